@@ -0,0 +1,38 @@
+/* contrib/pg_stat_cluster_activity/pg_stat_cluster_activity--1.0--1.1.sql */
+
+-- complain if script is sourced in psql, rather than via ALTER EXTENSION
+\echo Use "ALTER EXTENSION pg_stat_cluster_activity UPDATE TO '1.1'" to load this file. \quit
+
+CREATE OR REPLACE FUNCTION pg_stat_get_cluster_wait_samples(
+    sessionid text,
+    localonly bool,
+    OUT sample_time timestamp with time zone,
+    OUT sessionid text,
+    OUT nodename text,
+    OUT role text,
+    OUT pid integer,
+    OUT wait_event_type text,
+    OUT wait_event text
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+-- raw samples of all nodes, wait_event is null while running on CPU
+CREATE OR REPLACE VIEW pg_stat_cluster_wait_samples AS
+  SELECT * FROM pg_stat_get_cluster_wait_samples(NULL, false);
+
+-- samples of all nodes merged by global session
+CREATE OR REPLACE VIEW pg_stat_cluster_wait_profile AS
+  SELECT sessionid,
+         wait_event_type,
+         wait_event,
+         count(*) AS samples,
+         count(DISTINCT nodename) AS nodes,
+         min(sample_time) AS first_sample,
+         max(sample_time) AS last_sample
+    FROM pg_stat_get_cluster_wait_samples(NULL, false)
+   GROUP BY sessionid, wait_event_type, wait_event;
+
+GRANT SELECT ON pg_stat_cluster_wait_samples TO PUBLIC;
+GRANT SELECT ON pg_stat_cluster_wait_profile TO PUBLIC;
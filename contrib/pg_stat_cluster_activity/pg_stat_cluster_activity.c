@@ -15,7 +15,10 @@
 #include "pgxc/pgxc.h"
 #include "pgxc/squeue.h"
 #include "port/atomics.h"
+#include "postmaster/bgworker.h"
 #include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/proc.h"
 #include "storage/procarray.h"
 #include "storage/shmem.h"
 #include "utils/builtins.h"
@@ -103,6 +106,41 @@ static PortalDrop_hook_type prev_PortalDrop = NULL;
 static ExecutorStart_hook_type prev_ExecutorStart = NULL;
 
 static bool pgcs_enable_planstate; /* whether to show planstate in result sets */
+static int  pgcs_sample_interval;  /* ms between two wait event samples, 0 disables */
+static int  pgcs_sample_buffer_size; /* number of samples kept in shared memory */
+
+/*
+ * One wait event sample of a backend.
+ *
+ * Samples live in a shared ring written by the sampler worker alone, so no
+ * lock is taken on either side. The writer clears seq, fills the slot and
+ * then publishes seq as its ring position plus one; a reader copies the slot
+ * and keeps it only if seq was the expected value both before and after the
+ * copy, otherwise the slot was overwritten meanwhile and is skipped.
+ */
+typedef struct PgcsWaitSample
+{
+	pg_atomic_uint64 seq;           /* ring position + 1, 0 while being written */
+	TimestampTz sample_time;
+	int         pid;
+	uint32      wait_event_info;    /* 0 means running on CPU */
+	char        sessionid[NAMEDATALEN];
+	char        role[NAMEDATALEN];
+} PgcsWaitSample;
+
+typedef struct PgcsWaitSampleRing
+{
+	pg_atomic_uint64 next;          /* ring position of the next sample */
+	int         nslots;
+	PgcsWaitSample samples[FLEXIBLE_ARRAY_MEMBER];
+} PgcsWaitSampleRing;
+
+static PgcsWaitSampleRing *WaitSampleRing = NULL;
+
+static volatile sig_atomic_t pgcs_got_sighup = false;
+static volatile sig_atomic_t pgcs_got_sigterm = false;
+
+#define PG_STAT_GET_WAIT_SAMPLES_COLS 7
 
 /*
  * Macros to load and store st_changecount with the memory barriers.
@@ -145,14 +183,17 @@ Datum pg_stat_get_cluster_activity(PG_FUNCTION_ARGS);
 Datum pg_signal_session(PG_FUNCTION_ARGS);
 Datum pg_terminate_session(PG_FUNCTION_ARGS);
 Datum pg_cancel_session(PG_FUNCTION_ARGS);
+Datum pg_stat_get_cluster_wait_samples(PG_FUNCTION_ARGS);
 
 void _PG_init(void);
 void _PG_fini(void);
+void pgcs_sampler_main(Datum main_arg);
 
 PG_FUNCTION_INFO_V1(pg_stat_get_cluster_activity);
 PG_FUNCTION_INFO_V1(pg_signal_session);
 PG_FUNCTION_INFO_V1(pg_terminate_session);
 PG_FUNCTION_INFO_V1(pg_cancel_session);
+PG_FUNCTION_INFO_V1(pg_stat_get_cluster_wait_samples);
 
 
 static ParamListInfo
@@ -235,6 +276,23 @@ CreateSharedClusterStatus(void)
 		 */
 		MemSet(ClusterStatusArray, 0, size);
 	}
+	
+	/* Create or attach to the wait event sample ring */
+	size = add_size(offsetof(PgcsWaitSampleRing, samples),
+	                mul_size(sizeof(PgcsWaitSample), pgcs_sample_buffer_size));
+	WaitSampleRing = (PgcsWaitSampleRing *)
+		ShmemInitStruct("Cluster Wait Sample Ring", size, &found);
+	
+	if (!found)
+	{
+		int i;
+		
+		MemSet(WaitSampleRing, 0, size);
+		pg_atomic_init_u64(&WaitSampleRing->next, 0);
+		WaitSampleRing->nslots = pgcs_sample_buffer_size;
+		for (i = 0; i < pgcs_sample_buffer_size; i++)
+			pg_atomic_init_u64(&WaitSampleRing->samples[i].seq, 0);
+	}
 }
 
 /*
@@ -568,29 +626,22 @@ pgstat_fetch_stat_local_csentry(int beid)
 }
 
 /* ----------
- * pg_stat_get_remote_activity
+ * pgcs_remote_query_into
  * 
- *  Execute pg_stat_get_cluster_activity query remotely and save
- *  results in tuplestore.
+ *  Execute a set returning query taking sessionid as $1 on the other
+ *  nodes and save results in tuplestore.
  * ----------
  */
 static void
-pg_stat_get_remote_activity(const char *sessionid, bool coordonly, Tuplestorestate *tupstore, TupleDesc tupdesc)
+pgcs_remote_query_into(const char *query, const char *sessionid, bool coordonly,
+                       Tuplestorestate *tupstore, TupleDesc tupdesc)
 {
-#define QUERY_LEN 1024
-	char    query[QUERY_LEN];
 	EState              *estate;
 	MemoryContext		oldcontext;
 	RemoteQuery 		*plan;
 	RemoteQueryState    *pstate;
 	TupleTableSlot		*result = NULL;
 	
-	/*
-	 * Here we call pg_stat_get_cluster_activity in remote with args:
-	 * coordonly = false, localonly = true, to prevent recursive calls in remote nodes.
-	 */
-	snprintf(query, QUERY_LEN, "select * from pg_stat_get_cluster_activity($1, false, true)");
-	
 	plan = makeNode(RemoteQuery);
 	plan->combine_type = COMBINE_TYPE_NONE;
 	/*
@@ -599,7 +650,7 @@ pg_stat_get_remote_activity(const char *sessionid, bool coordonly, Tuplestoresta
 	 */
 	plan->exec_nodes = NULL;
 	plan->exec_type = EXEC_ON_ALL_NODES;
-	plan->sql_statement = (char *) query;
+	plan->sql_statement = pstrdup(query);
 	plan->force_autocommit = false;
 	plan->exec_nodes = makeNode(ExecNodes);
 	plan->exec_nodes->missing_ok = true;
@@ -633,6 +684,24 @@ pg_stat_get_remote_activity(const char *sessionid, bool coordonly, Tuplestoresta
 	FreeExecutorState(estate);
 }
 
+/* ----------
+ * pg_stat_get_remote_activity
+ * 
+ *  Execute pg_stat_get_cluster_activity query remotely and save
+ *  results in tuplestore.
+ * ----------
+ */
+static void
+pg_stat_get_remote_activity(const char *sessionid, bool coordonly, Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	/*
+	 * Here we call pg_stat_get_cluster_activity in remote with args:
+	 * coordonly = false, localonly = true, to prevent recursive calls in remote nodes.
+	 */
+	pgcs_remote_query_into("select * from pg_stat_get_cluster_activity($1, false, true)",
+	                       sessionid, coordonly, tupstore, tupdesc);
+}
+
 /* ----------
  * pg_stat_get_cluster_activity
  * 
@@ -1089,6 +1158,299 @@ pg_cancel_session(PG_FUNCTION_ARGS)
 	                           BoolGetDatum(false));
 }
 
+/* ----------
+ * pgcs_fetch_session
+ * 
+ *  Copy sessionid and role of the given backend without waiting for
+ *  a concurrent writer, give up after a few attempts since a changing
+ *  entry will be sampled again next time.
+ * ----------
+ */
+static bool
+pgcs_fetch_session(int beid, char *sessionid, char *role)
+{
+	volatile PgClusterStatus *csentry = &ClusterStatusArray[beid - 1];
+	int         attempt;
+	
+	for (attempt = 0; attempt < 3; attempt++)
+	{
+		int			before_changecount;
+		int			after_changecount;
+		bool        valid;
+		
+		save_changecount_before(csentry, before_changecount);
+		valid = csentry->valid;
+		if (valid)
+		{
+			memcpy(sessionid, (char *) csentry->sessionid, NAMEDATALEN);
+			memcpy(role, (char *) csentry->role, NAMEDATALEN);
+		}
+		save_changecount_after(csentry, after_changecount);
+		if (before_changecount == after_changecount &&
+		    (before_changecount & 1) == 0)
+		{
+			sessionid[NAMEDATALEN - 1] = '\0';
+			role[NAMEDATALEN - 1] = '\0';
+			return valid && sessionid[0] != '\0';
+		}
+	}
+	
+	return false;
+}
+
+/* ----------
+ * pgcs_take_samples
+ * 
+ *  Record wait_event_info of every backend which belongs to a global
+ *  session and is not idle in the ring. PGPROC is read without lock, as
+ *  pg_stat_activity does, a sample may be slightly stale but never blocks
+ *  the backends being sampled.
+ * ----------
+ */
+static void
+pgcs_take_samples(void)
+{
+	TimestampTz now = GetCurrentTimestamp();
+	int         i;
+	
+	for (i = 0; i < MaxBackends; i++)
+	{
+		PGPROC     *proc = &ProcGlobal->allProcs[i];
+		int         pid = proc->pid;
+		BackendId   beid = proc->backendId;
+		uint32      raw_wait_event;
+		char        sessionid[NAMEDATALEN];
+		char        role[NAMEDATALEN];
+		PgcsWaitSample *sample;
+		uint64      pos;
+		
+		if (pid == 0 || proc == MyProc)
+			continue;
+		if (beid < 1 || beid > MaxBackends)
+			continue;
+		
+		raw_wait_event = UINT32_ACCESS_ONCE(proc->wait_event_info);
+		/* waiting for the next command, nothing to profile */
+		if (raw_wait_event == WAIT_EVENT_CLIENT_READ)
+			continue;
+		
+		if (!pgcs_fetch_session(beid, sessionid, role))
+			continue;
+		
+		/* we are the only writer of the ring */
+		pos = pg_atomic_read_u64(&WaitSampleRing->next);
+		sample = &WaitSampleRing->samples[pos % WaitSampleRing->nslots];
+		
+		pg_atomic_write_u64(&sample->seq, 0);
+		pg_write_barrier();
+		sample->sample_time = now;
+		sample->pid = pid;
+		sample->wait_event_info = raw_wait_event;
+		memcpy(sample->sessionid, sessionid, NAMEDATALEN);
+		memcpy(sample->role, role, NAMEDATALEN);
+		pg_write_barrier();
+		pg_atomic_write_u64(&sample->seq, pos + 1);
+		pg_atomic_write_u64(&WaitSampleRing->next, pos + 1);
+	}
+}
+
+static void
+pgcs_sampler_sighup(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+	
+	pgcs_got_sighup = true;
+	SetLatch(MyLatch);
+	
+	errno = save_errno;
+}
+
+static void
+pgcs_sampler_sigterm(SIGNAL_ARGS)
+{
+	int			save_errno = errno;
+	
+	pgcs_got_sigterm = true;
+	SetLatch(MyLatch);
+	
+	errno = save_errno;
+}
+
+/*
+ * Main loop of the wait event sampler background worker.
+ */
+void
+pgcs_sampler_main(Datum main_arg)
+{
+	pqsignal(SIGHUP, pgcs_sampler_sighup);
+	pqsignal(SIGTERM, pgcs_sampler_sigterm);
+	BackgroundWorkerUnblockSignals();
+	
+	while (!pgcs_got_sigterm)
+	{
+		int         rc;
+		
+		if (pgcs_got_sighup)
+		{
+			pgcs_got_sighup = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+		
+		if (pgcs_sample_interval > 0 && WaitSampleRing != NULL)
+			pgcs_take_samples();
+		
+		if (pgcs_sample_interval > 0)
+			rc = WaitLatch(MyLatch,
+			               WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+			               pgcs_sample_interval,
+			               PG_WAIT_EXTENSION);
+		else
+			rc = WaitLatch(MyLatch,
+			               WL_LATCH_SET | WL_POSTMASTER_DEATH,
+			               -1L,
+			               PG_WAIT_EXTENSION);
+		ResetLatch(MyLatch);
+		
+		if (rc & WL_POSTMASTER_DEATH)
+			proc_exit(1);
+	}
+	
+	proc_exit(0);
+}
+
+/* ----------
+ * pg_stat_get_local_wait_samples
+ * 
+ *  Copy the samples still in the ring into tuplestore, skip the ones
+ *  overwritten while we are reading.
+ * ----------
+ */
+static void
+pg_stat_get_local_wait_samples(const char *sessionid, Tuplestorestate *tupstore, TupleDesc tupdesc)
+{
+	uint64      end = pg_atomic_read_u64(&WaitSampleRing->next);
+	uint64      start = end > WaitSampleRing->nslots ? end - WaitSampleRing->nslots : 0;
+	uint64      pos;
+	
+	for (pos = start; pos < end; pos++)
+	{
+		PgcsWaitSample *sample = &WaitSampleRing->samples[pos % WaitSampleRing->nslots];
+		Datum		values[PG_STAT_GET_WAIT_SAMPLES_COLS];
+		bool		nulls[PG_STAT_GET_WAIT_SAMPLES_COLS];
+		TimestampTz sample_time;
+		int         pid;
+		uint32      raw_wait_event;
+		char        sample_sessionid[NAMEDATALEN];
+		char        role[NAMEDATALEN];
+		const char *wait_event_type;
+		const char *wait_event;
+		
+		if (pg_atomic_read_u64(&sample->seq) != pos + 1)
+			continue;
+		pg_read_barrier();
+		sample_time = sample->sample_time;
+		pid = sample->pid;
+		raw_wait_event = sample->wait_event_info;
+		memcpy(sample_sessionid, sample->sessionid, NAMEDATALEN);
+		memcpy(role, sample->role, NAMEDATALEN);
+		pg_read_barrier();
+		if (pg_atomic_read_u64(&sample->seq) != pos + 1)
+			continue;
+		
+		if (sessionid != NULL && strcmp(sessionid, sample_sessionid) != 0)
+			continue;
+		
+		MemSet(values, 0, sizeof(values));
+		MemSet(nulls, 0, sizeof(nulls));
+		
+		values[0] = TimestampTzGetDatum(sample_time);
+		values[1] = CStringGetTextDatum(sample_sessionid);
+		values[2] = CStringGetTextDatum(PGXCNodeName);
+		values[3] = CStringGetTextDatum(role);
+		values[4] = Int32GetDatum(pid);
+		
+		wait_event_type = pgstat_get_wait_event_type(raw_wait_event);
+		wait_event = pgstat_get_wait_event(raw_wait_event);
+		if (wait_event_type)
+			values[5] = CStringGetTextDatum(wait_event_type);
+		else
+			nulls[5] = true;
+		if (wait_event)
+			values[6] = CStringGetTextDatum(wait_event);
+		else
+			nulls[6] = true;
+		
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+}
+
+/* ----------
+ * pg_stat_get_cluster_wait_samples
+ * 
+ *  SRF returning wait event samples kept by the sampler worker. On a
+ *  coordinator the samples of all other nodes are merged in, so the
+ *  whole distributed execution of a global session can be profiled.
+ *
+ *  arguments:  sessionid -- only return samples of this session if not null
+ *              localonly -- only return samples taken on this node if true
+ * ----------
+ */
+Datum
+pg_stat_get_cluster_wait_samples(PG_FUNCTION_ARGS)
+{
+	bool             localonly = PG_ARGISNULL(1) ? false : PG_GETARG_BOOL(1);
+	const char      *sessionid = PG_ARGISNULL(0) ? NULL : text_to_cstring(PG_GETARG_TEXT_P(0));
+	ReturnSetInfo   *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	     tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext    per_query_ctx;
+	MemoryContext    oldcontext;
+	
+	if (WaitSampleRing == NULL)
+		ereport(ERROR,
+		        (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			        errmsg("shared memory for pg_stat_cluster_activity is not prepared"),
+			        errhint("maybe you need to set shared_preload_libraries in postgresql.conf")));
+	
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+		        (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			        errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+		        (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+			        errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+	
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	
+	/* switch to query's memory context to save results during execution */
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+	
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+	
+	MemoryContextSwitchTo(oldcontext);
+	
+	/* dispatch query to remote if needed */
+	if (!localonly && IS_PGXC_COORDINATOR)
+		pgcs_remote_query_into("select * from pg_stat_get_cluster_wait_samples($1, true)",
+		                       sessionid, false, tupstore, tupdesc);
+	
+	pg_stat_get_local_wait_samples(sessionid, tupstore, tupdesc);
+	
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+	
+	return (Datum) 0;
+}
+
 /*
  * Hooked as shmem_startup_hook
  */
@@ -1107,7 +1469,13 @@ pgcs_shmem_startup(void)
 static Size
 pgcs_memsize(void)
 {
-	return mul_size(sizeof(PgClusterStatus), NumBackendStatSlots);
+	Size size;
+	
+	size = mul_size(sizeof(PgClusterStatus), NumBackendStatSlots);
+	size = add_size(size, offsetof(PgcsWaitSampleRing, samples));
+	size = add_size(size, mul_size(sizeof(PgcsWaitSample), pgcs_sample_buffer_size));
+	
+	return size;
 }
 
 /*
@@ -1116,6 +1484,8 @@ pgcs_memsize(void)
 void
 _PG_init(void)
 {
+	BackgroundWorker worker;
+	
 	if (!process_shared_preload_libraries_in_progress)
 		return;
 	
@@ -1133,6 +1503,32 @@ _PG_init(void)
 	                         NULL,
 	                         NULL);
 	
+	DefineCustomIntVariable("pg_stat_cluster_activity.sample_interval",
+	                        "Sets the interval between two wait event samples, 0 disables sampling.",
+	                        "Sampling disabled at server start can only be enabled by a restart.",
+	                        &pgcs_sample_interval,
+	                        0,
+	                        0,
+	                        INT_MAX / 1000,
+	                        PGC_SIGHUP,
+	                        GUC_UNIT_MS,
+	                        NULL,
+	                        NULL,
+	                        NULL);
+	
+	DefineCustomIntVariable("pg_stat_cluster_activity.sample_buffer_size",
+	                        "Sets the number of wait event samples kept in shared memory.",
+	                        NULL,
+	                        &pgcs_sample_buffer_size,
+	                        8192,
+	                        128,
+	                        1024 * 1024,
+	                        PGC_POSTMASTER,
+	                        0,
+	                        NULL,
+	                        NULL,
+	                        NULL);
+	
 	/*
 	 * Request additional shared resources.  (These are no-ops if we're not in
 	 * the postmaster process.)  We'll allocate or attach to the shared
@@ -1153,6 +1549,25 @@ _PG_init(void)
 	PortalDrop_hook = pgcs_report_activity;
 	prev_ExecutorStart = ExecutorStart_hook;
 	ExecutorStart_hook = pgcs_report_executor_activity;
+	
+	/*
+	 * Register the wait event sampler only if sampling is enabled at startup;
+	 * sample_interval can then be changed by reload, and the sampler sleeps
+	 * until the next reload while it is 0.
+	 */
+	if (pgcs_sample_interval <= 0)
+		return;
+
+	memset(&worker, 0, sizeof(worker));
+	worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+	worker.bgw_start_time = BgWorkerStart_ConsistentState;
+	worker.bgw_restart_time = 10;
+	snprintf(worker.bgw_library_name, BGW_MAXLEN, "pg_stat_cluster_activity");
+	snprintf(worker.bgw_function_name, BGW_MAXLEN, "pgcs_sampler_main");
+	snprintf(worker.bgw_name, BGW_MAXLEN, "pg_stat_cluster_activity sampler");
+	worker.bgw_main_arg = (Datum) 0;
+	worker.bgw_notify_pid = 0;
+	RegisterBackgroundWorker(&worker);
 }
 
 /*
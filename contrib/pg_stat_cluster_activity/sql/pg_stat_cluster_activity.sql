@@ -0,0 +1,23 @@
+CREATE EXTENSION pg_stat_cluster_activity;
+
+-- this session, as seen by its coordinator
+SELECT count(*), bool_and(state = 'active') AS active
+  FROM pg_stat_cluster_activity_cn WHERE pid = pg_backend_pid();
+
+-- the sampler catches it sleeping
+SELECT pg_sleep(0.5);
+SELECT count(*) > 0 AS sampled
+  FROM pg_stat_get_cluster_wait_samples(NULL, true)
+ WHERE pid = pg_backend_pid() AND wait_event = 'PgSleep';
+
+-- samples merged by session
+SELECT wait_event_type, wait_event, samples > 0 AS sampled, nodes
+  FROM pg_stat_cluster_wait_profile
+ WHERE wait_event = 'PgSleep'
+   AND sessionid = (SELECT sessionid FROM pg_stat_cluster_activity_cn
+                     WHERE pid = pg_backend_pid());
+
+-- unknown sessions have no samples
+SELECT count(*) FROM pg_stat_get_cluster_wait_samples('no such session', true);
+
+DROP EXTENSION pg_stat_cluster_activity;
@@ -0,0 +1,34 @@
+CREATE EXTENSION stormstats;
+
+CREATE TABLE storm_t (a int, b text) DISTRIBUTE BY SHARD (a);
+SELECT storm_statement_stats_reset();
+
+-- statements differing only in constants share a query id
+INSERT INTO storm_t VALUES (1, 'one');
+INSERT INTO storm_t VALUES (2, 'two');
+INSERT INTO storm_t VALUES (3, 'three');
+SELECT count(*) FROM storm_t WHERE a = 1;
+SELECT count(*) FROM storm_t WHERE a = 2;
+SELECT count(*) FROM storm_t WHERE a > 0;
+
+SELECT query, calls, rows, queryid <> 0 AS has_id
+  FROM storm_statement_stats
+ WHERE datname = current_database()
+   AND (query LIKE 'INSERT INTO storm_t %' OR query LIKE '%FROM storm_t %')
+ ORDER BY query;
+
+-- one row per query id
+SELECT count(*) = count(DISTINCT queryid) AS unique_ids
+  FROM storm_statement_stats WHERE datname = current_database();
+
+-- work done on the datanodes is accounted to the coordinator's query id
+SELECT remote_calls > 0 AS remote, total_time >= coord_time AS total_covers_coord
+  FROM storm_statement_stats
+ WHERE datname = current_database() AND query LIKE 'INSERT INTO storm_t%';
+
+SELECT storm_statement_stats_reset();
+SELECT count(*) FROM storm_statement_stats
+ WHERE datname = current_database() AND query LIKE '%storm_t%';
+
+DROP TABLE storm_t;
+DROP EXTENSION stormstats;
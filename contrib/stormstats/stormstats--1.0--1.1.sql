@@ -0,0 +1,37 @@
+/* contrib/stormstats/stormstats--1.0--1.1.sql */
+
+-- complain if script is sourced in psql, rather than via ALTER EXTENSION
+\echo Use "ALTER EXTENSION stormstats UPDATE TO '1.1'" to load this file. \quit
+
+CREATE FUNCTION storm_statement_stats(
+    OUT datname text,
+    OUT queryid int8,
+    OUT query text,
+    OUT calls int8,
+    OUT remote_calls int8,
+    OUT total_time float8,
+    OUT coord_time float8,
+    OUT rows int8,
+    OUT shared_blks_hit int8,
+    OUT shared_blks_read int8,
+    OUT shared_blks_dirtied int8,
+    OUT shared_blks_written int8,
+    OUT temp_blks_read int8,
+    OUT temp_blks_written int8,
+    OUT net_bytes_sent int8,
+    OUT net_bytes_received int8
+)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+CREATE FUNCTION storm_statement_stats_reset()
+RETURNS void
+AS 'MODULE_PATHNAME'
+LANGUAGE C;
+
+-- Register a view on the function for ease of use.
+CREATE VIEW storm_statement_stats AS
+  SELECT * FROM storm_statement_stats();
+
+REVOKE ALL ON FUNCTION storm_statement_stats_reset() FROM PUBLIC;
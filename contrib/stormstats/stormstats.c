@@ -2,7 +2,10 @@
 
 #include <unistd.h>
 
+#include "access/parallel.h"
 #include "catalog/pg_type.h"
+#include "common/keywords.h"
+#include "executor/instrument.h"
 #include "executor/spi.h"
 #include "miscadmin.h"
 #include "storage/ipc.h"
@@ -11,11 +14,15 @@
 
 #include "tcop/utility.h"
 #include "commands/dbcommands.h"
+#include "mb/pg_wchar.h"
 #include "utils/builtins.h"
 #include "utils/syscache.h"
 #include "utils/snapmgr.h"
 #include "libpq/auth.h"
 #include "optimizer/planner.h"
+#include "parser/analyze.h"
+#include "parser/scanner.h"
+#include "parser/gram.h"
 #include "nodes/makefuncs.h"
 #include "funcapi.h"
 #include "stormstats.h"
@@ -39,6 +46,10 @@ PG_MODULE_MAGIC;
 static const uint32 STORM_FILE_HEADER = 0x20120229;
 
 #define STORM_STATS_COLS 7
+#define STORM_STATEMENT_STATS_COLS 16
+
+/* Bytes of the query text kept for each statement */
+#define STORM_QUERY_LEN 1024
 
 typedef struct ssHashKey
 {
@@ -78,6 +89,57 @@ typedef struct StormSharedState
     LWLock *lock;
 } StormSharedState;
 
+/*
+ * Statement statistics are keyed by the query id of the coordinator
+ * statement. Datanodes receive that id along with the global session id and
+ * account the plan fragments or shipped statements they run to it, so that
+ * the shares of all nodes can be added up on a coordinator.
+ */
+typedef struct StatementKey
+{
+    Oid         dbid;
+    uint32      queryid;
+} StatementKey;
+
+typedef struct StatementCounters
+{
+    int64       calls;              /* executions started by a client */
+    int64       remote_calls;       /* executions on behalf of another node */
+    double      total_time;         /* time of all executions, in msec */
+    double      coord_time;         /* time of client executions, in msec */
+    int64       rows;
+    int64       shared_blks_hit;
+    int64       shared_blks_read;
+    int64       shared_blks_dirtied;
+    int64       shared_blks_written;
+    int64       temp_blks_read;
+    int64       temp_blks_written;
+    int64       net_bytes_sent;
+    int64       net_bytes_received;
+} StatementCounters;
+
+typedef struct StormStatementEntry
+{
+    StatementKey        key;        /* hash key of entry - MUST BE FIRST */
+    StatementCounters   counters;
+    slock_t             mutex;
+    char                query[STORM_QUERY_LEN];
+} StormStatementEntry;
+
+/* Local hash table entry used to merge statistics of all nodes */
+typedef struct LocalStatementKey
+{
+    char        dbname[NAMEDATALEN];
+    uint32      queryid;
+} LocalStatementKey;
+
+typedef struct LocalStatementEntry
+{
+    LocalStatementKey   key;
+    StatementCounters   counters;
+    char                query[STORM_QUERY_LEN];
+} LocalStatementEntry;
+
 static bool sp_save;            /* whether to save stats across shutdown */
 
 extern PlannedStmt *planner_callback(Query *parse, int cursorOptions, ParamListInfo boundParams);
@@ -93,13 +155,26 @@ static void stats_store(const char *dbname, CmdType c, bool isConnEvent, bool is
 
 static StormStatsEntry *alloc_event_entry(ssHashKey *key);
 
+static void storm_post_parse_analyze(ParseState *pstate, Query *query);
+static void storm_ExecutorStart(QueryDesc *queryDesc, int eflags);
+static void storm_ExecutorRun(QueryDesc *queryDesc, ScanDirection direction,
+                              uint64 count, bool execute_once);
+static void storm_ExecutorFinish(QueryDesc *queryDesc);
+static void storm_ExecutorEnd(QueryDesc *queryDesc);
+static void statement_store(QueryDesc *queryDesc, uint32 queryid);
+
 /* Functions */
 Datum storm_database_stats(PG_FUNCTION_ARGS);
+Datum storm_statement_stats(PG_FUNCTION_ARGS);
+Datum storm_statement_stats_reset(PG_FUNCTION_ARGS);
 
 PG_FUNCTION_INFO_V1(storm_database_stats);
+PG_FUNCTION_INFO_V1(storm_statement_stats);
+PG_FUNCTION_INFO_V1(storm_statement_stats_reset);
 
 /* Shared Memory Objects */
 static HTAB *StatsEntryHash = NULL;
+static HTAB *StatementEntryHash = NULL;
 static StormSharedState *shared_state = NULL;
 
 /* Session level objects */
@@ -109,7 +184,26 @@ static ClientAuthentication_hook_type original_client_auth_hook = NULL;
 
 static ProcessUtility_hook_type prev_ProcessUtility = NULL;
 
+static post_parse_analyze_hook_type prev_post_parse_analyze_hook = NULL;
+static ExecutorStart_hook_type prev_ExecutorStart = NULL;
+static ExecutorRun_hook_type prev_ExecutorRun = NULL;
+static ExecutorFinish_hook_type prev_ExecutorFinish = NULL;
+static ExecutorEnd_hook_type prev_ExecutorEnd = NULL;
+
 static int max_tracked_dbs;
+static int max_tracked_stmts;
+static bool track_statements;
+
+/* Current nesting depth of executor calls, only top level ones are tracked */
+static int nested_level = 0;
+
+/* Network counters when the top level statement started */
+static uint64 start_bytes_sent = 0;
+static uint64 start_bytes_received = 0;
+
+#define storm_statement_enabled() \
+    (track_statements && nested_level == 0 && !IsParallelWorker() && \
+     StatementEntryHash != NULL)
 
 static void
 ProcessUtility_callback(PlannedStmt *pstmt,
@@ -215,6 +309,30 @@ _PG_init(void)
                             NULL,
                             NULL);
 
+    DefineCustomIntVariable("storm_stats.max_tracked_statements",
+                            "Sets the maximum number of statements tracked.",
+                            NULL,
+                            &max_tracked_stmts,
+                            1000,
+                            100,
+                            INT_MAX,
+                            PGC_POSTMASTER,
+                            0,
+                            NULL,
+                            NULL,
+                            NULL);
+
+    DefineCustomBoolVariable("storm_stats.track_statements",
+                             "Collect statistics of statements by coordinator query id.",
+                             NULL,
+                             &track_statements,
+                             true,
+                             PGC_SUSET,
+                             0,
+                             NULL,
+                             NULL,
+                             NULL);
+
     DefineCustomBoolVariable("storm_stats.save",
                              "Save statistics across server shutdowns.",
                              NULL,
@@ -241,6 +359,17 @@ _PG_init(void)
     prev_ProcessUtility = ProcessUtility_hook;
     ProcessUtility_hook = ProcessUtility_callback;
 
+    prev_post_parse_analyze_hook = post_parse_analyze_hook;
+    post_parse_analyze_hook = storm_post_parse_analyze;
+    prev_ExecutorStart = ExecutorStart_hook;
+    ExecutorStart_hook = storm_ExecutorStart;
+    prev_ExecutorRun = ExecutorRun_hook;
+    ExecutorRun_hook = storm_ExecutorRun;
+    prev_ExecutorFinish = ExecutorFinish_hook;
+    ExecutorFinish_hook = storm_ExecutorFinish;
+    prev_ExecutorEnd = ExecutorEnd_hook;
+    ExecutorEnd_hook = storm_ExecutorEnd;
+
     elog( DEBUG1, "STORMSTATS: plugin loaded" );
 }
 
@@ -250,6 +379,11 @@ _PG_fini(void)
     shmem_startup_hook = prev_shmem_startup_hook;
     planner_hook = NULL;
     ProcessUtility_hook = prev_ProcessUtility;
+    post_parse_analyze_hook = prev_post_parse_analyze_hook;
+    ExecutorStart_hook = prev_ExecutorStart;
+    ExecutorRun_hook = prev_ExecutorRun;
+    ExecutorFinish_hook = prev_ExecutorFinish;
+    ExecutorEnd_hook = prev_ExecutorEnd;
 
     elog( DEBUG1, "STORMSTATS: plugin unloaded." );
 }
@@ -293,6 +427,17 @@ static void sp_shmem_startup(void)
     if (!StatsEntryHash)
         elog(ERROR, "out of shared memory");
 
+    memset(&event_ctl, 0, sizeof(event_ctl));
+
+    event_ctl.keysize = sizeof(StatementKey);
+    event_ctl.entrysize = sizeof(StormStatementEntry);
+
+    StatementEntryHash = ShmemInitHash("storm_stats statement hash", max_tracked_stmts,
+                                       max_tracked_stmts, &event_ctl,
+                                       HASH_ELEM | HASH_BLOBS);
+    if (!StatementEntryHash)
+        elog(ERROR, "out of shared memory");
+
     LWLockRelease(AddinShmemInitLock);
 
     /*
@@ -478,6 +623,8 @@ static Size hash_memsize(void)
     state_size = MAXALIGN(sizeof(StormSharedState));
 
     size = add_size(events_size, state_size);
+    size = add_size(size, hash_estimate_size(max_tracked_stmts,
+                                             MAXALIGN(sizeof(StormStatementEntry))));
 
     return size;
 }
@@ -897,3 +1044,641 @@ Datum storm_database_stats(PG_FUNCTION_ARGS)
 
     return (Datum) 0;
 }
+
+/*
+ * Compute a query id from the text of a statement. Constants and parameters
+ * are left out so that executions differing only in them share an id, the
+ * same way on every coordinator.
+ */
+static uint32
+storm_query_id(const char *sourcetext, int location, int len)
+{
+    core_yyscan_t       yyscanner;
+    core_yy_extra_type  yyextra;
+    core_YYSTYPE        yylval;
+    YYLTYPE             yylloc;
+    StringInfoData      buf;
+    char               *query;
+    uint32              queryid;
+
+    if (location < 0)
+    {
+        location = 0;
+        len = strlen(sourcetext);
+    }
+    else if (len <= 0)
+        len = strlen(sourcetext + location);
+    query = pnstrdup(sourcetext + location, len);
+
+    initStringInfo(&buf);
+    yyscanner = scanner_init(query, &yyextra, ScanKeywords, NumScanKeywords);
+    for (;;)
+    {
+        int tok = core_yylex(&yylval, &yylloc, yyscanner);
+
+        if (tok == 0)
+            break;
+
+        switch (tok)
+        {
+            case ICONST:
+            case FCONST:
+            case SCONST:
+            case BCONST:
+            case XCONST:
+            case PARAM:
+                appendStringInfoChar(&buf, '?');
+                break;
+            case IDENT:
+            case Op:
+                appendStringInfoString(&buf, yylval.str);
+                break;
+            default:
+                /* keywords and other multi-char tokens by number */
+                if (tok < 256)
+                    appendStringInfoChar(&buf, (char) tok);
+                else
+                    appendStringInfo(&buf, "%d", tok);
+                break;
+        }
+        appendStringInfoChar(&buf, ' ');
+    }
+    scanner_finish(yyscanner);
+
+    queryid = DatumGetUInt32(hash_any((const unsigned char *) buf.data, buf.len));
+
+    pfree(buf.data);
+    pfree(query);
+
+    /* zero means no query id */
+    return queryid != 0 ? queryid : 1;
+}
+
+static void
+storm_post_parse_analyze(ParseState *pstate, Query *query)
+{
+    if (prev_post_parse_analyze_hook)
+        prev_post_parse_analyze_hook(pstate, query);
+
+    /* Leave ids set by other modules alone */
+    if (!track_statements || query->queryId != 0 ||
+        query->utilityStmt != NULL || pstate->p_sourcetext == NULL)
+        return;
+
+    query->queryId = storm_query_id(pstate->p_sourcetext,
+                                    query->stmt_location, query->stmt_len);
+}
+
+/*
+ * Query id the statement is accounted to: statements run on behalf of
+ * another node use the id of the coordinator statement they belong to.
+ */
+static uint32
+storm_statement_queryid(QueryDesc *queryDesc)
+{
+    if (!IsConnFromApp() && PGXCQueryId != 0)
+        return PGXCQueryId;
+
+    return queryDesc->plannedstmt->queryId;
+}
+
+static void
+storm_ExecutorStart(QueryDesc *queryDesc, int eflags)
+{
+    if (storm_statement_enabled())
+    {
+        /* Tell the nodes we dispatch to which statement they are working for */
+        if (IsConnFromApp())
+            PGXCQueryId = queryDesc->plannedstmt->queryId;
+
+        start_bytes_sent = PGXCNetBytesSent;
+        start_bytes_received = PGXCNetBytesReceived;
+    }
+
+    if (prev_ExecutorStart)
+        prev_ExecutorStart(queryDesc, eflags);
+    else
+        standard_ExecutorStart(queryDesc, eflags);
+
+    /* Set up to track total elapsed time and buffer usage of the statement */
+    if (storm_statement_enabled() && queryDesc->totaltime == NULL)
+    {
+        MemoryContext oldcxt;
+
+        oldcxt = MemoryContextSwitchTo(queryDesc->estate->es_query_cxt);
+        queryDesc->totaltime = InstrAlloc(1, INSTRUMENT_ALL);
+        MemoryContextSwitchTo(oldcxt);
+    }
+}
+
+static void
+storm_ExecutorRun(QueryDesc *queryDesc, ScanDirection direction, uint64 count,
+                  bool execute_once)
+{
+    nested_level++;
+    PG_TRY();
+    {
+        if (prev_ExecutorRun)
+            prev_ExecutorRun(queryDesc, direction, count, execute_once);
+        else
+            standard_ExecutorRun(queryDesc, direction, count, execute_once);
+        nested_level--;
+    }
+    PG_CATCH();
+    {
+        nested_level--;
+        PG_RE_THROW();
+    }
+    PG_END_TRY();
+}
+
+static void
+storm_ExecutorFinish(QueryDesc *queryDesc)
+{
+    nested_level++;
+    PG_TRY();
+    {
+        if (prev_ExecutorFinish)
+            prev_ExecutorFinish(queryDesc);
+        else
+            standard_ExecutorFinish(queryDesc);
+        nested_level--;
+    }
+    PG_CATCH();
+    {
+        nested_level--;
+        PG_RE_THROW();
+    }
+    PG_END_TRY();
+}
+
+static void
+storm_ExecutorEnd(QueryDesc *queryDesc)
+{
+    if (queryDesc->totaltime && storm_statement_enabled())
+    {
+        uint32 queryid = storm_statement_queryid(queryDesc);
+
+        /* Make sure stats accumulation is done */
+        InstrEndLoop(queryDesc->totaltime);
+
+        if (queryid != 0)
+            statement_store(queryDesc, queryid);
+    }
+
+    if (nested_level == 0 && IsConnFromApp())
+        PGXCQueryId = 0;
+
+    if (prev_ExecutorEnd)
+        prev_ExecutorEnd(queryDesc);
+    else
+        standard_ExecutorEnd(queryDesc);
+}
+
+static void
+statement_store(QueryDesc *queryDesc, uint32 queryid)
+{
+    StatementKey        key;
+    StormStatementEntry *entry;
+    Instrumentation    *instr = queryDesc->totaltime;
+    bool                from_client = IsConnFromApp();
+
+    if (!shared_state)
+        return;
+
+    key.dbid = MyDatabaseId;
+    key.queryid = queryid;
+
+    /* Lookup the hash table entry with shared lock. */
+    LWLockAcquire(shared_state->lock, LW_SHARED);
+
+    entry = (StormStatementEntry *) hash_search(StatementEntryHash, &key, HASH_FIND, NULL);
+    if (!entry)
+    {
+        bool found;
+
+        /* Must acquire exclusive lock to add a new entry. */
+        LWLockRelease(shared_state->lock);
+        LWLockAcquire(shared_state->lock, LW_EXCLUSIVE);
+
+        /* Statements beyond the limit are not tracked until a reset */
+        if (hash_get_num_entries(StatementEntryHash) >= max_tracked_stmts)
+            entry = (StormStatementEntry *) hash_search(StatementEntryHash, &key, HASH_FIND, &found);
+        else
+            entry = (StormStatementEntry *) hash_search(StatementEntryHash, &key, HASH_ENTER, &found);
+
+        if (!entry)
+        {
+            LWLockRelease(shared_state->lock);
+            return;
+        }
+
+        if (!found)
+        {
+            const char *query = queryDesc->sourceText ? queryDesc->sourceText : "";
+            int         location = queryDesc->plannedstmt->stmt_location;
+            int         len = queryDesc->plannedstmt->stmt_len;
+
+            if (location < 0 || location > strlen(query))
+                location = 0;
+            query += location;
+            if (len <= 0 || len > strlen(query))
+                len = strlen(query);
+            len = pg_mbcliplen(query, len, STORM_QUERY_LEN - 1);
+
+            memset(&entry->counters, 0, sizeof(StatementCounters));
+            SpinLockInit(&entry->mutex);
+            memcpy(entry->query, query, len);
+            entry->query[len] = '\0';
+        }
+    }
+
+    /* Grab the spinlock while updating the counters. */
+    {
+        volatile StormStatementEntry *e = (volatile StormStatementEntry *) entry;
+        double      total_time = instr->total * 1000.0;
+
+        SpinLockAcquire(&e->mutex);
+
+        if (from_client)
+        {
+            e->counters.calls += 1;
+            e->counters.coord_time += total_time;
+        }
+        else
+            e->counters.remote_calls += 1;
+        e->counters.total_time += total_time;
+        e->counters.rows += queryDesc->estate->es_processed;
+        e->counters.shared_blks_hit += instr->bufusage.shared_blks_hit;
+        e->counters.shared_blks_read += instr->bufusage.shared_blks_read;
+        e->counters.shared_blks_dirtied += instr->bufusage.shared_blks_dirtied;
+        e->counters.shared_blks_written += instr->bufusage.shared_blks_written;
+        e->counters.temp_blks_read += instr->bufusage.temp_blks_read;
+        e->counters.temp_blks_written += instr->bufusage.temp_blks_written;
+        e->counters.net_bytes_sent += PGXCNetBytesSent - start_bytes_sent;
+        e->counters.net_bytes_received += PGXCNetBytesReceived - start_bytes_received;
+
+        SpinLockRelease(&e->mutex);
+    }
+
+    LWLockRelease(shared_state->lock);
+}
+
+/*
+ * Add statistics of a statement on some node to the merged hash table.
+ */
+static void
+statement_merge(HTAB *hash, const char *dbname, uint32 queryid,
+                const char *query, StatementCounters *counters)
+{
+    LocalStatementKey    key;
+    LocalStatementEntry *entry;
+    bool                 found;
+
+    memset(&key, 0, sizeof(key));
+    strlcpy(key.dbname, dbname, NAMEDATALEN);
+    key.queryid = queryid;
+
+    entry = (LocalStatementEntry *) hash_search(hash, &key, HASH_ENTER, &found);
+    if (!found)
+    {
+        memset(&entry->counters, 0, sizeof(StatementCounters));
+        entry->query[0] = '\0';
+    }
+
+    /* prefer the text the client sent to a coordinator */
+    if (query && (entry->query[0] == '\0' || counters->calls > 0))
+        strlcpy(entry->query, query, STORM_QUERY_LEN);
+
+    entry->counters.calls += counters->calls;
+    entry->counters.remote_calls += counters->remote_calls;
+    entry->counters.total_time += counters->total_time;
+    entry->counters.coord_time += counters->coord_time;
+    entry->counters.rows += counters->rows;
+    entry->counters.shared_blks_hit += counters->shared_blks_hit;
+    entry->counters.shared_blks_read += counters->shared_blks_read;
+    entry->counters.shared_blks_dirtied += counters->shared_blks_dirtied;
+    entry->counters.shared_blks_written += counters->shared_blks_written;
+    entry->counters.temp_blks_read += counters->temp_blks_read;
+    entry->counters.temp_blks_written += counters->temp_blks_written;
+    entry->counters.net_bytes_sent += counters->net_bytes_sent;
+    entry->counters.net_bytes_received += counters->net_bytes_received;
+}
+
+/*
+ * Build a RemoteQuery running query on all other nodes, with a targetlist
+ * matching tupdesc.
+ */
+static RemoteQuery *
+storm_make_remote_query(char *query, TupleDesc tupdesc)
+{
+    RemoteQuery *step;
+    int          i;
+
+    step = makeNode(RemoteQuery);
+
+    step->combine_type = COMBINE_TYPE_NONE;
+    step->exec_nodes = NULL;
+    step->sql_statement = query;
+    step->force_autocommit = false;
+    step->read_only = true;
+    step->exec_type = EXEC_ON_ALL_NODES;
+
+    for (i = 0; i < tupdesc->natts; ++i)
+    {
+        Var           *var;
+        TargetEntry *tle;
+
+        var = makeVar(1,
+                      tupdesc->attrs[i]->attnum,
+                      tupdesc->attrs[i]->atttypid,
+                      tupdesc->attrs[i]->atttypmod,
+                      InvalidOid,
+                      0);
+
+        tle = makeTargetEntry((Expr *) var, tupdesc->attrs[i]->attnum, NULL, false);
+        step->scan.plan.targetlist = lappend(step->scan.plan.targetlist, tle);
+    }
+
+    return step;
+}
+
+static int64
+slot_get_int64(TupleTableSlot *slot, int attnum)
+{
+    bool    isnull;
+    Datum   value = slot_getattr(slot, attnum, &isnull);
+
+    return isnull ? 0 : DatumGetInt64(value);
+}
+
+static double
+slot_get_float8(TupleTableSlot *slot, int attnum)
+{
+    bool    isnull;
+    Datum   value = slot_getattr(slot, attnum, &isnull);
+
+    return isnull ? 0 : DatumGetFloat8(value);
+}
+
+/*
+ * Gather statement statistics from all the other nodes into hash
+ */
+static void
+storm_gather_remote_statement_info(TupleDesc tupdesc, HTAB *hash)
+{
+    EState        *estate;
+    TupleTableSlot *result;
+    RemoteQuery *step;
+    RemoteQueryState *node;
+    MemoryContext oldcontext;
+
+    step = storm_make_remote_query("SELECT * FROM storm_statement_stats()", tupdesc);
+
+    estate = CreateExecutorState();
+
+    oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+
+    estate->es_snapshot = GetActiveSnapshot();
+
+    node = ExecInitRemoteQuery(step, estate, 0);
+    MemoryContextSwitchTo(oldcontext);
+
+    result = ExecRemoteQuery((PlanState *) node);
+    while (result != NULL && !TupIsNull(result))
+    {
+        Datum       value;
+        bool        isnull;
+        char       *dbname;
+        char       *query = NULL;
+        uint32      queryid;
+        StatementCounters counters;
+
+        value = slot_getattr(result, 1, &isnull); /* datname */
+        if (isnull)
+        {
+            result = ExecRemoteQuery((PlanState *) node);
+            continue;
+        }
+        dbname = TextDatumGetCString(value);
+
+        value = slot_getattr(result, 2, &isnull); /* queryid */
+        queryid = isnull ? 0 : (uint32) DatumGetInt64(value);
+
+        value = slot_getattr(result, 3, &isnull); /* query */
+        if (!isnull)
+            query = TextDatumGetCString(value);
+
+        counters.calls = slot_get_int64(result, 4);
+        counters.remote_calls = slot_get_int64(result, 5);
+        counters.total_time = slot_get_float8(result, 6);
+        counters.coord_time = slot_get_float8(result, 7);
+        counters.rows = slot_get_int64(result, 8);
+        counters.shared_blks_hit = slot_get_int64(result, 9);
+        counters.shared_blks_read = slot_get_int64(result, 10);
+        counters.shared_blks_dirtied = slot_get_int64(result, 11);
+        counters.shared_blks_written = slot_get_int64(result, 12);
+        counters.temp_blks_read = slot_get_int64(result, 13);
+        counters.temp_blks_written = slot_get_int64(result, 14);
+        counters.net_bytes_sent = slot_get_int64(result, 15);
+        counters.net_bytes_received = slot_get_int64(result, 16);
+
+        statement_merge(hash, dbname, queryid, query, &counters);
+
+        /* fetch next */
+        result = ExecRemoteQuery((PlanState *) node);
+    }
+    ExecEndRemoteQuery(node);
+    FreeExecutorState(estate);
+}
+
+/*
+ * Statistics of statements by query id. Called by a client on a coordinator
+ * the statistics of all nodes are merged, so each row shows the cost of a
+ * statement in the whole cluster; called by another node only local
+ * statistics are returned.
+ */
+Datum storm_statement_stats(PG_FUNCTION_ARGS)
+{// #lizard forgives
+    ReturnSetInfo       *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    TupleDesc           tupdesc;
+    Tuplestorestate     *tupstore;
+    MemoryContext       per_query_ctx;
+    MemoryContext       oldcontext;
+    HASH_SEQ_STATUS     hash_seq;
+    StormStatementEntry *entry;
+    LocalStatementEntry *le;
+    HTAB                *LocalStatementHash;
+    HASHCTL             ctl;
+    StormStatementEntry *local;
+    int                 nlocal = 0;
+    int                 i;
+
+    if (!shared_state || !StatementEntryHash)
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("storm_stats must be loaded via shared_preload_libraries")));
+
+    /* check to see if caller supports us returning a tuplestore */
+    if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("set-valued function called in context that cannot accept a set")));
+    if (!(rsinfo->allowedModes & SFRM_Materialize))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("materialize mode required, but it is not " \
+                        "allowed in this context")));
+
+    /* Build a tuple descriptor for our result type */
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        elog(ERROR, "return type must be a row type");
+    Assert(tupdesc->natts == STORM_STATEMENT_STATS_COLS);
+
+    per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+    oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+    tupstore = tuplestore_begin_heap(true, false, work_mem);
+    rsinfo->returnMode = SFRM_Materialize;
+    rsinfo->setResult = tupstore;
+    rsinfo->setDesc = tupdesc;
+
+    MemoryContextSwitchTo(oldcontext);
+
+    /* copy local entries to keep locking time short */
+    LWLockAcquire(shared_state->lock, LW_SHARED);
+
+    local = (StormStatementEntry *)
+        palloc(Max(hash_get_num_entries(StatementEntryHash), 1) * sizeof(StormStatementEntry));
+    hash_seq_init(&hash_seq, StatementEntryHash);
+    while ((entry = hash_seq_search(&hash_seq)) != NULL)
+    {
+        volatile StormStatementEntry *e = (volatile StormStatementEntry *) entry;
+
+        local[nlocal].key = entry->key;
+        memcpy(local[nlocal].query, entry->query, STORM_QUERY_LEN);
+
+        SpinLockAcquire(&e->mutex);
+        local[nlocal].counters = e->counters;
+        SpinLockRelease(&e->mutex);
+
+        nlocal++;
+    }
+
+    LWLockRelease(shared_state->lock);
+
+    memset(&ctl, 0, sizeof(ctl));
+    ctl.keysize = sizeof(LocalStatementKey);
+    ctl.entrysize = sizeof(LocalStatementEntry);
+    ctl.hcxt = CurrentMemoryContext;
+    LocalStatementHash = hash_create("storm_stats local statement hash", max_tracked_stmts,
+                                     &ctl, HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+    for (i = 0; i < nlocal; i++)
+    {
+        char *dbname = get_database_name(local[i].key.dbid);
+
+        /* database dropped */
+        if (dbname == NULL)
+            continue;
+
+        statement_merge(LocalStatementHash, dbname, local[i].key.queryid,
+                        local[i].query, &local[i].counters);
+    }
+    pfree(local);
+
+    /*
+     * Query the other nodes and add their shares. Do this only if you are
+     * query originator, otherwise just provide your local info.
+     */
+    if (IS_PGXC_COORDINATOR && IsConnFromApp())
+        storm_gather_remote_statement_info(tupdesc, LocalStatementHash);
+
+    hash_seq_init(&hash_seq, LocalStatementHash);
+    while ((le = hash_seq_search(&hash_seq)) != NULL)
+    {
+        Datum           values[STORM_STATEMENT_STATS_COLS];
+        bool            nulls[STORM_STATEMENT_STATS_COLS];
+        int             j = 0;
+
+        memset(values, 0, sizeof(values));
+        memset(nulls, 0, sizeof(nulls));
+
+        values[j++] = CStringGetTextDatum(le->key.dbname);
+        values[j++] = Int64GetDatumFast((int64) le->key.queryid);
+        values[j++] = CStringGetTextDatum(le->query);
+        values[j++] = Int64GetDatumFast(le->counters.calls);
+        values[j++] = Int64GetDatumFast(le->counters.remote_calls);
+        values[j++] = Float8GetDatumFast(le->counters.total_time);
+        values[j++] = Float8GetDatumFast(le->counters.coord_time);
+        values[j++] = Int64GetDatumFast(le->counters.rows);
+        values[j++] = Int64GetDatumFast(le->counters.shared_blks_hit);
+        values[j++] = Int64GetDatumFast(le->counters.shared_blks_read);
+        values[j++] = Int64GetDatumFast(le->counters.shared_blks_dirtied);
+        values[j++] = Int64GetDatumFast(le->counters.shared_blks_written);
+        values[j++] = Int64GetDatumFast(le->counters.temp_blks_read);
+        values[j++] = Int64GetDatumFast(le->counters.temp_blks_written);
+        values[j++] = Int64GetDatumFast(le->counters.net_bytes_sent);
+        values[j++] = Int64GetDatumFast(le->counters.net_bytes_received);
+
+        Assert(j == STORM_STATEMENT_STATS_COLS);
+
+        tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+    }
+
+    hash_destroy(LocalStatementHash);
+
+    /* clean up and return the tuplestore */
+    tuplestore_donestoring(tupstore);
+
+    return (Datum) 0;
+}
+
+/*
+ * Discard statement statistics, on all nodes when called by a client on a
+ * coordinator.
+ */
+Datum storm_statement_stats_reset(PG_FUNCTION_ARGS)
+{
+    HASH_SEQ_STATUS      hash_seq;
+    StormStatementEntry *entry;
+
+    if (!shared_state || !StatementEntryHash)
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("storm_stats must be loaded via shared_preload_libraries")));
+
+    LWLockAcquire(shared_state->lock, LW_EXCLUSIVE);
+
+    hash_seq_init(&hash_seq, StatementEntryHash);
+    while ((entry = hash_seq_search(&hash_seq)) != NULL)
+        hash_search(StatementEntryHash, &entry->key, HASH_REMOVE, NULL);
+
+    LWLockRelease(shared_state->lock);
+
+    if (IS_PGXC_COORDINATOR && IsConnFromApp())
+    {
+        EState           *estate;
+        RemoteQuery      *step;
+        RemoteQueryState *node;
+        TupleDesc         tupdesc;
+        MemoryContext     oldcontext;
+
+        tupdesc = CreateTemplateTupleDesc(1, false);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 1, "reset", VOIDOID, -1, 0);
+        step = storm_make_remote_query("SELECT storm_statement_stats_reset()", tupdesc);
+
+        estate = CreateExecutorState();
+        oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+        estate->es_snapshot = GetActiveSnapshot();
+        node = ExecInitRemoteQuery(step, estate, 0);
+        MemoryContextSwitchTo(oldcontext);
+
+        while (!TupIsNull(ExecRemoteQuery((PlanState *) node)))
+            ;
+        ExecEndRemoteQuery(node);
+        FreeExecutorState(estate);
+    }
+
+    PG_RETURN_VOID();
+}
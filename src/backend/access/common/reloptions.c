@@ -179,6 +179,17 @@ static relopt_bool boolRelOpts[] =
         },
         false
     },
+#ifdef __TBASE__
+    {
+        {
+            "page_compress",
+            "Stores the pages of this table compressed, takes effect when the table is rewritten",
+            RELOPT_KIND_HEAP,
+            ShareUpdateExclusiveLock
+        },
+        false
+    },
+#endif
     {
         {
             "fastupdate",
@@ -1427,6 +1438,10 @@ default_reloptions(Datum reloptions, bool validate, relopt_kind kind)
         offsetof(StdRdOptions, user_catalog_table)},
         {"parallel_workers", RELOPT_TYPE_INT,
         offsetof(StdRdOptions, parallel_workers)}
+#ifdef __TBASE__
+        ,{"page_compress", RELOPT_TYPE_BOOL,
+        offsetof(StdRdOptions, page_compress)}
+#endif
     };
 
     options = parseRelOptions(reloptions, validate, kind, &numoptions);
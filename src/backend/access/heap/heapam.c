@@ -1876,6 +1876,11 @@ heap_endscan(HeapScanDesc scan)
 Size
 heap_parallelscan_estimate(Snapshot snapshot)
 {
+#ifdef __TBASE__
+    /* SnapshotAny is a static snapshot and needs no serialized copy */
+    if (snapshot == SnapshotAny)
+        return offsetof(ParallelHeapScanDescData, phs_snapshot_data);
+#endif
     return add_size(offsetof(ParallelHeapScanDescData, phs_snapshot_data),
                     EstimateSnapshotSpace(snapshot));
 }
@@ -1901,6 +1906,11 @@ heap_parallelscan_initialize(ParallelHeapScanDesc target, Relation relation,
     SpinLockInit(&target->phs_mutex);
     target->phs_startblock = InvalidBlockNumber;
 	pg_atomic_write_u64(&target->phs_nallocated, 0);
+#ifdef __TBASE__
+    target->phs_snapshot_any = (snapshot == SnapshotAny);
+    if (target->phs_snapshot_any)
+        return;
+#endif
     SerializeSnapshot(snapshot, target->phs_snapshot_data);
 }
 
@@ -1929,6 +1939,13 @@ heap_beginscan_parallel(Relation relation, ParallelHeapScanDesc parallel_scan)
     Snapshot    snapshot;
 
     Assert(RelationGetRelid(relation) == parallel_scan->phs_relid);
+#ifdef __TBASE__
+    /* used by parallel index builds, which look at every tuple version */
+    if (parallel_scan->phs_snapshot_any)
+        return heap_beginscan_internal(relation, SnapshotAny, 0, NULL,
+                                       parallel_scan, true, true, false,
+                                       false, false, false);
+#endif
     snapshot = RestoreSnapshot(parallel_scan->phs_snapshot_data);
     RegisterSnapshot(snapshot);
 
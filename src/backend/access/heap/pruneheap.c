@@ -131,7 +131,8 @@ heap_page_prune_opt(Relation relation, Buffer buffer)
      * older than OldestXmin.
      */
 #ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
-    if (!PageIsPrunable(page, OldestXmin, RecentDataTs))
+    if (!PageIsPrunable(page, OldestXmin,
+                         DataHorizonForRelation(relation->rd_rel->relisshared)))
         return;
 #else
     if (!PageIsPrunable(page, OldestXmin))
@@ -22,6 +22,7 @@
 #include "access/relscan.h"
 #include "access/xlog.h"
 #include "catalog/index.h"
+#include "commands/progress.h"
 #include "commands/vacuum.h"
 #include "pgstat.h"
 #include "storage/condition_variable.h"
@@ -179,6 +180,9 @@ btbuild(Relation heap, Relation index, IndexInfo *indexInfo)
     IndexBuildResult *result;
     double        reltuples;
     BTBuildState buildstate;
+#ifdef __TBASE__
+    int            nworkers;
+#endif
 
     buildstate.isUnique = indexInfo->ii_Unique;
     buildstate.haveDead = false;
@@ -200,6 +204,23 @@ btbuild(Relation heap, Relation index, IndexInfo *indexInfo)
         elog(ERROR, "index \"%s\" already contains data",
              RelationGetRelationName(index));
 
+#ifdef __TBASE__
+    /* hand big builds over to parallel workers, see nbtsort.c */
+    nworkers = _bt_parallel_build_workers(heap, index, indexInfo);
+    if (nworkers > 0)
+    {
+        result = _bt_parallel_build(heap, index, indexInfo, nworkers);
+#ifdef BTREE_BUILD_STATS
+        if (log_btree_build_stats)
+        {
+            ShowUsage("BTREE BUILD STATS");
+            ResetUsage();
+        }
+#endif                            /* BTREE_BUILD_STATS */
+        return result;
+    }
+#endif
+
     buildstate.spool = _bt_spoolinit(heap, index, indexInfo->ii_Unique, false);
 
     /*
@@ -221,6 +242,20 @@ btbuild(Relation heap, Relation index, IndexInfo *indexInfo)
         buildstate.spool2 = NULL;
     }
 
+#ifdef __TBASE__
+    {
+        const int    progress_index[] = {
+            PROGRESS_CREATEIDX_PHASE,
+            PROGRESS_CREATEIDX_TUPLES_SCANNED
+        };
+        int64        val[2];
+
+        val[0] = PROGRESS_CREATEIDX_PHASE_SORT;
+        val[1] = (int64) buildstate.indtuples;
+        pgstat_progress_update_multi_param(2, progress_index, val);
+    }
+#endif
+
     /*
      * Finish the build by (1) completing the sort of the spool file, (2)
      * inserting the sorted tuples into btree pages and (3) building the upper
@@ -277,6 +312,12 @@ btbuildCallback(Relation index,
     }
 
     buildstate->indtuples += 1;
+
+#ifdef __TBASE__
+    if ((int64) buildstate->indtuples % BTREE_BUILD_REPORT_INTERVAL == 0)
+        pgstat_progress_update_param(PROGRESS_CREATEIDX_TUPLES_SCANNED,
+                                     (int64) buildstate->indtuples);
+#endif
 }
 
 /*
@@ -79,6 +79,24 @@
 #include "utils/relcrypt.h"
 #include "storage/relcryptstorage.h"
 #endif
+#ifdef __TBASE__
+#include "access/genam.h"
+#include "access/parallel.h"
+#include "access/relscan.h"
+#include "access/xact.h"
+#include "catalog/catalog.h"
+#include "catalog/index.h"
+#include "commands/progress.h"
+#include "lib/binaryheap.h"
+#include "optimizer/paths.h"
+#include "pgstat.h"
+#include "storage/proc.h"
+#include "storage/shm_mq.h"
+#include "storage/shm_toc.h"
+#include "storage/spin.h"
+#include "utils/snapmgr.h"
+#include "utils/tqual.h"
+#endif
 
 
 /*
@@ -92,6 +110,9 @@ struct BTSpool
     Relation    heap;
     Relation    index;
     bool        isunique;
+#ifdef __TBASE__
+    double        ntuples;        /* # tuples spooled */
+#endif
 };
 
 /*
@@ -129,8 +150,92 @@ typedef struct BTWriteState
     BlockNumber btws_pages_alloced; /* # pages allocated */
     BlockNumber btws_pages_written; /* # pages written out */
     Page        btws_zeropage;    /* workspace for filling zeroes */
+#ifdef __TBASE__
+    int64        btws_tuples_loaded;    /* # leaf tuples added so far */
+#endif
 } BTWriteState;
 
+#ifdef __TBASE__
+/*
+ * Parallel btree builds.
+ *
+ * The leader and each worker scan a share of the heap, handed out block by
+ * block by a parallel heap scan, and sort what they found into spools of
+ * their own.  Workers then stream their sorted tuples to the leader through
+ * one shm_mq each, live and dead tuples merged into a single stream with a
+ * flag byte after every tuple telling which it is.  The leader merges its
+ * own spools with the worker streams and loads the result into the index.
+ * Every participant's tuplesort has only checked uniqueness among its own
+ * tuples, so the leader checks it across participants as it loads.
+ */
+#define PARALLEL_KEY_BTREE_SHARED        UINT64CONST(0xB000000000000001)
+#define PARALLEL_KEY_TUPLE_QUEUE        UINT64CONST(0xB000000000000002)
+
+/* size of the queue each worker sends its sorted tuples through */
+#define BT_PARALLEL_QUEUE_SIZE            ((Size) 65536)
+
+/*
+ * State shared by the participants of a parallel build.
+ */
+typedef struct BTShared
+{
+    Oid            heaprelid;
+    Oid            indexrelid;
+    bool        isunique;
+    int            sortmem;        /* sort memory per participant, in kB */
+
+    /* progress counters, summed over all participants */
+    pg_atomic_uint64 tuples_scanned;
+    pg_atomic_uint64 tuples_sorted;
+
+    /* added to by each worker once its share is sorted; protected by mutex */
+    slock_t        mutex;
+    int            nworkersdone;
+    double        reltuples;
+    double        indtuples;
+    bool        brokenhotchain;
+
+    /* must come last, its size depends on the snapshot */
+    ParallelHeapScanDescData heapdesc;
+} BTShared;
+
+/*
+ * Per-participant state of the heap scan.
+ */
+typedef struct BTParallelScanState
+{
+    BTShared   *btshared;
+    BTSpool    *spool;
+    BTSpool    *spool2;            /* dead tuples of a unique index, or NULL */
+    bool        haveDead;
+    double        indtuples;
+    uint64        unreported;        /* # tuples not added to tuples_scanned yet */
+} BTParallelScanState;
+
+/*
+ * One sorted input of a merge: a local spool or a worker's queue.
+ */
+typedef struct BTMergeSource
+{
+    BTSpool    *spool;
+    bool        dead;            /* spool holds dead tuples? */
+    shm_mq_handle *mqh;
+    IndexTuple    itup;            /* current tuple, NULL once exhausted */
+    bool        itup_dead;
+} BTMergeSource;
+
+typedef struct BTMergeState
+{
+    TupleDesc    tupdes;
+    int            keysz;
+    SortSupport sortKeys;
+    BTMergeSource *sources;
+    int            nsources;
+    binaryheap *heap;            /* sources not exhausted, by current tuple */
+    bool        started;
+} BTMergeState;
+#endif
+
 
 static Page _bt_blnewpage(uint32 level);
 static BTPageState *_bt_pagestate(BTWriteState *wstate, uint32 level);
@@ -142,6 +247,32 @@ static void _bt_buildadd(BTWriteState *wstate, BTPageState *state,
 static void _bt_uppershutdown(BTWriteState *wstate, BTPageState *state);
 static void _bt_load(BTWriteState *wstate,
          BTSpool *btspool, BTSpool *btspool2);
+static BTSpool *_bt_spoolcreate(Relation heap, Relation index,
+                bool isunique, int btKbytes);
+static void _bt_initwritestate(BTWriteState *wstate, Relation heap,
+                   Relation index);
+static void _bt_load_finish(BTWriteState *wstate, BTPageState *state);
+static SortSupport _bt_mksortkeys(Relation index);
+static int32 _bt_comparetup(IndexTuple itup1, IndexTuple itup2,
+               TupleDesc tupdes, int keysz, SortSupport sortKeys);
+#ifdef __TBASE__
+static double _bt_parallel_scan_and_sort(BTShared *btshared, Relation heap,
+                           Relation index, IndexInfo *indexInfo,
+                           BTParallelScanState *pstate);
+static void _bt_parallel_build_callback(Relation index, HeapTuple htup,
+                            Datum *values, bool *isnull,
+                            bool tupleIsAlive, void *state);
+static void _bt_parallel_report_scanned(BTParallelScanState *pstate);
+static void _bt_parallel_unique_violation(Relation heap, Relation index,
+                              IndexTuple itup);
+static void _bt_merge_init(BTMergeState *ms, Relation index, int maxsources);
+static void _bt_merge_addsource(BTMergeState *ms, BTSpool *spool, bool dead,
+                    shm_mq_handle *mqh);
+static void _bt_merge_advance(BTMergeSource *src);
+static int    _bt_merge_cmp(Datum a, Datum b, void *arg);
+static IndexTuple _bt_merge_getnext(BTMergeState *ms, bool *dead);
+static void _bt_merge_end(BTMergeState *ms);
+#endif
 
 
 /*
@@ -155,13 +286,8 @@ static void _bt_load(BTWriteState *wstate,
 BTSpool *
 _bt_spoolinit(Relation heap, Relation index, bool isunique, bool isdead)
 {
-    BTSpool    *btspool = (BTSpool *) palloc0(sizeof(BTSpool));
     int            btKbytes;
 
-    btspool->heap = heap;
-    btspool->index = index;
-    btspool->isunique = isunique;
-
     /*
      * We size the sort area as maintenance_work_mem rather than work_mem to
      * speed index creation.  This should be OK since a single backend can't
@@ -171,6 +297,21 @@ _bt_spoolinit(Relation heap, Relation index, bool isunique, bool isdead)
      * work_mem.
      */
     btKbytes = isdead ? work_mem : maintenance_work_mem;
+
+    return _bt_spoolcreate(heap, index, isunique, btKbytes);
+}
+
+/*
+ * create a spool whose sort may use btKbytes of memory
+ */
+static BTSpool *
+_bt_spoolcreate(Relation heap, Relation index, bool isunique, int btKbytes)
+{
+    BTSpool    *btspool = (BTSpool *) palloc0(sizeof(BTSpool));
+
+    btspool->heap = heap;
+    btspool->index = index;
+    btspool->isunique = isunique;
     btspool->sortstate = tuplesort_begin_index_btree(heap, index, isunique,
                                                      btKbytes, false);
 
@@ -195,6 +336,9 @@ _bt_spool(BTSpool *btspool, ItemPointer self, Datum *values, bool *isnull)
 {
     tuplesort_putindextuplevalues(btspool->sortstate, btspool->index,
                                   self, values, isnull);
+#ifdef __TBASE__
+    btspool->ntuples += 1;
+#endif
 }
 
 /*
@@ -218,21 +362,47 @@ _bt_leafbuild(BTSpool *btspool, BTSpool *btspool2)
     if (btspool2)
         tuplesort_performsort(btspool2->sortstate);
 
-    wstate.heap = btspool->heap;
-    wstate.index = btspool->index;
+#ifdef __TBASE__
+    {
+        const int    progress_index[] = {
+            PROGRESS_CREATEIDX_PHASE,
+            PROGRESS_CREATEIDX_TUPLES_SORTED
+        };
+        int64        val[2];
+
+        val[0] = PROGRESS_CREATEIDX_PHASE_LOAD;
+        val[1] = (int64) (btspool->ntuples +
+                          (btspool2 ? btspool2->ntuples : 0));
+        pgstat_progress_update_multi_param(2, progress_index, val);
+    }
+#endif
+
+    _bt_initwritestate(&wstate, btspool->heap, btspool->index);
+    _bt_load(&wstate, btspool, btspool2);
+}
+
+/*
+ * set up the write state for loading a new index
+ */
+static void
+_bt_initwritestate(BTWriteState *wstate, Relation heap, Relation index)
+{
+    wstate->heap = heap;
+    wstate->index = index;
 
     /*
      * We need to log index creation in WAL iff WAL archiving/streaming is
      * enabled UNLESS the index isn't WAL-logged anyway.
      */
-    wstate.btws_use_wal = XLogIsNeeded() && RelationNeedsWAL(wstate.index);
+    wstate->btws_use_wal = XLogIsNeeded() && RelationNeedsWAL(wstate->index);
 
     /* reserve the metapage */
-    wstate.btws_pages_alloced = BTREE_METAPAGE + 1;
-    wstate.btws_pages_written = 0;
-    wstate.btws_zeropage = NULL;    /* until needed */
-
-    _bt_load(&wstate, btspool, btspool2);
+    wstate->btws_pages_alloced = BTREE_METAPAGE + 1;
+    wstate->btws_pages_written = 0;
+    wstate->btws_zeropage = NULL;    /* until needed */
+#ifdef __TBASE__
+    wstate->btws_tuples_loaded = 0;
+#endif
 }
 
 
@@ -485,6 +655,13 @@ _bt_buildadd(BTWriteState *wstate, BTPageState *state, IndexTuple itup)
      */
     CHECK_FOR_INTERRUPTS();
 
+#ifdef __TBASE__
+    if (state->btps_level == 0 &&
+        ++wstate->btws_tuples_loaded % BTREE_BUILD_REPORT_INTERVAL == 0)
+        pgstat_progress_update_param(PROGRESS_CREATEIDX_TUPLES_LOADED,
+                                     wstate->btws_tuples_loaded);
+#endif
+
     npage = state->btps_page;
     nblkno = state->btps_blkno;
     last_off = state->btps_lastoff;
@@ -697,16 +874,14 @@ _bt_uppershutdown(BTWriteState *wstate, BTPageState *state)
  */
 static void
 _bt_load(BTWriteState *wstate, BTSpool *btspool, BTSpool *btspool2)
-{// #lizard forgives
+{
     BTPageState *state = NULL;
     bool        merge = (btspool2 != NULL);
     IndexTuple    itup,
                 itup2 = NULL;
     bool        load1;
     TupleDesc    tupdes = RelationGetDescr(wstate->index);
-    int            i,
-                keysz = RelationGetNumberOfAttributes(wstate->index);
-    ScanKey        indexScanKey = NULL;
+    int            keysz = RelationGetNumberOfAttributes(wstate->index);
     SortSupport sortKeys;
 
     if (merge)
@@ -719,34 +894,7 @@ _bt_load(BTWriteState *wstate, BTSpool *btspool, BTSpool *btspool2)
         /* the preparation of merge */
         itup = tuplesort_getindextuple(btspool->sortstate, true);
         itup2 = tuplesort_getindextuple(btspool2->sortstate, true);
-        indexScanKey = _bt_mkscankey_nodata(wstate->index);
-
-        /* Prepare SortSupport data for each column */
-        sortKeys = (SortSupport) palloc0(keysz * sizeof(SortSupportData));
-
-        for (i = 0; i < keysz; i++)
-        {
-            SortSupport sortKey = sortKeys + i;
-            ScanKey        scanKey = indexScanKey + i;
-            int16        strategy;
-
-            sortKey->ssup_cxt = CurrentMemoryContext;
-            sortKey->ssup_collation = scanKey->sk_collation;
-            sortKey->ssup_nulls_first =
-                (scanKey->sk_flags & SK_BT_NULLS_FIRST) != 0;
-            sortKey->ssup_attno = scanKey->sk_attno;
-            /* Abbreviation is not supported here */
-            sortKey->abbreviate = false;
-
-            AssertState(sortKey->ssup_attno != 0);
-
-            strategy = (scanKey->sk_flags & SK_BT_DESC) != 0 ?
-                BTGreaterStrategyNumber : BTLessStrategyNumber;
-
-            PrepareSortSupportFromIndexRel(wstate->index, strategy, sortKey);
-        }
-
-        _bt_freeskey(indexScanKey);
+        sortKeys = _bt_mksortkeys(wstate->index);
 
         for (;;)
         {
@@ -757,32 +905,8 @@ _bt_load(BTWriteState *wstate, BTSpool *btspool, BTSpool *btspool2)
                     break;
             }
             else if (itup != NULL)
-            {
-                for (i = 1; i <= keysz; i++)
-                {
-                    SortSupport entry;
-                    Datum        attrDatum1,
-                                attrDatum2;
-                    bool        isNull1,
-                                isNull2;
-                    int32        compare;
-
-                    entry = sortKeys + i - 1;
-                    attrDatum1 = index_getattr(itup, i, tupdes, &isNull1);
-                    attrDatum2 = index_getattr(itup2, i, tupdes, &isNull2);
-
-                    compare = ApplySortComparator(attrDatum1, isNull1,
-                                                  attrDatum2, isNull2,
-                                                  entry);
-                    if (compare > 0)
-                    {
-                        load1 = false;
-                        break;
-                    }
-                    else if (compare < 0)
-                        break;
-                }
-            }
+                load1 = _bt_comparetup(itup, itup2, tupdes, keysz,
+                                       sortKeys) <= 0;
             else
                 load1 = false;
 
@@ -817,6 +941,20 @@ _bt_load(BTWriteState *wstate, BTSpool *btspool, BTSpool *btspool2)
         }
     }
 
+    _bt_load_finish(wstate, state);
+}
+
+/*
+ * Finish loading an index once all the leaf tuples have been added.
+ */
+static void
+_bt_load_finish(BTWriteState *wstate, BTPageState *state)
+{
+#ifdef __TBASE__
+    pgstat_progress_update_param(PROGRESS_CREATEIDX_TUPLES_LOADED,
+                                 wstate->btws_tuples_loaded);
+#endif
+
     /* Close down final pages and write the metapage */
     _bt_uppershutdown(wstate, state);
 
@@ -841,3 +979,634 @@ _bt_load(BTWriteState *wstate, BTSpool *btspool, BTSpool *btspool2)
         smgrimmedsync(wstate->index->rd_smgr, MAIN_FORKNUM);
     }
 }
+
+/*
+ * Prepare SortSupport data for each column of the index, to compare index
+ * tuples in the order the spools sort them in.
+ */
+static SortSupport
+_bt_mksortkeys(Relation index)
+{
+    int            i,
+                keysz = RelationGetNumberOfAttributes(index);
+    ScanKey        indexScanKey;
+    SortSupport sortKeys;
+
+    indexScanKey = _bt_mkscankey_nodata(index);
+    sortKeys = (SortSupport) palloc0(keysz * sizeof(SortSupportData));
+
+    for (i = 0; i < keysz; i++)
+    {
+        SortSupport sortKey = sortKeys + i;
+        ScanKey        scanKey = indexScanKey + i;
+        int16        strategy;
+
+        sortKey->ssup_cxt = CurrentMemoryContext;
+        sortKey->ssup_collation = scanKey->sk_collation;
+        sortKey->ssup_nulls_first =
+            (scanKey->sk_flags & SK_BT_NULLS_FIRST) != 0;
+        sortKey->ssup_attno = scanKey->sk_attno;
+        /* Abbreviation is not supported here */
+        sortKey->abbreviate = false;
+
+        AssertState(sortKey->ssup_attno != 0);
+
+        strategy = (scanKey->sk_flags & SK_BT_DESC) != 0 ?
+            BTGreaterStrategyNumber : BTLessStrategyNumber;
+
+        PrepareSortSupportFromIndexRel(index, strategy, sortKey);
+    }
+
+    _bt_freeskey(indexScanKey);
+
+    return sortKeys;
+}
+
+/*
+ * Compare two index tuples on all their columns; negative if itup1 sorts
+ * before itup2, zero if they are equal.
+ */
+static int32
+_bt_comparetup(IndexTuple itup1, IndexTuple itup2, TupleDesc tupdes,
+               int keysz, SortSupport sortKeys)
+{
+    int            i;
+
+    for (i = 1; i <= keysz; i++)
+    {
+        SortSupport entry;
+        Datum        attrDatum1,
+                    attrDatum2;
+        bool        isNull1,
+                    isNull2;
+        int32        compare;
+
+        entry = sortKeys + i - 1;
+        attrDatum1 = index_getattr(itup1, i, tupdes, &isNull1);
+        attrDatum2 = index_getattr(itup2, i, tupdes, &isNull2);
+
+        compare = ApplySortComparator(attrDatum1, isNull1,
+                                      attrDatum2, isNull2,
+                                      entry);
+        if (compare != 0)
+            return compare;
+    }
+
+    return 0;
+}
+
+#ifdef __TBASE__
+/*
+ * _bt_parallel_build_workers() -- number of workers to build an index with
+ *
+ * Zero means the build runs serially.  Like parallel sequential scans, we
+ * ask for one worker once the heap reaches min_parallel_table_scan_size
+ * and one more each time it triples, unless the heap's parallel_workers
+ * storage parameter says otherwise.
+ */
+int
+_bt_parallel_build_workers(Relation heap, Relation index, IndexInfo *indexInfo)
+{
+    int            nworkers;
+
+    if (max_parallel_maintenance_workers <= 0 ||
+        IsBootstrapProcessingMode() ||
+        IsInParallelMode() ||
+        !ActiveSnapshotSet())
+        return 0;
+
+    /*
+     * Concurrent builds index what their MVCC snapshot sees, which the
+     * parallel heap scan does not support, and expressions and predicates
+     * could call functions that are not safe to run in workers.
+     */
+    if (indexInfo->ii_Concurrent ||
+        indexInfo->ii_Expressions != NIL ||
+        indexInfo->ii_Predicate != NIL)
+        return 0;
+
+    /* workers can't see the leader's local buffers */
+    if (IsSystemRelation(heap) || RelationUsesLocalBuffers(heap))
+        return 0;
+
+    nworkers = RelationGetParallelWorkers(heap, -1);
+    if (nworkers < 0)
+    {
+        BlockNumber heap_blocks = RelationGetNumberOfBlocks(heap);
+        int            heap_parallel_threshold;
+
+        heap_parallel_threshold = Max(min_parallel_table_scan_size, 1);
+        if (heap_blocks < (BlockNumber) heap_parallel_threshold)
+            return 0;
+
+        nworkers = 1;
+        while (heap_blocks >= (BlockNumber) (heap_parallel_threshold * 3))
+        {
+            nworkers++;
+            heap_parallel_threshold *= 3;
+            if (heap_parallel_threshold > INT_MAX / 3)
+                break;            /* avoid overflow */
+        }
+    }
+
+    return Min(nworkers, max_parallel_maintenance_workers);
+}
+
+/*
+ * _bt_parallel_build() -- build a btree index with parallel workers
+ *
+ * Called by btbuild in place of the serial heap scan and load.
+ */
+IndexBuildResult *
+_bt_parallel_build(Relation heap, Relation index, IndexInfo *indexInfo,
+                   int nworkers)
+{// #lizard forgives
+    IndexBuildResult *result;
+    ParallelContext *pcxt;
+    BTShared   *btshared;
+    Size        estbtshared;
+    char       *mqspace;
+    BTParallelScanState pstate;
+    BTMergeState ms;
+    BTWriteState wstate;
+    BTPageState *state = NULL;
+    IndexTuple    itup;
+    IndexTuple    lastlive = NULL;
+    Size        lastlivesz = 0;
+    bool        dead;
+    double        reltuples;
+    double        indtuples;
+    int            nlaunched;
+    int            i;
+
+    EnterParallelMode();
+    pcxt = CreateParallelContext("postgres", "_bt_parallel_build_main",
+                                 nworkers);
+
+    estbtshared = add_size(offsetof(BTShared, heapdesc),
+                           heap_parallelscan_estimate(SnapshotAny));
+    shm_toc_estimate_chunk(&pcxt->estimator, estbtshared);
+    shm_toc_estimate_chunk(&pcxt->estimator,
+                           mul_size(BT_PARALLEL_QUEUE_SIZE, nworkers));
+    shm_toc_estimate_keys(&pcxt->estimator, 2);
+
+    InitializeParallelDSM(pcxt);
+
+    btshared = (BTShared *) shm_toc_allocate(pcxt->toc, estbtshared);
+    btshared->heaprelid = RelationGetRelid(heap);
+    btshared->indexrelid = RelationGetRelid(index);
+    btshared->isunique = indexInfo->ii_Unique;
+    btshared->sortmem = Max(maintenance_work_mem / (nworkers + 1), 64);
+    pg_atomic_init_u64(&btshared->tuples_scanned, 0);
+    pg_atomic_init_u64(&btshared->tuples_sorted, 0);
+    SpinLockInit(&btshared->mutex);
+    btshared->nworkersdone = 0;
+    btshared->reltuples = 0;
+    btshared->indtuples = 0;
+    btshared->brokenhotchain = false;
+    heap_parallelscan_initialize(&btshared->heapdesc, heap, SnapshotAny);
+    shm_toc_insert(pcxt->toc, PARALLEL_KEY_BTREE_SHARED, btshared);
+
+    mqspace = (char *) shm_toc_allocate(pcxt->toc,
+                                        mul_size(BT_PARALLEL_QUEUE_SIZE,
+                                                 nworkers));
+    for (i = 0; i < nworkers; i++)
+    {
+        shm_mq       *mq;
+
+        mq = shm_mq_create(mqspace + (Size) i * BT_PARALLEL_QUEUE_SIZE,
+                           BT_PARALLEL_QUEUE_SIZE);
+        shm_mq_set_receiver(mq, MyProc);
+    }
+    shm_toc_insert(pcxt->toc, PARALLEL_KEY_TUPLE_QUEUE, mqspace);
+
+    LaunchParallelWorkers(pcxt);
+    nlaunched = pcxt->nworkers_launched;
+    pgstat_progress_update_param(PROGRESS_CREATEIDX_WORKERS, nlaunched);
+
+    /* meanwhile, scan and sort our own share of the heap */
+    reltuples = _bt_parallel_scan_and_sort(btshared, heap, index, indexInfo,
+                                           &pstate);
+
+    pgstat_progress_update_param(PROGRESS_CREATEIDX_PHASE,
+                                 PROGRESS_CREATEIDX_PHASE_LOAD);
+
+    /*
+     * Merge our spools with the workers' streams.  A worker that was
+     * registered but never started just looks like an empty stream, its
+     * blocks having gone to the other participants.
+     */
+    _bt_merge_init(&ms, index, nlaunched + 2);
+    _bt_merge_addsource(&ms, pstate.spool, false, NULL);
+    if (pstate.spool2)
+        _bt_merge_addsource(&ms, pstate.spool2, true, NULL);
+    for (i = 0; i < nlaunched; i++)
+    {
+        shm_mq       *mq;
+
+        mq = (shm_mq *) (mqspace + (Size) i * BT_PARALLEL_QUEUE_SIZE);
+        _bt_merge_addsource(&ms, NULL, false,
+                            shm_mq_attach(mq, pcxt->seg,
+                                          pcxt->worker[i].bgwhandle));
+    }
+
+    _bt_initwritestate(&wstate, heap, index);
+    while ((itup = _bt_merge_getnext(&ms, &dead)) != NULL)
+    {
+        /* dead tuples are kept out of the uniqueness check, as usual */
+        if (btshared->isunique && !dead)
+        {
+            Size        itupsz = IndexTupleSize(itup);
+
+            if (lastlive != NULL && !IndexTupleHasNulls(itup) &&
+                _bt_comparetup(itup, lastlive, ms.tupdes, ms.keysz,
+                               ms.sortKeys) == 0)
+                _bt_parallel_unique_violation(heap, index, itup);
+
+            if (itupsz > lastlivesz)
+            {
+                if (lastlive != NULL)
+                    pfree(lastlive);
+                lastlivesz = itupsz;
+                lastlive = (IndexTuple) palloc(lastlivesz);
+            }
+            memcpy(lastlive, itup, itupsz);
+        }
+
+        /* When we see first tuple, create first index page */
+        if (state == NULL)
+            state = _bt_pagestate(&wstate, 0);
+
+        _bt_buildadd(&wstate, state, itup);
+
+        if (wstate.btws_tuples_loaded % BTREE_BUILD_REPORT_INTERVAL == 0)
+        {
+            const int    progress_index[] = {
+                PROGRESS_CREATEIDX_TUPLES_SCANNED,
+                PROGRESS_CREATEIDX_TUPLES_SORTED
+            };
+            int64        val[2];
+
+            val[0] = pg_atomic_read_u64(&btshared->tuples_scanned);
+            val[1] = pg_atomic_read_u64(&btshared->tuples_sorted);
+            pgstat_progress_update_multi_param(2, progress_index, val);
+        }
+    }
+
+    /*
+     * All streams have ended.  Make sure that no worker ended its stream by
+     * exiting early, leaving tuples out of the index.
+     */
+    WaitForParallelWorkersToFinish(pcxt);
+    if (btshared->nworkersdone != nlaunched)
+        elog(ERROR, "parallel index build worker exited without sending all its tuples");
+
+    reltuples += btshared->reltuples;
+    indtuples = pstate.indtuples + btshared->indtuples;
+    if (btshared->brokenhotchain)
+        indexInfo->ii_BrokenHotChain = true;
+
+    _bt_merge_end(&ms);
+    if (lastlive != NULL)
+        pfree(lastlive);
+    DestroyParallelContext(pcxt);
+    ExitParallelMode();
+
+    _bt_load_finish(&wstate, state);
+
+    result = (IndexBuildResult *) palloc(sizeof(IndexBuildResult));
+    result->heap_tuples = reltuples;
+    result->index_tuples = indtuples;
+
+    return result;
+}
+
+/*
+ * _bt_parallel_build_main() -- entry point of parallel build workers
+ */
+void
+_bt_parallel_build_main(dsm_segment *seg, shm_toc *toc)
+{
+    BTShared   *btshared;
+    char       *mqspace;
+    shm_mq       *mq;
+    shm_mq_handle *mqh;
+    Relation    heapRel;
+    Relation    indexRel;
+    IndexInfo  *indexInfo;
+    BTParallelScanState pstate;
+    BTMergeState ms;
+    IndexTuple    itup;
+    bool        dead;
+    double        reltuples;
+
+    btshared = (BTShared *) shm_toc_lookup(toc, PARALLEL_KEY_BTREE_SHARED,
+                                           false);
+    mqspace = (char *) shm_toc_lookup(toc, PARALLEL_KEY_TUPLE_QUEUE, false);
+    mq = (shm_mq *) (mqspace +
+                     (Size) ParallelWorkerNumber * BT_PARALLEL_QUEUE_SIZE);
+    shm_mq_set_sender(mq, MyProc);
+    mqh = shm_mq_attach(mq, seg, NULL);
+
+    /*
+     * The leader holds stronger locks on both relations, which don't
+     * conflict with ours since we are in its lock group.
+     */
+    heapRel = heap_open(btshared->heaprelid, ShareLock);
+    indexRel = index_open(btshared->indexrelid, RowExclusiveLock);
+    indexInfo = BuildIndexInfo(indexRel);
+
+    reltuples = _bt_parallel_scan_and_sort(btshared, heapRel, indexRel,
+                                           indexInfo, &pstate);
+
+    SpinLockAcquire(&btshared->mutex);
+    btshared->reltuples += reltuples;
+    btshared->indtuples += pstate.indtuples;
+    if (indexInfo->ii_BrokenHotChain)
+        btshared->brokenhotchain = true;
+    SpinLockRelease(&btshared->mutex);
+
+    /* stream our live and dead tuples to the leader, merged */
+    _bt_merge_init(&ms, indexRel, 2);
+    _bt_merge_addsource(&ms, pstate.spool, false, NULL);
+    if (pstate.spool2)
+        _bt_merge_addsource(&ms, pstate.spool2, true, NULL);
+
+    while ((itup = _bt_merge_getnext(&ms, &dead)) != NULL)
+    {
+        shm_mq_iovec iov[2];
+        char        flag = dead ? 1 : 0;
+
+        iov[0].data = (char *) itup;
+        iov[0].len = IndexTupleSize(itup);
+        iov[1].data = &flag;
+        iov[1].len = 1;
+
+        /* if the leader went away, its own error will say why */
+        if (shm_mq_sendv(mqh, iov, 2, false) != SHM_MQ_SUCCESS)
+            break;
+    }
+
+    SpinLockAcquire(&btshared->mutex);
+    btshared->nworkersdone++;
+    SpinLockRelease(&btshared->mutex);
+
+    shm_mq_detach(mq);
+    _bt_merge_end(&ms);
+
+    index_close(indexRel, RowExclusiveLock);
+    heap_close(heapRel, ShareLock);
+}
+
+/*
+ * Scan this participant's share of the heap into its spools and sort them.
+ * Returns the number of heap tuples seen.
+ */
+static double
+_bt_parallel_scan_and_sort(BTShared *btshared, Relation heap, Relation index,
+                           IndexInfo *indexInfo, BTParallelScanState *pstate)
+{
+    double        reltuples;
+
+    pstate->btshared = btshared;
+    pstate->spool = _bt_spoolcreate(heap, index, btshared->isunique,
+                                    btshared->sortmem);
+
+    /*
+     * If building a unique index, put dead tuples in a second spool to keep
+     * them out of the uniqueness check.  As in a serial build, we expect it
+     * to stay small.
+     */
+    pstate->spool2 = btshared->isunique ?
+        _bt_spoolcreate(heap, index, false, work_mem) : NULL;
+    pstate->haveDead = false;
+    pstate->indtuples = 0;
+    pstate->unreported = 0;
+
+    reltuples = IndexBuildHeapParallelScan(heap, index, indexInfo,
+                                           &btshared->heapdesc,
+                                           _bt_parallel_build_callback,
+                                           (void *) pstate);
+    _bt_parallel_report_scanned(pstate);
+
+    if (pstate->spool2 && !pstate->haveDead)
+    {
+        /* spool2 turns out to be unnecessary */
+        _bt_spooldestroy(pstate->spool2);
+        pstate->spool2 = NULL;
+    }
+
+    if (!IsParallelWorker())
+        pgstat_progress_update_param(PROGRESS_CREATEIDX_PHASE,
+                                     PROGRESS_CREATEIDX_PHASE_SORT);
+
+    tuplesort_performsort(pstate->spool->sortstate);
+    if (pstate->spool2)
+        tuplesort_performsort(pstate->spool2->sortstate);
+
+    pg_atomic_fetch_add_u64(&btshared->tuples_sorted,
+                            (int64) pstate->indtuples);
+
+    return reltuples;
+}
+
+/*
+ * Per-tuple callback from IndexBuildHeapParallelScan
+ */
+static void
+_bt_parallel_build_callback(Relation index,
+                            HeapTuple htup,
+                            Datum *values,
+                            bool *isnull,
+                            bool tupleIsAlive,
+                            void *state)
+{
+    BTParallelScanState *pstate = (BTParallelScanState *) state;
+
+    if (tupleIsAlive || pstate->spool2 == NULL)
+        _bt_spool(pstate->spool, &htup->t_self, values, isnull);
+    else
+    {
+        /* dead tuples are put into spool2 */
+        pstate->haveDead = true;
+        _bt_spool(pstate->spool2, &htup->t_self, values, isnull);
+    }
+
+    pstate->indtuples += 1;
+
+    if (++pstate->unreported >= BTREE_BUILD_REPORT_INTERVAL)
+        _bt_parallel_report_scanned(pstate);
+}
+
+/*
+ * Add the tuples spooled since the last call to the shared count, which
+ * the leader advertises as progress.
+ */
+static void
+_bt_parallel_report_scanned(BTParallelScanState *pstate)
+{
+    uint64        scanned;
+
+    scanned = pg_atomic_add_fetch_u64(&pstate->btshared->tuples_scanned,
+                                      (int64) pstate->unreported);
+    pstate->unreported = 0;
+
+    if (!IsParallelWorker())
+        pgstat_progress_update_param(PROGRESS_CREATEIDX_TUPLES_SCANNED,
+                                     (int64) scanned);
+}
+
+/*
+ * Report two live tuples with equal keys, as tuplesort would have.
+ */
+static void
+_bt_parallel_unique_violation(Relation heap, Relation index, IndexTuple itup)
+{
+    Datum        values[INDEX_MAX_KEYS];
+    bool        isnull[INDEX_MAX_KEYS];
+    char       *key_desc;
+
+    index_deform_tuple(itup, RelationGetDescr(index), values, isnull);
+    key_desc = BuildIndexValueDescription(index, values, isnull);
+
+    ereport(ERROR,
+            (errcode(ERRCODE_UNIQUE_VIOLATION),
+             errmsg("could not create unique index \"%s\"",
+                    RelationGetRelationName(index)),
+             key_desc ? errdetail("Key %s is duplicated.", key_desc) :
+             errdetail("Duplicate keys exist."),
+             errtableconstraint(heap, RelationGetRelationName(index))));
+}
+
+/*
+ * Set up a merge of at most maxsources sorted inputs.
+ */
+static void
+_bt_merge_init(BTMergeState *ms, Relation index, int maxsources)
+{
+    ms->tupdes = RelationGetDescr(index);
+    ms->keysz = RelationGetNumberOfAttributes(index);
+    ms->sortKeys = _bt_mksortkeys(index);
+    ms->sources = (BTMergeSource *) palloc0(maxsources * sizeof(BTMergeSource));
+    ms->nsources = 0;
+    ms->heap = binaryheap_allocate(maxsources, _bt_merge_cmp, ms);
+    ms->started = false;
+}
+
+/*
+ * Add a sorted spool, or the queue of a worker, to a merge.
+ */
+static void
+_bt_merge_addsource(BTMergeState *ms, BTSpool *spool, bool dead,
+                    shm_mq_handle *mqh)
+{
+    BTMergeSource *src = &ms->sources[ms->nsources++];
+
+    src->spool = spool;
+    src->dead = dead;
+    src->mqh = mqh;
+    src->itup = NULL;
+}
+
+/*
+ * Move a merge input on to its next tuple.
+ *
+ * A tuple read from a queue stays valid until the next read from the same
+ * queue, which is just what the merge needs.
+ */
+static void
+_bt_merge_advance(BTMergeSource *src)
+{
+    Size        nbytes;
+    void       *data;
+
+    if (src->spool != NULL)
+    {
+        src->itup = tuplesort_getindextuple(src->spool->sortstate, true);
+        src->itup_dead = src->dead;
+        return;
+    }
+
+    /* a detached queue means the worker has sent everything */
+    if (shm_mq_receive(src->mqh, &nbytes, &data, false) != SHM_MQ_SUCCESS)
+    {
+        src->itup = NULL;
+        return;
+    }
+
+    src->itup = (IndexTuple) data;
+    src->itup_dead = ((char *) data)[nbytes - 1] != 0;
+}
+
+/*
+ * binaryheap comparator; the heap keeps its largest element on top, so put
+ * the source with the smallest current tuple there.
+ */
+static int
+_bt_merge_cmp(Datum a, Datum b, void *arg)
+{
+    BTMergeState *ms = (BTMergeState *) arg;
+
+    return _bt_comparetup(ms->sources[DatumGetInt32(b)].itup,
+                          ms->sources[DatumGetInt32(a)].itup,
+                          ms->tupdes, ms->keysz, ms->sortKeys);
+}
+
+/*
+ * Return the next tuple of a merge in sort order, or NULL at the end.  The
+ * tuple is valid until the next call.
+ */
+static IndexTuple
+_bt_merge_getnext(BTMergeState *ms, bool *dead)
+{
+    BTMergeSource *src;
+    int            i;
+
+    if (!ms->started)
+    {
+        for (i = 0; i < ms->nsources; i++)
+        {
+            _bt_merge_advance(&ms->sources[i]);
+            if (ms->sources[i].itup != NULL)
+                binaryheap_add_unordered(ms->heap, Int32GetDatum(i));
+        }
+        binaryheap_build(ms->heap);
+        ms->started = true;
+    }
+    else if (!binaryheap_empty(ms->heap))
+    {
+        /* the tuple returned last time has been used up */
+        i = DatumGetInt32(binaryheap_first(ms->heap));
+        _bt_merge_advance(&ms->sources[i]);
+        if (ms->sources[i].itup != NULL)
+            binaryheap_replace_first(ms->heap, Int32GetDatum(i));
+        else
+            (void) binaryheap_remove_first(ms->heap);
+    }
+
+    if (binaryheap_empty(ms->heap))
+        return NULL;
+
+    src = &ms->sources[DatumGetInt32(binaryheap_first(ms->heap))];
+    *dead = src->itup_dead;
+    return src->itup;
+}
+
+/*
+ * Clean up a merge, including the spools it read from.
+ */
+static void
+_bt_merge_end(BTMergeState *ms)
+{
+    int            i;
+
+    for (i = 0; i < ms->nsources; i++)
+    {
+        if (ms->sources[i].spool != NULL)
+            _bt_spooldestroy(ms->sources[i].spool);
+    }
+    binaryheap_free(ms->heap);
+    pfree(ms->sortKeys);
+    pfree(ms->sources);
+}
+#endif
@@ -19,15 +19,28 @@ void
 barrier_desc(StringInfo buf, XLogReaderState *record)
 {
     char       *rec = XLogRecGetData(record);
-#ifdef USE_ASSERT_CHECKING
-    uint8       info = XLogRecGetInfo(record);
-    Assert(info == XLOG_BARRIER_CREATE);
+    uint8       info = XLogRecGetInfo(record) & ~XLR_INFO_MASK;
+
+#ifdef __TBASE__
+    if (info == XLOG_BARRIER_GTS)
+    {
+        xl_barrier_gts *xlrec = (xl_barrier_gts *) rec;
+
+        appendStringInfo(buf, "BARRIER %s gts " INT64_FORMAT,
+                         xlrec->barrier_id, xlrec->barrier_gts);
+        return;
+    }
 #endif
+    Assert(info == XLOG_BARRIER_CREATE);
     appendStringInfo(buf, "BARRIER %s", rec);
 }
 
 const char *
 barrier_identify(uint8 info)
 {
+#ifdef __TBASE__
+    if ((info & ~XLR_INFO_MASK) == XLOG_BARRIER_GTS)
+        return "CREATE_GTS";
+#endif
     return "CREATE";
 }
@@ -43,6 +43,7 @@
 #include "pgxc/nodemgr.h"
 #include "access/xlog.h"
 #include "storage/lmgr.h"
+#include "pgstat.h"
 #endif
 
 /* To access sequences */
@@ -1240,6 +1241,18 @@ ResetGTMConnection(void)
 	InitGTM();
 }
 
+#ifdef __TBASE__
+/* Report time spent waiting for GTM to answer as a wait event */
+static void
+GTMRoundTripWait(bool start)
+{
+    if (start)
+        pgstat_report_wait_start(WAIT_EVENT_GTM_ROUNDTRIP);
+    else
+        pgstat_report_wait_end();
+}
+#endif
+
 #ifdef HAVE_UNIX_SOCKETS
 /*
  * gtm_unix_socket_file_exists()
@@ -1281,6 +1294,8 @@ InitGTM(void)
 	const int max_try_cnt = 1;
     bool  same_host = false;
 
+	gtmpq_wait_hook = GTMRoundTripWait;
+
 	/*
 	 * Only re-set gtm info in two cases:
 	 * 1.No gtm info
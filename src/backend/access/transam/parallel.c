@@ -14,6 +14,7 @@
 
 #include "postgres.h"
 
+#include "access/nbtree.h"
 #include "access/parallel.h"
 #include "access/xact.h"
 #include "access/xlog.h"
@@ -131,6 +132,12 @@ static const struct
     {
         "ParallelQueryMain", ParallelQueryMain
     }
+#ifdef __TBASE__
+    ,
+    {
+        "_bt_parallel_build_main", _bt_parallel_build_main
+    }
+#endif
 };
 
 /* Private functions. */
@@ -552,6 +552,68 @@ void EndExplicitGlobalPrepare(char *gid)
     }
     SetGlobalPrepareTimestamp(InvalidGlobalTimestamp);
 }
+
+/*
+ * Oldest prepare GTS among the transactions prepared on this node that are
+ * not finished yet, or InvalidGlobalTimestamp if there are none.  On a
+ * standby these are the prepare records replayed without their COMMIT or
+ * ROLLBACK PREPARED: their commit GTS is above it but still unknown.
+ */
+GlobalTimestamp
+TwoPhaseGetOldestPrepareTimestamp(void)
+{
+    GlobalTimestamp oldest = InvalidGlobalTimestamp;
+    int            i;
+
+    if (max_prepared_xacts <= 0)
+        return InvalidGlobalTimestamp;
+
+    LWLockAcquire(TwoPhaseStateLock, LW_SHARED);
+    for (i = 0; i < TwoPhaseState->numPrepXacts; i++)
+    {
+        GlobalTransaction gxact = TwoPhaseState->prepXacts[i];
+
+        if (!GlobalTimestampIsValid(gxact->prepared_timestamp))
+            continue;
+        if (!GlobalTimestampIsValid(oldest) || gxact->prepared_timestamp < oldest)
+            oldest = gxact->prepared_timestamp;
+    }
+    LWLockRelease(TwoPhaseStateLock);
+
+    return oldest;
+}
+#endif
+
+#ifdef __TBASE__
+/*
+ * TwoPhaseGidIsBusy
+ *        Is a backend preparing, committing or rolling back the prepared
+ *        transaction gid right now?
+ */
+bool
+TwoPhaseGidIsBusy(const char *gid)
+{
+    bool        busy = false;
+    int            i;
+
+    if (max_prepared_xacts <= 0)
+        return false;
+
+    LWLockAcquire(TwoPhaseStateLock, LW_SHARED);
+    for (i = 0; i < TwoPhaseState->numPrepXacts; i++)
+    {
+        GlobalTransaction gxact = TwoPhaseState->prepXacts[i];
+
+        if (strcmp(gxact->gid, gid) != 0)
+            continue;
+
+        busy = !gxact->valid || gxact->locking_backend != InvalidBackendId;
+        break;
+    }
+    LWLockRelease(TwoPhaseStateLock);
+
+    return busy;
+}
 #endif
 
 
@@ -4400,6 +4462,147 @@ char *get_2pc_list_from_cache(int *count)
 	return recordList;
 }
 
+/*
+ * Read the 2pc record of tid from pg_2pc, NULL if there is none.
+ */
+static char *
+read_2pc_record_file(const char *tid)
+{
+	char path[MAXPGPATH];
+	struct stat fst;
+	char *result = NULL;
+	File fd = 0;
+	int ret = 0;
+
+	GET_2PC_FILE_PATH(path, tid);
+
+	if (stat(path, &fst) < 0 || 0 == fst.st_size)
+	{
+		return NULL;
+	}
+
+	fd = PathNameOpenFile(path, O_RDONLY, S_IRUSR | S_IWUSR);
+	if (fd < 0)
+	{
+		elog(LOG, "[%s] could not open file %s, errMsg: %s",
+			__FUNCTION__, path, strerror(errno));
+		return NULL;
+	}
+
+	result = (char *)palloc0(fst.st_size + 1);
+	ret = FileRead(fd, result, fst.st_size, WAIT_EVENT_BUFFILE_READ);
+	FileClose(fd);
+	if (ret != fst.st_size)
+	{
+		elog(LOG, "[%s] could not read file %s, ret: %d, file_size: %d",
+			__FUNCTION__, path, ret, (int) fst.st_size);
+		pfree(result);
+		return NULL;
+	}
+
+	return result;
+}
+
+/*
+ * Get the 2pc records of the implicit transactions started from startnode,
+ * both from the hash table and from pg_2pc.  Records of rolled back
+ * transactions are renamed and skipped.  Returns a list of Record2pcEntry,
+ * at most max_count of them.
+ */
+List *
+get_2pc_records_by_startnode(const char *startnode, int max_count)
+{
+	List *result = NIL;
+	char pattern[NAMEDATALEN + 2];
+	Record2pcEntry *rec = NULL;
+	DIR *dir = NULL;
+	struct dirent *de = NULL;
+	int i = 0;
+
+	snprintf(pattern, sizeof(pattern), ":%s:", startnode);
+
+	if (NULL != record_2pc_cache)
+	{
+		HASH_SEQ_STATUS seq;
+		Cache2pcInfo *entry = NULL;
+
+		for (i = 0; i < NUM_CACHE_2PC_PARTITIONS; i++)
+		{
+			LWLockAcquire(Cache2pcPartitionLockByIndex(i), LW_SHARED);
+		}
+
+		hash_seq_init(&seq, record_2pc_cache);
+		while ((entry = hash_seq_search(&seq)) != NULL)
+		{
+			if (!IsXidImplicit(entry->key) ||
+				NULL == strstr(entry->key, pattern))
+			{
+				continue;
+			}
+
+			rec = (Record2pcEntry *) palloc(sizeof(Record2pcEntry));
+			rec->gid = pstrdup(entry->key);
+			rec->info = pstrdup(entry->info);
+			result = lappend(result, rec);
+
+			if (list_length(result) >= max_count)
+			{
+				hash_seq_term(&seq);
+				break;
+			}
+		}
+
+		for (i = NUM_CACHE_2PC_PARTITIONS; --i >= 0;)
+		{
+			LWLockRelease(Cache2pcPartitionLockByIndex(i));
+		}
+	}
+
+	dir = AllocateDir(TWOPHASE_RECORD_DIR);
+	while (list_length(result) < max_count &&
+		   (de = ReadDir(dir, TWOPHASE_RECORD_DIR)) != NULL)
+	{
+		ListCell *lc = NULL;
+		char *info = NULL;
+		bool found = false;
+
+		/* rolled back records carry a timestamp suffix */
+		if (!IsXidImplicit(de->d_name) ||
+			NULL == strstr(de->d_name, pattern) ||
+			NULL != strstr(de->d_name, ".rollback"))
+		{
+			continue;
+		}
+
+		foreach(lc, result)
+		{
+			if (strcmp(((Record2pcEntry *) lfirst(lc))->gid, de->d_name) == 0)
+			{
+				found = true;
+				break;
+			}
+		}
+		if (found)
+		{
+			continue;
+		}
+
+		info = read_2pc_record_file(de->d_name);
+		if (NULL == info)
+		{
+			continue;
+		}
+
+		rec = (Record2pcEntry *) palloc(sizeof(Record2pcEntry));
+		rec->gid = pstrdup(de->d_name);
+		rec->info = info;
+		result = lappend(result, rec);
+	}
+	FreeDir(dir);
+
+	return result;
+}
+
 /*
  * Initialize 2pc info cache using shared memory hash table.
  */
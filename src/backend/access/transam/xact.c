@@ -269,6 +269,9 @@ typedef struct TransactionStateData
     List        *node_has_begin_txn_list;
     List        *node_has_begin_subtxn_list;
 #endif
+#ifdef __SUBSCRIPTION__
+    bool        assigned;        /* toplevel xid included in a WAL record? */
+#endif
 } TransactionStateData;
 
 typedef TransactionStateData *TransactionState;
@@ -671,6 +674,43 @@ MarkCurrentTransactionIdLoggedIfAny(void)
         CurrentTransactionState->didLogXid = true;
 }
 
+#ifdef __SUBSCRIPTION__
+/*
+ *    IsSubTransactionAssignmentPending
+ *
+ * With wal_level logical, the first WAL record of a subtransaction carries
+ * the toplevel xid, so that logical decoding knows the subtransaction before
+ * the commit record and can stream the transaction while it is in progress.
+ */
+bool
+IsSubTransactionAssignmentPending(void)
+{
+    if (!XLogLogicalInfoActive())
+        return false;
+
+    if (!IsTransactionState() || !IsSubTransaction())
+        return false;
+
+    if (!TransactionIdIsValid(GetCurrentTransactionIdIfAny()))
+        return false;
+
+    return !CurrentTransactionState->assigned;
+}
+
+/*
+ *    MarkSubTransactionAssigned
+ *
+ * Remember that the toplevel xid has been logged for this subtransaction.
+ */
+void
+MarkSubTransactionAssigned(void)
+{
+    Assert(IsSubTransactionAssignmentPending());
+
+    CurrentTransactionState->assigned = true;
+}
+#endif
+
 
 /*
  *    GetStableLatestTransactionId
@@ -2927,6 +2967,12 @@ CommitTransaction(void)
             FinishPreparedTransaction(savePrepareGID, true);
         }
 
+#ifdef __TBASE__
+        /* later reads of the session must see what the datanodes committed */
+        if (IS_PGXC_LOCAL_COORDINATOR)
+            PGXCNodeNoteCommit();
+#endif
+
         /*
          * The current transaction may have been ended and we might have
          * started a new transaction. Re-initialize with
@@ -3782,6 +3828,14 @@ AbortTransaction(void)
         
     if (!can_abort)
     {
+        /* let the 2pc clean launcher resolve it from our 2pc record */
+        if (IS_PGXC_LOCAL_COORDINATOR && g_twophase_state.is_start_node &&
+            false == g_twophase_state.isprinted && NULL != g_twophase_state.gid &&
+            IsXidImplicit(g_twophase_state.gid))
+        {
+            Clean2pcRequestResolve(g_twophase_state.gid);
+        }
+
         if (false == g_twophase_state.isprinted)
         {
             print_twophase_state(&errormsg, false);    
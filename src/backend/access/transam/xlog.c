@@ -36,6 +36,7 @@
 #include "access/xlog_internal.h"
 #include "access/xloginsert.h"
 #include "access/xlogreader.h"
+#include "access/xlogredo.h"
 #include "access/xlogutils.h"
 #include "catalog/catversion.h"
 #include "catalog/pg_control.h"
@@ -48,6 +49,9 @@
 #include "pgstat.h"
 #include "port/atomics.h"
 #include "postmaster/bgwriter.h"
+#ifdef __TBASE__
+#include "postmaster/clean2pc.h"
+#endif
 #include "postmaster/walwriter.h"
 #include "postmaster/startup.h"
 #include "replication/basebackup.h"
@@ -160,6 +164,10 @@ XLogRecPtr WalCheckStartPtr = InvalidXLogRecPtr;
 XLogRecPtr WalCheckEndPtr = InvalidXLogRecPtr;
 
 bool g_wal_check;
+
+/* adaptive group commit */
+bool        enable_adaptive_group_commit = false;
+int            group_commit_max_delay = 1000;    /* microseconds */
 #endif
 
 /*
@@ -324,6 +332,8 @@ static TimestampTz recoveryDelayUntilTime;
 #ifdef __TBASE__
 static GlobalTimestamp recoveryTargetGTS   = 0;
 static char           *recoveryGTMHost     = NULL;
+/* GTS of recovery_target_barrier, once its GTS barrier record is replayed */
+static GlobalTimestamp recoveryTargetBarrierGTS = InvalidGlobalTimestamp;
 GlobalTimestamp        segmentTrackGTS;
 RecoveryGTMHostInfo   *g_recovery_gtm_host = NULL;
 #endif
@@ -627,6 +637,24 @@ typedef struct XLogCtlInsert
     WALInsertLockPadded *WALInsertLocks;
 } XLogCtlInsert;
 
+#ifdef __TBASE__
+/* Shared state behind GroupCommitStats */
+typedef struct GroupCommitShared
+{
+    pg_atomic_uint64 requests;
+    pg_atomic_uint64 flushes;
+    pg_atomic_uint64 delayed_flushes;
+    pg_atomic_uint64 delay_time;
+    pg_atomic_uint64 queue_time;
+    pg_atomic_uint64 max_queue_time;
+    pg_atomic_uint64 avg_interval;
+    pg_atomic_uint64 avg_flush_time;
+    pg_atomic_uint32 window;
+    pg_atomic_uint64 last_arrival;
+    pg_atomic_uint64 stats_reset;
+} GroupCommitShared;
+#endif
+
 /*
  * Total shared-memory state for XLOG.
  */
@@ -760,6 +788,15 @@ typedef struct XLogCtlData
     XLogRecPtr    lastFpwDisableRecPtr;
 
     slock_t        info_lck;        /* locks shared variables shown above */
+
+#ifdef __TBASE__
+    /*
+     * Arrival rate of flush requests, flush latency and the resulting group
+     * commit window, with the statistics shown by pg_stat_group_commit.
+     * Only maintained while enable_adaptive_group_commit is on.
+     */
+    GroupCommitShared groupCommit;
+#endif
 } XLogCtlData;
 
 static XLogCtlData *XLogCtl = NULL;
@@ -907,6 +944,9 @@ static void exitArchiveRecovery(TimeLineID endTLI, XLogRecPtr endOfLog);
 static bool recoveryStopsBefore(XLogReaderState *record);
 static bool recoveryStopsAfter(XLogReaderState *record);
 static void recoveryPausesHere(void);
+#ifdef __TBASE__
+static void XLogParallelRedoSync(void);
+#endif
 static bool recoveryApplyDelay(XLogReaderState *record);
 static void SetLatestXTime(TimestampTz xtime);
 static void SetCurrentChunkStartTime(TimestampTz xtime);
@@ -923,6 +963,12 @@ static XLogRecPtr XLogGetReplicationSlotMinimumLSN(void);
 static void AdvanceXLInsertBuffer(XLogRecPtr upto, bool opportunistic);
 static bool XLogCheckpointNeeded(XLogSegNo new_segno);
 static void XLogWrite(XLogwrtRqst WriteRqst, bool flexible);
+#ifdef __TBASE__
+static int    GroupCommitArrival(TimestampTz now);
+static void GroupCommitInit(GroupCommitShared *gc);
+static void GroupCommitFlushed(long elapsed, int delay);
+static void GroupCommitDone(long elapsed);
+#endif
 static bool InstallXLogFileSegment(XLogSegNo *segno, char *tmppath,
                        bool find_free, XLogSegNo max_segno,
                        bool use_lock);
@@ -2878,6 +2924,177 @@ UpdateMinRecoveryPoint(XLogRecPtr lsn, bool force)
     LWLockRelease(ControlFileLock);
 }
 
+#ifdef __TBASE__
+/*
+ * Adaptive group commit.
+ *
+ * A backend that gets WALWriteLock to flush the WAL becomes the leader of a
+ * group commit: while it writes and fsyncs, other committing backends queue
+ * up behind the lock and are then satisfied by its flush, or by the next one.
+ * commit_delay makes the leader sleep before flushing so that more backends
+ * join, but a fixed delay is either too short to collect anyone under light
+ * load or adds latency for nothing.
+ *
+ * Instead we track, as moving averages, the interval between flush requests
+ * and how long a flush takes.  The leader waits for up to half a flush, capped
+ * by group_commit_max_delay, and only when at least one more request is
+ * expected to arrive within that window; each commit then pays at most half a
+ * flush in latency to save whole ones.
+ */
+#define GROUP_COMMIT_EWMA_WEIGHT    8
+
+/*
+ * Moving average after a new sample.  Concurrent updates may each lose the
+ * other's sample, which an average of this weight does not notice.
+ */
+static inline void
+GroupCommitAverage(pg_atomic_uint64 *avg, uint64 sample)
+{
+    uint64        old = pg_atomic_read_u64(avg);
+
+    if (old == 0)
+        pg_atomic_write_u64(avg, sample);
+    else
+        pg_atomic_write_u64(avg, (uint64) ((int64) old +
+                            ((int64) sample - (int64) old) / GROUP_COMMIT_EWMA_WEIGHT));
+}
+
+static void
+GroupCommitInit(GroupCommitShared *gc)
+{
+    pg_atomic_init_u64(&gc->requests, 0);
+    pg_atomic_init_u64(&gc->flushes, 0);
+    pg_atomic_init_u64(&gc->delayed_flushes, 0);
+    pg_atomic_init_u64(&gc->delay_time, 0);
+    pg_atomic_init_u64(&gc->queue_time, 0);
+    pg_atomic_init_u64(&gc->max_queue_time, 0);
+    pg_atomic_init_u64(&gc->avg_interval, 0);
+    pg_atomic_init_u64(&gc->avg_flush_time, 0);
+    pg_atomic_init_u32(&gc->window, 0);
+    pg_atomic_init_u64(&gc->last_arrival, 0);
+    pg_atomic_init_u64(&gc->stats_reset, (uint64) GetCurrentTimestamp());
+}
+
+/*
+ * Count a flush request arriving at now, and return how long its leader
+ * should wait for followers, in microseconds.
+ */
+static int
+GroupCommitArrival(TimestampTz now)
+{
+    GroupCommitShared *gc = &XLogCtl->groupCommit;
+    TimestampTz last;
+    uint64        interval;
+    uint64        avg_interval;
+    int            window = 0;
+
+    pg_atomic_fetch_add_u64(&gc->requests, 1);
+
+    last = (TimestampTz) pg_atomic_exchange_u64(&gc->last_arrival, (uint64) now);
+    if (last != 0 && now > last)
+    {
+        /*
+         * An idle gap longer than any window says only that nobody would
+         * have joined; don't let it swamp the average.
+         */
+        interval = (uint64) (now - last);
+        interval = Min(interval, 2 * Max((uint64) group_commit_max_delay,
+                                         pg_atomic_read_u64(&gc->avg_flush_time)));
+        GroupCommitAverage(&gc->avg_interval, interval);
+    }
+
+    if (enableFsync)
+    {
+        window = (int) Min((uint64) group_commit_max_delay,
+                           pg_atomic_read_u64(&gc->avg_flush_time) / 2);
+        avg_interval = pg_atomic_read_u64(&gc->avg_interval);
+        if (avg_interval == 0 || avg_interval >= (uint64) window)
+            window = 0;
+    }
+    pg_atomic_write_u32(&gc->window, (uint32) window);
+
+    return window;
+}
+
+/*
+ * Account a WAL write and flush done by a group commit leader, that took
+ * elapsed microseconds after waiting delay microseconds for followers.
+ * Leaders hold WALWriteLock, so the flush time average has one writer.
+ */
+static void
+GroupCommitFlushed(long elapsed, int delay)
+{
+    GroupCommitShared *gc = &XLogCtl->groupCommit;
+
+    pg_atomic_fetch_add_u64(&gc->flushes, 1);
+    if (delay > 0)
+    {
+        pg_atomic_fetch_add_u64(&gc->delayed_flushes, 1);
+        pg_atomic_fetch_add_u64(&gc->delay_time, (uint64) delay);
+    }
+    GroupCommitAverage(&gc->avg_flush_time, (uint64) Max(elapsed, 0));
+}
+
+/*
+ * Account the time a flush request waited until its WAL was flushed.
+ */
+static void
+GroupCommitDone(long elapsed)
+{
+    GroupCommitShared *gc = &XLogCtl->groupCommit;
+    uint64        max_time;
+
+    if (elapsed < 0)
+        elapsed = 0;
+
+    pg_atomic_fetch_add_u64(&gc->queue_time, (uint64) elapsed);
+
+    max_time = pg_atomic_read_u64(&gc->max_queue_time);
+    while ((uint64) elapsed > max_time &&
+           !pg_atomic_compare_exchange_u64(&gc->max_queue_time, &max_time,
+                                           (uint64) elapsed))
+        ;
+}
+
+/*
+ * Copy out the group commit statistics.
+ */
+void
+GetGroupCommitStats(GroupCommitStats *stats)
+{
+    GroupCommitShared *gc = &XLogCtl->groupCommit;
+
+    stats->requests = pg_atomic_read_u64(&gc->requests);
+    stats->flushes = pg_atomic_read_u64(&gc->flushes);
+    stats->delayed_flushes = pg_atomic_read_u64(&gc->delayed_flushes);
+    stats->delay_time = pg_atomic_read_u64(&gc->delay_time);
+    stats->queue_time = pg_atomic_read_u64(&gc->queue_time);
+    stats->max_queue_time = pg_atomic_read_u64(&gc->max_queue_time);
+    stats->avg_interval = (double) pg_atomic_read_u64(&gc->avg_interval);
+    stats->avg_flush_time = (double) pg_atomic_read_u64(&gc->avg_flush_time);
+    stats->window = (int) pg_atomic_read_u32(&gc->window);
+    stats->last_arrival = (TimestampTz) pg_atomic_read_u64(&gc->last_arrival);
+    stats->stats_reset = (TimestampTz) pg_atomic_read_u64(&gc->stats_reset);
+}
+
+/*
+ * Reset the group commit counters, keeping the moving averages.
+ */
+void
+ResetGroupCommitStats(void)
+{
+    GroupCommitShared *gc = &XLogCtl->groupCommit;
+
+    pg_atomic_write_u64(&gc->requests, 0);
+    pg_atomic_write_u64(&gc->flushes, 0);
+    pg_atomic_write_u64(&gc->delayed_flushes, 0);
+    pg_atomic_write_u64(&gc->delay_time, 0);
+    pg_atomic_write_u64(&gc->queue_time, 0);
+    pg_atomic_write_u64(&gc->max_queue_time, 0);
+    pg_atomic_write_u64(&gc->stats_reset, (uint64) GetCurrentTimestamp());
+}
+#endif
+
 /*
  * Ensure that all XLOG data through the given position is flushed to disk.
  *
@@ -2889,6 +3106,13 @@ XLogFlush(XLogRecPtr record)
 {// #lizard forgives
     XLogRecPtr    WriteRqstPtr;
     XLogwrtRqst WriteRqst;
+#ifdef __TBASE__
+    TimestampTz queue_start = 0;
+    TimestampTz flush_end = 0;
+    bool        adaptive = enable_adaptive_group_commit;
+    int            window = 0;
+    int            delay = 0;
+#endif
 
     /*
      * During REDO, we are reading not writing WAL.  Therefore, instead of
@@ -2932,6 +3156,14 @@ XLogFlush(XLogRecPtr record)
              (uint32) (LogwrtResult.Flush >> 32), (uint32) LogwrtResult.Flush);
 #endif
 
+#ifdef __TBASE__
+    if (adaptive)
+    {
+        queue_start = GetCurrentTimestamp();
+        window = GroupCommitArrival(queue_start);
+    }
+#endif
+
     START_CRIT_SECTION();
 
     /*
@@ -3003,11 +3235,26 @@ XLogFlush(XLogRecPtr record)
          *
          * We do not sleep if enableFsync is not turned on, nor if there are
          * fewer than CommitSiblings other backends with active transactions.
+         *
+         * With adaptive group commit the delay is the window worked out from
+         * the recent arrival rate of flush requests and flush latency instead.
          */
+#ifdef __TBASE__
+        if (adaptive)
+            delay = window;
+        else if (CommitDelay > 0 && enableFsync &&
+                 MinimumActiveBackends(CommitSiblings))
+            delay = CommitDelay;
+
+        if (delay > 0)
+        {
+            pg_usleep(delay);
+#else
         if (CommitDelay > 0 && enableFsync &&
             MinimumActiveBackends(CommitSiblings))
         {
             pg_usleep(CommitDelay);
+#endif
 
             /*
              * Re-check how far we can now flush the WAL. It's generally not
@@ -3026,6 +3273,17 @@ XLogFlush(XLogRecPtr record)
         WriteRqst.Write = insertpos;
         WriteRqst.Flush = insertpos;
 
+#ifdef __TBASE__
+        if (adaptive)
+        {
+            TimestampTz flush_start = GetCurrentTimestamp();
+
+            XLogWrite(WriteRqst, false);
+            flush_end = GetCurrentTimestamp();
+            GroupCommitFlushed(flush_end - flush_start, delay);
+        }
+        else
+#endif
         XLogWrite(WriteRqst, false);
 
         LWLockRelease(WALWriteLock);
@@ -3035,6 +3293,11 @@ XLogFlush(XLogRecPtr record)
 
     END_CRIT_SECTION();
 
+#ifdef __TBASE__
+    if (adaptive)
+        GroupCommitDone((flush_end ? flush_end : GetCurrentTimestamp()) - queue_start);
+#endif
+
     /* wake up walsenders now that we've released heavily contended locks */
     WalSndWakeupProcessRequests();
 
@@ -5099,6 +5362,9 @@ XLOGShmemInit(void)
     SpinLockInit(&XLogCtl->Insert.insertpos_lck);
     SpinLockInit(&XLogCtl->info_lck);
     SpinLockInit(&XLogCtl->ulsn_lck);
+#ifdef __TBASE__
+    GroupCommitInit(&XLogCtl->groupCommit);
+#endif
     InitSharedLatch(&XLogCtl->recoveryWakeupLatch);
 
     /*
@@ -6055,13 +6321,21 @@ recoveryStopsBefore(XLogReaderState *record)
     } /* end if (XLogRecGetRmid(record) == RM_XACT_ID) */
     else if (XLogRecGetRmid(record) == RM_BARRIER_ID)
     {
-        record_info = XLogRecGetInfo(record);
+        record_info = XLogRecGetInfo(record) & ~XLR_INFO_MASK;
         if (record_info == XLOG_BARRIER_CREATE)
         {
             recordBarrierId = (char *) XLogRecGetData(record);
             ereport(DEBUG2,
                     (errmsg("processing barrier xlog record for %s", recordBarrierId)));
         }
+#ifdef __TBASE__
+        else if (record_info == XLOG_BARRIER_GTS)
+        {
+            recordBarrierId = ((xl_barrier_gts *) XLogRecGetData(record))->barrier_id;
+            ereport(DEBUG2,
+                    (errmsg("processing GTS barrier xlog record for %s", recordBarrierId)));
+        }
+#endif
     }
 #endif
 
@@ -6091,7 +6365,47 @@ recoveryStopsBefore(XLogReaderState *record)
                             "barrier")));
             if (strcmp(recoveryTargetBarrierId, recordBarrierId) == 0)
                 stopsAtThisBarrier = true;
+            stopsHere = stopsAtThisBarrier;
         }
+#ifdef __TBASE__
+        /*
+         * A GTS barrier is only logged once every commit below the barrier
+         * GTS is in this node's WAL, and only used if no commit at or above
+         * it precedes it, see LogBarrierGTS().  Keep replaying and stop
+         * before the first commit at or above the barrier GTS.
+         */
+        else if ((XLogRecGetRmid(record) == RM_BARRIER_ID) &&
+                 (record_info == XLOG_BARRIER_GTS) &&
+                 !GlobalTimestampIsValid(recoveryTargetBarrierGTS) &&
+                 strcmp(recoveryTargetBarrierId, recordBarrierId) == 0)
+        {
+            recoveryTargetBarrierGTS =
+                ((xl_barrier_gts *) XLogRecGetData(record))->barrier_gts;
+            ereport(LOG,
+                    (errmsg("recovery reached barrier %s, stopping before the first commit "
+                            "with global timestamp at or above " INT64_FORMAT,
+                            recoveryTargetBarrierId, recoveryTargetBarrierGTS)));
+            return false;
+        }
+        else if (GlobalTimestampIsValid(recoveryTargetBarrierGTS) &&
+                 XLogRecGetRmid(record) == RM_XACT_ID &&
+                 (xact_info == XLOG_XACT_COMMIT ||
+                  xact_info == XLOG_XACT_COMMIT_PREPARED) &&
+                 xact_gts >= recoveryTargetBarrierGTS)
+        {
+            recoveryStopAfter = false;
+            recoveryStopXid = recordXid;
+            recoveryStopLSN = InvalidXLogRecPtr;
+            recoveryStopName[0] = '\0';
+            if (!getRecordTimestamp(record, &recoveryStopTime))
+                recoveryStopTime = 0;
+            ereport(LOG,
+                    (errmsg("recovery stopping at barrier %s before commit of transaction %u, "
+                            "global timestamp " INT64_FORMAT,
+                            recoveryTargetBarrierId, recoveryStopXid, xact_gts)));
+            return true;
+        }
+#endif
     }
 #endif
 
@@ -6329,6 +6643,29 @@ recoveryStopsAfter(XLogReaderState *record)
     return false;
 }
 
+#ifdef __TBASE__
+/*
+ * Wait for the parallel redo workers to replay all records given to them and
+ * advance lastReplayedEndRecPtr over those records.
+ */
+static void
+XLogParallelRedoSync(void)
+{
+    XLogRecPtr    replayed = ParallelRedoWaitAll();
+
+    if (XLogRecPtrIsInvalid(replayed))
+        return;
+
+    SpinLockAcquire(&XLogCtl->info_lck);
+    if (replayed > XLogCtl->lastReplayedEndRecPtr)
+    {
+        XLogCtl->lastReplayedEndRecPtr = replayed;
+        XLogCtl->lastReplayedTLI = ThisTimeLineID;
+    }
+    SpinLockRelease(&XLogCtl->info_lck);
+}
+#endif
+
 /*
  * Wait until shared recoveryPause flag is cleared.
  *
@@ -7516,6 +7853,9 @@ StartupXLOG(void)
             do
             {
                 bool        switchedTLI = false;
+#ifdef __TBASE__
+                bool        dispatched = false;
+#endif
 
 #ifdef WAL_DEBUG
                 if (XLOG_DEBUG ||
@@ -7553,7 +7893,12 @@ StartupXLOG(void)
                  * adding another spinlock cycle to prevent that.
                  */
                 if (((volatile XLogCtlData *) XLogCtl)->recoveryPause)
+                {
+#ifdef __TBASE__
+                    XLogParallelRedoSync();
+#endif
                     recoveryPausesHere();
+                }
 
                 /*
                  * Have we reached our recovery target?
@@ -7664,6 +8009,15 @@ StartupXLOG(void)
                     RecordKnownAssignedTransactionIds(record->xl_xid);
 
                 /* Now apply the WAL record itself */
+#ifdef __TBASE__
+                /*
+                 * A consistent standby may hand the record to a parallel redo
+                 * worker, which then also reports it as replayed.
+                 */
+                dispatched = StandbyMode && reachedConsistency &&
+                    ParallelRedoDispatch(xlogreader);
+                if (!dispatched)
+#endif
                 RmgrTable[record->xl_rmid].rm_redo(xlogreader);
 
                 /*
@@ -7682,10 +8036,17 @@ StartupXLOG(void)
                  * Update lastReplayedEndRecPtr after this record has been
                  * successfully replayed.
                  */
+#ifdef __TBASE__
+                if (!dispatched)
+                {
+#endif
                 SpinLockAcquire(&XLogCtl->info_lck);
                 XLogCtl->lastReplayedEndRecPtr = EndRecPtr;
                 XLogCtl->lastReplayedTLI = ThisTimeLineID;
                 SpinLockRelease(&XLogCtl->info_lck);
+#ifdef __TBASE__
+                }
+#endif
 
                 /*
                  * If rm_redo called XLogRequestWalReceiverReply, then we wake
@@ -7737,6 +8098,12 @@ StartupXLOG(void)
              * end of main redo apply loop
              */
 
+#ifdef __TBASE__
+            /* Let the parallel redo workers finish before going on. */
+            XLogParallelRedoSync();
+            ParallelRedoShutdown();
+#endif
+
             if (reachedStopPoint)
             {
                 if (!reachedConsistency)
@@ -8245,6 +8612,14 @@ StartupXLOG(void)
      * conditions concerning visibility of other recent updates to shared
      * memory.
      */
+#ifdef __TBASE__
+    /*
+     * No xid is assigned before backends may write WAL; the 2pc this node
+     * started below this one were left by an earlier life of the node.
+     */
+    Clean2pcSetStartupXid(ReadNewTransactionId());
+#endif
+
     LWLockAcquire(ControlFileLock, LW_EXCLUSIVE);
     ControlFile->state = DB_IN_PRODUCTION;
     ControlFile->time = (pg_time_t) time(NULL);
@@ -12297,6 +12672,14 @@ WaitForWALToBecomeAvailable(XLogRecPtr RecPtr, bool randAccess,
     TimestampTz now;
     bool        streaming_reply_sent = false;
 
+#ifdef __TBASE__
+    /*
+     * We may be about to wait for more WAL, so let what the parallel redo
+     * workers replayed become visible first.
+     */
+    XLogParallelRedoSync();
+#endif
+
     /*-------
      * Standby mode is implemented by a state machine:
      *
@@ -92,10 +92,19 @@ static char *hdr_scratch = NULL;
 
 #define SizeOfXlogOrigin    (sizeof(RepOriginId) + sizeof(char))
 
+#ifdef __SUBSCRIPTION__
+#define SizeOfXLogTopXid    (sizeof(TransactionId) + sizeof(char))
+
+/* did the record being assembled include the toplevel xid? */
+static bool curinsert_topxid = false;
+#else
+#define SizeOfXLogTopXid    0
+#endif
+
 #define HEADER_SCRATCH_SIZE \
     (SizeOfXLogRecord + \
      MaxSizeOfXLogRecordBlockHeader * (XLR_MAX_BLOCK_ID + 1) + \
-     SizeOfXLogRecordDataHeaderLong + SizeOfXlogOrigin)
+     SizeOfXLogRecordDataHeaderLong + SizeOfXlogOrigin + SizeOfXLogTopXid)
 
 /*
  * An array of XLogRecData structs, to hold registered data.
@@ -465,6 +474,14 @@ XLogInsert(RmgrId rmid, uint8 info)
         EndPos = XLogInsertRecord(rdt, fpw_lsn, curinsert_flags);
     } while (EndPos == InvalidXLogRecPtr);
 
+#ifdef __SUBSCRIPTION__
+    if (curinsert_topxid)
+    {
+        MarkSubTransactionAssigned();
+        curinsert_topxid = false;
+    }
+#endif
+
     XLogResetInsertion();
 
     return EndPos;
@@ -766,6 +783,19 @@ XLogRecordAssemble(RmgrId rmid, uint8 info,
         scratch += sizeof(replorigin_session_origin);
     }
 
+#ifdef __SUBSCRIPTION__
+    /* followed by the toplevel xid, for the first record of a subxact */
+    curinsert_topxid = IsSubTransactionAssignmentPending();
+    if (curinsert_topxid)
+    {
+        TransactionId topxid = GetTopTransactionIdIfAny();
+
+        *(scratch++) = (char) XLR_BLOCK_ID_TOPLEVEL_XID;
+        memcpy(scratch, &topxid, sizeof(TransactionId));
+        scratch += sizeof(TransactionId);
+    }
+#endif
+
     /* followed by main data, if any */
     if (mainrdata_len > 0)
     {
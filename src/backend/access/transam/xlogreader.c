@@ -1053,6 +1053,9 @@ DecodeXLogRecord(XLogReaderState *state, XLogRecord *record, char **errormsg)
 
     state->decoded_record = record;
     state->record_origin = InvalidRepOriginId;
+#ifdef __SUBSCRIPTION__
+    state->toplevel_xid = InvalidTransactionId;
+#endif
 
     ptr = (char *) record;
     ptr += SizeOfXLogRecord;
@@ -1091,6 +1094,12 @@ DecodeXLogRecord(XLogReaderState *state, XLogRecord *record, char **errormsg)
         {
             COPY_HEADER_FIELD(&state->record_origin, sizeof(RepOriginId));
         }
+#ifdef __SUBSCRIPTION__
+        else if (block_id == XLR_BLOCK_ID_TOPLEVEL_XID)
+        {
+            COPY_HEADER_FIELD(&state->toplevel_xid, sizeof(TransactionId));
+        }
+#endif
         else if (block_id <= XLR_MAX_BLOCK_ID)
         {
             /* XLogRecordBlockHeader */
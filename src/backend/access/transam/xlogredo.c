@@ -0,0 +1,697 @@
+/*
+ * Tencent is pleased to support the open source community by making TBase available.  
+ * 
+ * Copyright (C) 2019 THL A29 Limited, a Tencent company.  All rights reserved.
+ * 
+ * TBase is licensed under the BSD 3-Clause License, except for the third-party component listed below. 
+ * 
+ * A copy of the BSD 3-Clause License is included in this file.
+ * 
+ * Other dependencies and licenses:
+ * 
+ * Open Source Software Licensed Under the PostgreSQL License: 
+ * --------------------------------------------------------------------
+ * 1. Postgres-XL XL9_5_STABLE
+ * Portions Copyright (c) 2015-2016, 2ndQuadrant Ltd
+ * Portions Copyright (c) 2012-2015, TransLattice, Inc.
+ * Portions Copyright (c) 2010-2017, Postgres-XC Development Group
+ * Portions Copyright (c) 1996-2015, The PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, The Regents of the University of California
+ * 
+ * Terms of the PostgreSQL License: 
+ * --------------------------------------------------------------------
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written agreement
+ * is hereby granted, provided that the above copyright notice and this
+ * paragraph and the following two paragraphs appear in all copies.
+ * 
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+ * DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * 
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE UNIVERSITY OF CALIFORNIA HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ * 
+ * 
+ * Terms of the BSD 3-Clause License:
+ * --------------------------------------------------------------------
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of THL A29 Limited nor the names of its contributors may be used to endorse or promote products derived from this software without 
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+ * DAMAGE.
+ * 
+ */
+/*-------------------------------------------------------------------------
+ *
+ * xlogredo.c
+ *      Parallel replay of WAL on standby servers.
+ *
+ * Once a standby is consistent, the startup process can hand WAL records
+ * that modify a single block to parallel_redo_workers redo workers.  The
+ * worker is chosen by hashing the block, so the records of a block are
+ * still replayed in WAL order.  Every other record is a barrier: the
+ * startup process waits until the workers have replayed all they were
+ * given and replays the record itself, which keeps records touching several
+ * blocks, extent map, CLOG, commit timestamp/GTS and all other global
+ * records exactly as in serial replay.
+ *
+ * Commit and abort records only wait for the records of their own
+ * transaction, so a hot standby query never sees a commit before the
+ * changes it covers.  The replay position reported by the startup process
+ * moves over the records given to the workers once they are replayed.
+ *
+ * The workers follow the startup process: they exit when it detaches from
+ * their queues, at the end of recovery or when it exits.
+ *
+ * src/backend/access/transam/xlogredo.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "access/heapam_xlog.h"
+#include "access/nbtxlog.h"
+#include "access/transam.h"
+#include "access/xact.h"
+#include "access/xlog.h"
+#include "access/xlog_internal.h"
+#include "access/xlogredo.h"
+#include "catalog/pg_control.h"
+#include "miscadmin.h"
+#include "pgstat.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/startup.h"
+#include "storage/buf_internals.h"
+#include "storage/dsm.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/proc.h"
+#include "storage/shm_mq.h"
+#include "storage/smgr.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/resowner.h"
+
+/* GUC: number of redo workers, 0 replays serially. */
+int            parallel_redo_workers = 0;
+
+bool        InParallelRedoWorker = false;
+
+/* Size of the queue of each redo worker. */
+#define PARALLEL_REDO_QUEUE_SIZE    (1024 * 1024)
+
+typedef struct ParallelRedoWorkerState
+{
+    pg_atomic_uint64 replayed;    /* end of the last record replayed */
+} ParallelRedoWorkerState;
+
+/*
+ * Head of the segment shared with the redo workers, their queues follow it.
+ * smgr_epoch is advanced whenever a relation file may have been dropped or
+ * truncated, so that the workers close their stale file handles.
+ */
+typedef struct ParallelRedoShared
+{
+    PGPROC       *startup;
+    int            nworkers;
+    pg_atomic_uint32 smgr_epoch;
+    ParallelRedoWorkerState workers[FLEXIBLE_ARRAY_MEMBER];
+} ParallelRedoShared;
+
+#define PARALLEL_REDO_SHARED_SIZE(n) \
+    MAXALIGN(offsetof(ParallelRedoShared, workers) + \
+             (n) * sizeof(ParallelRedoWorkerState))
+
+#define PARALLEL_REDO_QUEUE(shared, i) \
+    ((shm_mq *) ((char *) (shared) + \
+                 PARALLEL_REDO_SHARED_SIZE((shared)->nworkers) + \
+                 (Size) (i) * PARALLEL_REDO_QUEUE_SIZE))
+
+/* Header of a record in a queue, followed by the record itself. */
+typedef struct ParallelRedoRecord
+{
+    XLogRecPtr    ReadRecPtr;
+    XLogRecPtr    EndRecPtr;
+} ParallelRedoRecord;
+
+/* End of the last record of a transaction given to a worker. */
+typedef struct ParallelRedoXact
+{
+    TransactionId xid;
+    XLogRecPtr    end;
+} ParallelRedoXact;
+
+/* State of the startup process */
+static dsm_segment *redo_seg = NULL;
+static ParallelRedoShared *redo_shared = NULL;
+static shm_mq_handle **redo_mqh = NULL;
+static BackgroundWorkerHandle **redo_handles = NULL;
+static XLogRecPtr *redo_dispatched = NULL;    /* per worker */
+static HTAB *redo_xacts = NULL;
+static bool redo_pending = false;
+static XLogRecPtr redo_last_end = InvalidXLogRecPtr;
+static bool redo_disabled = false;
+
+static bool parallel_redo_start(void);
+static int    parallel_redo_worker_for(XLogReaderState *record);
+static void parallel_redo_barrier(XLogReaderState *record);
+static void parallel_redo_wait(XLogRecPtr upto);
+static void parallel_redo_error_callback(void *arg);
+
+/*
+ * Hand a record to a redo worker, if it can be replayed there.  Returns
+ * false if the caller has to replay it; the workers have then replayed
+ * whatever the record depends on.
+ */
+bool
+ParallelRedoDispatch(XLogReaderState *record)
+{
+    ParallelRedoRecord hdr;
+    shm_mq_iovec iov[2];
+    shm_mq_result res;
+    TransactionId xid;
+    int            worker;
+
+    if (parallel_redo_workers <= 0 || redo_disabled)
+        return false;
+
+    worker = parallel_redo_worker_for(record);
+
+    if (redo_shared == NULL)
+    {
+        /* Nothing given to workers yet, so nothing to wait for. */
+        if (worker < 0)
+            return false;
+
+        if (!parallel_redo_start())
+        {
+            redo_disabled = true;
+            return false;
+        }
+    }
+
+    if (worker < 0)
+    {
+        parallel_redo_barrier(record);
+        return false;
+    }
+
+    worker %= redo_shared->nworkers;
+
+    hdr.ReadRecPtr = record->ReadRecPtr;
+    hdr.EndRecPtr = record->EndRecPtr;
+    iov[0].data = (const char *) &hdr;
+    iov[0].len = sizeof(hdr);
+    iov[1].data = (const char *) record->decoded_record;
+    iov[1].len = XLogRecGetTotalLen(record);
+
+    res = shm_mq_sendv(redo_mqh[worker], iov, 2, false);
+    if (res != SHM_MQ_SUCCESS)
+    {
+        HandleStartupProcInterrupts();
+        ereport(FATAL,
+                (errmsg("parallel redo worker %d exited unexpectedly", worker)));
+    }
+
+    redo_dispatched[worker] = record->EndRecPtr;
+    redo_last_end = record->EndRecPtr;
+    redo_pending = true;
+
+    xid = XLogRecGetXid(record);
+    if (TransactionIdIsValid(xid))
+    {
+        ParallelRedoXact *xact;
+
+        xact = (ParallelRedoXact *) hash_search(redo_xacts, &xid,
+                                                HASH_ENTER, NULL);
+        xact->end = record->EndRecPtr;
+    }
+
+    return true;
+}
+
+/*
+ * Wait until the redo workers have replayed every record given to them.
+ * Returns the end of the last such record, or InvalidXLogRecPtr if there
+ * was nothing left to replay.
+ */
+XLogRecPtr
+ParallelRedoWaitAll(void)
+{
+    HASH_SEQ_STATUS status;
+    ParallelRedoXact *xact;
+
+    if (!redo_pending)
+        return InvalidXLogRecPtr;
+
+    parallel_redo_wait(InvalidXLogRecPtr);
+
+    hash_seq_init(&status, redo_xacts);
+    while ((xact = (ParallelRedoXact *) hash_seq_search(&status)) != NULL)
+        hash_search(redo_xacts, &xact->xid, HASH_REMOVE, NULL);
+
+    redo_pending = false;
+
+    return redo_last_end;
+}
+
+/*
+ * Stop the redo workers at the end of recovery, once they have replayed all
+ * records given to them.
+ */
+void
+ParallelRedoShutdown(void)
+{
+    int            i;
+
+    if (redo_shared == NULL)
+        return;
+
+    (void) ParallelRedoWaitAll();
+
+    /* Detaching ends the queues, the workers exit when they see that. */
+    dsm_detach(redo_seg);
+
+    for (i = 0; i < parallel_redo_workers; i++)
+    {
+        if (redo_handles[i] != NULL)
+            (void) WaitForBackgroundWorkerShutdown(redo_handles[i]);
+    }
+
+    redo_seg = NULL;
+    redo_shared = NULL;
+    hash_destroy(redo_xacts);
+    redo_xacts = NULL;
+}
+
+/*
+ * Create the queues and start the redo workers.  Returns false if not even
+ * one worker could be started.
+ */
+static bool
+parallel_redo_start(void)
+{// #lizard forgives
+    int            nworkers = parallel_redo_workers;
+    int            nstarted = 0;
+    HASHCTL        ctl;
+    int            i;
+
+    redo_seg = dsm_create(PARALLEL_REDO_SHARED_SIZE(nworkers) +
+                          (Size) nworkers * PARALLEL_REDO_QUEUE_SIZE,
+                          DSM_CREATE_NULL_IF_MAXSEGMENTS);
+    if (redo_seg == NULL)
+    {
+        ereport(LOG,
+                (errmsg("could not create shared memory for parallel redo, replaying WAL serially")));
+        return false;
+    }
+    dsm_pin_mapping(redo_seg);
+
+    redo_shared = (ParallelRedoShared *) dsm_segment_address(redo_seg);
+    redo_shared->startup = MyProc;
+    redo_shared->nworkers = nworkers;
+    pg_atomic_init_u32(&redo_shared->smgr_epoch, 0);
+
+    if (redo_mqh == NULL)
+    {
+        redo_mqh = (shm_mq_handle **)
+            MemoryContextAllocZero(TopMemoryContext,
+                                   nworkers * sizeof(shm_mq_handle *));
+        redo_handles = (BackgroundWorkerHandle **)
+            MemoryContextAllocZero(TopMemoryContext,
+                                   nworkers * sizeof(BackgroundWorkerHandle *));
+        redo_dispatched = (XLogRecPtr *)
+            MemoryContextAllocZero(TopMemoryContext,
+                                   nworkers * sizeof(XLogRecPtr));
+    }
+
+    for (i = 0; i < nworkers; i++)
+    {
+        BackgroundWorker worker;
+        shm_mq       *mq;
+
+        pg_atomic_init_u64(&redo_shared->workers[i].replayed, 0);
+
+        mq = shm_mq_create(PARALLEL_REDO_QUEUE(redo_shared, i),
+                           PARALLEL_REDO_QUEUE_SIZE);
+        shm_mq_set_sender(mq, MyProc);
+
+        memset(&worker, 0, sizeof(worker));
+        worker.bgw_flags = BGWORKER_SHMEM_ACCESS;
+        worker.bgw_start_time = BgWorkerStart_PostmasterStart;
+        worker.bgw_restart_time = BGW_NEVER_RESTART;
+        snprintf(worker.bgw_library_name, BGW_MAXLEN, "postgres");
+        snprintf(worker.bgw_function_name, BGW_MAXLEN, "ParallelRedoWorkerMain");
+        snprintf(worker.bgw_name, BGW_MAXLEN, "parallel redo worker %d", i);
+        worker.bgw_main_arg = UInt32GetDatum(dsm_segment_handle(redo_seg));
+        memcpy(worker.bgw_extra, &i, sizeof(int));
+        worker.bgw_notify_pid = MyProcPid;
+
+        if (!RegisterDynamicBackgroundWorker(&worker, &redo_handles[i]))
+        {
+            redo_handles[i] = NULL;
+            break;
+        }
+
+        redo_mqh[i] = shm_mq_attach(mq, redo_seg, redo_handles[i]);
+        redo_dispatched[i] = InvalidXLogRecPtr;
+        nstarted++;
+    }
+
+    if (nstarted == 0)
+    {
+        ereport(LOG,
+                (errmsg("could not start parallel redo workers, replaying WAL serially"),
+                 errhint("You might need to increase max_worker_processes.")));
+        dsm_detach(redo_seg);
+        redo_seg = NULL;
+        redo_shared = NULL;
+        return false;
+    }
+
+    /* Workers only look at their own queue, so just use the ones started. */
+    redo_shared->nworkers = nstarted;
+
+    memset(&ctl, 0, sizeof(ctl));
+    ctl.keysize = sizeof(TransactionId);
+    ctl.entrysize = sizeof(ParallelRedoXact);
+    redo_xacts = hash_create("parallel redo transactions", 1024, &ctl,
+                             HASH_ELEM | HASH_BLOBS);
+
+    ereport(LOG,
+            (errmsg("started %d parallel redo workers", nstarted)));
+
+    return true;
+}
+
+/*
+ * Choose the worker a record is replayed by, as a hash of the only block
+ * it modifies.  Returns -1 if the record has to be replayed by the startup
+ * process.
+ */
+static int
+parallel_redo_worker_for(XLogReaderState *record)
+{// #lizard forgives
+    uint8        info = XLogRecGetInfo(record) & ~XLR_INFO_MASK;
+    BufferTag    tag;
+    RelFileNode rnode;
+    ForkNumber    forknum;
+    BlockNumber blkno;
+
+    if (record->max_block_id != 0 ||
+        (XLogRecGetInfo(record) & XLR_CHECK_CONSISTENCY) != 0)
+        return -1;
+
+    switch (XLogRecGetRmid(record))
+    {
+        case RM_HEAP_ID:
+            /* an update moving the tuple to another page has two blocks */
+            break;
+        case RM_HEAP2_ID:
+            if ((info & XLOG_HEAP_OPMASK) != XLOG_HEAP2_MULTI_INSERT &&
+                (info & XLOG_HEAP_OPMASK) != XLOG_HEAP2_LOCK_UPDATED)
+                return -1;
+            break;
+        case RM_BTREE_ID:
+            if (info != XLOG_BTREE_INSERT_LEAF)
+                return -1;
+            break;
+        case RM_XLOG_ID:
+            if (info != XLOG_FPI && info != XLOG_FPI_FOR_HINT)
+                return -1;
+            break;
+        default:
+            return -1;
+    }
+
+    if (!XLogRecGetBlockTag(record, 0, &rnode, &forknum, &blkno))
+        return -1;
+
+    INIT_BUFFERTAG(tag, rnode, forknum, blkno);
+
+    return (int) (hash_any((unsigned char *) &tag, sizeof(tag)) & INT_MAX);
+}
+
+/*
+ * Wait for what a record to be replayed by the startup process depends on.
+ * A commit or abort depends on the records of its transaction, anything
+ * else on all records given to the workers.
+ */
+static void
+parallel_redo_barrier(XLogReaderState *record)
+{// #lizard forgives
+    uint8        rmid = XLogRecGetRmid(record);
+    uint8        info = XLogRecGetInfo(record) & XLOG_XACT_OPMASK;
+    bool        drops_files = false;
+
+    if (rmid == RM_XACT_ID &&
+        (info == XLOG_XACT_COMMIT || info == XLOG_XACT_COMMIT_PREPARED ||
+         info == XLOG_XACT_ABORT || info == XLOG_XACT_ABORT_PREPARED))
+    {
+        TransactionId xid = XLogRecGetXid(record);
+        TransactionId *subxacts;
+        int            nsubxacts;
+        XLogRecPtr    upto = InvalidXLogRecPtr;
+        ParallelRedoXact *xact;
+        int            i;
+
+        if (info == XLOG_XACT_COMMIT || info == XLOG_XACT_COMMIT_PREPARED)
+        {
+            xl_xact_parsed_commit parsed;
+
+            ParseCommitRecord(XLogRecGetInfo(record),
+                              (xl_xact_commit *) XLogRecGetData(record),
+                              &parsed);
+            if (info == XLOG_XACT_COMMIT_PREPARED)
+                xid = parsed.twophase_xid;
+            subxacts = parsed.subxacts;
+            nsubxacts = parsed.nsubxacts;
+            drops_files = (parsed.nrels > 0);
+        }
+        else
+        {
+            xl_xact_parsed_abort parsed;
+
+            ParseAbortRecord(XLogRecGetInfo(record),
+                             (xl_xact_abort *) XLogRecGetData(record),
+                             &parsed);
+            if (info == XLOG_XACT_ABORT_PREPARED)
+                xid = parsed.twophase_xid;
+            subxacts = parsed.subxacts;
+            nsubxacts = parsed.nsubxacts;
+            drops_files = (parsed.nrels > 0);
+        }
+
+        if (!drops_files)
+        {
+            for (i = -1; i < nsubxacts; i++)
+            {
+                TransactionId x = (i < 0) ? xid : subxacts[i];
+                bool        found;
+
+                xact = (ParallelRedoXact *) hash_search(redo_xacts, &x,
+                                                        HASH_FIND, &found);
+                if (!found)
+                    continue;
+                if (xact->end > upto)
+                    upto = xact->end;
+                hash_search(redo_xacts, &x, HASH_REMOVE, NULL);
+            }
+
+            if (!XLogRecPtrIsInvalid(upto))
+                parallel_redo_wait(upto);
+            return;
+        }
+    }
+    else if (rmid == RM_SMGR_ID || rmid == RM_DBASE_ID || rmid == RM_TBLSPC_ID)
+        drops_files = true;
+
+    (void) ParallelRedoWaitAll();
+
+    if (drops_files)
+        pg_atomic_fetch_add_u32(&redo_shared->smgr_epoch, 1);
+}
+
+/*
+ * Wait until each worker has replayed the records given to it up to upto,
+ * or all of them if upto is invalid.
+ */
+static void
+parallel_redo_wait(XLogRecPtr upto)
+{
+    for (;;)
+    {
+        int            i;
+        int            rc;
+        pid_t        pid;
+
+        for (i = 0; i < redo_shared->nworkers; i++)
+        {
+            XLogRecPtr    target = redo_dispatched[i];
+
+            if (!XLogRecPtrIsInvalid(upto) && upto < target)
+                target = upto;
+            if (pg_atomic_read_u64(&redo_shared->workers[i].replayed) < target)
+                break;
+        }
+
+        if (i == redo_shared->nworkers)
+            return;
+
+        if (GetBackgroundWorkerPid(redo_handles[i], &pid) == BGWH_STOPPED)
+            ereport(FATAL,
+                    (errmsg("parallel redo worker %d exited unexpectedly", i)));
+
+        rc = WaitLatch(MyLatch,
+                       WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+                       100L, WAIT_EVENT_PARALLEL_REDO);
+
+        /* Emergency bailout if postmaster has died */
+        if (rc & WL_POSTMASTER_DEATH)
+            proc_exit(1);
+
+        ResetLatch(MyLatch);
+
+        HandleStartupProcInterrupts();
+    }
+}
+
+static void
+parallel_redo_error_callback(void *arg)
+{
+    XLogReaderState *record = (XLogReaderState *) arg;
+
+    errcontext("WAL redo at %X/%X for %s",
+               (uint32) (record->ReadRecPtr >> 32),
+               (uint32) record->ReadRecPtr,
+               RmgrTable[XLogRecGetRmid(record)].rm_name);
+}
+
+/*
+ * Main of a redo worker, which replays the records the startup process
+ * sends it until the startup process detaches.
+ */
+void
+ParallelRedoWorkerMain(Datum main_arg)
+{// #lizard forgives
+    ParallelRedoShared *shared;
+    ParallelRedoWorkerState *state;
+    XLogReaderState *reader;
+    MemoryContext redo_context;
+    dsm_segment *seg;
+    shm_mq       *mq;
+    shm_mq_handle *mqh;
+    uint32        smgr_epoch;
+    int            worker;
+
+    memcpy(&worker, MyBgworkerEntry->bgw_extra, sizeof(int));
+
+    /* We exit when the startup process detaches from our queue. */
+    pqsignal(SIGTERM, SIG_IGN);
+    BackgroundWorkerUnblockSignals();
+
+    CurrentResourceOwner = ResourceOwnerCreate(NULL, "parallel redo");
+
+    seg = dsm_attach(DatumGetUInt32(main_arg));
+    if (seg == NULL)
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("could not map dynamic shared memory segment of parallel redo")));
+    shared = (ParallelRedoShared *) dsm_segment_address(seg);
+    state = &shared->workers[worker];
+
+    mq = PARALLEL_REDO_QUEUE(shared, worker);
+    shm_mq_set_receiver(mq, MyProc);
+    mqh = shm_mq_attach(mq, seg, NULL);
+
+    /* Replay like the startup process of a consistent standby does. */
+    InParallelRedoWorker = true;
+    InRecovery = true;
+    reachedConsistency = true;
+#ifdef __TBASE__
+    i_am_standby = true;
+#endif
+
+    reader = XLogReaderAllocate(NULL, NULL);
+    if (reader == NULL)
+        ereport(ERROR,
+                (errcode(ERRCODE_OUT_OF_MEMORY),
+                 errmsg("out of memory")));
+
+    redo_context = AllocSetContextCreate(TopMemoryContext,
+                                         "parallel redo",
+                                         ALLOCSET_DEFAULT_SIZES);
+    smgr_epoch = pg_atomic_read_u32(&shared->smgr_epoch);
+
+    for (;;)
+    {
+        ErrorContextCallback errcallback;
+        ParallelRedoRecord hdr;
+        MemoryContext oldcontext;
+        shm_mq_result res;
+        Size        nbytes;
+        void       *data;
+        char       *errormsg;
+        uint32        epoch;
+
+        res = shm_mq_receive(mqh, &nbytes, &data, false);
+        if (res != SHM_MQ_SUCCESS)
+            break;
+
+        memcpy(&hdr, data, sizeof(hdr));
+        reader->ReadRecPtr = hdr.ReadRecPtr;
+        reader->EndRecPtr = hdr.EndRecPtr;
+        if (!DecodeXLogRecord(reader,
+                              (XLogRecord *) ((char *) data + sizeof(hdr)),
+                              &errormsg))
+            ereport(PANIC,
+                    (errmsg("could not decode WAL record at %X/%X: %s",
+                            (uint32) (hdr.ReadRecPtr >> 32),
+                            (uint32) hdr.ReadRecPtr, errormsg)));
+
+        /* Some relation file was dropped or truncated, don't keep it open. */
+        epoch = pg_atomic_read_u32(&shared->smgr_epoch);
+        if (epoch != smgr_epoch)
+        {
+            smgrcloseall();
+            smgr_epoch = epoch;
+        }
+
+        errcallback.callback = parallel_redo_error_callback;
+        errcallback.arg = (void *) reader;
+        errcallback.previous = error_context_stack;
+        error_context_stack = &errcallback;
+
+        oldcontext = MemoryContextSwitchTo(redo_context);
+        RmgrTable[XLogRecGetRmid(reader)].rm_redo(reader);
+        MemoryContextSwitchTo(oldcontext);
+        MemoryContextReset(redo_context);
+
+        error_context_stack = errcallback.previous;
+
+        pg_atomic_write_u64(&state->replayed, hdr.EndRecPtr);
+        SetLatch(&shared->startup->procLatch);
+    }
+
+    XLogReaderFree(reader);
+    dsm_detach(seg);
+    proc_exit(0);
+}
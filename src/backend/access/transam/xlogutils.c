@@ -23,6 +23,7 @@
 #include "access/timeline.h"
 #include "access/xlog.h"
 #include "access/xlog_internal.h"
+#include "access/xlogredo.h"
 #include "access/xlogutils.h"
 #include "catalog/catalog.h"
 #include "miscadmin.h"
@@ -442,6 +443,9 @@ XLogReadBufferExtended(RelFileNode rnode, ForkNumber forknum,
     BlockNumber lastblock;
     Buffer        buffer;
     SMgrRelation smgr;
+#ifdef __TBASE__
+    LOCKTAG        tag;
+#endif
 
     Assert(blkno != P_NEW);
 
@@ -479,7 +483,25 @@ XLogReadBufferExtended(RelFileNode rnode, ForkNumber forknum,
         /* OK to extend the file */
         /* we do this in recovery only - no rel-extension lock needed */
         Assert(InRecovery);
+#ifdef __TBASE__
+        /*
+         * ... unless other parallel redo workers may extend the same
+         * relation.  Somebody may have extended it while we waited.
+         */
+        if (InParallelRedoWorker)
+        {
+            SET_LOCKTAG_RELATION_EXTEND(tag, rnode.dbNode, rnode.relNode);
+            (void) LockAcquire(&tag, ExclusiveLock, false, false);
+            lastblock = smgrnblocks(smgr, forknum);
+        }
+#endif
         buffer = InvalidBuffer;
+#ifdef __TBASE__
+        if (blkno < lastblock)
+            buffer = ReadBufferWithoutRelcache(rnode, forknum, blkno,
+                                               mode, NULL);
+        else
+#endif
         do
         {
             if (buffer != InvalidBuffer)
@@ -501,6 +523,10 @@ XLogReadBufferExtended(RelFileNode rnode, ForkNumber forknum,
             buffer = ReadBufferWithoutRelcache(rnode, forknum, blkno,
                                                mode, NULL);
         }
+#ifdef __TBASE__
+        if (InParallelRedoWorker)
+            LockRelease(&tag, ExclusiveLock, false);
+#endif
     }
 
     if (mode == RBM_NORMAL)
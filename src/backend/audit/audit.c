@@ -499,6 +499,11 @@ static void audit_hit_rebuild_hit_info(AuditHitInfo * hit_info,
 static void audit_hit_match_in_catalog(AuditHitInfo * audit_hit,
                                        bool is_success);
 static void audit_hit_print_result_log(void);
+static void audit_hit_print_result_record(AuditResultInfo * audit_ret,
+                                          AuditHitInfo * audit_hit,
+                                          AuditStmtMap * hit_aciton,
+                                          char * hit_audit,
+                                          char * exec_status);
 static void audit_hit_process_result_info(bool is_success);
 
 #endif
@@ -8824,18 +8829,23 @@ static void audit_hit_print_result_log(void)
     char end_time[128] = { 0 };
 
     bool ignore_others = false;
+    bool binary_records = AuditLog_binary_records;
 
-    pg_strftime(start_time, sizeof(start_time),
-                "%Y-%m-%d %H:%M:%S %Z",
-                pg_localtime(&(audit_ret->proc_start_time), log_timezone));
+    /* binary records carry raw times, audit logger formats them */
+    if (!binary_records)
+    {
+        pg_strftime(start_time, sizeof(start_time),
+                    "%Y-%m-%d %H:%M:%S %Z",
+                    pg_localtime(&(audit_ret->proc_start_time), log_timezone));
 
-    pg_strftime(begin_time, sizeof(begin_time),
-                "%Y-%m-%d %H:%M:%S %Z",
-                pg_localtime(&(audit_ret->qry_begin_time), log_timezone));
+        pg_strftime(begin_time, sizeof(begin_time),
+                    "%Y-%m-%d %H:%M:%S %Z",
+                    pg_localtime(&(audit_ret->qry_begin_time), log_timezone));
 
-    pg_strftime(end_time, sizeof(end_time),
-                "%Y-%m-%d %H:%M:%S %Z",
-                pg_localtime(&(audit_ret->qry_end_time), log_timezone));
+        pg_strftime(end_time, sizeof(end_time),
+                    "%Y-%m-%d %H:%M:%S %Z",
+                    pg_localtime(&(audit_ret->qry_end_time), log_timezone));
+    }
 
     foreach(l, audit_ret->l_hit_info)
     {
@@ -8878,6 +8888,13 @@ static void audit_hit_print_result_log(void)
                 }
             }
 
+            if (binary_records)
+            {
+                audit_hit_print_result_record(audit_ret, audit_hit, hit_aciton,
+                                              hit_audit, exec_status);
+                continue;
+            }
+
             audit_log(
                 "AuditOutMessage: "
                 "AuditType: \"%s\", "                        // audit type
@@ -8949,6 +8966,58 @@ static void audit_hit_print_result_log(void)
     }
 }
 
+/*
+ * Same as the audit_log() in audit_hit_print_result_log, but only copies
+ * the fields into a binary record, audit logger formats it into the same
+ * text later.
+ */
+static void audit_hit_print_result_record(AuditResultInfo * audit_ret,
+                                          AuditHitInfo * audit_hit,
+                                          AuditStmtMap * hit_aciton,
+                                          char * hit_audit,
+                                          char * exec_status)
+{
+    AuditRecordData rec;
+    const char * str[AREC_NSTRINGS];
+
+    MemSet(&rec, 0, sizeof(AuditRecordData));
+
+    rec.db_id = audit_ret->db_id;
+    rec.db_user_id = audit_ret->db_user_id;
+    rec.node_oid = audit_ret->node_oid;
+    rec.node_port = audit_ret->node_port;
+    rec.proc_pid = audit_ret->proc_pid;
+    rec.proc_ppid = audit_ret->proc_ppid;
+    rec.is_success = audit_ret->is_success;
+    rec.obj_class_id = audit_hit->obj_addr.classId;
+    rec.obj_id = audit_hit->obj_addr.objectId;
+    rec.obj_sub_id = audit_hit->obj_addr.objectSubId;
+    rec.action_id = hit_aciton->id;
+    rec.proc_start_time = audit_ret->proc_start_time;
+    rec.qry_begin_time = audit_ret->qry_begin_time;
+    rec.qry_end_time = audit_ret->qry_end_time;
+
+    str[AREC_AUDIT_TYPE] = hit_audit;
+    str[AREC_QUERY_STRING] = audit_ret->qry_string;
+    str[AREC_COMMAND_TAG] = audit_ret->cmd_tag;
+    str[AREC_DB_NAME] = audit_ret->db_name;
+    str[AREC_DB_USER_NAME] = audit_ret->db_user_name;
+    str[AREC_NODE_NAME] = audit_ret->node_name;
+    str[AREC_NODE_TYPE] = PGXCNodeTypeString(audit_ret->node_type);
+    str[AREC_NODE_HOST] = audit_ret->node_host;
+    str[AREC_NODE_OSUSER] = audit_ret->node_osuser;
+    str[AREC_CLIENT_HOST] = audit_ret->client_host;
+    str[AREC_CLIENT_HOSTNAME] = audit_ret->client_hostname;
+    str[AREC_CLIENT_PORT] = audit_ret->client_port;
+    str[AREC_APP_NAME] = audit_ret->app_name;
+    str[AREC_OBJECT_TYPE] = audit_object_type_string(audit_hit->obj_type, false);
+    str[AREC_OBJECT_NAME] = audit_hit->obj_name;
+    str[AREC_ACTION_NAME] = hit_aciton->name;
+    str[AREC_EXEC_STATUS] = exec_status;
+
+    alog_record(&rec, str);
+}
+
 static void audit_hit_process_result_info(bool is_success)
 {
     ListCell * l = NULL;
@@ -113,6 +113,14 @@
 #include "pgstat.h"
 #include "catalog/pg_authid.h"
 
+#include "executor/executor.h"
+#include "nodes/makefuncs.h"
+#include "optimizer/clauses.h"
+#include "utils/catcache.h"
+#include "utils/hsearch.h"
+#include "utils/inval.h"
+#include "utils/memutils.h"
+
 
 #ifdef _PG_REGRESS_
 bool enable_fga    = true;
@@ -130,6 +138,46 @@ bool enable_fga    = false;
 static char formatted_start_time[FORMATTED_TS_LEN];
 static char formatted_log_time[FORMATTED_TS_LEN];
 
+/*
+ * Statement types a policy may apply to, see statement_types of
+ * pg_audit_fga_conf.
+ */
+#define AUDIT_FGA_CMD_SELECT    0
+#define AUDIT_FGA_CMD_INSERT    1
+#define AUDIT_FGA_CMD_UPDATE    2
+#define AUDIT_FGA_CMD_DELETE    3
+#define AUDIT_FGA_NUM_CMDS      4
+
+static const char *audit_fga_cmd_names[AUDIT_FGA_NUM_CMDS] =
+{
+    "select", "insert", "update", "delete"
+};
+
+/*
+ * An enabled policy of pg_audit_fga_conf, with its audit condition already
+ * read back from its node tree.
+ */
+typedef struct AuditFgaCachedPolicy
+{
+    char       *policy_name;
+    oidvector  *audit_column_oids;    /* NULL means all columns */
+    bool        audit_column_opts;
+    List       *qual;                /* implicitly-ANDed condition, or NIL */
+} AuditFgaCachedPolicy;
+
+/*
+ * Enabled policies of a relation, by statement type. Relations without
+ * policies get an entry too, so that they cost no catalog scan either.
+ */
+typedef struct AuditFgaRelCacheEntry
+{
+    Oid             relid;            /* hash key, must be first */
+    MemoryContext   context;        /* holds the policies, NULL if none */
+    List           *policies[AUDIT_FGA_NUM_CMDS];    /* AuditFgaCachedPolicy */
+} AuditFgaRelCacheEntry;
+
+static HTAB *audit_fga_rel_cache = NULL;
+
 
 /*
  * Flags set by interrupt handlers for later service in the main loop.
@@ -158,6 +206,13 @@ static void worker_audit_fga_wakeup(SIGNAL_ARGS);
 static void process_fga_trigger(bool timeout);
 static void reset_shem_info(int);
 static bool is_single_cmd(char * cmd);
+static int  audit_fga_cmd_index(char *cmd_type);
+static void audit_fga_rel_cache_init(void);
+static void audit_fga_rel_cache_callback(Datum arg, Oid relid);
+static void audit_fga_rel_cache_remove(AuditFgaRelCacheEntry *entry);
+static void audit_fga_rel_cache_invalidate(Oid relid);
+static AuditFgaRelCacheEntry *audit_fga_rel_cache_lookup(Oid rel);
+static void audit_fga_build_any_qual(PlanState *ps);
 
 
 
@@ -1128,6 +1183,9 @@ add_policy(PG_FUNCTION_ARGS)
 
     heap_close(rel, RowExclusiveLock);
 
+    /* cached policies and plans of the relation are out of date */
+    CacheInvalidateRelcacheByRelid(DatumGetObjectId(values[Anum_audit_fga_conf_object_id - 1]));
+
     exec_policy_funct_on_other_node(sql_cmd);
 
     PG_RETURN_BOOL(true);
@@ -1184,6 +1242,7 @@ drop_policy(PG_FUNCTION_ARGS)
         elog(ERROR,"policy[%s] is not exist", policy_name);
 
     simple_heap_delete(rel, &tup->t_self);
+    audit_fga_rel_cache_invalidate(((Form_audit_fga_conf) GETSTRUCT(tup))->object_id);
     ReleaseSysCache(tup);
     heap_close(rel, RowExclusiveLock);
 
@@ -1258,6 +1317,7 @@ enable_policy(PG_FUNCTION_ARGS)
                                  nulls, replaces);
 
     CatalogTupleUpdate(rel, &new_tup->t_self, new_tup);
+    audit_fga_rel_cache_invalidate(((Form_audit_fga_conf) GETSTRUCT(tup))->object_id);
 
     ReleaseSysCache(tup);
     
@@ -1349,6 +1409,7 @@ disable_policy(PG_FUNCTION_ARGS)
                                  nulls, replaces);
 
     CatalogTupleUpdate(rel, &new_tup->t_self, new_tup);
+    audit_fga_rel_cache_invalidate(((Form_audit_fga_conf) GETSTRUCT(tup))->object_id);
 
     ReleaseSysCache(tup);
     
@@ -1411,6 +1472,8 @@ enable_all_policy(PG_FUNCTION_ARGS)
     
     heap_close(rel, RowExclusiveLock);
 
+    CacheInvalidateRelcacheAll();
+
     exec_policy_funct_on_other_node(sql_cmd);
 
     PG_RETURN_BOOL(true);
@@ -1468,6 +1531,8 @@ disable_all_policy(PG_FUNCTION_ARGS)
 
     heap_close(rel, RowExclusiveLock);
 
+    CacheInvalidateRelcacheAll();
+
     exec_policy_funct_on_other_node(sql_cmd);
 
     PG_RETURN_BOOL(true);
@@ -1509,6 +1574,8 @@ drop_all_policy(PG_FUNCTION_ARGS)
 
     heap_close(rel, RowExclusiveLock);
 
+    CacheInvalidateRelcacheAll();
+
     exec_policy_funct_on_other_node(sql_cmd);
 
     PG_RETURN_BOOL(true);
@@ -1596,19 +1663,122 @@ has_policy_matched_columns(List * tlist, oidvector *audit_column_oids, bool audi
 }
 
 
-bool  
-get_audit_fga_quals(Oid rel, char * cmd_type, List *tlist, List **audit_fga_policy_list)
+/*
+ * Map the command type the planner passes to get_audit_fga_quals() to its
+ * statement type, -1 for others.
+ */
+static int
+audit_fga_cmd_index(char *cmd_type)
+{
+    int         i;
+
+    for (i = 0; i < AUDIT_FGA_NUM_CMDS; i++)
+    {
+        if (pg_strcasecmp(cmd_type, audit_fga_cmd_names[i]) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+static void
+audit_fga_rel_cache_init(void)
+{
+    HASHCTL     ctl;
+
+    if (CacheMemoryContext == NULL)
+        CreateCacheMemoryContext();
+
+    MemSet(&ctl, 0, sizeof(ctl));
+    ctl.keysize = sizeof(Oid);
+    ctl.entrysize = sizeof(AuditFgaRelCacheEntry);
+    ctl.hcxt = CacheMemoryContext;
+
+    audit_fga_rel_cache = hash_create("Audit FGA policy cache", 64, &ctl,
+                                      HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+
+    CacheRegisterRelcacheCallback(audit_fga_rel_cache_callback, (Datum) 0);
+}
+
+static void
+audit_fga_rel_cache_remove(AuditFgaRelCacheEntry *entry)
+{
+    if (entry->context != NULL)
+        MemoryContextDelete(entry->context);
+
+    hash_search(audit_fga_rel_cache, &entry->relid, HASH_REMOVE, NULL);
+}
+
+/*
+ * Invalidate the cached policies of a relation. Policies of a dropped
+ * relation stay in pg_audit_fga_conf, and the relcache cannot name it any
+ * more, so invalidate everything to still let them be dropped or changed.
+ */
+static void
+audit_fga_rel_cache_invalidate(Oid relid)
+{
+    if (SearchSysCacheExists1(RELOID, ObjectIdGetDatum(relid)))
+        CacheInvalidateRelcacheByRelid(relid);
+    else
+        CacheInvalidateRelcacheAll();
+}
+
+/*
+ * Relcache invalidation callback. Policy changes invalidate the relcache
+ * entry of their relation, so do DDL on it.
+ */
+static void
+audit_fga_rel_cache_callback(Datum arg, Oid relid)
+{
+    AuditFgaRelCacheEntry *entry;
+
+    if (audit_fga_rel_cache == NULL)
+        return;
+
+    if (OidIsValid(relid))
+    {
+        entry = (AuditFgaRelCacheEntry *) hash_search(audit_fga_rel_cache,
+                                                      &relid, HASH_FIND, NULL);
+        if (entry != NULL)
+            audit_fga_rel_cache_remove(entry);
+    }
+    else
+    {
+        HASH_SEQ_STATUS status;
+
+        hash_seq_init(&status, audit_fga_rel_cache);
+        while ((entry = (AuditFgaRelCacheEntry *) hash_seq_search(&status)) != NULL)
+            audit_fga_rel_cache_remove(entry);
+    }
+}
+
+/*
+ * Return the enabled policies of a relation, reading them from
+ * pg_audit_fga_conf only the first time.
+ */
+static AuditFgaRelCacheEntry *
+audit_fga_rel_cache_lookup(Oid rel)
 {// #lizard forgives
+    AuditFgaRelCacheEntry *entry;
+    MemoryContext policy_context = NULL;
+    MemoryContext oldcontext;
+    List       *policies[AUDIT_FGA_NUM_CMDS];
     Relation    audit_fga_rel;
     ScanKeyData skey[3];
     SysScanDesc sscan;
     HeapTuple    policy_tuple;
-    
-    AuditFgaPolicy * audit_fga_policy_item;
-    Expr *      qual_expr = NULL;
+    bool        found;
+    int         i;
 
-    bool        need_audit_fga_quals = false;
-    int         nfga = 0;
+    if (audit_fga_rel_cache == NULL)
+        audit_fga_rel_cache_init();
+
+    entry = (AuditFgaRelCacheEntry *) hash_search(audit_fga_rel_cache,
+                                                  &rel, HASH_FIND, NULL);
+    if (entry != NULL)
+        return entry;
+
+    MemSet(policies, 0, sizeof(policies));
 
     audit_fga_rel = heap_open(PgAuditFgaConfRelationId, AccessShareLock);
 
@@ -1644,8 +1814,6 @@ get_audit_fga_quals(Oid rel, char * cmd_type, List *tlist, List **audit_fga_poli
 
         Datum        qual_datum;
         Datum       policy_name_datum;
-        char        *qual_value;
-        char        *policy_name;
         bool        qual_is_null;
         bool        policy_name_is_null;
 
@@ -1653,10 +1821,9 @@ get_audit_fga_quals(Oid rel, char * cmd_type, List *tlist, List **audit_fga_poli
         Datum        column_opts_datum;
         bool        column_is_null;
         bool        column_opts_is_null;
-        oidvector   *audit_column_oids = NULL;
-        bool        audit_column_opts = true;
-        
-        /* get audit_columns  */
+        char        *statement_types = NULL;
+        AuditFgaCachedPolicy *policy;
+
         statement_types_datum = heap_getattr(policy_tuple, Anum_audit_fga_conf_statement_types,
                             RelationGetDescr(audit_fga_rel), &isNull);
 
@@ -1670,61 +1837,197 @@ get_audit_fga_quals(Oid rel, char * cmd_type, List *tlist, List **audit_fga_poli
         
         policy_name_datum = heap_getattr(policy_tuple, Anum_audit_fga_conf_policy_name,
                             RelationGetDescr(audit_fga_rel), &policy_name_is_null);
-                   
-        /*  check command type */
-        need_audit_fga_quals = has_policy_matched_cmd(cmd_type, statement_types_datum, isNull);
+
+        /* no statement types means select only */
+        if (!isNull)
+            statement_types = lowerstr(NameStr(*DatumGetName(statement_types_datum)));
+
+        if (policy_context == NULL)
+            policy_context = AllocSetContextCreate(CacheMemoryContext,
+                                                   "Audit FGA policies",
+                                                   ALLOCSET_SMALL_SIZES);
+
+        oldcontext = MemoryContextSwitchTo(policy_context);
+
+        policy = (AuditFgaCachedPolicy *) palloc0(sizeof(AuditFgaCachedPolicy));
+        policy->policy_name = pstrdup(NameStr(*DatumGetName(policy_name_datum)));
+        policy->audit_column_opts = true;
 
         if (!column_is_null)
-            audit_column_oids = (oidvector *) DatumGetPointer(column_datum);
+        {
+            oidvector *audit_column_oids = (oidvector *) DatumGetPointer(column_datum);
+
+            policy->audit_column_oids = (oidvector *) palloc(VARSIZE(audit_column_oids));
+            memcpy(policy->audit_column_oids, audit_column_oids, VARSIZE(audit_column_oids));
+        }
 
         if (!column_opts_is_null)   
-            audit_column_opts = DatumGetBool(column_opts_datum);
-        
-        /*  check column list */
-        if (need_audit_fga_quals)
+            policy->audit_column_opts = DatumGetBool(column_opts_datum);
+
+        if (!qual_is_null)
         {
-            need_audit_fga_quals = has_policy_matched_columns(tlist, audit_column_oids, audit_column_opts);    
+            char       *qual_value = TextDatumGetCString(qual_datum);
+
+            policy->qual = list_make1(stringToNode(qual_value));
         }
-        else
-            continue;
 
-        if (need_audit_fga_quals)
-            nfga++;
-        else
+        for (i = 0; i < AUDIT_FGA_NUM_CMDS; i++)
+        {
+            if ((statement_types == NULL && i == AUDIT_FGA_CMD_SELECT) ||
+                (statement_types != NULL && strstr(statement_types, audit_fga_cmd_names[i])))
+                policies[i] = lappend(policies[i], policy);
+        }
+
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    systable_endscan(sscan);
+    heap_close(audit_fga_rel, AccessShareLock);
+
+    entry = (AuditFgaRelCacheEntry *) hash_search(audit_fga_rel_cache,
+                                                  &rel, HASH_ENTER, &found);
+    if (found && entry->context != NULL)
+        MemoryContextDelete(entry->context);
+
+    entry->context = policy_context;
+    memcpy(entry->policies, policies, sizeof(policies));
+
+    return entry;
+}
+
+bool  
+get_audit_fga_quals(Oid rel, char * cmd_type, List *tlist, List **audit_fga_policy_list)
+{
+    AuditFgaRelCacheEntry *entry;
+    ListCell   *lc;
+    int         cmd;
+    int         nfga = 0;
+
+    cmd = audit_fga_cmd_index(cmd_type);
+    if (cmd < 0)
+        return false;
+
+    entry = audit_fga_rel_cache_lookup(rel);
+
+    foreach(lc, entry->policies[cmd])
+    {
+        AuditFgaCachedPolicy *policy = (AuditFgaCachedPolicy *) lfirst(lc);
+        AuditFgaPolicy * audit_fga_policy_item;
+
+        /*  check column list */
+        if (!has_policy_matched_columns(tlist, policy->audit_column_oids,
+                                        policy->audit_column_opts))
             continue;
 
-        /*  check audit condition expr */
-        policy_name = DatumGetCString(policy_name_datum);
+        nfga++;
 
         audit_fga_policy_item = makeNode(AuditFgaPolicy);
-        audit_fga_policy_item->policy_name = pstrdup(policy_name);
+        audit_fga_policy_item->policy_name = pstrdup(policy->policy_name);
         audit_fga_policy_item->query_string = pstrdup(debug_query_string);
-        
-        if (qual_datum)
-        {
-            qual_value = TextDatumGetCString(qual_datum);
-            qual_expr = copyObject((Expr *) stringToNode(qual_value));
-            
-            audit_fga_policy_item->qual = 
-                lappend(audit_fga_policy_item->qual, (Node *) qual_expr);
+        audit_fga_policy_item->qual = copyObject(policy->qual);
 
+        *audit_fga_policy_list = lappend(*audit_fga_policy_list, audit_fga_policy_item);
+    }
+
+    if (nfga > 0)
+        return true;
+    else
+        return false;
+}
 
-            *audit_fga_policy_list = lappend(*audit_fga_policy_list, audit_fga_policy_item);
+/*
+ * Set up the audit conditions of a plan node for execution. With several
+ * policies, the conditions are also ORed into one expression, so that rows
+ * matching none of them are rejected by one evaluation.
+ */
+void
+audit_fga_init_plan_quals(PlanState *ps, List *audit_fga_quals)
+{
+    ListCell   *item;
+
+    foreach (item, audit_fga_quals)
+    {
+        AuditFgaPolicy *audit_fga_qual = (AuditFgaPolicy *) lfirst(item);
+        audit_fga_policy_state * audit_fga_policy_state_item
+                = palloc0(sizeof(audit_fga_policy_state));
+
+        audit_fga_policy_state_item->policy_name = audit_fga_qual->policy_name;
+        audit_fga_policy_state_item->query_string = audit_fga_qual->query_string;
+        audit_fga_policy_state_item->qual_expr = audit_fga_qual->qual;
+        audit_fga_policy_state_item->qual = 
+            ExecInitQual(audit_fga_qual->qual, ps);
+
+        ps->audit_fga_qual = lappend(ps->audit_fga_qual, audit_fga_policy_state_item);
+    }
+
+    audit_fga_build_any_qual(ps);
+}
+
+static void
+audit_fga_build_any_qual(PlanState *ps)
+{
+    List       *args = NIL;
+    ListCell   *item;
+
+    ps->audit_fga_any_qual = NULL;
+
+    /* a single policy is checked by its own condition */
+    if (list_length(ps->audit_fga_qual) < 2)
+        return;
+
+    foreach (item, ps->audit_fga_qual)
+    {
+        audit_fga_policy_state *audit_fga_qual = (audit_fga_policy_state *) lfirst(item);
+
+        args = lappend(args, make_ands_explicit(audit_fga_qual->qual_expr));
+    }
+
+    ps->audit_fga_any_qual = ExecInitQual(list_make1(make_orclause(args)), ps);
+}
+
+/*
+ * Check the current row of econtext against the audit conditions of a plan
+ * node. A policy is logged once per statement, on its first matching row,
+ * and is not checked any more.
+ */
+void
+audit_fga_exec_plan_quals(PlanState *ps, ExprContext *econtext, char *cmd_type)
+{
+    ListCell   *item;
+    ListCell   *next;
+    ListCell   *prev = NULL;
+    bool        matched = false;
+
+    if (ps->audit_fga_any_qual != NULL &&
+        !ExecQual(ps->audit_fga_any_qual, econtext))
+        return;
+
+    for (item = list_head(ps->audit_fga_qual); item != NULL; item = next)
+    {
+        audit_fga_policy_state *audit_fga_qual = (audit_fga_policy_state *) lfirst(item);
+
+        next = lnext(item);
+
+        if (ExecQual(audit_fga_qual->qual, econtext))
+        {
+            audit_fga_log_policy_info_2(audit_fga_qual, cmd_type);
+
+            ps->audit_fga_qual = list_delete_cell(ps->audit_fga_qual, item, prev);
+            matched = true;
         }
         else
         {
-            audit_fga_policy_item->qual = NULL;
-            *audit_fga_policy_list = lappend(*audit_fga_policy_list, audit_fga_policy_item);
+            prev = item;
         }
     }
 
-    systable_endscan(sscan);
-    heap_close(audit_fga_rel, AccessShareLock);
+    if (matched)
+    {
+        MemoryContext oldcontext = MemoryContextSwitchTo(ps->state->es_query_cxt);
 
-    if (nfga > 0)
-        return true;
-    else
-        return false;
+        audit_fga_build_any_qual(ps);
+        MemoryContextSwitchTo(oldcontext);
+    }
 }
 
 
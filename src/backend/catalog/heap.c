@@ -33,6 +33,7 @@
 #include "access/htup_details.h"
 #include "access/multixact.h"
 #include "access/sysattr.h"
+#include "access/reloptions.h"
 #include "access/transam.h"
 #include "access/xact.h"
 #include "access/xlog.h"
@@ -2186,6 +2187,20 @@ heap_create_with_catalog(const char *relname,
     Assert(relid == RelationGetRelid(new_rel_desc));
 #ifdef _SHARDING_
     new_rel_desc->rd_rel->relhasextent = (relid >= FirstNormalObjectId && hasextent);
+#endif
+#ifdef __TBASE__
+    /* page compressed storage is requested by reloption */
+    if (relkind == RELKIND_RELATION && reloptions != (Datum) 0 &&
+        new_rel_desc->rd_smgr != NULL)
+    {
+        StdRdOptions *options;
+
+        options = (StdRdOptions *) heap_reloptions(relkind, reloptions, false);
+        if (options && options->page_compress)
+            RelationCreatePageCompressFork(new_rel_desc->rd_node, relpersistence);
+        if (options)
+            pfree(options);
+    }
 #endif
     /*
      * Decide whether to create an array type over the relation's rowtype. We
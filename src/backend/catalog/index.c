@@ -80,6 +80,11 @@
 #include "utils/mls.h"
 #include "utils/relcryptcache.h"
 #endif
+#ifdef __TBASE__
+#include "access/parallel.h"
+#include "commands/progress.h"
+#include "pgstat.h"
+#endif
 
 /* Potentially set by pg_upgrade_support functions */
 Oid            binary_upgrade_next_index_pg_class_oid = InvalidOid;
@@ -122,6 +127,19 @@ static void index_update_stats(Relation rel,
 static void IndexCheckExclusion(Relation heapRelation,
                     Relation indexRelation,
                     IndexInfo *indexInfo);
+static double IndexBuildHeapRangeScanInternal(Relation heapRelation,
+                                Relation indexRelation,
+                                IndexInfo *indexInfo,
+                                bool allow_sync,
+                                bool anyvisible,
+                                BlockNumber start_blockno,
+                                BlockNumber numblocks,
+                                ParallelHeapScanDesc pscan,
+                                IndexBuildCallback callback,
+                                void *callback_state);
+#ifdef __TBASE__
+static void index_build_progress_start(Oid heapId, Oid indexId, int64 phase);
+#endif
 static inline int64 itemptr_encode(ItemPointer itemptr);
 static inline void itemptr_decode(ItemPointer itemptr, int64 encoded);
 static bool validate_index_callback(ItemPointer itemptr, void *opaque);
@@ -2284,6 +2302,12 @@ index_build(Relation heapRelation,
                     RelationGetRelationName(indexRelation),
                     RelationGetRelationName(heapRelation))));
 
+#ifdef __TBASE__
+    index_build_progress_start(RelationGetRelid(heapRelation),
+                               RelationGetRelid(indexRelation),
+                               PROGRESS_CREATEIDX_PHASE_SCAN_HEAP);
+#endif
+
 #ifdef _MLS_
     /* index will build immediately, so check crypt policy asap */
     rel_crypt_index_check_policy(heapRelation->rd_id, indexRelation);
@@ -2407,7 +2431,32 @@ index_build(Relation heapRelation,
 
     /* Restore userid and security context */
     SetUserIdAndSecContext(save_userid, save_sec_context);
+
+#ifdef __TBASE__
+    pgstat_progress_end_command();
+#endif
+}
+
+#ifdef __TBASE__
+/*
+ * index_build_progress_start - advertise an index build in
+ * pg_stat_progress_create_index
+ */
+static void
+index_build_progress_start(Oid heapId, Oid indexId, int64 phase)
+{
+    const int    index[] = {
+        PROGRESS_CREATEIDX_PHASE,
+        PROGRESS_CREATEIDX_INDEX_OID
+    };
+    int64        val[2];
+
+    pgstat_progress_start_command(PROGRESS_COMMAND_CREATE_INDEX, heapId);
+    val[0] = phase;
+    val[1] = indexId;
+    pgstat_progress_update_multi_param(2, index, val);
 }
+#endif
 
 
 /*
@@ -2468,6 +2517,48 @@ IndexBuildHeapRangeScan(Relation heapRelation,
                         BlockNumber numblocks,
                         IndexBuildCallback callback,
                         void *callback_state)
+{
+    return IndexBuildHeapRangeScanInternal(heapRelation, indexRelation,
+                                           indexInfo, allow_sync, anyvisible,
+                                           start_blockno, numblocks, NULL,
+                                           callback, callback_state);
+}
+
+#ifdef __TBASE__
+/*
+ * IndexBuildHeapParallelScan - take part in a parallel index build
+ *
+ * Like IndexBuildHeapScan, but the blocks of the heap are handed out by the
+ * given parallel heap scan, which the leader set up with SnapshotAny.  Each
+ * participant only sees the tuples of the blocks it was given, and returns
+ * the number of heap tuples it saw.  Concurrent builds are not supported.
+ */
+double
+IndexBuildHeapParallelScan(Relation heapRelation,
+                           Relation indexRelation,
+                           IndexInfo *indexInfo,
+                           ParallelHeapScanDesc pscan,
+                           IndexBuildCallback callback,
+                           void *callback_state)
+{
+    return IndexBuildHeapRangeScanInternal(heapRelation, indexRelation,
+                                           indexInfo, true, false,
+                                           0, InvalidBlockNumber, pscan,
+                                           callback, callback_state);
+}
+#endif
+
+static double
+IndexBuildHeapRangeScanInternal(Relation heapRelation,
+                                Relation indexRelation,
+                                IndexInfo *indexInfo,
+                                bool allow_sync,
+                                bool anyvisible,
+                                BlockNumber start_blockno,
+                                BlockNumber numblocks,
+                                ParallelHeapScanDesc pscan,
+                                IndexBuildCallback callback,
+                                void *callback_state)
 {// #lizard forgives
     bool        is_system_catalog;
     bool        checking_uniqueness;
@@ -2485,6 +2576,10 @@ IndexBuildHeapRangeScan(Relation heapRelation,
     BlockNumber root_blkno = InvalidBlockNumber;
     OffsetNumber root_offsets[MaxHeapTuplesPerPage];
     ScanState * node = NULL;
+#ifdef __TBASE__
+    bool        report_progress;
+    BlockNumber blocks_done = 0;
+#endif
     /*
      * sanity checks
      */
@@ -2524,6 +2619,11 @@ IndexBuildHeapRangeScan(Relation heapRelation,
      * concurrent build, or during bootstrap, we take a regular MVCC snapshot
      * and index whatever's live according to that.
      */
+#ifdef __TBASE__
+    /* parallel builds are only set up for the SnapshotAny case */
+    Assert(pscan == NULL ||
+           (!IsBootstrapProcessingMode() && !indexInfo->ii_Concurrent));
+#endif
     if (IsBootstrapProcessingMode() || indexInfo->ii_Concurrent)
     {
         snapshot = RegisterSnapshot(GetTransactionSnapshot());
@@ -2539,6 +2639,11 @@ IndexBuildHeapRangeScan(Relation heapRelation,
         OldestXmin = GetOldestXmin(heapRelation, PROCARRAY_FLAGS_VACUUM);
     }
 
+#ifdef __TBASE__
+    if (pscan != NULL)
+        scan = heap_beginscan_parallel(heapRelation, pscan);
+    else
+#endif
     scan = heap_beginscan_strat(heapRelation,    /* relation */
                                 snapshot,    /* snapshot */
                                 0,    /* number of keys */
@@ -2558,6 +2663,19 @@ IndexBuildHeapRangeScan(Relation heapRelation,
 
     reltuples = 0;
 
+#ifdef __TBASE__
+    /*
+     * Whole-heap scans report the blocks they get through as CREATE INDEX
+     * progress.  Parallel workers leave that to the leader, which counts the
+     * blocks handed out by the shared scan.
+     */
+    report_progress = !IsParallelWorker() && numblocks == InvalidBlockNumber;
+    if (report_progress)
+        pgstat_progress_update_param(PROGRESS_CREATEIDX_BLOCKS_TOTAL,
+                                     pscan ? pscan->phs_nblocks :
+                                     scan->rs_nblocks);
+#endif
+
 #ifdef _MLS_
     if (heapRelation->rd_att->transp_crypt)
     {
@@ -2610,6 +2728,18 @@ IndexBuildHeapRangeScan(Relation heapRelation,
             LockBuffer(scan->rs_cbuf, BUFFER_LOCK_UNLOCK);
 
             root_blkno = scan->rs_cblock;
+#ifdef __TBASE__
+            if (report_progress)
+            {
+                if (pscan != NULL)
+                    blocks_done = Min(pg_atomic_read_u64(&pscan->phs_nallocated),
+                                      pscan->phs_nblocks);
+                else
+                    blocks_done++;
+                pgstat_progress_update_param(PROGRESS_CREATEIDX_BLOCKS_DONE,
+                                             blocks_done);
+            }
+#endif
         }
 
         if (snapshot == SnapshotAny)
@@ -3097,6 +3227,11 @@ validate_index(Oid heapId, Oid indexId, Snapshot snapshot)
     /* And the target index relation */
     indexRelation = index_open(indexId, RowExclusiveLock);
 
+#ifdef __TBASE__
+    index_build_progress_start(heapId, indexId,
+                               PROGRESS_CREATEIDX_PHASE_VALIDATE);
+#endif
+
     /*
      * Fetch info needed for index_insert.  (You might think this should be
      * passed in from DefineIndex, but its copy is long gone due to having
@@ -3167,6 +3302,10 @@ validate_index(Oid heapId, Oid indexId, Snapshot snapshot)
     /* Restore userid and security context */
     SetUserIdAndSecContext(save_userid, save_sec_context);
 
+#ifdef __TBASE__
+    pgstat_progress_end_command();
+#endif
+
     /* Close rels, but keep locks */
     index_close(indexRelation, NoLock);
     heap_close(heapRelation, NoLock);
@@ -190,6 +190,30 @@ RelationCreateStorage(RelFileNode rnode, char relpersistence)
     pendingDeletes = pending;
 }
 
+#ifdef __TBASE__
+/*
+ * RelationCreatePageCompressFork
+ *        Make the freshly created storage of a relation page compressed.
+ *
+ * Must be called right after RelationCreateStorage(), before anything is
+ * written to the main fork.  Only permanent user relations can be
+ * compressed, the request is silently ignored for others.
+ */
+void
+RelationCreatePageCompressFork(RelFileNode rnode, char relpersistence)
+{
+    SMgrRelation srel;
+
+    if (relpersistence != RELPERSISTENCE_PERMANENT ||
+        rnode.relNode < FirstNormalObjectId)
+        return;
+
+    srel = smgropen(rnode, InvalidBackendId);
+    smgrcreate(srel, PAGE_COMPRESS_FORKNUM, false);
+    log_smgrcreate(&srel->smgr_rnode.node, PAGE_COMPRESS_FORKNUM);
+}
+#endif
+
 /*
  * Perform XLogInsert of an XLOG_SMGR_CREATE record to WAL.
  */
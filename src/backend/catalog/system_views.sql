@@ -881,6 +881,32 @@ CREATE VIEW pg_stat_bgwriter AS
         pg_stat_get_buf_alloc() AS buffers_alloc,
         pg_stat_get_bgwriter_stat_reset_time() AS stats_reset;
 
+CREATE VIEW pg_stat_group_commit AS
+    SELECT
+        s.requests,
+        s.flushes,
+        s.delayed_flushes,
+        s.delay_time,
+        s.queue_time,
+        s.max_queue_time,
+        s.avg_interval,
+        s.avg_flush_time,
+        s.window_time,
+        s.stats_reset
+    FROM pg_stat_get_group_commit() s;
+
+CREATE VIEW pg_stat_data_horizon AS
+    SELECT
+        H.datid,
+        D.datname,
+        H.pid,
+        H.backend_xmin,
+        H.snapshot_ts,
+        H.horizon_ts,
+        H.holds_shared
+    FROM tbase_get_data_horizon() H
+        LEFT JOIN pg_database D ON H.datid = D.oid;
+
 CREATE VIEW pg_stat_progress_vacuum AS
 	SELECT
 		S.pid AS pid, S.datid AS datid, D.datname AS datname,
@@ -899,6 +925,26 @@ CREATE VIEW pg_stat_progress_vacuum AS
     FROM pg_stat_get_progress_info('VACUUM') AS S
 		LEFT JOIN pg_database D ON S.datid = D.oid;
 
+CREATE VIEW pg_stat_progress_create_index AS
+	SELECT
+		S.pid AS pid, S.datid AS datid, D.datname AS datname,
+		S.relid AS relid,
+		CAST(S.param2 AS oid) AS index_relid,
+		CASE S.param1 WHEN 0 THEN 'initializing'
+					  WHEN 1 THEN 'scanning heap'
+					  WHEN 2 THEN 'sorting'
+					  WHEN 3 THEN 'loading tuples in tree'
+					  WHEN 4 THEN 'validating index'
+					  END AS phase,
+		S.param3 AS blocks_total, S.param4 AS blocks_done,
+		S.param5 AS tuples_scanned, S.param6 AS tuples_sorted,
+		S.param7 AS tuples_loaded, S.param8 AS workers_launched
+    FROM pg_stat_get_progress_info('CREATE INDEX') AS S
+		LEFT JOIN pg_database D ON S.datid = D.oid;
+
+CREATE VIEW pgxc_stat_progress_create_index AS
+    SELECT * FROM pg_catalog.pgxc_stat_get_progress_create_index();
+
 CREATE VIEW pg_user_mappings AS
     SELECT
         U.oid       AS umid,
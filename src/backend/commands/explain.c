@@ -1619,6 +1619,12 @@ ExplainNode(PlanState *planstate, List *ancestors,
                 if (es->verbose)
                     show_simple_sort_keys((RemoteSubplanState *)planstate,
                                           ancestors, es);
+#ifdef __TBASE__
+                /* network waits and traffic of the remote fragments */
+                if (es->analyze)
+                    ExplainRemoteSubplanNetwork((RemoteSubplanState *)planstate,
+                                                es);
+#endif
             }
             break;
 #endif
@@ -20,6 +20,7 @@
 #include "libpq/libpq.h"
 #include "libpq/pqformat.h"
 #include "nodes/nodeFuncs.h"
+#include "pgxc/pgxc.h"
 #include "utils/lsyscache.h"
 #include "utils/tuplesort.h"
 
@@ -30,6 +31,13 @@ do {                                             \
     tmp_head = tmp_pos + 1;                      \
 } while(0)
 
+/* Read network instrument field */
+#define NET_READ_FIELD(fldname)                  \
+do {                                             \
+    net->fldname = strtod(tmp_head, &tmp_pos);   \
+    tmp_head = tmp_pos + 1;                      \
+} while(0)
+
 /* Set max instrument */
 #define INSTR_MAX_FIELD(fldname)                          \
 do {                                                      \
@@ -50,21 +58,33 @@ typedef struct
 {
 	/* ids of plan nodes we've handled */
 	Bitmapset  *printed_nodes;
+	/* root of the plan fragment, which owns the producer network counters */
+	PlanState  *root;
 	/* send str buf */
 	StringInfoData buf;
 } SerializeState;
 
+/* Min/max of network instrumentation over datanodes */
+typedef struct NetworkMinMax
+{
+	bool        valid;
+	NetworkInstrumentation min;
+	NetworkInstrumentation max;
+} NetworkMinMax;
+
 /*
  * InstrOut
  *
  * Serialize Instrumentation structure with the format
- * "nodetype-plan_node_id-node_oid{val,val,...,val}".
+ * "nodetype-plan_node_id-node_oid{val,val,...,val}", followed by the
+ * NetworkInstrumentation values inside the same braces.
  *
  * NOTE: The function should be modified if the structure of Instrumentation
  * or its relevant members has been changed.
  */
 static void
-InstrOut(StringInfo buf, Plan *plan, Instrumentation *instr, int current_node_id)
+InstrOut(StringInfo buf, Plan *plan, Instrumentation *instr,
+         NetworkInstrumentation *net, int current_node_id)
 {
 	/* nodeTag for varify */
 	appendStringInfo(buf, "%hd-%d-%d{", nodeTag(plan), plan->plan_node_id, current_node_id);
@@ -120,7 +140,13 @@ InstrOut(StringInfo buf, Plan *plan, Instrumentation *instr, int current_node_id
 	appendStringInfo(buf, "%ld,", instr->bufusage.blk_read_time.tv_sec);
 	appendStringInfo(buf, "%ld,", instr->bufusage.blk_read_time.tv_nsec);
 	appendStringInfo(buf, "%ld,", instr->bufusage.blk_write_time.tv_sec);
-	appendStringInfo(buf, "%ld}", instr->bufusage.blk_write_time.tv_nsec);
+	appendStringInfo(buf, "%ld,", instr->bufusage.blk_write_time.tv_nsec);
+	/* NetworkInstrumentation */
+	appendStringInfo(buf, "%.10f,", net->firsttuple);
+	appendStringInfo(buf, "%.10f,", net->recv_wait);
+	appendStringInfo(buf, "%.10f,", net->send_blocked);
+	appendStringInfo(buf, "%.0f,", net->bytes_recv);
+	appendStringInfo(buf, "%.0f}", net->bytes_sent);
 	
 	elog(DEBUG1, "InstrOut: plan_node_id %d, node %d, nloops %.0f", plan->plan_node_id, current_node_id, instr->nloops);
 }
@@ -317,6 +343,7 @@ InstrIn(StringInfo str, RemoteInstr *rinstr)
 	char *tmp_pos;
 	char *tmp_head = &str->data[str->cursor];
 	Instrumentation *instr = &rinstr->instr;
+	NetworkInstrumentation *net = &rinstr->net;
 	
 	if (str->len <= 0)
 		return;
@@ -379,6 +406,12 @@ InstrIn(StringInfo str, RemoteInstr *rinstr)
 	INSTR_READ_FIELD(bufusage.blk_write_time.tv_sec);
 	INSTR_READ_FIELD(bufusage.blk_write_time.tv_nsec);
 	
+	NET_READ_FIELD(firsttuple);
+	NET_READ_FIELD(recv_wait);
+	NET_READ_FIELD(send_blocked);
+	NET_READ_FIELD(bytes_recv);
+	NET_READ_FIELD(bytes_sent);
+	
 	elog(DEBUG1, "InstrIn: plan_node_id %d, node %d, nloops %.0f", rinstr->key.plan_node_id, rinstr->key.node_id, instr->nloops);
 	
 	/* tmp_head points to next instrument's nodetype or '\0' already */
@@ -459,6 +492,30 @@ SpecInstrIn(StringInfo str, RemoteInstr *instr)
 	str->cursor = tmp_head - &str->data[0];
 }
 
+/*
+ * LocalNetworkInstr
+ *
+ * Collect network waits and traffic of a local plan node. A RemoteSubplan
+ * reports what it received, the root of the fragment what the whole
+ * fragment sent since executor start.
+ */
+static void
+LocalNetworkInstr(PlanState *planstate, bool is_root, NetworkInstrumentation *net)
+{
+	EState *estate = planstate->state;
+	
+	if (IsA(planstate, RemoteSubplanState))
+		memcpy(net, &((RemoteSubplanState *) planstate)->net, sizeof(NetworkInstrumentation));
+	else
+		memset(net, 0, sizeof(NetworkInstrumentation));
+	
+	if (is_root)
+	{
+		net->send_blocked = PGXCNetSendBlockedTime - estate->es_net_send_blocked_start;
+		net->bytes_sent = PGXCNetBytesSent - estate->es_net_bytes_sent_start;
+	}
+}
+
 /*
  * SerializeLocalInstr
  *
@@ -473,6 +530,8 @@ SerializeLocalInstr(PlanState *planstate, SerializeState *ss)
 	 * it is ok to use plan_node_id in place of plan_id.
 	 */
 	int plan_node_id = planstate->plan->plan_node_id;
+	bool is_root = (planstate == ss->root);
+	
 	if (bms_is_member(plan_node_id, ss->printed_nodes))
 		return false;
 	else
@@ -493,12 +552,13 @@ SerializeLocalInstr(PlanState *planstate, SerializeState *ss)
 			for (n = 0; n < planstate->dn_instrument->nnode; n++)
 			{
 				Instrumentation *instrument = &(planstate->dn_instrument->instrument[n].instr);
+				NetworkInstrumentation *net = &(planstate->dn_instrument->instrument[n].net);
 				int              node_id = planstate->dn_instrument->instrument[n].nodeid;
 				
 				/* instrument valid only if node_oid set */
 				if (node_id != 0)
 				{
-					InstrOut(&ss->buf, planstate->plan, instrument, node_id);
+					InstrOut(&ss->buf, planstate->plan, instrument, net, node_id);
 					SpecInstrOut(&ss->buf, nodeTag(planstate->plan), planstate);
 				}
 				else
@@ -510,7 +570,10 @@ SerializeLocalInstr(PlanState *planstate, SerializeState *ss)
 		else
 		{
 			/* send our own instr */
-			InstrOut(&ss->buf, planstate->plan, planstate->instrument, 0);
+			NetworkInstrumentation net;
+			
+			LocalNetworkInstr(planstate, is_root, &net);
+			InstrOut(&ss->buf, planstate->plan, planstate->instrument, &net, 0);
 			SpecInstrOut(&ss->buf, nodeTag(planstate->plan), planstate);
 		}
 	}
@@ -536,6 +599,7 @@ SendLocalInstr(PlanState *planstate)
 	
 	/* Construct str with the same logic in ExplainNode */
 	ss.printed_nodes = NULL;
+	ss.root = planstate;
 	pq_beginmessage(&ss.buf, 'i');
 	SerializeLocalInstr(planstate, &ss);
 	pq_endmessage(&ss.buf);
@@ -692,6 +756,13 @@ combineRemoteInstr(RemoteInstr *rtarget, RemoteInstr *rsrc)
 	INSTR_MAX_FIELD(bufusage.blk_write_time.tv_sec);
 	INSTR_MAX_FIELD(bufusage.blk_write_time.tv_nsec);
 	
+	/* network instrument */
+	rtarget->net.firsttuple = Max(rtarget->net.firsttuple, rsrc->net.firsttuple);
+	rtarget->net.recv_wait = Max(rtarget->net.recv_wait, rsrc->net.recv_wait);
+	rtarget->net.send_blocked = Max(rtarget->net.send_blocked, rsrc->net.send_blocked);
+	rtarget->net.bytes_recv = Max(rtarget->net.bytes_recv, rsrc->net.bytes_recv);
+	rtarget->net.bytes_sent = Max(rtarget->net.bytes_sent, rsrc->net.bytes_sent);
+	
 	combineSpecRemoteInstr(rtarget, rsrc);
 }
 
@@ -914,6 +985,7 @@ AttachRemoteInstr(PlanState *planstate, AttachRemoteInstrContext *ctx)
 				elog(DEBUG1, "instr attach plan_node_id %d node %d index %d", plan_node_id, key.node_id, n);
 				planstate->dn_instrument->instrument[n].nodeid = key.node_id;
 				memcpy(&planstate->dn_instrument->instrument[n].instr, &rinstr->instr, sizeof(Instrumentation));
+				memcpy(&planstate->dn_instrument->instrument[n].net, &rinstr->net, sizeof(NetworkInstrumentation));
 				/* TODO attach all nodes' remote specific instr */
 				rinstr_final.nodeTag = rinstr->nodeTag;
 				rinstr_final.key = rinstr->key;
@@ -940,14 +1012,142 @@ AttachRemoteInstr(PlanState *planstate, AttachRemoteInstrContext *ctx)
 	return planstate_tree_walker(planstate, AttachRemoteInstr, ctx);
 }
 
+/*
+ * NetworkMinMaxAdd
+ *
+ * Fold network instrument of one datanode into the min/max of all.
+ */
+static void
+NetworkMinMaxAdd(NetworkMinMax *mm, NetworkInstrumentation *net)
+{
+	if (!mm->valid)
+	{
+		mm->min = *net;
+		mm->max = *net;
+		mm->valid = true;
+		return;
+	}
+	
+	SET_MIN_MAX(mm->min.firsttuple, mm->max.firsttuple, net->firsttuple);
+	SET_MIN_MAX(mm->min.recv_wait, mm->max.recv_wait, net->recv_wait);
+	SET_MIN_MAX(mm->min.send_blocked, mm->max.send_blocked, net->send_blocked);
+	SET_MIN_MAX(mm->min.bytes_recv, mm->max.bytes_recv, net->bytes_recv);
+	SET_MIN_MAX(mm->min.bytes_sent, mm->max.bytes_sent, net->bytes_sent);
+}
+
+/*
+ * appendNetworkField
+ *
+ * Append one network value for text format, as min..max if range is set.
+ * Values never recorded on any node are skipped.
+ */
+static void
+appendNetworkField(StringInfo str, const char *label, bool range,
+                   double min, double max, bool is_bytes)
+{
+	if (max <= 0)
+		return;
+	
+	if (str->len > 0)
+		appendStringInfoChar(str, ' ');
+	
+	if (is_bytes)
+	{
+		if (range)
+			appendStringInfo(str, "%s=%.0f..%.0fkB", label, min / 1024, max / 1024);
+		else
+			appendStringInfo(str, "%s=%.0fkB", label, max / 1024);
+	}
+	else
+	{
+		if (range)
+			appendStringInfo(str, "%s=%.3f..%.3f", label, 1000.0 * min, 1000.0 * max);
+		else
+			appendStringInfo(str, "%s=%.3f", label, 1000.0 * max);
+	}
+}
+
+/*
+ * NetworkInstrText
+ *
+ * Format network instrument for text output into buf, which is left empty
+ * if nothing was recorded. If min is NULL, max is the value of one node.
+ * Like times, traffic varies from run to run, so it is only shown with
+ * TIMING on.
+ */
+static void
+NetworkInstrText(StringInfo buf, NetworkInstrumentation *min,
+                 NetworkInstrumentation *max, ExplainState *es)
+{
+	bool range = (min != NULL);
+	
+	if (!range)
+		min = max;
+	
+	resetStringInfo(buf);
+	if (!es->timing)
+		return;
+	
+	appendNetworkField(buf, "first tuple", range,
+	                   min->firsttuple, max->firsttuple, false);
+	appendNetworkField(buf, "recv wait", range,
+	                   min->recv_wait, max->recv_wait, false);
+	appendNetworkField(buf, "send blocked", range,
+	                   min->send_blocked, max->send_blocked, false);
+	appendNetworkField(buf, "received", range,
+	                   min->bytes_recv, max->bytes_recv, true);
+	appendNetworkField(buf, "sent", range,
+	                   min->bytes_sent, max->bytes_sent, true);
+}
+
+/*
+ * NetworkInstrProperties
+ *
+ * Non-text counterpart of NetworkInstrText, labels start with prefix.
+ */
+static void
+NetworkInstrProperties(const char *prefix, NetworkInstrumentation *net,
+                       ExplainState *es)
+{
+	char label[64];
+	
+	if (!es->timing)
+		return;
+	
+	snprintf(label, sizeof(label), "%sFirst Tuple Time", prefix);
+	ExplainPropertyFloat(label, 1000.0 * net->firsttuple, 3, es);
+	snprintf(label, sizeof(label), "%sReceive Wait Time", prefix);
+	ExplainPropertyFloat(label, 1000.0 * net->recv_wait, 3, es);
+	snprintf(label, sizeof(label), "%sSend Blocked Time", prefix);
+	ExplainPropertyFloat(label, 1000.0 * net->send_blocked, 3, es);
+	snprintf(label, sizeof(label), "%sBytes Received", prefix);
+	ExplainPropertyFloat(label, net->bytes_recv, 0, es);
+	snprintf(label, sizeof(label), "%sBytes Sent", prefix);
+	ExplainPropertyFloat(label, net->bytes_sent, 0, es);
+}
+
+/*
+ * NetworkInstrIsSet
+ *
+ * Is anything recorded in the network instrument?
+ */
+static bool
+NetworkInstrIsSet(NetworkInstrumentation *net)
+{
+	return net->firsttuple > 0 || net->recv_wait > 0 ||
+	       net->send_blocked > 0 || net->bytes_recv > 0 ||
+	       net->bytes_sent > 0;
+}
+
 /*
  * ExplainCommonRemoteInstr
  *
- * Explain remote instruments for common info of current node.
+ * Explain remote instruments for common info of current node, with the
+ * slowest and fastest datanode and the network waits and traffic.
  */
 void
 ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es)
-{
+{// #lizard forgives
 	int     i;
 	int     nnode = planstate->dn_instrument->nnode;
 	
@@ -957,6 +1157,14 @@ ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es)
 	double startup_sec_min, startup_sec_max, startup_sec;
 	double total_sec_min, total_sec_max, total_sec;
 	double rows_min, rows_max, rows;
+	/* for slowest/fastest datanode */
+	int    nexecuted = 0;
+	int    slowest = -1;
+	int    fastest = -1;
+	double slowest_sec = 0;
+	double fastest_sec = 0;
+	NetworkMinMax net_mm;
+	StringInfoData netbuf;
 	/* for verbose */
 	StringInfoData buf;
 	
@@ -985,6 +1193,8 @@ ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es)
 		return;
 	}
 	
+	memset(&net_mm, 0, sizeof(NetworkMinMax));
+	initStringInfo(&netbuf);
 	if (es->verbose)
 		initStringInfo(&buf);
 	
@@ -1008,6 +1218,22 @@ ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es)
 		SET_MIN_MAX(total_sec_min, total_sec_max, total_sec);
 		SET_MIN_MAX(rows_min, rows_max, rows);
 		
+		if (nloops > 0)
+		{
+			if (slowest < 0 || total_sec > slowest_sec)
+			{
+				slowest = i;
+				slowest_sec = total_sec;
+			}
+			if (fastest < 0 || total_sec < fastest_sec)
+			{
+				fastest = i;
+				fastest_sec = total_sec;
+			}
+			NetworkMinMaxAdd(&net_mm, &rinstr[i].net);
+			nexecuted++;
+		}
+		
 		/* one line for each dn if verbose */
 		if (es->verbose)
 		{
@@ -1029,6 +1255,10 @@ ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es)
 						appendStringInfo(&buf,
 						                 "- %s (actual rows=%.0f loops=%.0f)",
 						                 dnname, rows, nloops);
+					
+					NetworkInstrText(&netbuf, NULL, &rinstr[i].net, es);
+					if (netbuf.len > 0)
+						appendStringInfo(&buf, " (network %s)", netbuf.data);
 				}
 			}
 			else
@@ -1041,6 +1271,8 @@ ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es)
 				}
 				ExplainPropertyFloat("Actual Rows", rows, 0, es);
 				ExplainPropertyFloat("Actual Loops", nloops, 0, es);
+				if (nloops > 0 && NetworkInstrIsSet(&rinstr[i].net))
+					NetworkInstrProperties("", &rinstr[i].net, es);
 			}
 		}
 	}
@@ -1066,6 +1298,31 @@ ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es)
 				appendStringInfo(es->str,
 				                 "DN (actual rows=%.0f..%.0f loops=%.0f..%.0f)",
 				                 rows_min, rows_max, nloops_min, nloops_max);
+			
+			/* tell skewed datanodes apart from slow network */
+			if (es->timing && nexecuted > 1)
+			{
+				appendStringInfoChar(es->str, '\n');
+				appendStringInfoSpaces(es->str, es->indent * 2);
+				appendStringInfo(es->str,
+				                 "DN Skew: slowest %s (total time=%.3f rows=%.0f) fastest %s (total time=%.3f rows=%.0f)",
+				                 get_pgxc_nodename_from_identifier(rinstr[slowest].nodeid),
+				                 slowest_sec,
+				                 rinstr[slowest].instr.ntuples / rinstr[slowest].instr.nloops,
+				                 get_pgxc_nodename_from_identifier(rinstr[fastest].nodeid),
+				                 fastest_sec,
+				                 rinstr[fastest].instr.ntuples / rinstr[fastest].instr.nloops);
+			}
+			if (net_mm.valid)
+			{
+				NetworkInstrText(&netbuf, &net_mm.min, &net_mm.max, es);
+				if (netbuf.len > 0)
+				{
+					appendStringInfoChar(es->str, '\n');
+					appendStringInfoSpaces(es->str, es->indent * 2);
+					appendStringInfo(es->str, "DN Network: %s", netbuf.data);
+				}
+			}
 		}
 		
 		if (es->verbose)
@@ -1089,5 +1346,55 @@ ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es)
 		ExplainPropertyFloat("Actual Max Rows", rows_max, 0, es);
 		ExplainPropertyFloat("Actual Min Loops", nloops_min, 0, es);
 		ExplainPropertyFloat("Actual Max Loops", nloops_max, 0, es);
+		
+		if (es->timing && nexecuted > 1)
+		{
+			ExplainPropertyText("Slowest Data Node",
+			                    get_pgxc_nodename_from_identifier(rinstr[slowest].nodeid),
+			                    es);
+			ExplainPropertyFloat("Slowest Data Node Total Time", slowest_sec, 3, es);
+			ExplainPropertyText("Fastest Data Node",
+			                    get_pgxc_nodename_from_identifier(rinstr[fastest].nodeid),
+			                    es);
+			ExplainPropertyFloat("Fastest Data Node Total Time", fastest_sec, 3, es);
+		}
+		if (net_mm.valid && NetworkInstrIsSet(&net_mm.max))
+		{
+			NetworkInstrProperties("Min ", &net_mm.min, es);
+			NetworkInstrProperties("Max ", &net_mm.max, es);
+		}
 	}
+	
+	pfree(netbuf.data);
+}
+
+/*
+ * ExplainRemoteSubplanNetwork
+ *
+ * Explain network waits and traffic of a RemoteSubplan executed locally,
+ * that is, how long it waited for the first tuple and for its producers.
+ */
+void
+ExplainRemoteSubplanNetwork(RemoteSubplanState *node, ExplainState *es)
+{
+	NetworkInstrumentation *net = &node->net;
+	
+	if (node->combiner.ss.ps.instrument == NULL || !NetworkInstrIsSet(net))
+		return;
+	
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		StringInfoData buf;
+		
+		initStringInfo(&buf);
+		NetworkInstrText(&buf, NULL, net, es);
+		if (buf.len > 0)
+		{
+			appendStringInfoSpaces(es->str, es->indent * 2);
+			appendStringInfo(es->str, "Network: %s\n", buf.data);
+		}
+		pfree(buf.data);
+	}
+	else
+		NetworkInstrProperties("", net, es);
 }
@@ -160,6 +160,9 @@ static List *on_commits = NIL;
 
 #ifdef __TBASE__
 extern bool    is_txn_has_parallel_ddl;
+
+/* refuse DDL blocking a distributed table for long, see CheckBlockingDDL */
+bool        refuse_blocking_ddl = false;
 #endif
 
 /*
@@ -5909,6 +5912,64 @@ ATModifyPartitionStartValue(Relation rel, ModifyPartStartValue * value)
 
     ModifyPartitionStartValue(RelationGetRelid(rel), start_value);
 }
+
+/*
+ * CheckBlockingDDL
+ *
+ * With refuse_blocking_ddl, refuse a step that would hold a lock blocking the
+ * writes (or reads) of a distributed table while every datanode scans,
+ * rewrites or indexes its shards.  This is only a guard: nothing is done
+ * online instead, the user has to pick the non-blocking form of the change.
+ *
+ * Checked on the local coordinator, which runs the statement before sending
+ * it to the datanodes, so nothing has been done there yet.  Tables created
+ * in this transaction are not visible to anybody else and are left alone.
+ */
+void
+CheckBlockingDDL(Relation rel, BlockingDDLStep step)
+{
+    if (!refuse_blocking_ddl || !IS_PGXC_LOCAL_COORDINATOR)
+        return;
+
+    if (RelationGetLocInfo(rel) == NULL ||
+        rel->rd_createSubid != InvalidSubTransactionId)
+        return;
+
+    if (rel->rd_rel->relkind != RELKIND_RELATION &&
+        rel->rd_rel->relkind != RELKIND_MATVIEW &&
+        rel->rd_rel->relkind != RELKIND_PARTITIONED_TABLE)
+        return;
+
+    switch (step)
+    {
+        case BLOCKING_DDL_REWRITE:
+            ereport(ERROR,
+                    (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                     errmsg("cannot rewrite distributed table \"%s\" while refuse_blocking_ddl is on",
+                            RelationGetRelationName(rel)),
+                     errdetail("Changing the type of a column, adding a column with a volatile default or changing persistence rewrites the table on every datanode under an ACCESS EXCLUSIVE lock."),
+                     errhint("Set refuse_blocking_ddl to off to run it anyway.")));
+            break;
+
+        case BLOCKING_DDL_VALIDATE:
+            ereport(ERROR,
+                    (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                     errmsg("cannot scan distributed table \"%s\" to validate constraints while refuse_blocking_ddl is on",
+                            RelationGetRelationName(rel)),
+                     errdetail("New NOT NULL, CHECK, FOREIGN KEY and partition constraints are validated on every datanode under a lock blocking writes."),
+                     errhint("Add CHECK and FOREIGN KEY constraints as NOT VALID, then validate them with ALTER TABLE ... VALIDATE CONSTRAINT, which does not block writes.")));
+            break;
+
+        case BLOCKING_DDL_INDEX:
+            ereport(ERROR,
+                    (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                     errmsg("cannot build index on distributed table \"%s\" while refuse_blocking_ddl is on",
+                            RelationGetRelationName(rel)),
+                     errdetail("The index is built on every datanode under a lock blocking writes."),
+                     errhint("Use CREATE INDEX CONCURRENTLY, then ALTER TABLE ... ADD CONSTRAINT ... USING INDEX for a primary key or unique constraint.")));
+            break;
+    }
+}
 #endif
 
 /*
@@ -5943,6 +6004,20 @@ ATRewriteTables(AlterTableStmt *parsetree, List **wqueue, LOCKMODE lockmode)
                 tab->relkind == RELKIND_PARTITIONED_INDEX)
             continue;
 
+#ifdef __TBASE__
+        if (refuse_blocking_ddl &&
+            (tab->rewrite > 0 || tab->constraints != NIL ||
+             tab->new_notnull || tab->partition_constraint != NULL))
+        {
+            Relation    rel;
+
+            rel = heap_open(tab->relid, NoLock);
+            CheckBlockingDDL(rel, tab->rewrite > 0 ? BLOCKING_DDL_REWRITE :
+                                                   BLOCKING_DDL_VALIDATE);
+            heap_close(rel, NoLock);
+        }
+#endif
+
         /*
          * If we change column data types or add/remove OIDs, the operation
          * has to be propagated to tables that use this table's rowtype as a
@@ -8733,6 +8808,11 @@ ATExecAddIndex(AlteredTableInfo *tab, Relation rel,
     /* suppress notices when rebuilding existing index */
     quiet = is_rebuild;
 
+#ifdef __TBASE__
+    if (!is_rebuild && !skip_build)
+        CheckBlockingDDL(rel, BLOCKING_DDL_INDEX);
+#endif
+
     address = DefineIndex(RelationGetRelid(rel),
                           stmt,
                           InvalidOid,    /* no predefined OID */
@@ -12912,6 +12992,10 @@ ATExecSetTableSpace(Oid tableOid, Oid newTableSpace, LOCKMODE lockmode)
      * RelationCreateStorage().
      */
     RelationCreateStorage(newrnode, rel->rd_rel->relpersistence);
+#ifdef __TBASE__
+    if (RelationIsPageCompressed(rel))
+        RelationCreatePageCompressFork(newrnode, rel->rd_rel->relpersistence);
+#endif
 
     /* copy main fork */
     copy_relation_data(rel->rd_smgr, dstrel, MAIN_FORKNUM,
@@ -12920,6 +13004,11 @@ ATExecSetTableSpace(Oid tableOid, Oid newTableSpace, LOCKMODE lockmode)
     /* copy those extra forks that exist */
     for (forkNum = MAIN_FORKNUM + 1; forkNum <= MAX_FORKNUM; forkNum++)
     {
+#ifdef __TBASE__
+        /* the address fork is private to the storage of the main fork */
+        if (forkNum == PAGE_COMPRESS_FORKNUM)
+            continue;
+#endif
         if (smgrexists(rel->rd_smgr, forkNum))
         {
             smgrcreate(dstrel, forkNum, false);
@@ -13254,8 +13343,12 @@ copy_relation_data(SMgrRelation src, SMgrRelation dst,
         smgrread(src, forkNum, blkno, buf);
         
 #ifdef _MLS_
-        /* after verify, decrypt if needed */
-        if (MAIN_FORKNUM == forkNum || EXTENT_FORKNUM == forkNum)
+        /* after verify, decrypt if needed, compressed pages are decrypted by smgr */
+        if ((MAIN_FORKNUM == forkNum || EXTENT_FORKNUM == forkNum)
+#ifdef __TBASE__
+            && !(MAIN_FORKNUM == forkNum && SmgrIsPageCompressed(src))
+#endif
+            )
         {
             algo_id = PageGetAlgorithmId(buf);
             if (TRANSP_CRYPT_ALGO_ID_IS_VALID(algo_id))
@@ -1212,7 +1212,7 @@ lazy_scan_heap(Relation onerel, int options, LVRelStats *vacrelstats,
                                 }
                             }
                                 
-                            if(!TestForOldTimestamp(committs, RecentDataTs))
+                            if(!TestForOldTimestamp(committs, DataHorizonForRelation(onerel->rd_rel->relisshared)))
                             {
                                 all_visible = false;
                                 break;
@@ -2389,7 +2389,7 @@ heap_page_is_all_visible(Relation rel, Buffer buf,
                             }
                         }
                             
-                        if(!TestForOldTimestamp(committs, RecentDataTs))
+                        if(!TestForOldTimestamp(committs, DataHorizonForRelation(rel->rd_rel->relisshared)))
                         {
                             all_visible = false;
                             *all_frozen = false;
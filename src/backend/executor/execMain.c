@@ -353,6 +353,13 @@ standard_ExecutorStart(QueryDesc *queryDesc, int eflags)
     estate->es_crosscheck_snapshot = RegisterSnapshot(queryDesc->crosscheck_snapshot);
     estate->es_top_eflags = eflags;
     estate->es_instrument = queryDesc->instrument_options;
+#ifdef __TBASE__
+    if (estate->es_instrument)
+    {
+        estate->es_net_send_blocked_start = PGXCNetSendBlockedTime;
+        estate->es_net_bytes_sent_start = PGXCNetBytesSent;
+    }
+#endif
 
     /*
      * Initialize the plan state tree
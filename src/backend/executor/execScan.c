@@ -142,7 +142,6 @@ ExecScan(ScanState *node,
     
 #ifdef __AUDIT_FGA__
 	ShardID 	shardid = InvalidShardID;
-    ListCell      *item;
 
     char *cmd_type = "SELECT";
     CmdType    commandType = CMD_SELECT;
@@ -316,21 +315,10 @@ next_record:
         if (qual == NULL || ExecQual(qual, econtext))
         {
 #ifdef __AUDIT_FGA__
-            if (enable_fga && g_commandTag && (strcmp(g_commandTag, "SELECT") == 0))
+            if (node->ps.audit_fga_qual && enable_fga &&
+                g_commandTag && (strcmp(g_commandTag, "SELECT") == 0))
             {
-                foreach (item, node->ps.audit_fga_qual)
-                {
-                    audit_fga_policy_state *audit_fga_qual = (audit_fga_policy_state *) lfirst(item);
-                    if (audit_fga_qual != NULL)
-                    {
-                        if(ExecQual(audit_fga_qual->qual, econtext))
-                        {
-                            audit_fga_log_policy_info_2(audit_fga_qual, cmd_type);
-
-                            node->ps.audit_fga_qual = list_delete(node->ps.audit_fga_qual, audit_fga_qual);
-                        }
-                    }   
-                }
+                audit_fga_exec_plan_quals(&node->ps, econtext, cmd_type);
             }
 #endif
 #ifdef __TBASE__
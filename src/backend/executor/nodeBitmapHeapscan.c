@@ -796,10 +796,6 @@ ExecInitBitmapHeapScan(BitmapHeapScan *node, EState *estate, int eflags)
     Relation    currentRelation;
     int            io_concurrency;
 
-#ifdef __AUDIT_FGA__
-    ListCell      *item;
-#endif    
-
     /* check for unsupported flags */
     Assert(!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)));
 
@@ -850,21 +846,7 @@ ExecInitBitmapHeapScan(BitmapHeapScan *node, EState *estate, int eflags)
 #ifdef __AUDIT_FGA__
     if (enable_fga)
     {
-        foreach (item, node->scan.plan.audit_fga_quals)
-        {
-            AuditFgaPolicy *audit_fga_qual = (AuditFgaPolicy *) lfirst(item);
-            
-            audit_fga_policy_state * audit_fga_policy_state_item
-                    = palloc0(sizeof(audit_fga_policy_state));
-
-            audit_fga_policy_state_item->policy_name = audit_fga_qual->policy_name;
-            audit_fga_policy_state_item->query_string = audit_fga_qual->query_string;
-            audit_fga_policy_state_item->qual = 
-                ExecInitQual(audit_fga_qual->qual, (PlanState *) scanstate);
-
-            scanstate->ss.ps.audit_fga_qual = 
-                lappend(scanstate->ss.ps.audit_fga_qual, audit_fga_policy_state_item);      
-        }
+        audit_fga_init_plan_quals(&scanstate->ss.ps, node->scan.plan.audit_fga_quals);
     }
 #endif 
 
@@ -469,10 +469,6 @@ ExecInitIndexOnlyScan(IndexOnlyScan *node, EState *estate, int eflags)
     bool        relistarget;
     TupleDesc    tupDesc;
 
-#ifdef __AUDIT_FGA__
-    ListCell      *item;
-#endif    
-
     /*
      * create state structure
      */
@@ -503,21 +499,7 @@ ExecInitIndexOnlyScan(IndexOnlyScan *node, EState *estate, int eflags)
 #ifdef __AUDIT_FGA__
     if (enable_fga)
     {
-        foreach (item, node->scan.plan.audit_fga_quals)
-        {
-            AuditFgaPolicy *audit_fga_qual = (AuditFgaPolicy *) lfirst(item);
-            
-            audit_fga_policy_state * audit_fga_policy_state_item
-                    = palloc0(sizeof(audit_fga_policy_state));
-
-            audit_fga_policy_state_item->policy_name = audit_fga_qual->policy_name;
-            audit_fga_policy_state_item->query_string = audit_fga_qual->query_string;
-            audit_fga_policy_state_item->qual = 
-                ExecInitQual(audit_fga_qual->qual, (PlanState *) indexstate);
-
-            indexstate->ss.ps.audit_fga_qual = 
-                lappend(indexstate->ss.ps.audit_fga_qual, audit_fga_policy_state_item);      
-        }
+        audit_fga_init_plan_quals(&indexstate->ss.ps, node->scan.plan.audit_fga_quals);
     }
 #endif     
 
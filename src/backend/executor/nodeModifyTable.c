@@ -2205,7 +2205,6 @@ ExecModifyTable(PlanState *pstate)
 #endif
 
 #ifdef __AUDIT_FGA__
-    ListCell      *item = NULL;
     ExprContext *econtext = NULL;
     //EState       *audit_fga_estate;
     TupleTableSlot *audit_fga_slot = NULL;
@@ -2562,98 +2561,82 @@ ExecModifyTable(PlanState *pstate)
         }
 
 #ifdef __AUDIT_FGA__
-        if (IsNormalProcessingMode() && IsUnderPostmaster && enable_fga)
+        if (IsNormalProcessingMode() && IsUnderPostmaster && enable_fga &&
+            node->ps.audit_fga_qual != NIL)
         {
-            foreach (item, node->ps.audit_fga_qual)
+            HeapTuple    result = NULL;
+
+            /* build the row once, then check it against all policies */
+            if (operation == CMD_UPDATE || operation == CMD_DELETE)
             {
-                HeapTuple    result = NULL;
-                audit_fga_policy_state *audit_fga_qual = (audit_fga_policy_state *) lfirst(item);
-        
-                if (operation == CMD_UPDATE || operation == CMD_DELETE)
-                {
-                    Page        page;
-                    ItemId        lp;
-                    Buffer        buffer;
-                    HeapTupleData tuple;
-                    Relation    relation = estate->es_result_relation_info->ri_RelationDesc;               
+                Page        page;
+                ItemId        lp;
+                Buffer        buffer;
+                HeapTupleData tuple;
+                Relation    relation = estate->es_result_relation_info->ri_RelationDesc;               
 
-                    buffer = ReadBuffer(relation, ItemPointerGetBlockNumber(tupleid));
+                buffer = ReadBuffer(relation, ItemPointerGetBlockNumber(tupleid));
 
-                    /*
-                             * Although we already know this tuple is valid, we must lock the
-                             * buffer to ensure that no one has a buffer cleanup lock; otherwise
-                             * they might move the tuple while we try to copy it.  But we can
-                             * release the lock before actually doing the heap_copytuple call,
-                             * since holding pin is sufficient to prevent anyone from getting a
-                             * cleanup lock they don't already hold.
-                             */
-                    LockBuffer(buffer, BUFFER_LOCK_SHARE);
-
-                    page = BufferGetPage(buffer);
-                    lp = PageGetItemId(page, ItemPointerGetOffsetNumber(tupleid));
-
-                    Assert(ItemIdIsNormal(lp));
-
-                    tuple.t_data = (HeapTupleHeader) PageGetItem(page, lp);
-                    tuple.t_len = ItemIdGetLength(lp);
-                    tuple.t_self = *tupleid;
-                    tuple.t_tableOid = RelationGetRelid(relation);
-
-                    LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
-                    result = heap_copytuple(&tuple);
-                    ReleaseBuffer(buffer);                
-                }              
-
-                audit_fga_slot_tupdesc = CreateTupleDescCopy(RelationGetDescr(estate->es_result_relation_info->ri_RelationDesc));
-                audit_fga_slot = MakeSingleTupleTableSlot(audit_fga_slot_tupdesc);
-            
-                switch (operation)
-                {
-                    case CMD_INSERT:
-                        cmd_type = "INSERT";
-                        ExecCopySlot(audit_fga_slot, slot);
-                        break;
-                    case CMD_UPDATE:
-                        cmd_type = "UPDATE";
-                        ExecStoreTuple(result, audit_fga_slot, InvalidBuffer, false);
-                        break;
-                    case CMD_DELETE:
-                        cmd_type = "DELETE";
-                        ExecStoreTuple(result, audit_fga_slot, InvalidBuffer, false);
-                        break;
-                    default:
-                        cmd_type = "???";
-                        ExecCopySlot(audit_fga_slot, slot);
-                        break;
-                }
+                /*
+                 * Although we already know this tuple is valid, we must lock the
+                 * buffer to ensure that no one has a buffer cleanup lock; otherwise
+                 * they might move the tuple while we try to copy it.  But we can
+                 * release the lock before actually doing the heap_copytuple call,
+                 * since holding pin is sufficient to prevent anyone from getting a
+                 * cleanup lock they don't already hold.
+                 */
+                LockBuffer(buffer, BUFFER_LOCK_SHARE);
+
+                page = BufferGetPage(buffer);
+                lp = PageGetItemId(page, ItemPointerGetOffsetNumber(tupleid));
+
+                Assert(ItemIdIsNormal(lp));
+
+                tuple.t_data = (HeapTupleHeader) PageGetItem(page, lp);
+                tuple.t_len = ItemIdGetLength(lp);
+                tuple.t_self = *tupleid;
+                tuple.t_tableOid = RelationGetRelid(relation);
+
+                LockBuffer(buffer, BUFFER_LOCK_UNLOCK);
+                result = heap_copytuple(&tuple);
+                ReleaseBuffer(buffer);                
+            }              
+
+            audit_fga_slot_tupdesc = CreateTupleDescCopy(RelationGetDescr(estate->es_result_relation_info->ri_RelationDesc));
+            audit_fga_slot = MakeSingleTupleTableSlot(audit_fga_slot_tupdesc);
+        
+            switch (operation)
+            {
+                case CMD_INSERT:
+                    cmd_type = "INSERT";
+                    ExecCopySlot(audit_fga_slot, slot);
+                    break;
+                case CMD_UPDATE:
+                    cmd_type = "UPDATE";
+                    ExecStoreTuple(result, audit_fga_slot, InvalidBuffer, true);
+                    break;
+                case CMD_DELETE:
+                    cmd_type = "DELETE";
+                    ExecStoreTuple(result, audit_fga_slot, InvalidBuffer, true);
+                    break;
+                default:
+                    cmd_type = "???";
+                    ExecCopySlot(audit_fga_slot, slot);
+                    break;
+            }
             
-                //ExecCopySlot(audit_fga_slot, slot);
-                
-                econtext = GetPerTupleExprContext(estate);
-                old_ecxt_scantuple = econtext->ecxt_scantuple;
-                econtext->ecxt_scantuple = audit_fga_slot;
-                            
-                if (audit_fga_qual != NULL)
-                {
-                    if(ExecQual(audit_fga_qual->qual, econtext))
-                    {
-                        audit_fga_log_policy_info_2(audit_fga_qual, cmd_type);
-                        
-                        node->ps.audit_fga_qual = list_delete(node->ps.audit_fga_qual, audit_fga_qual);
-                    }
-                    else
-                    {
-                        elog(DEBUG1, "AUDIT_FGA: NOT EQAL");
-                    }
-                }
+            econtext = GetPerTupleExprContext(estate);
+            old_ecxt_scantuple = econtext->ecxt_scantuple;
+            econtext->ecxt_scantuple = audit_fga_slot;
 
-                econtext->ecxt_scantuple = old_ecxt_scantuple;
-                ExecDropSingleTupleTableSlot(audit_fga_slot);
-                if (audit_fga_slot_tupdesc)
-                {
-                    FreeTupleDesc(audit_fga_slot_tupdesc);
-                }
-            }           
+            audit_fga_exec_plan_quals(&node->ps, econtext, cmd_type);
+
+            econtext->ecxt_scantuple = old_ecxt_scantuple;
+            ExecDropSingleTupleTableSlot(audit_fga_slot);
+            if (audit_fga_slot_tupdesc)
+            {
+                FreeTupleDesc(audit_fga_slot_tupdesc);
+            }
         }
 #endif            
 
@@ -2784,10 +2767,6 @@ ExecInitModifyTable(ModifyTable *node, EState *estate, int eflags)
     bool        remote_dml = false;
 #endif
 
-#ifdef __AUDIT_FGA__
-    ListCell      *item;
-#endif
-
     /* check for unsupported flags */
     Assert(!(eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)));
 
@@ -3062,21 +3041,7 @@ ExecInitModifyTable(ModifyTable *node, EState *estate, int eflags)
 #ifdef __AUDIT_FGA__
     if (enable_fga)
     {
-        foreach (item, node->plan.audit_fga_quals)
-        {
-            AuditFgaPolicy *audit_fga_qual = (AuditFgaPolicy *) lfirst(item);
-            
-            audit_fga_policy_state * audit_fga_policy_state_item
-                    = palloc0(sizeof(audit_fga_policy_state));
-
-            audit_fga_policy_state_item->policy_name = audit_fga_qual->policy_name;
-            audit_fga_policy_state_item->query_string = audit_fga_qual->query_string;
-            audit_fga_policy_state_item->qual = 
-                ExecInitQual(audit_fga_qual->qual, &mtstate->ps);
-
-            mtstate->ps.audit_fga_qual = 
-                lappend(mtstate->ps.audit_fga_qual, audit_fga_policy_state_item);      
-        }
+        audit_fga_init_plan_quals(&mtstate->ps, node->plan.audit_fga_quals);
     }
 #endif    
 
@@ -173,10 +173,6 @@ ExecInitSampleScan(SampleScan *node, EState *estate, int eflags)
     TableSampleClause *tsc = node->tablesample;
     TsmRoutine *tsm;
 
-#ifdef __AUDIT_FGA__
-    ListCell      *item;
-#endif   
-
     Assert(outerPlan(node) == NULL);
     Assert(innerPlan(node) == NULL);
 
@@ -204,21 +200,7 @@ ExecInitSampleScan(SampleScan *node, EState *estate, int eflags)
 #ifdef __AUDIT_FGA__
     if (enable_fga)
     {
-        foreach (item, node->scan.plan.audit_fga_quals)
-        {
-            AuditFgaPolicy *audit_fga_qual = (AuditFgaPolicy *) lfirst(item);
-            
-            audit_fga_policy_state * audit_fga_policy_state_item
-                    = palloc0(sizeof(audit_fga_policy_state));
-
-            audit_fga_policy_state_item->policy_name = audit_fga_qual->policy_name;
-            audit_fga_policy_state_item->query_string = audit_fga_qual->query_string;
-            audit_fga_policy_state_item->qual = 
-                ExecInitQual(audit_fga_qual->qual, (PlanState *) scanstate);
-
-            scanstate->ss.ps.audit_fga_qual = 
-                lappend(scanstate->ss.ps.audit_fga_qual, audit_fga_policy_state_item);      
-        }
+        audit_fga_init_plan_quals(&scanstate->ss.ps, node->scan.plan.audit_fga_quals);
     }
 #endif     
 
@@ -216,10 +216,6 @@ ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 	SeqScanState *scanstate;
 	bool init_ret = true;
 
-#ifdef __AUDIT_FGA__
-    ListCell      *item;
-#endif
-
 	/*
 	 * Once upon a time it was possible to have an outerPlan of a SeqScan, but
 	 * not any more.
@@ -251,21 +247,7 @@ ExecInitSeqScan(SeqScan *node, EState *estate, int eflags)
 #ifdef __AUDIT_FGA__
     if (enable_fga)
     {
-        foreach (item, node->plan.audit_fga_quals)
-        {
-            AuditFgaPolicy *audit_fga_qual = (AuditFgaPolicy *) lfirst(item);
-            
-            audit_fga_policy_state * audit_fga_policy_state_item
-                    = palloc0(sizeof(audit_fga_policy_state));
-
-            audit_fga_policy_state_item->policy_name = audit_fga_qual->policy_name;
-            audit_fga_policy_state_item->query_string = audit_fga_qual->query_string;
-            audit_fga_policy_state_item->qual = 
-                ExecInitQual(audit_fga_qual->qual, (PlanState *) scanstate);
-
-            scanstate->ss.ps.audit_fga_qual = 
-                lappend(scanstate->ss.ps.audit_fga_qual, audit_fga_policy_state_item);      
-        }
+        audit_fga_init_plan_quals(&scanstate->ss.ps, node->plan.audit_fga_quals);
     }
 #endif
 
@@ -521,10 +521,6 @@ ExecInitTidScan(TidScan *node, EState *estate, int eflags)
     TidScanState *tidstate;
     Relation    currentRelation;
 
-#ifdef __AUDIT_FGA__
-    ListCell      *item;
-#endif    
-
     /*
      * create state structure
      */
@@ -549,21 +545,7 @@ ExecInitTidScan(TidScan *node, EState *estate, int eflags)
 #ifdef __AUDIT_FGA__
     if (enable_fga)
     {
-        foreach (item, node->scan.plan.audit_fga_quals)
-        {
-            AuditFgaPolicy *audit_fga_qual = (AuditFgaPolicy *) lfirst(item);
-            
-            audit_fga_policy_state * audit_fga_policy_state_item
-                    = palloc0(sizeof(audit_fga_policy_state));
-
-            audit_fga_policy_state_item->policy_name = audit_fga_qual->policy_name;
-            audit_fga_policy_state_item->query_string = audit_fga_qual->query_string;
-            audit_fga_policy_state_item->qual = 
-                ExecInitQual(audit_fga_qual->qual, (PlanState *) tidstate);
-
-            tidstate->ss.ps.audit_fga_qual = 
-                lappend(tidstate->ss.ps.audit_fga_qual, audit_fga_policy_state_item);      
-        }
+        audit_fga_init_plan_quals(&tidstate->ss.ps, node->scan.plan.audit_fga_quals);
     }
 #endif     
 
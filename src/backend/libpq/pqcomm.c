@@ -152,6 +152,9 @@
 #include "common/ip.h"
 #include "libpq/libpq.h"
 #include "miscadmin.h"
+#ifdef __TBASE__
+#include "pgxc/pgxc.h"
+#endif
 #include "storage/ipc.h"
 #include "utils/guc.h"
 #include "utils/memutils.h"
@@ -1071,6 +1074,9 @@ pq_recvbuf(void)
         }
         /* r contains number of bytes read, so just incr length */
         PqRecvLength += r;
+#ifdef __TBASE__
+        PGXCNetBytesReceived += r;
+#endif
         return 0;
     }
 }
@@ -1562,6 +1568,9 @@ internal_flush(void)
         last_reported_send_errno = 0;    /* reset after any successful send */
         bufptr += r;
         PqSendStart += r;
+#ifdef __TBASE__
+        PGXCNetBytesSent += r;
+#endif
     }
 
     PqSendStart = PqSendPointer = 0;
@@ -3571,6 +3571,10 @@ transformAlterTableStmt(Oid relid, AlterTableStmt *stmt,
                         createpart->ofTypename = NULL;
                         createpart->oncommit = ONCOMMIT_NOOP;
                         createpart->options = NULL;
+                        /* new partitions are compressed like the existing ones */
+                        if (RelationIsPageCompressed(rel))
+                            createpart->options = list_make1(makeDefElem("page_compress",
+                                                             (Node *) makeInteger(true), -1));
                         createpart->tablespacename = NULL;
                         createpart->partbound = NULL;
                         createpart->partspec  = NULL;
@@ -26,12 +26,33 @@
 #include "nodes/nodes.h"
 #include "pgxc/pgxcnode.h"
 #include "storage/lwlock.h"
+#ifdef __TBASE__
+#include "storage/procarray.h"
+#endif
 #include "tcop/dest.h"
 
+#ifdef __TBASE__
+/*
+ * Take barriers at a GTS issued by the GTM instead of pausing 2PC commits on
+ * all Coordinators.
+ */
+bool		enable_gts_barrier = false;
+
+/* attempts at a GTS barrier before falling back to the locking protocol */
+#define GTS_BARRIER_MAX_ATTEMPTS	3
+
+/* wait for the commits below a GTS barrier to be logged, in ms */
+#define GTS_BARRIER_COMMIT_WAIT		1000
+#endif
+
 static const char *generate_barrier_id(const char *id);
 static PGXCNodeAllHandles *PrepareBarrier(const char *id);
 static void ExecuteBarrier(const char *id);
 static void EndBarrier(PGXCNodeAllHandles *handles, const char *id);
+#ifdef __TBASE__
+static bool LogBarrierGTS(const char *id, GlobalTimestamp barrier_gts);
+static bool ExecuteBarrierGTS(const char *id, GlobalTimestamp barrier_gts);
+#endif
 
 /*
  * Prepare ourselves for an incoming BARRIER. We must disable all new 2PC
@@ -120,7 +141,7 @@ ProcessCreateBarrierExecute(const char *id)
 		XLogRecPtr recptr;
 
 		XLogBeginInsert();
-		XLogRegisterData((char *) &id, strlen(id) + 1);
+		XLogRegisterData((char *) id, strlen(id) + 1);
 		recptr = XLogInsert(RM_BARRIER_ID, XLOG_BARRIER_CREATE);
 		XLogFlush(recptr);
 	}
@@ -131,6 +152,87 @@ ProcessCreateBarrierExecute(const char *id)
 	pq_flush();
 }
 
+#ifdef __TBASE__
+/*
+ * Execute a GTS barrier sent by the driving Coordinator. Nothing is paused:
+ * the record is written once the commits below the barrier GTS are logged
+ * and, if they are not in time or a commit at or above the barrier GTS may
+ * already precede it in the WAL, the barrier is reported as overtaken so that
+ * the Coordinator retries under another id.
+ */
+void
+ProcessCreateBarrierGTS(const char *id, GlobalTimestamp barrier_gts)
+{
+	StringInfoData buf;
+	bool		logged;
+
+	if (!IsConnFromCoord())
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("The CREATE BARRIER GTS message is expected to "
+						"arrive from a Coordinator")));
+
+	logged = LogBarrierGTS(id, barrier_gts);
+
+	pq_beginmessage(&buf, 'b');
+	pq_sendstring(&buf, id);
+	if (!logged)
+		pq_sendbyte(&buf, CREATE_BARRIER_GTS_OVERTAKEN);
+	pq_endmessage(&buf);
+	pq_flush();
+}
+
+/*
+ * Write and flush a GTS barrier record. Returns false if a transaction that
+ * committed at or above the barrier GTS may have been logged before it, or
+ * one below it may be logged after it, in which case recovery could not stop
+ * consistently at this barrier.
+ */
+static bool
+LogBarrierGTS(const char *id, GlobalTimestamp barrier_gts)
+{
+	xl_barrier_gts xlrec;
+	XLogRecPtr	recptr;
+	bool		overtaken;
+
+	/*
+	 * Commit GTS are not logged in GTS order: a transaction may have got a
+	 * commit GTS below the barrier's from GTM and not have logged its commit
+	 * yet.  Recovery stops before the first commit at or above the barrier
+	 * GTS, so such a commit logged after the barrier would be lost here while
+	 * kept on other nodes.  Wait for them, and for the transactions prepared
+	 * below the barrier GTS, whose commit GTS may be below it as well.
+	 */
+	if (!WaitForCommitsBelowGTS(barrier_gts, GTS_BARRIER_COMMIT_WAIT, true))
+	{
+		elog(LOG, "barrier \"%s\" overtaken by commits below global timestamp "
+			 INT64_FORMAT " not logged in time", id, barrier_gts);
+		return false;
+	}
+
+	xlrec.barrier_gts = barrier_gts;
+
+	XLogBeginInsert();
+	XLogRegisterData((char *) &xlrec, SizeOfBarrierGTS);
+	XLogRegisterData((char *) id, strlen(id) + 1);
+	recptr = XLogInsert(RM_BARRIER_ID, XLOG_BARRIER_GTS);
+
+	/*
+	 * Must be checked after the insert: a commit that published its GTS
+	 * before we reserved our WAL position is seen here.
+	 */
+	overtaken = CommitTsReachedGTS(barrier_gts);
+
+	XLogFlush(recptr);
+
+	if (overtaken)
+		elog(LOG, "barrier \"%s\" overtaken by a commit at or above "
+			 "global timestamp " INT64_FORMAT, id, barrier_gts);
+
+	return !overtaken;
+}
+#endif
+
 static const char *
 generate_barrier_id(const char *id)
 {
@@ -413,13 +515,126 @@ ExecuteBarrier(const char *id)
 		XLogRecPtr recptr;
 
 		XLogBeginInsert();
-		XLogRegisterData((char *) &id, strlen(id) + 1);
+		XLogRegisterData((char *) id, strlen(id) + 1);
 
 		recptr = XLogInsert(RM_BARRIER_ID, XLOG_BARRIER_CREATE);
 		XLogFlush(recptr);
 	}
 }
 
+#ifdef __TBASE__
+/*
+ * Log a GTS barrier on all the Datanodes and Coordinators, including this one.
+ * Returns true if every node logged it ahead of all its commits at or above
+ * barrier_gts.
+ */
+static bool
+ExecuteBarrierGTS(const char *id, GlobalTimestamp barrier_gts)
+{
+	List *barrierDataNodeList = GetAllDataNodes();
+	List *barrierCoordList = GetAllCoordNodes();
+	PGXCNodeAllHandles *conn_handles;
+	bool		consistent = true;
+	int			count;
+	int			conn;
+	int			msglen;
+	int			barrier_idlen;
+	uint32		n32;
+
+	conn_handles = get_handles(barrierDataNodeList, barrierCoordList, false, true, true);
+	count = conn_handles->co_conn_count + conn_handles->dn_conn_count;
+
+	elog(DEBUG2, "Sending CREATE BARRIER <%s> GTS " INT64_FORMAT " message to "
+				 "Datanodes and Coordinators", id, barrier_gts);
+
+	for (conn = 0; conn < count; conn++)
+	{
+		PGXCNodeHandle *handle;
+
+		if (conn < conn_handles->co_conn_count)
+			handle = conn_handles->coord_handles[conn];
+		else
+			handle = conn_handles->datanode_handles[conn - conn_handles->co_conn_count];
+
+		/* Invalid connection state, return error */
+		if (handle->state != DN_CONNECTION_STATE_IDLE)
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("Failed to send CREATE BARRIER GTS request "
+							"to the node")));
+
+		barrier_idlen = strlen(id) + 1;
+
+		msglen = 4; /* for the length itself */
+		msglen += 1; /* for barrier command itself */
+		msglen += barrier_idlen;
+		msglen += 8; /* for the barrier GTS */
+
+		/* msgType + msgLen */
+		if (ensure_out_buffer_capacity(handle->outEnd + 1 + msglen, handle) != 0)
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("Out of memory")));
+		}
+
+		handle->outBuffer[handle->outEnd++] = 'b';
+		msglen = htonl(msglen);
+		memcpy(handle->outBuffer + handle->outEnd, &msglen, 4);
+		handle->outEnd += 4;
+
+		handle->outBuffer[handle->outEnd++] = CREATE_BARRIER_GTS;
+
+		memcpy(handle->outBuffer + handle->outEnd, id, barrier_idlen);
+		handle->outEnd += barrier_idlen;
+
+		n32 = htonl((uint32) (barrier_gts >> 32));
+		memcpy(handle->outBuffer + handle->outEnd, &n32, 4);
+		handle->outEnd += 4;
+		n32 = htonl((uint32) barrier_gts);
+		memcpy(handle->outBuffer + handle->outEnd, &n32, 4);
+		handle->outEnd += 4;
+
+		PGXCNodeSetConnectionState(handle, DN_CONNECTION_STATE_QUERY);
+		pgxc_node_flush(handle);
+	}
+
+	/* Log it locally while the remote nodes do the same */
+	if (!LogBarrierGTS(id, barrier_gts))
+		consistent = false;
+
+	/* Collect every reply, even after one of them reported a conflict */
+	for (conn = 0; conn < count; conn++)
+	{
+		PGXCNodeHandle *handle;
+		int			res;
+
+		if (conn < conn_handles->co_conn_count)
+			handle = conn_handles->coord_handles[conn];
+		else
+			handle = conn_handles->datanode_handles[conn - conn_handles->co_conn_count];
+
+		if (pgxc_node_receive(1, &handle, NULL))
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("Failed to receive response from the remote side")));
+
+		res = handle_response(handle, NULL);
+		if (res == RESPONSE_BARRIER_OVERTAKEN)
+			consistent = false;
+		else if (res != RESPONSE_BARRIER_OK)
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("CREATE BARRIER GTS command failed "
+							"with error %s", handle->error)));
+	}
+
+	pfree_pgxc_all_handles(conn_handles);
+
+	return consistent;
+}
+#endif
+
 /*
  * Resume 2PC commits on the local as well as remote Coordinators.
  */
@@ -462,6 +677,53 @@ RequestBarrier(const char *id, char *completionTag)
 
 	elog(DEBUG2, "CREATE BARRIER <%s>", barrier_id);
 
+#ifdef __TBASE__
+	/*
+	 * A GTS barrier needs no pause: recovery stops before the first commit at
+	 * or above the barrier GTS, and each node logs the barrier after the
+	 * commits below it. A node that has already logged a commit at or above
+	 * it when the barrier reaches it, or whose commits below it are not
+	 * logged in time, makes the attempt unusable, and its records
+	 * stay in the WAL, so every retry logs the barrier under a fresh id and
+	 * GTS. If all attempts are overtaken, fall back to the locking protocol.
+	 */
+	if (enable_gts_barrier)
+	{
+		int			attempt;
+
+		for (attempt = 1; attempt <= GTS_BARRIER_MAX_ATTEMPTS; attempt++)
+		{
+			const char *attempt_id = barrier_id;
+			GlobalTimestamp barrier_gts;
+
+			if (attempt > 1)
+				attempt_id = psprintf("%s_%d", barrier_id, attempt);
+
+			barrier_gts = GetGlobalTimestampGTM();
+			if (!GlobalTimestampIsValid(barrier_gts))
+				ereport(ERROR,
+						(errcode(ERRCODE_CONNECTION_FAILURE),
+						 errmsg("could not get a global timestamp for barrier \"%s\" from GTM",
+								attempt_id)));
+
+			if (ExecuteBarrierGTS(attempt_id, barrier_gts))
+			{
+				ReportBarrierGTM(attempt_id);
+
+				if (completionTag)
+					snprintf(completionTag, COMPLETION_TAG_BUFSIZE, "BARRIER %s", attempt_id);
+				return;
+			}
+
+			elog(LOG, "GTS barrier \"%s\" was overtaken, attempt %d of %d",
+				 attempt_id, attempt, GTS_BARRIER_MAX_ATTEMPTS);
+		}
+
+		barrier_id = psprintf("%s_%d", barrier_id, attempt);
+		elog(LOG, "taking barrier \"%s\" with 2PC commits paused", barrier_id);
+	}
+#endif
+
 	/*
 	 * Step One. Prepare all Coordinators for upcoming barrier request
 	 */
@@ -45,6 +45,12 @@
 #endif
 bool enable_multi_cluster = true;
 bool enable_multi_cluster_print = false;
+#ifdef __TBASE__
+/* Route read-only transactions to standby datanodes of other planes. */
+bool enable_standby_read_routing = false;
+/* How often the pooler polls standby datanodes for their replayed GTS, ms. */
+int  standby_read_refresh_interval = 1000;
+#endif
 
 /*
  * How many times should we try to find a unique indetifier
@@ -652,13 +658,33 @@ PgxcNodeListAndCount(void)
         int i;
 
 #ifdef __TBASE__
+        bool is_standby = false;
+
         if(enable_multi_cluster && strcmp(NameStr(nodeForm->node_cluster_name), PGXCClusterName))
-            continue;
+        {
+            /*
+             * Coordinators of the main plane may read from the datanodes of
+             * the other planes, which are standbys of the datanodes of the
+             * same name.
+             */
+            if (!enable_standby_read_routing ||
+                !IS_PGXC_COORDINATOR ||
+                nodeForm->node_type != PGXC_NODE_DATANODE ||
+                PGXCMainClusterName == NULL ||
+                strcmp(PGXCClusterName, PGXCMainClusterName) != 0)
+                continue;
+            is_standby = true;
+        }
 #endif
         if (PGXC_NODE_GTM == nodeForm->node_type)
             continue;
         
         /* Take definition for given node type */
+#ifdef __TBASE__
+        if (is_standby)
+            node = &sdnDefs[(*shmemNumSlaveDataNodes)++];
+        else
+#endif
         switch (nodeForm->node_type)
         {
             case PGXC_NODE_COORDINATOR:
@@ -704,11 +730,17 @@ PgxcNodeListAndCount(void)
          * entry for a nodeoid, we mark it as healthy
          */
         node->nodeishealthy = true;
+#ifdef __TBASE__
+        node->nodereplaygts = InvalidGlobalTimestamp;
+#endif
         for (i = 0; i < numNodes; i++)
         {
             if (nodes[i].nodeoid == node->nodeoid)
             {
                 node->nodeishealthy = nodes[i].nodeishealthy;
+#ifdef __TBASE__
+                node->nodereplaygts = nodes[i].nodereplaygts;
+#endif
                 break;
             }
         }
@@ -1134,6 +1166,101 @@ PgxcNodeUpdateHealth(Oid node, bool status)
     return false;
 }
 
+#ifdef __TBASE__
+/*
+ * PgxcNodeGetPoolOids
+ *
+ * Like PgxcNodeGetOids, but the standby datanodes follow the datanodes in
+ * dnOids, the way the pooler numbers them.
+ */
+void
+PgxcNodeGetPoolOids(Oid **coOids, Oid **dnOids, int *num_coords, int *num_dns)
+{
+    int i;
+
+    LWLockAcquire(NodeTableLock, LW_SHARED);
+
+    if (num_coords)
+        *num_coords = *shmemNumCoords;
+    if (num_dns)
+        *num_dns = *shmemNumDataNodes + *shmemNumSlaveDataNodes;
+
+    if (coOids)
+    {
+        *coOids = (Oid *) palloc(*shmemNumCoords * sizeof(Oid));
+        for (i = 0; i < *shmemNumCoords; i++)
+            (*coOids)[i] = coDefs[i].nodeoid;
+    }
+
+    if (dnOids)
+    {
+        *dnOids = (Oid *) palloc((*shmemNumDataNodes + *shmemNumSlaveDataNodes) *
+                                 sizeof(Oid));
+        for (i = 0; i < *shmemNumDataNodes; i++)
+            (*dnOids)[i] = dnDefs[i].nodeoid;
+        for (i = 0; i < *shmemNumSlaveDataNodes; i++)
+            (*dnOids)[*shmemNumDataNodes + i] = sdnDefs[i].nodeoid;
+    }
+
+    LWLockRelease(NodeTableLock);
+}
+
+/*
+ * PgxcNodeUpdateReplayGTS
+ *
+ * Record the GTS a standby datanode has replayed up to.
+ */
+bool
+PgxcNodeUpdateReplayGTS(Oid node, GlobalTimestamp gts)
+{
+    bool             found;
+    NodeDefLookupTag tag;
+    NodeDefLookupEnt *ent;
+
+    tag.nodeoid = node;
+
+    LWLockAcquire(NodeTableLock, LW_EXCLUSIVE);
+
+    ent = (NodeDefLookupEnt*)hash_search(g_NodeDefHashTab, (void *) &tag, HASH_FIND, &found);
+    if (found && sdnDefs[ent->nodeDefIndex].nodeoid == node)
+    {
+        sdnDefs[ent->nodeDefIndex].nodereplaygts = gts;
+        LWLockRelease(NodeTableLock);
+        return true;
+    }
+
+    LWLockRelease(NodeTableLock);
+    return false;
+}
+
+/*
+ * PgxcNodeGetReplayGTS
+ *
+ * GTS a standby datanode has replayed up to, or InvalidGlobalTimestamp if
+ * unknown.
+ */
+GlobalTimestamp
+PgxcNodeGetReplayGTS(Oid node)
+{
+    bool             found;
+    NodeDefLookupTag tag;
+    NodeDefLookupEnt *ent;
+    GlobalTimestamp  gts = InvalidGlobalTimestamp;
+
+    tag.nodeoid = node;
+
+    LWLockAcquire(NodeTableLock, LW_SHARED);
+
+    ent = (NodeDefLookupEnt*)hash_search(g_NodeDefHashTab, (void *) &tag, HASH_FIND, &found);
+    if (found && sdnDefs[ent->nodeDefIndex].nodeoid == node &&
+        sdnDefs[ent->nodeDefIndex].nodeishealthy)
+        gts = sdnDefs[ent->nodeDefIndex].nodereplaygts;
+
+    LWLockRelease(NodeTableLock);
+    return gts;
+}
+#endif
+
 /*
  * PgxcNodeCreate
  *
@@ -39,6 +39,7 @@
 #include "nodes/nodes.h"
 #include "nodes/nodeFuncs.h"
 #include "optimizer/var.h"
+#include "pgxc/barrier.h"
 #include "pgxc/copyops.h"
 #include "pgxc/nodemgr.h"
 #include "pgxc/poolmgr.h"
@@ -3172,6 +3173,7 @@ pgxc_node_receive_responses(const int conn_count, PGXCNodeHandle ** connections,
  * RESPONSE_DATAROW - got data row
  * RESPONSE_COPY - got copy response
  * RESPONSE_BARRIER_OK - barrier command completed successfully
+ * RESPONSE_BARRIER_OVERTAKEN - GTS barrier was overtaken by a later commit
  */
 int
 handle_response(PGXCNodeHandle *conn, ResponseCombiner *combiner)
@@ -3427,6 +3429,12 @@ handle_response(PGXCNodeHandle *conn, ResponseCombiner *combiner)
                 
             case 'b':
                 PGXCNodeSetConnectionState(conn, DN_CONNECTION_STATE_IDLE);
+#ifdef __TBASE__
+                /* barrier id, optionally followed by a status byte */
+                if (msg_len > strlen(msg) + 1 &&
+                    msg[strlen(msg) + 1] == CREATE_BARRIER_GTS_OVERTAKEN)
+                    return RESPONSE_BARRIER_OVERTAKEN;
+#endif
                 return RESPONSE_BARRIER_OK;
                 
             case 'I':            /* EmptyQuery */
@@ -6749,14 +6757,23 @@ pgxc_start_command_on_connection(PGXCNodeHandle *connection,
         bool    prepared = false;
         char    nodetype = PGXC_NODE_DATANODE;
 		ExecNodes *exec_nodes = step->exec_nodes;
+		char   *statement = step->statement;
 
         /* if prepared statement is referenced see if it is already
          * exist */
 		if (exec_nodes && exec_nodes->need_rewrite == true)
 			prepared = false;
-		if (step->statement)
+#ifdef __TBASE__
+		/*
+		 * Statements prepared on datanodes are tracked by datanode index,
+		 * a standby serving reads gets the query text every time.
+		 */
+		if (connection->node_type == PGXC_NODE_SLAVEDATANODE)
+			statement = NULL;
+#endif
+		if (statement)
             prepared =
-                ActivateDatanodeStatementOnNode(step->statement,
+                ActivateDatanodeStatementOnNode(statement,
                         PGXCNodeGetNodeId(connection->nodeoid,
                             &nodetype));
 		if (prepared && exec_nodes && exec_nodes->need_rewrite == true)
@@ -6782,7 +6799,7 @@ pgxc_start_command_on_connection(PGXCNodeHandle *connection,
 
         if (pgxc_node_send_query_extended(connection,
                             prepared ? NULL : step->sql_statement,
-                            step->statement,
+                            statement,
                             step->cursor,
                             remotestate->rqs_num_params,
                             remotestate->rqs_param_types,
@@ -7649,8 +7666,8 @@ PreAbort_Remote(TranscationType txn_type, bool need_release_handle)
 		return true;
 	}
 
-    clean_nodes = (PGXCNodeHandle**)palloc(sizeof(PGXCNodeHandle*) * (NumCoords + NumDataNodes));
-    cancel_dn_list = (int*)palloc(sizeof(int) * NumDataNodes);
+    clean_nodes = (PGXCNodeHandle**)palloc(sizeof(PGXCNodeHandle*) * (NumCoords + NumDataNodes + NumSlaveDataNodes));
+    cancel_dn_list = (int*)palloc(sizeof(int) * (NumDataNodes + NumSlaveDataNodes));
     cancel_co_list = (int*)palloc(sizeof(int) * NumCoords);
 
 
@@ -7773,7 +7790,7 @@ PreAbort_Remote(TranscationType txn_type, bool need_release_handle)
                 if ('E' != handle->transaction_status)
                 {
                     clean_nodes[node_count++] = handle;                
-                    cancel_dn_list[cancel_dn_count++] = PGXCNodeGetNodeId(handle->nodeoid, NULL);
+                    cancel_dn_list[cancel_dn_count++] = PGXCNodeGetPoolIndex(handle);
                 }
 #endif				
 			}
@@ -7785,7 +7802,7 @@ PreAbort_Remote(TranscationType txn_type, bool need_release_handle)
 				 */
 				handle->combiner = NULL;
 				clean_nodes[node_count++] = handle;				
-				cancel_dn_list[cancel_dn_count++] = PGXCNodeGetNodeId(handle->nodeoid, NULL);
+				cancel_dn_list[cancel_dn_count++] = PGXCNodeGetPoolIndex(handle);
 #ifdef _PG_REGRESS_	
 				ereport(LOG,
 						(errcode(ERRCODE_INTERNAL_ERROR),
@@ -9015,6 +9032,13 @@ ExecRemoteQuery(PlanState *pstate)
         bool            need_tran_block;
         PGXCNodeAllHandles *pgxc_connections;
 
+#ifdef __TBASE__
+        /* plain reads may be served by standby datanodes */
+        if (step->exec_type == EXEC_ON_DATANODES && step->read_only &&
+            !step->has_row_marks)
+            PGXCNodeRequestStandbyRead();
+#endif
+
         /*
          * Get connections for Datanodes only, utilities and DDLs
          * are launched in ExecRemoteUtility
@@ -10876,6 +10900,30 @@ encode_epqcontext(PlanState *planstate, char **result)
 	return buf.len;
 }
 
+#ifdef __TBASE__
+/*
+ * Account the network waits and traffic of one ExecRemoteSubplan call, and
+ * the time it took to get the first tuple, for EXPLAIN ANALYZE.
+ */
+static void
+RemoteSubplanNetworkAccum(RemoteSubplanState *node, TupleTableSlot *slot,
+                          double recv_wait_start, uint64 bytes_recv_start)
+{
+    node->net.recv_wait += PGXCNetRecvWaitTime - recv_wait_start;
+    node->net.bytes_recv += PGXCNetBytesReceived - bytes_recv_start;
+
+    if (!node->net_got_tuple && !TupIsNull(slot))
+    {
+        instr_time    now;
+
+        INSTR_TIME_SET_CURRENT(now);
+        INSTR_TIME_SUBTRACT(now, node->net_start);
+        node->net.firsttuple = INSTR_TIME_GET_DOUBLE(now);
+        node->net_got_tuple = true;
+    }
+}
+#endif
+
 TupleTableSlot *
 ExecRemoteSubplan(PlanState *pstate)
 {// #lizard forgives
@@ -10888,6 +10936,8 @@ ExecRemoteSubplan(PlanState *pstate)
     struct timeval        start_t;
 #ifdef __TBASE__
     int count = 0;
+    double      recv_wait_start = 0;
+    uint64      bytes_recv_start = 0;
 #endif
 #ifdef __TBASE__
 	if ((node->eflags & EXEC_FLAG_EXPLAIN_ONLY) != 0)
@@ -10922,6 +10972,16 @@ ExecRemoteSubplan(PlanState *pstate)
     if (log_remotesubplan_stats)
         ResetUsageCommon(&start_r, &start_t);
 
+#ifdef __TBASE__
+    if (combiner->ss.ps.instrument)
+    {
+        recv_wait_start = PGXCNetRecvWaitTime;
+        bytes_recv_start = PGXCNetBytesReceived;
+        if (INSTR_TIME_IS_ZERO(node->net_start))
+            INSTR_TIME_SET_CURRENT(node->net_start);
+    }
+#endif
+
 primary_mode_phase_two:
     if (!node->bound)
     {
@@ -11228,6 +11288,11 @@ primary_mode_phase_two:
         {
             if (log_remotesubplan_stats)
                 ShowUsageCommon("ExecRemoteSubplan", &start_r, &start_t);
+#ifdef __TBASE__
+            if (combiner->ss.ps.instrument)
+                RemoteSubplanNetworkAccum(node, resultslot,
+                                          recv_wait_start, bytes_recv_start);
+#endif
             return resultslot;
         }
     }
@@ -11238,6 +11303,11 @@ primary_mode_phase_two:
         {
             if (log_remotesubplan_stats)
                 ShowUsageCommon("ExecRemoteSubplan", &start_r, &start_t);
+#ifdef __TBASE__
+            if (combiner->ss.ps.instrument)
+                RemoteSubplanNetworkAccum(node, slot,
+                                          recv_wait_start, bytes_recv_start);
+#endif
             return slot;
         }
         else if (combiner->probing_primary)
@@ -11260,6 +11330,10 @@ primary_mode_phase_two:
                     combiner->recv_tuples ? ((double)combiner->recv_total_time)/
                     ((double)combiner->recv_tuples) : -1);
     }
+
+    if (combiner->ss.ps.instrument)
+        RemoteSubplanNetworkAccum(node, NULL,
+                                  recv_wait_start, bytes_recv_start);
 #endif
     return NULL;
 }
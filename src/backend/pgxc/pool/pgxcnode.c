@@ -39,6 +39,7 @@
 #include "commands/prepare.h"
 #include "gtm/gtm_c.h"
 #include "nodes/nodes.h"
+#include "pgstat.h"
 #include "pgxc/pgxcnode.h"
 #include "pgxc/execRemote.h"
 #include "catalog/pgxc_node.h"
@@ -70,7 +71,9 @@
 #include "catalog/pg_authid.h"
 #endif
 #ifdef __TBASE__
+#include "gtm/gtm_gxid.h"
 #include "postmaster/postmaster.h"
+#include "storage/proc.h"
 #endif
 
 #define CMD_ID_MSG_LEN 8
@@ -90,6 +93,19 @@ static int  slavedatanode_count = 0;
  */
 static PGXCNodeHandle *dn_handles = NULL;
 static PGXCNodeHandle *sdn_handles = NULL;
+#ifdef __TBASE__
+/* Index in dn_handles of the datanode each standby datanode replicates */
+static int *sdn_master = NULL;
+/* Next choice among a datanode and its standbys for read-only queries */
+static uint32 standby_read_next = 0;
+/* The next get_handles() may route datanode reads to standbys */
+static bool standby_read_requested = false;
+/* Snapshot timestamp the reads of a transaction were moved back to */
+static LocalTransactionId standby_read_lxid = InvalidLocalTransactionId;
+static GlobalTimestamp standby_read_xact_ts = InvalidGlobalTimestamp;
+/* When the last transaction of this session that wrote on datanodes ended */
+static TimestampTz standby_read_last_write = 0;
+#endif
 
 /*
  * Coordinator handles saved in Transaction memory context
@@ -344,7 +360,7 @@ InitMultinodeExecutor(bool is_force)
                 NAMEDATALEN);
         sdn_handles[count].nodeport = get_pgxc_nodeport(sdnOids[count]);
         
-        elog(DEBUG1, "sdn handle %d nodename %s nodehost %s nodeport %d Oid %d", count, dn_handles[count].nodename,
+        elog(DEBUG1, "sdn handle %d nodename %s nodehost %s nodeport %d Oid %d", count, sdn_handles[count].nodename,
             sdn_handles[count].nodehost, sdn_handles[count].nodeport, sdnOids[count]);
 
 #ifdef __TBASE__
@@ -363,6 +379,28 @@ InitMultinodeExecutor(bool is_force)
 #endif        
         
     }
+
+#ifdef __TBASE__
+    if (NumSlaveDataNodes > 0)
+    {
+        int i;
+
+        sdn_master = (int *) palloc(NumSlaveDataNodes * sizeof(int));
+        for (count = 0; count < NumSlaveDataNodes; count++)
+        {
+            sdn_master[count] = -1;
+            for (i = 0; i < NumDataNodes; i++)
+            {
+                if (strcmp(sdn_handles[count].nodename, dn_handles[i].nodename) == 0)
+                {
+                    sdn_master[count] = i;
+                    break;
+                }
+            }
+        }
+        standby_read_next = (uint32) MyProcPid;
+    }
+#endif
         
     for (count = 0; count < NumCoords; count++)
     {
@@ -657,6 +695,11 @@ pgxc_node_all_free(void)
     co_handles = NULL;
     dn_handles = NULL;
     sdn_handles = NULL;
+#ifdef __TBASE__
+    if (sdn_master)
+        pfree(sdn_master);
+    sdn_master = NULL;
+#endif
     HandlesInvalidatePending = false;
     HandlesRefreshPending = false;
 }
@@ -780,6 +823,10 @@ pgxc_node_receive(const int conn_count,
     bool    is_msg_buffered;
     long     timeout_ms;
     struct    pollfd pool_fd[conn_count];
+#ifdef __TBASE__
+    instr_time    wait_start;
+    instr_time    wait_time;
+#endif
 
     /* sockets to be polled index */
     sockets_to_poll = 0;
@@ -855,7 +902,17 @@ pgxc_node_receive(const int conn_count,
 
 retry:
 	CHECK_FOR_INTERRUPTS();
+    pgstat_report_wait_start(WAIT_EVENT_REMOTE_RECEIVE);
+#ifdef __TBASE__
+    INSTR_TIME_SET_CURRENT(wait_start);
+#endif
     poll_val  = poll(pool_fd, conn_count, timeout_ms);
+#ifdef __TBASE__
+    INSTR_TIME_SET_CURRENT(wait_time);
+    INSTR_TIME_SUBTRACT(wait_time, wait_start);
+    PGXCNetRecvWaitTime += INSTR_TIME_GET_DOUBLE(wait_time);
+#endif
+    pgstat_report_wait_end();
     if (poll_val < 0)
     {
         /* error - retry if EINTR */
@@ -1256,6 +1313,9 @@ retry:
     if (nread > 0)
     {
         conn->inEnd += nread;
+#ifdef __TBASE__
+        PGXCNetBytesReceived += nread;
+#endif
 
         /*
          * Hack to deal with the fact that some kernels will only give us back
@@ -1971,6 +2031,9 @@ send_some(PGXCNodeHandle *handle, int len)
             ptr += sent;
             len -= sent;
             remaining -= sent;
+#ifdef __TBASE__
+            PGXCNetBytesSent += sent;
+#endif
         }
 
         if (len > 0)
@@ -2561,6 +2624,19 @@ pgxc_node_send_my_sync(PGXCNodeHandle * handle)
  */
 int
 pgxc_node_send_apply(PGXCNodeHandle * handle, char * buf, int len, bool ignore_pk_conflict)
+{
+    if (pgxc_node_queue_apply(handle, buf, len, ignore_pk_conflict))
+        return EOF;
+
+    return pgxc_node_flush(handle);
+}
+
+/*
+ * Append logical apply message to the output buffer of the Datanode
+ * connection without flushing it, so that several messages go out together.
+ */
+int
+pgxc_node_queue_apply(PGXCNodeHandle * handle, char * buf, int len, bool ignore_pk_conflict)
 {
     int    msgLen = 0;
 
@@ -2591,7 +2667,7 @@ pgxc_node_send_apply(PGXCNodeHandle * handle, char * buf, int len, bool ignore_p
     PGXCNodeSetConnectionState(handle, DN_CONNECTION_STATE_QUERY);
 
     handle->in_extended_query = false;
-     return pgxc_node_flush(handle);
+    return 0;
 }
 #endif
 
@@ -3498,9 +3574,10 @@ int
 pgxc_node_send_sessionid(PGXCNodeHandle * handle)
 {
 	int	msgLen = 0;
+	uint32 queryid;
 	
-	/* size + sessionid_str + '\0' */
-	msgLen = 4 + strlen(PGXCSessionId) + 1;
+	/* size + sessionid_str + '\0' + queryid */
+	msgLen = 4 + strlen(PGXCSessionId) + 1 + 4;
 	
 	/* msgType + msgLen */
 	if (ensure_out_buffer_capacity(handle->outEnd + 1 + msgLen, handle) != 0)
@@ -3517,6 +3594,11 @@ pgxc_node_send_sessionid(PGXCNodeHandle * handle)
 	
 	memcpy(handle->outBuffer + handle->outEnd, PGXCSessionId, strlen(PGXCSessionId) + 1);
 	handle->outEnd += strlen(PGXCSessionId) + 1;
+	
+	/* statistics of the remote node are accounted to our query id */
+	queryid = htonl(PGXCQueryId);
+	memcpy(handle->outBuffer + handle->outEnd, &queryid, 4);
+	handle->outEnd += 4;
 	return 0;
 }
 #endif
@@ -3786,6 +3868,173 @@ get_any_handle(List *datanodelist)
     return NULL;
 }
 
+#ifdef __TBASE__
+/*
+ * Ask the next get_handles() to serve datanode reads from standby datanodes
+ * when it can.  The caller must only read through the handles it gets.
+ */
+void
+PGXCNodeRequestStandbyRead(void)
+{
+    standby_read_requested = true;
+}
+
+/*
+ * Note the commit of a transaction that may have written on the datanodes.
+ * Called once the datanodes have committed it.
+ */
+void
+PGXCNodeNoteCommit(void)
+{
+    int i;
+
+    if (!enable_standby_read_routing || current_transaction_handles == NULL)
+        return;
+
+    for (i = 0; i < current_transaction_handles->dn_conn_count; i++)
+    {
+        if (!current_transaction_handles->datanode_handles[i]->read_only)
+        {
+            standby_read_last_write = GetCurrentTimestamp();
+            return;
+        }
+    }
+}
+
+/*
+ * Snapshot timestamp a standby must have replayed to serve the reads of the
+ * current statement, or InvalidGlobalTimestamp if they must go to the
+ * datanodes.
+ *
+ * A fresh snapshot is newer than anything a standby has replayed, so reads
+ * may only go to standbys at a snapshot standby_plane_query_delay seconds in
+ * the past; get_handles() moves the snapshot back when it picks a standby.
+ * Not if this session wrote on the datanodes in the meantime: it would not
+ * see its own writes.  GTS follow the clock of GTM, so comparing against the
+ * start of the transaction, before its snapshot was taken, is enough.  A
+ * transaction snapshot cannot move once the datanodes have read with it.
+ */
+static GlobalTimestamp
+get_standby_read_ts(void)
+{
+    Snapshot snapshot;
+    GlobalTimestamp interval;
+
+    if (!enable_standby_read_routing || sdn_master == NULL || query_delay <= 0 ||
+        !IS_PGXC_LOCAL_COORDINATOR || !XactReadOnly || !ActiveSnapshotSet())
+        return InvalidGlobalTimestamp;
+
+    snapshot = GetActiveSnapshot();
+    if (snapshot->local || !GlobalTimestampIsValid(snapshot->start_ts))
+        return InvalidGlobalTimestamp;
+
+    /* already moved back for an earlier read of this transaction */
+    if (standby_read_lxid == MyProc->lxid &&
+        snapshot->start_ts == standby_read_xact_ts)
+        return snapshot->start_ts;
+
+    if (standby_read_last_write != 0 &&
+        !TimestampDifferenceExceeds(standby_read_last_write,
+                                    GetCurrentTransactionStartTimestamp(),
+                                    query_delay * 1000))
+        return InvalidGlobalTimestamp;
+
+    if (IsolationUsesXactSnapshot() && current_transaction_handles != NULL &&
+        current_transaction_handles->dn_conn_count > 0)
+        return InvalidGlobalTimestamp;
+
+    interval = (GlobalTimestamp) query_delay * USECS_PER_SEC;
+    if (snapshot->start_ts - interval < FirstGlobalTimestamp)
+        return InvalidGlobalTimestamp;
+
+    return snapshot->start_ts - interval;
+}
+
+/*
+ * Move the snapshot of the current statement, and the transaction snapshot if
+ * the isolation level keeps one, back to read_ts, once a standby has been
+ * picked to serve reads at it.
+ */
+static void
+standby_read_move_snapshot(GlobalTimestamp read_ts)
+{
+    Snapshot snapshot = GetActiveSnapshot();
+
+    if (snapshot->start_ts == read_ts)
+        return;
+
+    if (IsolationUsesXactSnapshot())
+    {
+        Snapshot xact_snapshot = GetTransactionSnapshot();
+
+        if (xact_snapshot->start_ts == snapshot->start_ts)
+            xact_snapshot->start_ts = read_ts;
+    }
+    snapshot->start_ts = read_ts;
+
+    standby_read_lxid = MyProc->lxid;
+    standby_read_xact_ts = read_ts;
+}
+
+/*
+ * Handle serving the reads of datanode 'node': the datanode itself or one of
+ * its standbys that has replayed up to 'read_ts'.  A node already connected
+ * in this session is preferred, otherwise the choice rotates over all
+ * candidates.  *poolidx is set to the index the pooler knows the node by.
+ */
+static PGXCNodeHandle *
+get_read_handle(int node, GlobalTimestamp read_ts, int *poolidx)
+{
+    int  *candidates;
+    int   ncandidates = 0;
+    int   pick;
+    int   j;
+
+    *poolidx = node;
+    if (!GlobalTimestampIsValid(read_ts))
+        return &dn_handles[node];
+
+    candidates = (int *) palloc(NumSlaveDataNodes * sizeof(int));
+    for (j = 0; j < NumSlaveDataNodes; j++)
+    {
+        GlobalTimestamp replay_ts;
+
+        if (sdn_master[j] != node)
+            continue;
+
+        replay_ts = PgxcNodeGetReplayGTS(sdn_handles[j].nodeoid);
+        if (!GlobalTimestampIsValid(replay_ts) || replay_ts < read_ts)
+            continue;
+
+        if (sdn_handles[j].sock != NO_SOCKET)
+        {
+            pfree(candidates);
+            *poolidx = NumDataNodes + j;
+            return &sdn_handles[j];
+        }
+        candidates[ncandidates++] = j;
+    }
+
+    if (dn_handles[node].sock != NO_SOCKET || ncandidates == 0)
+    {
+        pfree(candidates);
+        return &dn_handles[node];
+    }
+
+    pick = standby_read_next++ % (ncandidates + 1);
+    if (pick < ncandidates)
+    {
+        j = candidates[pick];
+        pfree(candidates);
+        *poolidx = NumDataNodes + j;
+        return &sdn_handles[j];
+    }
+
+    pfree(candidates);
+    return &dn_handles[node];
+}
+#endif
+
 /*
  * for specified list return array of PGXCNodeHandles
  * acquire from pool if needed.
@@ -3807,6 +4056,17 @@ get_handles(List *datanodelist, List *coordlist, bool is_coord_only_query, bool
 
     /* index of the result array */
     int            i = 0;
+#ifdef __TBASE__
+    GlobalTimestamp read_ts = InvalidGlobalTimestamp;
+    int            poolidx;
+    bool        standby_picked = false;
+
+    if (standby_read_requested)
+    {
+        standby_read_requested = false;
+        read_ts = get_standby_read_ts();
+    }
+#endif
 
     if (HandlesRefreshPending)
         if (DoRefreshRemoteHandles())
@@ -3852,10 +4112,18 @@ get_handles(List *datanodelist, List *coordlist, bool is_coord_only_query, bool
 
             for (i = 0; i < NumDataNodes; i++)
             {
+#ifdef __TBASE__
+                node_handle = get_read_handle(i, read_ts, &poolidx);
+                standby_picked |= (poolidx >= NumDataNodes);
+                result->datanode_handles[i] = node_handle;
+                if (node_handle->sock == NO_SOCKET)
+                    dn_allocate = lappend_int(dn_allocate, poolidx);
+#else
                 node_handle = &dn_handles[i];
                 result->datanode_handles[i] = node_handle;
                 if (node_handle->sock == NO_SOCKET)
                     dn_allocate = lappend_int(dn_allocate, i);
+#endif
             }
         }
         else
@@ -3886,14 +4154,27 @@ get_handles(List *datanodelist, List *coordlist, bool is_coord_only_query, bool
                             errmsg("Invalid Datanode number, node number %d, max nodes %d", node, NumDataNodes)));
                 }
 
+#ifdef __TBASE__
+                node_handle = get_read_handle(node, read_ts, &poolidx);
+                standby_picked |= (poolidx >= NumDataNodes);
+                result->datanode_handles[i++] = node_handle;
+                if (node_handle->sock == NO_SOCKET)
+                    dn_allocate = lappend_int(dn_allocate, poolidx);
+#else
                 node_handle = &dn_handles[node];
                 result->datanode_handles[i++] = node_handle;
                 if (node_handle->sock == NO_SOCKET)
                     dn_allocate = lappend_int(dn_allocate, node);
+#endif
             }
         }
     }
 
+#ifdef __TBASE__
+    if (standby_picked)
+        standby_read_move_snapshot(read_ts);
+#endif
+
     /*
      * Get Handles for Coordinators
      * If node list is empty execute request on current nodes
@@ -4024,6 +4305,20 @@ get_handles(List *datanodelist, List *coordlist, bool is_coord_only_query, bool
                 int            fdsock = fds[j];
                 int            be_pid = pids[j++];
 
+#ifdef __TBASE__
+                if (node < 0 || node >= NumDataNodes + NumSlaveDataNodes)
+                {
+                    ereport(ERROR,
+                            (errcode(ERRCODE_INTERNAL_ERROR),
+                            errmsg("Invalid Datanode number, node number %d, max nodes %d", node, NumDataNodes + NumSlaveDataNodes)));
+                }
+
+                /* numbers past the datanodes are standbys serving reads */
+                if (node >= NumDataNodes)
+                    node_handle = &sdn_handles[node - NumDataNodes];
+                else
+                    node_handle = &dn_handles[node];
+#else
                 if (node < 0 || node >= NumDataNodes)
                 {
                     ereport(ERROR,
@@ -4032,6 +4327,7 @@ get_handles(List *datanodelist, List *coordlist, bool is_coord_only_query, bool
                 }
 
                 node_handle = &dn_handles[node];
+#endif
 				
 				if (be_pid == 0 && !raise_error)
 				{
@@ -4040,7 +4336,11 @@ get_handles(List *datanodelist, List *coordlist, bool is_coord_only_query, bool
 				}
 				
 				pgxc_node_init(node_handle, fdsock, is_global_session, be_pid);
-                dn_handles[node] = *node_handle;
+#ifdef __TBASE__
+                if (node >= NumDataNodes)
+                    slavedatanode_count++;
+                else
+#endif
                 datanode_count++;
 
                 elog(DEBUG1, "Established a connection with datanode \"%s\","
@@ -4054,7 +4354,8 @@ get_handles(List *datanodelist, List *coordlist, bool is_coord_only_query, bool
                         is_global_session ? 'T' : 'F');
 #endif
 
-				if (IS_PGXC_COORDINATOR)
+				if (IS_PGXC_COORDINATOR &&
+					node_handle->node_type == PGXC_NODE_DATANODE)
 				{
 					char nodetype = PGXC_NODE_DATANODE;
 					int nodeidx = PGXCNodeGetNodeId(node_handle->nodeoid, &nodetype);
@@ -4246,7 +4547,7 @@ get_current_dn_handles_internal(PGXCNodeAllHandles *result)
     int					i;
 
     result->datanode_handles = (PGXCNodeHandle **)
-            palloc(NumDataNodes * sizeof(PGXCNodeHandle *));
+            palloc((NumDataNodes + NumSlaveDataNodes) * sizeof(PGXCNodeHandle *));
     if (!result->datanode_handles)
     {
         ereport(ERROR,
@@ -4263,6 +4564,16 @@ get_current_dn_handles_internal(PGXCNodeAllHandles *result)
             result->datanode_handles[result->dn_conn_count++] = node_handle;
         }
     }
+
+    /* standby datanodes serving reads of this session */
+    for (i = 0; i < NumSlaveDataNodes; i++)
+    {
+        node_handle = &sdn_handles[i];
+        if (node_handle->sock != NO_SOCKET)
+        {
+            result->datanode_handles[result->dn_conn_count++] = node_handle;
+        }
+    }
 }
 
 /* get current transaction dn handles that register in pgxc_node_begin */
@@ -4421,11 +4732,11 @@ init_transaction_handles(void)
     current_transaction_handles->dn_conn_count = 0;
     if (current_transaction_handles->datanode_handles == NULL)
     {
-        current_transaction_handles->datanode_handles = (PGXCNodeHandle **) palloc(NumDataNodes * sizeof(PGXCNodeHandle *));
+        current_transaction_handles->datanode_handles = (PGXCNodeHandle **) palloc((NumDataNodes + NumSlaveDataNodes) * sizeof(PGXCNodeHandle *));
     }
     else
     {
-        current_transaction_handles->datanode_handles = (PGXCNodeHandle **) repalloc(current_transaction_handles->datanode_handles, NumDataNodes * sizeof(PGXCNodeHandle *));
+        current_transaction_handles->datanode_handles = (PGXCNodeHandle **) repalloc(current_transaction_handles->datanode_handles, (NumDataNodes + NumSlaveDataNodes) * sizeof(PGXCNodeHandle *));
     }
 
     current_transaction_handles->co_conn_count = 0;
@@ -4473,7 +4784,7 @@ register_transaction_handles(PGXCNodeHandle* handle)
 
     Assert (current_transaction_handles != NULL);
 
-    if (node_type == PGXC_NODE_DATANODE)
+    if (node_type == PGXC_NODE_DATANODE || node_type == PGXC_NODE_SLAVEDATANODE)
     {
         for (i = 0; i < current_transaction_handles->dn_conn_count; i++)
         {
@@ -4483,7 +4794,7 @@ register_transaction_handles(PGXCNodeHandle* handle)
             }
         }
         current_transaction_handles->datanode_handles[current_transaction_handles->dn_conn_count++] = handle;
-        Assert(current_transaction_handles->dn_conn_count <= NumDataNodes);
+        Assert(current_transaction_handles->dn_conn_count <= NumDataNodes + NumSlaveDataNodes);
     }
     else if (node_type == PGXC_NODE_COORDINATOR)
     {
@@ -4650,6 +4961,24 @@ NOT_FOUND:
     return -1;
 }
 
+#ifdef __TBASE__
+/*
+ * PGXCNodeGetPoolIndex
+ *        Index the pooler knows a datanode connection by: standby datanodes
+ *        serving reads follow the datanodes.
+ */
+int
+PGXCNodeGetPoolIndex(PGXCNodeHandle *handle)
+{
+    char node_type = handle->node_type;
+    int  nodeidx = PGXCNodeGetNodeId(handle->nodeoid, &node_type);
+
+    if (nodeidx >= 0 && node_type == PGXC_NODE_SLAVEDATANODE)
+        return NumDataNodes + nodeidx;
+    return nodeidx;
+}
+#endif
+
 /*
  * PGXCNodeGetNodeOid
  *        Look at the data cached for handles and return node Oid
@@ -42,6 +42,7 @@
 #include "catalog/pgxc_node.h"
 #include "commands/dbcommands.h"
 #include "nodes/nodes.h"
+#include "pgstat.h"
 #include "pgxc/poolmgr.h"
 #include "utils/builtins.h"
 #include "utils/guc.h"
@@ -605,6 +606,13 @@ static void handle_session_command(PoolAgent * agent, StringInfo s);
 static int  refresh_database_pools(PoolAgent *agent);
 
 static void pooler_async_ping_node(Oid node);
+#ifdef __TBASE__
+static NODE_CONNECTION *pooler_standby_read_conn(Oid node, const char *username,
+                         Oid *conn_oids, NODE_CONNECTION **conns, int *nconns);
+static void pooler_standby_read_close(Oid node,
+                          Oid *conn_oids, NODE_CONNECTION **conns, int *nconns);
+static void pooler_refresh_standby_replay_gts(void);
+#endif
 static bool match_databasepool(DatabasePool *databasePool, const char* user_name, const char* database);
 static int handle_close_pooled_connections(PoolAgent * agent, StringInfo s);
 #ifdef __TBASE__
@@ -873,7 +881,7 @@ node_info_check(PoolAgent *agent)
      * First check if agent's node information matches to current content of the
      * shared memory table.
      */
-    PgxcNodeGetOids(&coOids, &dnOids, &numCo, &numDn, false);
+    PgxcNodeGetPoolOids(&coOids, &dnOids, &numCo, &numDn);
 
     if (agent->num_coord_connections != numCo ||
             agent->num_dn_connections != numDn ||
@@ -1629,8 +1637,8 @@ agent_init(PoolAgent *agent, const char *database, const char *user_name,
     oldcontext = MemoryContextSwitchTo(agent->mcxt);
 
     /* Get needed info and allocate memory */
-    PgxcNodeGetOids(&agent->coord_conn_oids, &agent->dn_conn_oids,
-                    &agent->num_coord_connections, &agent->num_dn_connections, false);
+    PgxcNodeGetPoolOids(&agent->coord_conn_oids, &agent->dn_conn_oids,
+                    &agent->num_coord_connections, &agent->num_dn_connections);
 
     agent->coord_connections = (PGXCNodePoolSlot **)
             palloc0(agent->num_coord_connections * sizeof(PGXCNodePoolSlot *));
@@ -1902,7 +1910,9 @@ PoolManagerGetConnections(List *datanodelist, List *coordlist, bool raise_error,
     }
     
     pool_flush(&poolHandle->port);
+    pgstat_report_wait_start(WAIT_EVENT_POOLER_GET_CONNECTIONS);
     pool_recvfds_ret = pool_recvfds(&poolHandle->port, fds, totlen);
+    pgstat_report_wait_end();
     if (pool_recvfds_ret)
     {
         pfree(fds);
@@ -3008,8 +3018,8 @@ agent_acquire_connections(PoolAgent *agent, List *datanodelist, List *coordlist,
         /* fix memleak */
         oldcontext = MemoryContextSwitchTo(agent->mcxt);
         
-        PgxcNodeGetOids(&agent->coord_conn_oids, &agent->dn_conn_oids,
-                        &agent->num_coord_connections, &agent->num_dn_connections, false);
+        PgxcNodeGetPoolOids(&agent->coord_conn_oids, &agent->dn_conn_oids,
+                        &agent->num_coord_connections, &agent->num_dn_connections);
 
         agent->coord_connections = (PGXCNodePoolSlot **)
                 palloc0(agent->num_coord_connections * sizeof(PGXCNodePoolSlot *));
@@ -4470,8 +4480,8 @@ reload_database_pools(PoolAgent *agent)
     MemoryContextReset(agent->mcxt);
 
     /* and allocate new */
-    PgxcNodeGetOids(&agent->coord_conn_oids, &agent->dn_conn_oids,
-                    &agent->num_coord_connections, &agent->num_dn_connections, false);
+    PgxcNodeGetPoolOids(&agent->coord_conn_oids, &agent->dn_conn_oids,
+                    &agent->num_coord_connections, &agent->num_dn_connections);
 
     agent->coord_connections = (PGXCNodePoolSlot **)
             palloc0(agent->num_coord_connections * sizeof(PGXCNodePoolSlot *));
@@ -5642,10 +5652,21 @@ PoolerLoop(void)
             }
     
             /* wait for event */
+#ifdef __TBASE__
+            if (enable_standby_read_routing &&
+                timeout_val * 1000 > standby_read_refresh_interval)
+                retval = poll(pool_fd, agentCount + 1, standby_read_refresh_interval);
+            else
+#endif
             retval = poll(pool_fd, agentCount + 1, timeout_val * 1000);
         }
         else
         {
+#ifdef __TBASE__
+            if (enable_standby_read_routing)
+                retval = poll(pool_fd, agentCount + 1, standby_read_refresh_interval);
+            else
+#endif
             retval = poll(pool_fd, agentCount + 1, -1);
         }        
         
@@ -5702,6 +5723,11 @@ PoolerLoop(void)
             }
         }
 
+#ifdef __TBASE__
+        /* keep the replay positions of standby datanodes fresh */
+        pooler_refresh_standby_replay_gts();
+#endif
+
         /* maintaince time out */
         if (0 == timeout_val && PoolMaintenanceTimeout > 0)
         {
@@ -9189,7 +9215,7 @@ static void create_node_map(void)
     g_nodemap = hash_create("Node Map Hash", TBASE_MAX_DATANODE_NUMBER + TBASE_MAX_COORDINATOR_NUMBER,
                                               &hinfo, hflags);    
 
-    PgxcNodeGetOids(&coOids, &dnOids, &numCo, &numDn, false);
+    PgxcNodeGetPoolOids(&coOids, &dnOids, &numCo, &numDn);
 
     for (nodeindex = 0; nodeindex < numCo; nodeindex++)
     { 
@@ -9276,7 +9302,7 @@ static void refresh_node_map(void)
 		}
 	}
 #endif
-    PgxcNodeGetOids(&coOids, &dnOids, &numCo, &numDn, false);
+    PgxcNodeGetPoolOids(&coOids, &dnOids, &numCo, &numDn);
 
     for (nodeindex = 0; nodeindex < numCo; nodeindex++)
     { 
@@ -10958,7 +10984,7 @@ refresh_database_pools(PoolAgent *agent)
      * re-check if agent's node information matches current contents of the
      * shared memory table.
      */
-    PgxcNodeGetOids(&coOids, &dnOids, &numCo, &numDn, false);
+    PgxcNodeGetPoolOids(&coOids, &dnOids, &numCo, &numDn);
 
     if (agent->num_coord_connections != numCo ||
             agent->num_dn_connections != numDn ||
@@ -11575,3 +11601,258 @@ handle_get_conn_statistics(PoolAgent *agent)
 
     pfree(buf.data);
 }
+
+#ifdef __TBASE__
+/*
+ * Connection the pooler keeps to a datanode or standby datanode it polls for
+ * standby reads, opened if needed.  NULL if the node cannot be reached.
+ */
+static NODE_CONNECTION *
+pooler_standby_read_conn(Oid node, const char *username,
+                         Oid *conn_oids, NODE_CONNECTION **conns, int *nconns)
+{
+    NodeDefinition  *nodeDef;
+    NODE_CONNECTION *conn;
+    char             connstr[MAXPGPATH * 2 + 256];
+    int              j;
+
+    for (j = 0; j < *nconns; j++)
+    {
+        if (conn_oids[j] == node)
+            return conns[j];
+    }
+
+    if (*nconns >= 2 * TBASE_MAX_DATANODE_NUMBER)
+        return NULL;
+
+    nodeDef = PgxcNodeGetDefinition(node);
+    if (nodeDef == NULL)
+        return NULL;
+    snprintf(connstr, sizeof(connstr),
+             "host=%s port=%d user=%s dbname=postgres connect_timeout=2",
+             NameStr(nodeDef->nodehost), nodeDef->nodeport, username);
+    pfree(nodeDef);
+
+    conn = PGXCNodeConnectBarely(connstr);
+    if (conn == NULL || !PGXCNodeConnected(conn))
+    {
+        if (conn)
+            PGXCNodeClose(conn);
+        return NULL;
+    }
+
+    conn_oids[*nconns] = node;
+    conns[(*nconns)++] = conn;
+    return conn;
+}
+
+/* Close the connection to node kept by pooler_standby_read_conn() */
+static void
+pooler_standby_read_close(Oid node,
+                          Oid *conn_oids, NODE_CONNECTION **conns, int *nconns)
+{
+    int j;
+
+    for (j = 0; j < *nconns; j++)
+    {
+        if (conn_oids[j] != node)
+            continue;
+        PGXCNodeClose(conns[j]);
+        (*nconns)--;
+        conn_oids[j] = conn_oids[*nconns];
+        conns[j] = conns[*nconns];
+        return;
+    }
+}
+
+/*
+ * Poll the standby datanodes for the GTS below which they can serve
+ * snapshots, so that coordinators can route read-only transactions to them.
+ *
+ * A standby cannot tell that by itself: commit GTS are not in WAL order on
+ * its primary.  So each datanode is asked for a GTS and a WAL position such
+ * that every lower commit precedes the position, and the next time its
+ * standbys are asked whether they have replayed past it.  Connections to the
+ * nodes are kept open between polls.
+ */
+static void
+pooler_refresh_standby_replay_gts(void)
+{// #lizard forgives
+    static TimestampTz last_refresh = 0;
+    static Oid         conn_oids[2 * TBASE_MAX_DATANODE_NUMBER];
+    static NODE_CONNECTION *conns[2 * TBASE_MAX_DATANODE_NUMBER];
+    static int         nconns = 0;
+    /* pairs of tbase_get_safe_gts() last returned by the datanodes */
+    static Oid         safe_oids[TBASE_MAX_DATANODE_NUMBER];
+    static GlobalTimestamp safe_gts[TBASE_MAX_DATANODE_NUMBER];
+    static XLogRecPtr  safe_lsn[TBASE_MAX_DATANODE_NUMBER];
+    static int         nsafe = 0;
+    TimestampTz        now;
+    Oid               *dnOids = NULL;
+    Oid               *sdnOids = NULL;
+    Oid               *masters = NULL;
+    int                num_dns = 0;
+    int                num_sdns = 0;
+    const char        *username;
+    char              *errstr = NULL;
+    int                i;
+    int                j;
+
+    if (!enable_standby_read_routing && nconns == 0)
+        return;
+
+    now = GetCurrentTimestamp();
+    if (!TimestampDifferenceExceeds(last_refresh, now, standby_read_refresh_interval))
+        return;
+    last_refresh = now;
+
+    if (enable_standby_read_routing)
+        PgxcNodeGetOidsExtend(NULL, &dnOids, &sdnOids, NULL, &num_dns, &num_sdns, false);
+
+    /* datanode each standby replicates: the one with the same name */
+    if (num_sdns > 0)
+        masters = (Oid *) palloc(num_sdns * sizeof(Oid));
+    for (i = 0; i < num_sdns; i++)
+    {
+        NodeDefinition *sdnDef = PgxcNodeGetDefinition(sdnOids[i]);
+
+        masters[i] = InvalidOid;
+        for (j = 0; sdnDef != NULL && j < num_dns; j++)
+        {
+            NodeDefinition *dnDef = PgxcNodeGetDefinition(dnOids[j]);
+
+            if (dnDef == NULL)
+                continue;
+            if (strcmp(NameStr(dnDef->nodename), NameStr(sdnDef->nodename)) == 0)
+                masters[i] = dnOids[j];
+            pfree(dnDef);
+            if (OidIsValid(masters[i]))
+                break;
+        }
+        if (sdnDef)
+            pfree(sdnDef);
+    }
+
+    /* close connections to nodes that are no longer polled */
+    for (j = 0; j < nconns;)
+    {
+        for (i = 0; i < num_sdns; i++)
+        {
+            if (sdnOids[i] == conn_oids[j] || masters[i] == conn_oids[j])
+                break;
+        }
+        if (i < num_sdns)
+        {
+            j++;
+            continue;
+        }
+        pooler_standby_read_close(conn_oids[j], conn_oids, conns, &nconns);
+    }
+
+    username = get_user_name(&errstr);
+    if (errstr != NULL)
+    {
+        elog(LOG, POOL_MGR_PREFIX"could not get current user name: %s", errstr);
+        num_sdns = 0;
+    }
+
+    /* standbys: have they replayed past the pair their datanode gave? */
+    for (i = 0; i < num_sdns; i++)
+    {
+        NODE_CONNECTION *conn;
+        GlobalTimestamp  gts = InvalidGlobalTimestamp;
+        PGresult        *res;
+        char             query[256];
+
+        for (j = 0; j < nsafe; j++)
+        {
+            if (safe_oids[j] == masters[i])
+                break;
+        }
+        if (j == nsafe)
+            continue;
+
+        conn = pooler_standby_read_conn(sdnOids[i], username,
+                                        conn_oids, conns, &nconns);
+        if (conn == NULL)
+        {
+            PgxcNodeUpdateReplayGTS(sdnOids[i], InvalidGlobalTimestamp);
+            continue;
+        }
+
+        snprintf(query, sizeof(query),
+                 "SELECT pg_catalog.tbase_get_replayed_gts('%X/%X', " INT64_FORMAT ")",
+                 (uint32) (safe_lsn[j] >> 32), (uint32) safe_lsn[j], safe_gts[j]);
+        res = PQexec((PGconn *) conn, query);
+        if (res && PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1)
+        {
+            /* null until the standby has replayed up to the position */
+            if (!PQgetisnull(res, 0, 0))
+            {
+                gts = (GlobalTimestamp) strtoll(PQgetvalue(res, 0, 0), NULL, 10);
+                if (gts > PgxcNodeGetReplayGTS(sdnOids[i]))
+                    PgxcNodeUpdateReplayGTS(sdnOids[i], gts);
+            }
+        }
+        else
+        {
+            /* reconnect next time */
+            pooler_standby_read_close(sdnOids[i], conn_oids, conns, &nconns);
+            PgxcNodeUpdateReplayGTS(sdnOids[i], InvalidGlobalTimestamp);
+        }
+        if (res)
+            PQclear(res);
+    }
+
+    /* datanodes: new pairs for the next poll */
+    nsafe = 0;
+    for (i = 0; i < num_sdns; i++)
+    {
+        NODE_CONNECTION *conn;
+        PGresult        *res;
+
+        if (!OidIsValid(masters[i]))
+            continue;
+        for (j = 0; j < nsafe; j++)
+        {
+            if (safe_oids[j] == masters[i])
+                break;
+        }
+        if (j < nsafe)
+            continue;
+
+        conn = pooler_standby_read_conn(masters[i], username,
+                                        conn_oids, conns, &nconns);
+        if (conn == NULL)
+            continue;
+
+        res = PQexec((PGconn *) conn,
+                     "SELECT gts, lsn FROM pg_catalog.tbase_get_safe_gts()");
+        if (res && PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1)
+        {
+            uint32 hi;
+            uint32 lo;
+
+            if (!PQgetisnull(res, 0, 0) && !PQgetisnull(res, 0, 1) &&
+                sscanf(PQgetvalue(res, 0, 1), "%X/%X", &hi, &lo) == 2)
+            {
+                safe_oids[nsafe] = masters[i];
+                safe_gts[nsafe] = (GlobalTimestamp) strtoll(PQgetvalue(res, 0, 0), NULL, 10);
+                safe_lsn[nsafe] = ((uint64) hi) << 32 | lo;
+                nsafe++;
+            }
+        }
+        else
+            pooler_standby_read_close(masters[i], conn_oids, conns, &nconns);
+        if (res)
+            PQclear(res);
+    }
+
+    if (masters)
+        pfree(masters);
+    if (dnOids)
+        pfree(dnOids);
+    if (sdnOids)
+        pfree(sdnOids);
+}
+#endif
@@ -61,14 +61,15 @@
 #include "postgres.h"
 
 #include "funcapi.h"
+#include "access/hash.h"
 #include "access/htup_details.h"
 #include "catalog/pg_type.h"
+#include "port/atomics.h"
 #include "storage/shmem.h"
 #include "storage/relfilenode.h"
 #include "storage/spin.h"
 #include "storage/lwlock.h"
 #include "storage/lockdefs.h"
-#include "utils/hsearch.h"
 #include "utils/timestamp.h"
 #include "utils/builtins.h"
 #include "pgxc/shardmap.h"
@@ -76,6 +77,13 @@
 
 #define MAX_BARRIER_SHARDS    256
 
+/*
+ * Barriers live in an open-addressing table with linear probing, kept at most
+ * half full so that a probe ends after a slot or two.
+ */
+#define BARRIER_SHARD_SLOTS    (MAX_BARRIER_SHARDS * 2)
+#define BARRIER_SHARD_MASK    (BARRIER_SHARD_SLOTS - 1)
+
 typedef struct ShardBarrierTag
 {
     RelFileNode    rel;
@@ -89,25 +97,77 @@ typedef struct ShardBarrierEnt
     int32        flags;
     BackendId    pid;
     TimestampTz start_time;
+    uint32        hashcode;
+    bool        in_use;
 }ShardBarrierEnt;
 
+/*
+ * Writers change the table under ShardBarrierLock and make version odd while
+ * they do, so DML and buffer writes look barriers up without any lock: they
+ * probe the table and retry if version was odd or has moved meanwhile.
+ */
 typedef struct ShardBarrierInfo
 {
+    pg_atomic_uint32    version;
     int32    n_shards;
+    ShardBarrierEnt    slots[BARRIER_SHARD_SLOTS];
 }ShardBarrierInfo;
 
 /* in share memory */
 static ShardBarrierInfo *g_barrier_shards_info = NULL;
-static HTAB                *g_barrier_shards_ht = NULL;
 
 /* process local */
 static bool has_shard_barriered = false;
 static ShardBarrierTag barriered_shard;
 
+static inline uint32
+shard_barrier_hash(ShardBarrierTag *tag)
+{
+    return DatumGetUInt32(hash_any((unsigned char *) tag, sizeof(ShardBarrierTag)));
+}
+
+/*
+ * Slot holding the barrier, or -1.  Bounded so that a reader probing a table
+ * torn by a concurrent writer still terminates; it retries anyway.
+ */
+static int
+shard_barrier_lookup(ShardBarrierTag *tag, uint32 hashcode)
+{
+    int        i;
+    int        slot = hashcode & BARRIER_SHARD_MASK;
+
+    for (i = 0; i < BARRIER_SHARD_SLOTS; i++)
+    {
+        ShardBarrierEnt *ent = &g_barrier_shards_info->slots[slot];
+
+        if (!ent->in_use)
+            return -1;
+        if (ent->hashcode == hashcode &&
+            memcmp(&ent->tag, tag, sizeof(ShardBarrierTag)) == 0)
+            return slot;
+        slot = (slot + 1) & BARRIER_SHARD_MASK;
+    }
+
+    return -1;
+}
+
+static inline void
+shard_barrier_begin_change(void)
+{
+    pg_atomic_fetch_add_u32(&g_barrier_shards_info->version, 1);
+    pg_write_barrier();
+}
+
+static inline void
+shard_barrier_end_change(void)
+{
+    pg_write_barrier();
+    pg_atomic_fetch_add_u32(&g_barrier_shards_info->version, 1);
+}
+
 void ShardBarrierShmemInit(void)
 {
     bool found;
-    HASHCTL        info;
 
     g_barrier_shards_info = (ShardBarrierInfo *)ShmemInitStruct("BarrierShardInfo",
                                                 sizeof(ShardBarrierInfo),
@@ -115,33 +175,14 @@ void ShardBarrierShmemInit(void)
 
     if(!found)
     {
-        g_barrier_shards_info->n_shards = 0;
+        MemSet(g_barrier_shards_info, 0, sizeof(ShardBarrierInfo));
+        pg_atomic_init_u32(&g_barrier_shards_info->version, 0);
     }
-    
-    /* init hash table */
-    info.keysize   = sizeof(ShardBarrierTag);
-    info.entrysize = sizeof(ShardBarrierEnt);
-    info.hash = tag_hash;
-
-    g_barrier_shards_ht = ShmemInitHash("ShardBarrierHashTable",
-                                  MAX_BARRIER_SHARDS, 
-                                  MAX_BARRIER_SHARDS,
-                                  &info,
-                                  HASH_ELEM | HASH_FUNCTION);
 }
 
 Size ShardBarrierShmemSize(void)
 {
-    Size size;
-    
-    size = 0;    
-    /* hash table size */
-    size = hash_estimate_size(MAX_BARRIER_SHARDS, sizeof(ShardBarrierEnt));
-    
-    /* management info */
-    size = add_size(size, MAXALIGN64(sizeof(ShardBarrierInfo)));
-
-    return size;
+    return MAXALIGN64(sizeof(ShardBarrierInfo));
 }
 
 void AddShardBarrier(RelFileNode rel, ShardID sid, BackendId pid)
@@ -149,6 +190,7 @@ void AddShardBarrier(RelFileNode rel, ShardID sid, BackendId pid)
     bool found;
     ShardBarrierEnt *ent;
     ShardBarrierTag tag;
+    uint32 hashcode;
 
     if(!ShardIDIsValid(sid))
     {
@@ -163,24 +205,37 @@ void AddShardBarrier(RelFileNode rel, ShardID sid, BackendId pid)
     tag.rel = rel;
     tag.sid = sid;
     tag.reserved = 0;
+    hashcode = shard_barrier_hash(&tag);
 
     LWLockAcquire(ShardBarrierLock, LW_EXCLUSIVE);
-    if(g_barrier_shards_info->n_shards >= MAX_BARRIER_SHARDS)
-    {
-        LWLockRelease(ShardBarrierLock);
-        elog(ERROR, "too many shards are vacuuming right now, please try it later.");
-    }
-    
-    ent = (ShardBarrierEnt *)hash_search(g_barrier_shards_ht, (void *)&tag, HASH_ENTER, &found);
-
+    found = (shard_barrier_lookup(&tag, hashcode) >= 0);
     if(!found)
     {
+        int slot;
+
+        if(g_barrier_shards_info->n_shards >= MAX_BARRIER_SHARDS)
+        {
+            LWLockRelease(ShardBarrierLock);
+            elog(ERROR, "too many shards are vacuuming right now, please try it later.");
+        }
+
+        slot = hashcode & BARRIER_SHARD_MASK;
+        while (g_barrier_shards_info->slots[slot].in_use)
+            slot = (slot + 1) & BARRIER_SHARD_MASK;
+
+        shard_barrier_begin_change();
+        ent = &g_barrier_shards_info->slots[slot];
+        ent->tag = tag;
+        ent->hashcode = hashcode;
         ent->flags = 0;
         ent->pid = pid;
         ent->start_time = GetCurrentTimestamp();
+        ent->in_use = true;
+        g_barrier_shards_info->n_shards++;
+        shard_barrier_end_change();
+
         has_shard_barriered = true;
         memcpy(&barriered_shard, &tag, sizeof(ShardBarrierTag));
-        g_barrier_shards_info->n_shards++;
     }
     LWLockRelease(ShardBarrierLock);
 
@@ -194,6 +249,8 @@ void RemoveOneShardBarrier(RelFileNode rel, ShardID sid)
 {
     bool found = false;
     ShardBarrierTag tag;
+    uint32 hashcode;
+    int slot;
 
     if(!ShardIDIsValid(sid))
     {
@@ -203,15 +260,48 @@ void RemoveOneShardBarrier(RelFileNode rel, ShardID sid)
     tag.rel = rel;
     tag.sid = sid;
     tag.reserved = 0;
+    hashcode = shard_barrier_hash(&tag);
 
     LWLockAcquire(ShardBarrierLock, LW_EXCLUSIVE);
-    (void)hash_search(g_barrier_shards_ht, (void *)&tag, HASH_REMOVE, &found);
+    slot = shard_barrier_lookup(&tag, hashcode);
+    found = (slot >= 0);
 
     if(found)
     {
+        ShardBarrierEnt *slots = g_barrier_shards_info->slots;
+        int hole = slot;
+        int next = slot;
+
+        shard_barrier_begin_change();
+
+        /*
+         * Shift later members of the probe run back into the hole, so that
+         * lookups can keep stopping at the first free slot.
+         */
+        slots[hole].in_use = false;
+        for (;;)
+        {
+            int home;
+
+            next = (next + 1) & BARRIER_SHARD_MASK;
+            if (!slots[next].in_use)
+                break;
+
+            home = slots[next].hashcode & BARRIER_SHARD_MASK;
+            if (hole <= next ? (hole < home && home <= next)
+                             : (hole < home || home <= next))
+                continue;
+
+            slots[hole] = slots[next];
+            slots[next].in_use = false;
+            hole = next;
+        }
+        g_barrier_shards_info->n_shards--;
+
+        shard_barrier_end_change();
+
         has_shard_barriered = false;
         memset(&barriered_shard, 0, sizeof(ShardBarrierTag));
-        g_barrier_shards_info->n_shards--;
     }
     
     LWLockRelease(ShardBarrierLock);
@@ -237,6 +327,7 @@ bool IsShardBarriered(RelFileNode rel, ShardID sid)
     
     bool found;
     ShardBarrierTag tag;
+    uint32 hashcode;
 
     if(!ShardIDIsValid(sid))
     {
@@ -252,10 +343,25 @@ bool IsShardBarriered(RelFileNode rel, ShardID sid)
     tag.rel = rel;
     tag.sid = sid;
     tag.reserved = 0;
+    hashcode = shard_barrier_hash(&tag);
 
-    LWLockAcquire(ShardBarrierLock, LW_SHARED);
-    (void)hash_search(g_barrier_shards_ht, (void *)&tag, HASH_FIND, &found);
-    LWLockRelease(ShardBarrierLock);
+    for (;;)
+    {
+        uint32 version = pg_atomic_read_u32(&g_barrier_shards_info->version);
+
+        if (version & 1)
+        {
+            SPIN_DELAY();
+            continue;
+        }
+
+        pg_read_barrier();
+        found = (shard_barrier_lookup(&tag, hashcode) >= 0);
+        pg_read_barrier();
+
+        if (pg_atomic_read_u32(&g_barrier_shards_info->version) == version)
+            break;
+    }
     
     return found;
 }
@@ -340,15 +446,15 @@ Datum pg_stat_barrier_shards(PG_FUNCTION_ARGS)
         funcctx->user_fctx = (void *) bar_status;
 
         {
-            HASH_SEQ_STATUS scan_status;
-            ShardBarrierEnt  *item;
+            int i;
             int n_items = 0;
 
             LWLockAcquire(ShardBarrierLock, LW_SHARED);
-            hash_seq_init(&scan_status, g_barrier_shards_ht);
-            while ((item = (ShardBarrierEnt *) hash_seq_search(&scan_status)) != NULL)
+            for (i = 0; i < BARRIER_SHARD_SLOTS; i++)
             {
-                memcpy(&bar_status->bars[n_items++],item, sizeof(ShardBarrierEnt));
+                if (g_barrier_shards_info->slots[i].in_use)
+                    memcpy(&bar_status->bars[n_items++], &g_barrier_shards_info->slots[i],
+                           sizeof(ShardBarrierEnt));
             }
 
             bar_status->max_barriers = n_items;
@@ -1979,7 +1979,7 @@ SharedQueueRead(SharedQueue squeue, int consumerIdx,
             /* Wait for notification about available info */
             WaitLatch(&sqsync->sqs_consumer_sync[consumerIdx].cs_latch,
                     WL_LATCH_SET | WL_POSTMASTER_DEATH | WL_TIMEOUT, 1000L,
-                    WAIT_EVENT_MQ_INTERNAL);
+                    WAIT_EVENT_SQUEUE_EMPTY);
 
             /* got the notification, restore lock and try again */
             LWLockAcquire(sqsync->sqs_producer_lwlock, LW_SHARED);
@@ -2460,10 +2460,18 @@ bool
 SharedQueueWaitOnProducerLatch(SharedQueue squeue, long timeout)
 {
     SQueueSync *sqsync = squeue->sq_sync;
-    int rc = WaitLatch(&sqsync->sqs_producer_latch,
+    instr_time  wait_start;
+    instr_time  wait_time;
+    int rc;
+
+    INSTR_TIME_SET_CURRENT(wait_start);
+    rc = WaitLatch(&sqsync->sqs_producer_latch,
             WL_LATCH_SET | WL_POSTMASTER_DEATH | WL_TIMEOUT,
-            timeout, WAIT_EVENT_MQ_INTERNAL);
+            timeout, WAIT_EVENT_SQUEUE_FULL);
     ResetLatch(&sqsync->sqs_producer_latch);
+    INSTR_TIME_SET_CURRENT(wait_time);
+    INSTR_TIME_SUBTRACT(wait_time, wait_start);
+    PGXCNetSendBlockedTime += INSTR_TIME_GET_DOUBLE(wait_time);
     return (rc & (WL_TIMEOUT|WL_POSTMASTER_DEATH));
 }
 
@@ -2936,7 +2944,10 @@ SEND_DATA:
                     return nstores;
 #else
                     /* send all data to consumer until end */
+                    pgstat_report_wait_start(WAIT_EVENT_SQUEUE_FULL);
                     pg_usleep(1000L);
+                    pgstat_report_wait_end();
+                    PGXCNetSendBlockedTime += 0.001;
 
                     send_times++;
 
@@ -3554,7 +3565,7 @@ sq_pull_long_tuple(ConsState *cstate, RemoteDataRow datarow,
 
             /* Wait for notification about available info */
             WaitLatch(&sync->cs_latch, WL_LATCH_SET | WL_POSTMASTER_DEATH, -1,
-                    WAIT_EVENT_MQ_INTERNAL);
+                    WAIT_EVENT_SQUEUE_EMPTY);
             /* got the notification, restore lock and try again */
             LWLockAcquire(sqsync->sqs_producer_lwlock, LW_SHARED);
             LWLockAcquire(sync->cs_lwlock, LW_EXCLUSIVE);
@@ -5745,6 +5756,20 @@ bool socket_set_nonblocking(int fd, bool non_block)
     return true;
 }
 
+/*
+ * Sleep while the sender threads drain a full data pump buffer, reported as
+ * a wait event so that sampling shows time spent sending to other nodes, and
+ * counted as send-blocked time for EXPLAIN ANALYZE.
+ */
+static inline void
+DataPumpSendWait(long usec)
+{
+    pgstat_report_wait_start(WAIT_EVENT_DATAPUMP_SEND);
+    pg_usleep(usec);
+    pgstat_report_wait_end();
+    PGXCNetSendBlockedTime += usec / 1000000.0;
+}
+
 bool
 ExecFastSendDatarow(TupleTableSlot *slot, void *sndctl, int32 nodeindex, MemoryContext tmpcxt)
 {// #lizard forgives
@@ -5863,7 +5888,7 @@ ExecFastSendDatarow(TupleTableSlot *slot, void *sndctl, int32 nodeindex, MemoryC
                             {
                                 break;
                             }
-                            pg_usleep(1000L);
+                            DataPumpSendWait(1000L);
                             if (!DataPumpNodeCheck(sndctl, nodeindex))
                             {
                                 ReturnSpace(node->buffer, head);
@@ -5968,7 +5993,7 @@ ExecFastSendDatarow(TupleTableSlot *slot, void *sndctl, int32 nodeindex, MemoryC
                                 {
                                     break;
                                 }
-                                pg_usleep(1000L);
+                                DataPumpSendWait(1000L);
                                 if (!DataPumpNodeCheck(sndctl, nodeindex))
                                 {
                                     ReturnSpace(node->buffer, head);
@@ -6053,7 +6078,7 @@ ExecFastSendDatarow(TupleTableSlot *slot, void *sndctl, int32 nodeindex, MemoryC
                                 {
                                     break;
                                 }
-                                pg_usleep(1000L);
+                                DataPumpSendWait(1000L);
                                 if (!DataPumpNodeCheck(sndctl, nodeindex))
                                 {
                                     ReturnSpace(node->buffer, head);
@@ -6143,7 +6168,7 @@ ExecFastSendDatarow(TupleTableSlot *slot, void *sndctl, int32 nodeindex, MemoryC
                             {
                                 break;
                             }
-                            pg_usleep(1000L);
+                            DataPumpSendWait(1000L);
                             if (!DataPumpNodeCheck(sndctl, nodeindex))
                             {
                                 ReturnSpace(node->buffer, head);
@@ -6229,6 +6254,7 @@ ExecFastSendDatarow(TupleTableSlot *slot, void *sndctl, int32 nodeindex, MemoryC
         /* Write data length, we reserve data above. */
         n32 = htonl(write_len - 1);
         FillReserveSpace(node->buffer, leng_ptr, (char *)&n32, sizeof(n32));
+        PGXCNetBytesSent += write_len;
         
         /* Return space if needed. */
         if (remaining_length)
@@ -8243,7 +8269,7 @@ ParallelFastSendDatarow(ParallelSendDataQueue *buf, TupleTableSlot *slot, void *
                             {
                                 break;
                             }
-                            pg_usleep(1000L);
+                            DataPumpSendWait(1000L);
 
                             sleep_time++;
 
@@ -8338,7 +8364,7 @@ ParallelFastSendDatarow(ParallelSendDataQueue *buf, TupleTableSlot *slot, void *
                                 {
                                     break;
                                 }
-                                pg_usleep(1000L);
+                                DataPumpSendWait(1000L);
 
                                 sleep_time++;
 
@@ -8414,7 +8440,7 @@ ParallelFastSendDatarow(ParallelSendDataQueue *buf, TupleTableSlot *slot, void *
                                 {
                                     break;
                                 }
-                                pg_usleep(1000L);
+                                DataPumpSendWait(1000L);
                                 
                                 sleep_time++;
 
@@ -8495,7 +8521,7 @@ ParallelFastSendDatarow(ParallelSendDataQueue *buf, TupleTableSlot *slot, void *
                             {
                                 break;
                             }
-                            pg_usleep(1000L);
+                            DataPumpSendWait(1000L);
 
                             sleep_time++;
 
@@ -8556,6 +8582,7 @@ ParallelFastSendDatarow(ParallelSendDataQueue *buf, TupleTableSlot *slot, void *
         /* Write data length, we reserve data above. */
         n32 = htonl(write_len - 1);
         FillReserveBufferSpace(buf, leng_ptr, (char *)&n32, sizeof(n32));
+        PGXCNetBytesSent += write_len;
         
         /* Return space if needed. */
         if (remaining_length)
@@ -73,6 +73,7 @@
 
 #include <fcntl.h>
 #include <limits.h>
+#include <pthread.h>
 #include <signal.h>
 #include <time.h>
 #include <unistd.h>
@@ -83,6 +84,7 @@
 
 #include "lib/stringinfo.h"
 #include "libpq/pqsignal.h"
+#include "mb/pg_wchar.h"
 #include "miscadmin.h"
 #include "nodes/pg_list.h"
 #include "pgstat.h"
@@ -179,6 +181,12 @@ static AlogQueueArray	  * AuditCommonLogQueueArray = NULL;
 static AlogQueueArray	  * AuditFGALogQueueArray = NULL;
 /* store trace audit logs, each elem for a backend */
 static AlogQueueArray	  * AuditTraceLogQueueArray = NULL;
+/*
+ * store binary common audit records, each elem for a backend. Every ring
+ * has a single producer, its backend, and a single consumer thread, so
+ * head and tail are published with memory barriers and no lock.
+ */
+static AlogQueueArray	  * AuditRecordQueueArray = NULL;
 
 /*
  * shared memory bitmap to notify consumers to read audit log from AlogQueueArray above
@@ -218,6 +226,16 @@ static AlogQueueCache	  * AuditTraceLogLocalCache = NULL;
  */
 static ThreadSema		  * AuditConsumerNotifySemas = NULL;
 
+/*
+ * per consumer buffers to format binary audit records, one holding a record
+ * copied out of a ring and one for its text, used in audit logger only.
+ */
+static char				 ** AuditConsumerRecordBuffers = NULL;
+static char				 ** AuditConsumerTextBuffers = NULL;
+
+/* pg_localtime() returns static storage, serialize its callers among threads */
+static pthread_mutex_t		audit_localtime_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * GUC parameters.    can change at SIGHUP.
  */
@@ -248,6 +266,7 @@ int							Maintain_trace_log_cache_size_kb = 64;
  */
 bool                        am_auditlogger = false;
 bool                        enable_auditlogger_warning = false;
+bool						AuditLog_binary_records = false;
 
 /*
  * Logger Private state
@@ -321,6 +340,8 @@ static Size		audit_shared_fga_queue_elem_size(void);
 static Size		audit_shared_fga_queue_array_size(void);
 static Size		audit_shared_trace_queue_elem_size(void);
 static Size		audit_shared_trace_queue_array_size(void);
+static Size		audit_shared_record_queue_elem_size(void);
+static Size		audit_shared_record_queue_array_size(void);
 static Size 	audit_shared_consumer_bitmap_size(void);
 static int 		audit_shared_consumer_bitmap_get_value(int consumer_id);
 static void 	audit_shared_consumer_bitmap_set_value(int consumer_id, int value);
@@ -353,12 +374,19 @@ static bool     alog_queue_pushn(AlogQueue * queue, char * buff[], int len[], in
 static int         alog_queue_get_str_len(AlogQueue * queue, int offset);
 static bool     alog_queue_pop_to_queue(AlogQueue * from, AlogQueue * to);
 static bool     alog_queue_pop_to_file(AlogQueue * from, int destination);
+static void     alog_queue_copy_out(AlogQueue * queue, int offset, char * buff, int len);
+static void     alog_format_time(char * buff, int size, pg_time_t timestamp);
+static int      alog_record_format(const char * record, char * text, int text_size);
+static bool     alog_queue_pop_records_to_queue(AlogQueue * from, AlogQueue * to,
+                                                char * record_buff, char * text_buff,
+                                                int text_size);
 #endif
 
 #ifdef AuditLog_005_For_ThreadWorker
 static AlogQueue *		alog_get_shared_common_queue(int idx);
 static AlogQueue * 		alog_get_shared_fga_queue(int idx);
 static AlogQueue * 		alog_get_shared_trace_queue(int idx);
+static AlogQueue * 		alog_get_shared_record_queue(int idx);
 static AlogQueue *		alog_get_local_common_cache(int consumer_id);
 static AlogQueue *		alog_get_local_fga_cache(int consumer_id);
 static AlogQueue *		alog_get_local_trace_cache(int consumer_id);
@@ -376,6 +404,7 @@ static void                alog_start_all_worker(void);
 #endif
 
 #ifdef AuditLog_006_For_Elog
+static void				alog_notify_consumer(int consumer_id);
 #endif
 
 #ifdef AuditLog_007_For_ShardStatistics
@@ -1075,6 +1104,25 @@ static Size audit_shared_trace_queue_array_size(void)
 	return alogTraceQueueSize;
 }
 
+static Size audit_shared_record_queue_elem_size(void)
+{
+	/* binary records are sized like the common audit log they replace */
+	return audit_queue_elem_size(AuditLog_common_log_queue_size_kb);
+}
+
+static Size audit_shared_record_queue_array_size(void)
+{
+	Size		alogRecordQueueSize = 0;
+
+	alogRecordQueueSize = audit_shared_record_queue_elem_size();
+	alogRecordQueueSize = mul_size(alogRecordQueueSize, MaxBackends);
+
+	alogRecordQueueSize = add_size(alogRecordQueueSize,
+								audit_shared_queue_array_header_size());
+
+	return alogRecordQueueSize;
+}
+
 static Size audit_shared_consumer_bitmap_size(void)
 {
     Size alogConsumerBitmapSize = 0;
@@ -1102,6 +1150,7 @@ Size AuditLoggerShmemSize(void)
 	Size		alogCommonQueueSize = 0;
 	Size		alogFgaQueueSize = 0;
 	Size		alogTraceQueueSize = 0;
+	Size		alogRecordQueueSize = 0;
 	Size		alogConsumerBmpSize = 0;
 
     /* for common audit log */
@@ -1113,12 +1162,17 @@ Size AuditLoggerShmemSize(void)
 	/* for trace audit log */
 	alogTraceQueueSize = audit_shared_trace_queue_array_size();
 
+	/* for binary common audit records, only if they can be used */
+	if (AuditLog_binary_records)
+		alogRecordQueueSize = audit_shared_record_queue_array_size();
+
 	/* for consumer notify bitmap */
 	alogConsumerBmpSize = audit_shared_consumer_bitmap_size();
 
 	/* for total size */
 	size = add_size(alogCommonQueueSize, alogFgaQueueSize);
 	size = add_size(size, alogTraceQueueSize);
+	size = add_size(size, alogRecordQueueSize);
 	size = add_size(size, alogConsumerBmpSize);
 
     return size;
@@ -1339,6 +1393,43 @@ void AuditLoggerShmemInit(void)
 	found = false;
 	i = 0;
 
+	/* binary records rings are left out while alog_binary_records is off */
+	if (AuditLog_binary_records)
+	{
+		alogBmpOffset = audit_shared_queue_array_bitmap_offset();
+		alogHeaderSize = audit_shared_queue_array_header_size();
+		alogItemSize = audit_shared_record_queue_elem_size();
+		alogArraySize = audit_shared_record_queue_array_size();
+
+		AuditRecordQueueArray = ShmemInitStruct("Audit Record Queue",
+												alogArraySize,
+												&found);
+		/* Mark it empty upon creation */
+		if (!found)
+		{
+			AlogQueueArray * alogQueueArray = AuditRecordQueueArray;
+
+			MemSet(alogQueueArray, 0, alogArraySize);
+
+			alogQueueArray->a_count = MaxBackends;
+			alogQueueArray->a_bitmap = bms_make(((char *) alogQueueArray) + alogBmpOffset,
+												MaxBackends);
+			for (i = 0; i < MaxBackends; i++)
+			{
+				AlogQueue * alogQueueItem = NULL;
+
+				alogQueueItem = (AlogQueue *)(((char *) alogQueueArray) + alogHeaderSize + i * alogItemSize);
+
+				alog_queue_init(alogQueueItem, AuditLog_common_log_queue_size_kb);
+
+				alogQueueArray->a_queue[i] = alogQueueItem;
+			}
+		}
+	}
+
+	found = false;
+	i = 0;
+
 	alogConsumerBmpSize = audit_shared_consumer_bitmap_size();
 
 	AuditConsumerNotifyBitmap = ShmemInitStruct("Audit Consumer Bitmap",
@@ -1723,8 +1814,10 @@ audit_log_file_getname(pg_time_t timestamp, const char *suffix)
     len = strlen(filename);
 
     /* treat AuditLog_filename as a strftime pattern */
+    pthread_mutex_lock(&audit_localtime_lock);
     pg_strftime(filename + len, MAXPGPATH - len, AuditLog_filename,
                 pg_localtime(&timestamp, log_timezone));
+    pthread_mutex_unlock(&audit_localtime_lock);
 
     if (suffix != NULL)
     {
@@ -1759,8 +1852,10 @@ trace_log_file_getname(pg_time_t timestamp, const char *suffix)
 	len = strlen(filename);
 
 	/* treat AuditLog_filename as a strftime pattern */
+	pthread_mutex_lock(&audit_localtime_lock);
 	pg_strftime(filename + len, MAXPGPATH - len, TraceLog_filename,
 				pg_localtime(&timestamp, log_timezone));
+	pthread_mutex_unlock(&audit_localtime_lock);
 
 	if (suffix != NULL)
 	{
@@ -1795,11 +1890,13 @@ audit_set_next_rotation_time(void)
      */
     rotinterval = AuditLog_RotationAge * SECS_PER_MINUTE;    /* convert to seconds */
     now = (pg_time_t) time(NULL);
+    pthread_mutex_lock(&audit_localtime_lock);
     tm = pg_localtime(&now, log_timezone);
     now += tm->tm_gmtoff;
     now -= now % rotinterval;
     now += rotinterval;
     now -= tm->tm_gmtoff;
+    pthread_mutex_unlock(&audit_localtime_lock);
     audit_next_rotation_time = now;
 }
 #endif
@@ -2046,6 +2143,8 @@ static bool alog_queue_pushn(AlogQueue * queue, char * buff[], int len[], int n)
     q_used_after = alog_queue_used(q_size, q_head, q_tail);
     Assert(q_used_before + total_len == q_used_after);
 
+    /* the consumer must see the content before the new tail */
+    pg_write_barrier();
     queue->q_tail = q_tail;
 
     return true;
@@ -2229,6 +2328,8 @@ static bool alog_queue_pop_to_queue(AlogQueue * from, AlogQueue * to)
         to_used = alog_queue_used(to_size, to_head, to_tail);
     } while (!alog_queue_is_empty(from_size, from_head, from_tail));
 
+    /* finish reading before the producer may reuse the space */
+    pg_memory_barrier();
     from->q_head = from_head;
 
     return true;
@@ -2343,11 +2444,190 @@ static bool alog_queue_pop_to_file(AlogQueue * from, int destination)
 		from_used = alog_queue_used(from_size, from_head, from_tail);
 	} while (!alog_queue_is_empty(from_size, from_head, from_tail));
 
+	/* finish reading before the producer may reuse the space */
+	pg_memory_barrier();
 	from->q_head = from_head;
 
 	return true;
 }
 
+/*
+ * copy len bytes at offset out of queue, which may wrap around
+ */
+static void alog_queue_copy_out(AlogQueue * queue, int offset, char * buff, int len)
+{
+	int first_len = Min(len, queue->q_size - offset);
+
+	memcpy(buff, alog_queue_offset_to(queue, offset), first_len);
+	if (len > first_len)
+	{
+		memcpy(buff + first_len, alog_queue_offset_to(queue, 0), len - first_len);
+	}
+}
+
+/*
+ * format timestamp like audit log does, safe in audit logger threads
+ */
+static void alog_format_time(char * buff, int size, pg_time_t timestamp)
+{
+	pthread_mutex_lock(&audit_localtime_lock);
+	pg_strftime(buff, size, "%Y-%m-%d %H:%M:%S %Z",
+				pg_localtime(&timestamp, log_timezone));
+	pthread_mutex_unlock(&audit_localtime_lock);
+}
+
+/*
+ * Format a binary common audit record into the text the audit log has
+ * always had, cut to text_size if needed, and return its length including
+ * the trailing newline.
+ *
+ * Called by consumer threads, so no palloc and no elog here.
+ */
+static int alog_record_format(const char * record, char * text, int text_size)
+{
+#define AREC_STR(i)		((int) rec.str_len[(i)]), str[(i)]
+	AuditRecordData rec;
+	const char * str[AREC_NSTRINGS];
+	const char * p = NULL;
+	char start_time[128] = { '\0' };
+	char begin_time[128] = { '\0' };
+	char end_time[128] = { '\0' };
+	int len = 0;
+	int i = 0;
+
+	memcpy(&rec, record, sizeof(AuditRecordData));
+	p = record + sizeof(AuditRecordData);
+	for (i = 0; i < AREC_NSTRINGS; i++)
+	{
+		str[i] = p;
+		p += rec.str_len[i];
+	}
+
+	alog_format_time(start_time, sizeof(start_time), rec.proc_start_time);
+	alog_format_time(begin_time, sizeof(begin_time), rec.qry_begin_time);
+	alog_format_time(end_time, sizeof(end_time), rec.qry_end_time);
+
+	len = snprintf(text, text_size,
+				"AuditOutMessage: "
+				"AuditType: \"%.*s\", "
+				"QueryString: \"%.*s\", "
+				"TopCommandTag: \"%.*s\", "
+				"DatabaseID: %u, "
+				"DatabaseName: \"%.*s\", "
+				"DatabaseUserID: %u, "
+				"DatabaseUserName: \"%.*s\", "
+				"NodeOid: %u, "
+				"NodeName: \"%.*s\", "
+				"NodeType: \"%.*s\", "
+				"NodeHost: \"%.*s\", "
+				"NodePort: %d, "
+				"NodeOSUser: \"%.*s\", "
+				"PostgresPID: %u, "
+				"PostmasterPID: %u, "
+				"BackendStartTime: \"%s\", "
+				"QueryBeginTime: \"%s\", "
+				"QueryEndTime: \"%s\", "
+				"QueryIsSuccess: %d, "
+				"ClientHost: \"%.*s\", "
+				"ClientHostname: \"%.*s\", "
+				"ClientPort: \"%.*s\", "
+				"AppName: \"%.*s\", "
+				"ObjectClassID: %u, "
+				"ObjectId: %u, "
+				"ObjectSubId: %d, "
+				"ObjectType: \"%.*s\", "
+				"ObjectName: \"%.*s\", "
+				"ActionID: %d, "
+				"ActionName: \"%.*s\", "
+				"ExecStatus: \"%.*s\" ",
+				AREC_STR(AREC_AUDIT_TYPE),
+				AREC_STR(AREC_QUERY_STRING),
+				AREC_STR(AREC_COMMAND_TAG),
+				rec.db_id,
+				AREC_STR(AREC_DB_NAME),
+				rec.db_user_id,
+				AREC_STR(AREC_DB_USER_NAME),
+				rec.node_oid,
+				AREC_STR(AREC_NODE_NAME),
+				AREC_STR(AREC_NODE_TYPE),
+				AREC_STR(AREC_NODE_HOST),
+				rec.node_port,
+				AREC_STR(AREC_NODE_OSUSER),
+				rec.proc_pid,
+				rec.proc_ppid,
+				start_time,
+				begin_time,
+				end_time,
+				rec.is_success,
+				AREC_STR(AREC_CLIENT_HOST),
+				AREC_STR(AREC_CLIENT_HOSTNAME),
+				AREC_STR(AREC_CLIENT_PORT),
+				AREC_STR(AREC_APP_NAME),
+				rec.obj_class_id,
+				rec.obj_id,
+				rec.obj_sub_id,
+				AREC_STR(AREC_OBJECT_TYPE),
+				AREC_STR(AREC_OBJECT_NAME),
+				rec.action_id,
+				AREC_STR(AREC_ACTION_NAME),
+				AREC_STR(AREC_EXEC_STATUS));
+
+	/* keep room for the newline, a cut record still ends a line */
+	if (len < 0 || len > text_size - 2)
+	{
+		len = text_size - 2;
+	}
+	text[len++] = '\n';
+	text[len] = '\0';
+
+	return len;
+#undef AREC_STR
+}
+
+/*
+ * format binary records from a backend record ring into a consumer's
+ * common log cache, as many as fit
+ */
+static bool alog_queue_pop_records_to_queue(AlogQueue * from, AlogQueue * to,
+											char * record_buff, char * text_buff,
+											int text_size)
+{
+	int from_head = from->q_head;
+	int from_tail = from->q_tail;
+	int from_size = from->q_size;
+	bool copyed = false;
+
+	/* read the tail before the records it covers */
+	pg_read_barrier();
+
+	while (!alog_queue_is_empty(from_size, from_head, from_tail))
+	{
+		int record_len = alog_queue_get_str_len(from, from_head);
+		int record_offset = (from_head + sizeof(int)) % from_size;
+		int text_len = 0;
+
+		alog_queue_copy_out(from, record_offset, record_buff, record_len);
+		text_len = alog_record_format(record_buff, text_buff, text_size);
+
+		if (!alog_queue_push2(to, (char *)(&text_len), sizeof(int), text_buff, text_len))
+		{
+			break;
+		}
+
+		from_head = (from_head + sizeof(int) + record_len) % from_size;
+		copyed = true;
+	}
+
+	if (copyed)
+	{
+		/* finish reading before the producer may reuse the space */
+		pg_memory_barrier();
+		from->q_head = from_head;
+	}
+
+	return copyed;
+}
+
 #endif
 
 #ifdef AuditLog_005_For_ThreadWorker
@@ -2365,6 +2645,7 @@ int AuditLoggerQueueAcquire(void)
 	AlogQueue * common_queue = NULL;
 	AlogQueue * fga_queue = NULL;
 	AlogQueue * trace_queue = NULL;
+	AlogQueue * record_queue = NULL;
 
     if (!IsBackendPostgres)
     {
@@ -2380,14 +2661,18 @@ int AuditLoggerQueueAcquire(void)
 	common_queue = alog_get_shared_common_queue(alogIdx);
 	fga_queue = alog_get_shared_fga_queue(alogIdx);
 	trace_queue = alog_get_shared_trace_queue(alogIdx);
+	record_queue = alog_get_shared_record_queue(alogIdx);
 
 	Assert(common_queue->q_pid == fga_queue->q_pid);
 	Assert(common_queue->q_pid == trace_queue->q_pid);
+	Assert(record_queue == NULL || common_queue->q_pid == record_queue->q_pid);
 
 	AuditPostgresAlogQueueIndex = alogIdx;
 	common_queue->q_pid = MyProcPid;
 	fga_queue->q_pid = MyProcPid;
 	trace_queue->q_pid = MyProcPid;
+	if (record_queue != NULL)
+		record_queue->q_pid = MyProcPid;
 
     if (enable_auditlogger_warning)
     {
@@ -2428,6 +2713,17 @@ static AlogQueue * alog_get_shared_trace_queue(int idx)
 	return queue;
 }
 
+static AlogQueue * alog_get_shared_record_queue(int idx)
+{
+	AlogQueue * queue = NULL;
+
+	Assert(idx >= 0 && idx < MaxBackends);
+	if (AuditRecordQueueArray != NULL)
+		queue = AuditRecordQueueArray->a_queue[idx];
+
+	return queue;
+}
+
 static AlogQueue * alog_get_local_common_cache(int consumer_id)
 {
     AlogQueue * queue = NULL;
@@ -2573,9 +2869,17 @@ static void * alog_consumer_main(void * arg)
 	AlogQueue * local_common_cache = NULL;
 	AlogQueue * local_fga_cache = NULL;
 	AlogQueue * local_trace_cache = NULL;
+	char * record_buff = NULL;
+	char * text_buff = NULL;
+	int text_size = 0;
 
 	Assert(consumer_id >= 0 && consumer_id < AuditLog_max_worker_number);
 
+	/* buffers to format binary records, text must fit into the local cache */
+	record_buff = AuditConsumerRecordBuffers[consumer_id];
+	text_buff = AuditConsumerTextBuffers[consumer_id];
+	text_size = AuditLog_common_log_cache_size_kb * BYTES_PER_KB - sizeof(int) - 1;
+
 	/* get local common queue cache entry from AuditCommonLogLocalCache */
 	local_common_cache = alog_get_local_common_cache(consumer_id);
 
@@ -2595,6 +2899,7 @@ static void * alog_consumer_main(void * arg)
 			AlogQueue * shared_common_queue = NULL;
 			AlogQueue * shared_fga_queue = NULL;
 			AlogQueue * shared_trace_queue = NULL;
+			AlogQueue * shared_record_queue = NULL;
 
 			Assert(consumer_id == (sharedIdx % AuditLog_max_worker_number));
 
@@ -2626,6 +2931,25 @@ static void * alog_consumer_main(void * arg)
 					}
 				}
 
+				/* format binary records into the same local cache */
+				shared_record_queue = alog_get_shared_record_queue(sharedIdx);
+
+				local_is_empty = false;
+				if (alog_queue_is_empty2(local_common_cache))
+				{
+					local_is_empty = true;
+				}
+
+				if (shared_record_queue != NULL &&
+					alog_queue_pop_records_to_queue(shared_record_queue, local_common_cache,
+													record_buff, text_buff, text_size))
+				{
+					if (local_is_empty)
+					{
+						alog_writer_wakeup(AUDIT_COMMON_LOG);
+					}
+				}
+
 				local_is_empty = false;
 				if (alog_queue_is_empty2(local_fga_cache))
 				{
@@ -2656,7 +2980,8 @@ static void * alog_consumer_main(void * arg)
 
 				if (!alog_queue_is_empty2(shared_common_queue) ||
 					!alog_queue_is_empty2(shared_fga_queue) ||
-					!alog_queue_is_empty2(shared_trace_queue))
+					!alog_queue_is_empty2(shared_trace_queue) ||
+					(shared_record_queue != NULL && !alog_queue_is_empty2(shared_record_queue)))
 				{
 					shared_is_empty = false;
 				}
@@ -2863,6 +3188,15 @@ static void alog_start_all_worker(void)
 											Maintain_trace_log_cache_size_kb);
 	AuditConsumerNotifySemas = alog_make_consumer_semas(AuditLog_max_worker_number);
 
+	/* consumer threads must not palloc, give them their format buffers */
+	AuditConsumerRecordBuffers = palloc0(AuditLog_max_worker_number * sizeof(char *));
+	AuditConsumerTextBuffers = palloc0(AuditLog_max_worker_number * sizeof(char *));
+	for (i = 0; i < AuditLog_max_worker_number; i++)
+	{
+		AuditConsumerRecordBuffers[i] = palloc(AuditLog_common_log_queue_size_kb * BYTES_PER_KB);
+		AuditConsumerTextBuffers[i] = palloc(AuditLog_common_log_cache_size_kb * BYTES_PER_KB);
+	}
+
 	/* 00, start writer worker, one for common log, one for fga log, one for trace log. */
 	alog_start_writer(AUDIT_COMMON_LOG);
 	alog_start_writer(AUDIT_FGA_LOG);
@@ -2959,23 +3293,104 @@ void alog(int destination, const char *fmt,...)
 	len = buf.len;
 	while (false == alog_queue_push(queue, buf.data, len))
 	{
-		if (!audit_shared_consumer_bitmap_get_value(consumer_id))
-		{
-			/*
-			 * set shared consumer bitmap value to 1 to
-			 * notify consumer to read log
-			 */
-			audit_shared_consumer_bitmap_set_value(consumer_id, 1);
+		alog_notify_consumer(consumer_id);
+		pg_usleep(AUDIT_SLEEP_MICROSEC);
+	}
+
+	pfree(buf.data);
 
-			/* Notify logger process that it's got something to do */
-			SendPostmasterSignal(PMSIGNAL_WAKEN_AUDIT_LOGGER);
+	alog_notify_consumer(consumer_id);
+}
+
+/*
+ * Write a common audit log record in binary form into the record ring of
+ * this backend. The consumer threads of audit logger format it, so the
+ * query path only copies the fields.
+ *
+ * str[] holds the AuditRecordString fields, NULL is written as "(null)"
+ * like alog() would. The query string is cut if the record does not fit
+ * into the ring.
+ */
+void alog_record(AuditRecordData *rec, const char *str[AREC_NSTRINGS])
+{
+	AlogQueue * queue = NULL;
+	char * buff[AREC_NSTRINGS + 2];
+	int len[AREC_NSTRINGS + 2];
+	int record_len = 0;
+	int max_len = 0;
+	int idx = 0;
+	int consumer_id = 0;
+	int i = 0;
+
+	if (!IsBackendPostgres ||
+		!IsUnderPostmaster)
+	{
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("only postgres backend can write audit log")));
+		return;
+	}
+
+	Assert(AuditPostgresAlogQueueIndex >= 0 &&
+		   AuditPostgresAlogQueueIndex < MaxBackends);
+
+	idx = AuditPostgresAlogQueueIndex;
+	consumer_id = (idx % AuditLog_max_worker_number);
+	queue = alog_get_shared_record_queue(idx);
+
+	Assert(queue->q_pid == getpid());
+
+	record_len = sizeof(AuditRecordData);
+	for (i = 0; i < AREC_NSTRINGS; i++)
+	{
+		buff[i + 2] = (char *) (str[i] ? str[i] : "(null)");
+		rec->str_len[i] = strlen(buff[i + 2]);
+		record_len += rec->str_len[i];
+	}
+
+	/* a record must fit into the ring, same as alog_queue_is_enough */
+	max_len = queue->q_size - 2 - sizeof(int);
+	if (record_len > max_len)
+	{
+		int query_len = rec->str_len[AREC_QUERY_STRING];
+		int cut_len = Max(query_len - (record_len - max_len), 0);
+
+		cut_len = pg_mbcliplen(buff[AREC_QUERY_STRING + 2], query_len, cut_len);
+		record_len -= query_len - cut_len;
+		rec->str_len[AREC_QUERY_STRING] = cut_len;
+
+		if (record_len > max_len)
+		{
+			elog(WARNING, "audit record of %d bytes exceeds alog_common_queue_size, skipped",
+				 record_len);
+			return;
 		}
+	}
 
+	buff[0] = (char *)(&record_len);
+	len[0] = sizeof(int);
+	buff[1] = (char *) rec;
+	len[1] = sizeof(AuditRecordData);
+	for (i = 0; i < AREC_NSTRINGS; i++)
+	{
+		len[i + 2] = rec->str_len[i];
+	}
+
+	while (false == alog_queue_pushn(queue, buff, len, AREC_NSTRINGS + 2))
+	{
+		alog_notify_consumer(consumer_id);
 		pg_usleep(AUDIT_SLEEP_MICROSEC);
 	}
 
-	pfree(buf.data);
+	alog_notify_consumer(consumer_id);
+}
 
+/*
+ * Wake up the consumer of a backend's queues through postmaster, unless it
+ * has already been told and not gone to sleep since.
+ */
+static void alog_notify_consumer(int consumer_id)
+{
 	if (!audit_shared_consumer_bitmap_get_value(consumer_id))
 	{
 		/*
@@ -76,6 +76,8 @@
 
 #include "libpq/pqsignal.h"
 #include "access/parallel.h"
+#include "access/xlogredo.h"
+#include "postmaster/globaldeadlock.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/atomics.h"
@@ -197,6 +199,12 @@ static const struct
     },
     {
         "ApplyWorkerMain", ApplyWorkerMain
+    },
+    {
+        "ParallelRedoWorkerMain", ParallelRedoWorkerMain
+    },
+    {
+        "GlobalDeadlockDetectorMain", GlobalDeadlockDetectorMain
     }
 #ifdef __AUDIT_FGA__
     ,{
@@ -16,20 +16,29 @@
 
 #include "postgres.h"
 
+#include "access/gtm.h"
 #include "access/htup_details.h"
+#include "access/transam.h"
+#include "access/twophase.h"
+#include "access/xact.h"
 #include "catalog/pg_database.h"
 #include "catalog/pg_type.h"
 #include "commands/dbcommands.h"
 #include "executor/executor.h"
+#include "funcapi.h"
 #include "libpq/pqsignal.h"
 #include "nodes/makefuncs.h"
 #include "postmaster/clean2pc.h"
 #include "postmaster/fork_process.h"
 #include "postmaster/postmaster.h"
 #include "pgxc/execRemote.h"
+#include "pgxc/locator.h"
+#include "pgxc/pgxcnode.h"
 #include "storage/buf_internals.h"
 #include "storage/ipc.h"
 #include "storage/pmsignal.h"
+#include "storage/procarray.h"
+#include "storage/spin.h"
 #include "tcop/tcopprot.h"
 #include "utils/builtins.h"
 #include "utils/lsyscache.h"
@@ -46,6 +55,9 @@
 #define DB_TEMPLATE1     "template1"
 #define DB_DEFAULT       "postgres"
 
+#define MAX_LOCAL_2PC     1000
+#define MAX_RESOLVE_GIDS  64
+
 typedef enum
 {
 	Query2pcAttr_gid             = 0,
@@ -56,6 +68,7 @@ typedef enum
 } Query2pcAttrEnum;
 
 bool enable_clean_2pc_launcher = true;
+bool enable_clean_2pc_local_resolve = true;
 
 int auto_clean_2pc_interval        = 60;
 int auto_clean_2pc_delay           = 300;
@@ -82,11 +95,12 @@ Clean2pcLauncherMain(int argc, char *argv[]) pg_attribute_noreturn();
 NON_EXEC_STATIC void
 Clean2pcWorkerMain(int argc, char *argv[]) pg_attribute_noreturn();
 
-static void	start_query_worker(TimestampTz clean_time);
+static void	start_query_worker(TimestampTz clean_time, bool resolve_only);
 static void	start_clean_worker(int count);
 
 static void do_query_2pc(TimestampTz clean_time);
 static void do_clean_2pc(TimestampTz clean_time);
+static void do_resolve_local_2pc(bool query_only);
 
 static void clean_2pc_sigterm_handler(SIGNAL_ARGS);
 static void clean_2pc_sighup_handler(SIGNAL_ARGS);
@@ -96,6 +110,7 @@ static List *get_database_list(void);
 static Oid   get_default_database(void);
 
 static void ExitCleanRunning(int status, Datum arg);
+static void ExitCleanLauncher(int status, Datum arg);
 
 /* struct to keep track of databases in worker */
 typedef struct Clean2pcDBInfo
@@ -104,6 +119,30 @@ typedef struct Clean2pcDBInfo
 	char *db_name;
 } Clean2pcDBInfo;
 
+/*
+ * An in-doubt implicit 2pc started from this coordinator, read from its
+ * local 2pc record.
+ */
+typedef struct Clean2pcRecord
+{
+	char            gid[GIDSIZE];    /* hash key */
+	TransactionId   startxid;
+	GlobalTimestamp commit_ts;       /* valid once the commit phase began */
+	char           *participants;
+	bool            prepared;        /* still prepared on some node */
+	bool            prepared_local;  /* still prepared on this node */
+	bool            queued;          /* prepared in the current database */
+	int             pending;         /* remote nodes left to finish it on */
+} Clean2pcRecord;
+
+/* a node holding in-doubt 2pc of the current database */
+typedef struct Clean2pcNode
+{
+	Oid             nodeoid;
+	List           *records;         /* Clean2pcRecord, finished in order */
+	PGXCNodeHandle *handle;
+} Clean2pcNode;
+
 typedef struct
 {
 	TimestampTz clean_time;
@@ -113,6 +152,23 @@ typedef struct
 
 	int  db_count;
 	Oid  db_list[MAX_DB_SIZE];
+
+	/*
+	 * Local resolve: 2pc started before startup_xid, the next xid when
+	 * recovery ended, were left by an earlier life of this node, so they
+	 * are in doubt as soon as we see them.
+	 * Backends that fail in the commit phase queue their gid in requests
+	 * and wake the launcher; the query worker moves them to resolving.
+	 */
+	bool          resolve_only;
+	pid_t         launcher_pid;
+	TransactionId startup_xid;
+	int           nresolving;
+	char          resolving[MAX_RESOLVE_GIDS][GIDSIZE];
+
+	slock_t       mutex;    /* protects requests */
+	int           nrequests;
+	char          requests[MAX_RESOLVE_GIDS][GIDSIZE];
 } Clean2pcShmemStruct;
 
 static Clean2pcShmemStruct *Clean2pcShmem = NULL;
@@ -213,8 +269,11 @@ Clean2pcLauncherMain(int argc, char *argv[])
 	Clean2pcShmem->worker_running = false;
 	Clean2pcShmem->db_count = 0;
 	Clean2pcShmem->worker_db = InvalidOid;
+	Clean2pcShmem->launcher_pid = MyProcPid;
 	LWLockRelease(Clean2pcLock);
 
+	on_shmem_exit(ExitCleanLauncher, 0);
+
 	if (result_str == NULL)
 	{
 		MemoryContext oldcontext = MemoryContextSwitchTo(TopMemoryContext);
@@ -222,6 +281,15 @@ Clean2pcLauncherMain(int argc, char *argv[])
 		MemoryContextSwitchTo(oldcontext);
 	}
 
+	/*
+	 * 2pc left in doubt by a crash of this node can be resolved from the
+	 * local records at once, no need to wait for them to age.
+	 */
+	if (enable_clean_2pc_local_resolve)
+	{
+		start_query_worker(clean_time, true);
+	}
+
 	wait_time = auto_clean_2pc_delay;
 	for (;;)
 	{
@@ -245,15 +313,28 @@ Clean2pcLauncherMain(int argc, char *argv[])
 
 		if (got_SIGUSR2)
 		{
+			bool resolve = false;
+
 			got_SIGUSR2 = false;
+
 			clean_time = GetCurrentTimestamp();
 			wait_time = auto_clean_2pc_delay;
 			elog(LOG, "2pc clean launcher got SIGUSR2, clean_time: "
 				INT64_FORMAT, clean_time);
+
+			SpinLockAcquire(&Clean2pcShmem->mutex);
+			resolve = (Clean2pcShmem->nrequests > 0);
+			SpinLockRelease(&Clean2pcShmem->mutex);
+
+			if (resolve && enable_clean_2pc_local_resolve)
+			{
+				start_query_worker(clean_time, true);
+				wait_time = auto_clean_2pc_interval;
+			}
 			continue;
 		}
 
-		start_query_worker(clean_time);
+		start_query_worker(clean_time, false);
 
 		if (got_SIGTERM || got_SIGHUP || got_SIGUSR2)
 		{
@@ -379,13 +460,27 @@ Clean2pcWorkerMain(int argc, char *argv[])
 	if (Clean2pcShmem->db_count == 0)
 	{
 		elog(DEBUG5, "query 2pc from db: %s", db_name);
-		do_query_2pc(Clean2pcShmem->clean_time);
+		if (!Clean2pcShmem->resolve_only)
+		{
+			do_query_2pc(Clean2pcShmem->clean_time);
+		}
+		if (enable_clean_2pc_local_resolve)
+		{
+			do_resolve_local_2pc(true);
+		}
 		clean_db_count = Clean2pcShmem->db_count;
 	}
 	else
 	{
 		elog(LOG, "clean 2pc for db: %s", db_name);
-		do_clean_2pc(Clean2pcShmem->clean_time);
+		if (enable_clean_2pc_local_resolve)
+		{
+			do_resolve_local_2pc(false);
+		}
+		if (!Clean2pcShmem->resolve_only)
+		{
+			do_clean_2pc(Clean2pcShmem->clean_time);
+		}
 	}
 
 	Clean2pcShmem->worker_running = false;
@@ -686,6 +781,556 @@ do_clean_2pc(TimestampTz clean_time)
 	}
 }
 
+/*
+ * Parse the local 2pc record of an implicit transaction, see
+ * record_2pc_involved_nodes_xid and record_2pc_commit_timestamp.
+ */
+static bool
+parse_2pc_record(Record2pcEntry *entry, Clean2pcRecord *rec)
+{
+	char *pos = NULL;
+	char *end = NULL;
+
+	/*
+	 * Transactions the user prepared explicitly are the user's to finish,
+	 * whatever state their start node is in.
+	 */
+	if (!IsXidImplicit(entry->gid))
+	{
+		return false;
+	}
+
+	/* read-only ones are left to pg_clean */
+	if (strstr(entry->info, "readonly") != NULL)
+	{
+		return false;
+	}
+
+	pos = strstr(entry->info, "startxid:");
+	if (NULL == pos)
+	{
+		return false;
+	}
+	rec->startxid = (TransactionId) strtoul(pos + strlen("startxid:"), NULL, 10);
+
+	pos = strstr(entry->info, "nodes:");
+	if (NULL == pos)
+	{
+		return false;
+	}
+	pos += strlen("nodes:");
+	end = strchr(pos, '\n');
+	rec->participants = end ? pnstrdup(pos, end - pos) : pstrdup(pos);
+
+	rec->commit_ts = InvalidGlobalTimestamp;
+	pos = strstr(entry->info, "global_commit_timestamp:");
+	if (pos != NULL)
+	{
+		rec->commit_ts = (GlobalTimestamp) strtoll(pos +
+							strlen("global_commit_timestamp:"), NULL, 10);
+	}
+
+	return TransactionIdIsValid(rec->startxid) && rec->participants[0] != '\0';
+}
+
+/*
+ * Was the 2pc gid started from this node left by an earlier life of it?
+ *
+ * It must have started before recovery ended, so no backend of this life
+ * runs it.  Checking the xid is not enough: once a coordinator has prepared
+ * locally, the xid moves to the dummy PGPROC of the prepared transaction.
+ * A live backend finishing it holds the lock on the gid, and the prepared
+ * transaction is left alone while it is busy.
+ */
+static bool
+local_2pc_left_by_crash(const char *gid, Clean2pcRecord *rec)
+{
+	if (!TransactionIdPrecedes(rec->startxid, Clean2pcShmem->startup_xid))
+	{
+		return false;
+	}
+
+	if (BackendXidGetPid(rec->startxid) != 0)
+	{
+		return false;
+	}
+
+	return !TwoPhaseGidIsBusy(gid);
+}
+
+/*
+ * Collect the in-doubt 2pc started from this node.  The outcome is decided
+ * by the start node record alone: the global commit timestamp is written
+ * to it before any participant is told to commit, so a record without one
+ * never reached the commit phase and is rolled back.
+ */
+static HTAB *
+collect_local_2pc(bool query_only)
+{
+	HASHCTL   ctl;
+	HTAB     *records = NULL;
+	List     *entries = NIL;
+	ListCell *lc = NULL;
+	int       i = 0;
+
+	if (query_only)
+	{
+		/* pick up the gids backends asked us to resolve */
+		SpinLockAcquire(&Clean2pcShmem->mutex);
+		for (i = 0; i < Clean2pcShmem->nrequests; i++)
+		{
+			strlcpy(Clean2pcShmem->resolving[i], Clean2pcShmem->requests[i],
+					GIDSIZE);
+		}
+		Clean2pcShmem->nresolving = Clean2pcShmem->nrequests;
+		Clean2pcShmem->nrequests = 0;
+		SpinLockRelease(&Clean2pcShmem->mutex);
+	}
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = GIDSIZE;
+	ctl.entrysize = sizeof(Clean2pcRecord);
+	ctl.hcxt = CurrentMemoryContext;
+	records = hash_create("Clean 2pc records", 256, &ctl,
+						  HASH_ELEM | HASH_CONTEXT);
+
+	entries = get_2pc_records_by_startnode(PGXCNodeName, MAX_LOCAL_2PC);
+	foreach(lc, entries)
+	{
+		Record2pcEntry *entry = (Record2pcEntry *) lfirst(lc);
+		Clean2pcRecord  rec;
+		Clean2pcRecord *hentry = NULL;
+		bool            in_doubt = false;
+
+		if (strlen(entry->gid) >= GIDSIZE)
+		{
+			continue;
+		}
+
+		MemSet(&rec, 0, sizeof(rec));
+		if (!parse_2pc_record(entry, &rec))
+		{
+			continue;
+		}
+
+		if (local_2pc_left_by_crash(entry->gid, &rec))
+		{
+			in_doubt = true;
+		}
+
+		for (i = 0; !in_doubt && i < Clean2pcShmem->nresolving; i++)
+		{
+			if (strcmp(Clean2pcShmem->resolving[i], entry->gid) == 0)
+			{
+				in_doubt = true;
+			}
+		}
+
+		if (!in_doubt)
+		{
+			continue;
+		}
+
+		hentry = (Clean2pcRecord *) hash_search(records, entry->gid,
+												HASH_ENTER, NULL);
+		hentry->startxid = rec.startxid;
+		hentry->commit_ts = rec.commit_ts;
+		hentry->participants = rec.participants;
+		hentry->prepared = false;
+		hentry->prepared_local = false;
+		hentry->queued = false;
+		hentry->pending = 0;
+	}
+
+	return records;
+}
+
+/*
+ * Find where the in-doubt 2pc are still prepared, on all nodes of type
+ * exec_type at once.  In query mode remember their databases for the clean
+ * workers, otherwise queue the ones of our database on their nodes.
+ */
+static void
+scan_prepared_2pc(HTAB *records, RemoteQueryExecType exec_type, List *nodes,
+				  bool query_only, List **clean_nodes)
+{
+	int                  i = 0;
+	MemoryContext        oldcontext = NULL;
+	char                 query[SQL_CMD_LEN];
+	char                *db_name = get_database_name(MyDatabaseId);
+	EState              *estate = NULL;
+	RemoteQuery         *plan = NULL;
+	RemoteQueryState    *pstate = NULL;
+	TupleTableSlot      *result = NULL;
+	Var                 *dummy = NULL;
+	int                  attr_num = 3;
+
+	if (nodes == NIL)
+	{
+		return;
+	}
+
+	snprintf(query, SQL_CMD_LEN, "select gid::text, database::text, "
+		"pgxc_node_str()::text from pg_prepared_xacts where gid like '%%:%s:%%';",
+		PGXCNodeName);
+
+	plan = makeNode(RemoteQuery);
+	plan->combine_type = COMBINE_TYPE_NONE;
+	plan->exec_nodes = makeNode(ExecNodes);
+	plan->exec_type = exec_type;
+	plan->exec_nodes->nodeList = nodes;
+	plan->sql_statement = (char*)query;
+	plan->force_autocommit = false;
+
+	for (i = 1; i <= attr_num; i++)
+	{
+		dummy = makeVar(1, i, TEXTOID, 0, InvalidOid, 0);
+		plan->scan.plan.targetlist = lappend(plan->scan.plan.targetlist,
+										makeTargetEntry((Expr *) dummy, i, NULL, false));
+	}
+
+	estate = CreateExecutorState();
+	oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+	estate->es_snapshot = GetActiveSnapshot();
+	pstate = ExecInitRemoteQuery(plan, estate, 0);
+	MemoryContextSwitchTo(oldcontext);
+
+	result = ExecRemoteQuery((PlanState *) pstate);
+
+	while (result != NULL && !TupIsNull(result))
+	{
+		char           *gid = NULL;
+		char           *database = NULL;
+		char           *node_name = NULL;
+		Clean2pcRecord *rec = NULL;
+
+		slot_getallattrs(result);
+
+		gid = text_to_cstring(DatumGetTextP(result->tts_values[0]));
+		database = text_to_cstring(DatumGetTextP(result->tts_values[1]));
+		node_name = text_to_cstring(DatumGetTextP(result->tts_values[2]));
+
+		if (strlen(gid) < GIDSIZE)
+		{
+			rec = (Clean2pcRecord *) hash_search(records, gid, HASH_FIND, NULL);
+		}
+
+		if (rec != NULL)
+		{
+			rec->prepared = true;
+
+			if (query_only)
+			{
+				Oid db_oid = get_database_oid(database, true);
+
+				for (i = 0; i < Clean2pcShmem->db_count; i++)
+				{
+					if (Clean2pcShmem->db_list[i] == db_oid)
+					{
+						break;
+					}
+				}
+
+				if (OidIsValid(db_oid) && i == Clean2pcShmem->db_count &&
+					Clean2pcShmem->db_count < MAX_DB_SIZE)
+				{
+					Clean2pcShmem->db_list[Clean2pcShmem->db_count++] = db_oid;
+				}
+			}
+			else if (strcmp(database, db_name) == 0)
+			{
+				Oid           node_oid = get_pgxc_nodeoid(node_name);
+				Clean2pcNode *node = NULL;
+				ListCell     *lc = NULL;
+
+				if (strcmp(node_name, PGXCNodeName) == 0)
+				{
+					rec->prepared_local = true;
+				}
+				else
+				{
+					rec->pending++;
+				}
+
+				foreach(lc, *clean_nodes)
+				{
+					if (((Clean2pcNode *) lfirst(lc))->nodeoid == node_oid)
+					{
+						node = (Clean2pcNode *) lfirst(lc);
+						break;
+					}
+				}
+
+				if (NULL == node)
+				{
+					node = (Clean2pcNode *) palloc0(sizeof(Clean2pcNode));
+					node->nodeoid = node_oid;
+					*clean_nodes = lappend(*clean_nodes, node);
+				}
+				node->records = lappend(node->records, rec);
+				rec->queued = true;
+			}
+		}
+
+		result = ExecRemoteQuery((PlanState *) pstate);
+	}
+
+	ExecEndRemoteQuery(pstate);
+}
+
+/*
+ * Finish the queued 2pc on the given nodes.  Every round sends the next
+ * COMMIT/ROLLBACK PREPARED to each node and waits for all of them, so the
+ * nodes work in parallel and one slow node delays only its own queue.
+ */
+static void
+finish_on_nodes(Clean2pcNode **nodes, int count, bool local)
+{
+	PGXCNodeHandle   **connections = NULL;
+	Clean2pcRecord   **sent = NULL;
+	ResponseCombiner   combiner;
+	char               command[GIDSIZE + 32];
+	int                conn_count = 0;
+	int                i = 0;
+
+	connections = (PGXCNodeHandle **) palloc(sizeof(PGXCNodeHandle *) * count);
+	sent = (Clean2pcRecord **) palloc(sizeof(Clean2pcRecord *) * count);
+
+	for (;;)
+	{
+		conn_count = 0;
+
+		for (i = 0; i < count; i++)
+		{
+			PGXCNodeHandle *conn = nodes[i]->handle;
+			Clean2pcRecord *rec = NULL;
+			bool            commit = false;
+
+			if (nodes[i]->records == NIL)
+			{
+				continue;
+			}
+
+			rec = (Clean2pcRecord *) linitial(nodes[i]->records);
+			nodes[i]->records = list_delete_first(nodes[i]->records);
+			commit = GlobalTimestampIsValid(rec->commit_ts);
+
+			snprintf(command, sizeof(command), "%s PREPARED '%s'",
+					 commit ? "COMMIT" : "ROLLBACK", rec->gid);
+
+			if (pgxc_node_send_clean(conn) ||
+				(commit && pgxc_node_send_global_timestamp(conn, rec->commit_ts)) ||
+				pgxc_node_send_starter(conn, PGXCNodeName) ||
+				pgxc_node_send_startxid(conn, rec->startxid) ||
+				pgxc_node_send_partnodes(conn, rec->participants) ||
+				pgxc_node_send_query(conn, command))
+			{
+				ereport(ERROR,
+						(errcode(ERRCODE_INTERNAL_ERROR),
+						 errmsg("failed to send \"%s\" to node %s",
+								command, conn->nodename)));
+			}
+
+			connections[conn_count] = conn;
+			sent[conn_count++] = rec;
+		}
+
+		if (conn_count == 0)
+		{
+			break;
+		}
+
+		InitResponseCombiner(&combiner, conn_count, COMBINE_TYPE_NONE);
+		if (pgxc_node_receive_responses(conn_count, connections, NULL, &combiner) ||
+			!validate_combiner(&combiner))
+		{
+			if (combiner.errorMessage)
+				pgxc_node_report_error(&combiner);
+			else
+				ereport(ERROR,
+						(errcode(ERRCODE_INTERNAL_ERROR),
+						 errmsg("failed to finish in-doubt 2pc on one or more nodes")));
+		}
+		else
+			CloseCombiner(&combiner);
+
+		for (i = 0; !local && i < conn_count; i++)
+		{
+			sent[i]->pending--;
+		}
+	}
+
+	pfree(connections);
+	pfree(sent);
+}
+
+/*
+ * Drop the start node record and the GTM entry of a resolved 2pc.  When
+ * this node was a participant, finishing it here already took care of the
+ * record.
+ */
+static void
+forget_local_2pc(Clean2pcRecord *rec)
+{
+	if (!rec->prepared_local)
+	{
+		if (GlobalTimestampIsValid(rec->commit_ts))
+		{
+			remove_2pc_records(rec->gid, true);
+		}
+		else
+		{
+			rename_2pc_records(rec->gid, 0);
+		}
+	}
+
+	FinishGIDGTM(rec->gid);
+}
+
+/*
+ * Resolve the in-doubt 2pc started from this node using its local 2pc
+ * records, instead of asking every node about every prepared transaction.
+ * In query mode find the databases holding them and drop the records no
+ * node still has prepared; otherwise finish the ones of our database on
+ * all their nodes, remote nodes first and this node last.
+ */
+static void
+do_resolve_local_2pc(bool query_only)
+{
+	HTAB             *records = NULL;
+	HASH_SEQ_STATUS   seq;
+	Clean2pcRecord   *rec = NULL;
+	List             *clean_nodes = NIL;
+	List             *coord_nodes = NIL;
+	Clean2pcNode    **remote = NULL;
+	Clean2pcNode     *local = NULL;
+	List             *dn_list = NIL;
+	List             *cn_list = NIL;
+	ListCell         *lc = NULL;
+	PGXCNodeAllHandles *handles = NULL;
+	Oid               my_node_oid = InvalidOid;
+	int               nremote = 0;
+	int               count = 0;
+	int               i = 0;
+
+	StartTransactionCommand();
+
+	records = collect_local_2pc(query_only);
+	if (hash_get_num_entries(records) == 0)
+	{
+		CommitTransactionCommand();
+		return;
+	}
+
+	InitMultinodeExecutor(false);
+
+	my_node_oid = get_pgxc_nodeoid(PGXCNodeName);
+	coord_nodes = GetAllCoordNodes();
+	coord_nodes = lappend_int(coord_nodes, PGXCNodeId - 1);
+
+	scan_prepared_2pc(records, EXEC_ON_DATANODES, GetAllDataNodes(),
+					  query_only, &clean_nodes);
+	scan_prepared_2pc(records, EXEC_ON_COORDS, coord_nodes,
+					  query_only, &clean_nodes);
+
+	if (!query_only && clean_nodes != NIL)
+	{
+		remote = (Clean2pcNode **) palloc(sizeof(Clean2pcNode *) *
+										  list_length(clean_nodes));
+
+		foreach(lc, clean_nodes)
+		{
+			Clean2pcNode *node = (Clean2pcNode *) lfirst(lc);
+			char          node_type = PGXC_NODE_NONE;
+			int           node_index = PGXCNodeGetNodeId(node->nodeoid, &node_type);
+
+			if (node_type == PGXC_NODE_DATANODE)
+			{
+				dn_list = lappend_int(dn_list, node_index);
+			}
+			else
+			{
+				cn_list = lappend_int(cn_list, node_index);
+			}
+
+			if (node->nodeoid == my_node_oid)
+			{
+				local = node;
+			}
+			else
+			{
+				remote[nremote++] = node;
+			}
+		}
+
+		handles = get_handles(dn_list, cn_list, false, true, true);
+
+		foreach(lc, clean_nodes)
+		{
+			Clean2pcNode *node = (Clean2pcNode *) lfirst(lc);
+
+			for (i = 0; i < handles->dn_conn_count; i++)
+			{
+				if (handles->datanode_handles[i]->nodeoid == node->nodeoid)
+				{
+					node->handle = handles->datanode_handles[i];
+				}
+			}
+			for (i = 0; i < handles->co_conn_count; i++)
+			{
+				if (handles->coord_handles[i]->nodeoid == node->nodeoid)
+				{
+					node->handle = handles->coord_handles[i];
+				}
+			}
+
+			if (NULL == node->handle)
+			{
+				elog(ERROR, "get handle of node %u failed", node->nodeoid);
+			}
+		}
+
+		/*
+		 * The start node finishes last: once it is done there, the 2pc
+		 * record which tells the outcome is gone.
+		 */
+		finish_on_nodes(remote, nremote, false);
+		if (local != NULL)
+		{
+			finish_on_nodes(&local, 1, true);
+		}
+
+		clear_handles();
+		pfree_pgxc_all_handles(handles);
+	}
+
+	hash_seq_init(&seq, records);
+	while ((rec = (Clean2pcRecord *) hash_seq_search(&seq)) != NULL)
+	{
+		/* left to the clean worker of its database */
+		if (query_only && rec->prepared)
+		{
+			continue;
+		}
+		/* belongs to another database */
+		if (!query_only && (!rec->queued || rec->pending > 0))
+		{
+			continue;
+		}
+
+		forget_local_2pc(rec);
+		count++;
+	}
+
+	CommitTransactionCommand();
+
+	if (count > 0)
+	{
+		elog(LOG, "resolved %d in-doubt 2pc from local records%s", count,
+			 query_only ? "" : " in parallel");
+	}
+}
+
 /* SIGTERM: set flag to exit normally */
 static void
 clean_2pc_sigterm_handler(SIGNAL_ARGS)
@@ -852,7 +1497,7 @@ get_default_database(void)
  * start query worker to query 2pc
  */
 static void
-start_query_worker(TimestampTz clean_time)
+start_query_worker(TimestampTz clean_time, bool resolve_only)
 {
 	Oid db_oid = get_default_database();
 	if (!OidIsValid(db_oid))
@@ -895,6 +1540,7 @@ start_query_worker(TimestampTz clean_time)
 	Clean2pcShmem->worker_running = true;
 	Clean2pcShmem->db_count = 0;
 	Clean2pcShmem->worker_db = db_oid;
+	Clean2pcShmem->resolve_only = resolve_only;
 
 	LWLockRelease(Clean2pcLock);
 
@@ -973,6 +1619,116 @@ ExitCleanRunning(int status, Datum arg)
 	}
 }
 
+/*
+ * on_shmem_exit callback to stop 2pc clean launcher wakeups
+ */
+static void
+ExitCleanLauncher(int status, Datum arg)
+{
+	Clean2pcShmem->launcher_pid = 0;
+}
+
+/*
+ * Clean2pcRequestResolve
+ *		Ask the 2pc clean launcher to resolve the in-doubt 2pc gid, which
+ *		this node started and could not finish.
+ */
+void
+Clean2pcRequestResolve(const char *gid)
+{
+	pid_t launcher_pid = 0;
+
+	if (!enable_clean_2pc_local_resolve || NULL == Clean2pcShmem)
+	{
+		return;
+	}
+
+	SpinLockAcquire(&Clean2pcShmem->mutex);
+	if (Clean2pcShmem->nrequests < MAX_RESOLVE_GIDS)
+	{
+		strlcpy(Clean2pcShmem->requests[Clean2pcShmem->nrequests++], gid, GIDSIZE);
+	}
+	launcher_pid = Clean2pcShmem->launcher_pid;
+	SpinLockRelease(&Clean2pcShmem->mutex);
+
+	if (launcher_pid != 0)
+	{
+		kill(launcher_pid, SIGUSR2);
+	}
+}
+
+/*
+ * Clean2pcSetStartupXid
+ *		Remember the next xid at the end of recovery: the 2pc this node
+ *		started before it were left by an earlier life of the node.
+ */
+void
+Clean2pcSetStartupXid(TransactionId xid)
+{
+	if (NULL == Clean2pcShmem)
+	{
+		return;
+	}
+
+	Clean2pcShmem->startup_xid = xid;
+}
+
+/*
+ * tbase_clean_2pc_in_doubt
+ *		The 2pc started from this node that the 2pc clean launcher resolves
+ *		from the local records, as left by an earlier life of the node.
+ */
+Datum
+tbase_clean_2pc_in_doubt(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx = NULL;
+	List            *gids = NIL;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		List         *entries = NIL;
+		ListCell     *lc = NULL;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (IS_PGXC_COORDINATOR && NULL != Clean2pcShmem)
+		{
+			entries = get_2pc_records_by_startnode(PGXCNodeName, MAX_LOCAL_2PC);
+		}
+		foreach(lc, entries)
+		{
+			Record2pcEntry *entry = (Record2pcEntry *) lfirst(lc);
+			Clean2pcRecord  rec;
+
+			MemSet(&rec, 0, sizeof(rec));
+			if (strlen(entry->gid) < GIDSIZE &&
+				parse_2pc_record(entry, &rec) &&
+				local_2pc_left_by_crash(entry->gid, &rec))
+			{
+				gids = lappend(gids, entry->gid);
+			}
+		}
+		funcctx->user_fctx = gids;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	gids = (List *) funcctx->user_fctx;
+
+	if (gids != NIL)
+	{
+		char *gid = (char *) linitial(gids);
+
+		funcctx->user_fctx = list_delete_first(gids);
+		SRF_RETURN_NEXT(funcctx, CStringGetTextDatum(gid));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
 /*
  * Clean2pcShmemSize
  *		Compute space needed for clean 2pc related shared memory
@@ -1002,6 +1758,12 @@ Clean2pcShmemInit(void)
 	Clean2pcShmem = (Clean2pcShmemStruct *) ShmemInitStruct("Clean 2pc Data",
 															Clean2pcShmemSize(),
 															&found);
+	if (!found)
+	{
+		MemSet(Clean2pcShmem, 0, Clean2pcShmemSize());
+		Clean2pcShmem->startup_xid = InvalidTransactionId;
+		SpinLockInit(&Clean2pcShmem->mutex);
+	}
 }
 
 #ifdef EXEC_BACKEND
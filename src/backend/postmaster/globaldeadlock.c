@@ -0,0 +1,984 @@
+/*
+ * Tencent is pleased to support the open source community by making TBase available.  
+ * 
+ * Copyright (C) 2019 THL A29 Limited, a Tencent company.  All rights reserved.
+ * 
+ * TBase is licensed under the BSD 3-Clause License, except for the third-party component listed below. 
+ * 
+ * A copy of the BSD 3-Clause License is included in this file.
+ * 
+ * Other dependencies and licenses:
+ * 
+ * Open Source Software Licensed Under the PostgreSQL License: 
+ * --------------------------------------------------------------------
+ * 1. Postgres-XL XL9_5_STABLE
+ * Portions Copyright (c) 2015-2016, 2ndQuadrant Ltd
+ * Portions Copyright (c) 2012-2015, TransLattice, Inc.
+ * Portions Copyright (c) 2010-2017, Postgres-XC Development Group
+ * Portions Copyright (c) 1996-2015, The PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, The Regents of the University of California
+ * 
+ * Terms of the PostgreSQL License: 
+ * --------------------------------------------------------------------
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written agreement
+ * is hereby granted, provided that the above copyright notice and this
+ * paragraph and the following two paragraphs appear in all copies.
+ * 
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+ * DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * 
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE UNIVERSITY OF CALIFORNIA HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ * 
+ * 
+ * Terms of the BSD 3-Clause License:
+ * --------------------------------------------------------------------
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of THL A29 Limited nor the names of its contributors may be used to endorse or promote products derived from this software without 
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+ * DAMAGE.
+ * 
+ */
+/*-------------------------------------------------------------------------
+ *
+ * globaldeadlock.c
+ *
+ * Global deadlock detector.
+ *
+ * The lock manager of each node only sees its own wait-for graph, so a
+ * deadlock between distributed transactions whose waits are on different
+ * nodes is never found locally; it used to last until lock_timeout, or until
+ * somebody ran pg_unlock.
+ *
+ * A background worker runs on every coordinator, but only the one with the
+ * smallest name (the DDL leader) does the work.  Every
+ * global_deadlock_detector_interval it collects from all nodes the edges
+ * "global transaction A waits for a lock held by global transaction B", as
+ * reported by tbase_lock_wait_edges(), and merges them into a graph kept
+ * between rounds.  Edges are collected from the nodes one after the other,
+ * not at one instant, so an edge is only trusted once it has been seen in
+ * two rounds in a row.  A cycle is searched for only from the edges that have
+ * just become trusted, as any new cycle must go through one of them.  The
+ * victim of a cycle is the transaction with the most waits in or out.
+ *
+ * Right before a victim is canceled, the waits are collected again from all
+ * nodes, and the cycle is left alone if one of its waits has gone.  Only the
+ * backends of the victim that wait for the next transaction of the cycle are
+ * canceled, on the node they wait on, by tbase_cancel_lock_waiter().  It
+ * takes the pid and the global xid of the backend, and removes it from the
+ * wait queue of its lock under the lock partition lock, so the backend gets a
+ * deadlock error for that wait only; unlike a query cancel, it can not hit a
+ * later statement of the transaction or of the session.
+ *
+ * Only waits on granted locks are followed; a cycle that goes through the
+ * order of a lock's wait queue is left to lock_timeout.  Waits for relation
+ * extension, page, tuple and speculative insertion locks are not followed
+ * either: they are held for a short time and their waits can look like a
+ * cycle that never was.  The wait for the transaction behind a tuple lock is
+ * still seen.  Transactions without a global xid only have locks on one
+ * node, and any cycle they take part in is found by the local deadlock
+ * detector.
+ *
+ * IDENTIFICATION
+ *      src/backend/postmaster/globaldeadlock.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "access/xact.h"
+#include "catalog/pg_type.h"
+#include "executor/executor.h"
+#include "funcapi.h"
+#include "libpq/pqsignal.h"
+#include "miscadmin.h"
+#include "nodes/makefuncs.h"
+#include "pgstat.h"
+#include "pgxc/execRemote.h"
+#include "pgxc/locator.h"
+#include "pgxc/pgxc.h"
+#include "pgxc/pgxcnode.h"
+#include "postmaster/bgworker.h"
+#include "postmaster/globaldeadlock.h"
+#include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/lock.h"
+#include "storage/proc.h"
+#include "storage/procarray.h"
+#include "tcop/tcopprot.h"
+#include "utils/builtins.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/snapmgr.h"
+
+bool        enable_global_deadlock_detector = false;
+int            global_deadlock_detector_interval = 2000;    /* ms */
+
+/* a wait of one global transaction for another, on one node */
+typedef struct LockWaitEdge
+{
+    int            waiter_pid;
+    int            holder_pid;
+    char        waiter[NAMEDATALEN];
+    char        holder[NAMEDATALEN];
+} LockWaitEdge;
+
+/* a wait as collected from one node */
+typedef struct GddWait
+{
+    char        node[NAMEDATALEN];
+    char        waiter[NAMEDATALEN];
+    char        holder[NAMEDATALEN];
+    int            waiter_pid;
+} GddWait;
+
+/* an edge of the global wait-for graph, kept between rounds */
+typedef struct GddEdgeKey
+{
+    char        waiter[NAMEDATALEN];
+    char        holder[NAMEDATALEN];
+} GddEdgeKey;
+
+typedef struct GddEdge
+{
+    GddEdgeKey    key;
+    uint64        first_round;    /* first of the rounds in a row it was seen */
+    uint64        last_round;
+    char        node[NAMEDATALEN];    /* one node the wait is on */
+} GddEdge;
+
+/* a transaction of the trusted graph, rebuilt every round */
+typedef struct GddVertex
+{
+    char        gxid[NAMEDATALEN];
+    List       *out;            /* GddVertex's it waits for */
+    int            degree;
+    uint64        visited;        /* search that visited it */
+    struct GddVertex *parent;    /* vertex it was reached from */
+    bool        canceled;
+} GddVertex;
+
+static volatile sig_atomic_t got_SIGHUP = false;
+
+static HTAB *gdd_edges = NULL;
+static uint64 gdd_round = 0;
+static uint64 gdd_search = 0;
+
+static void gdd_sighup(SIGNAL_ARGS);
+static void gdd_run_round(void);
+static List *gdd_collect_waits(void);
+static List *gdd_collect_remote(List *waits, bool datanodes);
+static void gdd_add_edge(const char *node, const char *waiter, const char *holder);
+static void gdd_detect(MemoryContext cxt);
+static bool gdd_find_path(GddVertex *from, GddVertex *to);
+static void gdd_cancel(GddVertex *victim, GddVertex *from, GddVertex *to);
+static void gdd_forget(const char *gxid);
+
+/*
+ * Collect the waits of global transactions for each other on this node.
+ */
+static int
+lock_instance_cmp(const void *a, const void *b)
+{
+    const LockInstanceData *la = *(LockInstanceData * const *) a;
+    const LockInstanceData *lb = *(LockInstanceData * const *) b;
+
+    return memcmp(&la->locktag, &lb->locktag, sizeof(LOCKTAG));
+}
+
+static int
+lock_wait_edge_cmp(const void *a, const void *b)
+{
+    const LockWaitEdge *ea = (const LockWaitEdge *) a;
+    const LockWaitEdge *eb = (const LockWaitEdge *) b;
+
+    if (ea->waiter_pid != eb->waiter_pid)
+        return ea->waiter_pid < eb->waiter_pid ? -1 : 1;
+    if (ea->holder_pid != eb->holder_pid)
+        return ea->holder_pid < eb->holder_pid ? -1 : 1;
+    return 0;
+}
+
+static LockWaitEdge *
+GetLockWaitEdges(int *nedges)
+{// #lizard forgives
+    LockData   *lockData = GetLockStatusData();
+    LockInstanceData **sorted;
+    LockWaitEdge *edges;
+    int            maxedges = 64;
+    int            count = 0;
+    int            result = 0;
+    int            start;
+    int            end;
+    int            i;
+    int            j;
+
+    edges = (LockWaitEdge *) palloc(maxedges * sizeof(LockWaitEdge));
+    sorted = (LockInstanceData **) palloc((lockData->nelements + 1) * sizeof(LockInstanceData *));
+    for (i = 0; i < lockData->nelements; i++)
+        sorted[i] = &lockData->locks[i];
+    qsort(sorted, lockData->nelements, sizeof(LockInstanceData *), lock_instance_cmp);
+
+    /* a waiter waits for the holders of conflicting modes on the same lock */
+    for (start = 0; start < lockData->nelements; start = end)
+    {
+        for (end = start + 1; end < lockData->nelements; end++)
+        {
+            if (lock_instance_cmp(&sorted[start], &sorted[end]) != 0)
+                break;
+        }
+
+        for (i = start; i < end; i++)
+        {
+            LockInstanceData *waiter = sorted[i];
+            LOCKMASK    conflicts;
+
+            if (waiter->waitLockMode == NoLock)
+                continue;
+
+            /* short-lived locks, see the header comment */
+            if (waiter->locktag.locktag_type == LOCKTAG_RELATION_EXTEND ||
+                waiter->locktag.locktag_type == LOCKTAG_PAGE ||
+                waiter->locktag.locktag_type == LOCKTAG_TUPLE ||
+                waiter->locktag.locktag_type == LOCKTAG_SPECULATIVE_TOKEN)
+                continue;
+            conflicts = GetLockTagsMethodTable(&waiter->locktag)->conflictTab[waiter->waitLockMode];
+
+            for (j = start; j < end; j++)
+            {
+                LockInstanceData *holder = sorted[j];
+
+                if (holder->pid == waiter->pid ||
+                    holder->leaderPid == waiter->leaderPid ||
+                    (holder->holdMask & conflicts) == 0)
+                    continue;
+
+                if (count >= maxedges)
+                {
+                    maxedges *= 2;
+                    edges = (LockWaitEdge *) repalloc(edges, maxedges * sizeof(LockWaitEdge));
+                }
+                edges[count].waiter_pid = waiter->leaderPid;
+                edges[count].holder_pid = holder->leaderPid;
+                count++;
+            }
+        }
+    }
+
+    /* keep one edge per pair of backends, between global transactions */
+    qsort(edges, count, sizeof(LockWaitEdge), lock_wait_edge_cmp);
+    for (i = 0; i < count; i++)
+    {
+        char       *waiter;
+        char       *holder;
+
+        if (i > 0 && lock_wait_edge_cmp(&edges[i - 1], &edges[i]) == 0)
+            continue;
+
+        waiter = GetGlobalTransactionId(edges[i].waiter_pid);
+        holder = GetGlobalTransactionId(edges[i].holder_pid);
+        if (waiter == NULL || holder == NULL || waiter[0] == '\0' || holder[0] == '\0')
+            continue;
+
+        edges[result].waiter_pid = edges[i].waiter_pid;
+        edges[result].holder_pid = edges[i].holder_pid;
+        strlcpy(edges[result].waiter, waiter, NAMEDATALEN);
+        strlcpy(edges[result].holder, holder, NAMEDATALEN);
+
+        /* the same transaction on both ends, through a parallel worker */
+        if (strcmp(edges[result].waiter, edges[result].holder) == 0)
+            continue;
+        result++;
+    }
+
+    pfree(sorted);
+    *nedges = result;
+    return edges;
+}
+
+/*
+ * tbase_lock_wait_edges
+ *        Waits of global transactions for each other on this node.
+ */
+Datum
+tbase_lock_wait_edges(PG_FUNCTION_ARGS)
+{
+    FuncCallContext *funcctx;
+    LockWaitEdge *edges;
+
+    if (SRF_IS_FIRSTCALL())
+    {
+        TupleDesc    tupdesc;
+        MemoryContext oldcontext;
+        int            nedges;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        tupdesc = CreateTemplateTupleDesc(5, false);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 1, "node",
+                           TEXTOID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 2, "waiter",
+                           TEXTOID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 3, "waiter_pid",
+                           INT4OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 4, "holder",
+                           TEXTOID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 5, "holder_pid",
+                           INT4OID, -1, 0);
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+        funcctx->user_fctx = GetLockWaitEdges(&nedges);
+        funcctx->max_calls = nedges;
+
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+    edges = (LockWaitEdge *) funcctx->user_fctx;
+
+    if (funcctx->call_cntr < funcctx->max_calls)
+    {
+        LockWaitEdge *edge = &edges[funcctx->call_cntr];
+        Datum        values[5];
+        bool        nulls[5];
+        HeapTuple    tuple;
+
+        MemSet(nulls, 0, sizeof(nulls));
+        values[0] = CStringGetTextDatum(PGXCNodeName);
+        values[1] = CStringGetTextDatum(edge->waiter);
+        values[2] = Int32GetDatum(edge->waiter_pid);
+        values[3] = CStringGetTextDatum(edge->holder);
+        values[4] = Int32GetDatum(edge->holder_pid);
+
+        tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+    }
+
+    SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * tbase_cancel_lock_waiter
+ *        Make the backend with the given pid fail its lock wait with a
+ *        deadlock error, if it still waits for a lock for the given global
+ *        transaction on this node.
+ */
+Datum
+tbase_cancel_lock_waiter(PG_FUNCTION_ARGS)
+{
+    char       *gxid = text_to_cstring(PG_GETARG_TEXT_PP(0));
+    int            pid = PG_GETARG_INT32(1);
+
+    if (!superuser())
+        ereport(ERROR,
+                (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+                 (errmsg("must be superuser to cancel global transactions"))));
+
+    PG_RETURN_BOOL(CancelGlobalTransactionLockWaiter(gxid, pid));
+}
+
+/*
+ * GlobalDeadlockDetectorRegister
+ *        Register the global deadlock detector of a coordinator.
+ */
+void
+GlobalDeadlockDetectorRegister(void)
+{
+    BackgroundWorker bgw;
+
+    if (!IS_PGXC_COORDINATOR)
+        return;
+
+    memset(&bgw, 0, sizeof(bgw));
+    bgw.bgw_flags = BGWORKER_SHMEM_ACCESS |
+        BGWORKER_BACKEND_DATABASE_CONNECTION;
+    bgw.bgw_start_time = BgWorkerStart_RecoveryFinished;
+    snprintf(bgw.bgw_library_name, BGW_MAXLEN, "postgres");
+    snprintf(bgw.bgw_function_name, BGW_MAXLEN, "GlobalDeadlockDetectorMain");
+    snprintf(bgw.bgw_name, BGW_MAXLEN, "global deadlock detector");
+    bgw.bgw_restart_time = 5;
+    bgw.bgw_notify_pid = 0;
+    bgw.bgw_main_arg = (Datum) 0;
+
+    RegisterBackgroundWorker(&bgw);
+}
+
+static void
+gdd_sighup(SIGNAL_ARGS)
+{
+    int            save_errno = errno;
+
+    got_SIGHUP = true;
+    SetLatch(MyLatch);
+
+    errno = save_errno;
+}
+
+/*
+ * Main loop of the global deadlock detector.
+ */
+void
+GlobalDeadlockDetectorMain(Datum main_arg)
+{
+    MemoryContext round_cxt;
+    HASHCTL        ctl;
+
+    pqsignal(SIGHUP, gdd_sighup);
+    pqsignal(SIGTERM, die);
+    BackgroundWorkerUnblockSignals();
+
+    BackgroundWorkerInitializeConnection("postgres", NULL);
+
+    MemSet(&ctl, 0, sizeof(ctl));
+    ctl.keysize = sizeof(GddEdgeKey);
+    ctl.entrysize = sizeof(GddEdge);
+    gdd_edges = hash_create("global deadlock detector edges", 256, &ctl,
+                            HASH_ELEM | HASH_BLOBS);
+
+    round_cxt = AllocSetContextCreate(TopMemoryContext,
+                                      "global deadlock detector",
+                                      ALLOCSET_DEFAULT_SIZES);
+
+    for (;;)
+    {
+        int            rc;
+
+        rc = WaitLatch(MyLatch,
+                       WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+                       global_deadlock_detector_interval,
+                       WAIT_EVENT_GLOBAL_DEADLOCK_DETECTOR_MAIN);
+        ResetLatch(MyLatch);
+
+        if (rc & WL_POSTMASTER_DEATH)
+            proc_exit(1);
+
+        CHECK_FOR_INTERRUPTS();
+
+        if (got_SIGHUP)
+        {
+            got_SIGHUP = false;
+            ProcessConfigFile(PGC_SIGHUP);
+        }
+
+        if (!enable_global_deadlock_detector)
+        {
+            gdd_forget(NULL);
+            continue;
+        }
+
+        StartTransactionCommand();
+        PushActiveSnapshot(GetTransactionSnapshot());
+
+        InitMultinodeExecutor(false);
+        if (is_pgxc_handles_init() &&
+            find_ddl_leader_cn() != NULL &&
+            is_ddl_leader_cn(find_ddl_leader_cn()->nodename))
+        {
+            MemoryContext oldcxt = MemoryContextSwitchTo(round_cxt);
+
+            gdd_run_round();
+            gdd_detect(round_cxt);
+
+            MemoryContextSwitchTo(oldcxt);
+            MemoryContextReset(round_cxt);
+        }
+        else
+            gdd_forget(NULL);
+
+        PopActiveSnapshot();
+        CommitTransactionCommand();
+    }
+}
+
+/*
+ * Collect the waits of all nodes into the graph.
+ */
+static void
+gdd_run_round(void)
+{
+    HASH_SEQ_STATUS status;
+    GddEdge    *edge;
+    List       *waits;
+    ListCell   *lc;
+
+    gdd_round++;
+
+    waits = gdd_collect_waits();
+    foreach(lc, waits)
+    {
+        GddWait    *wait = (GddWait *) lfirst(lc);
+
+        gdd_add_edge(wait->node, wait->waiter, wait->holder);
+    }
+
+    /* waits that have gone */
+    hash_seq_init(&status, gdd_edges);
+    while ((edge = (GddEdge *) hash_seq_search(&status)) != NULL)
+    {
+        if (edge->last_round != gdd_round)
+            hash_search(gdd_edges, &edge->key, HASH_REMOVE, NULL);
+    }
+}
+
+/*
+ * Run query on the given datanodes, or other coordinators, or on all of them
+ * if nodes is NIL, and return the state to fetch the rows from.
+ */
+static RemoteQueryState *
+gdd_remote_query(const char *query, int natts, bool datanodes, List *nodes)
+{
+    RemoteQuery *plan;
+    EState       *estate;
+    MemoryContext oldcontext;
+    RemoteQueryState *pstate;
+    int            i;
+
+    if (nodes == NIL)
+        nodes = datanodes ? GetAllDataNodes() : GetAllCoordNodes();
+    if (nodes == NIL)
+        return NULL;
+
+    plan = makeNode(RemoteQuery);
+    plan->combine_type = COMBINE_TYPE_NONE;
+    plan->exec_nodes = makeNode(ExecNodes);
+    plan->exec_type = datanodes ? EXEC_ON_DATANODES : EXEC_ON_COORDS;
+    plan->exec_nodes->nodeList = nodes;
+    plan->sql_statement = (char *) query;
+    plan->force_autocommit = false;
+
+    /*
+     * We only need the target entry to determine result data type.
+     * So create dummy even if real expression is a function.
+     */
+    for (i = 1; i <= natts; i++)
+    {
+        Var           *dummy = makeVar(1, i, TEXTOID, 0, InvalidOid, 0);
+
+        plan->scan.plan.targetlist = lappend(plan->scan.plan.targetlist,
+                                             makeTargetEntry((Expr *) dummy, i, NULL, false));
+    }
+
+    estate = CreateExecutorState();
+    oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+    estate->es_snapshot = GetActiveSnapshot();
+    pstate = ExecInitRemoteQuery(plan, estate, 0);
+    MemoryContextSwitchTo(oldcontext);
+
+    return pstate;
+}
+
+/*
+ * Collect the waits of global transactions for each other on all nodes.
+ */
+static List *
+gdd_collect_waits(void)
+{
+    List       *waits = NIL;
+    LockWaitEdge *edges;
+    int            nedges;
+    int            i;
+
+    edges = GetLockWaitEdges(&nedges);
+    for (i = 0; i < nedges; i++)
+    {
+        GddWait    *wait = (GddWait *) palloc(sizeof(GddWait));
+
+        strlcpy(wait->node, PGXCNodeName, NAMEDATALEN);
+        strlcpy(wait->waiter, edges[i].waiter, NAMEDATALEN);
+        strlcpy(wait->holder, edges[i].holder, NAMEDATALEN);
+        wait->waiter_pid = edges[i].waiter_pid;
+        waits = lappend(waits, wait);
+    }
+    pfree(edges);
+
+    waits = gdd_collect_remote(waits, false);
+    waits = gdd_collect_remote(waits, true);
+
+    return waits;
+}
+
+static List *
+gdd_collect_remote(List *waits, bool datanodes)
+{
+    RemoteQueryState *pstate;
+    TupleTableSlot *result;
+
+    pstate = gdd_remote_query("SELECT node, waiter, waiter_pid, holder FROM pg_catalog.tbase_lock_wait_edges()",
+                              4, datanodes, NIL);
+    if (pstate == NULL)
+        return waits;
+
+    result = ExecRemoteQuery((PlanState *) pstate);
+    while (result != NULL && !TupIsNull(result))
+    {
+        slot_getallattrs(result);
+        if (!result->tts_isnull[0] && !result->tts_isnull[1] &&
+            !result->tts_isnull[2] && !result->tts_isnull[3])
+        {
+            GddWait    *wait = (GddWait *) palloc(sizeof(GddWait));
+            char       *pid = TextDatumGetCString(result->tts_values[2]);
+
+            text_to_cstring_buffer(DatumGetTextPP(result->tts_values[0]),
+                                   wait->node, NAMEDATALEN);
+            text_to_cstring_buffer(DatumGetTextPP(result->tts_values[1]),
+                                   wait->waiter, NAMEDATALEN);
+            text_to_cstring_buffer(DatumGetTextPP(result->tts_values[3]),
+                                   wait->holder, NAMEDATALEN);
+            wait->waiter_pid = pg_atoi(pid, sizeof(int32), 0);
+            waits = lappend(waits, wait);
+        }
+        result = ExecRemoteQuery((PlanState *) pstate);
+    }
+    ExecEndRemoteQuery(pstate);
+
+    return waits;
+}
+
+static void
+gdd_add_edge(const char *node, const char *waiter, const char *holder)
+{
+    GddEdgeKey    key;
+    GddEdge    *edge;
+    bool        found;
+
+    MemSet(&key, 0, sizeof(key));
+    strlcpy(key.waiter, waiter, NAMEDATALEN);
+    strlcpy(key.holder, holder, NAMEDATALEN);
+
+    edge = (GddEdge *) hash_search(gdd_edges, &key, HASH_ENTER, &found);
+    if (!found)
+    {
+        edge->first_round = gdd_round;
+        strlcpy(edge->node, node, NAMEDATALEN);
+    }
+    edge->last_round = gdd_round;
+}
+
+/*
+ * Look for cycles through the edges trusted since this round, and break
+ * them.
+ */
+static void
+gdd_detect(MemoryContext cxt)
+{// #lizard forgives
+    HASHCTL        ctl;
+    HTAB       *vertices;
+    HASH_SEQ_STATUS status;
+    GddEdge    *edge;
+    List       *fresh = NIL;
+    ListCell   *lc;
+
+    MemSet(&ctl, 0, sizeof(ctl));
+    ctl.keysize = NAMEDATALEN;
+    ctl.entrysize = sizeof(GddVertex);
+    ctl.hcxt = cxt;
+    vertices = hash_create("global deadlock detector vertices", 256, &ctl,
+                           HASH_ELEM | HASH_CONTEXT);
+
+    /* graph of the edges seen in two rounds in a row */
+    hash_seq_init(&status, gdd_edges);
+    while ((edge = (GddEdge *) hash_seq_search(&status)) != NULL)
+    {
+        GddVertex  *waiter;
+        GddVertex  *holder;
+        bool        found;
+
+        if (edge->first_round == gdd_round)
+            continue;
+
+        waiter = (GddVertex *) hash_search(vertices, edge->key.waiter, HASH_ENTER, &found);
+        if (!found)
+        {
+            waiter->out = NIL;
+            waiter->degree = 0;
+            waiter->visited = 0;
+            waiter->canceled = false;
+        }
+        holder = (GddVertex *) hash_search(vertices, edge->key.holder, HASH_ENTER, &found);
+        if (!found)
+        {
+            holder->out = NIL;
+            holder->degree = 0;
+            holder->visited = 0;
+            holder->canceled = false;
+        }
+
+        waiter->out = lappend(waiter->out, holder);
+        waiter->degree++;
+        holder->degree++;
+
+        if (edge->first_round == gdd_round - 1)
+        {
+            GddEdgeKey *key = (GddEdgeKey *) palloc(sizeof(GddEdgeKey));
+
+            memcpy(key, &edge->key, sizeof(GddEdgeKey));
+            fresh = lappend(fresh, key);
+        }
+    }
+
+    foreach(lc, fresh)
+    {
+        GddVertex  *waiter;
+        GddVertex  *holder;
+        GddVertex  *victim;
+        GddVertex  *v;
+        GddEdgeKey *key = (GddEdgeKey *) lfirst(lc);
+
+        waiter = (GddVertex *) hash_search(vertices, key->waiter, HASH_FIND, NULL);
+        holder = (GddVertex *) hash_search(vertices, key->holder, HASH_FIND, NULL);
+        if (waiter->canceled || holder->canceled)
+            continue;
+
+        /* the edge closes a cycle if the holder waits for the waiter */
+        if (!gdd_find_path(holder, waiter))
+            continue;
+
+        victim = waiter;
+        for (v = waiter; v != holder; v = v->parent)
+        {
+            if (v->degree > victim->degree ||
+                (v->degree == victim->degree && strcmp(v->gxid, victim->gxid) > 0))
+                victim = v;
+        }
+        if (holder->degree > victim->degree ||
+            (holder->degree == victim->degree && strcmp(holder->gxid, victim->gxid) > 0))
+            victim = holder;
+
+        gdd_cancel(victim, holder, waiter);
+    }
+
+    hash_destroy(vertices);
+}
+
+/*
+ * Depth-first search of a path from "from" to "to" through transactions not
+ * canceled yet; on success each vertex of the path has its parent set.
+ */
+static bool
+gdd_find_path(GddVertex *from, GddVertex *to)
+{
+    List       *stack;
+
+    gdd_search++;
+    from->visited = gdd_search;
+    from->parent = NULL;
+    stack = list_make1(from);
+
+    while (stack != NIL)
+    {
+        GddVertex  *v = (GddVertex *) linitial(stack);
+        ListCell   *lc;
+
+        stack = list_delete_first(stack);
+
+        foreach(lc, v->out)
+        {
+            GddVertex  *next = (GddVertex *) lfirst(lc);
+
+            if (next->visited == gdd_search || next->canceled)
+                continue;
+            next->visited = gdd_search;
+            next->parent = v;
+            if (next == to)
+            {
+                list_free(stack);
+                return true;
+            }
+            stack = lcons(next, stack);
+        }
+    }
+
+    return false;
+}
+
+/*
+ * Describe the wait of one transaction for another.
+ */
+static void
+gdd_describe_wait(StringInfo buf, GddVertex *waiter, GddVertex *holder)
+{
+    GddEdgeKey    key;
+    GddEdge    *edge;
+
+    MemSet(&key, 0, sizeof(key));
+    strlcpy(key.waiter, waiter->gxid, NAMEDATALEN);
+    strlcpy(key.holder, holder->gxid, NAMEDATALEN);
+    edge = (GddEdge *) hash_search(gdd_edges, &key, HASH_FIND, NULL);
+
+    if (buf->len > 0)
+        appendStringInfoString(buf, "; ");
+    appendStringInfo(buf, "%s waits for %s on %s",
+                     waiter->gxid, holder->gxid, edge ? edge->node : "?");
+}
+
+/*
+ * Is there a wait of waiter for holder in waits?
+ */
+static bool
+gdd_wait_exists(List *waits, GddVertex *waiter, GddVertex *holder)
+{
+    ListCell   *lc;
+
+    foreach(lc, waits)
+    {
+        GddWait    *wait = (GddWait *) lfirst(lc);
+
+        if (strcmp(wait->waiter, waiter->gxid) == 0 &&
+            strcmp(wait->holder, holder->gxid) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+ * Make one backend of a global transaction fail its lock wait on a node.
+ */
+static void
+gdd_cancel_waiter(const char *node, const char *gxid, int pid)
+{
+    StringInfoData query;
+    RemoteQueryState *pstate;
+    char        node_type;
+    int            nodeid;
+
+    if (strcmp(node, PGXCNodeName) == 0)
+    {
+        CancelGlobalTransactionLockWaiter(gxid, pid);
+        return;
+    }
+
+    nodeid = PGXCNodeGetNodeIdFromName((char *) node, &node_type);
+    if (nodeid < 0 ||
+        (node_type != PGXC_NODE_DATANODE && node_type != PGXC_NODE_COORDINATOR))
+    {
+        elog(LOG, "global deadlock detector could not find node %s", node);
+        return;
+    }
+
+    initStringInfo(&query);
+    appendStringInfo(&query, "SELECT pg_catalog.tbase_cancel_lock_waiter(%s, %d)",
+                     quote_literal_cstr(gxid), pid);
+
+    pstate = gdd_remote_query(query.data, 1, node_type == PGXC_NODE_DATANODE,
+                              list_make1_int(nodeid));
+    if (pstate != NULL)
+    {
+        TupleTableSlot *result = ExecRemoteQuery((PlanState *) pstate);
+
+        while (result != NULL && !TupIsNull(result))
+            result = ExecRemoteQuery((PlanState *) pstate);
+        ExecEndRemoteQuery(pstate);
+    }
+    pfree(query.data);
+}
+
+/*
+ * Cancel the victim of the cycle from -> ... -> to -> from, if the cycle is
+ * still there.
+ */
+static void
+gdd_cancel(GddVertex *victim, GddVertex *from, GddVertex *to)
+{
+    StringInfoData cycle;
+    GddVertex  *v;
+    GddVertex  *next = NULL;
+    List       *path = NIL;
+    List       *waits;
+    ListCell   *lc;
+    int            canceled = 0;
+
+    /* each vertex of the path waits for the next one */
+    for (v = to; v != NULL; v = v->parent)
+        path = lcons(v, path);
+    Assert(linitial(path) == from);
+
+    /* the graph may be a round old, look at the waits as they are now */
+    waits = gdd_collect_waits();
+
+    initStringInfo(&cycle);
+    for (lc = list_head(path); lc != NULL; lc = lnext(lc))
+    {
+        GddVertex  *waiter = (GddVertex *) lfirst(lc);
+        GddVertex  *holder = lnext(lc) ? (GddVertex *) lfirst(lnext(lc)) : from;
+
+        if (!gdd_wait_exists(waits, waiter, holder))
+        {
+            elog(DEBUG1, "global deadlock detector: %s no longer waits for %s",
+                 waiter->gxid, holder->gxid);
+            return;
+        }
+        if (waiter == victim)
+            next = holder;
+        gdd_describe_wait(&cycle, waiter, holder);
+    }
+    Assert(next != NULL);
+
+    ereport(LOG,
+            (errmsg("global deadlock detected, canceling global transaction %s",
+                    victim->gxid),
+             errdetail("%s.", cycle.data)));
+
+    /* only the waits of the victim that are part of the cycle */
+    foreach(lc, waits)
+    {
+        GddWait    *wait = (GddWait *) lfirst(lc);
+
+        if (strcmp(wait->waiter, victim->gxid) != 0 ||
+            strcmp(wait->holder, next->gxid) != 0)
+            continue;
+
+        gdd_cancel_waiter(wait->node, victim->gxid, wait->waiter_pid);
+        canceled++;
+    }
+
+    elog(DEBUG1, "global deadlock detector canceled %d lock waits of %s",
+         canceled, victim->gxid);
+
+    victim->canceled = true;
+    gdd_forget(victim->gxid);
+}
+
+/*
+ * Drop the edges of a transaction from the graph, or all of them; if the
+ * waits are still there they have to be trusted again.
+ */
+static void
+gdd_forget(const char *gxid)
+{
+    HASH_SEQ_STATUS status;
+    GddEdge    *edge;
+
+    if (gdd_edges == NULL)
+        return;
+
+    hash_seq_init(&status, gdd_edges);
+    while ((edge = (GddEdge *) hash_seq_search(&status)) != NULL)
+    {
+        if (gxid == NULL ||
+            strcmp(edge->key.waiter, gxid) == 0 ||
+            strcmp(edge->key.holder, gxid) == 0)
+            hash_search(gdd_edges, &edge->key, HASH_REMOVE, NULL);
+    }
+}
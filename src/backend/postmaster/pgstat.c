@@ -40,6 +40,7 @@
 #include "access/transam.h"
 #include "access/twophase_rmgr.h"
 #include "access/xact.h"
+#include "access/xlog.h"
 #include "catalog/pg_database.h"
 #include "catalog/pg_proc.h"
 #include "common/ip.h"
@@ -1336,6 +1337,15 @@ pgstat_reset_shared_counters(const char *target)
 {
     PgStat_MsgResetsharedcounter msg;
 
+#ifdef __TBASE__
+    /* kept in shared memory by xlog.c, not by the collector */
+    if (strcmp(target, "group_commit") == 0)
+    {
+        ResetGroupCommitStats();
+        return;
+    }
+#endif
+
     if (pgStatSock == PGINVALID_SOCKET)
         return;
 
@@ -1347,7 +1357,11 @@ pgstat_reset_shared_counters(const char *target)
         ereport(ERROR,
                 (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
                  errmsg("unrecognized reset target: \"%s\"", target),
+#ifdef __TBASE__
+                 errhint("Target must be \"archiver\", \"bgwriter\" or \"group_commit\".")));
+#else
                  errhint("Target must be \"archiver\" or \"bgwriter\".")));
+#endif
 
     pgstat_setheader(&msg.m_hdr, PGSTAT_MTYPE_RESETSHAREDCOUNTER);
     pgstat_send(&msg, sizeof(msg));
@@ -3611,6 +3625,9 @@ pgstat_get_wait_activity(WaitEventActivity w)
         case WAIT_EVENT_CLUSTER_MONITOR_MAIN:
             event_name = "ClusterMonitorMain";
             break;
+        case WAIT_EVENT_GLOBAL_DEADLOCK_DETECTOR_MAIN:
+            event_name = "GlobalDeadlockDetectorMain";
+            break;
             /* no default case, so that compiler will warn */
     }
 
@@ -3673,6 +3690,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 
     switch (w)
     {
+        case WAIT_EVENT_BASE_BACKUP_STREAMS:
+            event_name = "BaseBackupStreams";
+            break;
         case WAIT_EVENT_BGWORKER_SHUTDOWN:
             event_name = "BgWorkerShutdown";
             break;
@@ -3682,9 +3702,18 @@ pgstat_get_wait_ipc(WaitEventIPC w)
         case WAIT_EVENT_BTREE_PAGE:
             event_name = "BtreePage";
             break;
+        case WAIT_EVENT_DATAPUMP_SEND:
+            event_name = "DataPumpSend";
+            break;
         case WAIT_EVENT_EXECUTE_GATHER:
             event_name = "ExecuteGather";
             break;
+        case WAIT_EVENT_GTM_ROUNDTRIP:
+            event_name = "GTMRoundTrip";
+            break;
+        case WAIT_EVENT_LOGICAL_APPLY_COMMIT_ORDER:
+            event_name = "LogicalApplyCommitOrder";
+            break;
         case WAIT_EVENT_LOGICAL_SYNC_DATA:
             event_name = "LogicalSyncData";
             break;
@@ -3709,9 +3738,18 @@ pgstat_get_wait_ipc(WaitEventIPC w)
         case WAIT_EVENT_PARALLEL_BITMAP_SCAN:
             event_name = "ParallelBitmapScan";
             break;
+        case WAIT_EVENT_PARALLEL_REDO:
+            event_name = "ParallelRedo";
+            break;
+        case WAIT_EVENT_POOLER_GET_CONNECTIONS:
+            event_name = "PoolerGetConnections";
+            break;
         case WAIT_EVENT_PROCARRAY_GROUP_UPDATE:
             event_name = "ProcArrayGroupUpdate";
             break;
+        case WAIT_EVENT_REMOTE_RECEIVE:
+            event_name = "RemoteReceive";
+            break;
         case WAIT_EVENT_REPLICATION_ORIGIN_DROP:
             event_name = "ReplicationOriginDrop";
             break;
@@ -3721,6 +3759,12 @@ pgstat_get_wait_ipc(WaitEventIPC w)
         case WAIT_EVENT_SAFE_SNAPSHOT:
             event_name = "SafeSnapshot";
             break;
+        case WAIT_EVENT_SQUEUE_EMPTY:
+            event_name = "SQueueEmpty";
+            break;
+        case WAIT_EVENT_SQUEUE_FULL:
+            event_name = "SQueueFull";
+            break;
         case WAIT_EVENT_SYNC_REP:
             event_name = "SyncRep";
             break;
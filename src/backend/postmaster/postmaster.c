@@ -122,6 +122,7 @@
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/clean2pc.h"
 #include "postmaster/fork_process.h"
+#include "postmaster/globaldeadlock.h"
 #include "postmaster/pgarch.h"
 #include "postmaster/postmaster.h"
 #include "postmaster/syslogger.h"
@@ -470,6 +471,11 @@ bool        IsPGXCMainCluster = false;
 int            PGXCNodeId = 0;
 #ifdef __TBASE__
 char             PGXCSessionId[NAMEDATALEN];
+uint32            PGXCQueryId = 0;
+uint64            PGXCNetBytesSent = 0;
+uint64            PGXCNetBytesReceived = 0;
+double            PGXCNetSendBlockedTime = 0;
+double            PGXCNetRecvWaitTime = 0;
 #endif
 /*
  * When a particular node starts up, store the node identifier in this variable
@@ -1142,6 +1148,11 @@ PostmasterMain(int argc, char *argv[])
      */
     ApplyLauncherRegister();
 
+#ifdef __TBASE__
+    /* Register the global deadlock detector of coordinators */
+    GlobalDeadlockDetectorRegister();
+#endif
+
     /*
         * Register Audit FGA worker
         */
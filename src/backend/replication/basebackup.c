@@ -16,11 +16,13 @@
 #include <unistd.h>
 #include <time.h>
 
+#include "access/hash.h"
 #include "access/xlog_internal.h"    /* for pg_start/stop_backup */
 #include "catalog/catalog.h"
 #include "catalog/pg_type.h"
 #include "lib/stringinfo.h"
 #include "libpq/libpq.h"
+#include "libpq/libpq-be.h"
 #include "libpq/pqformat.h"
 #include "miscadmin.h"
 #include "nodes/pg_list.h"
@@ -30,14 +32,22 @@
 #include "replication/basebackup.h"
 #include "replication/walsender.h"
 #include "replication/walsender_private.h"
+#include "storage/bufpage.h"
 #include "storage/dsm_impl.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
+#include "storage/latch.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
 #include "utils/builtins.h"
 #include "utils/elog.h"
+#include "utils/memutils.h"
 #include "utils/ps_status.h"
 #include "utils/timestamp.h"
 
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 typedef struct
 {
@@ -48,6 +58,13 @@ typedef struct
     bool        includewal;
     uint32        maxrate;
     bool        sendtblspcmapfile;
+#ifdef __TBASE__
+    int            compresslevel;
+    XLogRecPtr    incremental_lsn;
+    int            nstreams;
+    int            stream;
+    XLogRecPtr    stream_startptr;
+#endif
 } basebackup_options;
 #ifdef __TBASE__
 int32   g_TransferSpeed    = 50;  /* in million bytes */
@@ -88,6 +105,57 @@ static void JudgeHalt(size_t nbytes)
     }
 }
 
+/*
+ * A parallel base backup is sent through several connections.  The one that
+ * ran BASE_BACKUP PARALLEL n does the start and stop of the backup and sends
+ * stream 0; the others run BASE_BACKUP STREAM k <start> and send the files
+ * hashed to stream k.  Only one parallel backup can run at a time.
+ */
+#define MAX_BACKUP_STREAMS    64
+
+typedef struct BaseBackupStreamsState
+{
+    slock_t        mutex;
+    XLogRecPtr    startptr;        /* start of the backup, invalid if none */
+    int            nstreams;
+    int            ndone;
+    int            nfailed;
+    Latch       *latch;            /* latch of the process running the backup */
+    bool        started[MAX_BACKUP_STREAMS];
+} BaseBackupStreamsState;
+
+static BaseBackupStreamsState *BackupStreams = NULL;
+
+/* Does this process own the shared state of a parallel backup? */
+static bool backup_streams_owner = false;
+
+/* Stream of the backup this process sends, and the number of streams */
+static int    backup_stream = 0;
+static int    backup_nstreams = 1;
+
+/* Blocks older than this are left out of relation files, if valid */
+static XLogRecPtr incremental_lsn = InvalidXLogRecPtr;
+
+/* Compression of the CopyData messages, 0 if none */
+static int    backup_compresslevel = 0;
+#ifdef HAVE_LIBZ
+static z_stream backup_zstream;
+static bool backup_zstream_inited = false;
+static StringInfo backup_zbuf = NULL;
+#endif
+
+static void bb_putmessage(const char *data, size_t len);
+static void bb_begin_copyout(void);
+static bool backup_stream_owns_file(const char *tarfilename);
+static bool is_incremental_file(const char *readfilename,
+                    const char *tarfilename);
+static bool sendIncrementalFile(FILE *fp, char *readfilename,
+                    char *tarfilename, struct stat *statbuf);
+static void start_backup_streams(XLogRecPtr startptr, int nstreams);
+static void wait_for_backup_streams(void);
+static void backup_streams_cleanup(int code, Datum arg);
+static void backup_stream_cleanup(int code, Datum arg);
+static void perform_backup_stream(basebackup_options *opt);
 #endif
 
 static int64 sendDir(char *path, int basepathlen, bool sizeonly,
@@ -106,6 +174,8 @@ static void perform_base_backup(basebackup_options *opt, DIR *tblspcdir);
 static void parse_basebackup_options(List *options, basebackup_options *opt);
 static void SendXlogRecPtrResult(XLogRecPtr ptr, TimeLineID tli);
 static int    compareWalFileNames(const void *a, const void *b);
+static void setup_statrelpath(void);
+static void setup_throttling(uint32 maxrate);
 static void throttle(size_t increment);
 
 /* Was the backup currently in-progress initiated in recovery mode? */
@@ -213,6 +283,9 @@ static const char *excludeFiles[] =
 static void
 base_backup_cleanup(int code, Datum arg)
 {
+#ifdef __TBASE__
+    backup_streams_cleanup(code, arg);
+#endif
     do_pg_abort_backup();
 }
 
@@ -231,12 +304,10 @@ perform_base_backup(basebackup_options *opt, DIR *tblspcdir)
     TimeLineID    endtli;
     StringInfo    labelfile;
     StringInfo    tblspc_map_file = NULL;
-    int            datadirpathlen;
     List       *tablespaces = NIL;
 #ifdef __TBASE__
     BeginTransfer();
 #endif
-    datadirpathlen = strlen(DataDir);
 
     backup_started_in_recovery = RecoveryInProgress();
 
@@ -260,19 +331,23 @@ perform_base_backup(basebackup_options *opt, DIR *tblspcdir)
         ListCell   *lc;
         tablespaceinfo *ti;
 
+#ifdef __TBASE__
+        if (incremental_lsn > startptr)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("incremental backup position %X/%X is past the start of this backup %X/%X",
+                            (uint32) (incremental_lsn >> 32), (uint32) incremental_lsn,
+                            (uint32) (startptr >> 32), (uint32) startptr)));
+        if (opt->nstreams > 1)
+            start_backup_streams(startptr, opt->nstreams);
+#endif
         SendXlogRecPtrResult(startptr, starttli);
 
         /*
          * Calculate the relative path of temporary statistics directory in
          * order to skip the files which are located in that directory later.
          */
-        if (is_absolute_path(pgstat_stat_directory) &&
-            strncmp(pgstat_stat_directory, DataDir, datadirpathlen) == 0)
-            statrelpath = psprintf("./%s", pgstat_stat_directory + datadirpathlen + 1);
-        else if (strncmp(pgstat_stat_directory, "./", 2) != 0)
-            statrelpath = psprintf("./%s", pgstat_stat_directory);
-        else
-            statrelpath = pgstat_stat_directory;
+        setup_statrelpath();
 
         /* Add a node for the base directory at the end */
         ti = palloc0(sizeof(tablespaceinfo));
@@ -286,40 +361,25 @@ perform_base_backup(basebackup_options *opt, DIR *tblspcdir)
         JudgeHalt(512);
 #endif
         /* Setup and activate network throttling, if client requested it */
-        if (opt->maxrate > 0)
-        {
-            throttling_sample =
-                (int64) opt->maxrate * (int64) 1024 / THROTTLING_FREQUENCY;
-
-            /*
-             * The minimum amount of time for throttling_sample bytes to be
-             * transferred.
-             */
-            elapsed_min_unit = USECS_PER_SEC / THROTTLING_FREQUENCY;
-
-            /* Enable throttling. */
-            throttling_counter = 0;
-
-            /* The 'real data' starts now (header was ignored). */
-            throttled_last = GetCurrentTimestamp();
-        }
-        else
-        {
-            /* Disable throttling. */
-            throttling_counter = -1;
-        }
+        setup_throttling(opt->maxrate);
 
         /* Send off our tablespaces one by one */
         foreach(lc, tablespaces)
         {
             tablespaceinfo *ti = (tablespaceinfo *) lfirst(lc);
+#ifndef __TBASE__
             StringInfoData buf;
+#endif
 
+#ifdef __TBASE__
+            bb_begin_copyout();
+#else
             /* Send CopyOutResponse message */
             pq_beginmessage(&buf, 'H');
             pq_sendbyte(&buf, 0);    /* overall format */
             pq_sendint(&buf, 0, 2); /* natts */
             pq_endmessage(&buf);
+#endif
 
             if (ti->path == NULL)
             {
@@ -364,6 +424,12 @@ perform_base_backup(basebackup_options *opt, DIR *tblspcdir)
             else
                 pq_putemptymessage('c');    /* CopyDone */
         }
+
+#ifdef __TBASE__
+        /* The backup is complete once the other streams are */
+        if (opt->nstreams > 1)
+            wait_for_backup_streams();
+#endif
     }
     PG_END_ENSURE_ERROR_CLEANUP(base_backup_cleanup, (Datum) 0);
 
@@ -539,9 +605,7 @@ perform_base_backup(basebackup_options *opt, DIR *tblspcdir)
             {
                 CheckXLogRemoved(segno, tli);
                 /* Send the chunk as a CopyData message */
-                if (pq_putmessage('d', buf, cnt))
-                    ereport(ERROR,
-                            (errmsg("base backup could not send data, aborting backup")));
+                bb_putmessage(buf, cnt);
 
                 len += cnt;
 #ifdef __TBASE__
@@ -622,6 +686,55 @@ compareWalFileNames(const void *a, const void *b)
     return strcmp(fna + 8, fnb + 8);
 }
 
+/*
+ * Remember the path of the temporary statistics directory relative to the
+ * data directory, so that sendDir can skip its contents.
+ */
+static void
+setup_statrelpath(void)
+{
+    int            datadirpathlen = strlen(DataDir);
+
+    if (is_absolute_path(pgstat_stat_directory) &&
+        strncmp(pgstat_stat_directory, DataDir, datadirpathlen) == 0)
+        statrelpath = psprintf("./%s", pgstat_stat_directory + datadirpathlen + 1);
+    else if (strncmp(pgstat_stat_directory, "./", 2) != 0)
+        statrelpath = psprintf("./%s", pgstat_stat_directory);
+    else
+        statrelpath = pgstat_stat_directory;
+}
+
+/*
+ * Setup and activate network throttling at 'maxrate' kilobytes per second,
+ * or disable it if 'maxrate' is 0.
+ */
+static void
+setup_throttling(uint32 maxrate)
+{
+    if (maxrate > 0)
+    {
+        throttling_sample =
+            (int64) maxrate * (int64) 1024 / THROTTLING_FREQUENCY;
+
+        /*
+         * The minimum amount of time for throttling_sample bytes to be
+         * transferred.
+         */
+        elapsed_min_unit = USECS_PER_SEC / THROTTLING_FREQUENCY;
+
+        /* Enable throttling. */
+        throttling_counter = 0;
+
+        /* The 'real data' starts now (header was ignored). */
+        throttled_last = GetCurrentTimestamp();
+    }
+    else
+    {
+        /* Disable throttling. */
+        throttling_counter = -1;
+    }
+}
+
 /*
  * Parse the base backup options passed down by the parser
  */
@@ -636,6 +749,12 @@ parse_basebackup_options(List *options, basebackup_options *opt)
     bool        o_wal = false;
     bool        o_maxrate = false;
     bool        o_tablespace_map = false;
+#ifdef __TBASE__
+    bool        o_compress = false;
+    bool        o_incremental = false;
+    bool        o_parallel = false;
+    bool        o_stream = false;
+#endif
 
     MemSet(opt, 0, sizeof(*opt));
     foreach(lopt, options)
@@ -715,12 +834,107 @@ parse_basebackup_options(List *options, basebackup_options *opt)
             opt->sendtblspcmapfile = true;
             o_tablespace_map = true;
         }
+#ifdef __TBASE__
+        else if (strcmp(defel->defname, "compress") == 0)
+        {
+            int            level;
+
+            if (o_compress)
+                ereport(ERROR,
+                        (errcode(ERRCODE_SYNTAX_ERROR),
+                         errmsg("duplicate option \"%s\"", defel->defname)));
+
+            level = intVal(defel->arg);
+            if (level < 0 || level > 9)
+                ereport(ERROR,
+                        (errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+                         errmsg("%d is outside the valid range for parameter \"%s\" (%d .. %d)",
+                                level, "COMPRESS", 0, 9)));
+#ifndef HAVE_LIBZ
+            if (level > 0)
+                ereport(ERROR,
+                        (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                         errmsg("compression is not supported by this build")));
+#endif
+            opt->compresslevel = level;
+            o_compress = true;
+        }
+        else if (strcmp(defel->defname, "incremental") == 0)
+        {
+            uint32        hi;
+            uint32        lo;
+
+            if (o_incremental)
+                ereport(ERROR,
+                        (errcode(ERRCODE_SYNTAX_ERROR),
+                         errmsg("duplicate option \"%s\"", defel->defname)));
+
+            if (sscanf(strVal(defel->arg), "%X/%X", &hi, &lo) != 2)
+                ereport(ERROR,
+                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                         errmsg("invalid value for parameter \"%s\": \"%s\"",
+                                "INCREMENTAL", strVal(defel->arg))));
+            opt->incremental_lsn = ((uint64) hi) << 32 | lo;
+            if (XLogRecPtrIsInvalid(opt->incremental_lsn))
+                ereport(ERROR,
+                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                         errmsg("invalid value for parameter \"%s\": \"%s\"",
+                                "INCREMENTAL", strVal(defel->arg))));
+            o_incremental = true;
+        }
+        else if (strcmp(defel->defname, "parallel") == 0)
+        {
+            int            nstreams;
+
+            if (o_parallel)
+                ereport(ERROR,
+                        (errcode(ERRCODE_SYNTAX_ERROR),
+                         errmsg("duplicate option \"%s\"", defel->defname)));
+
+            nstreams = intVal(defel->arg);
+            if (nstreams < 1 || nstreams > MAX_BACKUP_STREAMS)
+                ereport(ERROR,
+                        (errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+                         errmsg("%d is outside the valid range for parameter \"%s\" (%d .. %d)",
+                                nstreams, "PARALLEL", 1, MAX_BACKUP_STREAMS)));
+            opt->nstreams = nstreams;
+            o_parallel = true;
+        }
+        else if (strcmp(defel->defname, "stream") == 0)
+        {
+            List       *args = (List *) defel->arg;
+            uint32        hi;
+            uint32        lo;
+
+            if (o_stream)
+                ereport(ERROR,
+                        (errcode(ERRCODE_SYNTAX_ERROR),
+                         errmsg("duplicate option \"%s\"", defel->defname)));
+
+            opt->stream = intVal(linitial(args));
+            if (sscanf(strVal(lsecond(args)), "%X/%X", &hi, &lo) != 2)
+                ereport(ERROR,
+                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                         errmsg("invalid value for parameter \"%s\": \"%s\"",
+                                "STREAM", strVal(lsecond(args)))));
+            opt->stream_startptr = ((uint64) hi) << 32 | lo;
+            o_stream = true;
+        }
+#endif
         else
             elog(ERROR, "option \"%s\" not recognized",
                  defel->defname);
     }
     if (opt->label == NULL)
         opt->label = "base backup";
+#ifdef __TBASE__
+    if (opt->nstreams == 0)
+        opt->nstreams = 1;
+    if (o_stream && (opt->stream < 1 || opt->stream >= opt->nstreams))
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("STREAM must be between 1 and the number of streams given by PARALLEL minus one")));
+#endif
 }
 
 
@@ -750,6 +964,20 @@ SendBaseBackup(BaseBackupCmd *cmd)
         set_ps_display(activitymsg, false);
     }
 
+#ifdef __TBASE__
+    backup_compresslevel = opt.compresslevel;
+    incremental_lsn = opt.incremental_lsn;
+    backup_stream = opt.stream;
+    backup_nstreams = opt.nstreams;
+
+    /* The other streams of a parallel backup only send their files */
+    if (opt.stream > 0)
+    {
+        perform_backup_stream(&opt);
+        return;
+    }
+#endif
+
     /* Make sure we can open the directory with tablespaces in it */
     dir = AllocateDir("pg_tblspc");
     if (!dir)
@@ -931,7 +1159,7 @@ sendFileWithContent(const char *filename, const char *content)
 
     _tarWriteHeader(filename, NULL, &statbuf, false);
     /* Send the contents as a CopyData message */
-    pq_putmessage('d', content, len);
+    bb_putmessage(content, len);
     
 #ifdef __TBASE__
     JudgeHalt(len);
@@ -944,7 +1172,7 @@ sendFileWithContent(const char *filename, const char *content)
         char        buf[512];
 
         MemSet(buf, 0, pad);
-        pq_putmessage('d', buf, pad);
+        bb_putmessage(buf, pad);
         
 #ifdef __TBASE__
         JudgeHalt(pad);
@@ -1221,6 +1449,11 @@ sendDir(char *path, int basepathlen, bool sizeonly, List *tablespaces,
         {
             bool        sent = false;
 
+#ifdef __TBASE__
+            /* In a parallel backup, each file is sent by one stream */
+            if (!backup_stream_owns_file(pathbuf + basepathlen + 1))
+                continue;
+#endif
             if (!sizeonly)
                 sent = sendFile(pathbuf, pathbuf + basepathlen + 1, &statbuf,
                                 true);
@@ -1275,14 +1508,23 @@ sendFile(char *readfilename, char *tarfilename, struct stat *statbuf,
                  errmsg("could not open file \"%s\": %m", readfilename)));
     }
 
+#ifdef __TBASE__
+    /* Leave out the blocks not changed since an earlier backup */
+    if (!XLogRecPtrIsInvalid(incremental_lsn) &&
+        is_incremental_file(readfilename, tarfilename) &&
+        sendIncrementalFile(fp, readfilename, tarfilename, statbuf))
+    {
+        FreeFile(fp);
+        return true;
+    }
+#endif
+
     _tarWriteHeader(tarfilename, NULL, statbuf, false);
 
     while ((cnt = fread(buf, 1, Min(sizeof(buf), statbuf->st_size - len), fp)) > 0)
     {
         /* Send the chunk as a CopyData message */
-        if (pq_putmessage('d', buf, cnt))
-            ereport(ERROR,
-                    (errmsg("base backup could not send data, aborting backup")));
+        bb_putmessage(buf, cnt);
 
         len += cnt;
         
@@ -1309,7 +1551,7 @@ sendFile(char *readfilename, char *tarfilename, struct stat *statbuf,
         while (len < statbuf->st_size)
         {
             cnt = Min(sizeof(buf), statbuf->st_size - len);
-            pq_putmessage('d', buf, cnt);
+            bb_putmessage(buf, cnt);
             len += cnt;
 #ifdef __TBASE__
             JudgeHalt(cnt);
@@ -1326,7 +1568,7 @@ sendFile(char *readfilename, char *tarfilename, struct stat *statbuf,
     if (pad > 0)
     {
         MemSet(buf, 0, pad);
-        pq_putmessage('d', buf, pad);        
+        bb_putmessage(buf, pad);
 #ifdef __TBASE__
         JudgeHalt(pad);
 #endif
@@ -1370,7 +1612,7 @@ _tarWriteHeader(const char *filename, const char *linktarget,
                 elog(ERROR, "unrecognized tar error: %d", rc);
         }
 
-        pq_putmessage('d', h, sizeof(h));
+        bb_putmessage(h, sizeof(h));
 #ifdef __TBASE__
         /* limit the transfer speed */
         JudgeHalt(512);
@@ -1457,3 +1699,557 @@ throttle(size_t increment)
      */
     throttled_last = GetCurrentTimestamp();
 }
+
+#ifdef __TBASE__
+/*
+ * Send a CopyData message of the backup, compressing it if asked to.  Each
+ * message is compressed with a sync flush so that the client can decompress
+ * it as soon as it arrives.
+ */
+static void
+bb_putmessage(const char *data, size_t len)
+{
+#ifdef HAVE_LIBZ
+    if (backup_compresslevel > 0)
+    {
+        backup_zstream.next_in = (Bytef *) data;
+        backup_zstream.avail_in = len;
+        resetStringInfo(backup_zbuf);
+
+        do
+        {
+            int            avail;
+            int            rc;
+
+            enlargeStringInfo(backup_zbuf, TAR_SEND_SIZE);
+            avail = backup_zbuf->maxlen - backup_zbuf->len - 1;
+            backup_zstream.next_out = (Bytef *) (backup_zbuf->data + backup_zbuf->len);
+            backup_zstream.avail_out = avail;
+
+            rc = deflate(&backup_zstream, Z_SYNC_FLUSH);
+            if (rc != Z_OK && rc != Z_BUF_ERROR)
+                ereport(ERROR,
+                        (errmsg("could not compress base backup data: %s",
+                                backup_zstream.msg ? backup_zstream.msg : "unknown error")));
+
+            backup_zbuf->len += avail - backup_zstream.avail_out;
+        } while (backup_zstream.avail_out == 0);
+
+        data = backup_zbuf->data;
+        len = backup_zbuf->len;
+    }
+#endif
+
+    if (pq_putmessage('d', data, len))
+        ereport(ERROR,
+                (errmsg("base backup could not send data, aborting backup")));
+}
+
+/*
+ * Send a CopyOutResponse message starting the tar stream of a tablespace.
+ * Every tar stream is compressed on its own.
+ */
+static void
+bb_begin_copyout(void)
+{
+    StringInfoData buf;
+
+    pq_beginmessage(&buf, 'H');
+    pq_sendbyte(&buf, 0);        /* overall format */
+    pq_sendint(&buf, 0, 2);        /* natts */
+    pq_endmessage(&buf);
+
+#ifdef HAVE_LIBZ
+    if (backup_compresslevel > 0)
+    {
+        if (!backup_zstream_inited)
+        {
+            MemoryContext oldcontext;
+
+            MemSet(&backup_zstream, 0, sizeof(backup_zstream));
+            if (deflateInit(&backup_zstream, backup_compresslevel) != Z_OK)
+                ereport(ERROR,
+                        (errcode(ERRCODE_OUT_OF_MEMORY),
+                         errmsg("could not initialize compression library")));
+
+            oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+            backup_zbuf = makeStringInfo();
+            MemoryContextSwitchTo(oldcontext);
+            backup_zstream_inited = true;
+        }
+        else if (deflateReset(&backup_zstream) != Z_OK ||
+                 deflateParams(&backup_zstream, backup_compresslevel,
+                               Z_DEFAULT_STRATEGY) != Z_OK)
+            ereport(ERROR,
+                    (errmsg("could not reset compression stream: %s",
+                            backup_zstream.msg ? backup_zstream.msg : "unknown error")));
+    }
+#endif
+}
+
+/*
+ * Is the regular file 'tarfilename', relative to the data directory or the
+ * tablespace, sent by this stream of the backup?
+ */
+static bool
+backup_stream_owns_file(const char *tarfilename)
+{
+    uint32        hash;
+
+    if (backup_nstreams <= 1)
+        return true;
+
+    hash = DatumGetUInt32(hash_any((const unsigned char *) tarfilename,
+                                   strlen(tarfilename)));
+    return (hash % backup_nstreams) == backup_stream;
+}
+
+/*
+ * Can 'tarfilename' be sent incrementally?  Only segments of the main fork
+ * of relations are; the other forks are small and are sent whole.  So are
+ * the segments of page-compressed relations: they hold chunks addressed by
+ * their _pca fork, not pages with an LSN.
+ */
+static bool
+is_incremental_file(const char *readfilename, const char *tarfilename)
+{// #lizard forgives
+    char        dir[MAXPGPATH];
+    char        pcaname[MAXPGPATH];
+    struct stat pcastat;
+    const char *fname;
+    const char *p;
+    char       *parent;
+
+    fname = last_dir_separator(tarfilename);
+    if (fname == NULL)
+        return false;
+    fname++;
+
+    /* <relfilenode> or <relfilenode>.<segment> */
+    p = fname;
+    if (!isdigit((unsigned char) *p))
+        return false;
+    while (isdigit((unsigned char) *p))
+        p++;
+    if (*p == '.')
+    {
+        p++;
+        if (!isdigit((unsigned char) *p))
+            return false;
+        while (isdigit((unsigned char) *p))
+            p++;
+    }
+    if (*p != '\0')
+        return false;
+
+    /* <relfilenode>_pca next to the segment */
+    strlcpy(pcaname, readfilename, sizeof(pcaname));
+    parent = last_dir_separator(pcaname);
+    if (parent != NULL && (parent = strchr(parent, '.')) != NULL)
+        *parent = '\0';
+    strlcat(pcaname, "_", sizeof(pcaname));
+    strlcat(pcaname, forkNames[PAGE_COMPRESS_FORKNUM], sizeof(pcaname));
+    if (lstat(pcaname, &pcastat) == 0)
+        return false;
+
+    strlcpy(dir, tarfilename, Min(fname - tarfilename, sizeof(dir)));
+    if (strcmp(dir, "global") == 0)
+        return true;
+
+    /* Otherwise it must be in base/<db> or <tablespace version dir>/<db> */
+    parent = last_dir_separator(dir);
+    if (parent == NULL)
+        return false;
+    for (p = parent + 1; *p; p++)
+    {
+        if (!isdigit((unsigned char) *p))
+            return false;
+    }
+    *parent = '\0';
+    parent = last_dir_separator(dir);
+    parent = parent ? parent + 1 : dir;
+
+    return strcmp(parent, "base") == 0 ||
+        strncmp(parent, "PG_", 3) == 0;
+}
+
+/*
+ * Send a relation segment as "<name>.incr", with only the blocks changed
+ * since incremental_lsn.  The client keeps the other blocks from the earlier
+ * backup.  New pages always count as changed.
+ *
+ * Returns false without sending anything if the segment is not a whole
+ * number of blocks; the caller then sends it whole.
+ */
+static bool
+sendIncrementalFile(FILE *fp, char *readfilename, char *tarfilename,
+                    struct stat *statbuf)
+{// #lizard forgives
+    union
+    {
+        char        data[BLCKSZ];
+        double        force_align_d;
+        int64        force_align_i64;
+    }            page;
+    IncrementalFileHeader hdr;
+    BlockNumber *changed;
+    BlockNumber nblocks;
+    BlockNumber nchanged = 0;
+    BlockNumber blkno;
+    struct stat incrstat;
+    char       *incrname;
+    char       *buf;
+    size_t        hdrlen;
+    pgoff_t        len;
+    size_t        pad;
+    int            i;
+
+    if (statbuf->st_size % BLCKSZ != 0)
+        return false;
+
+    nblocks = statbuf->st_size / BLCKSZ;
+    changed = palloc(sizeof(BlockNumber) * Max(nblocks, 1));
+
+    /* Find the changed blocks */
+    for (blkno = 0; blkno < nblocks; blkno++)
+    {
+        if (fread(page.data, 1, BLCKSZ, fp) != BLCKSZ)
+        {
+            if (ferror(fp))
+                ereport(ERROR,
+                        (errcode_for_file_access(),
+                         errmsg("could not read file \"%s\": %m", readfilename)));
+
+            /* Truncated meanwhile, the rest will be restored from WAL */
+            nblocks = blkno;
+            break;
+        }
+
+        if (PageIsNew(page.data) || PageGetLSN(page.data) >= incremental_lsn)
+            changed[nchanged++] = blkno;
+
+        CHECK_FOR_INTERRUPTS();
+    }
+
+    hdr.magic = INCREMENTAL_FILE_MAGIC;
+    hdr.blcksz = BLCKSZ;
+    hdr.nblocks = nblocks;
+    hdr.nchanged = nchanged;
+    hdrlen = sizeof(hdr) + sizeof(BlockNumber) * nchanged;
+
+    memcpy(&incrstat, statbuf, sizeof(struct stat));
+    incrstat.st_size = hdrlen + (pgoff_t) nchanged * BLCKSZ;
+    incrname = psprintf("%s%s", tarfilename, INCREMENTAL_FILE_SUFFIX);
+    _tarWriteHeader(incrname, NULL, &incrstat, false);
+
+    buf = palloc(hdrlen);
+    memcpy(buf, &hdr, sizeof(hdr));
+    memcpy(buf + sizeof(hdr), changed, sizeof(BlockNumber) * nchanged);
+    bb_putmessage(buf, hdrlen);
+    len = hdrlen;
+    JudgeHalt(hdrlen);
+    throttle(hdrlen);
+
+    /* Send the changed blocks */
+    for (i = 0; i < nchanged; i++)
+    {
+        if (fseeko(fp, (pgoff_t) changed[i] * BLCKSZ, SEEK_SET) != 0)
+            ereport(ERROR,
+                    (errcode_for_file_access(),
+                     errmsg("could not seek in file \"%s\": %m", readfilename)));
+
+        if (fread(page.data, 1, BLCKSZ, fp) != BLCKSZ)
+        {
+            if (ferror(fp))
+                ereport(ERROR,
+                        (errcode_for_file_access(),
+                         errmsg("could not read file \"%s\": %m", readfilename)));
+
+            /* Truncated meanwhile, pad it with zeros as sendFile does */
+            MemSet(page.data, 0, BLCKSZ);
+        }
+
+        bb_putmessage(page.data, BLCKSZ);
+        len += BLCKSZ;
+        JudgeHalt(BLCKSZ);
+        throttle(BLCKSZ);
+    }
+
+    /* Pad to 512 byte boundary, per tar format requirements */
+    pad = ((len + 511) & ~511) - len;
+    if (pad > 0)
+    {
+        MemSet(page.data, 0, pad);
+        bb_putmessage(page.data, pad);
+        JudgeHalt(pad);
+    }
+
+    pfree(buf);
+    pfree(incrname);
+    pfree(changed);
+
+    return true;
+}
+
+Size
+BaseBackupShmemSize(void)
+{
+    return sizeof(BaseBackupStreamsState);
+}
+
+void
+BaseBackupShmemInit(void)
+{
+    bool        found;
+
+    BackupStreams = (BaseBackupStreamsState *)
+        ShmemInitStruct("Base Backup Streams", BaseBackupShmemSize(), &found);
+
+    if (!found)
+    {
+        MemSet(BackupStreams, 0, BaseBackupShmemSize());
+        SpinLockInit(&BackupStreams->mutex);
+        BackupStreams->startptr = InvalidXLogRecPtr;
+    }
+}
+
+/*
+ * Publish the parallel backup started at 'startptr', so that the other
+ * streams can attach to it.
+ */
+static void
+start_backup_streams(XLogRecPtr startptr, int nstreams)
+{
+    SpinLockAcquire(&BackupStreams->mutex);
+    if (!XLogRecPtrIsInvalid(BackupStreams->startptr))
+    {
+        SpinLockRelease(&BackupStreams->mutex);
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("a parallel base backup is already in progress")));
+    }
+    BackupStreams->startptr = startptr;
+    BackupStreams->nstreams = nstreams;
+    BackupStreams->ndone = 0;
+    BackupStreams->nfailed = 0;
+    BackupStreams->latch = MyLatch;
+    MemSet(BackupStreams->started, 0, sizeof(BackupStreams->started));
+    SpinLockRelease(&BackupStreams->mutex);
+
+    backup_streams_owner = true;
+}
+
+/*
+ * Wait for the other streams of the parallel backup to send their files.
+ * The client sends nothing meanwhile, so a readable socket means that it
+ * went away.
+ */
+static void
+wait_for_backup_streams(void)
+{// #lizard forgives
+    TimestampTz start = GetCurrentTimestamp();
+
+    for (;;)
+    {
+        int            nstreams;
+        int            nstarted = 0;
+        int            ndone;
+        int            nfailed;
+        int            rc;
+        int            i;
+
+        SpinLockAcquire(&BackupStreams->mutex);
+        nstreams = BackupStreams->nstreams;
+        ndone = BackupStreams->ndone;
+        nfailed = BackupStreams->nfailed;
+        for (i = 1; i < nstreams; i++)
+        {
+            if (BackupStreams->started[i])
+                nstarted++;
+        }
+        SpinLockRelease(&BackupStreams->mutex);
+
+        if (nfailed > 0)
+            ereport(ERROR,
+                    (errmsg("a stream of the parallel base backup failed, aborting backup")));
+        if (ndone == nstreams - 1)
+            break;
+        if (nstarted < nstreams - 1 && wal_sender_timeout > 0 &&
+            TimestampDifferenceExceeds(start, GetCurrentTimestamp(),
+                                       wal_sender_timeout))
+            ereport(ERROR,
+                    (errmsg("only %d of %d streams of the parallel base backup started, aborting backup",
+                            nstarted, nstreams - 1)));
+
+        rc = WaitLatchOrSocket(MyLatch,
+                               WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH |
+                               WL_SOCKET_READABLE,
+                               MyProcPort->sock, 1000L,
+                               WAIT_EVENT_BASE_BACKUP_STREAMS);
+
+        if (rc & WL_POSTMASTER_DEATH)
+            proc_exit(1);
+        if (rc & WL_LATCH_SET)
+        {
+            ResetLatch(MyLatch);
+            CHECK_FOR_INTERRUPTS();
+        }
+        if (rc & WL_SOCKET_READABLE)
+            ereport(ERROR,
+                    (errcode(ERRCODE_PROTOCOL_VIOLATION),
+                     errmsg("unexpected input from client during parallel base backup")));
+    }
+
+    backup_streams_cleanup(0, (Datum) 0);
+}
+
+/*
+ * Release the shared state of the parallel backup run by this process.
+ */
+static void
+backup_streams_cleanup(int code, Datum arg)
+{
+    if (!backup_streams_owner)
+        return;
+
+    SpinLockAcquire(&BackupStreams->mutex);
+    BackupStreams->startptr = InvalidXLogRecPtr;
+    BackupStreams->latch = NULL;
+    SpinLockRelease(&BackupStreams->mutex);
+
+    backup_streams_owner = false;
+}
+
+/*
+ * Tell the process running the parallel backup that this stream failed.
+ */
+static void
+backup_stream_cleanup(int code, Datum arg)
+{
+    XLogRecPtr    startptr = DatumGetInt64(arg);
+    Latch       *latch = NULL;
+
+    SpinLockAcquire(&BackupStreams->mutex);
+    if (BackupStreams->startptr == startptr)
+    {
+        BackupStreams->nfailed++;
+        latch = BackupStreams->latch;
+    }
+    SpinLockRelease(&BackupStreams->mutex);
+
+    if (latch)
+        SetLatch(latch);
+}
+
+/*
+ * Send the files of one of the other streams of a parallel backup: one tar
+ * stream per tablespace, the main data directory last, as the first stream
+ * does.  backup_label, tablespace_map, pg_control, the tablespace links and
+ * the WAL files are only sent by the first stream.
+ */
+static void
+perform_backup_stream(basebackup_options *opt)
+{// #lizard forgives
+    List       *tablespaces = NIL;
+    tablespaceinfo *ti;
+    bool        attached = false;
+    Latch       *latch = NULL;
+
+    SpinLockAcquire(&BackupStreams->mutex);
+    if (BackupStreams->startptr == opt->stream_startptr &&
+        BackupStreams->nstreams == opt->nstreams &&
+        !BackupStreams->started[opt->stream])
+    {
+        BackupStreams->started[opt->stream] = true;
+        attached = true;
+    }
+    SpinLockRelease(&BackupStreams->mutex);
+
+    if (!attached)
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("stream %d of the parallel base backup started at %X/%X is not expected",
+                        opt->stream,
+                        (uint32) (opt->stream_startptr >> 32),
+                        (uint32) opt->stream_startptr)));
+
+    BeginTransfer();
+    backup_started_in_recovery = RecoveryInProgress();
+
+    PG_ENSURE_ERROR_CLEANUP(backup_stream_cleanup,
+                            Int64GetDatum(opt->stream_startptr));
+    {
+        ListCell   *lc;
+        DIR           *dir;
+        struct dirent *de;
+        int            datadirpathlen = strlen(DataDir);
+
+        /* Collect the tablespaces as do_pg_start_backup does */
+        dir = AllocateDir("pg_tblspc");
+        while ((de = ReadDir(dir, "pg_tblspc")) != NULL)
+        {
+#if defined(HAVE_READLINK) || defined(WIN32)
+            char        fullpath[MAXPGPATH + 10];
+            char        linkpath[MAXPGPATH];
+            int            rllen;
+
+            if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+                continue;
+
+            snprintf(fullpath, sizeof(fullpath), "pg_tblspc/%s", de->d_name);
+            rllen = readlink(fullpath, linkpath, sizeof(linkpath));
+            if (rllen < 0 || rllen >= sizeof(linkpath))
+                continue;
+            linkpath[rllen] = '\0';
+
+            ti = palloc0(sizeof(tablespaceinfo));
+            ti->oid = pstrdup(de->d_name);
+            ti->path = pstrdup(linkpath);
+            if (rllen > datadirpathlen &&
+                strncmp(linkpath, DataDir, datadirpathlen) == 0 &&
+                IS_DIR_SEP(linkpath[datadirpathlen]))
+                ti->rpath = pstrdup(linkpath + datadirpathlen + 1);
+            ti->size = -1;
+            tablespaces = lappend(tablespaces, ti);
+#endif
+        }
+        FreeDir(dir);
+
+        setup_statrelpath();
+
+        /* Add a node for the base directory at the end */
+        ti = palloc0(sizeof(tablespaceinfo));
+        ti->size = -1;
+        tablespaces = lappend(tablespaces, ti);
+
+        SendBackupHeader(tablespaces);
+        JudgeHalt(512);
+        setup_throttling(opt->maxrate);
+
+        foreach(lc, tablespaces)
+        {
+            ti = (tablespaceinfo *) lfirst(lc);
+
+            bb_begin_copyout();
+            if (ti->path == NULL)
+                sendDir(".", 1, false, tablespaces, false);
+            else
+                sendTablespace(ti->path, false);
+            pq_putemptymessage('c');    /* CopyDone */
+        }
+    }
+    PG_END_ENSURE_ERROR_CLEANUP(backup_stream_cleanup,
+                                Int64GetDatum(opt->stream_startptr));
+
+    SpinLockAcquire(&BackupStreams->mutex);
+    if (BackupStreams->startptr == opt->stream_startptr)
+    {
+        BackupStreams->ndone++;
+        latch = BackupStreams->latch;
+    }
+    SpinLockRelease(&BackupStreams->mutex);
+
+    if (latch)
+        SetLatch(latch);
+}
+#endif
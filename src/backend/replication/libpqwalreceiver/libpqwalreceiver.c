@@ -394,6 +394,13 @@ libpqrcv_startstreaming(WalReceiverConn *conn,
         PQfreemem(pubnames_literal);
         pfree(pubnames_str);
 
+#ifdef __SUBSCRIPTION__
+        if (options->proto.logical.streaming)
+            appendStringInfoString(&cmd, ", streaming 'on'");
+        if (options->proto.logical.binary)
+            appendStringInfoString(&cmd, ", binary 'on'");
+#endif
+
         appendStringInfoChar(&cmd, ')');
     }
     else
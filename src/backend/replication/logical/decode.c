@@ -220,6 +220,17 @@ LogicalDecodingProcessRecord(LogicalDecodingContext *ctx, XLogReaderState *recor
     buf.endptr = ctx->reader->EndRecPtr;
     buf.record = record;
 
+#ifdef __SUBSCRIPTION__
+    /*
+     * The first record of a subtransaction names its toplevel transaction, so
+     * the subtransaction is known to belong to it long before the commit.
+     * Transactions can only be streamed with that knowledge.
+     */
+    if (TransactionIdIsValid(XLogRecGetTopXid(record)))
+        ReorderBufferAssignChild(ctx->reorder, XLogRecGetTopXid(record),
+                                 XLogRecGetXid(record), buf.origptr);
+#endif
+
     /* cast so we get a warning when new rmgrs are added */
     switch ((RmgrIds) XLogRecGetRmid(record))
     {
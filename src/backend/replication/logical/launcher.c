@@ -48,6 +48,9 @@
 
 #include "tcop/tcopprot.h"
 
+#ifdef __SUBSCRIPTION__
+#include "utils/fmgrprotos.h"
+#endif
 #include "utils/memutils.h"
 #include "utils/pg_lsn.h"
 #include "utils/ps_status.h"
@@ -89,6 +92,10 @@ static void logicalrep_launcher_onexit(int code, Datum arg);
 static void logicalrep_worker_onexit(int code, Datum arg);
 static void logicalrep_worker_detach(void);
 static void logicalrep_worker_cleanup(LogicalRepWorker *worker);
+static BackgroundWorkerHandle *logicalrep_worker_launch_internal(Oid dbid,
+                                  Oid subid, const char *subname, Oid userid,
+                                  Oid relid, int sync_stream, int sync_nstreams,
+                                  dsm_handle sync_dsm);
 
 /* Flags set by signal handlers */
 static volatile sig_atomic_t got_SIGHUP = false;
@@ -250,6 +257,12 @@ logicalrep_worker_find(Oid subid, Oid relid, bool only_running)
     {
         LogicalRepWorker *w = &LogicalRepCtx->workers[i];
 
+#ifdef __SUBSCRIPTION__
+        /* Helpers of a sync worker are never looked up by relid. */
+        if (w->sync_stream > 0)
+            continue;
+#endif
+
         if (w->in_use && w->subid == subid && w->relid == relid &&
             (!only_running || w->proc))
         {
@@ -291,6 +304,37 @@ logicalrep_workers_find(Oid subid, bool only_running)
 void
 logicalrep_worker_launch(Oid dbid, Oid subid, const char *subname, Oid userid,
                          Oid relid)
+{
+    (void) logicalrep_worker_launch_internal(dbid, subid, subname, userid,
+                                             relid, 0, 0, DSM_HANDLE_INVALID);
+}
+
+#ifdef __SUBSCRIPTION__
+/*
+ * Start a helper of the sync worker of relid, which copies stream number
+ * stream of nstreams as described in the segment handle.  Returns NULL if it
+ * could not be started.
+ */
+BackgroundWorkerHandle *
+logicalrep_sync_stream_launch(Oid dbid, Oid subid, const char *subname,
+                              Oid userid, Oid relid, int stream, int nstreams,
+                              dsm_handle handle)
+{
+    Assert(stream > 0 && OidIsValid(relid));
+
+    return logicalrep_worker_launch_internal(dbid, subid, subname, userid,
+                                             relid, stream, nstreams, handle);
+}
+#endif
+
+/*
+ * Register the worker and wait for it to attach; returns its handle, or NULL
+ * if it could not be registered.
+ */
+static BackgroundWorkerHandle *
+logicalrep_worker_launch_internal(Oid dbid, Oid subid, const char *subname,
+                                  Oid userid, Oid relid, int sync_stream,
+                                  int sync_nstreams, dsm_handle sync_dsm)
 {// #lizard forgives
     BackgroundWorker bgw;
     BackgroundWorkerHandle *bgw_handle;
@@ -376,7 +420,7 @@ retry:
     if (nsyncworkers >= max_sync_workers_per_subscription)
     {
         LWLockRelease(LogicalRepWorkerLock);
-        return;
+        return NULL;
     }
 
     /*
@@ -390,7 +434,7 @@ retry:
                 (errcode(ERRCODE_CONFIGURATION_LIMIT_EXCEEDED),
                  errmsg("out of logical replication worker slots"),
                  errhint("You might need to increase max_logical_replication_workers.")));
-        return;
+        return NULL;
     }
 
     /* Prepare the worker slot. */
@@ -409,6 +453,15 @@ retry:
     TIMESTAMP_NOBEGIN(worker->last_recv_time);
     worker->reply_lsn = InvalidXLogRecPtr;
     TIMESTAMP_NOBEGIN(worker->reply_time);
+#ifdef __SUBSCRIPTION__
+    worker->apply_final_lsn = InvalidXLogRecPtr;
+    worker->sync_stream = sync_stream;
+    worker->sync_nstreams = sync_nstreams;
+    worker->sync_first_shard = -1;
+    worker->sync_last_shard = -1;
+    worker->sync_dsm = sync_dsm;
+    worker->sync_ntuples = 0;
+#endif
 
     LWLockRelease(LogicalRepWorkerLock);
 
@@ -419,6 +472,12 @@ retry:
     bgw.bgw_start_time = BgWorkerStart_RecoveryFinished;
     snprintf(bgw.bgw_library_name, BGW_MAXLEN, "postgres");
     snprintf(bgw.bgw_function_name, BGW_MAXLEN, "ApplyWorkerMain");
+#ifdef __SUBSCRIPTION__
+    if (sync_stream > 0)
+        snprintf(bgw.bgw_name, BGW_MAXLEN,
+                 "logical replication sync %u stream %d", relid, sync_stream);
+    else
+#endif
     if (OidIsValid(relid))
         snprintf(bgw.bgw_name, BGW_MAXLEN,
                  "logical replication worker for subscription %u sync %u", subid, relid);
@@ -436,11 +495,13 @@ retry:
                 (errcode(ERRCODE_CONFIGURATION_LIMIT_EXCEEDED),
                  errmsg("out of background worker slots"),
                  errhint("You might need to increase max_worker_processes.")));
-        return;
+        return NULL;
     }
 
     /* Now wait until it attaches. */
     WaitForReplicationWorkerAttach(worker, bgw_handle);
+
+    return bgw_handle;
 }
 
 /*
@@ -665,6 +726,11 @@ logicalrep_worker_cleanup(LogicalRepWorker *worker)
     worker->userid = InvalidOid;
     worker->subid = InvalidOid;
     worker->relid = InvalidOid;
+#ifdef __SUBSCRIPTION__
+    worker->sync_stream = 0;
+    worker->sync_nstreams = 0;
+    worker->sync_dsm = DSM_HANDLE_INVALID;
+#endif
 }
 
 /*
@@ -1106,3 +1172,107 @@ pg_stat_get_subscription(PG_FUNCTION_ARGS)
 
     return (Datum) 0;
 }
+
+#ifdef __SUBSCRIPTION__
+/*
+ * Returns progress of the streams of the initial table copies that are
+ * running in parallel.
+ */
+Datum
+tbase_get_sync_stream_stat(PG_FUNCTION_ARGS)
+{
+#define TBASE_GET_SYNC_STREAM_STAT_COLS    8
+    int            i;
+    ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    TupleDesc    tupdesc;
+    Tuplestorestate *tupstore;
+    MemoryContext per_query_ctx;
+    MemoryContext oldcontext;
+
+    /* check to see if caller supports us returning a tuplestore */
+    if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("set-valued function called in context that cannot accept a set")));
+    if (!(rsinfo->allowedModes & SFRM_Materialize))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("materialize mode required, but it is not " \
+                        "allowed in this context")));
+
+    /* Build a tuple descriptor for our result type */
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        elog(ERROR, "return type must be a row type");
+
+    per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+    oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+    tupstore = tuplestore_begin_heap(true, false, work_mem);
+    rsinfo->returnMode = SFRM_Materialize;
+    rsinfo->setResult = tupstore;
+    rsinfo->setDesc = tupdesc;
+
+    MemoryContextSwitchTo(oldcontext);
+
+    LWLockAcquire(LogicalRepWorkerLock, LW_SHARED);
+
+    for (i = 0; i < max_logical_replication_workers; i++)
+    {
+        Datum        values[TBASE_GET_SYNC_STREAM_STAT_COLS];
+        bool        nulls[TBASE_GET_SYNC_STREAM_STAT_COLS];
+        LogicalRepWorker *w = &LogicalRepCtx->workers[i];
+        int            worker_pid;
+        int            stream;
+        int            nstreams;
+        int            first_shard;
+        int            last_shard;
+        uint64        ntuples;
+
+        if (!w->proc || !OidIsValid(w->relid) || !IsBackendPid(w->proc->pid))
+            continue;
+
+        SpinLockAcquire(&w->relmutex);
+        stream = w->sync_stream;
+        nstreams = w->sync_nstreams;
+        first_shard = w->sync_first_shard;
+        last_shard = w->sync_last_shard;
+        ntuples = w->sync_ntuples;
+        SpinLockRelease(&w->relmutex);
+
+        /* Only workers busy with a copy have something to report. */
+        if (nstreams == 0)
+            continue;
+
+        worker_pid = w->proc->pid;
+
+        MemSet(values, 0, sizeof(values));
+        MemSet(nulls, 0, sizeof(nulls));
+
+        values[0] = ObjectIdGetDatum(w->subid);
+        values[1] = ObjectIdGetDatum(w->relid);
+        values[2] = Int32GetDatum(worker_pid);
+        values[3] = Int32GetDatum(stream);
+        values[4] = Int32GetDatum(nstreams);
+        if (first_shard < 0)
+        {
+            nulls[5] = true;
+            nulls[6] = true;
+        }
+        else
+        {
+            values[5] = Int32GetDatum(first_shard);
+            values[6] = Int32GetDatum(last_shard);
+        }
+        values[7] = Int64GetDatum((int64) ntuples);
+
+        tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+    }
+
+    LWLockRelease(LogicalRepWorkerLock);
+
+    /* clean up and return the tuplestore */
+    tuplestore_donestoring(tupstore);
+
+    return (Datum) 0;
+}
+#endif
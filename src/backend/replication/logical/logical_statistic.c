@@ -48,6 +48,8 @@ typedef struct
     int64     ntups_delete;      /* number of tuples deleted during replication */
     int64     checksum_insert;   /* checksum of all tuples inserted during replication */
     int64     checksum_delete;   /* checksum of all tuples deleted during replication */
+    int64     ntxns_apply;       /* number of remote transactions committed by apply */
+    int64     commit_wait_time;  /* microseconds spent waiting for commit order */
 } StatisticData;
 
 /* statistic data for publication in hashtable */
@@ -369,11 +371,38 @@ UpdateSubStatistics(char *subname, uint64 ntups_copy, uint64 ntups_insert, uint6
         ent->data.ntups_copy = ntups_copy;
         ent->data.ntups_insert = ntups_insert;
         ent->data.ntups_delete = ntups_delete;
+        ent->data.ntxns_apply = 0;
+        ent->data.commit_wait_time = 0;
     }
 
     LWLockRelease(SubStatLock);
 }
 
+/* update transaction throughput of subscription, counted by apply worker */
+void
+UpdateSubApplyStatistics(char *subname, uint64 ntxns_apply, uint64 commit_wait_time)
+{
+    bool found;
+    StatTag key;
+    StatEnt *ent;
+
+    snprintf(key.subname, NAMEDATALEN, "%s", subname);
+
+    LWLockAcquire(SubStatLock, LW_EXCLUSIVE);
+
+    ent = hash_search(SubStatHash, &key, HASH_ENTER, &found);
+
+    if (!found)
+    {
+        memset(&ent->data, 0, sizeof(StatisticData));
+    }
+
+    ent->data.ntxns_apply += ntxns_apply;
+    ent->data.commit_wait_time += commit_wait_time;
+
+    LWLockRelease(SubStatLock);
+}
+
 void
 GetSubTableEntry(Oid subid, Oid relid, void **entry, CmdType cmd)
 {
@@ -656,7 +685,8 @@ Datum tbase_get_all_pub_stat(PG_FUNCTION_ARGS)
 /* show statistic data of one subscription */
 Datum tbase_get_sub_stat(PG_FUNCTION_ARGS)
 {
-#define NCOLUMNS 6
+#undef NCOLUMNS
+#define NCOLUMNS 8
     bool        found;
     StatTag     key;
     StatEnt     *ent;
@@ -683,6 +713,10 @@ Datum tbase_get_sub_stat(PG_FUNCTION_ARGS)
                        INT8OID, -1, 0);
     TupleDescInitEntry(tupdesc, (AttrNumber) 6,  "checksum_delete" ,
                        INT8OID, -1, 0);
+    TupleDescInitEntry(tupdesc, (AttrNumber) 7,  "ntxns_apply" ,
+                       INT8OID, -1, 0);
+    TupleDescInitEntry(tupdesc, (AttrNumber) 8,  "commit_wait_time" ,
+                       INT8OID, -1, 0);
     tupdesc = BlessTupleDesc(tupdesc);
 
     LWLockAcquire(SubStatLock, LW_SHARED);
@@ -712,6 +746,12 @@ Datum tbase_get_sub_stat(PG_FUNCTION_ARGS)
 
         nulls[5] = false;
         values[5] = Int64GetDatum(ent->data.checksum_delete);
+
+        nulls[6] = false;
+        values[6] = Int64GetDatum(ent->data.ntxns_apply);
+
+        nulls[7] = false;
+        values[7] = Int64GetDatum(ent->data.commit_wait_time);
     }
 
     LWLockRelease(SubStatLock);
@@ -725,7 +765,8 @@ Datum tbase_get_sub_stat(PG_FUNCTION_ARGS)
 /* show statistic data of all subscription  */
 Datum tbase_get_all_sub_stat(PG_FUNCTION_ARGS)
 {
-#define NCOLUMNS 6
+#undef NCOLUMNS
+#define NCOLUMNS 8
     FuncCallContext     *funcctx;
     StatEnt             *ent;
     StatInfo            *info;
@@ -752,6 +793,10 @@ Datum tbase_get_all_sub_stat(PG_FUNCTION_ARGS)
                            INT8OID, -1, 0);
         TupleDescInitEntry(tupdesc, (AttrNumber) 6,  "checksum_delete",
                            INT8OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 7,  "ntxns_apply",
+                           INT8OID, -1, 0);
+        TupleDescInitEntry(tupdesc, (AttrNumber) 8,  "commit_wait_time",
+                           INT8OID, -1, 0);
 
         funcctx->tuple_desc = BlessTupleDesc(tupdesc);
 
@@ -789,6 +834,10 @@ Datum tbase_get_all_sub_stat(PG_FUNCTION_ARGS)
 
         values[5] = Int64GetDatum(ent->data.checksum_delete);
 
+        values[6] = Int64GetDatum(ent->data.ntxns_apply);
+
+        values[7] = Int64GetDatum(ent->data.commit_wait_time);
+
         tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
         SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
     }
@@ -13,6 +13,7 @@
 #include "postgres.h"
 
 #include "access/sysattr.h"
+#include "access/transam.h"
 #include "catalog/pg_namespace.h"
 #include "catalog/pg_type.h"
 #include "libpq/pqformat.h"
@@ -51,6 +52,7 @@ static int32 logicalrep_dml_hashmod = 0;        /* The number of parallel tbase-
 static int32 logicalrep_dml_hashvalue = 0;        /* Send Tuple to the subscriber only if the Hash value is equal to this value
                                                   */
 static bool     logicalrep_dml_send_all = true;    /* Do I need to send all tuples to the subscriber? */
+static bool     logicalrep_binary = false;        /* Send column values by the type's send function? */
 #endif
 
 /*
@@ -149,18 +151,148 @@ logicalrep_read_origin(StringInfo in, XLogRecPtr *origin_lsn)
     return pstrdup(pq_getmsgstring(in));
 }
 
+#ifdef __SUBSCRIPTION__
+/*
+ * Write STREAM START to the output stream.
+ */
+void
+logicalrep_write_stream_start(StringInfo out, TransactionId xid,
+                              bool first_segment)
+{
+    pq_sendbyte(out, 'S');        /* STREAM START */
+
+    Assert(TransactionIdIsValid(xid));
+
+    /* transaction ID (we're starting to stream, so must be valid) */
+    pq_sendint(out, xid, 4);
+
+    /* 1 if this is the first streaming segment for this xid */
+    pq_sendbyte(out, first_segment ? 1 : 0);
+}
+
+/*
+ * Read STREAM START from the output stream.
+ */
+TransactionId
+logicalrep_read_stream_start(StringInfo in, bool *first_segment)
+{
+    TransactionId xid;
+
+    xid = pq_getmsgint(in, 4);
+    *first_segment = (pq_getmsgbyte(in) == 1);
+
+    return xid;
+}
+
+/*
+ * Write STREAM STOP to the output stream.
+ */
+void
+logicalrep_write_stream_stop(StringInfo out)
+{
+    pq_sendbyte(out, 'E');        /* STREAM STOP */
+}
+
+/*
+ * Write STREAM COMMIT to the output stream.
+ */
+void
+logicalrep_write_stream_commit(StringInfo out, ReorderBufferTXN *txn,
+                               XLogRecPtr commit_lsn)
+{
+    uint8        flags = 0;
+
+    pq_sendbyte(out, 'c');        /* STREAM COMMIT */
+
+    Assert(TransactionIdIsValid(txn->xid));
+
+    /* transaction ID */
+    pq_sendint(out, txn->xid, 4);
+
+    /* send the flags field (unused for now) */
+    pq_sendbyte(out, flags);
+
+    /* send fields */
+    pq_sendint64(out, commit_lsn);
+    pq_sendint64(out, txn->end_lsn);
+    pq_sendint64(out, txn->commit_time);
+}
+
+/*
+ * Read STREAM COMMIT from the output stream.
+ */
+TransactionId
+logicalrep_read_stream_commit(StringInfo in,
+                              LogicalRepCommitData *commit_data)
+{
+    TransactionId xid;
+    uint8        flags;
+
+    xid = pq_getmsgint(in, 4);
+
+    /* read flags (unused for now) */
+    flags = pq_getmsgbyte(in);
+
+    if (flags != 0)
+        elog(ERROR, "unrecognized flags %u in commit message", flags);
+
+    /* read fields */
+    commit_data->commit_lsn = pq_getmsgint64(in);
+    commit_data->end_lsn = pq_getmsgint64(in);
+    commit_data->committime = pq_getmsgint64(in);
+
+    return xid;
+}
+
+/*
+ * Write STREAM ABORT to the output stream. Note that xid and subxid will be
+ * same for the top-level transaction abort.
+ */
+void
+logicalrep_write_stream_abort(StringInfo out, TransactionId xid,
+                              TransactionId subxid)
+{
+    pq_sendbyte(out, 'A');        /* STREAM ABORT */
+
+    Assert(TransactionIdIsValid(xid) && TransactionIdIsValid(subxid));
+
+    /* transaction ID */
+    pq_sendint(out, xid, 4);
+    pq_sendint(out, subxid, 4);
+}
+
+/*
+ * Read STREAM ABORT from the output stream.
+ */
+void
+logicalrep_read_stream_abort(StringInfo in, TransactionId *xid,
+                             TransactionId *subxid)
+{
+    Assert(xid && subxid);
+
+    *xid = pq_getmsgint(in, 4);
+    *subxid = pq_getmsgint(in, 4);
+}
+#endif
+
 /*
  * Write INSERT to the output stream.
  */
 void
 logicalrep_write_insert(StringInfo out, Relation rel,
 #ifdef __SUBSCRIPTION__
-                        int32 tuple_hash,
+                        TransactionId xid, int32 tuple_hash,
 #endif
                         HeapTuple newtuple)
 {
     pq_sendbyte(out, 'I');        /* action INSERT */
 
+#ifdef __SUBSCRIPTION__
+    /* transaction ID, if the change is part of a streamed transaction */
+    if (TransactionIdIsValid(xid))
+        pq_sendint(out, xid, 4);
+#endif
+
     Assert(rel->rd_rel->relreplident == REPLICA_IDENTITY_DEFAULT ||
            rel->rd_rel->relreplident == REPLICA_IDENTITY_FULL ||
            rel->rd_rel->relreplident == REPLICA_IDENTITY_INDEX);
@@ -257,13 +389,19 @@ logicalrep_read_insert(StringInfo in,
 void
 logicalrep_write_update(StringInfo out, Relation rel, 
 #ifdef __SUBSCRIPTION__
-                        int32 tuple_hash,
+                        TransactionId xid, int32 tuple_hash,
 #endif
                         HeapTuple oldtuple,
                         HeapTuple newtuple)
 {// #lizard forgives    
     pq_sendbyte(out, 'U');        /* action UPDATE */
 
+#ifdef __SUBSCRIPTION__
+    /* transaction ID, if the change is part of a streamed transaction */
+    if (TransactionIdIsValid(xid))
+        pq_sendint(out, xid, 4);
+#endif
+
     Assert(rel->rd_rel->relreplident == REPLICA_IDENTITY_DEFAULT ||
            rel->rd_rel->relreplident == REPLICA_IDENTITY_FULL ||
            rel->rd_rel->relreplident == REPLICA_IDENTITY_INDEX);
@@ -390,7 +528,7 @@ logicalrep_read_update(StringInfo in,
 void
 logicalrep_write_delete(StringInfo out, Relation rel,
 #ifdef __SUBSCRIPTION__
-                        int32 tuple_hash,
+                        TransactionId xid, int32 tuple_hash,
 #endif
                         HeapTuple oldtuple)
 {
@@ -400,6 +538,12 @@ logicalrep_write_delete(StringInfo out, Relation rel,
 
     pq_sendbyte(out, 'D');        /* action DELETE */
 
+#ifdef __SUBSCRIPTION__
+    /* transaction ID, if the change is part of a streamed transaction */
+    if (TransactionIdIsValid(xid))
+        pq_sendint(out, xid, 4);
+#endif
+
     /* use Oid as relation identifier */
     pq_sendint(out, RelationGetRelid(rel), 4);
 
@@ -494,12 +638,22 @@ logicalrep_read_delete(StringInfo in,
  * Write relation description to the output stream.
  */
 void
-logicalrep_write_rel(StringInfo out, Relation rel)
+logicalrep_write_rel(StringInfo out,
+#ifdef __SUBSCRIPTION__
+                     TransactionId xid,
+#endif
+                     Relation rel)
 {
     char       *relname;
 
     pq_sendbyte(out, 'R');        /* sending RELATION */
 
+#ifdef __SUBSCRIPTION__
+    /* transaction ID, if the change is part of a streamed transaction */
+    if (TransactionIdIsValid(xid))
+        pq_sendint(out, xid, 4);
+#endif
+
     /* use Oid as relation identifier */
     pq_sendint(out, RelationGetRelid(rel), 4);
 
@@ -602,7 +756,11 @@ void logicalrep_relation_free(LogicalRepRelation * rel)
  * This function will always write base type info.
  */
 void
-logicalrep_write_typ(StringInfo out, Oid typoid)
+logicalrep_write_typ(StringInfo out,
+#ifdef __SUBSCRIPTION__
+                     TransactionId xid,
+#endif
+                     Oid typoid)
 {
     Oid            basetypoid = getBaseType(typoid);
     HeapTuple    tup;
@@ -610,6 +768,12 @@ logicalrep_write_typ(StringInfo out, Oid typoid)
 
     pq_sendbyte(out, 'Y');        /* sending TYPE */
 
+#ifdef __SUBSCRIPTION__
+    /* transaction ID, if the change is part of a streamed transaction */
+    if (TransactionIdIsValid(xid))
+        pq_sendint(out, xid, 4);
+#endif
+
     tup = SearchSysCache1(TYPEOID, ObjectIdGetDatum(basetypoid));
     if (!HeapTupleIsValid(tup))
         elog(ERROR, "cache lookup failed for type %u", basetypoid);
@@ -704,6 +868,32 @@ logicalrep_write_tuple(StringInfo out, Relation rel,
             elog(ERROR, "cache lookup failed for type %u", att->atttypid);
         typclass = (Form_pg_type) GETSTRUCT(typtup);
 
+#ifdef __SUBSCRIPTION__
+        /*
+         * Built-in types have the same OID and binary format on every node,
+         * so the subscriber can check that its column takes the value as is.
+         * Everything else, including arrays and composites of user-defined
+         * types, still goes as text.
+         */
+        if (logicalrep_binary && OidIsValid(typclass->typsend) &&
+            att->atttypid < FirstNormalObjectId)
+        {
+            bytea       *outputbytes;
+            int            len;
+
+            pq_sendbyte(out, LOGICALREP_COLUMN_BINARY);    /* 'binary' data follows */
+
+            outputbytes = OidSendFunctionCall(typclass->typsend, values[i]);
+            len = VARSIZE(outputbytes) - VARHDRSZ;
+            pq_sendint(out, len, 4);
+            pq_sendbytes(out, VARDATA(outputbytes), len);
+            pfree(outputbytes);
+
+            ReleaseSysCache(typtup);
+            continue;
+        }
+#endif
+
         pq_sendbyte(out, 't');    /* 'text' data follows */
 
         outputstr = OidOutputFunctionCall(typclass->typoutput, values[i]);
@@ -753,6 +943,9 @@ logicalrep_read_tuple(StringInfo in, LogicalRepTupleData *tuple)
                 tuple->values[i] = NULL;
                 break;
             case 't':            /* text formatted value */
+#ifdef __SUBSCRIPTION__
+            case LOGICALREP_COLUMN_BINARY:    /* binary formatted value */
+#endif
                 {
                     int            len;
 
@@ -764,6 +957,10 @@ logicalrep_read_tuple(StringInfo in, LogicalRepTupleData *tuple)
                     tuple->values[i] = palloc(len + 1);
                     pq_copymsgbytes(in, tuple->values[i], len);
                     tuple->values[i][len] = '\0';
+#ifdef __SUBSCRIPTION__
+                    tuple->formats[i] = kind;
+                    tuple->lengths[i] = len;
+#endif
                 }
                 break;
             default:
@@ -942,6 +1139,11 @@ bool logicalrep_dml_get_send_all(void)
     return logicalrep_dml_send_all;
 }
 
+void logicalrep_set_binary(bool binary)
+{
+    logicalrep_binary = binary;
+}
+
 int32 logicalrep_dml_calc_hash(Relation rel, HeapTuple tuple)
 {// #lizard forgives
     TupleDesc    desc = NULL;
@@ -251,6 +251,16 @@ static void ReorderBufferExecuteInvalidations(ReorderBuffer *rb, ReorderBufferTX
  * ---------------------------------------
  */
 static void ReorderBufferCheckSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
+static void ReorderBufferProcessTXN(ReorderBuffer *rb, ReorderBufferTXN *txn,
+                        XLogRecPtr commit_lsn, bool streaming);
+#ifdef __SUBSCRIPTION__
+static bool ReorderBufferCanStream(ReorderBuffer *rb, ReorderBufferTXN *txn);
+static void ReorderBufferTruncateTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
+
+/* have changes of the transaction tree been streamed already? */
+#define ReorderBufferTXNStreamed(txn) \
+    ((txn)->toptxn != NULL ? (txn)->toptxn->streamed : (txn)->streamed)
+#endif
 static void ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
 static void ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
                              int fd, ReorderBufferChange *change);
@@ -643,6 +653,9 @@ ReorderBufferQueueChange(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn,
     txn = ReorderBufferTXNByXid(rb, xid, true, NULL, lsn, true);
 
     change->lsn = lsn;
+#ifdef __SUBSCRIPTION__
+    change->txn = txn;
+#endif
     Assert(InvalidXLogRecPtr != lsn);
     dlist_push_tail(&txn->changes, &change->node);
     txn->nentries++;
@@ -775,6 +788,10 @@ ReorderBufferAssignChild(ReorderBuffer *rb, TransactionId xid,
          * that have not yet produced any records. Knowing those aren't top
          * level xids allows us to make processing cheaper in some places.
          */
+#ifdef __SUBSCRIPTION__
+        subtxn->is_known_as_subxact = true;
+        subtxn->toptxn = txn;
+#endif
         dlist_push_tail(&txn->subtxns, &subtxn->node);
         txn->nsubtxns++;
     }
@@ -782,6 +799,9 @@ ReorderBufferAssignChild(ReorderBuffer *rb, TransactionId xid,
     {
         subtxn->is_known_as_subxact = true;
         Assert(subtxn->nsubtxns == 0);
+#ifdef __SUBSCRIPTION__
+        subtxn->toptxn = txn;
+#endif
 
         /* remove from lsn order list of top-level transactions */
         dlist_delete(&subtxn->node);
@@ -832,6 +852,11 @@ ReorderBufferCommitChild(ReorderBuffer *rb, TransactionId xid,
         (txn->base_snapshot == NULL ||
          txn->base_snapshot_lsn > subtxn->base_snapshot_lsn))
     {
+#ifdef __SUBSCRIPTION__
+        /* the toplevel may have one already, see ReorderBufferSetBaseSnapshot */
+        if (txn->base_snapshot != NULL)
+            SnapBuildSnapDecRefcount(txn->base_snapshot);
+#endif
         txn->base_snapshot = subtxn->base_snapshot;
         txn->base_snapshot_lsn = subtxn->base_snapshot_lsn;
         subtxn->base_snapshot = NULL;
@@ -845,6 +870,9 @@ ReorderBufferCommitChild(ReorderBuffer *rb, TransactionId xid,
     {
         subtxn->is_known_as_subxact = true;
         Assert(subtxn->nsubtxns == 0);
+#ifdef __SUBSCRIPTION__
+        subtxn->toptxn = txn;
+#endif
 
         /* remove from lsn order list of top-level transactions */
         dlist_delete(&subtxn->node);
@@ -1183,6 +1211,14 @@ ReorderBufferCleanupTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
         txn->base_snapshot_lsn = InvalidXLogRecPtr;
     }
 
+#ifdef __SUBSCRIPTION__
+    if (txn->stream_snapshot != NULL)
+    {
+        ReorderBufferFreeSnap(rb, txn->stream_snapshot);
+        txn->stream_snapshot = NULL;
+    }
+#endif
+
     /*
      * Remove TXN from its containing list.
      *
@@ -1372,12 +1408,8 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
                     XLogRecPtr commit_lsn, XLogRecPtr end_lsn,
                     TimestampTz commit_time,
                     RepOriginId origin_id, XLogRecPtr origin_lsn)
-{// #lizard forgives
+{
     ReorderBufferTXN *txn;
-    volatile Snapshot snapshot_now;
-    volatile CommandId command_id = FirstCommandId;
-    bool        using_subtxn;
-    ReorderBufferIterTXNState *volatile iterstate = NULL;
 
     txn = ReorderBufferTXNByXid(rb, xid, false, NULL, InvalidXLogRecPtr,
                                 false);
@@ -1405,7 +1437,47 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
         return;
     }
 
-    snapshot_now = txn->base_snapshot;
+#ifdef __SUBSCRIPTION__
+    /* the rest of a streamed transaction is streamed as well */
+    ReorderBufferProcessTXN(rb, txn, commit_lsn, txn->streamed);
+#else
+    ReorderBufferProcessTXN(rb, txn, commit_lsn, false);
+#endif
+}
+
+/*
+ * Replay the changes of a transaction and its subtransactions to the output
+ * plugin, in lsn order.
+ *
+ * Without streaming, this is done once the commit record has been read and
+ * the changes are wrapped in begin/commit callbacks.  With streaming, the
+ * changes queued so far go out between stream_start and stream_stop.  If
+ * commit_lsn is valid that was the last block and stream_commit follows;
+ * otherwise the changes are dropped from the buffer and the transaction goes
+ * on collecting changes, to be continued from the snapshot it ended with.
+ */
+static void
+ReorderBufferProcessTXN(ReorderBuffer *rb, ReorderBufferTXN *txn,
+                        XLogRecPtr commit_lsn, bool streaming)
+{// #lizard forgives
+    volatile Snapshot snapshot_now;
+    volatile CommandId command_id = FirstCommandId;
+    bool        using_subtxn;
+    ReorderBufferIterTXNState *volatile iterstate = NULL;
+
+#ifdef __SUBSCRIPTION__
+    if (txn->stream_snapshot != NULL)
+    {
+        /* recopy, the set of subtransactions may have grown since */
+        command_id = txn->stream_command_id;
+        snapshot_now = ReorderBufferCopySnap(rb, txn->stream_snapshot,
+                                             txn, command_id);
+        ReorderBufferFreeSnap(rb, txn->stream_snapshot);
+        txn->stream_snapshot = NULL;
+    }
+    else
+#endif
+        snapshot_now = txn->base_snapshot;
 
     /* build data to be able to lookup the CommandIds of catalog tuples */
     ReorderBufferBuildTupleCidHash(rb, txn);
@@ -1435,7 +1507,15 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
         else
             StartTransactionCommand();
 
-        rb->begin(rb, txn);
+#ifdef __SUBSCRIPTION__
+        if (streaming)
+        {
+            rb->stream_start(rb, txn);
+            txn->streamed = true;
+        }
+        else
+#endif
+            rb->begin(rb, txn);
 
         iterstate = ReorderBufferIterTXNInit(rb, txn);
         while ((change = ReorderBufferIterTXNNext(rb, iterstate)) != NULL)
@@ -1697,7 +1777,17 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
         iterstate = NULL;
 
         /* call commit callback */
-        rb->commit(rb, txn, commit_lsn);
+#ifdef __SUBSCRIPTION__
+        if (streaming)
+        {
+            rb->stream_stop(rb, txn);
+
+            if (commit_lsn != InvalidXLogRecPtr)
+                rb->stream_commit(rb, txn, commit_lsn);
+        }
+        else
+#endif
+            rb->commit(rb, txn, commit_lsn);
 
         /* this is just a sanity check against bad output plugin behaviour */
         if (GetCurrentTransactionIdIfAny() != InvalidTransactionId)
@@ -1721,11 +1811,29 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
         if (using_subtxn)
             RollbackAndReleaseCurrentSubTransaction();
 
-        if (snapshot_now->copied)
-            ReorderBufferFreeSnap(rb, snapshot_now);
+#ifdef __SUBSCRIPTION__
+        if (streaming && commit_lsn == InvalidXLogRecPtr)
+        {
+            /* keep our own copy, the snapshot may belong to a change */
+            if (snapshot_now->copied)
+                txn->stream_snapshot = snapshot_now;
+            else
+                txn->stream_snapshot = ReorderBufferCopySnap(rb, snapshot_now,
+                                                             txn, command_id);
+            txn->stream_command_id = command_id;
+
+            /* the changes are with the output plugin now */
+            ReorderBufferTruncateTXN(rb, txn);
+        }
+        else
+#endif
+        {
+            if (snapshot_now->copied)
+                ReorderBufferFreeSnap(rb, snapshot_now);
 
-        /* remove potential on-disk data, and deallocate */
-        ReorderBufferCleanupTXN(rb, txn);
+            /* remove potential on-disk data, and deallocate */
+            ReorderBufferCleanupTXN(rb, txn);
+        }
     }
     PG_CATCH();
     {
@@ -1785,6 +1893,12 @@ ReorderBufferAbort(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn)
     /* cosmetic... */
     txn->final_lsn = lsn;
 
+#ifdef __SUBSCRIPTION__
+    /* the receiver has to throw away what it got of it */
+    if (ReorderBufferTXNStreamed(txn))
+        rb->stream_abort(rb, txn, lsn);
+#endif
+
     /* remove potential on-disk data, and deallocate */
     ReorderBufferCleanupTXN(rb, txn);
 }
@@ -1818,6 +1932,11 @@ ReorderBufferAbortOld(ReorderBuffer *rb, TransactionId oldestRunningXid)
         {
             elog(DEBUG2, "aborting old transaction %u", txn->xid);
 
+#ifdef __SUBSCRIPTION__
+            if (txn->streamed)
+                rb->stream_abort(rb, txn, InvalidXLogRecPtr);
+#endif
+
             /* remove potential on-disk data, and deallocate this tx */
             ReorderBufferCleanupTXN(rb, txn);
         }
@@ -1854,6 +1973,12 @@ ReorderBufferForget(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn)
     /* cosmetic... */
     txn->final_lsn = lsn;
 
+#ifdef __SUBSCRIPTION__
+    /* parts of it may have been streamed, those must not be applied */
+    if (ReorderBufferTXNStreamed(txn))
+        rb->stream_abort(rb, txn, lsn);
+#endif
+
     /*
      * Process cache invalidation messages if there are any. Even if we're not
      * interested in the transaction's contents, it could have manipulated the
@@ -1952,6 +2077,11 @@ ReorderBufferSetBaseSnapshot(ReorderBuffer *rb, TransactionId xid,
     bool        is_new;
 
     txn = ReorderBufferTXNByXid(rb, xid, true, &is_new, lsn, true);
+#ifdef __SUBSCRIPTION__
+    /* known subtransactions are decoded with the snapshot of the toplevel */
+    if (txn->toptxn != NULL)
+        txn = txn->toptxn;
+#endif
     Assert(txn->base_snapshot == NULL);
     Assert(snap != NULL);
 
@@ -2089,11 +2219,12 @@ ReorderBufferXidHasBaseSnapshot(ReorderBuffer *rb, TransactionId xid)
     if (txn == NULL)
         return false;
 
-    /*
-     * TODO: It would be a nice improvement if we would check the toplevel
-     * transaction in subtransactions, but we'd need to keep track of a bit
-     * more state.
-     */
+#ifdef __SUBSCRIPTION__
+    /* see ReorderBufferSetBaseSnapshot */
+    if (txn->toptxn != NULL)
+        txn = txn->toptxn;
+#endif
+
     return txn->base_snapshot != NULL;
 }
 
@@ -2134,11 +2265,119 @@ ReorderBufferCheckSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
      */
     if (txn->nentries_mem >= max_changes_in_memory)
     {
+#ifdef __SUBSCRIPTION__
+        ReorderBufferTXN *toptxn = txn->toptxn != NULL ? txn->toptxn : txn;
+
+        /*
+         * Instead of spilling to disk, send the changes right away if the
+         * output plugin takes in-progress transactions.
+         */
+        if (ReorderBufferCanStream(rb, toptxn))
+        {
+            ReorderBufferChange *last;
+            MemoryContext oldcontext = CurrentMemoryContext;
+
+            /*
+             * A speculative insertion has to go out together with its
+             * confirmation, so wait for the next change.
+             */
+            last = dlist_tail_element(ReorderBufferChange, node, &txn->changes);
+            if (last->action == REORDER_BUFFER_CHANGE_INTERNAL_SPEC_INSERT)
+                return;
+
+            ReorderBufferProcessTXN(rb, toptxn, InvalidXLogRecPtr, true);
+            MemoryContextSwitchTo(oldcontext);
+            return;
+        }
+#endif
         ReorderBufferSerializeTXN(rb, txn);
         Assert(txn->nentries_mem == 0);
     }
 }
 
+#ifdef __SUBSCRIPTION__
+/*
+ * Can the changes of a toplevel transaction be streamed before its commit?
+ *
+ * The output plugin has to ask for it, and the changes have to be decodable
+ * with what we know now.  Transactions touching the catalog are left for the
+ * commit, as their invalidations only arrive with the commit record; and so
+ * are transactions that were spilled to disk already.
+ */
+static bool
+ReorderBufferCanStream(ReorderBuffer *rb, ReorderBufferTXN *txn)
+{
+    LogicalDecodingContext *ctx = rb->private_data;
+    dlist_iter    iter;
+
+    if (ctx == NULL || !ctx->streaming)
+        return false;
+
+    if (SnapBuildCurrentState(ctx->snapshot_builder) != SNAPBUILD_CONSISTENT ||
+        SnapBuildXactNeedsSkip(ctx->snapshot_builder, ctx->reader->EndRecPtr))
+        return false;
+
+    /* an unknown subtransaction can't be told apart from a toplevel one */
+    if (txn->is_known_as_subxact || txn->base_snapshot == NULL)
+        return false;
+
+    if (txn->has_catalog_changes || txn->serialized)
+        return false;
+
+    dlist_foreach(iter, &txn->subtxns)
+    {
+        ReorderBufferTXN *subtxn;
+
+        subtxn = dlist_container(ReorderBufferTXN, node, iter.cur);
+
+        if (subtxn->has_catalog_changes || subtxn->serialized ||
+            subtxn->base_snapshot != NULL)
+            return false;
+    }
+
+    return true;
+}
+
+/*
+ * Drop the changes of a streamed transaction and its subtransactions from
+ * the buffer.  The transactions themselves stay around until commit or
+ * abort.
+ */
+static void
+ReorderBufferTruncateTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+{
+    dlist_iter    subtxn_i;
+    dlist_mutable_iter change_i;
+
+    dlist_foreach(subtxn_i, &txn->subtxns)
+    {
+        ReorderBufferTXN *subtxn;
+
+        subtxn = dlist_container(ReorderBufferTXN, node, subtxn_i.cur);
+        ReorderBufferTruncateTXN(rb, subtxn);
+    }
+
+    dlist_foreach_modify(change_i, &txn->changes)
+    {
+        ReorderBufferChange *change;
+
+        change = dlist_container(ReorderBufferChange, node, change_i.cur);
+        dlist_delete(&change->node);
+        ReorderBufferReturnChange(rb, change);
+    }
+
+    txn->nentries = 0;
+    txn->nentries_mem = 0;
+
+    /* rebuilt from the tuplecids on the next run */
+    if (txn->tuplecid_hash != NULL)
+    {
+        hash_destroy(txn->tuplecid_hash);
+        txn->tuplecid_hash = NULL;
+    }
+}
+#endif
+
 /*
  * Spill data of a large transaction (and its subtransactions) to disk.
  */
@@ -2650,6 +2889,9 @@ ReorderBufferRestoreChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
             break;
     }
 
+#ifdef __SUBSCRIPTION__
+    change->txn = txn;
+#endif
     dlist_push_tail(&txn->changes, &change->node);
     txn->nentries_mem++;
 }
@@ -88,6 +88,7 @@
 #include "miscadmin.h"
 #include "pgstat.h"
 
+#include "access/transam.h"
 #include "access/xact.h"
 
 #include "catalog/pg_subscription_rel.h"
@@ -95,19 +96,25 @@
 
 #include "commands/copy.h"
 
+#include "nodes/makefuncs.h"
+
 #include "parser/parse_relation.h"
 
 #include "replication/logicallauncher.h"
 #include "replication/logicalrelation.h"
+#include "replication/logicalworker.h"
 #include "replication/walreceiver.h"
 #include "replication/worker_internal.h"
 
 #include "utils/snapmgr.h"
+#include "storage/dsm.h"
 #include "storage/ipc.h"
+#include "storage/shm_mq.h"
 
 #include "utils/builtins.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/syscache.h"
 #ifdef __STORAGE_SCALABLE__
 #include "replication/logicalrelation.h"
 #include "replication/logical_statistic.h"
@@ -117,6 +124,52 @@ static bool table_states_valid = false;
 
 StringInfo    copybuf = NULL;
 
+#ifdef __SUBSCRIPTION__
+/* Number of streams the copy of a sharded table is split into. */
+int logical_sync_streams_per_table = 1;
+
+/* Size of the queue each helper of a parallel table copy sends rows through. */
+#define SYNC_STREAM_QUEUE_SIZE    (256 * 1024)
+
+/*
+ * Head of the segment shared by the streams of a parallel table copy, the
+ * queues of the helpers follow it.  Stream i copies the shards from
+ * shards[i * nshards / nstreams] up to before shards[(i + 1) * nshards /
+ * nstreams], under the snapshot exported by the sync worker.
+ */
+typedef struct SyncStreamShared
+{
+    char        nspname[NAMEDATALEN];
+    char        relname[NAMEDATALEN];
+    char        snapshot[NAMEDATALEN];
+    int            nstreams;
+    int            nshards;
+    int            shards[MAX_SHARDS];
+} SyncStreamShared;
+
+#define SYNC_STREAM_QUEUE(shared, stream) \
+    ((shm_mq *) ((char *) (shared) + MAXALIGN(sizeof(SyncStreamShared)) + \
+                 (Size) ((stream) - 1) * SYNC_STREAM_QUEUE_SIZE))
+
+/*
+ * State of the sync worker while it reads the rows of all streams.  Rows are
+ * taken from one stream at a time, so it only moves on to another stream at
+ * the end of a row.
+ */
+typedef struct SyncStreamState
+{
+    dsm_segment *seg;
+    int            nstreams;
+    shm_mq_handle **mqh;        /* queue of each helper */
+    bool       *done;            /* stream sent all its rows */
+    int            nactive;        /* streams not done yet */
+    int            current;        /* stream the last data came from */
+    bool        in_row;            /* current stream stopped inside a row */
+} SyncStreamState;
+
+static SyncStreamState *sync_streams = NULL;
+#endif
+
 /*
  * Exit routine for synchronization worker.
  */
@@ -906,6 +959,434 @@ fetch_remote_table_info(char *nspname, char *relname,
     pfree(cmd.data);
 }
 
+#ifdef __SUBSCRIPTION__
+/*
+ * Whether the initial copy of a table can use the binary COPY format.  Every
+ * column must be of the same built-in type on both sides, the same rule as
+ * for binary column values during apply.
+ */
+static bool
+copy_table_binary(LogicalRepRelMapEntry *rel)
+{
+    TupleDesc    desc = RelationGetDescr(rel->localrel);
+    int            i;
+
+    if (!logical_apply_binary)
+        return false;
+
+    for (i = 0; i < desc->natts; i++)
+    {
+        Form_pg_attribute att = desc->attrs[i];
+        int            remoteattnum = rel->attrmap[i];
+        HeapTuple    typtup;
+        Form_pg_type typclass;
+        bool        binary;
+
+        if (att->attisdropped || remoteattnum < 0)
+            continue;
+
+        if (rel->remoterel.atttyps[remoteattnum] != att->atttypid ||
+            att->atttypid >= FirstNormalObjectId)
+            return false;
+
+        typtup = SearchSysCache1(TYPEOID, ObjectIdGetDatum(att->atttypid));
+        if (!HeapTupleIsValid(typtup))
+            elog(ERROR, "cache lookup failed for type %u", att->atttypid);
+        typclass = (Form_pg_type) GETSTRUCT(typtup);
+        binary = OidIsValid(typclass->typsend) &&
+            OidIsValid(typclass->typreceive);
+        ReleaseSysCache(typtup);
+
+        if (!binary)
+            return false;
+    }
+
+    return true;
+}
+
+/*
+ * Whether the publisher distributes the table by shard.
+ */
+static bool
+fetch_remote_table_sharded(LogicalRepRelation *lrel)
+{
+    WalRcvExecResult *res;
+    StringInfoData cmd;
+    TupleTableSlot *slot;
+    Oid            shardRow[1] = {INT4OID};
+    bool        sharded;
+
+    initStringInfo(&cmd);
+    appendStringInfo(&cmd, "SELECT 1"
+                     "  FROM pg_catalog.pgxc_class"
+                     " WHERE pcrelid = %u"
+                     "   AND pclocatortype = '%c'",
+                     lrel->remoteid, LOCATOR_TYPE_SHARD);
+    res = walrcv_exec(wrconn, cmd.data, 1, shardRow);
+
+    if (res->status != WALRCV_OK_TUPLES)
+        ereport(ERROR,
+                (errmsg("could not fetch distribution of table \"%s.%s\" from publisher: %s",
+                        lrel->nspname, lrel->relname, res->err)));
+
+    slot = MakeSingleTupleTableSlot(res->tupledesc);
+    sharded = tuplestore_gettupleslot(res->tuplestore, true, false, slot);
+    ExecDropSingleTupleTableSlot(slot);
+
+    walrcv_clear_result(res);
+    pfree(cmd.data);
+
+    return sharded;
+}
+
+/*
+ * Shards copied by stream of nstreams, from shards[*begin] up to before
+ * shards[*end].
+ */
+static void
+sync_stream_range(int nshards, int nstreams, int stream, int *begin, int *end)
+{
+    *begin = (int) ((int64) nshards * stream / nstreams);
+    *end = (int) ((int64) nshards * (stream + 1) / nstreams);
+}
+
+/*
+ * Account the rows of a piece of COPY data to the stream of this worker.
+ * Text format rows end with a newline, which is escaped inside values.
+ */
+static void
+sync_stream_count_rows(const char *buf, int len)
+{
+    const char *end = buf + len;
+    uint64        nrows = 0;
+
+    while ((buf = memchr(buf, '\n', end - buf)) != NULL)
+    {
+        nrows++;
+        buf++;
+    }
+
+    if (nrows > 0)
+    {
+        SpinLockAcquire(&MyLogicalRepWorker->relmutex);
+        MyLogicalRepWorker->sync_ntuples += nrows;
+        SpinLockRelease(&MyLogicalRepWorker->relmutex);
+    }
+}
+
+/*
+ * Split the copy of a sharded table into logical_sync_streams_per_table
+ * streams by range of shards, and start a helper worker for each but the
+ * first one.  The helpers copy under a snapshot exported from our remote
+ * transaction and send their rows to us, so the rows are still written by us
+ * only and the table sync keeps a single transaction and catch-up point.
+ *
+ * Returns the shards we copy ourselves: those of the first stream plus those
+ * of any stream whose helper could not be started.  If the table can't be
+ * split, shards is returned unchanged.
+ */
+static List *
+copy_table_start_streams(LogicalRepRelation *lrel, List *shards)
+{// #lizard forgives
+    SyncStreamShared *shared;
+    dsm_segment *seg;
+    WalRcvExecResult *res;
+    TupleTableSlot *slot;
+    Oid            snapshotRow[1] = {TEXTOID};
+    List       *myshards = NIL;
+    ListCell   *cell;
+    char       *snapshot;
+    bool        isnull;
+    int            nstreams = logical_sync_streams_per_table;
+    int            nshards;
+    int            nstarted = 0;
+    int            begin;
+    int            end;
+    int            i;
+    int            j;
+
+    /* Only a sharded table can be split. */
+    if (shards == NIL)
+    {
+        if (!fetch_remote_table_sharded(lrel))
+            return shards;
+
+        for (i = 0; i < MAX_SHARDS; i++)
+            shards = lappend_int(shards, i);
+    }
+
+    nshards = list_length(shards);
+    if (nstreams > nshards)
+        nstreams = nshards;
+    if (nstreams <= 1)
+        return shards;
+
+    /* Every stream has to see the same rows as our copy. */
+    res = walrcv_exec(wrconn, "SELECT pg_catalog.pg_export_snapshot()",
+                      1, snapshotRow);
+    if (res->status != WALRCV_OK_TUPLES)
+        ereport(ERROR,
+                (errmsg("could not export snapshot of table copy on publisher: %s",
+                        res->err)));
+
+    slot = MakeSingleTupleTableSlot(res->tupledesc);
+    if (!tuplestore_gettupleslot(res->tuplestore, true, false, slot))
+        ereport(ERROR,
+                (errmsg("could not export snapshot of table copy on publisher")));
+    snapshot = TextDatumGetCString(slot_getattr(slot, 1, &isnull));
+    Assert(!isnull);
+    ExecDropSingleTupleTableSlot(slot);
+    walrcv_clear_result(res);
+
+    seg = dsm_create(MAXALIGN(sizeof(SyncStreamShared)) +
+                     (Size) (nstreams - 1) * SYNC_STREAM_QUEUE_SIZE, 0);
+    shared = (SyncStreamShared *) dsm_segment_address(seg);
+    strlcpy(shared->nspname, lrel->nspname, NAMEDATALEN);
+    strlcpy(shared->relname, lrel->relname, NAMEDATALEN);
+    strlcpy(shared->snapshot, snapshot, NAMEDATALEN);
+    shared->nstreams = nstreams;
+    shared->nshards = nshards;
+    i = 0;
+    foreach(cell, shards)
+        shared->shards[i++] = lfirst_int(cell);
+
+    sync_streams = (SyncStreamState *) palloc0(sizeof(SyncStreamState));
+    sync_streams->seg = seg;
+    sync_streams->nstreams = nstreams;
+    sync_streams->mqh = (shm_mq_handle **) palloc0(nstreams * sizeof(shm_mq_handle *));
+    sync_streams->done = (bool *) palloc0(nstreams * sizeof(bool));
+    sync_streams->nactive = 1;
+
+    sync_stream_range(nshards, nstreams, 0, &begin, &end);
+    for (j = begin; j < end; j++)
+        myshards = lappend_int(myshards, shared->shards[j]);
+
+    for (i = 1; i < nstreams; i++)
+    {
+        BackgroundWorkerHandle *handle;
+        shm_mq       *mq;
+
+        mq = shm_mq_create(SYNC_STREAM_QUEUE(shared, i), SYNC_STREAM_QUEUE_SIZE);
+        shm_mq_set_receiver(mq, MyProc);
+
+        handle = logicalrep_sync_stream_launch(MyLogicalRepWorker->dbid,
+                                               MySubscription->oid,
+                                               MySubscription->name,
+                                               MyLogicalRepWorker->userid,
+                                               MyLogicalRepWorker->relid,
+                                               i, nstreams,
+                                               dsm_segment_handle(seg));
+        if (handle == NULL)
+        {
+            /* No worker left for this stream, copy its shards ourselves. */
+            sync_stream_range(nshards, nstreams, i, &begin, &end);
+            for (j = begin; j < end; j++)
+                myshards = lappend_int(myshards, shared->shards[j]);
+            sync_streams->done[i] = true;
+            continue;
+        }
+
+        sync_streams->mqh[i] = shm_mq_attach(mq, seg, handle);
+        sync_streams->nactive++;
+        nstarted++;
+    }
+
+    SpinLockAcquire(&MyLogicalRepWorker->relmutex);
+    MyLogicalRepWorker->sync_nstreams = nstreams;
+    MyLogicalRepWorker->sync_first_shard = linitial_int(myshards);
+    MyLogicalRepWorker->sync_last_shard = llast_int(myshards);
+    MyLogicalRepWorker->sync_ntuples = 0;
+    SpinLockRelease(&MyLogicalRepWorker->relmutex);
+
+    elog(DEBUG1, "copy of table \"%s.%s\" split into %d streams, %d of them by helper workers",
+         lrel->nspname, lrel->relname, nstreams, nstarted);
+
+    return myshards;
+}
+
+/*
+ * Done with the streams of a parallel table copy, all of them sent their
+ * rows.
+ */
+static void
+copy_table_end_streams(void)
+{
+    Assert(sync_streams->nactive == 0);
+
+    dsm_detach(sync_streams->seg);
+
+    pfree(sync_streams->mqh);
+    pfree(sync_streams->done);
+    pfree(sync_streams);
+    sync_streams = NULL;
+
+    SpinLockAcquire(&MyLogicalRepWorker->relmutex);
+    MyLogicalRepWorker->sync_nstreams = 0;
+    MyLogicalRepWorker->sync_first_shard = -1;
+    MyLogicalRepWorker->sync_last_shard = -1;
+    SpinLockRelease(&MyLogicalRepWorker->relmutex);
+}
+
+/*
+ * Try to get the next piece of COPY data of a stream without waiting.
+ * Returns its length, or 0 if there is none now or the stream is finished;
+ * *fd is set to the socket to wait on for our own stream.
+ */
+static int
+sync_stream_receive(int stream, char **buffer, pgsocket *fd)
+{
+    shm_mq_result res;
+    Size        nbytes;
+    void       *data;
+    int            len;
+
+    if (stream == 0)
+    {
+        len = walrcv_receive(wrconn, buffer, fd);
+        if (len > 0)
+        {
+            sync_stream_count_rows(*buffer, len);
+            return len;
+        }
+        if (len < 0)
+        {
+            sync_streams->done[0] = true;
+            sync_streams->nactive--;
+        }
+        return 0;
+    }
+
+    res = shm_mq_receive(sync_streams->mqh[stream], &nbytes, &data, true);
+    if (res == SHM_MQ_WOULD_BLOCK)
+        return 0;
+    if (res == SHM_MQ_DETACHED)
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("stream %d of the table copy terminated before sending all its rows",
+                        stream)));
+
+    /* A zero-length message ends the stream. */
+    if (nbytes == 0)
+    {
+        sync_streams->done[stream] = true;
+        sync_streams->nactive--;
+        return 0;
+    }
+
+    *buffer = (char *) data;
+    return (int) nbytes;
+}
+
+/*
+ * Data source callback for the COPY FROM of a parallel table copy, which
+ * reads from our own remote connection and from the queues of the helpers,
+ * switching between them only at the end of a row.
+ */
+static int
+copy_read_streams(void *outbuf, int minread, int maxread)
+{// #lizard forgives
+    int            bytesread = 0;
+    int            avail;
+
+    /* If there are some leftover data from previous read, use it. */
+    avail = copybuf->len - copybuf->cursor;
+    if (avail)
+    {
+        if (avail > maxread)
+            avail = maxread;
+        memcpy(outbuf, &copybuf->data[copybuf->cursor], avail);
+        outbuf = (void *) ((char *) outbuf + avail);
+        copybuf->cursor += avail;
+        maxread -= avail;
+        bytesread += avail;
+    }
+
+    while (maxread > 0 && bytesread < minread)
+    {
+        pgsocket    fd = PGINVALID_SOCKET;
+        char       *buf = NULL;
+        int            len = 0;
+        int            events;
+        int            rc;
+        int            i;
+
+        if (sync_streams->nactive == 0)
+            return bytesread;
+
+        for (i = 1; i <= sync_streams->nstreams; i++)
+        {
+            int            stream;
+
+            /* Stay on a stream that stopped inside a row. */
+            if (sync_streams->in_row)
+                stream = sync_streams->current;
+            else
+                stream = (sync_streams->current + i) % sync_streams->nstreams;
+
+            if (!sync_streams->done[stream])
+                len = sync_stream_receive(stream, &buf, &fd);
+
+            if (len > 0)
+            {
+                sync_streams->current = stream;
+                sync_streams->in_row = (buf[len - 1] != '\n');
+                break;
+            }
+
+            if (sync_streams->in_row)
+            {
+                if (sync_streams->done[stream])
+                    ereport(ERROR,
+                            (errcode(ERRCODE_PROTOCOL_VIOLATION),
+                             errmsg("stream %d of the table copy ended inside a row",
+                                    stream)));
+                break;
+            }
+        }
+
+        CHECK_FOR_INTERRUPTS();
+
+        if (len > 0)
+        {
+            copybuf->data = buf;
+            copybuf->len = len;
+            copybuf->cursor = 0;
+
+            avail = len;
+            if (avail > maxread)
+                avail = maxread;
+            memcpy(outbuf, copybuf->data, avail);
+            outbuf = (void *) ((char *) outbuf + avail);
+            copybuf->cursor += avail;
+            maxread -= avail;
+            bytesread += avail;
+            continue;
+        }
+
+        if (sync_streams->nactive == 0)
+            return bytesread;
+
+        /*
+         * Wait for more data or latch, the helpers set it when they put
+         * data into their queues.
+         */
+        events = WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH;
+        if (fd != PGINVALID_SOCKET)
+            events |= WL_SOCKET_READABLE;
+        rc = WaitLatchOrSocket(MyLatch, events, fd, 1000L,
+                               WAIT_EVENT_LOGICAL_SYNC_DATA);
+
+        /* Emergency bailout if postmaster has died */
+        if (rc & WL_POSTMASTER_DEATH)
+            proc_exit(1);
+
+        ResetLatch(MyLatch);
+    }
+
+    return bytesread;
+}
+#endif
+
 /*
  * Copy existing data of a table from publisher.
  *
@@ -925,6 +1406,7 @@ copy_table(Relation rel)
     StringInfoData cmd;
     CopyState    cstate;
     List       *attnamelist;
+    List       *options = NIL;
     ParseState *pstate;
 #ifdef __STORAGE_SCALABLE__
     uint64 nCopyIn = 0;
@@ -940,6 +1422,12 @@ copy_table(Relation rel)
     relmapentry = logicalrep_rel_open(lrel.remoteid, NoLock);
     Assert(rel == relmapentry->localrel);
 
+#ifdef __SUBSCRIPTION__
+    /* Let helper workers copy ranges of shards next to us. */
+    if (logical_sync_streams_per_table > 1)
+        shards = copy_table_start_streams(&lrel, shards);
+#endif
+
     /* Start copy on the publisher. */
     initStringInfo(&cmd);
 #ifdef __STORAGE_SCALABLE__
@@ -974,6 +1462,15 @@ copy_table(Relation rel)
                      quote_qualified_identifier(lrel.nspname, lrel.relname));
 #ifdef __STORAGE_SCALABLE__
     }
+#endif
+#ifdef __SUBSCRIPTION__
+    /* The rows of parallel streams are merged at text line boundaries. */
+    if (sync_streams == NULL && copy_table_binary(relmapentry))
+    {
+        appendStringInfoString(&cmd, " WITH (FORMAT binary)");
+        options = list_make1(makeDefElem("format",
+                                         (Node *) makeString("binary"), -1));
+    }
 #endif
     res = walrcv_exec(wrconn, cmd.data, 0, NULL);
     pfree(cmd.data);
@@ -989,7 +1486,13 @@ copy_table(Relation rel)
     addRangeTableEntryForRelation(pstate, rel, NULL, false, false);
 
     attnamelist = make_copy_attnamelist(relmapentry);
-    cstate = BeginCopyFrom(pstate, rel, NULL, false, copy_read_data, attnamelist, NIL);
+#ifdef __SUBSCRIPTION__
+    if (sync_streams != NULL)
+        cstate = BeginCopyFrom(pstate, rel, NULL, false, copy_read_streams,
+                               attnamelist, options);
+    else
+#endif
+    cstate = BeginCopyFrom(pstate, rel, NULL, false, copy_read_data, attnamelist, options);
 
     /* Do the copy */
 #ifdef __STORAGE_SCALABLE__
@@ -1001,6 +1504,9 @@ copy_table(Relation rel)
 #ifdef __SUBSCRIPTION__
     if (IS_PGXC_COORDINATOR)
         EndCopyFrom(cstate);
+
+    if (sync_streams != NULL)
+        copy_table_end_streams();
 #endif
 
     logicalrep_rel_close(relmapentry, NoLock);
@@ -1275,3 +1781,153 @@ LogicalRepSyncTableStart(XLogRecPtr *origin_startpos)
 
     return slotname;
 }
+
+#ifdef __SUBSCRIPTION__
+/*
+ * Main of a helper of the sync worker, which copies one stream of a parallel
+ * table copy from the publisher and sends the rows to the sync worker.
+ */
+void
+LogicalRepSyncStreamMain(void)
+{// #lizard forgives
+    int            stream = MyLogicalRepWorker->sync_stream;
+    SyncStreamShared *shared;
+    dsm_segment *seg;
+    shm_mq       *mq;
+    shm_mq_handle *mqh;
+    WalRcvExecResult *res;
+    StringInfoData cmd;
+    char       *appname;
+    char       *err;
+    int            begin;
+    int            end;
+    int            i;
+
+    seg = dsm_attach(MyLogicalRepWorker->sync_dsm);
+    if (seg == NULL)
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("could not map dynamic shared memory segment of table copy")));
+    shared = (SyncStreamShared *) dsm_segment_address(seg);
+
+    mq = SYNC_STREAM_QUEUE(shared, stream);
+    shm_mq_set_sender(mq, MyProc);
+    mqh = shm_mq_attach(mq, seg, NULL);
+
+    sync_stream_range(shared->nshards, shared->nstreams, stream, &begin, &end);
+    Assert(begin < end);
+
+    SpinLockAcquire(&MyLogicalRepWorker->relmutex);
+    MyLogicalRepWorker->sync_first_shard = shared->shards[begin];
+    MyLogicalRepWorker->sync_last_shard = shared->shards[end - 1];
+    SpinLockRelease(&MyLogicalRepWorker->relmutex);
+
+    appname = psprintf("%.*s_%u_sync_%u_%d",
+                       NAMEDATALEN - 40,
+                       MySubscription->slotname,
+                       MySubscription->oid,
+                       MyLogicalRepWorker->relid,
+                       stream);
+    wrconn = walrcv_connect(MySubscription->conninfo, true, appname, &err);
+    if (wrconn == NULL)
+        ereport(ERROR,
+                (errmsg("could not connect to the publisher: %s", err)));
+
+    res = walrcv_exec(wrconn,
+                      "BEGIN READ ONLY ISOLATION LEVEL "
+                      "REPEATABLE READ", 0, NULL);
+    if (res->status != WALRCV_OK_COMMAND)
+        ereport(ERROR,
+                (errmsg("table copy could not start transaction on publisher"),
+                 errdetail("The error was: %s", res->err)));
+    walrcv_clear_result(res);
+
+    /* See the same rows as the sync worker. */
+    initStringInfo(&cmd);
+    appendStringInfo(&cmd, "SET TRANSACTION SNAPSHOT %s",
+                     quote_literal_cstr(shared->snapshot));
+    res = walrcv_exec(wrconn, cmd.data, 0, NULL);
+    if (res->status != WALRCV_OK_COMMAND)
+        ereport(ERROR,
+                (errmsg("table copy could not import snapshot on publisher"),
+                 errdetail("The error was: %s", res->err)));
+    walrcv_clear_result(res);
+
+    resetStringInfo(&cmd);
+    appendStringInfo(&cmd, "COPY %s sharding (",
+                     quote_qualified_identifier(shared->nspname, shared->relname));
+    for (i = begin; i < end; i++)
+    {
+        if (i > begin)
+            appendStringInfoChar(&cmd, ',');
+        appendStringInfo(&cmd, "%d", shared->shards[i]);
+    }
+    appendStringInfoString(&cmd, ") TO STDOUT");
+
+    res = walrcv_exec(wrconn, cmd.data, 0, NULL);
+    if (res->status != WALRCV_OK_COPY_OUT)
+        ereport(ERROR,
+                (errmsg("could not start initial contents copy for table \"%s.%s\": %s",
+                        shared->nspname, shared->relname, res->err)));
+    walrcv_clear_result(res);
+    pfree(cmd.data);
+
+    for (;;)
+    {
+        pgsocket    fd = PGINVALID_SOCKET;
+        char       *buf = NULL;
+        int            len;
+        int            rc;
+
+        len = walrcv_receive(wrconn, &buf, &fd);
+
+        CHECK_FOR_INTERRUPTS();
+
+        if (len > 0)
+        {
+            if (shm_mq_send(mqh, len, buf, false) != SHM_MQ_SUCCESS)
+                ereport(ERROR,
+                        (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                         errmsg("table synchronization worker stopped reading stream %d",
+                                stream)));
+            sync_stream_count_rows(buf, len);
+            continue;
+        }
+        else if (len < 0)
+            break;
+
+        /*
+         * Wait for more data or latch.
+         */
+        rc = WaitLatchOrSocket(MyLatch,
+                               WL_SOCKET_READABLE | WL_LATCH_SET |
+                               WL_TIMEOUT | WL_POSTMASTER_DEATH,
+                               fd, 1000L, WAIT_EVENT_LOGICAL_SYNC_DATA);
+
+        /* Emergency bailout if postmaster has died */
+        if (rc & WL_POSTMASTER_DEATH)
+            proc_exit(1);
+
+        ResetLatch(MyLatch);
+    }
+
+    /* Tell the sync worker that all rows of the stream were sent. */
+    if (shm_mq_send(mqh, 0, NULL, false) != SHM_MQ_SUCCESS)
+        ereport(ERROR,
+                (errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+                 errmsg("table synchronization worker stopped reading stream %d",
+                        stream)));
+
+    res = walrcv_exec(wrconn, "COMMIT", 0, NULL);
+    if (res->status != WALRCV_OK_COMMAND)
+        ereport(ERROR,
+                (errmsg("table copy could not finish transaction on publisher"),
+                 errdetail("The error was: %s", res->err)));
+    walrcv_clear_result(res);
+
+    elog(DEBUG1, "stream %d of the copy of table \"%s.%s\" has finished",
+         stream, shared->nspname, shared->relname);
+
+    dsm_detach(seg);
+}
+#endif
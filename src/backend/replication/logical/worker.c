@@ -67,6 +67,7 @@
 
 #include "rewrite/rewriteHandler.h"
 
+#include "storage/buffile.h"
 #include "storage/bufmgr.h"
 #include "storage/ipc.h"
 #include "storage/lmgr.h"
@@ -352,13 +353,65 @@ slot_store_error_callback(void *arg)
 }
 
 /*
- * Store data in C string form into slot.
+ * Convert a remote column value to a datum of the local column type, by the
+ * type's input function, or by its receive function if the publisher sent
+ * the value in binary.
+ */
+static Datum
+slot_column_datum(LogicalRepRelMapEntry *rel, LogicalRepTupleData *tuple,
+                  int remoteattnum, Form_pg_attribute att)
+{
+    Oid            typfunc;
+    Oid            typioparam;
+
+#ifdef __SUBSCRIPTION__
+    if (tuple->formats[remoteattnum] == LOGICALREP_COLUMN_BINARY)
+    {
+        Oid            remotetypoid = rel->remoterel.atttyps[remoteattnum];
+        StringInfoData buf;
+        Datum        value;
+
+        /* only built-in types are sent in binary, their OIDs match ours */
+        if (remotetypoid != att->atttypid)
+            ereport(ERROR,
+                    (errcode(ERRCODE_DATATYPE_MISMATCH),
+                     errmsg("binary data of type %s cannot be applied to a column of type %s",
+                            format_type_be(remotetypoid),
+                            format_type_be(att->atttypid)),
+                     errhint("Set logical_apply_binary to off to receive the data in text format.")));
+
+        buf.data = tuple->values[remoteattnum];
+        buf.len = tuple->lengths[remoteattnum];
+        buf.maxlen = buf.len + 1;
+        buf.cursor = 0;
+
+        getTypeBinaryInputInfo(att->atttypid, &typfunc, &typioparam);
+        value = OidReceiveFunctionCall(typfunc, &buf, typioparam,
+                                       att->atttypmod);
+
+        if (buf.cursor != buf.len)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                     errmsg("incorrect binary data format in logical replication column %d",
+                            remoteattnum + 1)));
+
+        return value;
+    }
+#endif
+
+    getTypeInputInfo(att->atttypid, &typfunc, &typioparam);
+    return OidInputFunctionCall(typfunc, tuple->values[remoteattnum],
+                                typioparam, att->atttypmod);
+}
+
+/*
+ * Store data received from the publisher into slot.
  * This is similar to BuildTupleFromCStrings but TupleTableSlot fits our
  * use better.
  */
 static void
 slot_store_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
-                    char **values)
+                    LogicalRepTupleData *tuple)
 {
     int            natts = slot->tts_tupleDescriptor->natts;
     int            i;
@@ -382,18 +435,12 @@ slot_store_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
         int            remoteattnum = rel->attrmap[i];
 
         if (!att->attisdropped && remoteattnum >= 0 &&
-            values[remoteattnum] != NULL)
+            tuple->values[remoteattnum] != NULL)
         {
-            Oid            typinput;
-            Oid            typioparam;
-
             errarg.attnum = remoteattnum;
 
-            getTypeInputInfo(att->atttypid, &typinput, &typioparam);
-            slot->tts_values[i] = OidInputFunctionCall(typinput,
-                                                       values[remoteattnum],
-                                                       typioparam,
-                                                       att->atttypmod);
+            slot->tts_values[i] = slot_column_datum(rel, tuple, remoteattnum,
+                                                    att);
             slot->tts_isnull[i] = false;
         }
         else
@@ -415,14 +462,14 @@ slot_store_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
 }
 
 /*
- * Modify slot with user data provided as C strings.
+ * Modify slot with the changed columns of data received from the publisher.
  * This is somewhat similar to heap_modify_tuple but also calls the type
- * input function on the user data as the input is the text representation
- * of the types.
+ * input or receive function on the user data as the input is the text or
+ * binary representation of the types.
  */
 static void
 slot_modify_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
-                     char **values, bool *replaces)
+                     LogicalRepTupleData *tuple)
 {
     int            natts = slot->tts_tupleDescriptor->natts;
     int            i;
@@ -446,21 +493,15 @@ slot_modify_cstrings(TupleTableSlot *slot, LogicalRepRelMapEntry *rel,
         Form_pg_attribute att = slot->tts_tupleDescriptor->attrs[i];
         int            remoteattnum = rel->attrmap[i];
 
-        if (remoteattnum >= 0 && !replaces[remoteattnum])
+        if (remoteattnum >= 0 && !tuple->changed[remoteattnum])
             continue;
 
-        if (remoteattnum >= 0 && values[remoteattnum] != NULL)
+        if (remoteattnum >= 0 && tuple->values[remoteattnum] != NULL)
         {
-            Oid            typinput;
-            Oid            typioparam;
-
             errarg.attnum = remoteattnum;
 
-            getTypeInputInfo(att->atttypid, &typinput, &typioparam);
-            slot->tts_values[i] = OidInputFunctionCall(typinput,
-                                                       values[remoteattnum],
-                                                       typioparam,
-                                                       att->atttypmod);
+            slot->tts_values[i] = slot_column_datum(rel, tuple, remoteattnum,
+                                                    att);
             slot->tts_isnull[i] = false;
         }
         else
@@ -510,14 +551,7 @@ apply_get_exec_nodes(LogicalRepRelMapEntry * rel,
         if (!att->attisdropped && remoteattnum >= 0 &&
             tuple->values[remoteattnum] != NULL)
         {
-            Oid    typinput = InvalidOid;
-            Oid    typioparam = InvalidOid;
-
-            getTypeInputInfo(att->atttypid, &typinput, &typioparam);
-            valueForDistCol = OidInputFunctionCall(typinput,
-                                                    tuple->values[remoteattnum],
-                                                    typioparam,
-                                                    att->atttypmod);
+            valueForDistCol = slot_column_datum(rel, tuple, remoteattnum, att);
             isValueNull = false;
         }
         else
@@ -535,14 +569,7 @@ apply_get_exec_nodes(LogicalRepRelMapEntry * rel,
         if (!att->attisdropped && remoteattnum >= 0 &&
             tuple->values[remoteattnum] != NULL)
         {
-            Oid    typinput = InvalidOid;
-            Oid    typioparam = InvalidOid;
-
-            getTypeInputInfo(att->atttypid, &typinput, &typioparam);
-            valueForSecDistCol = OidInputFunctionCall(typinput,
-                                                    tuple->values[remoteattnum],
-                                                    typioparam,
-                                                    att->atttypmod);
+            valueForSecDistCol = slot_column_datum(rel, tuple, remoteattnum, att);
             isSecValueNull = false;
         }
         else
@@ -557,6 +584,268 @@ apply_get_exec_nodes(LogicalRepRelMapEntry * rel,
     return exec_nodes;
 }
 
+/*
+ * check the result of one apply message, unique violations are only logged
+ * if the subscription ignores primary key conflicts.
+ */
+static void
+apply_check_result(ResponseCombiner *combiner, int result, bool ignore_pk_conflict,
+                   char *nspname, char *relname)
+{// #lizard forgives
+    if (result)
+    {
+        if (combiner->errorMessage)
+        {
+            pgxc_node_report_error(combiner);
+        }
+        else
+        {
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("Failed to APPLY the insert or update or delete or relation message on datanodes")));
+        }
+    }
+    else if (ignore_pk_conflict &&
+                combiner->errorMessage &&
+                MAKE_SQLSTATE(combiner->errorCode[0], combiner->errorCode[1],
+                              combiner->errorCode[2], combiner->errorCode[3],
+                              combiner->errorCode[4]) == ERRCODE_UNIQUE_VIOLATION)
+    {
+        if (combiner->errorDetail && combiner->errorHint)
+        {
+			elog(LOG, "logical apply found that %s, %s, %s",
+                        combiner->errorMessage,
+                        combiner->errorDetail,
+                        combiner->errorHint);
+        }
+        else if (combiner->errorDetail)
+        {
+            elog(LOG, "logical apply found that %s, %s",
+                        combiner->errorMessage,
+                        combiner->errorDetail);
+        }
+        else
+        {
+            elog(LOG, "logical apply found that %s",
+                        combiner->errorMessage);
+        }
+    }
+    else if (!validate_combiner(combiner))
+    {
+        if (nspname && relname)
+            ereport(ERROR,
+                  (errcode(ERRCODE_INTERNAL_ERROR),
+                  errmsg("apply_exec_on_dn_nodes validate_combiner responese of APPLY failed: %s, on table %s.%s in database %s",
+                  combiner->errorMessage, nspname, relname, get_database_name(MyDatabaseId))));
+        else
+            ereport(ERROR,
+                  (errcode(ERRCODE_INTERNAL_ERROR),
+                  errmsg("apply_exec_on_dn_nodes validate_combiner responese of pipelined APPLY failed: %s, on datanode %s in database %s",
+                  combiner->errorMessage, combiner->errorNode ? combiner->errorNode : "unknown",
+                  get_database_name(MyDatabaseId))));
+    }
+}
+
+/*
+ * Pipelined apply on coordinator.
+ *
+ * With logical_apply_pipeline_depth > 0, changes are queued on the connection
+ * of the datanode owning their shard and sent in batches, without waiting
+ * for each result.  A datanode applies the messages of one connection in
+ * order, so results only need to be collected when a datanode has too many
+ * changes in flight, before the executor uses the connections synchronously
+ * (changes of tables that are not distributed by column), and before the
+ * transaction commits.  Nodes are remembered only until the results are
+ * collected, as handles may be released at the end of the transaction.
+ */
+typedef struct ApplyPipelineNode
+{
+    PGXCNodeHandle *handle;
+    int             inflight;        /* messages sent, result not read yet */
+} ApplyPipelineNode;
+
+/* flush the output buffer of a datanode once it holds this many bytes */
+#define APPLY_PIPELINE_FLUSH_SIZE    (64 * 1024)
+
+int logical_apply_pipeline_depth = 0;
+
+static ApplyPipelineNode *apply_pipeline_nodes = NULL;
+static int apply_pipeline_nnodes = 0;
+static int apply_pipeline_maxnodes = 0;
+
+static ApplyPipelineNode *
+apply_pipeline_get_node(PGXCNodeHandle *handle)
+{
+    int i;
+
+    for (i = 0; i < apply_pipeline_nnodes; i++)
+    {
+        if (apply_pipeline_nodes[i].handle == handle)
+        {
+            return &apply_pipeline_nodes[i];
+        }
+    }
+
+    if (apply_pipeline_nnodes >= apply_pipeline_maxnodes)
+    {
+        int newmax = (apply_pipeline_maxnodes == 0) ? 16 : apply_pipeline_maxnodes * 2;
+
+        if (apply_pipeline_nodes == NULL)
+            apply_pipeline_nodes = (ApplyPipelineNode *)
+                MemoryContextAlloc(TopMemoryContext, newmax * sizeof(ApplyPipelineNode));
+        else
+            apply_pipeline_nodes = (ApplyPipelineNode *)
+                repalloc(apply_pipeline_nodes, newmax * sizeof(ApplyPipelineNode));
+        apply_pipeline_maxnodes = newmax;
+    }
+
+    apply_pipeline_nodes[apply_pipeline_nnodes].handle = handle;
+    apply_pipeline_nodes[apply_pipeline_nnodes].inflight = 0;
+
+    return &apply_pipeline_nodes[apply_pipeline_nnodes++];
+}
+
+/*
+ * read the results of all messages in flight on one datanode
+ */
+static void
+apply_pipeline_wait_node(ApplyPipelineNode *node)
+{// #lizard forgives
+    PGXCNodeHandle *handle = node->handle;
+    bool ignore_pk_conflict = MySubscription->ignore_pk_conflict;
+
+    if (node->inflight > 0 && pgxc_node_flush(handle))
+    {
+        ereport(ERROR,
+            (errcode(ERRCODE_INTERNAL_ERROR),
+            errmsg("apply_exec_on_dn_nodes sending apply to datanode %s fails", handle->nodename)));
+    }
+
+    while (node->inflight > 0)
+    {
+        ResponseCombiner combiner;
+        int result = 0;
+
+        MemSet(&combiner, 0, sizeof(ResponseCombiner));
+        InitResponseCombiner(&combiner, 1, COMBINE_TYPE_NONE);
+
+        /* every message ends with ApplyDone, or ReadyForQuery after an error */
+        for (;;)
+        {
+            int res = handle_response(handle, &combiner);
+
+            if (res == RESPONSE_READY)
+            {
+                break;
+            }
+
+            if (res == RESPONSE_COMPLETE && handle->state == DN_CONNECTION_STATE_ERROR_FATAL)
+            {
+                result = EOF;
+                break;
+            }
+
+            if (res == RESPONSE_EOF)
+            {
+                /* the connection went idle after the previous result */
+                PGXCNodeSetConnectionState(handle, DN_CONNECTION_STATE_QUERY);
+                if (pgxc_node_receive(1, &handle, NULL))
+                {
+                    result = EOF;
+                    break;
+                }
+            }
+        }
+
+        node->inflight--;
+
+        apply_check_result(&combiner, result, ignore_pk_conflict, NULL, NULL);
+        CloseCombiner(&combiner);
+
+        if (result)
+        {
+            /* connection is broken, the remaining results are lost */
+            node->inflight = 0;
+        }
+    }
+}
+
+/*
+ * read the results of all messages in flight, and forget the datanodes
+ */
+static void
+apply_pipeline_wait_all(void)
+{
+    int i;
+
+    for (i = 0; i < apply_pipeline_nnodes; i++)
+    {
+        apply_pipeline_wait_node(&apply_pipeline_nodes[i]);
+    }
+
+    apply_pipeline_nnodes = 0;
+}
+
+/*
+ * push out the queued messages without waiting for their results
+ */
+static void
+apply_pipeline_flush(void)
+{
+    int i;
+
+    for (i = 0; i < apply_pipeline_nnodes; i++)
+    {
+        PGXCNodeHandle *handle = apply_pipeline_nodes[i].handle;
+
+        if (handle->outEnd > 0 && pgxc_node_flush(handle))
+        {
+            ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                errmsg("apply_exec_on_dn_nodes sending apply to datanode %s fails", handle->nodename)));
+        }
+    }
+}
+
+/*
+ * queue apply message to datanodes, results are collected later
+ */
+static void
+apply_pipeline_send(StringInfo s, PGXCNodeAllHandles *all_handles)
+{
+    int i = 0;
+    bool ignore_pk_conflict = MySubscription->ignore_pk_conflict;
+
+    for (i = 0; i < all_handles->dn_conn_count; i++)
+    {
+        PGXCNodeHandle *handle = all_handles->datanode_handles[i];
+        ApplyPipelineNode *node = NULL;
+
+        if (handle->sock == PGINVALID_SOCKET)
+        {
+            ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                errmsg("apply_exec_on_dn_nodes invalid connection to datanode %s", handle->nodename)));
+        }
+
+        node = apply_pipeline_get_node(handle);
+
+        if (pgxc_node_queue_apply(handle, s->data, s->len, ignore_pk_conflict) ||
+            (handle->outEnd >= APPLY_PIPELINE_FLUSH_SIZE && pgxc_node_flush(handle)))
+        {
+            ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                errmsg("apply_exec_on_dn_nodes sending apply to datanode %s fails", handle->nodename)));
+        }
+        node->inflight++;
+
+        if (node->inflight >= logical_apply_pipeline_depth)
+        {
+            apply_pipeline_wait_node(node);
+        }
+    }
+}
+
 /*
  * send apply message to datanodes and wait response
  */
@@ -575,6 +864,19 @@ apply_exec_on_dn_nodes(StringInfo s, char *nspname, char *relname, PGXCNodeAllHa
         return;
     }
 
+    if (logical_apply_pipeline_depth > 0)
+    {
+        apply_pipeline_send(s, all_handles);
+        return;
+    }
+
+    /*
+     * The depth may have been set to 0 by a reload in the middle of the
+     * transaction, collect what is still in flight before using the
+     * connections synchronously.
+     */
+    apply_pipeline_wait_all();
+
     /* send apply message to DN and wait response */
     ignore_pk_conflict = MySubscription->ignore_pk_conflict;
 
@@ -598,53 +900,7 @@ apply_exec_on_dn_nodes(StringInfo s, char *nspname, char *relname, PGXCNodeAllHa
 
     /* Receive responses */
     result = pgxc_node_receive_responses(all_handles->dn_conn_count, all_handles->datanode_handles, NULL, &combiner);
-    if (result)
-    {
-        if (combiner.errorMessage)
-        {
-            pgxc_node_report_error(&combiner);
-        }
-        else
-        {
-            ereport(ERROR,
-                    (errcode(ERRCODE_INTERNAL_ERROR),
-					 errmsg("Failed to APPLY the insert or update or delete or relation message on datanodes")));
-        }
-        result = EOF;
-    }
-    else if (ignore_pk_conflict &&
-                combiner.errorMessage &&
-                MAKE_SQLSTATE(combiner.errorCode[0], combiner.errorCode[1],
-                              combiner.errorCode[2], combiner.errorCode[3],
-                              combiner.errorCode[4]) == ERRCODE_UNIQUE_VIOLATION)
-    {
-        if (combiner.errorDetail && combiner.errorHint)
-        {
-			elog(LOG, "logical apply found that %s, %s, %s",
-                        combiner.errorMessage,
-                        combiner.errorDetail,
-                        combiner.errorHint);
-        }
-        else if (combiner.errorDetail)
-        {
-            elog(LOG, "logical apply found that %s, %s",
-                        combiner.errorMessage,
-                        combiner.errorDetail);
-        }
-        else
-        {
-            elog(LOG, "logical apply found that %s",
-                        combiner.errorMessage);
-        }
-    }
-    else if (!validate_combiner(&combiner))
-    {
-        ereport(ERROR,
-	              (errcode(ERRCODE_INTERNAL_ERROR),
-                  errmsg("apply_exec_on_dn_nodes validate_combiner responese of APPLY failed: %s, on table %s.%s in database %s",
-                  combiner.errorMessage, nspname, relname, get_database_name(MyDatabaseId))));
-
-	}
+    apply_check_result(&combiner, result, ignore_pk_conflict, nspname, relname);
 
     CloseCombiner(&combiner);
 }
@@ -713,6 +969,195 @@ check_if_ican_apply(int32 tuple_hash)
     return false;
 }
 
+/*
+ * Commit ordering of parallel child subscriptions.
+ *
+ * The publisher routes each row change to one child by the hash of its
+ * replica identity, so changes of one key are applied in order by a single
+ * worker while independent keys are applied concurrently.  BEGIN and COMMIT
+ * reach every child, hence a child that has begun remote transaction L has
+ * finished all transactions committed before L.  When commit order is
+ * requested, a child commits L only after every running sibling has begun L
+ * or a later transaction.  The worker holding the oldest transaction never
+ * waits, so the children cannot deadlock.
+ */
+bool logical_apply_preserve_commit_order = false;
+
+/* oids of all child subscriptions sharing our parent, loaded on demand */
+static List *apply_order_siblings = NIL;
+static bool apply_order_siblings_valid = false;
+
+/* throughput not reported to subscription statistics yet */
+static uint64 apply_ntxns_pending = 0;
+static uint64 apply_commit_wait_pending = 0;
+
+static bool
+apply_order_enabled(void)
+{
+    return logical_apply_preserve_commit_order &&
+           !am_tablesync_worker() &&
+           MySubscription->is_all_actived &&
+           MySubscription->parallel_number > 1;
+}
+
+static void
+apply_order_reset_siblings(void)
+{
+    list_free(apply_order_siblings);
+    apply_order_siblings = NIL;
+    apply_order_siblings_valid = false;
+}
+
+/* must be called in a transaction, the siblings are read from catalog */
+static void
+apply_order_load_siblings(void)
+{
+    MemoryContext oldctx;
+    List       *childs;
+    ListCell   *lc;
+
+    apply_order_reset_siblings();
+
+    childs = GetTbaseSubscriptnParallelChild(MySubscription->oid);
+
+    oldctx = MemoryContextSwitchTo(ApplyContext);
+    foreach (lc, childs)
+    {
+        Oid subid = lfirst_oid(lc);
+
+        if (subid != MySubscription->oid)
+            apply_order_siblings = lappend_oid(apply_order_siblings, subid);
+    }
+    MemoryContextSwitchTo(oldctx);
+
+    list_free(childs);
+    apply_order_siblings_valid = true;
+}
+
+/*
+ * Publish the remote transaction we are going to apply, and wake up the
+ * siblings which may wait for us to reach it.
+ */
+static void
+apply_order_set_position(XLogRecPtr final_lsn)
+{
+    ListCell   *lc;
+
+    SpinLockAcquire(&MyLogicalRepWorker->relmutex);
+    MyLogicalRepWorker->apply_final_lsn = final_lsn;
+    SpinLockRelease(&MyLogicalRepWorker->relmutex);
+
+    if (!apply_order_siblings_valid || !apply_order_enabled())
+        return;
+
+    LWLockAcquire(LogicalRepWorkerLock, LW_SHARED);
+    foreach (lc, apply_order_siblings)
+    {
+        LogicalRepWorker *worker;
+
+        worker = logicalrep_worker_find(lfirst_oid(lc), InvalidOid, true);
+        if (worker)
+            logicalrep_worker_wakeup_ptr(worker);
+    }
+    LWLockRelease(LogicalRepWorkerLock);
+}
+
+/* is any running sibling still applying a transaction before commit_lsn */
+static bool
+apply_order_siblings_behind(XLogRecPtr commit_lsn)
+{
+    ListCell   *lc;
+    bool        behind = false;
+
+    LWLockAcquire(LogicalRepWorkerLock, LW_SHARED);
+    foreach (lc, apply_order_siblings)
+    {
+        LogicalRepWorker *worker;
+
+        worker = logicalrep_worker_find(lfirst_oid(lc), InvalidOid, true);
+        if (worker == NULL)
+            continue;
+
+        SpinLockAcquire(&worker->relmutex);
+        behind = worker->apply_final_lsn < commit_lsn;
+        SpinLockRelease(&worker->relmutex);
+
+        if (behind)
+            break;
+    }
+    LWLockRelease(LogicalRepWorkerLock);
+
+    return behind;
+}
+
+/*
+ * Wait until all siblings are done with transactions committed before
+ * commit_lsn on the publisher.
+ */
+static void
+apply_order_wait_commit(XLogRecPtr commit_lsn)
+{
+    TimestampTz start = 0;
+
+    if (!apply_order_enabled())
+        return;
+
+    if (!apply_order_siblings_valid)
+        apply_order_load_siblings();
+
+    while (apply_order_siblings_behind(commit_lsn))
+    {
+        int rc;
+
+        if (start == 0)
+            start = GetCurrentTimestamp();
+
+        /* siblings wake us up when they begin a transaction */
+        rc = WaitLatch(MyLatch,
+                       WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH,
+                       NAPTIME_PER_CYCLE,
+                       WAIT_EVENT_LOGICAL_APPLY_COMMIT_ORDER);
+
+        if (rc & WL_POSTMASTER_DEATH)
+            proc_exit(1);
+
+        ResetLatch(MyLatch);
+        CHECK_FOR_INTERRUPTS();
+
+        if (got_SIGHUP)
+        {
+            got_SIGHUP = false;
+            ProcessConfigFile(PGC_SIGHUP);
+
+            if (!apply_order_enabled())
+                break;
+        }
+    }
+
+    if (start != 0)
+    {
+        long    secs;
+        int     usecs;
+
+        TimestampDifference(start, GetCurrentTimestamp(), &secs, &usecs);
+        apply_commit_wait_pending += (uint64) secs * USECS_PER_SEC + usecs;
+    }
+}
+
+/* report transactions applied since the last call to statistics */
+static void
+apply_order_report_stat(void)
+{
+    if (apply_ntxns_pending == 0 && apply_commit_wait_pending == 0)
+        return;
+
+    UpdateSubApplyStatistics(MySubscription->name, apply_ntxns_pending,
+                             apply_commit_wait_pending);
+
+    apply_ntxns_pending = 0;
+    apply_commit_wait_pending = 0;
+}
+
 #endif
 
 /*
@@ -729,9 +1174,15 @@ apply_handle_begin(StringInfo s)
 
     in_remote_transaction = true;
 
+#ifdef __SUBSCRIPTION__
+    apply_order_set_position(begin_data.final_lsn);
+#endif
+
     pgstat_report_activity(STATE_RUNNING, NULL);
 }
 
+static void apply_handle_commit_internal(LogicalRepCommitData *commit_data);
+
 /*
  * Handle COMMIT message.
  *
@@ -746,6 +1197,20 @@ apply_handle_commit(StringInfo s)
 
     Assert(commit_data.commit_lsn == remote_final_lsn);
 
+    apply_handle_commit_internal(&commit_data);
+}
+
+/*
+ * Commit the remote transaction applied so far, for COMMIT and STREAM COMMIT.
+ */
+static void
+apply_handle_commit_internal(LogicalRepCommitData *commit_data)
+{
+#ifdef __SUBSCRIPTION__
+    /* the transaction is applied on datanodes only when all results are in */
+    apply_pipeline_wait_all();
+#endif
+
     /* The synchronization worker runs in single transaction. */
     if (IsTransactionState() && !am_tablesync_worker())
     {
@@ -761,18 +1226,25 @@ apply_handle_commit(StringInfo s)
                 GetCurrentTransactionId();
             }
         }
+#endif
+#ifdef __SUBSCRIPTION__
+        /* transactions before us on the publisher must be committed first */
+        apply_order_wait_commit(commit_data->commit_lsn);
 #endif
         /*
          * Update origin state so we can restart streaming from correct
          * position in case of crash.
          */
-        replorigin_session_origin_lsn = commit_data.end_lsn;
-        replorigin_session_origin_timestamp = commit_data.committime;
+        replorigin_session_origin_lsn = commit_data->end_lsn;
+        replorigin_session_origin_timestamp = commit_data->committime;
 
         CommitTransactionCommand();
         pgstat_report_stat(false);
+#ifdef __SUBSCRIPTION__
+        apply_ntxns_pending++;
+#endif
 
-        store_flush_position(commit_data.end_lsn);
+        store_flush_position(commit_data->end_lsn);
     }
     else
     {
@@ -784,7 +1256,7 @@ apply_handle_commit(StringInfo s)
     in_remote_transaction = false;
 
     /* Process any tables that are being synchronized in parallel. */
-    process_syncing_tables(commit_data.end_lsn);
+    process_syncing_tables(commit_data->end_lsn);
 
     pgstat_report_activity(STATE_IDLE, NULL);
 }
@@ -947,6 +1419,9 @@ apply_handle_insert(StringInfo s)
         CommandCounterIncrement();
         return;
     }
+
+    /* the executor below uses the datanode connections synchronously */
+    apply_pipeline_wait_all();
 #endif
 
     /* Initialize the executor state. */
@@ -963,7 +1438,7 @@ apply_handle_insert(StringInfo s)
 
 	/* Process and store remote tuple in the slot */
 	oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
-	slot_store_cstrings(remoteslot, rel, newtup.values);
+	slot_store_cstrings(remoteslot, rel, &newtup);
 	slot_fill_defaults(rel, estate, remoteslot);
 	MemoryContextSwitchTo(oldctx);
 
@@ -1109,6 +1584,9 @@ apply_handle_update(StringInfo s)
         CommandCounterIncrement();
         return;
     }
+
+    /* the executor below uses the datanode connections synchronously */
+    apply_pipeline_wait_all();
 #endif
 
     /* Initialize the executor state. */
@@ -1130,7 +1608,7 @@ apply_handle_update(StringInfo s)
     /* Build the search tuple. */
     oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
     slot_store_cstrings(remoteslot, rel,
-                        has_oldtup ? oldtup.values : newtup.values);
+                        has_oldtup ? &oldtup : &newtup);
     MemoryContextSwitchTo(oldctx);
 
     /*
@@ -1161,7 +1639,7 @@ apply_handle_update(StringInfo s)
         /* Process and store remote tuple in the slot */
         oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
         ExecStoreTuple(localslot->tts_tuple, remoteslot, InvalidBuffer, false);
-        slot_modify_cstrings(remoteslot, rel, newtup.values, newtup.changed);
+        slot_modify_cstrings(remoteslot, rel, &newtup);
         MemoryContextSwitchTo(oldctx);
 
         EvalPlanQualSetSlot(&epqstate, remoteslot);
@@ -1286,6 +1764,9 @@ apply_handle_delete(StringInfo s)
         CommandCounterIncrement();
         return;
     }
+
+    /* the executor below uses the datanode connections synchronously */
+    apply_pipeline_wait_all();
 #endif
 
     /* Initialize the executor state. */
@@ -1306,7 +1787,7 @@ apply_handle_delete(StringInfo s)
 
     /* Find the tuple using the replica identity index. */
     oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
-    slot_store_cstrings(remoteslot, rel, oldtup.values);
+    slot_store_cstrings(remoteslot, rel, &oldtup);
     MemoryContextSwitchTo(oldctx);
 
     /*
@@ -1370,6 +1851,385 @@ apply_handle_delete(StringInfo s)
 }
 
 
+#ifdef __SUBSCRIPTION__
+/*
+ * Streaming of large in-progress transactions.
+ *
+ * With logical_apply_streaming on, the publisher sends the changes of a large
+ * transaction in blocks between STREAM START and STREAM STOP long before it
+ * commits, each change tagged with the (sub)transaction it belongs to.  The
+ * changes are spooled to a temporary file per remote transaction, with the
+ * xid taken out again, and replayed through apply_dispatch on STREAM COMMIT.
+ * STREAM ABORT of a subtransaction cuts the file back to its first change.
+ */
+bool logical_apply_streaming = false;
+
+/* ask for column values in binary, see slot_column_datum */
+bool logical_apply_binary = false;
+
+typedef struct ApplyStreamSubXact
+{
+    TransactionId xid;
+    off_t        offset;            /* position of its first change */
+} ApplyStreamSubXact;
+
+typedef struct ApplyStreamXact
+{
+    TransactionId xid;            /* remote toplevel xid */
+    BufFile    *file;            /* spooled changes */
+    off_t        end;            /* size of the valid part of the file */
+    List       *subxacts;        /* ApplyStreamSubXact, in file order */
+    TransactionId last_subxid;    /* subxact of the last spooled change */
+} ApplyStreamXact;
+
+/* streamed transactions neither committed nor aborted yet */
+static List *apply_stream_xacts = NIL;
+
+/* transaction of the current STREAM START block, NULL outside blocks */
+static ApplyStreamXact *apply_stream_cur = NULL;
+
+static void apply_dispatch(StringInfo s);
+
+static ApplyStreamXact *
+apply_stream_find(TransactionId xid)
+{
+    ListCell   *lc;
+
+    foreach(lc, apply_stream_xacts)
+    {
+        ApplyStreamXact *sx = (ApplyStreamXact *) lfirst(lc);
+
+        if (sx->xid == xid)
+            return sx;
+    }
+
+    return NULL;
+}
+
+static void
+apply_stream_seek(ApplyStreamXact *sx, off_t offset)
+{
+    if (BufFileSeek(sx->file, 0, offset, SEEK_SET) != 0)
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("could not seek in changes file of streamed remote transaction %u",
+                        sx->xid)));
+}
+
+/*
+ * Forget the changes spooled from offset on, and the subtransactions that
+ * started there.
+ */
+static void
+apply_stream_truncate(ApplyStreamXact *sx, off_t offset)
+{
+    MemoryContext oldctx = MemoryContextSwitchTo(ApplyContext);
+    List       *keep = NIL;
+    ListCell   *lc;
+
+    foreach(lc, sx->subxacts)
+    {
+        ApplyStreamSubXact *sub = (ApplyStreamSubXact *) lfirst(lc);
+
+        if (sub->offset < offset)
+            keep = lappend(keep, sub);
+        else
+            pfree(sub);
+    }
+    list_free(sx->subxacts);
+    sx->subxacts = keep;
+    MemoryContextSwitchTo(oldctx);
+
+    sx->end = offset;
+    sx->last_subxid = InvalidTransactionId;
+    apply_stream_seek(sx, offset);
+}
+
+static void
+apply_stream_discard(ApplyStreamXact *sx)
+{
+    BufFileClose(sx->file);
+    list_free_deep(sx->subxacts);
+    apply_stream_xacts = list_delete_ptr(apply_stream_xacts, sx);
+    pfree(sx);
+}
+
+/*
+ * Spool a change received inside a STREAM START block.  Returns false if the
+ * message is not to be spooled.
+ */
+static bool
+apply_stream_spool(char action, StringInfo s)
+{
+    ApplyStreamXact *sx = apply_stream_cur;
+    TransactionId subxid;
+    int            hdrlen;
+    int            len;
+
+    if (sx == NULL)
+        return false;
+
+    if (action != 'I' && action != 'U' && action != 'D' &&
+        action != 'R' && action != 'Y')
+        return false;
+
+    subxid = pq_getmsgint(s, 4);
+    if (!TransactionIdIsValid(subxid))
+        ereport(ERROR,
+                (errcode(ERRCODE_PROTOCOL_VIOLATION),
+                 errmsg("invalid transaction ID in streamed replication transaction")));
+
+    /* remember where each subtransaction starts, for STREAM ABORT */
+    if (subxid != sx->xid && subxid != sx->last_subxid)
+    {
+        ListCell   *lc;
+        bool        found = false;
+
+        foreach(lc, sx->subxacts)
+        {
+            if (((ApplyStreamSubXact *) lfirst(lc))->xid == subxid)
+            {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+        {
+            MemoryContext oldctx = MemoryContextSwitchTo(ApplyContext);
+            ApplyStreamSubXact *sub = palloc(sizeof(ApplyStreamSubXact));
+
+            sub->xid = subxid;
+            sub->offset = sx->end;
+            sx->subxacts = lappend(sx->subxacts, sub);
+            MemoryContextSwitchTo(oldctx);
+        }
+    }
+    sx->last_subxid = subxid;
+
+    /* the message as it would look in a regular transaction */
+    hdrlen = s->cursor - sizeof(TransactionId);
+    len = s->len - sizeof(TransactionId);
+
+    if (BufFileWrite(sx->file, &len, sizeof(len)) != sizeof(len) ||
+        BufFileWrite(sx->file, s->data, hdrlen) != hdrlen ||
+        BufFileWrite(sx->file, s->data + s->cursor, s->len - s->cursor) !=
+        s->len - s->cursor)
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("could not write to changes file of streamed remote transaction %u",
+                        sx->xid)));
+
+    sx->end += sizeof(len) + len;
+
+    return true;
+}
+
+/*
+ * Apply the spooled changes of a streamed transaction.  The caller has
+ * started the remote transaction.
+ */
+static void
+apply_stream_replay(ApplyStreamXact *sx)
+{
+    StringInfoData s2;
+    off_t        offset = 0;
+    char       *buffer = NULL;
+    int            bufsize = 0;
+
+    apply_stream_seek(sx, 0);
+
+    while (offset < sx->end)
+    {
+        int            len;
+
+        if (BufFileRead(sx->file, &len, sizeof(len)) != sizeof(len))
+            ereport(ERROR,
+                    (errcode_for_file_access(),
+                     errmsg("could not read from changes file of streamed remote transaction %u",
+                            sx->xid)));
+
+        if (len > bufsize)
+        {
+            if (buffer != NULL)
+                pfree(buffer);
+            bufsize = len;
+            buffer = MemoryContextAlloc(ApplyContext, bufsize);
+        }
+
+        if (BufFileRead(sx->file, buffer, len) != len)
+            ereport(ERROR,
+                    (errcode_for_file_access(),
+                     errmsg("could not read from changes file of streamed remote transaction %u",
+                            sx->xid)));
+
+        offset += sizeof(len) + len;
+
+        s2.data = buffer;
+        s2.len = len;
+        s2.cursor = 0;
+        s2.maxlen = -1;
+
+        /* skip the walsender header, as the apply loop does */
+        (void) pq_getmsgbyte(&s2);    /* 'w' */
+        (void) pq_getmsgint64(&s2); /* dataStart */
+        (void) pq_getmsgint64(&s2); /* walEnd */
+        (void) pq_getmsgint64(&s2); /* sendTime */
+
+        apply_dispatch(&s2);
+
+        MemoryContextReset(ApplyMessageContext);
+    }
+
+    if (buffer != NULL)
+        pfree(buffer);
+}
+
+/*
+ * Handle STREAM START message.
+ */
+static void
+apply_handle_stream_start(StringInfo s)
+{
+    ApplyStreamXact *sx;
+    TransactionId xid;
+    bool        first_segment;
+
+    if (apply_stream_cur != NULL)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROTOCOL_VIOLATION),
+                 errmsg("duplicate STREAM START message")));
+
+    xid = logicalrep_read_stream_start(s, &first_segment);
+    if (!TransactionIdIsValid(xid))
+        ereport(ERROR,
+                (errcode(ERRCODE_PROTOCOL_VIOLATION),
+                 errmsg("invalid transaction ID in streamed replication transaction")));
+
+    sx = apply_stream_find(xid);
+    if (sx == NULL)
+    {
+        MemoryContext oldctx;
+
+        if (!first_segment)
+            ereport(ERROR,
+                    (errcode(ERRCODE_PROTOCOL_VIOLATION),
+                     errmsg("STREAM START message for unknown remote transaction %u",
+                            xid)));
+
+        oldctx = MemoryContextSwitchTo(ApplyContext);
+        sx = (ApplyStreamXact *) palloc0(sizeof(ApplyStreamXact));
+        sx->xid = xid;
+        sx->file = BufFileCreateTemp(true);
+        apply_stream_xacts = lappend(apply_stream_xacts, sx);
+        MemoryContextSwitchTo(oldctx);
+    }
+    else if (first_segment)
+    {
+        /* the publisher decodes the transaction again from its start */
+        apply_stream_truncate(sx, 0);
+    }
+
+    apply_stream_cur = sx;
+
+    pgstat_report_activity(STATE_RUNNING, NULL);
+}
+
+/*
+ * Handle STREAM STOP message.
+ */
+static void
+apply_handle_stream_stop(StringInfo s)
+{
+    if (apply_stream_cur == NULL)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROTOCOL_VIOLATION),
+                 errmsg("STREAM STOP message without STREAM START")));
+
+    apply_stream_cur = NULL;
+
+    pgstat_report_activity(STATE_IDLE, NULL);
+}
+
+/*
+ * Handle STREAM ABORT message, of the whole transaction or of one of its
+ * subtransactions.
+ */
+static void
+apply_handle_stream_abort(StringInfo s)
+{
+    ApplyStreamXact *sx;
+    TransactionId xid;
+    TransactionId subxid;
+    ListCell   *lc;
+
+    if (apply_stream_cur != NULL)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROTOCOL_VIOLATION),
+                 errmsg("STREAM ABORT message inside a streamed block")));
+
+    logicalrep_read_stream_abort(s, &xid, &subxid);
+
+    /* nothing of it may have been streamed */
+    sx = apply_stream_find(xid);
+    if (sx == NULL)
+        return;
+
+    if (subxid == xid)
+    {
+        apply_stream_discard(sx);
+        return;
+    }
+
+    foreach(lc, sx->subxacts)
+    {
+        ApplyStreamSubXact *sub = (ApplyStreamSubXact *) lfirst(lc);
+
+        if (sub->xid == subxid)
+        {
+            apply_stream_truncate(sx, sub->offset);
+            break;
+        }
+    }
+}
+
+/*
+ * Handle STREAM COMMIT message: apply the spooled changes and commit them
+ * like a regular remote transaction.
+ */
+static void
+apply_handle_stream_commit(StringInfo s)
+{
+    LogicalRepCommitData commit_data;
+    ApplyStreamXact *sx;
+    TransactionId xid;
+
+    if (apply_stream_cur != NULL)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROTOCOL_VIOLATION),
+                 errmsg("STREAM COMMIT message inside a streamed block")));
+
+    xid = logicalrep_read_stream_commit(s, &commit_data);
+
+    sx = apply_stream_find(xid);
+    if (sx == NULL)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROTOCOL_VIOLATION),
+                 errmsg("STREAM COMMIT message for unknown remote transaction %u",
+                        xid)));
+
+    remote_final_lsn = commit_data.commit_lsn;
+    in_remote_transaction = true;
+    apply_order_set_position(commit_data.commit_lsn);
+    pgstat_report_activity(STATE_RUNNING, NULL);
+
+    apply_stream_replay(sx);
+    apply_stream_discard(sx);
+
+    apply_handle_commit_internal(&commit_data);
+}
+#endif
+
 /*
  * Logical replication protocol message dispatcher for CN.
  */
@@ -1378,6 +2238,12 @@ apply_dispatch(StringInfo s)
 {// #lizard forgives
     char        action = pq_getmsgbyte(s);
 
+#ifdef __SUBSCRIPTION__
+    /* changes of a streamed transaction wait for its commit */
+    if (apply_stream_spool(action, s))
+        return;
+#endif
+
     switch (action)
     {
             /* BEGIN */
@@ -1412,6 +2278,24 @@ apply_dispatch(StringInfo s)
         case 'O':
             apply_handle_origin(s);
             break;
+#ifdef __SUBSCRIPTION__
+            /* STREAM START */
+        case 'S':
+            apply_handle_stream_start(s);
+            break;
+            /* STREAM STOP */
+        case 'E':
+            apply_handle_stream_stop(s);
+            break;
+            /* STREAM ABORT */
+        case 'A':
+            apply_handle_stream_abort(s);
+            break;
+            /* STREAM COMMIT */
+        case 'c':
+            apply_handle_stream_commit(s);
+            break;
+#endif
         default:
             {
                 ereport(ERROR,
@@ -1666,9 +2550,17 @@ LogicalRepApplyLoop(XLogRecPtr last_received)
         if (!am_tablesync_worker())
         {
         	logicalrep_statis_update_for_apply(MySubscription->oid, MySubscription->name);
+#ifdef __SUBSCRIPTION__
+            apply_order_report_stat();
+#endif
         }
 #endif
 
+#ifdef __SUBSCRIPTION__
+        /* let datanodes work on queued changes while we wait for more */
+        apply_pipeline_flush();
+#endif
+
         /* confirm all writes so far */
         send_feedback(last_received, false, false);
 
@@ -2009,6 +2901,11 @@ maybe_reread_subscription(void)
     FreeSubscription(MySubscription);
     MySubscription = newsub;
 
+#ifdef __SUBSCRIPTION__
+    /* parallel children may have changed, reload them on next commit */
+    apply_order_reset_siblings();
+#endif
+
     MemoryContextSwitchTo(oldctx);
 
     /* Change synchronous commit according to the user's wishes */
@@ -2176,6 +3073,15 @@ ApplyWorkerMain(Datum main_arg)
     {
         char       *syncslotname;
 
+#ifdef __SUBSCRIPTION__
+        /* Helper of a sync worker, copy our stream of the table and quit. */
+        if (MyLogicalRepWorker->sync_stream > 0)
+        {
+            LogicalRepSyncStreamMain();
+            proc_exit(0);
+        }
+#endif
+
         /* This is table synchroniation worker, call initial sync. */
         syncslotname = LogicalRepSyncTableStart(&origin_startpos);
 
@@ -2216,6 +3122,13 @@ ApplyWorkerMain(Datum main_arg)
         origin_startpos = replorigin_session_get_progress(false);
         CommitTransactionCommand();
 
+#ifdef __SUBSCRIPTION__
+        /* everything up to the origin progress is applied already */
+        SpinLockAcquire(&MyLogicalRepWorker->relmutex);
+        MyLogicalRepWorker->apply_final_lsn = origin_startpos;
+        SpinLockRelease(&MyLogicalRepWorker->relmutex);
+#endif
+
         wrconn = walrcv_connect(MySubscription->conninfo, true, MySubscription->name,
                                 &err);
         if (wrconn == NULL)
@@ -2244,6 +3157,12 @@ ApplyWorkerMain(Datum main_arg)
     options.slotname = myslotname;
     options.proto.logical.proto_version = LOGICALREP_PROTO_VERSION_NUM;
     options.proto.logical.publication_names = MySubscription->publications;
+#ifdef __SUBSCRIPTION__
+    /* the synchronization worker applies everything in one transaction */
+    options.proto.logical.streaming = logical_apply_streaming &&
+        !am_tablesync_worker();
+    options.proto.logical.binary = logical_apply_binary;
+#endif
 
     /* Start normal logical streaming replication. */
     walrcv_startstreaming(wrconn, &options);
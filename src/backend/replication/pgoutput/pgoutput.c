@@ -19,6 +19,7 @@
 #include "replication/origin.h"
 #include "replication/pgoutput.h"
 
+#include "utils/builtins.h"
 #include "utils/inval.h"
 #include "utils/int8.h"
 #include "utils/memutils.h"
@@ -41,6 +42,16 @@ static void pgoutput_change(LogicalDecodingContext *ctx,
                 ReorderBufferChange *change);
 static bool pgoutput_origin_filter(LogicalDecodingContext *ctx,
                        RepOriginId origin_id);
+#ifdef __SUBSCRIPTION__
+static void pgoutput_stream_start(LogicalDecodingContext *ctx,
+                      ReorderBufferTXN *txn);
+static void pgoutput_stream_stop(LogicalDecodingContext *ctx,
+                     ReorderBufferTXN *txn);
+static void pgoutput_stream_abort(LogicalDecodingContext *ctx,
+                      ReorderBufferTXN *txn, XLogRecPtr abort_lsn);
+static void pgoutput_stream_commit(LogicalDecodingContext *ctx,
+                       ReorderBufferTXN *txn, XLogRecPtr commit_lsn);
+#endif
 
 static bool publications_valid;
 
@@ -55,6 +66,15 @@ typedef struct RelationSyncEntry
     bool        schema_sent;    /* did we send the schema? */
     bool        replicate_valid;
     PublicationActions pubactions;
+
+#ifdef __SUBSCRIPTION__
+    /*
+     * Streamed transactions the schema was sent in.  The subscriber only
+     * sees those messages when the transaction commits, so schema_sent is
+     * left alone until then.
+     */
+    List       *streamed_txns;
+#endif
 } RelationSyncEntry;
 
 /* Map used to remember which relation schemas we sent. */
@@ -65,6 +85,9 @@ static RelationSyncEntry *get_rel_sync_entry(PGOutputData *data, Oid relid);
 static void rel_sync_cache_relation_cb(Datum arg, Oid relid);
 static void rel_sync_cache_publication_cb(Datum arg, int cacheid,
                               uint32 hashvalue);
+#ifdef __SUBSCRIPTION__
+static void cleanup_rel_sync_cache(TransactionId xid, bool is_commit);
+#endif
 
 /*
  * Specify output plugin callbacks
@@ -80,15 +103,28 @@ _PG_output_plugin_init(OutputPluginCallbacks *cb)
     cb->commit_cb = pgoutput_commit_txn;
     cb->filter_by_origin_cb = pgoutput_origin_filter;
     cb->shutdown_cb = pgoutput_shutdown;
+#ifdef __SUBSCRIPTION__
+    cb->stream_start_cb = pgoutput_stream_start;
+    cb->stream_stop_cb = pgoutput_stream_stop;
+    cb->stream_abort_cb = pgoutput_stream_abort;
+    cb->stream_commit_cb = pgoutput_stream_commit;
+#endif
 }
 
 static void
 parse_output_parameters(List *options, uint32 *protocol_version,
+#ifdef __SUBSCRIPTION__
+                        bool *enable_streaming, bool *binary,
+#endif
                         List **publication_names)
 {// #lizard forgives
     ListCell   *lc;
     bool        protocol_version_given = false;
     bool        publication_names_given = false;
+#ifdef __SUBSCRIPTION__
+    bool        streaming_given = false;
+    bool        binary_given = false;
+#endif
 
     foreach(lc, options)
     {
@@ -134,6 +170,36 @@ parse_output_parameters(List *options, uint32 *protocol_version,
                         (errcode(ERRCODE_INVALID_NAME),
                          errmsg("invalid publication_names syntax")));
         }
+#ifdef __SUBSCRIPTION__
+        else if (strcmp(defel->defname, "streaming") == 0)
+        {
+            if (streaming_given)
+                ereport(ERROR,
+                        (errcode(ERRCODE_SYNTAX_ERROR),
+                         errmsg("conflicting or redundant options")));
+            streaming_given = true;
+
+            if (!parse_bool(strVal(defel->arg), enable_streaming))
+                ereport(ERROR,
+                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                         errmsg("invalid streaming value \"%s\"",
+                                strVal(defel->arg))));
+        }
+        else if (strcmp(defel->defname, "binary") == 0)
+        {
+            if (binary_given)
+                ereport(ERROR,
+                        (errcode(ERRCODE_SYNTAX_ERROR),
+                         errmsg("conflicting or redundant options")));
+            binary_given = true;
+
+            if (!parse_bool(strVal(defel->arg), binary))
+                ereport(ERROR,
+                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                         errmsg("invalid binary value \"%s\"",
+                                strVal(defel->arg))));
+        }
+#endif
         else
             elog(ERROR, "unrecognized pgoutput option: %s", defel->defname);
     }
@@ -170,6 +236,9 @@ pgoutput_startup(LogicalDecodingContext *ctx, OutputPluginOptions *opt,
         /* Parse the params and ERROR if we see any we don't recognize */
         parse_output_parameters(ctx->output_plugin_options,
                                 &data->protocol_version,
+#ifdef __SUBSCRIPTION__
+                                &data->streaming, &data->binary,
+#endif
                                 &data->publication_names);
 
         /* Check if we support requested protocol */
@@ -200,6 +269,14 @@ pgoutput_startup(LogicalDecodingContext *ctx, OutputPluginOptions *opt,
         /* Initialize relation schema cache. */
         init_rel_sync_cache(CacheMemoryContext);
     }
+
+#ifdef __SUBSCRIPTION__
+    /* only stream in-progress transactions if the client can take them */
+    ctx->streaming = data->streaming;
+
+    /* column values in the send/recv format of their types */
+    logicalrep_set_binary(data->binary);
+#endif
 }
 
 /*
@@ -266,6 +343,8 @@ pgoutput_change(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
 #ifdef __SUBSCRIPTION__
     HeapTuple calc_tuple = NULL;
     int32 tuple_hash = 0;
+    TransactionId xid = InvalidTransactionId;
+    TransactionId topxid = InvalidTransactionId;
 #endif
 
     relentry = get_rel_sync_entry(data, RelationGetRelid(relation));
@@ -316,13 +395,31 @@ pgoutput_change(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
     }
 #endif
 
+#ifdef __SUBSCRIPTION__
+    /*
+     * Changes of a streamed transaction carry the xid of their subxact, so
+     * the subscriber can drop them when that rolls back.
+     */
+    if (data->in_streaming)
+    {
+        xid = change->txn->xid;
+        topxid = txn->xid;
+    }
+#endif
+
     /* Avoid leaking memory by using and resetting our own context */
     old = MemoryContextSwitchTo(data->context);
 
     /*
      * Write the relation schema if the current schema haven't been sent yet.
      */
+#ifdef __SUBSCRIPTION__
+    if (data->in_streaming ?
+        !list_member_int(relentry->streamed_txns, topxid) :
+        !relentry->schema_sent)
+#else
     if (!relentry->schema_sent)
+#endif
     {
         TupleDesc    desc;
         int            i;
@@ -344,14 +441,33 @@ pgoutput_change(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
                 continue;
 
             OutputPluginPrepareWrite(ctx, false);
-            logicalrep_write_typ(ctx->out, att->atttypid);
+            logicalrep_write_typ(ctx->out,
+#ifdef __SUBSCRIPTION__
+                                 topxid,
+#endif
+                                 att->atttypid);
             OutputPluginWrite(ctx, false);
         }
 
         OutputPluginPrepareWrite(ctx, false);
-        logicalrep_write_rel(ctx->out, relation);
+        logicalrep_write_rel(ctx->out,
+#ifdef __SUBSCRIPTION__
+                             topxid,
+#endif
+                             relation);
         OutputPluginWrite(ctx, false);
-        relentry->schema_sent = true;
+#ifdef __SUBSCRIPTION__
+        if (data->in_streaming)
+        {
+            MemoryContext oldctx = MemoryContextSwitchTo(CacheMemoryContext);
+
+            relentry->streamed_txns = lappend_int(relentry->streamed_txns,
+                                                  topxid);
+            MemoryContextSwitchTo(oldctx);
+        }
+        else
+#endif
+            relentry->schema_sent = true;
     }
 
     /* Send the data */
@@ -361,7 +477,7 @@ pgoutput_change(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
             OutputPluginPrepareWrite(ctx, true);
             logicalrep_write_insert(ctx->out, relation,
                                     #ifdef __SUBSCRIPTION__
-                                    tuple_hash,
+                                    xid, tuple_hash,
                                     #endif
                                     &change->data.tp.newtuple->tuple);
             OutputPluginWrite(ctx, true);
@@ -374,7 +490,7 @@ pgoutput_change(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
                 OutputPluginPrepareWrite(ctx, true);
                 logicalrep_write_update(ctx->out, relation,
                                         #ifdef __SUBSCRIPTION__
-                                        tuple_hash,
+                                        xid, tuple_hash,
                                         #endif
                                         oldtuple,
                                         &change->data.tp.newtuple->tuple);
@@ -387,7 +503,7 @@ pgoutput_change(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
                 OutputPluginPrepareWrite(ctx, true);
                 logicalrep_write_delete(ctx->out, relation,
                                         #ifdef __SUBSCRIPTION__
-                                        tuple_hash,
+                                        xid, tuple_hash,
                                         #endif
                                         &change->data.tp.oldtuple->tuple);
                 OutputPluginWrite(ctx, true);
@@ -404,6 +520,88 @@ pgoutput_change(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
     MemoryContextReset(data->context);
 }
 
+#ifdef __SUBSCRIPTION__
+/*
+ * STREAM START callback
+ */
+static void
+pgoutput_stream_start(LogicalDecodingContext *ctx, ReorderBufferTXN *txn)
+{
+    PGOutputData *data = (PGOutputData *) ctx->output_plugin_private;
+
+    /* we can't nest streaming of transactions */
+    Assert(!data->in_streaming);
+
+    OutputPluginPrepareWrite(ctx, true);
+    logicalrep_write_stream_start(ctx->out, txn->xid, !txn->streamed);
+    OutputPluginWrite(ctx, true);
+
+    data->in_streaming = true;
+}
+
+/*
+ * STREAM STOP callback
+ */
+static void
+pgoutput_stream_stop(LogicalDecodingContext *ctx, ReorderBufferTXN *txn)
+{
+    PGOutputData *data = (PGOutputData *) ctx->output_plugin_private;
+
+    Assert(data->in_streaming);
+
+    OutputPluginPrepareWrite(ctx, true);
+    logicalrep_write_stream_stop(ctx->out);
+    OutputPluginWrite(ctx, true);
+
+    data->in_streaming = false;
+}
+
+/*
+ * STREAM ABORT callback, for the toplevel transaction or a subxact of it.
+ */
+static void
+pgoutput_stream_abort(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
+                      XLogRecPtr abort_lsn)
+{
+    PGOutputData *data PG_USED_FOR_ASSERTS_ONLY =
+        (PGOutputData *) ctx->output_plugin_private;
+    ReorderBufferTXN *toptxn = txn->toptxn != NULL ? txn->toptxn : txn;
+
+    Assert(!data->in_streaming);
+
+    OutputPluginPrepareWrite(ctx, true);
+    logicalrep_write_stream_abort(ctx->out, toptxn->xid, txn->xid);
+    OutputPluginWrite(ctx, true);
+
+    /*
+     * The subscriber drops everything the aborted part sent, schema included,
+     * so send the schema again on the next change.
+     */
+    cleanup_rel_sync_cache(toptxn->xid, false);
+}
+
+/*
+ * STREAM COMMIT callback
+ */
+static void
+pgoutput_stream_commit(LogicalDecodingContext *ctx, ReorderBufferTXN *txn,
+                       XLogRecPtr commit_lsn)
+{
+    PGOutputData *data PG_USED_FOR_ASSERTS_ONLY =
+        (PGOutputData *) ctx->output_plugin_private;
+
+    Assert(!data->in_streaming);
+
+    OutputPluginUpdateProgress(ctx);
+
+    OutputPluginPrepareWrite(ctx, true);
+    logicalrep_write_stream_commit(ctx->out, txn, commit_lsn);
+    OutputPluginWrite(ctx, true);
+
+    cleanup_rel_sync_cache(txn->xid, true);
+}
+#endif
+
 /*
  * Currently we always forward.
  */
@@ -569,7 +767,12 @@ get_rel_sync_entry(PGOutputData *data, Oid relid)
     }
 
     if (!found)
+    {
         entry->schema_sent = false;
+#ifdef __SUBSCRIPTION__
+        entry->streamed_txns = NIL;
+#endif
+    }
 
     return entry;
 }
@@ -609,9 +812,42 @@ rel_sync_cache_relation_cb(Datum arg, Oid relid)
      * Reset schema sent status as the relation definition may have changed.
      */
     if (entry != NULL)
+    {
         entry->schema_sent = false;
+#ifdef __SUBSCRIPTION__
+        list_free(entry->streamed_txns);
+        entry->streamed_txns = NIL;
+#endif
+    }
 }
 
+#ifdef __SUBSCRIPTION__
+/*
+ * Forget that the schema was sent in a streamed transaction.  If it
+ * committed, the subscriber has the schema now.
+ */
+static void
+cleanup_rel_sync_cache(TransactionId xid, bool is_commit)
+{
+    HASH_SEQ_STATUS hash_seq;
+    RelationSyncEntry *entry;
+
+    Assert(RelationSyncCache != NULL);
+
+    hash_seq_init(&hash_seq, RelationSyncCache);
+    while ((entry = hash_seq_search(&hash_seq)) != NULL)
+    {
+        if (!list_member_int(entry->streamed_txns, xid))
+            continue;
+
+        if (is_commit)
+            entry->schema_sent = true;
+
+        entry->streamed_txns = list_delete_int(entry->streamed_txns, xid);
+    }
+}
+#endif
+
 /*
  * Publication relation map syscache invalidation callback
  */
@@ -150,6 +150,10 @@ static SQLCmd *make_sqlcmd(void);
 %token K_ID_SUBSCRIPTION
 %token K_REL_NAMESPACE
 %token K_NAME_REL
+%token K_COMPRESS
+%token K_INCREMENTAL
+%token K_PARALLEL
+%token K_STREAM
 
 %type <node>	command
 %type <node>	base_backup start_replication start_logical_replication
@@ -218,7 +222,8 @@ var_name:	IDENT	{ $$ = $1; }
 
 /*
  * BASE_BACKUP [LABEL '<label>'] [PROGRESS] [FAST] [WAL] [NOWAIT]
- * [MAX_RATE %d] [TABLESPACE_MAP]
+ * [MAX_RATE %d] [TABLESPACE_MAP] [COMPRESS %d] [INCREMENTAL %X/%X]
+ * [PARALLEL %d] [STREAM %d %X/%X]
  */
 base_backup:
 			K_BASE_BACKUP base_backup_opt_list
@@ -272,6 +277,29 @@ base_backup_opt:
 				  $$ = makeDefElem("tablespace_map",
 								   (Node *)makeInteger(TRUE), -1);
 				}
+			| K_COMPRESS UCONST
+				{
+				  $$ = makeDefElem("compress",
+								   (Node *)makeInteger($2), -1);
+				}
+			| K_INCREMENTAL RECPTR
+				{
+				  $$ = makeDefElem("incremental",
+								   (Node *)makeString(psprintf("%X/%X",
+										(uint32) ($2 >> 32), (uint32) $2)), -1);
+				}
+			| K_PARALLEL UCONST
+				{
+				  $$ = makeDefElem("parallel",
+								   (Node *)makeInteger($2), -1);
+				}
+			| K_STREAM UCONST RECPTR
+				{
+				  $$ = makeDefElem("stream",
+								   (Node *)list_make2(makeInteger($2),
+										makeString(psprintf("%X/%X",
+											(uint32) ($3 >> 32), (uint32) $3))), -1);
+				}
 			;
 
 create_replication_slot:
@@ -952,8 +952,12 @@ ReadBuffer_common(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
                 INSTR_TIME_ADD(pgBufferUsage.blk_read_time, io_time);
             }
 #ifdef _MLS_
-            /* before verify, decrypt if needed */
-            if (MAIN_FORKNUM == forkNum || EXTENT_FORKNUM == forkNum)
+            /* before verify, decrypt if needed, compressed pages are decrypted by smgr */
+            if ((MAIN_FORKNUM == forkNum || EXTENT_FORKNUM == forkNum)
+#ifdef __TBASE__
+                && !(MAIN_FORKNUM == forkNum && SmgrIsPageCompressed(smgr))
+#endif
+                )
             {
                 algo_id = PageGetAlgorithmId(bufBlock);
                 if (TRANSP_CRYPT_ALGO_ID_IS_VALID(algo_id))
@@ -2964,7 +2968,12 @@ FlushBuffer(BufferDesc *buf, SMgrRelation reln)
          * and, the shadow block dose not need to free, we alloc it once and it resides in top memory context.
          */
         if (REL_CRYPT_ENTRY_IS_VALID(&(reln->smgr_relcrypt)) 
-            && (MAIN_FORKNUM == buf->tag.forkNum || EXTENT_FORKNUM == buf->tag.forkNum))
+            && (MAIN_FORKNUM == buf->tag.forkNum || EXTENT_FORKNUM == buf->tag.forkNum)
+#ifdef __TBASE__
+            /* compressed pages are encrypted by smgr after compression */
+            && !(MAIN_FORKNUM == buf->tag.forkNum && SmgrIsPageCompressed(reln))
+#endif
+            )
         {
 			BufDisableMemoryProtection(bufBlock, false);
             bufBlockEncrypt = rel_crypt_page_encrypt((RelCrypt)&(reln->smgr_relcrypt), bufToWrite);
@@ -3700,6 +3709,25 @@ IncrBufferRefCount(Buffer buffer)
     }
 }
 
+#ifdef __TBASE__
+/*
+ * A page of a compressed relation is stored as one compressed image, which a
+ * torn write leaves impossible to uncompress.  Its hint bit updates are
+ * therefore protected by a full page image even without checksums.
+ */
+static bool
+BufferIsPageCompressed(BufferDesc *bufHdr)
+{
+    SMgrRelation reln;
+
+    if (bufHdr->tag.forkNum != MAIN_FORKNUM)
+        return false;
+
+    reln = smgropen(bufHdr->tag.rnode, InvalidBackendId);
+    return SmgrIsPageCompressed(reln);
+}
+#endif
+
 /*
  * MarkBufferDirtyHint
  *
@@ -3707,8 +3735,9 @@ IncrBufferRefCount(Buffer buffer)
  *
  * This is essentially the same as MarkBufferDirty, except:
  *
- * 1. The caller does not write WAL; so if checksums are enabled, we may need
- *      to write an XLOG_FPI WAL record to protect against torn pages.
+ * 1. The caller does not write WAL; so if checksums are enabled, or the
+ *      relation is page compressed, we may need to write an XLOG_FPI WAL
+ *      record to protect against torn pages.
  * 2. The caller might have only share-lock instead of exclusive-lock on the
  *      buffer's content lock.
  * 3. This function does not guarantee that the buffer is always marked dirty
@@ -3763,8 +3792,12 @@ MarkBufferDirtyHint(Buffer buffer, bool buffer_std)
          * We don't check full_page_writes here because that logic is included
          * when we call XLogInsert() since the value changes dynamically.
          */
-        if (XLogHintBitIsNeeded() &&
-            (pg_atomic_read_u32(&bufHdr->state) & BM_PERMANENT))
+        if ((pg_atomic_read_u32(&bufHdr->state) & BM_PERMANENT) &&
+            (XLogHintBitIsNeeded()
+#ifdef __TBASE__
+             || BufferIsPageCompressed(bufHdr)
+#endif
+            ))
         {
             /*
              * If we're in recovery we cannot dirty a page because of a hint.
@@ -5024,7 +5057,11 @@ static List* SyncBufferDoing(int buf_id, int status)
          * and, the shadow block dose not need to free, we alloc it once and it resides in top memory context.
          */
         if (REL_CRYPT_ENTRY_IS_VALID(&(reln->smgr_relcrypt))
-            && (MAIN_FORKNUM == buf->tag.forkNum || EXTENT_FORKNUM == buf->tag.forkNum))
+            && (MAIN_FORKNUM == buf->tag.forkNum || EXTENT_FORKNUM == buf->tag.forkNum)
+#ifdef __TBASE__
+            && !(MAIN_FORKNUM == buf->tag.forkNum && SmgrIsPageCompressed(reln))
+#endif
+            )
         {
             /* ---------------- parellel section ---------------- */
             if (g_enable_crypt_parellel_debug)
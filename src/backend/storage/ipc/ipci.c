@@ -95,6 +95,7 @@
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/bgwriter.h"
 #include "postmaster/postmaster.h"
+#include "replication/basebackup.h"
 #include "replication/logicallauncher.h"
 #include "replication/slot.h"
 #include "replication/walreceiver.h"
@@ -103,6 +104,9 @@
 #include "storage/bufmgr.h"
 #include "storage/dsm.h"
 #include "storage/ipc.h"
+#ifdef __TBASE__
+#include "storage/pagecompress.h"
+#endif
 #include "storage/pg_shmem.h"
 #include "storage/pmsignal.h"
 #include "storage/predicate.h"
@@ -245,6 +249,10 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
         size = add_size(size, ReplicationSlotsShmemSize());
         size = add_size(size, ReplicationOriginShmemSize());
         size = add_size(size, WalSndShmemSize());
+#ifdef __TBASE__
+        size = add_size(size, BaseBackupShmemSize());
+        size = add_size(size, PageCompressShmemSize());
+#endif
         size = add_size(size, WalRcvShmemSize());
 		size = add_size(size, Clean2pcShmemSize());
 #ifdef XCP
@@ -420,6 +428,10 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
     ReplicationSlotsShmemInit();
     ReplicationOriginShmemInit();
     WalSndShmemInit();
+#ifdef __TBASE__
+    BaseBackupShmemInit();
+    PageCompressShmemInit();
+#endif
     WalRcvShmemInit();
     ApplyLauncherShmemInit();
 
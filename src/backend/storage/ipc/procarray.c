@@ -58,12 +58,14 @@
 #include <signal.h>
 
 #include "access/clog.h"
+#include "access/htup_details.h"
 #include "access/subtrans.h"
 #include "access/transam.h"
 #include "access/twophase.h"
 #include "access/xact.h"
 #include "access/xlog.h"
 #include "catalog/catalog.h"
+#include "funcapi.h"
 #include "miscadmin.h"
 #include "postmaster/clustermon.h"
 #include "pgstat.h"
@@ -71,10 +73,12 @@
 #include "storage/procarray.h"
 #include "storage/spin.h"
 #include "utils/builtins.h"
+#include "utils/pg_lsn.h"
 #include "utils/rel.h"
 #include "utils/snapmgr.h"
 #ifdef PGXC
 #include "pgxc/pgxc.h"
+#include "pgxc/nodemgr.h"
 #include "access/gtm.h"
 #include "storage/ipc.h"
 #include "utils/guc.h"
@@ -2058,6 +2062,64 @@ char *GetGlobalTransactionId(const TransactionId pid)
 
 }
 
+/*
+ * CancelGlobalTransactionLockWaiter -- make the backend with the given pid
+ * fail its lock wait with a deadlock error, to break a deadlock spanning
+ * nodes.  Nothing is done unless the backend still waits for a lock for the
+ * given global transaction.  Returns whether the wait was canceled.
+ *
+ * Unlike a query cancel, removing the backend from the wait queue under the
+ * lock partition lock can only end the wait that was seen, not a later
+ * statement of the transaction.  WaitOnLock() reports the error.
+ */
+bool
+CancelGlobalTransactionLockWaiter(const char *globalXid, int pid)
+{
+    PGPROC     *proc;
+    LOCK       *lock;
+    uint32        hashcode;
+    LWLock       *partitionLock;
+    bool        match;
+    bool        canceled = false;
+
+    proc = BackendPidGetProc(pid);
+    if (proc == NULL)
+        return false;
+
+    /*
+     * The lock may go away before we hold its partition lock; the hash code
+     * is checked again once we do.
+     */
+    lock = proc->waitLock;
+    if (lock == NULL)
+        return false;
+    hashcode = LockTagHashCode(&lock->tag);
+    partitionLock = LockHashPartitionLock(hashcode);
+
+    LWLockAcquire(partitionLock, LW_EXCLUSIVE);
+    if (proc->pid == pid && proc->waitLock == lock &&
+        LockTagHashCode(&lock->tag) == hashcode &&
+        proc->waitStatus == STATUS_WAITING)
+    {
+        LWLockAcquire(&proc->globalxidLock, LW_SHARED);
+        match = proc->hasGlobalXid && strcmp(proc->globalXid, globalXid) == 0;
+        LWLockRelease(&proc->globalxidLock);
+
+        if (match)
+        {
+            elog(LOG, "canceling lock wait of process %d of global transaction %s to resolve a global deadlock",
+                 pid, globalXid);
+            proc->globalDeadlockVictim = true;
+            RemoveFromWaitQueue(proc, hashcode);
+            SetLatch(&proc->procLatch);
+            canceled = true;
+        }
+    }
+    LWLockRelease(partitionLock);
+
+    return canceled;
+}
+
 /*
  * GetSnapshotData -- returns information about running transactions.
  *
@@ -2104,6 +2166,7 @@ GetSnapshotData_shard(Snapshot snapshot, bool latest, bool need_shardmap)
 #ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
     TransactionId prepare_xmin;
     GlobalTimestamp tmin;
+    GlobalTimestamp db_tmin;
     int            precount = 0;
     int            subprecount = 0;
 #endif
@@ -2252,6 +2315,7 @@ GetSnapshotData_shard(Snapshot snapshot, bool latest, bool need_shardmap)
     prepare_xmin   = xmin;
     RecentCommitTs = tmin = ShmemVariableCache->latestGTS > ShmemVariableCache->latestCommitTs ? 
                                 ShmemVariableCache->latestGTS : ShmemVariableCache->latestCommitTs;
+    db_tmin = tmin;
 #endif
 
     snapshot->takenDuringRecovery = RecoveryInProgress();
@@ -2282,6 +2346,13 @@ GetSnapshotData_shard(Snapshot snapshot, bool latest, bool need_shardmap)
             {
                 tmin = saved_tmin;
             }
+            /* processes not bound to a database may read any of them */
+            if(GlobalTimestampIsValid(saved_tmin) && (saved_tmin < db_tmin) &&
+               (allProcs[pgprocno].databaseId == MyDatabaseId ||
+                !OidIsValid(allProcs[pgprocno].databaseId)))
+            {
+                db_tmin = saved_tmin;
+            }
             /* Fetch xid just once - see GetNewTransactionId */
             xid = pgxact->xid;
 
@@ -2561,6 +2632,14 @@ prepare_finished:
     {
         tmin = snapshot->start_ts;
     }
+    if(!snapshot->local && (snapshot->start_ts < db_tmin))
+    {
+        db_tmin = snapshot->start_ts;
+    }
+    if(!vacuum_database_horizon)
+    {
+        db_tmin = tmin;
+    }
 
     if(tmin <  (vacuum_delta * TIMESTAMP_SHIFT))
     {
@@ -2570,6 +2649,15 @@ prepare_finished:
     {
         RecentDataTs = tmin -  (vacuum_delta * TIMESTAMP_SHIFT);
     }
+
+    if(db_tmin <  (vacuum_delta * TIMESTAMP_SHIFT))
+    {
+        RecentDbDataTs = InvalidGlobalTimestamp;
+    }
+    else
+    {
+        RecentDbDataTs = db_tmin -  (vacuum_delta * TIMESTAMP_SHIFT);
+    }
     
 #endif
 
@@ -4067,6 +4155,14 @@ GetPGXCSnapshotData(Snapshot snapshot, bool latest)
         {
             /* need global snapshot now */
         }
+#ifdef __TBASE__
+        else if (IsStandbyPostgres() && !latest && enable_standby_read_routing &&
+                 IsConnFromCoord() &&
+                 SNAPSHOT_COORDINATOR == globalSnapshot.snapshot_source)
+        {
+            /* serving reads routed by a coordinator of the main plane */
+        }
+#endif
         else
         {
             snapshot->local = true;
@@ -5560,4 +5656,329 @@ GlobalTimestamp GetLatestCommitTS(void)
     gts = ShmemVariableCache->latestGTS;
     return gts;
 }
+
+#ifdef __TBASE__
+/*
+ * Has a transaction with a commit GTS at or above the given one committed, or
+ * started writing its commit record, on this node?  Backends publish
+ * MyProc->commitTs before they insert the commit record and fold it into
+ * latestCommitTs under CommitTsLock when they end, so a caller that has just
+ * inserted a WAL record gets true for every such commit that precedes it in
+ * the WAL.  Later commits may also be counted, so the answer is conservative.
+ */
+bool
+CommitTsReachedGTS(GlobalTimestamp gts)
+{
+    ProcArrayStruct *arrayP = procArray;
+    bool        reached;
+    int            index;
+
+    LWLockAcquire(ProcArrayLock, LW_SHARED);
+    LWLockAcquire(CommitTsLock, LW_SHARED);
+
+    reached = (ShmemVariableCache->latestCommitTs >= gts);
+    for (index = 0; !reached && index < arrayP->numProcs; index++)
+    {
+        PGPROC       *proc = &allProcs[arrayP->pgprocnos[index]];
+        GlobalTimestamp commitTs = proc->commitTs;
+
+        if (GlobalTimestampIsValid(commitTs) && commitTs >= gts)
+            reached = true;
+    }
+
+    LWLockRelease(CommitTsLock);
+    LWLockRelease(ProcArrayLock);
+
+    return reached;
+}
+
+/*
+ * Is the transaction of proc, seen committing when we started to wait, still
+ * to insert a commit record with a GTS below the given one?  Local commits
+ * publish FrozenGlobalTimestamp as prepare timestamp before they get their
+ * commit GTS from GTM, and keep delayChkpt set from before they publish it in
+ * commitTs until their commit record is in the WAL.  Prepared transactions
+ * are waited for until COMMIT or ROLLBACK PREPARED is done.
+ */
+static bool
+ProcCommitBelowGTS(int pgprocno, TransactionId xid, GlobalTimestamp gts)
+{
+    PGPROC       *proc = &allProcs[pgprocno];
+    PGXACT       *pgxact = &allPgXact[pgprocno];
+    GlobalTimestamp prepare_ts = pg_atomic_read_u64(&pgxact->prepare_timestamp);
+    GlobalTimestamp commitTs = proc->commitTs;
+
+    if (!TransactionIdEquals(pgxact->xid, xid) ||
+        !GlobalTimestampIsValid(prepare_ts) || prepare_ts >= gts)
+        return false;
+
+    if (prepare_ts != FrozenGlobalTimestamp)
+        return true;
+
+    if (!GlobalTimestampIsValid(commitTs))
+        return true;
+
+    return commitTs < gts && pgxact->delayChkpt;
+}
+
+/*
+ * Wait until no transaction that was committing on this node when we were
+ * called can still insert a commit record with a GTS below the given one.
+ * The caller has got gts from GTM before, so transactions that start to
+ * commit later get a higher GTS and are not waited for.  With
+ * include_prepared, transactions prepared below gts, whose commit GTS may be
+ * below it too, are waited for as well.
+ *
+ * Returns false if that did not happen within timeout_ms.
+ */
+bool
+WaitForCommitsBelowGTS(GlobalTimestamp gts, int timeout_ms, bool include_prepared)
+{
+    ProcArrayStruct *arrayP = procArray;
+    TimestampTz start = GetCurrentTimestamp();
+    int           *pgprocnos;
+    TransactionId *xids;
+    int            nwaits = 0;
+    int            index;
+
+    pgprocnos = (int *) palloc(arrayP->maxProcs * sizeof(int));
+    xids = (TransactionId *) palloc(arrayP->maxProcs * sizeof(TransactionId));
+
+    LWLockAcquire(ProcArrayLock, LW_SHARED);
+    for (index = 0; index < arrayP->numProcs; index++)
+    {
+        int            pgprocno = arrayP->pgprocnos[index];
+        PGXACT       *pgxact = &allPgXact[pgprocno];
+        GlobalTimestamp prepare_ts = pg_atomic_read_u64(&pgxact->prepare_timestamp);
+
+        if (pgxact == MyPgXact)
+            continue;
+        if (!include_prepared && prepare_ts != FrozenGlobalTimestamp)
+            continue;
+        if (!ProcCommitBelowGTS(pgprocno, pgxact->xid, gts))
+            continue;
+
+        pgprocnos[nwaits] = pgprocno;
+        xids[nwaits++] = pgxact->xid;
+    }
+    LWLockRelease(ProcArrayLock);
+
+    while (nwaits > 0)
+    {
+        index = 0;
+        while (index < nwaits)
+        {
+            if (ProcCommitBelowGTS(pgprocnos[index], xids[index], gts))
+            {
+                index++;
+                continue;
+            }
+            nwaits--;
+            pgprocnos[index] = pgprocnos[nwaits];
+            xids[index] = xids[nwaits];
+        }
+
+        if (nwaits == 0 ||
+            TimestampDifferenceExceeds(start, GetCurrentTimestamp(), timeout_ms))
+            break;
+
+        CHECK_FOR_INTERRUPTS();
+        pg_usleep(1000L);
+    }
+
+    pfree(pgprocnos);
+    pfree(xids);
+
+    return nwaits == 0;
+}
+#endif
+
+#ifdef __TBASE__
+/*
+ * A GTS and a WAL position of this datanode such that every commit with a
+ * lower GTS precedes the position in the WAL, except the COMMIT PREPARED of
+ * transactions prepared before it.  A standby that has replayed up to the
+ * position can serve snapshots below the GTS, see tbase_get_replayed_gts().
+ * Returns nulls if commits in progress did not get logged in time.
+ */
+#define SAFE_GTS_WAIT_TIMEOUT 100        /* ms */
+
+Datum
+tbase_get_safe_gts(PG_FUNCTION_ARGS)
+{
+    TupleDesc    tupdesc;
+    Datum        values[2];
+    bool        nulls[2];
+    GlobalTimestamp gts = InvalidGlobalTimestamp;
+
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        elog(ERROR, "return type must be a row type");
+
+    MemSet(nulls, true, sizeof(nulls));
+
+    if (!RecoveryInProgress())
+        gts = GetGlobalTimestampGTM();
+
+    if (GlobalTimestampIsValid(gts) &&
+        WaitForCommitsBelowGTS(gts, SAFE_GTS_WAIT_TIMEOUT, false))
+    {
+        values[0] = Int64GetDatum((int64) gts);
+        values[1] = LSNGetDatum(GetXLogInsertRecPtr());
+        nulls[0] = nulls[1] = false;
+    }
+
+    PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+/*
+ * GTS below which this standby can serve snapshots, given a pair returned by
+ * tbase_get_safe_gts() on its primary, or null if it has not replayed up to
+ * the position yet.  Transactions prepared but not finished here may commit
+ * below the GTS, so it is kept under their prepare GTS.  The pooler of a main
+ * plane coordinator polls standby datanodes for it to know which snapshots
+ * they can serve.
+ */
+Datum
+tbase_get_replayed_gts(PG_FUNCTION_ARGS)
+{
+    XLogRecPtr    lsn = PG_GETARG_LSN(0);
+    GlobalTimestamp gts = (GlobalTimestamp) PG_GETARG_INT64(1);
+    GlobalTimestamp oldest_prepare;
+
+    if (!RecoveryInProgress() || GetXLogReplayRecPtr(NULL) < lsn)
+        PG_RETURN_NULL();
+
+    oldest_prepare = TwoPhaseGetOldestPrepareTimestamp();
+    if (GlobalTimestampIsValid(oldest_prepare) && oldest_prepare <= gts)
+        gts = oldest_prepare - 1;
+
+    PG_RETURN_INT64((int64) gts);
+}
+
+/*
+ * Report, per database, the process whose snapshot holds back the data
+ * horizon vacuum uses there, i.e. the oldest snapshot start timestamp.
+ * Processes not bound to a database hold back all of them and are reported
+ * with a null datid.  holds_shared marks the holder of the node-wide
+ * horizon, which shared catalogs are vacuumed against.
+ */
+Datum
+tbase_get_data_horizon(PG_FUNCTION_ARGS)
+{
+#define DATA_HORIZON_COLS 6
+    ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    ProcArrayStruct *arrayP = procArray;
+    TupleDesc    tupdesc;
+    Tuplestorestate *tupstore;
+    MemoryContext per_query_ctx;
+    MemoryContext oldcontext;
+    Oid           *datids;
+    int           *holders;
+    GlobalTimestamp *tmins;
+    GlobalTimestamp oldest = InvalidGlobalTimestamp;
+    int            ndbs = 0;
+    int            index;
+
+    if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("set-valued function called in context that cannot accept a set")));
+    if (!(rsinfo->allowedModes & SFRM_Materialize))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("materialize mode required, but it is not " \
+                        "allowed in this context")));
+
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        elog(ERROR, "return type must be a row type");
+
+    per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+    oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+    tupstore = tuplestore_begin_heap(true, false, work_mem);
+    rsinfo->returnMode = SFRM_Materialize;
+    rsinfo->setResult = tupstore;
+    rsinfo->setDesc = tupdesc;
+    MemoryContextSwitchTo(oldcontext);
+
+    datids = (Oid *) palloc(sizeof(Oid) * arrayP->maxProcs);
+    holders = (int *) palloc(sizeof(int) * arrayP->maxProcs);
+    tmins = (GlobalTimestamp *) palloc(sizeof(GlobalTimestamp) * arrayP->maxProcs);
+
+    LWLockAcquire(ProcArrayLock, LW_SHARED);
+    for (index = 0; index < arrayP->numProcs; index++)
+    {
+        int            pgprocno = arrayP->pgprocnos[index];
+        volatile PGXACT *pgxact = &allPgXact[pgprocno];
+        Oid            datid = allProcs[pgprocno].databaseId;
+        GlobalTimestamp tmin;
+        int            i;
+
+        tmin = pg_atomic_read_u64(&pgxact->tmin);
+        if (!GlobalTimestampIsValid(tmin))
+            continue;
+
+        if (!GlobalTimestampIsValid(oldest) || tmin < oldest)
+            oldest = tmin;
+
+        for (i = 0; i < ndbs; i++)
+        {
+            if (datids[i] == datid)
+                break;
+        }
+        if (i == ndbs)
+        {
+            datids[ndbs++] = datid;
+        }
+        else if (tmin >= tmins[i])
+        {
+            continue;
+        }
+        holders[i] = pgprocno;
+        tmins[i] = tmin;
+    }
+
+    for (index = 0; index < ndbs; index++)
+    {
+        PGPROC       *proc = &allProcs[holders[index]];
+        PGXACT       *pgxact = &allPgXact[holders[index]];
+        Datum        values[DATA_HORIZON_COLS];
+        bool        nulls[DATA_HORIZON_COLS];
+
+        MemSet(values, 0, sizeof(values));
+        MemSet(nulls, 0, sizeof(nulls));
+
+        if (OidIsValid(datids[index]))
+            values[0] = ObjectIdGetDatum(datids[index]);
+        else
+            nulls[0] = true;
+        /* dummy procs of prepared transactions have no pid */
+        if (proc->pid != 0)
+            values[1] = Int32GetDatum(proc->pid);
+        else
+            nulls[1] = true;
+        if (TransactionIdIsValid(pgxact->xmin))
+            values[2] = TransactionIdGetDatum(pgxact->xmin);
+        else
+            nulls[2] = true;
+        values[3] = Int64GetDatum((int64) tmins[index]);
+        if (tmins[index] >= vacuum_delta * TIMESTAMP_SHIFT)
+            values[4] = Int64GetDatum((int64) (tmins[index] - vacuum_delta * TIMESTAMP_SHIFT));
+        else
+            nulls[4] = true;
+        values[5] = BoolGetDatum(tmins[index] == oldest);
+
+        tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+    }
+    LWLockRelease(ProcArrayLock);
+
+    pfree(datids);
+    pfree(holders);
+    pfree(tmins);
+
+    tuplestore_donestoring(tupstore);
+
+    return (Datum) 0;
+}
+#endif
 #endif
@@ -101,6 +101,7 @@
 #include "miscadmin.h"
 #include "pg_trace.h"
 #include "pgstat.h"
+#include "storage/lmgr.h"
 #include "storage/proc.h"
 #include "storage/procarray.h"
 #include "storage/sinvaladt.h"
@@ -1894,6 +1895,28 @@ WaitOnLock(LOCALLOCK *locallock, ResourceOwner owner)
                        locallock->lock, locallock->tag.mode);
             LWLockRelease(LockHashPartitionLock(locallock->hashcode));
 
+#ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
+            /* canceled by the global deadlock detector, see globaldeadlock.c */
+            if (MyProc->globalDeadlockVictim)
+            {
+                StringInfoData locktagbuf;
+
+                MyProc->globalDeadlockVictim = false;
+                initStringInfo(&locktagbuf);
+                DescribeLockTag(&locktagbuf, &locallock->tag.lock);
+                pgstat_report_deadlock();
+                ereport(ERROR,
+                        (errcode(ERRCODE_T_R_DEADLOCK_DETECTED),
+                         errmsg("global deadlock detected"),
+                         errdetail("Process %d waits for %s on %s; the deadlock spans nodes.",
+                                   MyProcPid,
+                                   GetLockmodeName(locallock->tag.lock.locktag_lockmethodid,
+                                                   locallock->tag.mode),
+                                   locktagbuf.data),
+                         errhint("See server log of the coordinator for the cycle.")));
+            }
+#endif
+
             /*
              * Now that we aren't holding the partition lock, we can give an
              * error report including details about the detected deadlock.
@@ -464,6 +464,13 @@ InitializeLWLocks(void)
 	for (id = 0; id < NUM_CACHE_2PC_PARTITIONS; id++, lock++)
 		LWLockInitialize(&lock->lock, LWTRANCHE_2PC_INFO_CACHE);
 
+#ifdef __TBASE__
+    /* Initialize page compression address map LWLocks in main array */
+    lock = MainLWLockArray + PAGE_COMPRESS_LWLOCK_OFFSET;
+    for (id = 0; id < NUM_PAGE_COMPRESS_PARTITIONS; id++, lock++)
+        LWLockInitialize(&lock->lock, LWTRANCHE_PAGE_COMPRESS);
+#endif
+
     /* Initialize named tranches. */
     if (NamedLWLockTrancheRequests > 0)
     {
@@ -531,6 +538,9 @@ RegisterLWLockTranches(void)
 #endif
 
     LWLockRegisterTranche(LWTRANCHE_TBM, "tbm");
+#ifdef __TBASE__
+    LWLockRegisterTranche(LWTRANCHE_PAGE_COMPRESS, "page_compress");
+#endif
 
     /* Register named tranches. */
     for (i = 0; i < NamedLWLockTrancheRequests; i++)
@@ -395,6 +395,7 @@ InitProcess(void)
     MyProc->commitTs = InvalidGlobalTimestamp;
     pg_atomic_init_u64(&MyPgXact->tmin, InvalidGlobalTimestamp);
     MyProc->hasGlobalXid = false;
+    MyProc->globalDeadlockVictim = false;
 #endif
     MyPgXact->xid = InvalidTransactionId;
     MyPgXact->xmin = InvalidTransactionId;
@@ -238,6 +238,13 @@ static CycleCtr mdckpt_cycle_ctr = 0;
  * mdnblocks().
  */
 #define EXTENSION_DONT_CHECK_SIZE    (1 << 4)
+/*
+ * Create missing segments without zero-padding the ones before them.  Byte
+ * addressed callers (compressed relations) fill their segments out of order,
+ * so a short preceding segment may still be written by a concurrent backend
+ * and must not be overwritten with zeroes.
+ */
+#define EXTENSION_DONT_PAD            (1 << 5)
 
 
 /* local routines */
@@ -1108,6 +1115,191 @@ mdimmedsync(SMgrRelation reln, ForkNumber forknum)
     }
 }
 
+/*
+ *    mdreadbytes() -- Read a byte range of a fork.
+ *
+ *        Unlike mdread(), the range need not be block aligned and may cross
+ *        a segment boundary.  This is used by the compressed storage manager,
+ *        which packs variable-size page images into the main fork.  Bytes
+ *        beyond EOF are returned as zeroes if zero_damaged_pages is on or we
+ *        are InRecovery, like a short read in mdread().
+ */
+void
+mdreadbytes(SMgrRelation reln, ForkNumber forknum, uint64 offset,
+            char *buffer, int nbytes)
+{
+    while (nbytes > 0)
+    {
+        BlockNumber blocknum = (BlockNumber) (offset / BLCKSZ);
+        off_t        seekpos;
+        int            amount;
+        int            nread;
+        MdfdVec    *v;
+
+        v = _mdfd_getseg(reln, forknum, blocknum, false,
+                         EXTENSION_FAIL | EXTENSION_CREATE_RECOVERY |
+                         EXTENSION_DONT_CHECK_SIZE | EXTENSION_DONT_PAD);
+
+        seekpos = (off_t) (offset % ((uint64) BLCKSZ * RELSEG_SIZE));
+        amount = Min((off_t) nbytes, (off_t) BLCKSZ * RELSEG_SIZE - seekpos);
+
+        if (FileSeek(v->mdfd_vfd, seekpos, SEEK_SET) != seekpos)
+            ereport(ERROR,
+                    (errcode_for_file_access(),
+                     errmsg("could not seek to offset " UINT64_FORMAT " in file \"%s\": %m",
+                            offset, FilePathName(v->mdfd_vfd))));
+
+        nread = FileRead(v->mdfd_vfd, buffer, amount, WAIT_EVENT_DATA_FILE_READ);
+        if (nread != amount)
+        {
+            if (nread < 0)
+                ereport(ERROR,
+                        (errcode_for_file_access(),
+                         errmsg("could not read offset " UINT64_FORMAT " in file \"%s\": %m",
+                                offset, FilePathName(v->mdfd_vfd))));
+
+            if (zero_damaged_pages || InRecovery)
+                MemSet(buffer + nread, 0, amount - nread);
+            else
+                ereport(ERROR,
+                        (errcode(ERRCODE_DATA_CORRUPTED),
+                         errmsg("could not read offset " UINT64_FORMAT " in file \"%s\": read only %d of %d bytes",
+                                offset, FilePathName(v->mdfd_vfd),
+                                nread, amount)));
+        }
+
+        offset += amount;
+        buffer += amount;
+        nbytes -= amount;
+    }
+}
+
+/*
+ *    mdwritebytes() -- Write a byte range of a fork, extending it if needed.
+ *
+ *        Segments are created on demand but, unlike mdextend(), the segments
+ *        before them are not padded: concurrent writers may fill byte ranges
+ *        out of order.
+ */
+void
+mdwritebytes(SMgrRelation reln, ForkNumber forknum, uint64 offset,
+             char *buffer, int nbytes, bool skipFsync)
+{
+    while (nbytes > 0)
+    {
+        BlockNumber blocknum = (BlockNumber) (offset / BLCKSZ);
+        off_t        seekpos;
+        int            amount;
+        int            nwritten;
+        MdfdVec    *v;
+
+        v = _mdfd_getseg(reln, forknum, blocknum, skipFsync,
+                         EXTENSION_CREATE | EXTENSION_DONT_CHECK_SIZE |
+                         EXTENSION_DONT_PAD);
+
+        seekpos = (off_t) (offset % ((uint64) BLCKSZ * RELSEG_SIZE));
+        amount = Min((off_t) nbytes, (off_t) BLCKSZ * RELSEG_SIZE - seekpos);
+
+        if (FileSeek(v->mdfd_vfd, seekpos, SEEK_SET) != seekpos)
+            ereport(ERROR,
+                    (errcode_for_file_access(),
+                     errmsg("could not seek to offset " UINT64_FORMAT " in file \"%s\": %m",
+                            offset, FilePathName(v->mdfd_vfd))));
+
+        nwritten = FileWrite(v->mdfd_vfd, buffer, amount, WAIT_EVENT_DATA_FILE_WRITE);
+        if (nwritten != amount)
+        {
+            if (nwritten < 0)
+                ereport(ERROR,
+                        (errcode_for_file_access(),
+                         errmsg("could not write offset " UINT64_FORMAT " in file \"%s\": %m",
+                                offset, FilePathName(v->mdfd_vfd))));
+            /* short write: complain appropriately */
+            ereport(ERROR,
+                    (errcode(ERRCODE_DISK_FULL),
+                     errmsg("could not write offset " UINT64_FORMAT " in file \"%s\": wrote only %d of %d bytes",
+                            offset, FilePathName(v->mdfd_vfd),
+                            nwritten, amount),
+                     errhint("Check free disk space.")));
+        }
+
+        if (!skipFsync && !SmgrIsTemp(reln))
+            register_dirty_segment(reln, forknum, v);
+
+        offset += amount;
+        buffer += amount;
+        nbytes -= amount;
+    }
+}
+
+/*
+ *    mdtruncatebytes() -- Truncate a byte addressed fork to the given length.
+ *
+ *        Segments wholly past the new length are truncated to zero length
+ *        but kept, as in mdtruncate().  Since byte addressed forks may have
+ *        short segments in the middle, every existing segment is visited.
+ */
+void
+mdtruncatebytes(SMgrRelation reln, ForkNumber forknum, uint64 nbytes)
+{
+    BlockNumber segno;
+
+    for (segno = 0;; segno++)
+    {
+        uint64        segstart = (uint64) segno * BLCKSZ * RELSEG_SIZE;
+        off_t        keep;
+        MdfdVec    *v;
+
+        v = _mdfd_getseg(reln, forknum, segno * ((BlockNumber) RELSEG_SIZE),
+                         true, EXTENSION_RETURN_NULL | EXTENSION_DONT_CHECK_SIZE);
+        if (v == NULL)
+            break;
+
+        if (segstart >= nbytes)
+            keep = 0;
+        else if (nbytes - segstart < (uint64) BLCKSZ * RELSEG_SIZE)
+            keep = (off_t) (nbytes - segstart);
+        else
+            continue;
+
+        if (FileTruncate(v->mdfd_vfd, keep, WAIT_EVENT_DATA_FILE_TRUNCATE) < 0)
+            ereport(ERROR,
+                    (errcode_for_file_access(),
+                     errmsg("could not truncate file \"%s\": %m",
+                            FilePathName(v->mdfd_vfd))));
+        if (!SmgrIsTemp(reln))
+            register_dirty_segment(reln, forknum, v);
+    }
+}
+
+/*
+ *    mdimmedsyncbytes() -- Immediately sync a byte addressed fork.
+ *
+ *        Like mdimmedsync(), but visits every existing segment, as the fork
+ *        may have short segments in the middle.
+ */
+void
+mdimmedsyncbytes(SMgrRelation reln, ForkNumber forknum)
+{
+    BlockNumber segno;
+
+    for (segno = 0;; segno++)
+    {
+        MdfdVec    *v;
+
+        v = _mdfd_getseg(reln, forknum, segno * ((BlockNumber) RELSEG_SIZE),
+                         true, EXTENSION_RETURN_NULL | EXTENSION_DONT_CHECK_SIZE);
+        if (v == NULL)
+            break;
+
+        if (FileSync(v->mdfd_vfd, WAIT_EVENT_DATA_FILE_IMMEDIATE_SYNC) < 0)
+            ereport(ERROR,
+                    (errcode_for_file_access(),
+                     errmsg("could not fsync file \"%s\": %m",
+                            FilePathName(v->mdfd_vfd))));
+    }
+}
+
 /*
  *    mdsync() -- Sync previous writes to stable storage.
  */
@@ -2001,7 +2193,8 @@ _mdfd_getseg(SMgrRelation reln, ForkNumber forknum, BlockNumber blkno,
              * matters if in recovery, or if the caller is extending the
              * relation discontiguously, but that can happen in hash indexes.)
              */
-            if (nblocks < ((BlockNumber) RELSEG_SIZE))
+            if (nblocks < ((BlockNumber) RELSEG_SIZE) &&
+                !(behavior & EXTENSION_DONT_PAD))
             {
                 char       *zerobuf = palloc0(BLCKSZ);
 
@@ -0,0 +1,714 @@
+/*
+ * Tencent is pleased to support the open source community by making TBase available.  
+ * 
+ * Copyright (C) 2019 THL A29 Limited, a Tencent company.  All rights reserved.
+ * 
+ * TBase is licensed under the BSD 3-Clause License, except for the third-party component listed below. 
+ * 
+ * A copy of the BSD 3-Clause License is included in this file.
+ * 
+ * Other dependencies and licenses:
+ * 
+ * Open Source Software Licensed Under the PostgreSQL License: 
+ * --------------------------------------------------------------------
+ * 1. Postgres-XL XL9_5_STABLE
+ * Portions Copyright (c) 2015-2016, 2ndQuadrant Ltd
+ * Portions Copyright (c) 2012-2015, TransLattice, Inc.
+ * Portions Copyright (c) 2010-2017, Postgres-XC Development Group
+ * Portions Copyright (c) 1996-2015, The PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, The Regents of the University of California
+ * 
+ * Terms of the PostgreSQL License: 
+ * --------------------------------------------------------------------
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written agreement
+ * is hereby granted, provided that the above copyright notice and this
+ * paragraph and the following two paragraphs appear in all copies.
+ * 
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+ * DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * 
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE UNIVERSITY OF CALIFORNIA HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ * 
+ * 
+ * Terms of the BSD 3-Clause License:
+ * --------------------------------------------------------------------
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of THL A29 Limited nor the names of its contributors may be used to endorse or promote products derived from this software without 
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+ * DAMAGE.
+ * 
+ */
+/*-------------------------------------------------------------------------
+ *
+ * pagecompress.c
+ *      Storage manager for page compressed heap relations.
+ *
+ * The main fork of a compressed relation is a sequence of PC_CHUNK_SIZE
+ * chunks, and the address fork maps each block to a run of chunks, see
+ * pagecompress.h.  All file access goes through the byte addressed
+ * routines of md.c, so segmenting, fsync queueing and unlinking are shared
+ * with plain relations; forks other than the main fork are handed to md.c
+ * unchanged.
+ *
+ * Concurrency: the buffer manager never does I/O on the same block from two
+ * backends at once, so reading or writing a block's address and data needs
+ * no lock.  The header, which holds the logical size and the chunk high
+ * water mark, is only changed under one of the page compress partition
+ * locks.  Each partition has a version in shared memory that is advanced
+ * whenever a header in it is written, so a backend can keep the header in
+ * its SMgrRelation and use it as long as the version did not move.
+ *
+ * Crash safety: data is written before its address, and a run is never
+ * shared by two blocks, so a torn write can only affect a block that WAL
+ * replay rewrites from a full page image anyway.  Writes that change only
+ * hint bits get such an image too, whatever wal_log_hints and checksums
+ * say, see MarkBufferDirtyHint().  After a crash the header
+ * may lag behind addresses that reached disk; the first write during
+ * recovery therefore rescans the map and raises the high water mark past
+ * every run in use.
+ *
+ * Space of a run that outgrows its capacity, or of truncated blocks, is not
+ * reused until the relation is rewritten (VACUUM FULL, CLUSTER) or
+ * truncated to zero.
+ *
+ * IDENTIFICATION
+ *      src/backend/storage/smgr/pagecompress.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "access/xlog.h"
+#include "common/pg_lzcompress.h"
+#include "storage/bufmgr.h"
+#include "storage/bufpage.h"
+#include "storage/lwlock.h"
+#include "storage/pagecompress.h"
+#include "storage/shmem.h"
+#include "utils/memutils.h"
+#include "utils/relcrypt.h"
+#include "storage/relcryptstorage.h"
+
+#define PC_RUN_BYTES(nchunks)    ((int) (nchunks) * PC_CHUNK_SIZE)
+#define PC_CHUNK_OFFSET(chunkno) ((uint64) (chunkno) * PC_CHUNK_SIZE)
+
+/* number of addresses read at once while checking the map in recovery */
+#define PC_ADDRS_PER_READ        (BLCKSZ / sizeof(PageCompressAddr))
+
+/* work space, allocated once in TopMemoryContext */
+static char *pc_image = NULL;        /* chunk header + stored image */
+static char *pc_work = NULL;        /* compressed or decrypted image */
+
+/* header versions, one per page compress partition lock */
+static pg_atomic_uint64 *PageCompressHeaderVersions = NULL;
+
+static void pc_init_workspace(void);
+static int    pc_partition(SMgrRelation reln);
+static LWLock *pc_partition_lock(SMgrRelation reln);
+static void pc_read_header(SMgrRelation reln, PageCompressHeader *hdr);
+static void pc_write_header(SMgrRelation reln, PageCompressHeader *hdr,
+                bool skipFsync);
+static void pc_read_addr(SMgrRelation reln, BlockNumber blocknum,
+             PageCompressAddr *addr);
+static void pc_write_addr(SMgrRelation reln, BlockNumber blocknum,
+              PageCompressAddr *addr, bool skipFsync);
+static void pc_check_map(SMgrRelation reln);
+static int    pc_build_image(SMgrRelation reln, char *buffer);
+static void pc_write_page(SMgrRelation reln, BlockNumber blocknum,
+              char *buffer, bool skipFsync, bool extend);
+
+static void
+pc_init_workspace(void)
+{
+    if (pc_image == NULL)
+        pc_image = MemoryContextAlloc(TopMemoryContext,
+                                      PC_RUN_BYTES(PC_MAX_CHUNKS));
+    if (pc_work == NULL)
+        pc_work = MemoryContextAlloc(TopMemoryContext,
+                                     PC_RUN_BYTES(PC_MAX_CHUNKS));
+}
+
+Size
+PageCompressShmemSize(void)
+{
+    return mul_size(NUM_PAGE_COMPRESS_PARTITIONS, sizeof(pg_atomic_uint64));
+}
+
+void
+PageCompressShmemInit(void)
+{
+    bool        found;
+    int            i;
+
+    PageCompressHeaderVersions = (pg_atomic_uint64 *)
+        ShmemInitStruct("Page Compress Header Versions",
+                        PageCompressShmemSize(), &found);
+
+    if (!found)
+    {
+        /* zero is never a valid version, see smgropen() */
+        for (i = 0; i < NUM_PAGE_COMPRESS_PARTITIONS; i++)
+            pg_atomic_init_u64(&PageCompressHeaderVersions[i], 1);
+    }
+}
+
+static int
+pc_partition(SMgrRelation reln)
+{
+    uint32        hashcode;
+
+    hashcode = DatumGetUInt32(hash_any((const unsigned char *) &reln->smgr_rnode.node,
+                                       sizeof(RelFileNode)));
+
+    return hashcode % NUM_PAGE_COMPRESS_PARTITIONS;
+}
+
+static LWLock *
+pc_partition_lock(SMgrRelation reln)
+{
+    return &MainLWLockArray[PAGE_COMPRESS_LWLOCK_OFFSET +
+                            pc_partition(reln)].lock;
+}
+
+/*
+ * Read the header, from the copy in the SMgrRelation if no header of the
+ * partition was written since.  Caller holds the partition lock.
+ */
+static void
+pc_read_header(SMgrRelation reln, PageCompressHeader *hdr)
+{
+    uint64        version;
+
+    version = pg_atomic_read_u64(&PageCompressHeaderVersions[pc_partition(reln)]);
+    if (reln->pc_header_version == version)
+    {
+        hdr->pch_magic = PC_MAGIC;
+        hdr->pch_version = PC_VERSION;
+        hdr->pch_chunk_size = PC_CHUNK_SIZE;
+        hdr->pch_nblocks = reln->pc_nblocks;
+        hdr->pch_allocated_chunks = reln->pc_allocated_chunks;
+        return;
+    }
+
+    mdreadbytes(reln, PAGE_COMPRESS_FORKNUM, 0, (char *) hdr,
+                sizeof(PageCompressHeader));
+
+    if (hdr->pch_magic != PC_MAGIC || hdr->pch_version != PC_VERSION ||
+        hdr->pch_chunk_size != PC_CHUNK_SIZE)
+        ereport(ERROR,
+                (errcode(ERRCODE_DATA_CORRUPTED),
+                 errmsg("invalid page compression header in \"%s\"",
+                        relpath(reln->smgr_rnode, PAGE_COMPRESS_FORKNUM))));
+
+    reln->pc_nblocks = hdr->pch_nblocks;
+    reln->pc_allocated_chunks = hdr->pch_allocated_chunks;
+    reln->pc_header_version = version;
+}
+
+/*
+ * Write the header and move the version of its partition, so that every
+ * other backend reads it again.  Caller holds the partition lock exclusively.
+ */
+static void
+pc_write_header(SMgrRelation reln, PageCompressHeader *hdr, bool skipFsync)
+{
+    mdwritebytes(reln, PAGE_COMPRESS_FORKNUM, 0, (char *) hdr,
+                 sizeof(PageCompressHeader), skipFsync);
+
+    reln->pc_nblocks = hdr->pch_nblocks;
+    reln->pc_allocated_chunks = hdr->pch_allocated_chunks;
+    reln->pc_header_version =
+        pg_atomic_add_fetch_u64(&PageCompressHeaderVersions[pc_partition(reln)], 1);
+}
+
+static void
+pc_read_addr(SMgrRelation reln, BlockNumber blocknum, PageCompressAddr *addr)
+{
+    mdreadbytes(reln, PAGE_COMPRESS_FORKNUM, PC_ADDR_OFFSET(blocknum),
+                (char *) addr, sizeof(PageCompressAddr));
+
+    if (addr->pca_nchunks > PC_MAX_CHUNKS)
+        ereport(ERROR,
+                (errcode(ERRCODE_DATA_CORRUPTED),
+                 errmsg("invalid page compression address for block %u of relation %s",
+                        blocknum, relpath(reln->smgr_rnode, MAIN_FORKNUM))));
+}
+
+static void
+pc_write_addr(SMgrRelation reln, BlockNumber blocknum, PageCompressAddr *addr,
+              bool skipFsync)
+{
+    mdwritebytes(reln, PAGE_COMPRESS_FORKNUM, PC_ADDR_OFFSET(blocknum),
+                 (char *) addr, sizeof(PageCompressAddr), skipFsync);
+}
+
+/*
+ * After a crash the header may not cover runs whose addresses did reach
+ * disk.  Raise the high water mark past all of them before allocating
+ * anything, so that no two blocks ever share a run.
+ */
+static void
+pc_check_map(SMgrRelation reln)
+{
+    LWLock       *lock = pc_partition_lock(reln);
+    PageCompressHeader hdr;
+    PageCompressAddr addrs[PC_ADDRS_PER_READ];
+    BlockNumber blkno;
+    uint32        maxchunk = 0;
+
+    LWLockAcquire(lock, LW_EXCLUSIVE);
+    pc_read_header(reln, &hdr);
+
+    for (blkno = 0; blkno < hdr.pch_nblocks; blkno += PC_ADDRS_PER_READ)
+    {
+        int            n = Min(PC_ADDRS_PER_READ, hdr.pch_nblocks - blkno);
+        int            i;
+
+        mdreadbytes(reln, PAGE_COMPRESS_FORKNUM, PC_ADDR_OFFSET(blkno),
+                    (char *) addrs, n * sizeof(PageCompressAddr));
+
+        for (i = 0; i < n; i++)
+        {
+            if (addrs[i].pca_nchunks > 0 &&
+                addrs[i].pca_chunkno + addrs[i].pca_nchunks > maxchunk)
+                maxchunk = addrs[i].pca_chunkno + addrs[i].pca_nchunks;
+        }
+    }
+
+    if (maxchunk > hdr.pch_allocated_chunks)
+    {
+        elog(LOG, "page compression: raising chunk high water mark of %s from %u to %u",
+             relpath(reln->smgr_rnode, MAIN_FORKNUM),
+             hdr.pch_allocated_chunks, maxchunk);
+        hdr.pch_allocated_chunks = maxchunk;
+        pc_write_header(reln, &hdr, false);
+    }
+    LWLockRelease(lock);
+
+    reln->pc_map_checked = true;
+}
+
+/*
+ * Build the stored image of a page in pc_image: the chunk header followed by
+ * the page compressed with pglz, or the raw page if that does not save a
+ * chunk, encrypted when the relation is under transparent encryption.
+ * Returns the number of chunks needed.
+ */
+static int
+pc_build_image(SMgrRelation reln, char *buffer)
+{
+    PageCompressChunkHeader *chdr = (PageCompressChunkHeader *) pc_image;
+    char       *payload = pc_image + SizeOfPageCompressChunkHeader;
+    int            maxpayload = PC_RUN_BYTES(PC_MAX_CHUNKS) - SizeOfPageCompressChunkHeader;
+    char       *src;
+    int32        len;
+
+    len = pglz_compress(buffer, BLCKSZ, pc_work, PGLZ_strategy_always);
+    if (len >= 0 &&
+        len + SizeOfPageCompressChunkHeader <= PC_RUN_BYTES(PC_CHUNKS_PER_PAGE - 1))
+    {
+        chdr->pcc_method = PC_METHOD_PGLZ;
+        src = pc_work;
+    }
+    else
+    {
+        chdr->pcc_method = PC_METHOD_NONE;
+        src = buffer;
+        len = BLCKSZ;
+    }
+    chdr->pcc_rawlen = (uint16) len;
+    chdr->pcc_reserved = 0;
+    chdr->pcc_algo_id = TRANSP_CRYPT_INVALID_ALGORITHM_ID;
+
+#ifdef _MLS_
+    if (REL_CRYPT_ENTRY_IS_VALID(&(reln->smgr_relcrypt)))
+    {
+        int            storedlen;
+
+        storedlen = rel_crypt_buffer_encrypt(&(reln->smgr_relcrypt), src, len,
+                                             payload, maxpayload);
+        if (storedlen < 0)
+            elog(ERROR, "encrypted page image of relation %s exceeds %d bytes",
+                 relpath(reln->smgr_rnode, MAIN_FORKNUM), maxpayload);
+        chdr->pcc_algo_id = reln->smgr_relcrypt.algo_id;
+        len = storedlen;
+    }
+    else
+#endif
+        memcpy(payload, src, len);
+
+    chdr->pcc_storedlen = (uint16) len;
+
+    len += SizeOfPageCompressChunkHeader;
+    MemSet(pc_image + len, 0, PC_RUN_BYTES(PC_MAX_CHUNKS) - len);
+
+    return (len + PC_CHUNK_SIZE - 1) / PC_CHUNK_SIZE;
+}
+
+/*
+ * Store one page.  The page is rewritten in place if its image fits the
+ * run it already owns, otherwise a new run is allocated at the high water
+ * mark.  When extending, the logical size is raised as well; new all-zero
+ * pages are recorded as holes and take no space.
+ */
+static void
+pc_write_page(SMgrRelation reln, BlockNumber blocknum, char *buffer,
+              bool skipFsync, bool extend)
+{
+    LWLock       *lock = pc_partition_lock(reln);
+    PageCompressHeader hdr;
+    PageCompressAddr addr;
+    int            need = 0;
+    bool        newblock = false;
+
+    pc_init_workspace();
+
+    if (InRecovery && !reln->pc_map_checked)
+        pc_check_map(reln);
+
+    if (extend)
+    {
+        LWLockAcquire(lock, LW_SHARED);
+        pc_read_header(reln, &hdr);
+        LWLockRelease(lock);
+        newblock = (blocknum >= hdr.pch_nblocks);
+    }
+
+    if (newblock)
+        MemSet(&addr, 0, sizeof(addr));
+    else
+        pc_read_addr(reln, blocknum, &addr);
+
+    if (!(newblock && PageIsNew(buffer)))
+        need = pc_build_image(reln, buffer);
+
+    if (need > addr.pca_nchunks || newblock)
+    {
+        LWLockAcquire(lock, LW_EXCLUSIVE);
+        pc_read_header(reln, &hdr);
+        if (need > addr.pca_nchunks)
+        {
+            addr.pca_chunkno = hdr.pch_allocated_chunks;
+            addr.pca_nchunks = (uint16) need;
+            hdr.pch_allocated_chunks += need;
+        }
+        if (blocknum >= hdr.pch_nblocks)
+            hdr.pch_nblocks = blocknum + 1;
+        pc_write_header(reln, &hdr, skipFsync);
+        LWLockRelease(lock);
+    }
+
+    if (need > 0)
+        mdwritebytes(reln, MAIN_FORKNUM, PC_CHUNK_OFFSET(addr.pca_chunkno),
+                     pc_image, PC_RUN_BYTES(need), skipFsync);
+
+    pc_write_addr(reln, blocknum, &addr, skipFsync);
+}
+
+/*
+ *    pccreate() -- Create a fork.  A new address fork gets its header.
+ */
+void
+pccreate(SMgrRelation reln, ForkNumber forknum, bool isRedo)
+{
+    mdcreate(reln, forknum, isRedo);
+
+    if (forknum == PAGE_COMPRESS_FORKNUM &&
+        mdnblocks(reln, PAGE_COMPRESS_FORKNUM) == 0)
+    {
+        char       *block = palloc0(BLCKSZ);
+        PageCompressHeader *hdr = (PageCompressHeader *) block;
+
+        hdr->pch_magic = PC_MAGIC;
+        hdr->pch_version = PC_VERSION;
+        hdr->pch_chunk_size = PC_CHUNK_SIZE;
+        hdr->pch_nblocks = 0;
+        hdr->pch_allocated_chunks = 0;
+
+        /* a reused relfilenode must not keep the header of the old file */
+        LWLockAcquire(pc_partition_lock(reln), LW_EXCLUSIVE);
+        mdextend(reln, PAGE_COMPRESS_FORKNUM, 0, block, false);
+        pg_atomic_add_fetch_u64(&PageCompressHeaderVersions[pc_partition(reln)], 1);
+        LWLockRelease(pc_partition_lock(reln));
+        pfree(block);
+    }
+}
+
+/*
+ *    pcextend() -- Add a block to the relation.
+ */
+void
+pcextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+         char *buffer, bool skipFsync)
+{
+    if (forknum != MAIN_FORKNUM)
+    {
+        mdextend(reln, forknum, blocknum, buffer, skipFsync);
+        return;
+    }
+
+    /* same limit as md.c */
+    if (blocknum == InvalidBlockNumber)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("cannot extend file \"%s\" beyond %u blocks",
+                        relpath(reln->smgr_rnode, forknum),
+                        InvalidBlockNumber)));
+
+    pc_write_page(reln, blocknum, buffer, skipFsync, true);
+}
+
+/*
+ *    pcprefetch() -- Nothing to do for the main fork, the position of a
+ *        block is only known after reading its address.
+ */
+void
+pcprefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum)
+{
+    if (forknum != MAIN_FORKNUM)
+        mdprefetch(reln, forknum, blocknum);
+}
+
+/*
+ *    pcread() -- Read and uncompress the specified block.
+ */
+void
+pcread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+       char *buffer)
+{
+    PageCompressAddr addr;
+    PageCompressChunkHeader *chdr;
+    char       *payload;
+    char       *src;
+    bool        ok;
+
+    if (forknum != MAIN_FORKNUM)
+    {
+        mdread(reln, forknum, blocknum, buffer);
+        return;
+    }
+
+    pc_init_workspace();
+
+    pc_read_addr(reln, blocknum, &addr);
+    if (addr.pca_nchunks == 0)
+    {
+        MemSet(buffer, 0, BLCKSZ);
+        return;
+    }
+
+    mdreadbytes(reln, MAIN_FORKNUM, PC_CHUNK_OFFSET(addr.pca_chunkno),
+                pc_image, PC_RUN_BYTES(addr.pca_nchunks));
+
+    chdr = (PageCompressChunkHeader *) pc_image;
+    payload = pc_image + SizeOfPageCompressChunkHeader;
+    src = payload;
+
+    ok = (chdr->pcc_storedlen + SizeOfPageCompressChunkHeader <= PC_RUN_BYTES(addr.pca_nchunks) &&
+          chdr->pcc_rawlen <= BLCKSZ);
+    if (ok && chdr->pcc_method == PC_METHOD_NONE)
+        ok = (chdr->pcc_rawlen == BLCKSZ);
+    else if (ok)
+        ok = (chdr->pcc_method == PC_METHOD_PGLZ);
+
+    if (ok && TRANSP_CRYPT_ALGO_ID_IS_VALID(chdr->pcc_algo_id))
+    {
+#ifdef _MLS_
+        rel_crypt_buffer_decrypt(chdr->pcc_algo_id, payload, chdr->pcc_storedlen,
+                                 pc_work, chdr->pcc_rawlen);
+        src = pc_work;
+#else
+        ok = false;
+#endif
+    }
+
+    if (ok && chdr->pcc_method == PC_METHOD_PGLZ)
+        ok = (pglz_decompress(src, chdr->pcc_rawlen, buffer, BLCKSZ) == BLCKSZ);
+    else if (ok)
+        memcpy(buffer, src, BLCKSZ);
+
+    /* nothing of a damaged image can be saved, not even by replay */
+    if (!ok)
+        ereport(ERROR,
+                (errcode(ERRCODE_DATA_CORRUPTED),
+                 errmsg("could not uncompress block %u in file \"%s\"",
+                        blocknum, relpath(reln->smgr_rnode, forknum))));
+}
+
+/*
+ *    pcwrite() -- Compress and write the supplied block.
+ */
+void
+pcwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+        char *buffer, bool skipFsync)
+{
+    if (forknum != MAIN_FORKNUM)
+    {
+        mdwrite(reln, forknum, blocknum, buffer, skipFsync);
+        return;
+    }
+
+    pc_write_page(reln, blocknum, buffer, skipFsync, false);
+}
+
+/*
+ *    pcwriteback() -- Runs of the main fork are small and scattered, leave
+ *        them to the kernel.
+ */
+void
+pcwriteback(SMgrRelation reln, ForkNumber forknum,
+            BlockNumber blocknum, BlockNumber nblocks)
+{
+    if (forknum != MAIN_FORKNUM)
+        mdwriteback(reln, forknum, blocknum, nblocks);
+}
+
+/*
+ *    pcnblocks() -- Get the logical number of blocks of the main fork.
+ *
+ *        Callers that must see every extension done before (relation
+ *        extension lock, buffer lock) synchronized through a lock, so an
+ *        unlocked look at the version suffices when the header is cached.
+ */
+BlockNumber
+pcnblocks(SMgrRelation reln, ForkNumber forknum)
+{
+    LWLock       *lock;
+    PageCompressHeader hdr;
+
+    if (forknum != MAIN_FORKNUM)
+        return mdnblocks(reln, forknum);
+
+    if (reln->pc_header_version ==
+        pg_atomic_read_u64(&PageCompressHeaderVersions[pc_partition(reln)]))
+        return reln->pc_nblocks;
+
+    lock = pc_partition_lock(reln);
+    LWLockAcquire(lock, LW_SHARED);
+    pc_read_header(reln, &hdr);
+    LWLockRelease(lock);
+
+    return hdr.pch_nblocks;
+}
+
+/*
+ *    pctruncate() -- Truncate the main fork to the given number of blocks.
+ *
+ *        Only the addresses are dropped; chunks are given back only when the
+ *        relation is truncated to zero.
+ */
+void
+pctruncate(SMgrRelation reln, ForkNumber forknum, BlockNumber nblocks)
+{
+    LWLock       *lock;
+    PageCompressHeader hdr;
+
+    if (forknum != MAIN_FORKNUM)
+    {
+        mdtruncate(reln, forknum, nblocks);
+        return;
+    }
+
+    lock = pc_partition_lock(reln);
+    LWLockAcquire(lock, LW_EXCLUSIVE);
+    pc_read_header(reln, &hdr);
+
+    if (nblocks > hdr.pch_nblocks)
+    {
+        LWLockRelease(lock);
+
+        /* Bogus request ... but no complaint if InRecovery, as in md.c */
+        if (InRecovery)
+            return;
+        ereport(ERROR,
+                (errmsg("could not truncate file \"%s\" to %u blocks: it's only %u blocks now",
+                        relpath(reln->smgr_rnode, forknum),
+                        nblocks, hdr.pch_nblocks)));
+    }
+
+    hdr.pch_nblocks = nblocks;
+    if (nblocks == 0)
+    {
+        hdr.pch_allocated_chunks = 0;
+        mdtruncatebytes(reln, MAIN_FORKNUM, 0);
+    }
+    pc_write_header(reln, &hdr, false);
+    mdtruncatebytes(reln, PAGE_COMPRESS_FORKNUM, PC_ADDR_OFFSET(nblocks));
+
+    LWLockRelease(lock);
+}
+
+/*
+ *    pcimmedsync() -- Immediately sync a fork, with its addresses.
+ */
+void
+pcimmedsync(SMgrRelation reln, ForkNumber forknum)
+{
+    if (forknum != MAIN_FORKNUM)
+    {
+        mdimmedsync(reln, forknum);
+        return;
+    }
+
+    mdimmedsyncbytes(reln, MAIN_FORKNUM);
+    mdimmedsyncbytes(reln, PAGE_COMPRESS_FORKNUM);
+}
+
+#ifdef _SHARDING_
+/*
+ *    pcdealloc() -- Drop the pages of an extent, they read back as zeroes.
+ */
+void
+pcdealloc(SMgrRelation reln, ForkNumber forknum, BlockNumber from_blk)
+{
+    PageCompressAddr addrs[PAGES_PER_EXTENTS];
+    BlockNumber nblocks;
+    int            n;
+
+    if (forknum != MAIN_FORKNUM)
+    {
+        mddealloc(reln, forknum, from_blk);
+        return;
+    }
+
+    if (from_blk % PAGES_PER_EXTENTS != 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("deallocing must begin with first block of a extent, but from_blk is %d",
+                        from_blk)));
+
+    nblocks = pcnblocks(reln, forknum);
+    if (from_blk >= nblocks)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("cannot dealloc file \"%s\" beyond the end of file",
+                        relpath(reln->smgr_rnode, forknum))));
+
+    n = Min(PAGES_PER_EXTENTS, nblocks - from_blk);
+    MemSet(addrs, 0, sizeof(addrs));
+    mdwritebytes(reln, PAGE_COMPRESS_FORKNUM, PC_ADDR_OFFSET(from_blk),
+                 (char *) addrs, n * sizeof(PageCompressAddr), false);
+    mdimmedsyncbytes(reln, PAGE_COMPRESS_FORKNUM);
+}
+#endif
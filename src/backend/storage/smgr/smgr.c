@@ -21,6 +21,10 @@
 #include "storage/bufmgr.h"
 #include "storage/ipc.h"
 #include "storage/smgr.h"
+#ifdef __TBASE__
+#include "access/transam.h"
+#include "storage/pagecompress.h"
+#endif
 #include "utils/hsearch.h"
 #include "utils/inval.h"
 #ifdef _MLS_
@@ -80,10 +84,28 @@ static const f_smgr smgrsw[] = {
         ,mddealloc, mdrealloc
 #endif
     }
+#ifdef __TBASE__
+    ,
+    /* compressed pages, see pagecompress.c; fsync is queued through md.c */
+    {NULL, NULL, mdclose, pccreate, mdexists, mdunlink, pcextend,
+        pcprefetch, pcread, pcwrite, pcwriteback, pcnblocks, pctruncate,
+        pcimmedsync, NULL, NULL, NULL
+#ifdef _SHARDING_
+        ,pcdealloc, mdrealloc
+#endif
+    }
+#endif
 };
 
 static const int NSmgr = lengthof(smgrsw);
 
+/* storage manager for I/O; the close, exists and unlink callbacks are shared */
+#ifdef __TBASE__
+#define SMGR_WHICH(reln)    SmgrWhich(reln)
+#else
+#define SMGR_WHICH(reln)    ((reln)->smgr_which)
+#endif
+
 
 /*
  * Each backend has a hashtable that stores all extant SMgrRelation objects.
@@ -195,6 +217,17 @@ smgropen(RelFileNode rnode, BackendId backend)
         /* mark it not open */
         for (forknum = 0; forknum <= MAX_FORKNUM; forknum++)
             reln->md_num_open_segs[forknum] = 0;
+#ifdef __TBASE__
+        /*
+         * A relation is page compressed iff it has an address fork.  Catalogs
+         * and temp relations are never compressed; for others the fork is
+         * looked for on first I/O, many opens (unlink, buffer drop) do none.
+         */
+        reln->pc_probed = (rnode.relNode < FirstNormalObjectId ||
+                           backend != InvalidBackendId);
+        reln->pc_map_checked = false;
+        reln->pc_header_version = 0;
+#endif
 
 #ifdef _MLS_
         rel_crypt_struct_init(&(reln->smgr_relcrypt));
@@ -317,6 +350,24 @@ smgrexists(SMgrRelation reln, ForkNumber forknum)
     return (*(smgrsw[reln->smgr_which].smgr_exists)) (reln, forknum);
 }
 
+#ifdef __TBASE__
+/*
+ *    smgrprobe() -- Choose the storage manager of a relation that might be
+ *        page compressed, by looking for its address fork.  The result
+ *        holds for the life of the SMgrRelation.
+ */
+int
+smgrprobe(SMgrRelation reln)
+{
+    if (reln->md_num_open_segs[PAGE_COMPRESS_FORKNUM] > 0 ||
+        mdexists(reln, PAGE_COMPRESS_FORKNUM))
+        reln->smgr_which = SMGR_PAGE_COMPRESS;
+    reln->pc_probed = true;
+
+    return reln->smgr_which;
+}
+#endif
+
 /*
  *    smgrclose() -- Close and delete an SMgrRelation object.
  */
@@ -407,6 +458,15 @@ smgrcreate(SMgrRelation reln, ForkNumber forknum, bool isRedo)
      * Exit quickly in WAL replay mode if we've already opened the file. If
      * it's open, it surely must exist.
      */
+#ifdef __TBASE__
+    /* creating the address fork turns the relation into a compressed one */
+    if (forknum == PAGE_COMPRESS_FORKNUM)
+    {
+        reln->smgr_which = SMGR_PAGE_COMPRESS;
+        reln->pc_probed = true;
+    }
+#endif
+
     if (isRedo && reln->md_num_open_segs[forknum] > 0)
         return;
 
@@ -628,7 +688,7 @@ void
 smgrextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
            char *buffer, bool skipFsync)
 {
-    (*(smgrsw[reln->smgr_which].smgr_extend)) (reln, forknum, blocknum,
+    (*(smgrsw[SMGR_WHICH(reln)].smgr_extend)) (reln, forknum, blocknum,
                                                buffer, skipFsync);
 }
 
@@ -638,7 +698,7 @@ smgrextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 void
 smgrprefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum)
 {
-    (*(smgrsw[reln->smgr_which].smgr_prefetch)) (reln, forknum, blocknum);
+    (*(smgrsw[SMGR_WHICH(reln)].smgr_prefetch)) (reln, forknum, blocknum);
 }
 
 /*
@@ -653,7 +713,7 @@ void
 smgrread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
          char *buffer)
 {
-    (*(smgrsw[reln->smgr_which].smgr_read)) (reln, forknum, blocknum, buffer);
+    (*(smgrsw[SMGR_WHICH(reln)].smgr_read)) (reln, forknum, blocknum, buffer);
 }
 
 /*
@@ -675,7 +735,7 @@ void
 smgrwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
           char *buffer, bool skipFsync)
 {
-    (*(smgrsw[reln->smgr_which].smgr_write)) (reln, forknum, blocknum,
+    (*(smgrsw[SMGR_WHICH(reln)].smgr_write)) (reln, forknum, blocknum,
                                               buffer, skipFsync);
 }
 
@@ -688,7 +748,7 @@ void
 smgrwriteback(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
               BlockNumber nblocks)
 {
-    (*(smgrsw[reln->smgr_which].smgr_writeback)) (reln, forknum, blocknum,
+    (*(smgrsw[SMGR_WHICH(reln)].smgr_writeback)) (reln, forknum, blocknum,
                                                   nblocks);
 }
 
@@ -699,7 +759,7 @@ smgrwriteback(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 BlockNumber
 smgrnblocks(SMgrRelation reln, ForkNumber forknum)
 {
-    return (*(smgrsw[reln->smgr_which].smgr_nblocks)) (reln, forknum);
+    return (*(smgrsw[SMGR_WHICH(reln)].smgr_nblocks)) (reln, forknum);
 }
 
 /*
@@ -732,7 +792,7 @@ smgrtruncate(SMgrRelation reln, ForkNumber forknum, BlockNumber nblocks)
     /*
      * Do the truncation.
      */
-    (*(smgrsw[reln->smgr_which].smgr_truncate)) (reln, forknum, nblocks);
+    (*(smgrsw[SMGR_WHICH(reln)].smgr_truncate)) (reln, forknum, nblocks);
 }
 
 /*
@@ -761,7 +821,7 @@ smgrtruncate(SMgrRelation reln, ForkNumber forknum, BlockNumber nblocks)
 void
 smgrimmedsync(SMgrRelation reln, ForkNumber forknum)
 {
-    (*(smgrsw[reln->smgr_which].smgr_immedsync)) (reln, forknum);
+    (*(smgrsw[SMGR_WHICH(reln)].smgr_immedsync)) (reln, forknum);
 }
 
 
@@ -815,14 +875,14 @@ void
 smgrdealloc(SMgrRelation reln, ForkNumber forknum, BlockNumber from_blk)
 {
 #ifndef DISABLE_FALLOCATE
-    (*(smgrsw[reln->smgr_which].smgr_dealloc)) (reln, forknum, from_blk);
+    (*(smgrsw[SMGR_WHICH(reln)].smgr_dealloc)) (reln, forknum, from_blk);
 #endif
 }
 
 void
 smgrrealloc(SMgrRelation reln, ForkNumber forknum, BlockNumber from_blk)
 {
-    (*(smgrsw[reln->smgr_which].smgr_realloc)) (reln, forknum, from_blk);
+    (*(smgrsw[SMGR_WHICH(reln)].smgr_realloc)) (reln, forknum, from_blk);
 }
 #endif
 
@@ -5849,6 +5849,12 @@ PostgresMain(int argc, char *argv[],
 			case 'o':       /* session id */
 				{
 					const char *sessionid = pq_getmsgstring(&input_message);
+					
+					/* query id of the coordinator statement, if sent */
+					if (input_message.cursor < input_message.len)
+						PGXCQueryId = (uint32) pq_getmsgint(&input_message, 4);
+					else
+						PGXCQueryId = 0;
 					pq_getmsgend(&input_message);
 					strncpy((char *) PGXCSessionId, sessionid, NAMEDATALEN);
 				}
@@ -5994,9 +6000,16 @@ PostgresMain(int argc, char *argv[],
                 {
                     int command;
                     char *id;
+#ifdef __TBASE__
+                    GlobalTimestamp barrier_gts = InvalidGlobalTimestamp;
+#endif
 
                     command = pq_getmsgbyte(&input_message);
                     id = (char *) pq_getmsgstring(&input_message);
+#ifdef __TBASE__
+                    if (command == CREATE_BARRIER_GTS)
+                        barrier_gts = (GlobalTimestamp) pq_getmsgint64(&input_message);
+#endif
                     pq_getmsgend(&input_message);
 
                     switch (command)
@@ -6013,6 +6026,12 @@ PostgresMain(int argc, char *argv[],
                             ProcessCreateBarrierExecute(id);
                             break;
 
+#ifdef __TBASE__
+                        case CREATE_BARRIER_GTS:
+                            ProcessCreateBarrierGTS(id, barrier_gts);
+                            break;
+#endif
+
                         default:
                             ereport(ERROR,
                                     (errcode(ERRCODE_INTERNAL_ERROR),
@@ -4321,6 +4321,15 @@ ProcessUtilitySlow(ParseState *pstate,
                                                  false, false,
                                                  RangeVarCallbackOwnsRelation,
                                                  NULL);
+#ifdef __TBASE__
+                    if (!stmt->concurrent)
+                    {
+                        rel = heap_open(relid, NoLock);
+                        CheckBlockingDDL(rel, BLOCKING_DDL_INDEX);
+                        heap_close(rel, NoLock);
+                        rel = NULL;
+                    }
+#endif
 #if 0
                     /* could not create index on interval child table directly */
                     if (OidIsValid(relid))
@@ -15,6 +15,7 @@
 #include "postgres.h"
 
 #include "access/htup_details.h"
+#include "access/xlog.h"
 #include "catalog/pg_authid.h"
 #include "catalog/pg_type.h"
 #include "common/ip.h"
@@ -28,6 +29,14 @@
 #include "utils/builtins.h"
 #include "utils/inet.h"
 #include "utils/timestamp.h"
+#ifdef __TBASE__
+#include "executor/executor.h"
+#include "nodes/makefuncs.h"
+#include "pgxc/execRemote.h"
+#include "pgxc/locator.h"
+#include "pgxc/pgxc.h"
+#include "utils/snapmgr.h"
+#endif
 
 #define UINT32_ACCESS_ONCE(var)         ((uint32)(*((volatile uint32 *)&(var))))
 
@@ -467,6 +476,10 @@ pg_stat_get_progress_info(PG_FUNCTION_ARGS)
     /* Translate command name into command type code. */
     if (pg_strcasecmp(cmd, "VACUUM") == 0)
         cmdtype = PROGRESS_COMMAND_VACUUM;
+#ifdef __TBASE__
+    else if (pg_strcasecmp(cmd, "CREATE INDEX") == 0)
+        cmdtype = PROGRESS_COMMAND_CREATE_INDEX;
+#endif
     else
         ereport(ERROR,
                 (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
@@ -1861,3 +1874,168 @@ pg_stat_get_archiver(PG_FUNCTION_ARGS)
     PG_RETURN_DATUM(HeapTupleGetDatum(
                                       heap_form_tuple(tupdesc, values, nulls)));
 }
+
+#ifdef __TBASE__
+Datum
+pg_stat_get_group_commit(PG_FUNCTION_ARGS)
+{
+    TupleDesc    tupdesc;
+    Datum        values[10];
+    bool        nulls[10];
+    GroupCommitStats stats;
+
+    /* Initialise values and NULL flags arrays */
+    MemSet(values, 0, sizeof(values));
+    MemSet(nulls, 0, sizeof(nulls));
+
+    /* Initialise attributes information in the tuple descriptor */
+    tupdesc = CreateTemplateTupleDesc(10, false);
+    TupleDescInitEntry(tupdesc, (AttrNumber) 1, "requests",
+                       INT8OID, -1, 0);
+    TupleDescInitEntry(tupdesc, (AttrNumber) 2, "flushes",
+                       INT8OID, -1, 0);
+    TupleDescInitEntry(tupdesc, (AttrNumber) 3, "delayed_flushes",
+                       INT8OID, -1, 0);
+    TupleDescInitEntry(tupdesc, (AttrNumber) 4, "delay_time",
+                       FLOAT8OID, -1, 0);
+    TupleDescInitEntry(tupdesc, (AttrNumber) 5, "queue_time",
+                       FLOAT8OID, -1, 0);
+    TupleDescInitEntry(tupdesc, (AttrNumber) 6, "max_queue_time",
+                       FLOAT8OID, -1, 0);
+    TupleDescInitEntry(tupdesc, (AttrNumber) 7, "avg_interval",
+                       FLOAT8OID, -1, 0);
+    TupleDescInitEntry(tupdesc, (AttrNumber) 8, "avg_flush_time",
+                       FLOAT8OID, -1, 0);
+    TupleDescInitEntry(tupdesc, (AttrNumber) 9, "window_time",
+                       FLOAT8OID, -1, 0);
+    TupleDescInitEntry(tupdesc, (AttrNumber) 10, "stats_reset",
+                       TIMESTAMPTZOID, -1, 0);
+
+    BlessTupleDesc(tupdesc);
+
+    GetGroupCommitStats(&stats);
+
+    /* times are kept in microseconds, shown in milliseconds */
+    values[0] = Int64GetDatum(stats.requests);
+    values[1] = Int64GetDatum(stats.flushes);
+    values[2] = Int64GetDatum(stats.delayed_flushes);
+    values[3] = Float8GetDatum(stats.delay_time / 1000.0);
+    values[4] = Float8GetDatum(stats.queue_time / 1000.0);
+    values[5] = Float8GetDatum(stats.max_queue_time / 1000.0);
+    values[6] = Float8GetDatum(stats.avg_interval / 1000.0);
+    values[7] = Float8GetDatum(stats.avg_flush_time / 1000.0);
+    values[8] = Float8GetDatum(stats.window / 1000.0);
+    values[9] = TimestampTzGetDatum(stats.stats_reset);
+
+    /* Returns the record as Datum */
+    PG_RETURN_DATUM(HeapTupleGetDatum(
+                                      heap_form_tuple(tupdesc, values, nulls)));
+}
+#endif
+
+#ifdef __TBASE__
+/*
+ * Returns the index build progress of every datanode, as shown by their
+ * pg_stat_progress_create_index views.  Relations are shown by name, since
+ * their OIDs differ from node to node.
+ */
+Datum
+pgxc_stat_get_progress_create_index(PG_FUNCTION_ARGS)
+{
+#define PGXC_PROGRESS_CREATE_INDEX_COLS    12
+    ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+    TupleDesc    tupdesc;
+    Tuplestorestate *tupstore;
+    AttInMetadata *attinmeta;
+    MemoryContext per_query_ctx;
+    MemoryContext oldcontext;
+    RemoteQuery *plan;
+    RemoteQueryState *pstate;
+    EState       *estate;
+    TupleTableSlot *result;
+    List       *nodes;
+    int            i;
+
+    /* check to see if caller supports us returning a tuplestore */
+    if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("set-valued function called in context that cannot accept a set")));
+    if (!(rsinfo->allowedModes & SFRM_Materialize))
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("materialize mode required, but it is not " \
+                        "allowed in this context")));
+
+    if (!IS_PGXC_LOCAL_COORDINATOR)
+        ereport(ERROR,
+                (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                 errmsg("cluster-wide index build progress can only be gathered on a coordinator")));
+
+    /* Build a tuple descriptor for our result type */
+    if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+        elog(ERROR, "return type must be a row type");
+
+    per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+    oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+    tupstore = tuplestore_begin_heap(true, false, work_mem);
+    rsinfo->returnMode = SFRM_Materialize;
+    rsinfo->setResult = tupstore;
+    rsinfo->setDesc = tupdesc;
+    attinmeta = TupleDescGetAttInMetadata(tupdesc);
+
+    MemoryContextSwitchTo(oldcontext);
+
+    nodes = GetAllDataNodes();
+    if (nodes == NIL)
+        return (Datum) 0;
+
+    plan = makeNode(RemoteQuery);
+    plan->combine_type = COMBINE_TYPE_NONE;
+    plan->exec_nodes = makeNode(ExecNodes);
+    plan->exec_type = EXEC_ON_DATANODES;
+    plan->exec_nodes->nodeList = nodes;
+    plan->sql_statement = "SELECT pg_catalog.pgxc_node_str(), pid, datname, "
+        "relid::pg_catalog.regclass, index_relid::pg_catalog.regclass, "
+        "phase, blocks_total, blocks_done, tuples_scanned, tuples_sorted, "
+        "tuples_loaded, workers_launched "
+        "FROM pg_catalog.pg_stat_progress_create_index";
+    plan->force_autocommit = false;
+
+    /*
+     * We only need the target entry to determine result data type.
+     * The columns come back as text and are converted below.
+     */
+    for (i = 1; i <= PGXC_PROGRESS_CREATE_INDEX_COLS; i++)
+    {
+        Var           *dummy = makeVar(1, i, TEXTOID, 0, InvalidOid, 0);
+
+        plan->scan.plan.targetlist = lappend(plan->scan.plan.targetlist,
+                                             makeTargetEntry((Expr *) dummy, i, NULL, false));
+    }
+
+    estate = CreateExecutorState();
+    oldcontext = MemoryContextSwitchTo(estate->es_query_cxt);
+    estate->es_snapshot = GetActiveSnapshot();
+    pstate = ExecInitRemoteQuery(plan, estate, 0);
+    MemoryContextSwitchTo(oldcontext);
+
+    result = ExecRemoteQuery((PlanState *) pstate);
+    while (result != NULL && !TupIsNull(result))
+    {
+        char       *values[PGXC_PROGRESS_CREATE_INDEX_COLS];
+
+        slot_getallattrs(result);
+        for (i = 0; i < PGXC_PROGRESS_CREATE_INDEX_COLS; i++)
+            values[i] = result->tts_isnull[i] ? NULL :
+                TextDatumGetCString(result->tts_values[i]);
+
+        tuplestore_puttuple(tupstore, BuildTupleFromCStrings(attinmeta, values));
+        result = ExecRemoteQuery((PlanState *) pstate);
+    }
+    ExecEndRemoteQuery(pstate);
+
+    return (Datum) 0;
+}
+#endif
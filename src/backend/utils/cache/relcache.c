@@ -3869,6 +3869,10 @@ RelationSetNewRelfilenode(Relation relation, char persistence,
     newrnode.node.relNode = newrelfilenode;
     newrnode.backend = relation->rd_backend;
     RelationCreateStorage(newrnode.node, persistence);
+#ifdef __TBASE__
+    if (RelationIsPageCompressed(relation))
+        RelationCreatePageCompressFork(newrnode.node, persistence);
+#endif
     smgrclosenode(newrnode);
 
     /*
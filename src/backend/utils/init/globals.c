@@ -205,6 +205,9 @@ int            NBuffers = 1000;
 int            MaxConnections = 90;
 int            max_worker_processes = 8;
 int            max_parallel_workers = 8;
+#ifdef __TBASE__
+int            max_parallel_maintenance_workers = 2;
+#endif
 int            MaxBackends = 0;
 
 int            VacuumCostPageHit = 1;    /* GUC parameters for vacuum */
@@ -76,6 +76,7 @@
 #include "parser/parse_clause.h"
 #include "parser/parse_collate.h"
 #include "miscadmin.h"
+#include "nodes/bitmapset.h"
 #include "nodes/pg_list.h"
 #include "storage/lockdefs.h"
 #include "tcop/tcopprot.h"
@@ -85,6 +86,7 @@
 #include "utils/builtins.h"
 #include "utils/palloc.h"
 #include "utils/fmgroids.h"
+#include "utils/inval.h"
 #include "utils/relcache.h"
 #include "utils/memutils.h"
 #include "utils/syscache.h"
@@ -137,9 +139,26 @@ typedef struct tagClsGroupInfo
     bool    valid;
 }ClsGroupInfo;
 
+/*
+ * results of cls_check_read and cls_check_write for rows of the user's policy,
+ * one bit per label id. the result only depends on the row label and the
+ * labels of the user, so each label is resolved against the catalogs once per
+ * session; changes in pg_cls_label or pg_cls_group reset them.
+ */
+#define CLS_LABEL_BITMAP_WORDS      ((PG_INT16_MAX + 1) / BITS_PER_BITMAPWORD)
+
+typedef struct tagClsLabelDecision
+{
+    bitmapword  checked[CLS_LABEL_BITMAP_WORDS];
+    bitmapword  allowed[CLS_LABEL_BITMAP_WORDS];
+}ClsLabelDecision;
+
 /* every user has one of this global variable */
 ClsUserAuthority g_user_cls_priv;
 
+static ClsLabelDecision * g_cls_read_decision  = NULL;
+static ClsLabelDecision * g_cls_write_decision = NULL;
+
 int g_command_tag_enum = CLS_CMD_UNKNOWN;
 
 /* only the parent of root node could be invalid node, other has only one parent */
@@ -180,6 +199,9 @@ static int cls_get_clscol_from_pg_attribute(Form_pg_attribute *attrs, int natts)
 static List * array_datum_convert_to_int2_list(Datum datum);
 static bool cls_group_compare(int polid, List * rowgrouplist, List * usergrouplist);
 static bool cls_compartment_compare(List * rowcompartmentlist, List * usercompartmentlist);
+static void cls_reset_label_decision(void);
+static void cls_label_decision_callback(Datum arg, int cacheid, uint32 hashvalue);
+static bool cls_check_label_cached(ClsItem *arg, ClsLabelDecision **decision, bool (*check)(ClsItem *));
 Datum clsitemin(PG_FUNCTION_ARGS);
 Datum clsitemout(PG_FUNCTION_ARGS);
 
@@ -311,60 +333,108 @@ static void cls_parse_clsitem_and_assign(const char * str, ClsItem * clstiem)
 
 static bool cls_get_group_info(int polid, int groupid, ClsGroupInfo * group_info)
 {
-    bool        ret;
-    Relation    rel;
-    SysScanDesc scan;
     HeapTuple    tup;
-    ScanKeyData key[2];
     Form_pg_cls_group group_form;
 
-    ScanKeyInit(&key[0],
-                Anum_pg_cls_group_polid,
-                BTEqualStrategyNumber, 
-                F_OIDEQ,
-                ObjectIdGetDatum(polid));
-    ScanKeyInit(&key[1],
-                Anum_pg_cls_group_groupid,
-                BTEqualStrategyNumber, 
-                F_OIDEQ,
-                ObjectIdGetDatum(groupid));
-
-    ret = false;
-    rel = heap_open(ClsGroupRelationId, AccessShareLock);
+    tup = SearchSysCache2(CLSGRPOID, ObjectIdGetDatum(polid), ObjectIdGetDatum(groupid));
+    if (!HeapTupleIsValid(tup))
+    {
+        return false;
+    }
 
-    scan = systable_beginscan(rel, PgClsGroupPolidGroupidIndexId, true, NULL, 2, key);
+    group_form = (Form_pg_cls_group) GETSTRUCT(tup);
 
-    if (HeapTupleIsValid(tup = systable_getnext(scan)))
+    if (group_info)
     {
-        group_form = (Form_pg_cls_group) GETSTRUCT(tup);
-        
-        if (group_info)
+        group_info->childid  = group_form->groupid;
+        group_info->parentid = group_form->parentid;
+
+        if (HeapTupleHasNulls(tup) 
+            && att_isnull(Anum_pg_cls_group_longname, tup->t_data->t_bits))
+        {
+            group_info->valid = false;
+        }
+        else
         {
-            group_info->childid  = group_form->groupid;
-            group_info->parentid = group_form->parentid;
+            group_info->valid = true;
+        }
+    }
 
-            if (HeapTupleHasNulls(tup) 
-                && att_isnull(Anum_pg_cls_group_longname, tup->t_data->t_bits))
-            {
-                group_info->valid = false;
-            }
-            else
-            {
-                group_info->valid = true;
-            }
+    ReleaseSysCache(tup);
+    
+    return true;
+}
+
+/*
+ * forget all cached label decisions.
+ */
+static void cls_reset_label_decision(void)
+{
+    if (g_cls_read_decision)
+    {
+        MemSet(g_cls_read_decision, 0, sizeof(ClsLabelDecision));
+    }
+    if (g_cls_write_decision)
+    {
+        MemSet(g_cls_write_decision, 0, sizeof(ClsLabelDecision));
+    }
+}
+
+/*
+ * labels or groups changed, the dominance between labels may change too.
+ */
+static void cls_label_decision_callback(Datum arg, int cacheid, uint32 hashvalue)
+{
+    cls_reset_label_decision();
+}
+
+/*
+ * run 'check' for the label of the row once, later rows with the same label
+ * get the result from the bitmap. caller makes sure the row is in the user's
+ * policy.
+ */
+static bool cls_check_label_cached(ClsItem *arg, ClsLabelDecision **decision, bool (*check)(ClsItem *))
+{
+    static bool callback_registered = false;
+    int         wordnum;
+    bitmapword  bit;
+    bool        ret;
+
+    if (arg->labelid < 0)
+    {
+        return check(arg);
+    }
+
+    if (NULL == *decision)
+    {
+        if (false == callback_registered)
+        {
+            CacheRegisterSyscacheCallback(CLSLABELOID, cls_label_decision_callback, (Datum) 0);
+            CacheRegisterSyscacheCallback(CLSGRPOID, cls_label_decision_callback, (Datum) 0);
+            callback_registered = true;
         }
+        *decision = (ClsLabelDecision *) MemoryContextAllocZero(TopMemoryContext, sizeof(ClsLabelDecision));
+    }
+
+    wordnum = arg->labelid / BITS_PER_BITMAPWORD;
+    bit     = ((bitmapword) 1) << (arg->labelid % BITS_PER_BITMAPWORD);
 
-        ret = true;
+    if ((*decision)->checked[wordnum] & bit)
+    {
+        return ((*decision)->allowed[wordnum] & bit) != 0;
     }
 
-    systable_endscan(scan);
+    ret = check(arg);
+
+    (*decision)->checked[wordnum] |= bit;
+    if (ret)
+    {
+        (*decision)->allowed[wordnum] |= bit;
+    }
 
-    heap_close(rel, AccessShareLock);
-    
     return ret;
 }
 
-
 #endif
 #if MARK("algorithm")
 /*
@@ -780,11 +850,11 @@ Datum pg_cls_check(PG_FUNCTION_ARGS)
         
         if (CLS_CMD_READ == g_command_tag_enum)
         {
-            ret = cls_check_read(arg);
+            ret = cls_check_label_cached(arg, &g_cls_read_decision, cls_check_read);
         }
         else if (CLS_CMD_WRITE == g_command_tag_enum)
         {
-            ret = cls_check_write(arg);
+            ret = cls_check_label_cached(arg, &g_cls_write_decision, cls_check_write);
         }
 /*        
         else if (CLS_CMD_ROW == g_command_tag_enum)
@@ -792,9 +862,6 @@ Datum pg_cls_check(PG_FUNCTION_ARGS)
             
         }
 */      
-        /* TODO: we just output the datum value, later there would be policies algorithm */
-        elog(LOG, "[neoqguo]pg_cls_check is ready, get value:%d:%d", arg->polid, arg->labelid);
-        
         PG_RETURN_BOOL(ret);
     }
 
@@ -996,6 +1063,9 @@ void mls_assign_user_clsitem(void)
     }
 
     MemoryContextSwitchTo(oldcontext);
+
+    /* labels of the user changed, decisions made before are useless */
+    cls_reset_label_decision();
     
     return ;
 }
@@ -1045,7 +1115,12 @@ bool mls_cls_check_row_validation_in_cp(Datum datum)
 
     clsitem = (ClsItem *)datum;
 
-    return cls_check_read(clsitem);
+    if (false == CLS_AUTH_CHECK_IN_POLICY(clsitem->polid))
+    {
+        return false;
+    }
+
+    return cls_check_label_cached(clsitem, &g_cls_read_decision, cls_check_read);
 }
 
 /*
@@ -62,6 +62,8 @@
 #include "postgres_ext.h"
 #include "access/genam.h"
 #include "access/htup_details.h"
+#include "access/sysattr.h"
+#include "access/xact.h"
 #include "access/xlogreader.h"
 #include "catalog/pg_attribute.h"
 #include "catalog/pg_authid.h"
@@ -81,11 +83,13 @@
 #include "nodes/makefuncs.h"
 #include "nodes/primnodes.h"
 #include "nodes/nodeFuncs.h"
+#include "optimizer/var.h"
 #include "parser/parsetree.h"
 #include "parser/parse_relation.h"
 #include "storage/bufmgr.h"
 #include "storage/lockdefs.h"
 #include "storage/lwlock.h"
+#include "storage/proc.h"
 #include "storage/sinval.h"
 #include "storage/shmem.h"
 #include "mb/pg_wchar.h"
@@ -98,6 +102,7 @@
 #include "utils/lsyscache.h"
 #include "utils/fmgroids.h"
 #include "utils/fmgrprotos.h"
+#include "utils/hsearch.h"
 #include "utils/memutils.h"
 #include "utils/inval.h"
 #include "utils/snapshot.h"
@@ -142,9 +147,50 @@ enum
     DATAMASK_KIND_BUTT
 };
 
+/*
+ * Masking decision of a column for a user, see datamask_get_col_decision.
+ */
+typedef struct DataMaskColDecisionKey
+{
+    Oid         relid;
+    Oid         userid;
+    int16       attnum;
+} DataMaskColDecisionKey;
+
+typedef struct DataMaskColDecision
+{
+    DataMaskColDecisionKey key;     /* hash key, must be first */
+    bool        enable;             /* column is masked for the user */
+    int32       option;
+    int64       datamask;
+    char       *defaultval;
+} DataMaskColDecision;
+
+/*
+ * Decisions are read from the catalogs once per statement and kept in
+ * DataMaskDecisionContext, which is reset when another statement or command
+ * starts, or when pg_data_mask_map or the white list change. The last mask
+ * state built for COPY is kept there too, so that COPY and record output do
+ * not rebuild it for every row.
+ */
+static MemoryContext DataMaskDecisionContext = NULL;
+static HTAB *DataMaskDecisionHash = NULL;
+static bool DataMaskDecisionValid = false;
+static LocalTransactionId DataMaskDecisionLxid = InvalidLocalTransactionId;
+static CommandId DataMaskDecisionCid = InvalidCommandId;
+static TimestampTz DataMaskDecisionStmtTs = 0;
+static DataMaskState *DataMaskCopyState = NULL;
+static Oid DataMaskCopyRelid = InvalidOid;
+static TupleDesc DataMaskCopyTupdesc = NULL;
+
 static Datum datamask_exchange_one_col_value(Form_pg_attribute attr, Datum inputval, bool isnull, DataMaskAttScan *mask,
                                              bool *datumvalid);
 static bool datamask_attr_mask_is_valid(Datamask   *datamask, int attnum);
+static void datamask_decision_callback(Datum arg, int cacheid, uint32 hashvalue);
+static void datamask_decision_cache_check(void);
+static DataMaskColDecision *datamask_get_col_decision(Oid relid, Oid userid, Form_pg_attribute attr);
+static void datamask_fill_const_value(Form_pg_attribute attr, DataMaskAttScan *info);
+static Bitmapset *datamask_scan_used_attrs(ScanState *node, bool *all_attrs);
 static char * transfer_str_prefix(text * text_str, int mask_bit_count);
 static char * transfer_str_postfix(text * text_str, int mask_bit_count);
 
@@ -471,6 +517,12 @@ static Datum datamask_exchange_one_col_value(Form_pg_attribute attr, Datum input
         return value;
     }
 
+    if (mask->constvalid)
+    {
+        *datumvalid = true;
+        return mask->constval;
+    }
+
     if (mls_support_data_type(attr->atttypid))
     {
         *datumvalid = true;
@@ -754,23 +806,220 @@ static void fill_att_mask_info(Oid relid, Form_pg_attribute attr, DataMaskAttSca
         info->datamask   = form_pg_datamask->datamask;
         info->defaultval = TextDatumGetCString(&form_pg_datamask->defaultval);
         info->option     = form_pg_datamask->option;
-
-        fill_att_mask_func(info,attr->atttypid);
     }
 
     systable_endscan(scan);
     heap_close(rel, AccessShareLock);
 }
 
-DataMaskState *init_datamask_desc(Oid relid, Form_pg_attribute *attrs, Datamask *datamask)
+/*
+ * Masking rules or the white list changed, decisions are read again by the
+ * next check. The hash is not freed here, the invalidation may arrive while
+ * a decision is being filled in.
+ */
+static void datamask_decision_callback(Datum arg, int cacheid, uint32 hashvalue)
+{
+    DataMaskDecisionValid = false;
+}
+
+/*
+ * Forget the masking decisions of a previous statement or command. A read
+ * only transaction keeps its command id, so the statement start is checked
+ * too: under READ COMMITTED each statement must see the rules committed
+ * before it started.
+ */
+static void datamask_decision_cache_check(void)
+{
+    HASHCTL     ctl;
+    CommandId   cid = GetCurrentCommandId(false);
+    TimestampTz stmt_ts = GetCurrentStatementStartTimestamp();
+
+    if (DataMaskDecisionHash != NULL &&
+        DataMaskDecisionValid &&
+        DataMaskDecisionLxid == MyProc->lxid &&
+        DataMaskDecisionCid == cid &&
+        DataMaskDecisionStmtTs == stmt_ts)
+    {
+        return;
+    }
+
+    if (DataMaskDecisionContext == NULL)
+    {
+        DataMaskDecisionContext = AllocSetContextCreate(TopMemoryContext,
+                                                        "Datamask decisions",
+                                                        ALLOCSET_DEFAULT_SIZES);
+        CacheRegisterSyscacheCallback(DATAMASKOID, datamask_decision_callback, (Datum) 0);
+        CacheRegisterSyscacheCallback(DATAMASKUSEROID, datamask_decision_callback, (Datum) 0);
+    }
+    else
+    {
+        MemoryContextReset(DataMaskDecisionContext);
+    }
+
+    MemSet(&ctl, 0, sizeof(ctl));
+    ctl.keysize   = sizeof(DataMaskColDecisionKey);
+    ctl.entrysize = sizeof(DataMaskColDecision);
+    ctl.hcxt      = DataMaskDecisionContext;
+
+    DataMaskDecisionHash = hash_create("Datamask decisions", 64, &ctl,
+                                       HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+    DataMaskDecisionValid  = true;
+    DataMaskDecisionLxid   = MyProc->lxid;
+    DataMaskDecisionCid    = cid;
+    DataMaskDecisionStmtTs = stmt_ts;
+
+    DataMaskCopyState   = NULL;
+    DataMaskCopyRelid   = InvalidOid;
+    DataMaskCopyTupdesc = NULL;
+}
+
+/*
+ * Whether a column of relid is masked for userid and how, looking at the
+ * white list and pg_data_mask_map only once per statement.
+ */
+static DataMaskColDecision *datamask_get_col_decision(Oid relid, Oid userid, Form_pg_attribute attr)
+{
+    DataMaskColDecisionKey key;
+    DataMaskColDecision   *decision;
+    DataMaskAttScan        info;
+    MemoryContext          old_memctx;
+    bool                   found;
+
+    datamask_decision_cache_check();
+
+    MemSet(&key, 0, sizeof(key));
+    key.relid  = relid;
+    key.userid = userid;
+    key.attnum = attr->attnum;
+
+    decision = (DataMaskColDecision *) hash_search(DataMaskDecisionHash, &key, HASH_FIND, NULL);
+    if (decision != NULL)
+    {
+        return decision;
+    }
+
+    MemSet(&info, 0, sizeof(info));
+
+    if (!dmask_chk_usr_and_col_in_whit_list(relid, userid, attr->attnum))
+    {
+        old_memctx = MemoryContextSwitchTo(DataMaskDecisionContext);
+        fill_att_mask_info(relid, attr, &info);
+        MemoryContextSwitchTo(old_memctx);
+    }
+
+    decision = (DataMaskColDecision *) hash_search(DataMaskDecisionHash, &key, HASH_ENTER, &found);
+    decision->enable     = info.enable;
+    decision->option     = info.option;
+    decision->datamask   = info.datamask;
+    decision->defaultval = info.defaultval;
+
+    return decision;
+}
+
+/*
+ * VALUE and DEFAULT_VAL masks do not depend on the column value, so the
+ * masked value is computed once instead of once per row. Other kinds, and
+ * unsupported types that must still fail on the first row, stay per row.
+ */
+static void datamask_fill_const_value(Form_pg_attribute attr, DataMaskAttScan *info)
+{
+    bool        isconst = false;
+    bool        datumvalid = false;
+    Datum       value;
+
+    info->constvalid = false;
+
+    switch (info->option)
+    {
+        case DATAMASK_KIND_VALUE:
+            isconst = (INT4OID == attr->atttypid || INT2OID == attr->atttypid || INT8OID == attr->atttypid);
+            break;
+        case DATAMASK_KIND_DEFAULT_VAL:
+            /* fill_att_mask_func has refused other types */
+            isconst = true;
+            break;
+        default:
+            break;
+    }
+
+    if (isconst)
+    {
+        value = datamask_exchange_one_col_value(attr, (Datum) 0, true, info, &datumvalid);
+
+        info->constval   = value;
+        info->constvalid = datumvalid;
+    }
+}
+
+/*
+ * Columns of the scanned relation read by a heap scan node, through its
+ * target list or quals. *all_attrs is set when every column may be read,
+ * e.g. for a whole-row reference or a node whose target list does not
+ * refer to the heap.
+ */
+static Bitmapset *datamask_scan_used_attrs(ScanState *node, bool *all_attrs)
+{
+    Scan       *scan;
+    Bitmapset  *attrs_used = NULL;
+
+    *all_attrs = true;
+
+    if (node == NULL || node->ps.plan == NULL)
+        return NULL;
+
+    scan = (Scan *) node->ps.plan;
+
+    switch (nodeTag(node))
+    {
+        case T_SeqScanState:
+        case T_SampleScanState:
+            break;
+        case T_IndexScanState:
+            pull_varattnos((Node *) ((IndexScan *) scan)->indexqualorig, scan->scanrelid, &attrs_used);
+            pull_varattnos((Node *) ((IndexScan *) scan)->indexorderbyorig, scan->scanrelid, &attrs_used);
+            break;
+        case T_BitmapHeapScanState:
+            pull_varattnos((Node *) ((BitmapHeapScan *) scan)->bitmapqualorig, scan->scanrelid, &attrs_used);
+            break;
+        case T_TidScanState:
+            pull_varattnos((Node *) ((TidScan *) scan)->tidquals, scan->scanrelid, &attrs_used);
+            break;
+        default:
+            return NULL;
+    }
+
+    pull_varattnos((Node *) scan->plan.targetlist, scan->scanrelid, &attrs_used);
+    pull_varattnos((Node *) scan->plan.qual, scan->scanrelid, &attrs_used);
+
+    if (bms_is_member(InvalidAttrNumber - FirstLowInvalidHeapAttributeNumber, attrs_used))
+    {
+        bms_free(attrs_used);
+        return NULL;
+    }
+
+    *all_attrs = false;
+    return attrs_used;
+}
+
+/*
+ * Build the mask state of a relation for the current user. With a scan, only
+ * the columns it reads are masked, other columns never reach its output.
+ */
+DataMaskState *init_datamask_desc(Oid relid, Form_pg_attribute *attrs, Datamask *datamask,
+                                  ScanState *scan)
 {
     DataMaskAttScan *att_info;
     DataMaskState *desc;
+    DataMaskColDecision *decision;
+    Bitmapset *attrs_used;
+    bool all_attrs;
     int attno;
     int natts;
 
     natts = datamask->attmasknum;
 
+    attrs_used = datamask_scan_used_attrs(scan, &all_attrs);
+
     desc = palloc0(sizeof(DataMaskState));
     if (desc == NULL)
         elog(ERROR, "out of memory");
@@ -779,6 +1028,9 @@ DataMaskState *init_datamask_desc(Oid relid, Form_pg_attribute *attrs, Datamask
     if (desc->maskinfo == NULL)
         elog(ERROR, "out of memory");
 
+    desc->maskatts = palloc0(sizeof(int) * natts);
+    desc->nmaskatts = 0;
+
     for (attno = 0; attno < natts; attno++)
     {
         att_info = &desc->maskinfo[attno];
@@ -789,16 +1041,32 @@ DataMaskState *init_datamask_desc(Oid relid, Form_pg_attribute *attrs, Datamask
             continue;
         }
 
-        if(dmask_chk_usr_and_col_in_whit_list(relid, GetUserId(), attrs[attno]->attnum))
+        decision = datamask_get_col_decision(relid, GetUserId(), attrs[attno]);
+        if (!decision->enable)
         {
             att_info->enable = false;
             continue;
         }
 
-        att_info->enable = true;
-        fill_att_mask_info(relid, attrs[attno], att_info);
+        att_info->enable     = true;
+        att_info->datamask   = decision->datamask;
+        att_info->defaultval = decision->defaultval;
+        att_info->option     = decision->option;
+
+        fill_att_mask_func(att_info, attrs[attno]->atttypid);
+        datamask_fill_const_value(attrs[attno], att_info);
+
+        if (!all_attrs &&
+            !bms_is_member(attrs[attno]->attnum - FirstLowInvalidHeapAttributeNumber, attrs_used))
+        {
+            continue;
+        }
+
+        desc->maskatts[desc->nmaskatts++] = attno;
     }
 
+    bms_free(attrs_used);
+
     return desc;
 }
 
@@ -810,6 +1078,7 @@ void datamask_exchange_all_cols_value(Node *node, TupleTableSlot *slot)
     bool        need_exchange_slot_tts_tuple;
     bool        datumvalid;
     int         attnum;
+    int         i;
     int         natts;
     TupleDesc   tupleDesc;
     Datum      *tuple_values;
@@ -829,6 +1098,12 @@ void datamask_exchange_all_cols_value(Node *node, TupleTableSlot *slot)
     datamask    = tupleDesc->tdatamask;
     natts       = tupleDesc->natts;
 
+    /* no column read by the scan is masked for this user */
+    if (scanstate->ss_currentMaskDesc->nmaskatts == 0)
+    {
+        return;
+    }
+
     slot_values = slot->tts_values;
     slot_isnull = slot->tts_isnull;
     att         = tupleDesc->attrs;
@@ -853,43 +1128,43 @@ void datamask_exchange_all_cols_value(Node *node, TupleTableSlot *slot)
 
         }
 
-        for (attnum = 0; attnum < natts; attnum++)
+        for (i = 0; i < scanstate->ss_currentMaskDesc->nmaskatts; i++)
         {
-            if (datamask_attr_mask_is_valid(datamask, attnum))
-            {
-                Form_pg_attribute thisatt = att[attnum];
+            Form_pg_attribute thisatt;
 
-                datumvalid = false;
-                if (need_exchange_slot_tts_tuple)
-                {
-                    slot_values[attnum]  = datamask_exchange_one_col_value(
-                            thisatt,
-                            tuple_values[attnum],
-                            tuple_isnull[attnum],
-                            &maskState[attnum],
-                            &datumvalid);
-                }
-                else
-                {
-                    /* tuple_values are null, so try slot_values */
-                    slot_values[attnum]  = datamask_exchange_one_col_value(
-                            thisatt,
-                            slot_values[attnum],
-                            slot_isnull[attnum],
-                            &maskState[attnum],
-                            &datumvalid);
-                }
-                slot_isnull[attnum]  = false;
+            attnum  = scanstate->ss_currentMaskDesc->maskatts[i];
+            thisatt = att[attnum];
 
-                /* 
-                 * if datum is invalid, slot_values is invalid either, keep orginal value in tuple_value
-                 * it seems a little bored
-                 */
-                if (need_exchange_slot_tts_tuple && datumvalid)
-                {
-                    tuple_values[attnum] = slot_values[attnum];
-                    tuple_isnull[attnum] = slot_isnull[attnum];
-                }
+            datumvalid = false;
+            if (need_exchange_slot_tts_tuple)
+            {
+                slot_values[attnum]  = datamask_exchange_one_col_value(
+                        thisatt,
+                        tuple_values[attnum],
+                        tuple_isnull[attnum],
+                        &maskState[attnum],
+                        &datumvalid);
+            }
+            else
+            {
+                /* tuple_values are null, so try slot_values */
+                slot_values[attnum]  = datamask_exchange_one_col_value(
+                        thisatt,
+                        slot_values[attnum],
+                        slot_isnull[attnum],
+                        &maskState[attnum],
+                        &datumvalid);
+            }
+            slot_isnull[attnum]  = false;
+
+            /* 
+             * if datum is invalid, slot_values is invalid either, keep orginal value in tuple_value
+             * it seems a little bored
+             */
+            if (need_exchange_slot_tts_tuple && datumvalid)
+            {
+                tuple_values[attnum] = slot_values[attnum];
+                tuple_isnull[attnum] = slot_isnull[attnum];
             }
         }
 
@@ -1179,39 +1454,51 @@ bool datamask_check_datamask_equal(Datamask * dm1, Datamask * dm2)
 void dmask_exchg_all_cols_value_copy(TupleDesc tupleDesc, Datum   *tuple_values, bool*tuple_isnull, Oid relid)
 {
     int         attnum;
-    int         natts;
+    int         i;
     Datamask   *datamask;
     Datum       datum_ret;
     bool        datumvalid;
     Form_pg_attribute *att;
     DataMaskState *maskstate;
+    MemoryContext  old_memctx;
 
-    natts    = tupleDesc->natts;
     att      = tupleDesc->attrs;
     datamask = tupleDesc->tdatamask;
 
-    maskstate = init_datamask_desc(relid, att, datamask);
+    /* build the mask state once per statement, not for every row */
+    datamask_decision_cache_check();
+    if (DataMaskCopyState == NULL ||
+        DataMaskCopyRelid != relid ||
+        DataMaskCopyTupdesc != tupleDesc)
+    {
+        old_memctx = MemoryContextSwitchTo(DataMaskDecisionContext);
+        DataMaskCopyState   = init_datamask_desc(relid, att, datamask, NULL);
+        DataMaskCopyRelid   = relid;
+        DataMaskCopyTupdesc = tupleDesc;
+        MemoryContextSwitchTo(old_memctx);
+    }
+    maskstate = DataMaskCopyState;
 
-    for (attnum = 0; attnum < natts; attnum++)
+    for (i = 0; i < maskstate->nmaskatts; i++)
     {
-        if (datamask_attr_mask_is_valid(datamask, attnum))
-        {
-            Form_pg_attribute thisatt = att[attnum];
+        Form_pg_attribute thisatt;
 
-            datumvalid = false;
+        attnum  = maskstate->maskatts[i];
+        thisatt = att[attnum];
 
-            datum_ret = datamask_exchange_one_col_value(
-                    thisatt,
-                    tuple_values[attnum],
-                    tuple_isnull[attnum],
-                    &maskstate->maskinfo[attnum],
-                    &datumvalid);
+        datumvalid = false;
 
-            if (datumvalid)
-                tuple_values[attnum] = datum_ret;
+        datum_ret = datamask_exchange_one_col_value(
+                thisatt,
+                tuple_values[attnum],
+                tuple_isnull[attnum],
+                &maskstate->maskinfo[attnum],
+                &datumvalid);
 
-            tuple_isnull[attnum] = false;
-        }
+        if (datumvalid)
+            tuple_values[attnum] = datum_ret;
+
+        tuple_isnull[attnum] = false;
     }
 }
 
@@ -38,6 +38,7 @@
 #include "access/twophase.h"
 #include "access/xact.h"
 #include "access/xlog_internal.h"
+#include "access/xlogredo.h"
 #include "access/heapam_xlog.h"
 #include "access/lru.h"
 #include "catalog/namespace.h"
@@ -67,6 +68,7 @@
 #include "commands/tablecmds.h"
 #include "commands/trigger.h"
 #include "nodes/nodes.h"
+#include "pgxc/barrier.h"
 #include "pgxc/execRemote.h"
 #include "pgxc/locator.h"
 #include "pgxc/planner.h"
@@ -86,10 +88,12 @@
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/bgwriter.h"
 #include "postmaster/clean2pc.h"
+#include "postmaster/globaldeadlock.h"
 #include "postmaster/postmaster.h"
 #include "postmaster/syslogger.h"
 #include "postmaster/walwriter.h"
 #include "replication/logicallauncher.h"
+#include "replication/logicalworker.h"
 #include "replication/slot.h"
 #include "replication/syncrep.h"
 #include "replication/walreceiver.h"
@@ -1177,6 +1181,17 @@ static struct config_bool ConfigureNamesBool[] =
         false,
         NULL, NULL, NULL
     },
+#ifdef __TBASE__
+    {
+        {"enable_gts_barrier", PGC_SUSET, QUERY_TUNING_METHOD,
+            gettext_noop("Takes barriers at a global timestamp without pausing two-phase commits."),
+            NULL
+        },
+        &enable_gts_barrier,
+        false,
+        NULL, NULL, NULL
+    },
+#endif
     {
         {"enable_datanode_row_triggers", PGC_POSTMASTER, DEVELOPER_OPTIONS,
             gettext_noop("Enables datanode-only ROW triggers"),
@@ -1363,6 +1378,19 @@ static struct config_bool ConfigureNamesBool[] =
         NULL, NULL, NULL
     },
 
+#ifdef __TBASE__
+    {
+        {"enable_adaptive_group_commit", PGC_SUSET, WAL_SETTINGS,
+            gettext_noop("Sizes the delay before flushing WAL from the recent "
+                         "commit rate and flush latency."),
+            gettext_noop("When on, commit_delay and commit_siblings are ignored.")
+        },
+        &enable_adaptive_group_commit,
+        false,
+        NULL, NULL, NULL
+    },
+#endif
+
     {
         {"log_checkpoints", PGC_SIGHUP, LOGGING_WHAT,
             gettext_noop("Logs each checkpoint."),
@@ -1831,6 +1859,15 @@ static struct config_bool ConfigureNamesBool[] =
         false,
         NULL, NULL, NULL
     },
+    {
+        {"alog_binary_records", PGC_POSTMASTER, LOGGING_WHERE,
+            gettext_noop("Write common audit logs as binary records formatted by audit logger."),
+            gettext_noop("The record rings are only allocated in shared memory when this is on at server start.")
+        },
+        &AuditLog_binary_records,
+        false,
+        NULL, NULL, NULL
+    },
 #endif
 
 #ifdef TRACE_SORT
@@ -2144,6 +2181,17 @@ static struct config_bool ConfigureNamesBool[] =
         NULL, NULL, NULL
     },
 
+    {
+        {"vacuum_database_horizon", PGC_SIGHUP, CUSTOM_OPTIONS,
+            gettext_noop("Let vacuum compute the data horizon of each database separately."),
+            gettext_noop("Snapshots taken in other databases then do not hold back "
+                         "the cleanup of dead tuples, except in shared catalogs.")
+        },
+        &vacuum_database_horizon,
+        true,
+        NULL, NULL, NULL
+    },
+
     {
         {"enable_multi_cluster", PGC_POSTMASTER, CUSTOM_OPTIONS,
             gettext_noop("Enable multiple clusters."),
@@ -2198,6 +2246,16 @@ static struct config_bool ConfigureNamesBool[] =
         NULL, NULL, NULL
     },    
 
+    {
+        {"refuse_blocking_ddl", PGC_USERSET, CUSTOM_OPTIONS,
+            gettext_noop("Refuses DDL that blocks a distributed table while datanodes rewrite, scan or index it."),
+            gettext_noop("This is only a guard, the DDL is not run online instead.")
+        },
+        &refuse_blocking_ddl,
+        false,
+        NULL, NULL, NULL
+    },
+
     {
         {"param_pass_down", PGC_USERSET, CUSTOM_OPTIONS,
             gettext_noop("enable exec param to pass down."),
@@ -2519,6 +2577,15 @@ static struct config_bool ConfigureNamesBool[] =
         false,
         NULL, NULL, NULL
     },
+    {
+        {"enable_standby_read_routing", PGC_SIGHUP, CUSTOM_OPTIONS,
+            gettext_noop("Routes reads of read-only transactions to standby datanodes of other planes."),
+            NULL
+        },
+        &enable_standby_read_routing,
+        false,
+        NULL, NULL, NULL
+    },
     {
         {"enable_committs_print", PGC_SUSET, CUSTOM_OPTIONS,
             gettext_noop("enable commit ts debug print"),
@@ -2704,6 +2771,35 @@ static struct config_bool ConfigureNamesBool[] =
         NULL, NULL, NULL
     },
 #endif
+#ifdef __SUBSCRIPTION__
+    {
+        {"logical_apply_preserve_commit_order", PGC_SIGHUP, REPLICATION_SUBSCRIBERS,
+            gettext_noop("Commits transactions applied by parallel child subscriptions in publisher commit order."),
+            NULL
+        },
+        &logical_apply_preserve_commit_order,
+        false,
+        NULL, NULL, NULL
+    },
+    {
+        {"logical_apply_streaming", PGC_SIGHUP, REPLICATION_SUBSCRIBERS,
+            gettext_noop("Asks publishers to stream large transactions before they commit."),
+            NULL
+        },
+        &logical_apply_streaming,
+        false,
+        NULL, NULL, NULL
+    },
+    {
+        {"logical_apply_binary", PGC_SIGHUP, REPLICATION_SUBSCRIBERS,
+            gettext_noop("Asks publishers to send column values of built-in types in binary format."),
+            NULL
+        },
+        &logical_apply_binary,
+        false,
+        NULL, NULL, NULL
+    },
+#endif
 
 #ifdef __TWO_PHASE_TRANS__
 	{
@@ -2753,6 +2849,18 @@ static struct config_bool ConfigureNamesBool[] =
 	},
 #endif
 
+#ifdef __TBASE__
+    {
+        {"enable_global_deadlock_detector", PGC_SIGHUP, LOCK_MANAGEMENT,
+            gettext_noop("Detects and breaks deadlocks between distributed transactions spanning nodes."),
+            NULL
+        },
+        &enable_global_deadlock_detector,
+        false,
+        NULL, NULL, NULL
+    },
+#endif
+
 	{
 		{"enable_clean_2pc_launcher", PGC_POSTMASTER, CUSTOM_OPTIONS,
 			gettext_noop("Enable clean 2PC launcher."),
@@ -2763,6 +2871,17 @@ static struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"enable_clean_2pc_local_resolve", PGC_SIGHUP, CUSTOM_OPTIONS,
+			gettext_noop("Resolve in-doubt 2PC started from this node using its local 2PC records."),
+			gettext_noop("In-doubt 2PC left by a crash or a failed commit phase "
+						 "are resolved at once, on all participants in parallel.")
+		},
+		&enable_clean_2pc_local_resolve,
+		true,
+		NULL, NULL, NULL
+	},
+
 #ifdef __TBASE__
 	{
 		{"enable_lock_account", PGC_SUSET, CUSTOM_OPTIONS,
@@ -2999,6 +3118,19 @@ static struct config_int ConfigureNamesInt[] =
         NULL, NULL, NULL
     },
 
+#ifdef __TBASE__
+    {
+        {"global_deadlock_detector_interval", PGC_SIGHUP, LOCK_MANAGEMENT,
+            gettext_noop("Sets the time between two collections of lock waits by the global deadlock detector."),
+            NULL,
+            GUC_UNIT_MS
+        },
+        &global_deadlock_detector_interval,
+        2000, 100, INT_MAX,
+        NULL, NULL, NULL
+    },
+#endif
+
     {
         {"max_standby_archive_delay", PGC_SIGHUP, REPLICATION_STANDBY,
             gettext_noop("Sets the maximum delay before canceling queries when a hot standby server is processing archived WAL data."),
@@ -3710,6 +3842,20 @@ static struct config_int ConfigureNamesInt[] =
         NULL, NULL, NULL
     },
 
+#ifdef __TBASE__
+    {
+        {"group_commit_max_delay", PGC_SUSET, WAL_SETTINGS,
+            gettext_noop("Sets the longest delay in microseconds adaptive group commit "
+                         "waits before flushing WAL."),
+            NULL
+            /* we have no microseconds designation, so can't supply units here */
+        },
+        &group_commit_max_delay,
+        1000, 0, 100000,
+        NULL, NULL, NULL
+    },
+#endif
+
     {
         {"extra_float_digits", PGC_USERSET, CLIENT_CONN_LOCALE,
             gettext_noop("Sets the number of digits displayed for floating-point values."),
@@ -3852,6 +3998,31 @@ static struct config_int ConfigureNamesInt[] =
         50, 10, INT_MAX,
         NULL, NULL, NULL
     },
+#ifdef __SUBSCRIPTION__
+    {
+        {"logical_apply_pipeline_depth",
+            PGC_SIGHUP,
+            REPLICATION_SUBSCRIBERS,
+            gettext_noop("Maximum number of changes a coordinator apply worker sends to one datanode before waiting for their results."),
+            gettext_noop("0 waits for the result of each change.")
+        },
+        &logical_apply_pipeline_depth,
+        0, 0, 10000,
+        NULL, NULL, NULL
+    },
+
+    {
+        {"logical_sync_streams_per_table",
+            PGC_SIGHUP,
+            REPLICATION_SUBSCRIBERS,
+            gettext_noop("Number of parallel streams the initial copy of a sharded table is split into."),
+            gettext_noop("Each stream copies a range of shards, all but one in a helper worker.")
+        },
+        &logical_sync_streams_per_table,
+        1, 1, 64,
+        NULL, NULL, NULL
+    },
+#endif
         
     {
             {"base_backup_limit", PGC_SIGHUP, RESOURCES_KERNEL,
@@ -3910,6 +4081,16 @@ static struct config_int ConfigureNamesInt[] =
         &query_delay,
         0, 0, 31536000,
         NULL, NULL, NULL
+    },
+    {
+        {"standby_read_refresh_interval", PGC_SIGHUP, CUSTOM_OPTIONS,
+            gettext_noop("Sets how often the pooler polls standby datanodes for the timestamp they have replayed."),
+            NULL,
+            GUC_UNIT_MS
+        },
+        &standby_read_refresh_interval,
+        1000, 100, INT_MAX,
+        NULL, NULL, NULL
     },
 	{
 		{"max_relcache_relations", PGC_POSTMASTER, RESOURCES,
@@ -4124,6 +4305,18 @@ static struct config_int ConfigureNamesInt[] =
         NULL, NULL, NULL
     },
 
+#ifdef __TBASE__
+    {
+        {"parallel_redo_workers", PGC_POSTMASTER, REPLICATION_STANDBY,
+            gettext_noop("Sets the number of worker processes replaying WAL on a standby."),
+            gettext_noop("0 replays WAL in the startup process only."),
+        },
+        &parallel_redo_workers,
+        0, 0, 64,
+        NULL, NULL, NULL
+    },
+#endif
+
     {
         {"wal_segment_size", PGC_INTERNAL, PRESET_OPTIONS,
             gettext_noop("Shows the number of pages per write ahead log segment."),
@@ -4229,6 +4422,18 @@ static struct config_int ConfigureNamesInt[] =
         NULL, NULL, NULL
     },
 
+#ifdef __TBASE__
+    {
+        {"max_parallel_maintenance_workers", PGC_USERSET, RESOURCES_ASYNCHRONOUS,
+            gettext_noop("Sets the maximum number of parallel processes per btree index build."),
+            NULL
+        },
+        &max_parallel_maintenance_workers,
+        2, 0, MAX_PARALLEL_WORKER_LIMIT,
+        NULL, NULL, NULL
+    },
+#endif
+
     {
         {"autovacuum_work_mem", PGC_SIGHUP, RESOURCES_MEM,
             gettext_noop("Sets the maximum memory to be used by each autovacuum worker process."),
@@ -1490,7 +1490,8 @@ void MlsExecCheck(ScanState *node, TupleTableSlot *slot)
                                 parent_oid = mls_get_parent_oid(node->ss_currentRelation);
                                 node->ss_currentMaskDesc = init_datamask_desc(parent_oid,
                                                                               slot->tts_tupleDescriptor->attrs,
-                                                                              node->ss_currentRelation->rd_att->tdatamask);
+                                                                              node->ss_currentRelation->rd_att->tdatamask,
+                                                                              node);
                             }
 
                             /* 
@@ -1154,6 +1154,80 @@ void rel_crypt_page_decrypt(RelCrypt relcrypt, Page page)
     return;
 }
 
+#ifdef __TBASE__
+/*
+ * encrypt an arbitrary buffer, used by page compression to encrypt the compressed image.
+ * the source is padded with zero to a multiple of 16 bytes, which is the block size of aes and sm4.
+ * returns the length stored in dst, or -1 if the crypted result does not fit in dstlen.
+ */
+int rel_crypt_buffer_encrypt(RelCrypt relcrypt, char *src, int srclen, char *dst, int dstlen)
+{
+    int     padlen;
+    int     len;
+    text   *need_encrypt_text;
+    text   *encrypted;
+
+    padlen = TYPEALIGN(16, srclen);
+    if (padlen > dstlen)
+    {
+        return -1;
+    }
+
+    need_encrypt_text = (text *) palloc0(VARHDRSZ + padlen);
+    SET_VARSIZE(need_encrypt_text, VARHDRSZ + padlen);
+    memcpy(VARDATA(need_encrypt_text), src, srclen);
+
+    /* run encrypt algorithm, sm4 and udf write the result to dst directly */
+    memset(dst, 0, padlen);
+    encrypted = encrypt_procedure(relcrypt->algo_id, need_encrypt_text, dst);
+    pfree(need_encrypt_text);
+
+    if (encrypted)
+    {
+        /* aes128/192/256 returns a standard text, keep the length word for decrypt */
+        len = VARSIZE_ANY(encrypted);
+        if (len > dstlen)
+        {
+            crypt_free(encrypted);
+            return -1;
+        }
+        memcpy(dst, encrypted, len);
+        crypt_free(encrypted);
+        return len;
+    }
+
+    return padlen;
+}
+
+/*
+ * reverse of rel_crypt_buffer_encrypt, buf is decrypted in place when the algorithm works in place.
+ * rawlen bytes of plain data are copied to dst.
+ */
+void rel_crypt_buffer_decrypt(int16 algo_id, char *buf, int buflen, char *dst, int rawlen)
+{
+    text  *decrypted;
+
+    decrypted = decrypt_procedure(algo_id, (text *) buf, buflen);
+
+    if (decrypted)
+    {
+        if (VARSIZE_ANY_EXHDR(decrypted) < rawlen)
+        {
+            elog(ERROR, "decrypted length:%d is less than expected:%d, algo_id:%d",
+                        (int) VARSIZE_ANY_EXHDR(decrypted), rawlen, algo_id);
+        }
+        memcpy(dst, VARDATA_ANY(decrypted), rawlen);
+    }
+    else
+    {
+        /* guomi(sm4) decrypts in place */
+        memcpy(dst, buf, rawlen);
+    }
+
+    return;
+}
+#endif
+
 /*
  * do the encrypt action
  * this function support several scenarios.
@@ -170,9 +170,11 @@ TransactionId RecentGlobalXmin = InvalidTransactionId;
 TransactionId RecentGlobalDataXmin = InvalidTransactionId;
 GlobalTimestamp RecentCommitTs = InvalidGlobalTimestamp;
 GlobalTimestamp RecentDataTs = InvalidGlobalTimestamp;
+GlobalTimestamp RecentDbDataTs = InvalidGlobalTimestamp;
 
 int     vacuum_delta;
 bool vacuum_debug_print;
+bool vacuum_database_horizon = true;
 
 
 /* (table, ctid) => (cmin, cmax) mapping during timetravel */
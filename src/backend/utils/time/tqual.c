@@ -67,6 +67,7 @@
 #include "access/transam.h"
 #include "access/xact.h"
 #include "access/xlog.h"
+#include "catalog/catalog.h"
 #include "storage/bufmgr.h"
 #include "storage/procarray.h"
 #include "utils/builtins.h"
@@ -2478,6 +2479,19 @@ HeapTupleSatisfiesMVCC(HeapTuple htup, Snapshot snapshot,
 }
 #endif
 
+#ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
+/*
+ * Data horizon for a tuple: shared catalogs are read from every database,
+ * so are their tuples of unknown origin.
+ */
+static inline GlobalTimestamp
+TupleDataHorizon(HeapTuple htup)
+{
+    return DataHorizonForRelation(!OidIsValid(htup->t_tableOid) ||
+                                  IsSharedRelation(htup->t_tableOid));
+}
+#endif
+
 /*
  * HeapTupleSatisfiesVacuum
  *
@@ -2696,15 +2710,15 @@ HeapTupleSatisfiesVacuum(HeapTuple htup, TransactionId OldestXmin,
                     
                 }
                     
-                if(!TestForOldTimestamp(committs, RecentDataTs))
+                if(!TestForOldTimestamp(committs, TupleDataHorizon(htup)))
                 {
                     if(vacuum_debug_print)
-                        elog(LOG, "vacuum RECENTLY DEAD committs "INT64_FORMAT "RecentDataTs "INT64_FORMAT, committs, RecentDataTs);
+                        elog(LOG, "vacuum RECENTLY DEAD committs "INT64_FORMAT "RecentDataTs "INT64_FORMAT, committs, TupleDataHorizon(htup));
                     return HEAPTUPLE_RECENTLY_DEAD;
                 }
 
                 if(vacuum_debug_print)
-                        elog(LOG, "vacuum DEAD committs "INT64_FORMAT "RecentDataTs "INT64_FORMAT, committs, RecentDataTs);
+                        elog(LOG, "vacuum DEAD committs "INT64_FORMAT "RecentDataTs "INT64_FORMAT, committs, TupleDataHorizon(htup));
             }
             
             return HEAPTUPLE_DEAD;
@@ -2779,14 +2793,14 @@ HeapTupleSatisfiesVacuum(HeapTuple htup, TransactionId OldestXmin,
             }
         }
 
-        if(!TestForOldTimestamp(committs, RecentDataTs))
+        if(!TestForOldTimestamp(committs, TupleDataHorizon(htup)))
         {
             if(vacuum_debug_print)
-                elog(LOG, "vacuum RECENTLY DEAD committs "INT64_FORMAT "RecentDataTs "INT64_FORMAT, committs, RecentDataTs);
+                elog(LOG, "vacuum RECENTLY DEAD committs "INT64_FORMAT "RecentDataTs "INT64_FORMAT, committs, TupleDataHorizon(htup));
             return HEAPTUPLE_RECENTLY_DEAD;
         }
         if(vacuum_debug_print)
-            elog(LOG, "vacuum  DEAD committs "INT64_FORMAT "RecentDataTs "INT64_FORMAT, committs, RecentDataTs);
+            elog(LOG, "vacuum  DEAD committs "INT64_FORMAT "RecentDataTs "INT64_FORMAT, committs, TupleDataHorizon(htup));
             
     }
     
@@ -2881,7 +2895,7 @@ HeapTupleIsSurelyDead(HeapTuple htup, TransactionId OldestXmin)
                 }
             }
 
-            if(TestForOldTimestamp(committs, RecentDataTs))
+            if(TestForOldTimestamp(committs, TupleDataHorizon(htup)))
                 return true;
 
             return false;
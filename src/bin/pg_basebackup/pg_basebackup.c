@@ -152,6 +152,12 @@ static pg_time_t last_progress_report = 0;
 static int32 maxrate = 0;        /* no limit by default */
 static char *replication_slot = NULL;
 static bool temp_replication_slot = true;
+#ifdef __TBASE__
+static int    jobs = 1;
+static int    stream_compresslevel = 0;
+static char *incremental_lsn = NULL;
+static char *incremental_reference = NULL;
+#endif
 
 static bool success = false;
 static bool made_new_pgdata = false;
@@ -175,6 +181,30 @@ static int    bgpipe[2] = {-1, -1};
 static pid_t bgchild = -1;
 static bool in_log_streamer = false;
 
+#ifdef __TBASE__
+/*
+ * The other streams of a parallel backup are received by child processes,
+ * each with its own connection.  Stream numbers start at 1 in the children.
+ */
+static pid_t *backup_stream_pids = NULL;
+static bool in_backup_stream = false;
+static int    backup_stream_no = 0;
+static char backup_stream_suffix[16] = "";
+
+/* State of the incremental file being restored */
+static IncrementalFileHeader incr_header;
+static uint32 *incr_blocks = NULL;
+static uint32 incr_next = 0;
+
+#ifdef HAVE_LIBZ
+/* Decompression of the CopyData messages */
+static z_stream copy_zstream;
+static bool copy_zstream_inited = false;
+static char *copy_zbuf = NULL;
+static size_t copy_zbuflen = 0;
+#endif
+#endif
+
 /* End position for xlog streaming, empty string if unknown yet */
 static XLogRecPtr xlogendptr;
 
@@ -198,6 +228,19 @@ static void ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum);
 static void GenerateRecoveryConf(PGconn *conn);
 static void WriteRecoveryConf(void);
 static void BaseBackup(void);
+#ifdef __TBASE__
+static int    GetCopyData(PGconn *conn, char **buffer);
+static void FreeCopyData(char *buffer);
+static void ResetCopyData(void);
+static void StartBackupStreams(const char *xlogstart);
+static int    BackupStreamMain(const char *xlogstart);
+static void WaitBackupStreams(void);
+static void WriteIncrementalData(FILE *file, const char *filename,
+                     char *data, int len);
+static void FinishIncrementalFile(FILE *file, const char *filename);
+static FILE *OpenIncrementalFile(PGresult *res, int rownum,
+                                 const char *filename, const char *relpath);
+#endif
 
 static bool reached_end_position(XLogRecPtr segendpos, uint32 timeline,
                      bool segment_finished);
@@ -211,6 +254,11 @@ cleanup_directories_atexit(void)
 {// #lizard forgives
     if (success || in_log_streamer)
         return;
+#ifdef __TBASE__
+    /* The main process cleans up for all the streams */
+    if (in_backup_stream)
+        return;
+#endif
 
     if (!noclean)
     {
@@ -284,6 +332,18 @@ disconnect_and_exit(int code)
      */
     if (bgchild > 0)
         kill(bgchild, SIGTERM);
+#ifdef __TBASE__
+    if (backup_stream_pids != NULL)
+    {
+        int            k;
+
+        for (k = 1; k < jobs; k++)
+        {
+            if (backup_stream_pids[k] > 0)
+                kill(backup_stream_pids[k], SIGTERM);
+        }
+    }
+#endif
 #endif
 
     exit(code);
@@ -404,12 +464,22 @@ usage(void)
     printf(_("      --waldir=WALDIR    location for the write-ahead log directory\n"));
     printf(_("  -z, --gzip             compress tar output\n"));
     printf(_("  -Z, --compress=0-9     compress tar output with given compression level\n"));
+#ifdef __TBASE__
+    printf(_("      --incremental=LSN  only receive the blocks changed since LSN\n"));
+    printf(_("      --reference=DIR    earlier backup to take the unchanged blocks of an\n"
+             "                         incremental backup from\n"));
+#endif
     printf(_("\nGeneral options:\n"));
     printf(_("  -c, --checkpoint=fast|spread\n"
              "                         set fast or spread checkpointing\n"));
     printf(_("  -l, --label=LABEL      set backup label\n"));
     printf(_("  -n, --no-clean         do not clean up after errors\n"));
     printf(_("  -N, --no-sync          do not wait for changes to be written safely to disk\n"));
+#ifdef __TBASE__
+    printf(_("  -j, --jobs=NUM         use this many parallel connections to receive files\n"));
+    printf(_("      --stream-compress=0-9\n"
+             "                         compress data sent by the server with given level\n"));
+#endif
     printf(_("  -P, --progress         show progress information\n"));
     printf(_("  -v, --verbose          output verbose messages\n"));
     printf(_("  -V, --version          output version information, then exit\n"));
@@ -980,6 +1050,100 @@ writeTarData(
 #define WRITE_TAR_DATA(buf, sz) writeTarData(tarfile, buf, sz, filename)
 #endif
 
+#ifdef __TBASE__
+/*
+ * Start decompressing a new COPY stream, if the server compresses it.
+ */
+static void
+ResetCopyData(void)
+{
+#ifdef HAVE_LIBZ
+    if (stream_compresslevel == 0)
+        return;
+
+    if (!copy_zstream_inited)
+    {
+        MemSet(&copy_zstream, 0, sizeof(copy_zstream));
+        if (inflateInit(&copy_zstream) != Z_OK)
+        {
+            fprintf(stderr, _("%s: could not initialize decompression library\n"),
+                    progname);
+            disconnect_and_exit(1);
+        }
+        copy_zstream_inited = true;
+    }
+    else if (inflateReset(&copy_zstream) != Z_OK)
+    {
+        fprintf(stderr, _("%s: could not reset decompression stream: %s\n"),
+                progname, copy_zstream.msg ? copy_zstream.msg : "unknown error");
+        disconnect_and_exit(1);
+    }
+#endif
+}
+
+/*
+ * PQgetCopyData for the backup stream, decompressing each message if the
+ * server compresses them.  The buffer returned must be released with
+ * FreeCopyData.
+ */
+static int
+GetCopyData(PGconn *conn, char **buffer)
+{// #lizard forgives
+#ifdef HAVE_LIBZ
+    char       *raw;
+    int            r;
+    size_t        len = 0;
+
+    if (stream_compresslevel == 0)
+        return PQgetCopyData(conn, buffer, 0);
+
+    r = PQgetCopyData(conn, &raw, 0);
+    if (r < 0)
+    {
+        *buffer = NULL;
+        return r;
+    }
+
+    copy_zstream.next_in = (Bytef *) raw;
+    copy_zstream.avail_in = r;
+    do
+    {
+        int            rc;
+
+        if (copy_zbuflen - len < 8192)
+        {
+            copy_zbuflen = Max(copy_zbuflen * 2, 65536);
+            copy_zbuf = pg_realloc(copy_zbuf, copy_zbuflen);
+        }
+        copy_zstream.next_out = (Bytef *) (copy_zbuf + len);
+        copy_zstream.avail_out = copy_zbuflen - len;
+
+        rc = inflate(&copy_zstream, Z_SYNC_FLUSH);
+        if (rc != Z_OK && rc != Z_BUF_ERROR)
+        {
+            fprintf(stderr, _("%s: could not decompress COPY data: %s\n"),
+                    progname, copy_zstream.msg ? copy_zstream.msg : "unknown error");
+            disconnect_and_exit(1);
+        }
+        len = copy_zbuflen - copy_zstream.avail_out;
+    } while (copy_zstream.avail_in > 0 || copy_zstream.avail_out == 0);
+
+    PQfreemem(raw);
+    *buffer = copy_zbuf;
+    return (int) len;
+#else
+    return PQgetCopyData(conn, buffer, 0);
+#endif
+}
+
+static void
+FreeCopyData(char *buffer)
+{
+    if (stream_compresslevel == 0)
+        PQfreemem(buffer);
+}
+#endif
+
 /*
  * Receive a tar format file from the connection to the server, and write
  * the data from this file directly into a tar file. If compression is
@@ -1041,7 +1205,8 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 #ifdef HAVE_LIBZ
             if (compresslevel != 0)
             {
-                snprintf(filename, sizeof(filename), "%s/base.tar.gz", basedir);
+                snprintf(filename, sizeof(filename), "%s/base%s.tar.gz", basedir,
+                         backup_stream_suffix);
                 ztarfile = gzopen(filename, "wb");
                 if (gzsetparams(ztarfile, compresslevel,
                                 Z_DEFAULT_STRATEGY) != Z_OK)
@@ -1055,7 +1220,8 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
             else
 #endif
             {
-                snprintf(filename, sizeof(filename), "%s/base.tar", basedir);
+                snprintf(filename, sizeof(filename), "%s/base%s.tar", basedir,
+                         backup_stream_suffix);
                 tarfile = fopen(filename, "wb");
             }
         }
@@ -1068,8 +1234,8 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 #ifdef HAVE_LIBZ
         if (compresslevel != 0)
         {
-            snprintf(filename, sizeof(filename), "%s/%s.tar.gz", basedir,
-                     PQgetvalue(res, rownum, 0));
+            snprintf(filename, sizeof(filename), "%s/%s%s.tar.gz", basedir,
+                     PQgetvalue(res, rownum, 0), backup_stream_suffix);
             ztarfile = gzopen(filename, "wb");
             if (gzsetparams(ztarfile, compresslevel,
                             Z_DEFAULT_STRATEGY) != Z_OK)
@@ -1083,8 +1249,8 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
         else
 #endif
         {
-            snprintf(filename, sizeof(filename), "%s/%s.tar", basedir,
-                     PQgetvalue(res, rownum, 0));
+            snprintf(filename, sizeof(filename), "%s/%s%s.tar", basedir,
+                     PQgetvalue(res, rownum, 0), backup_stream_suffix);
             tarfile = fopen(filename, "wb");
         }
     }
@@ -1123,6 +1289,9 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
                 progname, PQerrorMessage(conn));
         disconnect_and_exit(1);
     }
+#ifdef __TBASE__
+    ResetCopyData();
+#endif
 
     while (1)
     {
@@ -1130,11 +1299,19 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 
         if (copybuf != NULL)
         {
+#ifdef __TBASE__
+            FreeCopyData(copybuf);
+#else
             PQfreemem(copybuf);
+#endif
             copybuf = NULL;
         }
 
+#ifdef __TBASE__
+        r = GetCopyData(conn, &copybuf);
+#else
         r = PQgetCopyData(conn, &copybuf, 0);
+#endif
         if (r == -1)
         {
             /*
@@ -1327,7 +1504,11 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
     progress_report(rownum, filename, true);
 
     if (copybuf != NULL)
+#ifdef __TBASE__
+        FreeCopyData(copybuf);
+#else
         PQfreemem(copybuf);
+#endif
 
     /* sync the resulting tar file, errors are not considered fatal */
     if (do_sync && strcmp(basedir, "-") != 0)
@@ -1372,6 +1553,9 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
     bool        basetablespace;
     char       *copybuf = NULL;
     FILE       *file = NULL;
+#ifdef __TBASE__
+    bool        incremental_file = false;
+#endif
 
     basetablespace = PQgetisnull(res, rownum, 0);
     if (basetablespace)
@@ -1391,6 +1575,9 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
                 progname, PQerrorMessage(conn));
         disconnect_and_exit(1);
     }
+#ifdef __TBASE__
+    ResetCopyData();
+#endif
 
     while (1)
     {
@@ -1398,11 +1585,19 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 
         if (copybuf != NULL)
         {
+#ifdef __TBASE__
+            FreeCopyData(copybuf);
+#else
             PQfreemem(copybuf);
+#endif
             copybuf = NULL;
         }
 
+#ifdef __TBASE__
+        r = GetCopyData(conn, &copybuf);
+#else
         r = PQgetCopyData(conn, &copybuf, 0);
+#endif
 
         if (r == -1)
         {
@@ -1477,7 +1672,15 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
                         if (!((pg_str_endswith(filename, "/pg_wal") ||
                                pg_str_endswith(filename, "/pg_xlog") ||
                                pg_str_endswith(filename, "/archive_status")) &&
-                              errno == EEXIST))
+                              errno == EEXIST)
+#ifdef __TBASE__
+                            /*
+                             * Every stream of a parallel backup sends all the
+                             * directories.
+                             */
+                            && !(jobs > 1 && errno == EEXIST)
+#endif
+                            )
                         {
                             fprintf(stderr,
                                     _("%s: could not create directory \"%s\": %s\n"),
@@ -1531,6 +1734,17 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
             /*
              * regular file
              */
+#ifdef __TBASE__
+            incremental_file = incremental_lsn &&
+                pg_str_endswith(filename, INCREMENTAL_FILE_SUFFIX);
+            if (incremental_file)
+            {
+                filename[strlen(filename) - strlen(INCREMENTAL_FILE_SUFFIX)] = '\0';
+                copybuf[strlen(copybuf) - strlen(INCREMENTAL_FILE_SUFFIX)] = '\0';
+                file = OpenIncrementalFile(res, rownum, filename, copybuf);
+            }
+            else
+#endif
             file = fopen(filename, "wb");
             if (!file)
             {
@@ -1566,12 +1780,21 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
                  * Received the padding block for this file, ignore it and
                  * close the file, then move on to the next tar header.
                  */
+#ifdef __TBASE__
+                if (incremental_file)
+                    FinishIncrementalFile(file, filename);
+#endif
                 fclose(file);
                 file = NULL;
                 totaldone += r;
                 continue;
             }
 
+#ifdef __TBASE__
+            if (incremental_file)
+                WriteIncrementalData(file, filename, copybuf, r);
+            else
+#endif
             if (fwrite(copybuf, r, 1, file) != 1)
             {
                 fprintf(stderr, _("%s: could not write to file \"%s\": %s\n"),
@@ -1589,6 +1812,10 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
                  * expected. Close the file and move on to the next tar
                  * header.
                  */
+#ifdef __TBASE__
+                if (incremental_file)
+                    FinishIncrementalFile(file, filename);
+#endif
                 fclose(file);
                 file = NULL;
                 continue;
@@ -1606,7 +1833,11 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
     }
 
     if (copybuf != NULL)
+#ifdef __TBASE__
+        FreeCopyData(copybuf);
+#else
         PQfreemem(copybuf);
+#endif
 
     if (basetablespace && writerecoveryconf)
         WriteRecoveryConf();
@@ -1617,6 +1848,333 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
      */
 }
 
+#ifdef __TBASE__
+/*
+ * Apply a CopyData message of an incremental file to the file of the earlier
+ * backup: first the header and the numbers of the blocks sent, then each
+ * block in its own message.
+ */
+static void
+WriteIncrementalData(FILE *file, const char *filename, char *data, int len)
+{// #lizard forgives
+    if (incr_blocks == NULL)
+    {
+        pgoff_t        cursize;
+        uint32        blkno;
+        uint32        i = 0;
+
+        if (len < sizeof(IncrementalFileHeader))
+        {
+            fprintf(stderr, _("%s: invalid incremental file header in \"%s\"\n"),
+                    progname, filename);
+            disconnect_and_exit(1);
+        }
+        memcpy(&incr_header, data, sizeof(IncrementalFileHeader));
+        if (incr_header.magic != INCREMENTAL_FILE_MAGIC ||
+            incr_header.blcksz == 0 ||
+            len != sizeof(IncrementalFileHeader) +
+            (size_t) incr_header.nchanged * sizeof(uint32))
+        {
+            fprintf(stderr, _("%s: invalid incremental file header in \"%s\"\n"),
+                    progname, filename);
+            disconnect_and_exit(1);
+        }
+
+        incr_blocks = pg_malloc(sizeof(uint32) * Max(incr_header.nchanged, 1));
+        memcpy(incr_blocks, data + sizeof(IncrementalFileHeader),
+               sizeof(uint32) * incr_header.nchanged);
+        incr_next = 0;
+
+        /*
+         * The blocks not sent must be in the earlier backup.  They are not if
+         * the relation was created by copying files, as CREATE DATABASE does.
+         */
+        if (fseeko(file, 0, SEEK_END) != 0 || (cursize = ftello(file)) < 0)
+        {
+            fprintf(stderr, _("%s: could not seek in file \"%s\": %s\n"),
+                    progname, filename, strerror(errno));
+            disconnect_and_exit(1);
+        }
+        for (blkno = cursize / incr_header.blcksz; blkno < incr_header.nblocks; blkno++)
+        {
+            while (i < incr_header.nchanged && incr_blocks[i] < blkno)
+                i++;
+            if (i >= incr_header.nchanged || incr_blocks[i] != blkno)
+            {
+                fprintf(stderr,
+                        _("%s: block %u of file \"%s\" is missing from the earlier backup, take a full backup instead\n"),
+                        progname, blkno, filename);
+                disconnect_and_exit(1);
+            }
+        }
+        return;
+    }
+
+    if (incr_next >= incr_header.nchanged || len != incr_header.blcksz)
+    {
+        fprintf(stderr, _("%s: unexpected data in incremental file \"%s\"\n"),
+                progname, filename);
+        disconnect_and_exit(1);
+    }
+
+    if (fseeko(file, (pgoff_t) incr_blocks[incr_next] * incr_header.blcksz,
+               SEEK_SET) != 0)
+    {
+        fprintf(stderr, _("%s: could not seek in file \"%s\": %s\n"),
+                progname, filename, strerror(errno));
+        disconnect_and_exit(1);
+    }
+    if (fwrite(data, len, 1, file) != 1)
+    {
+        fprintf(stderr, _("%s: could not write to file \"%s\": %s\n"),
+                progname, filename, strerror(errno));
+        disconnect_and_exit(1);
+    }
+    incr_next++;
+}
+
+/*
+ * Cut the restored file to its length on the server.
+ */
+static void
+FinishIncrementalFile(FILE *file, const char *filename)
+{
+    if (incr_blocks == NULL || incr_next != incr_header.nchanged)
+    {
+        fprintf(stderr, _("%s: incremental file \"%s\" is incomplete\n"),
+                progname, filename);
+        disconnect_and_exit(1);
+    }
+
+    if (fflush(file) != 0 ||
+        ftruncate(fileno(file),
+                  (pgoff_t) incr_header.nblocks * incr_header.blcksz) != 0)
+    {
+        fprintf(stderr, _("%s: could not truncate file \"%s\": %s\n"),
+                progname, filename, strerror(errno));
+        disconnect_and_exit(1);
+    }
+
+    free(incr_blocks);
+    incr_blocks = NULL;
+}
+
+/*
+ * Open 'filename' of this incremental backup for the changed blocks to be
+ * written into, starting from a copy of the same file in the reference
+ * backup.  'relpath' is the name of the file within the tablespace of row
+ * 'rownum' of 'res'.  A file missing from the reference backup starts
+ * empty, and must then be sent in full.
+ */
+static FILE *
+OpenIncrementalFile(PGresult *res, int rownum, const char *filename,
+                    const char *relpath)
+{
+    char        refpath[MAXPGPATH];
+    char        buf[65536];
+    FILE       *src;
+    FILE       *dst;
+    size_t      nread;
+
+    if (PQgetisnull(res, rownum, 0))
+        snprintf(refpath, sizeof(refpath), "%s/%s",
+                 incremental_reference, relpath);
+    else
+        snprintf(refpath, sizeof(refpath), "%s/pg_tblspc/%s/%s",
+                 incremental_reference, PQgetvalue(res, rownum, 0), relpath);
+
+    dst = fopen(filename, "w+b");
+    if (dst == NULL)
+        return NULL;
+
+    src = fopen(refpath, "rb");
+    if (src == NULL)
+    {
+        if (errno == ENOENT)
+            return dst;
+        fprintf(stderr, _("%s: could not open file \"%s\": %s\n"),
+                progname, refpath, strerror(errno));
+        disconnect_and_exit(1);
+    }
+
+    while ((nread = fread(buf, 1, sizeof(buf), src)) > 0)
+    {
+        if (fwrite(buf, 1, nread, dst) != nread)
+        {
+            fprintf(stderr, _("%s: could not write to file \"%s\": %s\n"),
+                    progname, filename, strerror(errno));
+            disconnect_and_exit(1);
+        }
+    }
+    if (ferror(src))
+    {
+        fprintf(stderr, _("%s: could not read file \"%s\": %s\n"),
+                progname, refpath, strerror(errno));
+        disconnect_and_exit(1);
+    }
+    fclose(src);
+
+    return dst;
+}
+
+#ifndef WIN32
+/*
+ * Start a child process with its own connection for each of the other
+ * streams of the parallel backup started at 'xlogstart'.
+ */
+static void
+StartBackupStreams(const char *xlogstart)
+{
+    int            k;
+
+    backup_stream_pids = pg_malloc0(sizeof(pid_t) * jobs);
+
+    /* Don't let the children print our buffered output again */
+    fflush(stdout);
+    fflush(stderr);
+
+    for (k = 1; k < jobs; k++)
+    {
+        pid_t        pid = fork();
+
+        if (pid == 0)
+        {
+            /*
+             * The connection and the processes of the parent are not ours to
+             * use, close or kill.
+             */
+            conn = NULL;
+            bgchild = -1;
+            backup_stream_pids = NULL;
+            in_backup_stream = true;
+            backup_stream_no = k;
+            snprintf(backup_stream_suffix, sizeof(backup_stream_suffix),
+                     ".%d", k);
+            exit(BackupStreamMain(xlogstart));
+        }
+        else if (pid < 0)
+        {
+            fprintf(stderr, _("%s: could not create background process: %s\n"),
+                    progname, strerror(errno));
+            disconnect_and_exit(1);
+        }
+        backup_stream_pids[k] = pid;
+    }
+}
+
+/*
+ * Receive one of the other streams of a parallel backup, in a child process.
+ */
+static int
+BackupStreamMain(const char *xlogstart)
+{// #lizard forgives
+    PGresult   *res;
+    char       *cmd;
+    int            i;
+
+    /* Only the main process reports progress and writes recovery.conf */
+    showprogress = false;
+    writerecoveryconf = false;
+
+    conn = GetConnection();
+    if (!conn)
+        /* Error message already written in GetConnection() */
+        return 1;
+
+    cmd = psprintf("BASE_BACKUP PARALLEL %d STREAM %d %s",
+                   jobs, backup_stream_no, xlogstart);
+    if (stream_compresslevel > 0)
+        cmd = psprintf("%s COMPRESS %d", cmd, stream_compresslevel);
+    if (incremental_lsn)
+        cmd = psprintf("%s INCREMENTAL %s", cmd, incremental_lsn);
+    if (maxrate > 0)
+        cmd = psprintf("%s MAX_RATE %u", cmd, maxrate);
+
+    if (PQsendQuery(conn, cmd) == 0)
+    {
+        fprintf(stderr, _("%s: could not send replication command \"%s\": %s"),
+                progname, "BASE_BACKUP", PQerrorMessage(conn));
+        disconnect_and_exit(1);
+    }
+
+    res = PQgetResult(conn);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK)
+    {
+        fprintf(stderr, _("%s: could not get backup header: %s"),
+                progname, PQerrorMessage(conn));
+        disconnect_and_exit(1);
+    }
+
+    for (i = 0; i < PQntuples(res); i++)
+    {
+        if (format == 't')
+            ReceiveTarFile(conn, res, i);
+        else
+            ReceiveAndUnpackTarFile(conn, res, i);
+    }
+    PQclear(res);
+
+    res = PQgetResult(conn);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK)
+    {
+        fprintf(stderr, _("%s: final receive failed: %s"),
+                progname, PQerrorMessage(conn));
+        disconnect_and_exit(1);
+    }
+    PQclear(res);
+    PQfinish(conn);
+    conn = NULL;
+
+    return 0;
+}
+
+/*
+ * Wait for the processes receiving the other streams to exit.
+ */
+static void
+WaitBackupStreams(void)
+{
+    int            k;
+
+    for (k = 1; k < jobs; k++)
+    {
+        int            status;
+
+        if (waitpid(backup_stream_pids[k], &status, 0) != backup_stream_pids[k])
+        {
+            fprintf(stderr, _("%s: could not wait for child process: %s\n"),
+                    progname, strerror(errno));
+            disconnect_and_exit(1);
+        }
+        backup_stream_pids[k] = -1;
+
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        {
+            fprintf(stderr, _("%s: stream %d of the backup failed\n"),
+                    progname, k);
+            disconnect_and_exit(1);
+        }
+    }
+}
+#else
+static void
+StartBackupStreams(const char *xlogstart)
+{
+}
+
+static int
+BackupStreamMain(const char *xlogstart)
+{
+    return 0;
+}
+
+static void
+WaitBackupStreams(void)
+{
+}
+#endif                            /* WIN32 */
+#endif                            /* __TBASE__ */
+
 /*
  * Escape a string so that it can be used as a value in a key-value pair
  * a configuration file.
@@ -1826,6 +2384,14 @@ BaseBackup(void)
 				 includewal == NO_WAL ? "" : "NOWAIT",
 				 maxrate_clause ? maxrate_clause : "",
 				 format == 't' ? "TABLESPACE_MAP" : "");
+#ifdef __TBASE__
+	if (jobs > 1)
+		basebkp = psprintf("%s PARALLEL %d", basebkp, jobs);
+	if (stream_compresslevel > 0)
+		basebkp = psprintf("%s COMPRESS %d", basebkp, stream_compresslevel);
+	if (incremental_lsn)
+		basebkp = psprintf("%s INCREMENTAL %s", basebkp, incremental_lsn);
+#endif
 	if (PQsendQuery(conn, basebkp) == 0)
 	{
 		fprintf(stderr, _("%s: could not send replication command \"%s\": %s"),
@@ -1866,6 +2432,11 @@ BaseBackup(void)
 	if (verbose && includewal != NO_WAL)
 		fprintf(stderr, _("%s: write-ahead log start point: %s on timeline %u\n"),
 				progname, xlogstart, starttli);
+#ifdef __TBASE__
+	/* The other streams of a parallel backup attach to this one */
+	if (jobs > 1)
+		StartBackupStreams(xlogstart);
+#endif
 	/*
 	 * Get the header
 	 */
@@ -1936,6 +2507,14 @@ BaseBackup(void)
 		progress_report(PQntuples(res), NULL, true);
 		fprintf(stderr, "\n");	/* Need to move to next line */
 	}
+#ifdef __TBASE__
+	/*
+	 * The server returns the end position once all the streams are sent, so
+	 * the children are about done.
+	 */
+	if (jobs > 1)
+		WaitBackupStreams();
+#endif
 	PQclear(res);
 	/*
 	 * Get the stop position
@@ -2119,6 +2698,12 @@ main(int argc, char **argv)
         {"progress", no_argument, NULL, 'P'},
         {"waldir", required_argument, NULL, 1},
         {"no-slot", no_argument, NULL, 2},
+#ifdef __TBASE__
+        {"jobs", required_argument, NULL, 'j'},
+        {"stream-compress", required_argument, NULL, 3},
+        {"incremental", required_argument, NULL, 4},
+        {"reference", required_argument, NULL, 5},
+#endif
         {NULL, 0, NULL, 0}
     };
     int            c;
@@ -2146,7 +2731,7 @@ main(int argc, char **argv)
 
     atexit(cleanup_directories_atexit);
 
-    while ((c = getopt_long(argc, argv, "D:F:r:RT:X:l:nNzZ:d:c:h:p:U:s:S:wWvP",
+    while ((c = getopt_long(argc, argv, "D:F:r:RT:X:l:nNzZ:d:c:h:p:U:s:S:wWvPj:",
                             long_options, &option_index)) != -1)
     {
         switch (c)
@@ -2285,6 +2870,44 @@ main(int argc, char **argv)
             case 'P':
                 showprogress = true;
                 break;
+#ifdef __TBASE__
+            case 'j':
+                jobs = atoi(optarg);
+                if (jobs < 1 || jobs > 64)
+                {
+                    fprintf(stderr, _("%s: invalid number of parallel jobs \"%s\", must be between 1 and 64\n"),
+                            progname, optarg);
+                    exit(1);
+                }
+                break;
+            case 3:
+                stream_compresslevel = atoi(optarg);
+                if (stream_compresslevel < 0 || stream_compresslevel > 9)
+                {
+                    fprintf(stderr, _("%s: invalid compression level \"%s\"\n"),
+                            progname, optarg);
+                    exit(1);
+                }
+                break;
+            case 4:
+                {
+                    uint32        hi;
+                    uint32        lo;
+
+                    if (sscanf(optarg, "%X/%X", &hi, &lo) != 2)
+                    {
+                        fprintf(stderr, _("%s: could not parse incremental start position \"%s\"\n"),
+                                progname, optarg);
+                        exit(1);
+                    }
+                    incremental_lsn = psprintf("%X/%X", hi, lo);
+                }
+                break;
+            case 5:
+                incremental_reference = pg_strdup(optarg);
+                canonicalize_path(incremental_reference);
+                break;
+#endif
             default:
 
                 /*
@@ -2399,6 +3022,81 @@ main(int argc, char **argv)
                 progname);
         exit(1);
     }
+#ifdef __TBASE__
+    if (stream_compresslevel != 0)
+    {
+        fprintf(stderr,
+                _("%s: this build does not support compression\n"),
+                progname);
+        exit(1);
+    }
+#endif
+#endif
+
+#ifdef __TBASE__
+    if (jobs > 1)
+    {
+#ifdef WIN32
+        fprintf(stderr,
+                _("%s: parallel jobs are not supported on this platform\n"),
+                progname);
+        exit(1);
+#endif
+        if (strcmp(basedir, "-") == 0)
+        {
+            fprintf(stderr,
+                    _("%s: cannot write a parallel backup to stdout\n"),
+                    progname);
+            fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+                    progname);
+            exit(1);
+        }
+    }
+
+    if (incremental_lsn)
+    {
+        char        path[MAXPGPATH];
+        struct stat st;
+
+        if (format != 'p' || strcmp(xlog_dir, "") != 0)
+        {
+            fprintf(stderr,
+                    _("%s: incremental backups can only be taken in plain mode, without a separate WAL directory\n"),
+                    progname);
+            fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+                    progname);
+            exit(1);
+        }
+
+        if (incremental_reference == NULL)
+        {
+            fprintf(stderr,
+                    _("%s: an incremental backup needs the earlier backup given with --reference\n"),
+                    progname);
+            fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+                    progname);
+            exit(1);
+        }
+
+        /* The unchanged blocks are copied from the earlier backup */
+        snprintf(path, sizeof(path), "%s/global/pg_control", incremental_reference);
+        if (stat(path, &st) != 0)
+        {
+            fprintf(stderr,
+                    _("%s: directory \"%s\" does not contain an earlier backup\n"),
+                    progname, incremental_reference);
+            exit(1);
+        }
+    }
+    else if (incremental_reference)
+    {
+        fprintf(stderr,
+                _("%s: --reference can only be used with --incremental\n"),
+                progname);
+        fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+                progname);
+        exit(1);
+    }
 #endif
 
     /*
@@ -2,9 +2,11 @@ use strict;
 use warnings;
 use Cwd;
 use Config;
+use Digest::MD5;
+use File::Find;
 use PostgresNode;
 use TestLib;
-use Test::More tests => 72;
+use Test::More tests => 79;
 
 program_help_ok('pg_basebackup');
 program_version_ok('pg_basebackup');
@@ -288,3 +290,89 @@ like(
 	slurp_file("$tempdir/backupxs_sl_R/recovery.conf"),
 	qr/^primary_slot_name = 'slot1'\n/m,
 	'recovery.conf sets primary_slot_name');
+
+# Incremental backup on top of a full one, both received with several
+# connections.  The full backup is only read, and the incremental one
+# starts as a complete data directory.
+$node->safe_psql(
+	'postgres', q{
+CREATE TABLE incr_tab (a int PRIMARY KEY, b text);
+INSERT INTO incr_tab SELECT i, md5(i::text) FROM generate_series(1, 20000) i;
+CREATE TABLE incr_drop (a int);
+INSERT INTO incr_drop SELECT generate_series(1, 1000);
+});
+my $drop_path =
+  $node->safe_psql('postgres', q{SELECT pg_relation_filepath('incr_drop')});
+
+my $backup_dir = $node->backup_dir;
+$node->command_ok(
+	[ 'pg_basebackup', '-D', "$backup_dir/full", '-j', '3' ],
+	'pg_basebackup -j runs');
+
+$node->safe_psql(
+	'postgres', q{
+UPDATE incr_tab SET b = 'upd' WHERE a % 10 = 0;
+DELETE FROM incr_tab WHERE a % 7 = 0;
+INSERT INTO incr_tab SELECT i, md5(i::text) FROM generate_series(20001, 25000) i;
+VACUUM incr_tab;
+DROP TABLE incr_drop;
+CREATE TABLE incr_new AS SELECT generate_series(1, 500) AS a;
+});
+
+# checksum of every file of a directory, to see that it was left alone
+sub dir_checksum
+{
+	my ($dir) = @_;
+	my $md5 = Digest::MD5->new;
+
+	find(
+		{   wanted => sub {
+				return unless -f $_;
+				open my $fh, '<', $_ or die "could not open $_: $!";
+				binmode $fh;
+				$md5->add($File::Find::name);
+				$md5->addfile($fh);
+				close $fh;
+			},
+			preprocess => sub { sort @_ },
+			no_chdir   => 1 },
+		$dir);
+	return $md5->hexdigest;
+}
+
+my $full_checksum = dir_checksum("$backup_dir/full");
+my ($incr_lsn) =
+  slurp_file("$backup_dir/full/backup_label") =~ /^START WAL LOCATION: (\S+)/m;
+
+$node->command_fails(
+	[   'pg_basebackup', '-D', "$backup_dir/incr_fail",
+		"--incremental=$incr_lsn" ],
+	'pg_basebackup --incremental fails without --reference');
+$node->command_ok(
+	[   'pg_basebackup', '-D', "$backup_dir/incr",
+		"--incremental=$incr_lsn", "--reference=$backup_dir/full",
+		'-j', '3' ],
+	'pg_basebackup --incremental -j runs');
+is(dir_checksum("$backup_dir/full"),
+	$full_checksum, 'earlier backup not modified by the incremental one');
+ok(!-f "$backup_dir/incr/$drop_path",
+	'relation dropped since the earlier backup not in the incremental one');
+
+my $node_incr = get_new_node('incr');
+$node_incr->init_from_backup($node, 'incr');
+$node_incr->start;
+
+my $incr_check = q{
+SELECT count(*), sum(a), md5(string_agg(b, ',' ORDER BY a)) FROM incr_tab;
+SELECT count(*), sum(a) FROM incr_new;
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SELECT count(*), sum(a) FROM incr_tab WHERE a > 0;
+};
+is($node_incr->safe_psql('postgres', $incr_check),
+	$node->safe_psql('postgres', $incr_check),
+	'restored incremental backup has the data at the time it was taken');
+is($node_incr->safe_psql('postgres',
+		q{SELECT count(*) FROM pg_class WHERE relname = 'incr_drop'}),
+	'0', 'dropped relation not in the restored incremental backup');
+$node_incr->stop;
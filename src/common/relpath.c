@@ -104,6 +104,9 @@ const char *const forkNames[] = {
     "extent",                    /* EXTENT_FORKNUM */
 #endif
     "init"                        /* INIT_FORKNUM */
+#ifdef __TBASE__
+    ,"pca"                        /* PAGE_COMPRESS_FORKNUM */
+#endif
 };
 
 /*
@@ -122,11 +125,19 @@ forkname_to_number(const char *forkName)
             return forkNum;
 
 #ifndef FRONTEND
+#ifdef __TBASE__
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+             errmsg("invalid fork name"),
+             errhint("Valid fork names are \"main\", \"fsm\", "
+                     "\"vm\", \"extent\", \"init\", and \"pca\".")));
+#else
     ereport(ERROR,
             (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
              errmsg("invalid fork name"),
              errhint("Valid fork names are \"main\", \"fsm\", "
                      "\"vm\", and \"init\".")));
+#endif
 #endif
 
     return InvalidForkNumber;
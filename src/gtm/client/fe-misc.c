@@ -47,6 +47,8 @@
 #include "gtm/libpq-fe.h"
 #include "gtm/libpq-int.h"
 
+gtmpq_wait_hook_type gtmpq_wait_hook = NULL;
+
 static int    gtmpqPutMsgBytes(const void *buf, size_t len, GTM_Conn *conn);
 static int    gtmpqSendSome(GTM_Conn *conn, int len);
 static int gtmpqSocketCheck(GTM_Conn *conn, int forRead, int forWrite,
@@ -881,8 +883,14 @@ gtmpqWaitTimed(int forRead, int forWrite, GTM_Conn *conn, time_t finish_time)
 {
     int            result;
 
+    if (forRead && gtmpq_wait_hook)
+        gtmpq_wait_hook(true);
+
     result = gtmpqSocketCheck(conn, forRead, forWrite, finish_time);
 
+    if (forRead && gtmpq_wait_hook)
+        gtmpq_wait_hook(false);
+
     if (result < 0)
         return EOF;                /* errorMessage is already set */
 
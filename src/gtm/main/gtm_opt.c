@@ -69,6 +69,8 @@ extern char     *synchronous_standby_names;
 extern char     *application_name;
 extern bool      enalbe_gtm_xlog_debug;
 extern char     *recovery_command;
+extern char     *restore_command;
+extern int      standby_catchup_jobs;
 extern char     *recovery_target_timestamp;
 
 extern char*   GTMStartupGTSSet;
@@ -373,6 +375,17 @@ struct config_int ConfigureNamesInt[] =
 		500, 0, INT_MAX,
 		0, NULL
 	},
+	{
+		{
+			GTM_OPTNAME_STANDBY_CATCHUP_JOBS, GTMC_STARTUP,
+			gettext_noop("Number of xlog segments a standby restores from the archive at the same time when catching up, 0 to disable."),
+			NULL,
+			0
+		},
+		&standby_catchup_jobs,
+		4, 0, 64, NULL, NULL,
+		0, NULL
+	},
 #endif
 	{
         {
@@ -613,6 +626,17 @@ struct config_string ConfigureNamesString[] =
 		NULL, NULL,
 		NULL, NULL
 	},
+	{
+		{GTM_OPTNAME_RESTORE_COMMAND, GTMC_STARTUP,
+		 	gettext_noop("Command a standby uses to fetch archived xlog when catching up"),
+		 	NULL,
+		 	0
+		},
+		&restore_command,
+		NULL,
+		NULL, NULL,
+		NULL, NULL
+	},
 	{
 		{GTM_OPTNAME_RECOVERY_TARGET_GLOBALTIMESTAMP, GTMC_STARTUP,
 		 gettext_noop("Point in time recovery,recovery timestamp"),
@@ -82,6 +82,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <signal.h>
+#include <sys/wait.h>
 #include <inttypes.h>
 #include <sys/epoll.h>
 #include <gtm/gtm_standby.h>
@@ -130,6 +131,9 @@ extern bool             recovery_pitr_mode;
 
 extern int  GTMStartupGTSDelta;
 
+extern char *restore_command;
+extern int   standby_catchup_jobs;
+
 static bool      g_recovery_finish;
 static bool     *g_GTMStoreDirtyMap;
 static GTM_MutexLock g_CheckPointLock;
@@ -3943,6 +3947,255 @@ CopyXLogRecordToBuff(char *data,XLogRecPtr start,XLogRecPtr end,size_t size)
     return true;
 }
 
+/*
+ * A segment being restored from the archive by restore_command.
+ */
+typedef struct XLogRestoreSlot
+{
+    pid_t       pid;
+    XLogSegNo   segment_no;
+    char        path[MAXFNAMELEN * 2];
+} XLogRestoreSlot;
+
+#define MAX_CATCHUP_JOBS 64
+
+/*
+ * Run restore_command in a child process to fetch a segment into
+ * gtm_xlog/restore.
+ */
+static bool
+StartXLogRestore(XLogRestoreSlot *slot,TimeLineID timeline,XLogSegNo segment_no)
+{
+    char command[MAX_COMMAND_LEN];
+    char file_name[MAXFNAMELEN];
+
+    GTMXLogFileNameWithoutGtmDir(file_name,timeline,segment_no);
+    snprintf(slot->path,sizeof(slot->path),"gtm_xlog/restore/%s",file_name);
+    unlink(slot->path);
+
+    GetFormatedCommandLine(command,MAX_COMMAND_LEN,restore_command,file_name,slot->path);
+
+    if(enalbe_gtm_xlog_debug)
+        elog(LOG,"%s",command);
+
+    slot->segment_no = segment_no;
+    slot->pid        = fork();
+    if(slot->pid == 0)
+    {
+        execl("/bin/sh","sh","-c",command,(char *)NULL);
+        _exit(127);
+    }
+
+    if(slot->pid < 0)
+    {
+        elog(LOG,"could not fork restore command %s : %s",command,strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Wait for the restore of a segment, true if restore_command succeeded.
+ */
+static bool
+WaitXLogRestore(XLogRestoreSlot *slot)
+{
+    int status;
+
+    while(waitpid(slot->pid,&status,0) < 0)
+    {
+        if(errno != EINTR)
+        {
+            elog(LOG,"could not wait for restore command : %s",strerror(errno));
+            slot->pid = -1;
+            return false;
+        }
+    }
+    slot->pid = -1;
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/*
+ * Read a restored segment into buff, returns its length or -1.
+ */
+static int
+ReadRestoredXLog(XLogRestoreSlot *slot,char *buff)
+{
+    int      fd;
+    int      total = 0;
+    ssize_t  bytes;
+
+    fd = open(slot->path,O_RDONLY);
+    if(fd == -1)
+    {
+        elog(LOG,"Fail to open restored xlog %s : %s",slot->path,strerror(errno));
+        return -1;
+    }
+
+    while(total < GTM_XLOG_SEG_SIZE)
+    {
+        bytes = read(fd,buff + total,GTM_XLOG_SEG_SIZE - total);
+        if(bytes < 0)
+        {
+            elog(LOG,"Read restored xlog %s fails : %s",slot->path,strerror(errno));
+            close(fd);
+            return -1;
+        }
+        if(bytes == 0)
+            break;
+        total += bytes;
+    }
+
+    close(fd);
+    unlink(slot->path);
+    return total;
+}
+
+/*
+ * Catch up a standby from the archive before streaming.
+ *
+ * Up to standby_catchup_jobs segments are fetched by restore_command at the
+ * same time, and applied in order as they arrive, the same way as the xlog
+ * received from the active GTM; the redoer replays them meanwhile.  Catch-up
+ * stops at the first segment that cannot be restored, normally the one the
+ * active GTM has not archived yet, and streaming takes over from there.
+ */
+void
+GTM_StandbyRestoreArchivedXLog(void)
+{// #lizard forgives
+    XLogRestoreSlot  slots[MAX_CATCHUP_JOBS];
+    XLogRecPtr       start_pos;
+    XLogRecPtr       end_pos;
+    XLogSegNo        next_fetch;
+    XLogSegNo        next_apply;
+    XLogSegNo        first_segment;
+    TimeLineID       timeline;
+    char            *buff;
+    int              jobs;
+    int              length;
+    int              offset;
+    bool             stop = false;
+
+    if(restore_command == NULL || restore_command[0] == '\0' || standby_catchup_jobs <= 0)
+        return;
+
+    start_pos = GetStandbyWriteBuffPos();
+    if(start_pos == InvalidXLogRecPtr)
+        return;
+
+    if(mkdir("gtm_xlog/restore",S_IRWXU) != 0 && errno != EEXIST)
+    {
+        elog(LOG,"could not create directory gtm_xlog/restore : %s",strerror(errno));
+        return;
+    }
+
+    jobs     = MIN(standby_catchup_jobs,MAX_CATCHUP_JOBS);
+    timeline = GetCurrentTimeLineID();
+    buff     = palloc(GTM_XLOG_SEG_SIZE);
+
+    first_segment = next_fetch = next_apply = GetSegmentNo(start_pos);
+
+    elog(LOG,"standby catch-up from archive starts at %X/%X with %d jobs",
+         (uint32)(start_pos >> 32),(uint32)start_pos,jobs);
+
+    for(;;)
+    {
+        XLogRestoreSlot *slot;
+
+        /* keep the next segments being fetched */
+        while(!stop && next_fetch - next_apply < jobs)
+        {
+            if(!StartXLogRestore(&slots[next_fetch % jobs],timeline,next_fetch))
+            {
+                stop = true;
+                break;
+            }
+            next_fetch++;
+        }
+
+        if(next_apply == next_fetch)
+            break;
+
+        slot = &slots[next_apply % jobs];
+        if(!WaitXLogRestore(slot))
+        {
+            if(enalbe_gtm_xlog_debug)
+                elog(LOG,"xlog segment " UINT64_FORMAT " not in archive",slot->segment_no);
+            unlink(slot->path);
+            stop = true;
+            break;
+        }
+
+        length = ReadRestoredXLog(slot,buff);
+
+        /* the standby may be in the middle of this segment */
+        start_pos = GetStandbyWriteBuffPos();
+        offset    = XLogRecPtrToBuffIdx(start_pos);
+        if(GetSegmentNo(start_pos) != next_apply)
+        {
+            start_pos = next_apply * GTM_XLOG_SEG_SIZE;
+            offset    = 0;
+        }
+
+        if(length < offset)
+        {
+            elog(LOG,"restored xlog segment " UINT64_FORMAT " is shorter than the standby's",slot->segment_no);
+            stop = true;
+            break;
+        }
+
+        end_pos = next_apply * GTM_XLOG_SEG_SIZE + length;
+        if(end_pos > start_pos)
+        {
+            if(XLogInCurrentSegment(start_pos) == false)
+            {
+                XLogFlush(GetStandbyWriteBuffPos());
+                SwitchXLogFile();
+            }
+
+            CopyXLogRecordToBuff(buff + offset,start_pos,end_pos,(uint64)(end_pos - start_pos));
+            NotifyReplication(end_pos);
+            UpdateStandbyWriteBuffPos(end_pos);
+            XLogFlush(end_pos);
+        }
+        next_apply++;
+
+        if(GTM_SHUTTING_DOWN == GTMTransactions.gt_gtm_state || Recovery_IsStandby() == false)
+        {
+            stop = true;
+            break;
+        }
+
+        /* a segment not full is the last one archived */
+        if(length < GTM_XLOG_SEG_SIZE)
+        {
+            stop = true;
+            break;
+        }
+    }
+
+    /* cancel the fetches left */
+    for(; next_apply < next_fetch; next_apply++)
+    {
+        XLogRestoreSlot *slot = &slots[next_apply % jobs];
+
+        if(slot->pid > 0)
+        {
+            kill(slot->pid,SIGTERM);
+            WaitXLogRestore(slot);
+        }
+        unlink(slot->path);
+    }
+
+    pfree(buff);
+
+    end_pos = GetStandbyWriteBuffPos();
+    elog(LOG,"standby catch-up from archive restored " UINT64_FORMAT " segments, streaming from %X/%X",
+         GetSegmentNo(end_pos) - first_segment,
+         (uint32)(end_pos >> 32),(uint32)end_pos);
+}
+
 
 static void
 gtm_init_replication_data(GTM_StandbyReplication *replication)
@@ -113,6 +113,8 @@ char        *application_name;
 bool        first_init;
 char        *recovery_file_name;
 char        *recovery_command;
+char        *restore_command;
+int         standby_catchup_jobs;
 GlobalTimestamp recovery_timestamp;
 char        *recovery_target_timestamp;
 bool        recovery_pitr_mode;
@@ -3234,6 +3236,9 @@ reconnect:
 
     sleep(1);
 
+    /* fetch what the active GTM has already archived before streaming */
+    GTM_StandbyRestoreArchivedXLog();
+
 	if (!gtm_standby_start_startup(0))
     {
         elog(ERROR, "Failed to establish a connection to active-GTM.");
@@ -21,6 +21,10 @@
 #include "catalog/pg_index.h"
 #include "lib/stringinfo.h"
 #include "storage/bufmgr.h"
+#ifdef __TBASE__
+#include "storage/dsm.h"
+#include "storage/shm_toc.h"
+#endif
 
 /* There's room for a 16-bit vacuum cycle ID in BTPageOpaqueData */
 typedef uint16 BTCycleId;
@@ -555,5 +559,15 @@ extern void _bt_spooldestroy(BTSpool *btspool);
 extern void _bt_spool(BTSpool *btspool, ItemPointer self,
           Datum *values, bool *isnull);
 extern void _bt_leafbuild(BTSpool *btspool, BTSpool *spool2);
+#ifdef __TBASE__
+/* index builds report their tuple counts as progress this often */
+#define BTREE_BUILD_REPORT_INTERVAL    1024
+
+extern int    _bt_parallel_build_workers(Relation heap, Relation index,
+                           struct IndexInfo *indexInfo);
+extern IndexBuildResult *_bt_parallel_build(Relation heap, Relation index,
+                   struct IndexInfo *indexInfo, int nworkers);
+extern void _bt_parallel_build_main(dsm_segment *seg, shm_toc *toc);
+#endif
 
 #endif                            /* NBTREE_H */
@@ -77,6 +77,7 @@
 #include "access/xlogdefs.h"
 #include "datatype/timestamp.h"
 #include "storage/lock.h"
+#include "nodes/pg_list.h"
 
 #include "gtm/gtm_c.h"
 
@@ -121,6 +122,10 @@ extern GlobalTransaction MarkAsPreparing(TransactionId xid, const char *gid,
 #ifdef __SUPPORT_DISTRIBUTED_TRANSACTION__
 extern void EndGlobalPrepare(GlobalTransaction gxact, bool isImplicit);
 extern void EndExplicitGlobalPrepare(char *gid);
+extern GlobalTimestamp TwoPhaseGetOldestPrepareTimestamp(void);
+#endif
+#ifdef __TBASE__
+extern bool TwoPhaseGidIsBusy(const char *gid);
 #endif
 
 extern void EndPrepare(GlobalTransaction gxact);
@@ -159,6 +164,15 @@ extern void record_2pc_readonly(const char *gid);
 extern char *get_2pc_info_from_cache(const char *tid);
 extern char *get_2pc_list_from_cache(int *count);
 
+/* 2pc record of a transaction, as returned by get_2pc_records_by_startnode */
+typedef struct Record2pcEntry
+{
+	char	   *gid;
+	char	   *info;
+} Record2pcEntry;
+
+extern List *get_2pc_records_by_startnode(const char *startnode, int max_count);
+
 extern void Record2pcCacheInit(void);
 extern Size Record2pcCacheSize(void);
 #endif
@@ -122,6 +122,9 @@ extern int    wal_gts_track_entries;
 extern bool i_am_standby;
 
 extern bool g_wal_check;
+
+extern bool enable_adaptive_group_commit;
+extern int    group_commit_max_delay;
 #endif
 /* Archive modes */
 typedef enum ArchiveMode
@@ -361,6 +364,25 @@ extern bool NeedMvcc(void);
 extern void RecoveryGTMHostInit(void);
 extern size_t RecoveryGTMHostSize(void);
 
+/* Adaptive group commit, times in microseconds. */
+typedef struct GroupCommitStats
+{
+    uint64        requests;        /* flush requests that had to wait */
+    uint64        flushes;        /* WAL flushes done by a group commit leader */
+    uint64        delayed_flushes;    /* flushes that waited for followers */
+    uint64        delay_time;        /* time leaders waited for followers */
+    uint64        queue_time;        /* time requests waited for their flush */
+    uint64        max_queue_time; /* longest such wait */
+    double        avg_interval;    /* moving average between requests */
+    double        avg_flush_time; /* moving average of a flush */
+    int            window;            /* current wait for followers */
+    TimestampTz last_arrival;
+    TimestampTz stats_reset;
+} GroupCommitStats;
+
+extern void GetGroupCommitStats(GroupCommitStats *stats);
+extern void ResetGroupCommitStats(void);
+
 #endif
 #ifdef _PUB_SUB_RELIABLE_
 extern bool wal_is_cluster_stream(void);
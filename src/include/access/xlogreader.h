@@ -195,6 +195,11 @@ struct XLogReaderState
 
     RepOriginId record_origin;
 
+#ifdef __SUBSCRIPTION__
+    /* toplevel xid of a subtransaction's first record, else invalid */
+    TransactionId toplevel_xid;
+#endif
+
     /* information about blocks referenced by the record. */
     DecodedBkpBlock blocks[XLR_MAX_BLOCK_ID + 1];
 
@@ -282,6 +287,9 @@ extern bool DecodeXLogRecord(XLogReaderState *state, XLogRecord *record,
 #define XLogRecGetRmid(decoder) ((decoder)->decoded_record->xl_rmid)
 #define XLogRecGetXid(decoder) ((decoder)->decoded_record->xl_xid)
 #define XLogRecGetOrigin(decoder) ((decoder)->record_origin)
+#ifdef __SUBSCRIPTION__
+#define XLogRecGetTopXid(decoder) ((decoder)->toplevel_xid)
+#endif
 #define XLogRecGetData(decoder) ((decoder)->main_data)
 #define XLogRecGetDataLen(decoder) ((decoder)->main_data_len)
 #define XLogRecHasAnyBlockRefs(decoder) ((decoder)->max_block_id >= 0)
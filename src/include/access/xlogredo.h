@@ -0,0 +1,25 @@
+/*-------------------------------------------------------------------------
+ *
+ * xlogredo.h
+ *      parallel replay of WAL on standby servers.
+ *
+ * src/include/access/xlogredo.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef XLOGREDO_H
+#define XLOGREDO_H
+
+#include "access/xlogreader.h"
+
+extern int    parallel_redo_workers;
+
+/* true in a parallel redo worker */
+extern bool InParallelRedoWorker;
+
+extern bool ParallelRedoDispatch(XLogReaderState *record);
+extern XLogRecPtr ParallelRedoWaitAll(void);
+extern void ParallelRedoShutdown(void);
+extern void ParallelRedoWorkerMain(Datum main_arg);
+
+#endif                            /* XLOGREDO_H */
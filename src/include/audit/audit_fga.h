@@ -94,6 +94,7 @@ typedef struct audit_fga_policy_state
     char       *policy_name;    /* Name of the policy */
     ExprState  *qual;            /* Expression to audit condition */
     char       *query_string;
+    List       *qual_expr;        /* audit condition, to combine with others */
 } audit_fga_policy_state;
 
 typedef enum exec_status
@@ -128,6 +129,8 @@ extern void exec_policy_funct_on_other_node(char *query_string);
 extern bool has_policy_matched_cmd(char * cmd_type, Datum statement_types_datum, bool is_null);
 extern bool has_policy_matched_columns(List * tlist, oidvector *audit_column_oids, bool audit_column_opts);
 extern bool get_audit_fga_quals(Oid rel, char * cmd_type, List *tlist, List **audit_fga_policy_list);
+extern void audit_fga_init_plan_quals(PlanState *ps, List *audit_fga_quals);
+extern void audit_fga_exec_plan_quals(PlanState *ps, ExprContext *econtext, char *cmd_type);
 extern void audit_fga_log_policy_info(AuditFgaPolicy *policy_s, char * cmd_type);
 extern void audit_fga_log_policy_info_2(audit_fga_policy_state *policy_s, char * cmd_type);
 
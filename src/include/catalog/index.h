@@ -185,6 +185,14 @@ extern double IndexBuildHeapRangeScan(Relation heapRelation,
                         BlockNumber end_blockno,
                         IndexBuildCallback callback,
                         void *callback_state);
+#ifdef __TBASE__
+extern double IndexBuildHeapParallelScan(Relation heapRelation,
+                           Relation indexRelation,
+                           IndexInfo *indexInfo,
+                           struct ParallelHeapScanDescData *pscan,
+                           IndexBuildCallback callback,
+                           void *callback_state);
+#endif
 
 extern void validate_index(Oid heapId, Oid indexId, Snapshot snapshot);
 
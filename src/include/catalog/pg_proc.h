@@ -6807,9 +6807,9 @@ DATA(insert OID = 4603 (  tbase_get_pub_stat PGNSP PGUID 12 1 0 0 0 f f f f t t
 DESCR("get statistic data of one publication");
 DATA(insert OID = 4604 (  tbase_get_all_pub_stat PGNSP PGUID 12 1 0 0 0 f f f f t t v r 0 0 2249 "" "{25,20,20,20,20,20}" "{o,o,o,o,o,o}" "{subscription_name,ntups_copyOut,ntups_insert,ntups_delete,checksum_insert,checksum_delete}" _null_ _null_ tbase_get_all_pub_stat _null_ _null_ _null_ ));
 DESCR("get statistic data of all publications");
-DATA(insert OID = 4605 (  tbase_get_sub_stat PGNSP PGUID 12 1 0 0 0 f f f f t t v r 1 0 2249 "25" "{25,25,20,20,20,20,20}" "{i,o,o,o,o,o,o}" "{sub_name,subscription_name,ntups_copyIn,ntups_insert,ntups_delete,checksum_insert,checksum_delete}" _null_ _null_ tbase_get_sub_stat _null_ _null_ _null_ ));
+DATA(insert OID = 4605 (  tbase_get_sub_stat PGNSP PGUID 12 1 0 0 0 f f f f t t v r 1 0 2249 "25" "{25,25,20,20,20,20,20,20,20}" "{i,o,o,o,o,o,o,o,o}" "{sub_name,subscription_name,ntups_copyIn,ntups_insert,ntups_delete,checksum_insert,checksum_delete,ntxns_apply,commit_wait_time}" _null_ _null_ tbase_get_sub_stat _null_ _null_ _null_ ));
 DESCR("get statistic data of one subscription");
-DATA(insert OID = 4606 (  tbase_get_all_sub_stat PGNSP PGUID 12 1 0 0 0 f f f f t t v r 0 0 2249 "" "{25,20,20,20,20,20}" "{o,o,o,o,o,o}" "{subscription_name,ntups_copyIn,ntups_insert,ntups_delete,checksum_insert,checksum_delete}" _null_ _null_ tbase_get_all_sub_stat _null_ _null_ _null_ ));
+DATA(insert OID = 4606 (  tbase_get_all_sub_stat PGNSP PGUID 12 1 0 0 0 f f f f t t v r 0 0 2249 "" "{25,20,20,20,20,20,20,20}" "{o,o,o,o,o,o,o,o}" "{subscription_name,ntups_copyIn,ntups_insert,ntups_delete,checksum_insert,checksum_delete,ntxns_apply,commit_wait_time}" _null_ _null_ tbase_get_all_sub_stat _null_ _null_ _null_ ));
 DESCR("get statistic data of all subscriptions");
 DATA(insert OID = 4607 (  tbase_get_pubtable_stat PGNSP PGUID 12 1 0 0 0 f f f f t t v r 2 0 2249 "26 26" "{26,26,26,26,20,20,20,20,20}" "{i,i,o,o,o,o,o,o,o}" "{subid,relid,subscription_id,relation_id,ntups_copyOut,ntups_insert,ntups_delete,checksum_insert,checksum_delete}" _null_ _null_ tbase_get_pubtable_stat _null_ _null_ _null_ ));
 DESCR("get statistic data of one publication with one table");
@@ -6846,6 +6846,28 @@ DESCR("set need_mvcc flag");
 DATA(insert OID = 4629 (  tbase_show_need_mvcc PGNSP PGUID 12 1 0 0 0 f f f f t f v r 0 0 23 "" _null_ _null_ _null_ _null_ _null_ tbase_show_need_mvcc _null_ _null_ _null_ ));
 DESCR("show need_mvcc flag");
 
+DATA(insert OID = 4631 (  tbase_get_sync_stream_stat PGNSP PGUID 12 1 0 0 0 f f f f f t s r 0 0 2249 "" "{26,26,23,23,23,23,23,20}" "{o,o,o,o,o,o,o,o}" "{subid,relid,pid,stream,nstreams,first_shard,last_shard,ntups_copy}" _null_ _null_ tbase_get_sync_stream_stat _null_ _null_ _null_ ));
+DESCR("statistics: progress of the streams of parallel initial table copies");
+
+DATA(insert OID = 4632 (  tbase_get_replayed_gts PGNSP PGUID 12 1 0 0 0 f f f f t f v s 2 0 20 "3220 20" _null_ _null_ "{lsn,gts}" _null_ _null_ tbase_get_replayed_gts _null_ _null_ _null_ ));
+DESCR("global timestamp below which this standby can serve snapshots");
+DATA(insert OID = 4638 (  tbase_get_safe_gts PGNSP PGUID 12 1 0 0 0 f f f f t f v r 0 0 2249 "" "{20,3220}" "{o,o}" "{gts,lsn}" _null_ _null_ tbase_get_safe_gts _null_ _null_ _null_ ));
+DESCR("global timestamp and WAL position of this node that every lower commit precedes");
+
+DATA(insert OID = 4633 (  pg_stat_get_group_commit PGNSP PGUID 12 1 0 0 0 f f f f f f s r 0 0 2249 "" "{20,20,20,701,701,701,701,701,701,1184}" "{o,o,o,o,o,o,o,o,o,o}" "{requests,flushes,delayed_flushes,delay_time,queue_time,max_queue_time,avg_interval,avg_flush_time,window_time,stats_reset}" _null_ _null_ pg_stat_get_group_commit _null_ _null_ _null_ ));
+DESCR("statistics: group commit of WAL flushes");
+
+DATA(insert OID = 4634 (  tbase_lock_wait_edges PGNSP PGUID 12 1 100 0 0 f f f f t t v r 0 0 2249 "" "{25,25,23,25,23}" "{o,o,o,o,o}" "{node,waiter,waiter_pid,holder,holder_pid}" _null_ _null_ tbase_lock_wait_edges _null_ _null_ _null_ ));
+DESCR("waits of global transactions for locks held by other global transactions on this node");
+DATA(insert OID = 4635 (  tbase_cancel_lock_waiter PGNSP PGUID 12 1 0 0 0 f f f f t f v r 2 0 16 "25 23" _null_ _null_ "{gxid,pid}" _null_ _null_ tbase_cancel_lock_waiter _null_ _null_ _null_ ));
+DESCR("fail the lock wait of a backend of a global transaction on this node");
+DATA(insert OID = 4639 (  tbase_clean_2pc_in_doubt PGNSP PGUID 12 1 100 0 0 f f f f t t v r 0 0 25 "" "{25}" "{o}" "{gid}" _null_ _null_ tbase_clean_2pc_in_doubt _null_ _null_ _null_ ));
+DESCR("2pc started from this node that were left in doubt by an earlier life of it");
+DATA(insert OID = 4636 (  tbase_get_data_horizon PGNSP PGUID 12 1 10 0 0 f f f f f t v r 0 0 2249 "" "{26,23,28,20,20,16}" "{o,o,o,o,o,o}" "{datid,pid,backend_xmin,snapshot_ts,horizon_ts,holds_shared}" _null_ _null_ tbase_get_data_horizon _null_ _null_ _null_ ));
+DESCR("statistics: processes holding back the vacuum data horizon of each database");
+DATA(insert OID = 4637 (  pgxc_stat_get_progress_create_index PGNSP PGUID 12 1 100 0 0 f f f f f t v r 0 0 2249 "" "{25,23,19,25,25,25,20,20,20,20,20,20}" "{o,o,o,o,o,o,o,o,o,o,o,o}" "{node_name,pid,datname,relname,indexrelname,phase,blocks_total,blocks_done,tuples_scanned,tuples_sorted,tuples_loaded,workers_launched}" _null_ _null_ pgxc_stat_get_progress_create_index _null_ _null_ _null_ ));
+DESCR("statistics: index build progress of all datanodes");
+
 #endif
 
 /*
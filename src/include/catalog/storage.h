@@ -19,6 +19,9 @@
 #include "utils/relcache.h"
 
 extern void RelationCreateStorage(RelFileNode rnode, char relpersistence);
+#ifdef __TBASE__
+extern void RelationCreatePageCompressFork(RelFileNode rnode, char relpersistence);
+#endif
 extern void RelationDropStorage(Relation rel);
 extern void RelationPreserveStorage(RelFileNode rnode, bool atCommit);
 extern void RelationTruncate(Relation rel, BlockNumber nblocks);
@@ -30,6 +30,7 @@ typedef struct RemoteInstr
 	
 	int nodeTag;            /* type of current plan node */
 	Instrumentation instr;  /* instrument of current plan node */
+	NetworkInstrumentation net; /* network waits and traffic */
 	
 	/* for Gather and Sort */
 	int nworkers_launched;  /* worker num of gather or sort */
@@ -53,5 +54,6 @@ extern void SendLocalInstr(PlanState *planstate);
 extern void HandleRemoteInstr(char *msg_body, size_t len, int nodeid, ResponseCombiner *combiner);
 extern bool AttachRemoteInstr(PlanState *planstate, AttachRemoteInstrContext *ctx);
 extern void ExplainCommonRemoteInstr(PlanState *planstate, ExplainState *es);
+extern void ExplainRemoteSubplanNetwork(RemoteSubplanState *node, ExplainState *es);
 
 #endif  /* EXPLAINDIST_H  */
\ No newline at end of file
@@ -34,4 +34,22 @@
 #define PROGRESS_VACUUM_PHASE_TRUNCATE            5
 #define PROGRESS_VACUUM_PHASE_FINAL_CLEANUP        6
 
+#ifdef __TBASE__
+/* Progress parameters for CREATE INDEX and the other index builds */
+#define PROGRESS_CREATEIDX_PHASE                0
+#define PROGRESS_CREATEIDX_INDEX_OID            1
+#define PROGRESS_CREATEIDX_BLOCKS_TOTAL            2
+#define PROGRESS_CREATEIDX_BLOCKS_DONE            3
+#define PROGRESS_CREATEIDX_TUPLES_SCANNED        4
+#define PROGRESS_CREATEIDX_TUPLES_SORTED        5
+#define PROGRESS_CREATEIDX_TUPLES_LOADED        6
+#define PROGRESS_CREATEIDX_WORKERS                7
+
+/* Phases of index builds (as advertised via PROGRESS_CREATEIDX_PHASE) */
+#define PROGRESS_CREATEIDX_PHASE_SCAN_HEAP        1
+#define PROGRESS_CREATEIDX_PHASE_SORT            2
+#define PROGRESS_CREATEIDX_PHASE_LOAD            3
+#define PROGRESS_CREATEIDX_PHASE_VALIDATE        4
+#endif
+
 #endif
@@ -119,7 +119,18 @@ extern Oid *add_node_list(Oid *old_oids, int old_num, Oid *add_oids, int add_num
 #endif
 
 #ifdef __TBASE__
+/* steps of DDL that block a distributed table for long, see CheckBlockingDDL */
+typedef enum BlockingDDLStep
+{
+    BLOCKING_DDL_REWRITE,        /* rewrite of the table */
+    BLOCKING_DDL_VALIDATE,        /* scan validating new constraints */
+    BLOCKING_DDL_INDEX            /* index build */
+} BlockingDDLStep;
+
+extern bool refuse_blocking_ddl;
+
 extern void StoreIntervalPartitionInfo(Oid relationId, char partkind, Oid parentId, bool isindex);
+extern void CheckBlockingDDL(Relation rel, BlockingDDLStep step);
 #endif
 
 #ifdef __COLD_HOT__
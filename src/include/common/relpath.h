@@ -31,6 +31,9 @@ typedef enum ForkNumber
     EXTENT_FORKNUM,
 #endif
     INIT_FORKNUM
+#ifdef __TBASE__
+    ,PAGE_COMPRESS_FORKNUM
+#endif
 
     /*
      * NOTE: if you add a new fork, change MAX_FORKNUM and possibly
@@ -39,7 +42,11 @@ typedef enum ForkNumber
      */
 } ForkNumber;
 
+#ifdef __TBASE__
+#define MAX_FORKNUM        PAGE_COMPRESS_FORKNUM
+#else
 #define MAX_FORKNUM        INIT_FORKNUM
+#endif
 
 #ifdef _SHARDING_
 #define FORKNAMECHARS    5        /* max chars for a fork name */
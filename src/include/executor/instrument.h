@@ -70,10 +70,25 @@ typedef struct WorkerInstrumentation
 } WorkerInstrumentation;
 
 #ifdef __TBASE__
+/*
+ * Network side of a distributed plan node, times in seconds.  The producer
+ * fields are filled for the root of a plan fragment, the consumer fields
+ * for a RemoteSubplan.
+ */
+typedef struct NetworkInstrumentation
+{
+	double		firsttuple;		/* consumer: wait for the first tuple */
+	double		recv_wait;		/* consumer: blocked waiting for producers */
+	double		send_blocked;	/* producer: blocked on full send queues */
+	double		bytes_recv;		/* consumer: network bytes received */
+	double		bytes_sent;		/* producer: network bytes sent */
+} NetworkInstrumentation;
+
 typedef struct RemoteInstrumentation
 {
 	int              nodeid;    /* which datanode the instrument comes from */
 	Instrumentation  instr;     /* the instrumentation */
+	NetworkInstrumentation net; /* network waits and traffic */
 } RemoteInstrumentation;
 
 typedef struct DatanodeInstrumentation
@@ -374,6 +374,8 @@ const char *const config_type_names[] =\
 #define GTM_OPTNAME_ENABLE_XLOG_DEBUG            "enable_gtm_xlog_debug"
 #define GTM_OPTNAME_RECOVERY_TARGET_GLOBALTIMESTAMP "recovery_target_global_timestamp"
 #define GTM_OPTNAME_RECOVERY_COMMAND              "recovery_command"
+#define GTM_OPTNAME_RESTORE_COMMAND               "restore_command"
+#define GTM_OPTNAME_STANDBY_CATCHUP_JOBS          "standby_catchup_jobs"
 #endif
 
 #define GTM_OPTNAME_UNIX_SOCKET_DIRECTORY       "unix_socket_directory"
@@ -190,6 +190,7 @@ extern void WaitXLogWriteUntil(XLogRecPtr write_pos);
 XLogRecPtr GetXLogFlushRecPtr(void);
 
 extern bool  CopyXLogRecordToBuff(char *data,XLogRecPtr start,XLogRecPtr end,uint64 size);
+extern void  GTM_StandbyRestoreArchivedXLog(void);
 extern void  GTM_ThreadWalRedoer_Internal();
 
 /*
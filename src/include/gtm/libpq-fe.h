@@ -133,6 +133,12 @@ extern int    PQflush(GTM_Conn *conn);
 extern bool GTMSetSockKeepAlive(GTM_Conn *conn, int tcp_keepalives_idle,
 	int tcp_keepalives_interval, int tcp_keepalives_count);
 
+/* === in fe-misc.c === */
+
+/* Called with true before and false after waiting for GTM to answer */
+typedef void (*gtmpq_wait_hook_type) (bool start);
+extern gtmpq_wait_hook_type gtmpq_wait_hook;
+
 #define libpq_gettext(x)	x
 
 #ifdef __cplusplus
@@ -249,6 +249,9 @@ extern int    MaxBackends;
 extern int    MaxConnections;
 extern int    max_worker_processes;
 extern int    max_parallel_workers;
+#ifdef __TBASE__
+extern int    max_parallel_maintenance_workers;
+#endif
 
 extern PGDLLIMPORT int MyProcPid;
 extern PGDLLIMPORT pg_time_t MyStartTime;
@@ -544,6 +544,11 @@ typedef struct EState
 #ifdef __AUDIT__
     int32        es_remote_subplan_num;    /* number of RemoteSubplan in es_plannedstmt */
 #endif
+#ifdef __TBASE__
+    /* network counters at executor start, for instrumented plan fragments */
+    double        es_net_send_blocked_start;
+    uint64        es_net_bytes_sent_start;
+#endif
 } EState;
 
 
@@ -964,6 +969,7 @@ typedef struct PlanState
 
 #ifdef __AUDIT_FGA__
     List *audit_fga_qual;
+    ExprState *audit_fga_any_qual;    /* audit_fga_qual ORed, if several */
 #endif
 } PlanState;
 
@@ -1182,11 +1188,15 @@ typedef struct datamask_att_scan {
 	char     *defaultval;    /* keep default val */
 	int64    datamask;
 	FmgrInfo flinfo;
+	bool     constvalid;    /* masked value does not depend on the column value */
+	Datum    constval;      /* and is this one, computed once */
 } DataMaskAttScan;
 
 typedef struct datamask_state
 {
 	DataMaskAttScan *maskinfo;
+	int      nmaskatts;     /* number of columns to mask */
+	int     *maskatts;      /* their attribute indexes, read by the scan */
 } DataMaskState ;
 
 /* ----------------------------------------------------------------
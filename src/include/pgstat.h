@@ -785,7 +785,8 @@ typedef enum
 #ifdef __AUDIT_FGA__
     WAIT_EVENT_AUDIT_FGA_MAIN,
 #endif
-	WAIT_EVENT_CLUSTER_MONITOR_MAIN
+	WAIT_EVENT_CLUSTER_MONITOR_MAIN,
+	WAIT_EVENT_GLOBAL_DEADLOCK_DETECTOR_MAIN
 } WaitEventActivity;
 
 /* ----------
@@ -817,10 +818,14 @@ typedef enum
  */
 typedef enum
 {
-	WAIT_EVENT_BGWORKER_SHUTDOWN = PG_WAIT_IPC,
+	WAIT_EVENT_BASE_BACKUP_STREAMS = PG_WAIT_IPC,
+	WAIT_EVENT_BGWORKER_SHUTDOWN,
 	WAIT_EVENT_BGWORKER_STARTUP,
 	WAIT_EVENT_BTREE_PAGE,
+	WAIT_EVENT_DATAPUMP_SEND,
 	WAIT_EVENT_EXECUTE_GATHER,
+	WAIT_EVENT_GTM_ROUNDTRIP,
+	WAIT_EVENT_LOGICAL_APPLY_COMMIT_ORDER,
 	WAIT_EVENT_LOGICAL_SYNC_DATA,
 	WAIT_EVENT_LOGICAL_SYNC_STATE_CHANGE,
 	WAIT_EVENT_MQ_INTERNAL,
@@ -829,10 +834,15 @@ typedef enum
 	WAIT_EVENT_MQ_SEND,
 	WAIT_EVENT_PARALLEL_FINISH,
 	WAIT_EVENT_PARALLEL_BITMAP_SCAN,
+	WAIT_EVENT_PARALLEL_REDO,
+	WAIT_EVENT_POOLER_GET_CONNECTIONS,
 	WAIT_EVENT_PROCARRAY_GROUP_UPDATE,
+	WAIT_EVENT_REMOTE_RECEIVE,
 	WAIT_EVENT_REPLICATION_ORIGIN_DROP,
 	WAIT_EVENT_REPLICATION_SLOT_DROP,
 	WAIT_EVENT_SAFE_SNAPSHOT,
+	WAIT_EVENT_SQUEUE_EMPTY,
+	WAIT_EVENT_SQUEUE_FULL,
 	WAIT_EVENT_SYNC_REP
 } WaitEventIPC;
 
@@ -946,7 +956,10 @@ typedef enum
 typedef enum ProgressCommandType
 {
 	PROGRESS_COMMAND_INVALID,
-	PROGRESS_COMMAND_VACUUM
+	PROGRESS_COMMAND_VACUUM,
+#ifdef __TBASE__
+	PROGRESS_COMMAND_CREATE_INDEX
+#endif
 } ProgressCommandType;
 
 #define PGSTAT_NUM_PROGRESS_PARAM	10
@@ -22,9 +22,15 @@
 #define CREATE_BARRIER_PREPARE    'P'
 #define CREATE_BARRIER_EXECUTE    'X'
 #define CREATE_BARRIER_END        'E'
+#ifdef __TBASE__
+#define CREATE_BARRIER_GTS        'G'
+#endif
 
 #define CREATE_BARRIER_PREPARE_DONE    'p'
 #define CREATE_BARRIER_EXECUTE_DONE    'x'
+#ifdef __TBASE__
+#define CREATE_BARRIER_GTS_OVERTAKEN   'o'
+#endif
 
 typedef struct xl_barrier
 {
@@ -33,9 +39,31 @@ typedef struct xl_barrier
 
 #define XLOG_BARRIER_CREATE    0x00
 
+#ifdef __TBASE__
+/*
+ * Barrier taken at a global timestamp instead of under BarrierLock.  Every
+ * commit with a GTS at or above barrier_gts follows this record in the WAL of
+ * the node that wrote it.
+ */
+typedef struct xl_barrier_gts
+{
+    GlobalTimestamp barrier_gts;
+    char        barrier_id[FLEXIBLE_ARRAY_MEMBER];
+} xl_barrier_gts;
+
+#define SizeOfBarrierGTS    (offsetof(xl_barrier_gts, barrier_id))
+
+#define XLOG_BARRIER_GTS    0x10
+
+extern bool enable_gts_barrier;
+#endif
+
 extern void ProcessCreateBarrierPrepare(const char *id);
 extern void ProcessCreateBarrierEnd(const char *id);
 extern void ProcessCreateBarrierExecute(const char *id);
+#ifdef __TBASE__
+extern void ProcessCreateBarrierGTS(const char *id, GlobalTimestamp barrier_gts);
+#endif
 
 extern void RequestBarrier(const char *id, char *completionTag);
 extern void barrier_redo(XLogReaderState *record);
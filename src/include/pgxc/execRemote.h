@@ -53,6 +53,7 @@
 
 #ifdef __TBASE__
 #define RESPONSE_INSTR 13
+#define RESPONSE_BARRIER_OVERTAKEN 14
 #define     UINT32_BITS_NUM              32
 #define     WORD_NUMBER_FOR_NODES      (MAX_NODES_NUMBER / UINT32_BITS_NUM)
 
@@ -263,6 +264,10 @@ typedef struct RemoteSubplanState
     bool        finish_init;
     int32       eflags;                       /* estate flag. */
     ParallelWorkerStatus *parallel_status; /* Shared storage for parallel worker. */
+    /* network waits and traffic of this node, when instrumented */
+    NetworkInstrumentation net;
+    instr_time  net_start;                /* first call of ExecRemoteSubplan */
+    bool        net_got_tuple;            /* net.firsttuple is set */
 #endif
 } RemoteSubplanState;
 
@@ -23,6 +23,7 @@
 /* Global number of nodes */
 extern int     NumDataNodes;
 extern int     NumCoords;
+extern int     NumSlaveDataNodes;
 
 #ifdef __TBASE__
 extern char *PGXCNodeHost;
@@ -38,6 +39,10 @@ typedef struct
     bool        nodeisprimary;
     bool         nodeispreferred;
     bool        nodeishealthy;
+#ifdef __TBASE__
+    /* For a standby datanode, GTS of the last commit it replayed */
+    GlobalTimestamp nodereplaygts;
+#endif
 } NodeDefinition;
 
 extern void NodeTablesShmemInit(void);
@@ -66,9 +71,19 @@ extern void PgxcNodeCreate(CreateNodeStmt *stmt);
 extern void PgxcNodeRemove(DropNodeStmt *stmt);
 extern void PgxcNodeDnListHealth(List *nodeList, bool *dnhealth);
 extern bool PgxcNodeUpdateHealth(Oid node, bool status);
+#ifdef __TBASE__
+extern void PgxcNodeGetPoolOids(Oid **coOids, Oid **dnOids,
+                int *num_coords, int *num_dns);
+extern bool PgxcNodeUpdateReplayGTS(Oid node, GlobalTimestamp gts);
+extern GlobalTimestamp PgxcNodeGetReplayGTS(Oid node);
+#endif
 
 extern bool PrimaryNodeNumberChanged(void);
 /* GUC parameter */
 extern bool enable_multi_cluster;
 extern bool enable_multi_cluster_print;
+#ifdef __TBASE__
+extern bool enable_standby_read_routing;
+extern int  standby_read_refresh_interval;
+#endif
 #endif    /* NODEMGR_H */
@@ -107,6 +107,14 @@ extern char *PGXCMainClusterName;
 extern char *PGXCDefaultClusterName;
 #ifdef __TBASE__
 extern char PGXCSessionId[NAMEDATALEN];
+/* query id of the statement the coordinator is running for this session */
+extern uint32 PGXCQueryId;
+/* bytes sent and received over client and internode connections */
+extern uint64 PGXCNetBytesSent;
+extern uint64 PGXCNetBytesReceived;
+/* seconds spent blocked sending tuples to and waiting for other nodes */
+extern double PGXCNetSendBlockedTime;
+extern double PGXCNetRecvWaitTime;
 #endif
 
 
@@ -174,6 +174,11 @@ extern int PGXCNodeGetNodeId(Oid nodeoid, char *node_type);
 extern Oid PGXCGetLocalNodeOid(Oid nodeoid);
 extern Oid PGXCGetMainNodeOid(Oid nodeoid);
 extern int PGXCNodeGetNodeIdFromName(char *node_name, char *node_type);
+#ifdef __TBASE__
+extern int PGXCNodeGetPoolIndex(PGXCNodeHandle *handle);
+extern void PGXCNodeRequestStandbyRead(void);
+extern void PGXCNodeNoteCommit(void);
+#endif
 extern Oid PGXCNodeGetNodeOid(int nodeid, char node_type);
 
 extern PGXCNodeAllHandles *get_handles(List *datanodelist, List *coordlist,
@@ -216,6 +221,7 @@ extern int	pgxc_node_send_my_sync(PGXCNodeHandle * handle);
 
 #ifdef __SUBSCRIPTION__
 extern int pgxc_node_send_apply(PGXCNodeHandle * handle, char * buf, int len, bool ignore_pk_conflict);
+extern int pgxc_node_queue_apply(PGXCNodeHandle * handle, char * buf, int len, bool ignore_pk_conflict);
 #endif
 #ifdef __TBASE__
 extern int pgxc_node_send_disconnect(PGXCNodeHandle * handle, char *cursor, int cons);
@@ -74,6 +74,8 @@
 
 #include <limits.h>
 
+#include "pgtime.h"
+
 #define 					AUDIT_COMMON_LOG		(1 << 0)
 #define 					AUDIT_FGA_LOG			(1 << 1)
 /* size_rotation_for = AUDIT_COMMON_LOG | AUDIT_FGA_LOG | MAINTAIN_TRACE_LOG */
@@ -95,6 +97,7 @@ extern int					Maintain_trace_log_cache_size_kb;
 
 extern bool                 am_auditlogger;
 extern bool                 enable_auditlogger_warning;
+extern bool					AuditLog_binary_records;
 
 extern int                    AuditLogger_Start(void);
 
@@ -111,4 +114,55 @@ extern void     alog(int destination, const char *fmt,...) pg_attribute_printf(2
 #define 		audit_log_fga(args...)      alog(AUDIT_FGA_LOG, ##args)
 #define 		trace_log(args...)          alog(MAINTAIN_TRACE_LOG, ##args)
 
+/*
+ * String fields of a common audit log record, in output order.
+ */
+typedef enum AuditRecordString
+{
+	AREC_AUDIT_TYPE = 0,
+	AREC_QUERY_STRING,
+	AREC_COMMAND_TAG,
+	AREC_DB_NAME,
+	AREC_DB_USER_NAME,
+	AREC_NODE_NAME,
+	AREC_NODE_TYPE,
+	AREC_NODE_HOST,
+	AREC_NODE_OSUSER,
+	AREC_CLIENT_HOST,
+	AREC_CLIENT_HOSTNAME,
+	AREC_CLIENT_PORT,
+	AREC_APP_NAME,
+	AREC_OBJECT_TYPE,
+	AREC_OBJECT_NAME,
+	AREC_ACTION_NAME,
+	AREC_EXEC_STATUS,
+	AREC_NSTRINGS
+} AuditRecordString;
+
+/*
+ * Fixed part of a common audit log record. alog_record() copies it and the
+ * strings as they are into the backend's record ring, and the audit logger
+ * threads format the text later, off the query path.
+ */
+typedef struct AuditRecordData
+{
+	Oid					db_id;
+	Oid					db_user_id;
+	Oid					node_oid;
+	int32				node_port;
+	uint32				proc_pid;
+	uint32				proc_ppid;
+	int32				is_success;
+	Oid					obj_class_id;
+	Oid					obj_id;
+	int32				obj_sub_id;
+	int32				action_id;
+	pg_time_t			proc_start_time;
+	pg_time_t			qry_begin_time;
+	pg_time_t			qry_end_time;
+	uint32				str_len[AREC_NSTRINGS];	/* set by alog_record */
+} AuditRecordData;
+
+extern void		alog_record(AuditRecordData *rec, const char *str[AREC_NSTRINGS]);
+
 #endif                            /* __AUDIT_LOGGER_H__ */
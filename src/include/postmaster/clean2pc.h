@@ -15,6 +15,7 @@
 #include "storage/block.h"
 
 extern bool enable_clean_2pc_launcher;
+extern bool enable_clean_2pc_local_resolve;
 
 extern int auto_clean_2pc_interval;
 extern int auto_clean_2pc_delay;
@@ -24,6 +25,9 @@ extern int auto_clean_2pc_max_check_time;
 extern bool IsClean2pcLauncher(void);
 extern bool IsClean2pcWorker(void);
 
+extern void Clean2pcRequestResolve(const char *gid);
+extern void Clean2pcSetStartupXid(TransactionId xid);
+
 #define IsAnyClean2pcProcess() \
 	(IsClean2pcLauncher() || IsClean2pcWorker())
 
@@ -0,0 +1,20 @@
+/*-------------------------------------------------------------------------
+ *
+ * globaldeadlock.h
+ *      Global deadlock detector of distributed transactions.
+ *
+ * IDENTIFICATION
+ *      src/include/postmaster/globaldeadlock.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef GLOBALDEADLOCK_H
+#define GLOBALDEADLOCK_H
+
+extern bool enable_global_deadlock_detector;
+extern int    global_deadlock_detector_interval;
+
+extern void GlobalDeadlockDetectorRegister(void);
+extern void GlobalDeadlockDetectorMain(Datum main_arg);
+
+#endif                            /* GLOBALDEADLOCK_H */
@@ -29,8 +29,31 @@ typedef struct
     int64        size;
 } tablespaceinfo;
 
+#ifdef __TBASE__
+/*
+ * An incremental base backup sends a relation segment as "<name>.incr": this
+ * header, the numbers of the blocks sent, then the blocks.  The segment is
+ * nblocks long; blocks not sent are unchanged since the earlier backup.
+ */
+#define INCREMENTAL_FILE_SUFFIX    ".incr"
+#define INCREMENTAL_FILE_MAGIC    0x494E4352
+
+typedef struct IncrementalFileHeader
+{
+    uint32        magic;
+    uint32        blcksz;
+    uint32        nblocks;
+    uint32        nchanged;
+} IncrementalFileHeader;
+#endif
+
 extern void SendBaseBackup(BaseBackupCmd *cmd);
 
 extern int64 sendTablespace(char *path, bool sizeonly);
 
+#ifdef __TBASE__
+extern Size BaseBackupShmemSize(void);
+extern void BaseBackupShmemInit(void);
+#endif
+
 #endif                            /* _BASEBACKUP_H */
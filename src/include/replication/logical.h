@@ -82,6 +82,14 @@ typedef struct LogicalDecodingContext
     bool        prepared_write;
     XLogRecPtr    write_location;
     TransactionId write_xid;
+
+#ifdef __SUBSCRIPTION__
+    /*
+     * Stream large transactions before they commit?  Set if the output
+     * plugin has the stream callbacks; the plugin can clear it at startup.
+     */
+    bool        streaming;
+#endif
 } LogicalDecodingContext;
 
 
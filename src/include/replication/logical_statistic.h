@@ -112,6 +112,7 @@ extern void SetPubStatCheck(bool pubstatcount, bool pubstatchecksum);
 
 extern void UpdateSubStatistics(char *subname, uint64 ntups_copy, uint64 ntups_insert, uint64 ntups_delete,
                                         uint64 checksum_insert, uint64 checksum_delete, bool init);
+extern void UpdateSubApplyStatistics(char *subname, uint64 ntxns_apply, uint64 commit_wait_time);
 extern void UpdateSubTableStatistics(Oid subid, Oid relid, uint64 ntups_copy, uint64 ntups_insert, uint64 ntups_delete,
                                         uint64 checksum_insert, uint64 checksum_delete, char state, bool init);
 extern void RemoveSubStatistics(char *subname);
@@ -37,9 +37,17 @@ typedef struct LogicalRepTupleData
 
 #ifdef __SUBSCRIPTION__
     int32        tuple_hash;        /* hash value of this tuple */
+    /* LOGICALREP_COLUMN_TEXT or _BINARY, and length of non-null values: */
+    char        formats[MaxTupleAttributeNumber];
+    int            lengths[MaxTupleAttributeNumber];
 #endif
 } LogicalRepTupleData;
 
+#ifdef __SUBSCRIPTION__
+#define LOGICALREP_COLUMN_TEXT        't'
+#define LOGICALREP_COLUMN_BINARY    'b'
+#endif
+
 typedef uint32 LogicalRepRelId;
 
 /* Relation information */
@@ -92,7 +100,7 @@ extern void logicalrep_write_origin(StringInfo out, const char *origin,
 extern char *logicalrep_read_origin(StringInfo in, XLogRecPtr *origin_lsn);
 extern void logicalrep_write_insert(StringInfo out, Relation rel,
 #ifdef __SUBSCRIPTION__
-                        int32 tuple_hash,
+                        TransactionId xid, int32 tuple_hash,
 #endif
                         HeapTuple newtuple);
 extern LogicalRepRelId logicalrep_read_insert(StringInfo in, 
@@ -102,7 +110,7 @@ extern LogicalRepRelId logicalrep_read_insert(StringInfo in,
                         LogicalRepTupleData *newtup);
 extern void logicalrep_write_update(StringInfo out, Relation rel, 
 #ifdef __SUBSCRIPTION__
-                        int32 tuple_hash,
+                        TransactionId xid, int32 tuple_hash,
 #endif
                         HeapTuple oldtuple,
                         HeapTuple newtuple);
@@ -114,7 +122,7 @@ extern LogicalRepRelId logicalrep_read_update(StringInfo in,
                        LogicalRepTupleData *newtup);
 extern void logicalrep_write_delete(StringInfo out, Relation rel,
 #ifdef __SUBSCRIPTION__
-                        int32 tuple_hash,
+                        TransactionId xid, int32 tuple_hash,
 #endif
                         HeapTuple oldtuple);
 extern LogicalRepRelId logicalrep_read_delete(StringInfo in,
@@ -122,9 +130,17 @@ extern LogicalRepRelId logicalrep_read_delete(StringInfo in,
                        char **nspname, char **relname, char *replident,
 #endif
                        LogicalRepTupleData *oldtup);
-extern void logicalrep_write_rel(StringInfo out, Relation rel);
+extern void logicalrep_write_rel(StringInfo out,
+#ifdef __SUBSCRIPTION__
+                     TransactionId xid,
+#endif
+                     Relation rel);
 extern LogicalRepRelation *logicalrep_read_rel(StringInfo in);
-extern void logicalrep_write_typ(StringInfo out, Oid typoid);
+extern void logicalrep_write_typ(StringInfo out,
+#ifdef __SUBSCRIPTION__
+                     TransactionId xid,
+#endif
+                     Oid typoid);
 extern void logicalrep_read_typ(StringInfo out, LogicalRepTyp *ltyp);
 
 #ifdef __SUBSCRIPTION__
@@ -135,7 +151,22 @@ extern void logicalrep_dml_set_send_all(bool send_all);
 extern int32 logicalrep_dml_get_hashmod(void);
 extern int32 logicalrep_dml_get_hashvalue(void);
 extern bool  logicalrep_dml_get_send_all(void);
+extern void logicalrep_set_binary(bool binary);
 extern int32 logicalrep_dml_calc_hash(Relation rel, HeapTuple tuple);
+
+extern void logicalrep_write_stream_start(StringInfo out, TransactionId xid,
+                              bool first_segment);
+extern TransactionId logicalrep_read_stream_start(StringInfo in,
+                             bool *first_segment);
+extern void logicalrep_write_stream_stop(StringInfo out);
+extern void logicalrep_write_stream_commit(StringInfo out, ReorderBufferTXN *txn,
+                               XLogRecPtr commit_lsn);
+extern TransactionId logicalrep_read_stream_commit(StringInfo in,
+                              LogicalRepCommitData *commit_data);
+extern void logicalrep_write_stream_abort(StringInfo out, TransactionId xid,
+                              TransactionId subxid);
+extern void logicalrep_read_stream_abort(StringInfo in, TransactionId *xid,
+                             TransactionId *subxid);
 extern void	logicalrep_relation_free(LogicalRepRelation * rel);
 #endif
 
@@ -16,4 +16,12 @@ extern void ApplyWorkerMain(Datum main_arg);
 
 extern bool IsLogicalWorker(void);
 
+#ifdef __SUBSCRIPTION__
+extern int    logical_apply_pipeline_depth;
+extern bool logical_apply_preserve_commit_order;
+extern bool logical_apply_streaming;
+extern bool logical_apply_binary;
+extern int    logical_sync_streams_per_table;
+#endif
+
 #endif                            /* LOGICALWORKER_H */
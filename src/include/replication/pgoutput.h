@@ -25,6 +25,12 @@ typedef struct PGOutputData
 
     List       *publication_names;
     List       *publications;
+
+#ifdef __SUBSCRIPTION__
+    bool        streaming;        /* client asked for in-progress transactions */
+    bool        in_streaming;    /* inside a stream_start/stream_stop block */
+    bool        binary;            /* client takes column values in binary */
+#endif
 } PGOutputData;
 
 #endif                            /* PGOUTPUT_H */
@@ -135,6 +135,11 @@ typedef struct ReorderBufferChange
      * otherwise it's the preallocated list.
      */
     dlist_node    node;
+
+#ifdef __SUBSCRIPTION__
+    /* (sub)transaction the change belongs to */
+    struct ReorderBufferTXN *txn;
+#endif
 } ReorderBufferChange;
 
 typedef struct ReorderBufferTXN
@@ -269,6 +274,21 @@ typedef struct ReorderBufferTXN
      */
     dlist_node    node;
 
+#ifdef __SUBSCRIPTION__
+    /* toplevel transaction, set once we know this is a subxact */
+    struct ReorderBufferTXN *toptxn;
+
+    /*
+     * Have changes of this (toplevel) transaction been streamed before the
+     * commit?  The streamed changes are gone from the buffer, so the
+     * transaction has to be finished with stream_commit or stream_abort.
+     */
+    bool        streamed;
+
+    /* snapshot and command id to continue streaming with, or NULL */
+    Snapshot    stream_snapshot;
+    CommandId    stream_command_id;
+#endif
 } ReorderBufferTXN;
 
 /* so we can define the callbacks used inside struct ReorderBuffer itself */
@@ -301,6 +321,29 @@ typedef void (*ReorderBufferMessageCB) (
                                         const char *prefix, Size sz,
                                         const char *message);
 
+#ifdef __SUBSCRIPTION__
+/* start/stop of a block of changes streamed before commit */
+typedef void (*ReorderBufferStreamStartCB) (
+                                            ReorderBuffer *rb,
+                                            ReorderBufferTXN *txn);
+
+typedef void (*ReorderBufferStreamStopCB) (
+                                           ReorderBuffer *rb,
+                                           ReorderBufferTXN *txn);
+
+/* abort of a streamed toplevel transaction or one of its subxacts */
+typedef void (*ReorderBufferStreamAbortCB) (
+                                            ReorderBuffer *rb,
+                                            ReorderBufferTXN *txn,
+                                            XLogRecPtr abort_lsn);
+
+/* commit of a streamed transaction */
+typedef void (*ReorderBufferStreamCommitCB) (
+                                             ReorderBuffer *rb,
+                                             ReorderBufferTXN *txn,
+                                             XLogRecPtr commit_lsn);
+#endif
+
 struct ReorderBuffer
 {
     /*
@@ -329,6 +372,16 @@ struct ReorderBuffer
     ReorderBufferCommitCB commit;
     ReorderBufferMessageCB message;
 
+#ifdef __SUBSCRIPTION__
+    /*
+     * Callbacks to stream large transactions while they are in progress.
+     */
+    ReorderBufferStreamStartCB stream_start;
+    ReorderBufferStreamStopCB stream_stop;
+    ReorderBufferStreamAbortCB stream_abort;
+    ReorderBufferStreamCommitCB stream_commit;
+#endif
+
     /*
      * Pointer that will be passed untouched to the callbacks.
      */
@@ -214,6 +214,10 @@ typedef struct
         {
             uint32        proto_version;    /* Logical protocol version */
             List       *publication_names;    /* String list of publications */
+#ifdef __SUBSCRIPTION__
+            bool        streaming;    /* Stream in-progress transactions */
+            bool        binary;        /* Column values in binary format */
+#endif
         }            logical;
     }            proto;
 } WalRcvStreamOptions;
@@ -77,6 +77,8 @@
 #include "access/xlogdefs.h"
 #include "catalog/pg_subscription.h"
 #include "datatype/timestamp.h"
+#include "postmaster/bgworker.h"
+#include "storage/dsm_impl.h"
 #include "storage/lock.h"
 
 typedef struct LogicalRepWorker
@@ -114,6 +116,29 @@ typedef struct LogicalRepWorker
     TimestampTz last_recv_time;
     XLogRecPtr    reply_lsn;
     TimestampTz reply_time;
+
+#ifdef __SUBSCRIPTION__
+    /*
+     * Final LSN of the remote transaction being applied, or the replication
+     * origin progress before the first one.  Every earlier transaction is
+     * done.  Protected by relmutex.
+     */
+    XLogRecPtr    apply_final_lsn;
+
+    /*
+     * Parallel initial copy of a table.  Stream number (0 for the sync
+     * worker, above 0 for its helpers), number of streams and the range of
+     * shards copied by this stream; helpers also get the segment holding the
+     * queues they send rows through.  sync_ntuples counts rows copied so far.
+     * Protected by relmutex.
+     */
+    int            sync_stream;
+    int            sync_nstreams;
+    int            sync_first_shard;
+    int            sync_last_shard;
+    dsm_handle    sync_dsm;
+    uint64        sync_ntuples;
+#endif
 } LogicalRepWorker;
 
 /* Main memory context for apply worker. Permanent during worker lifetime. */
@@ -134,6 +159,11 @@ extern LogicalRepWorker *logicalrep_worker_find(Oid subid, Oid relid,
 extern List *logicalrep_workers_find(Oid subid, bool only_running);
 extern void logicalrep_worker_launch(Oid dbid, Oid subid, const char *subname,
                          Oid userid, Oid relid);
+#ifdef __SUBSCRIPTION__
+extern BackgroundWorkerHandle *logicalrep_sync_stream_launch(Oid dbid, Oid subid,
+                              const char *subname, Oid userid, Oid relid,
+                              int stream, int nstreams, dsm_handle handle);
+#endif
 extern void logicalrep_worker_stop(Oid subid, Oid relid);
 extern void logicalrep_worker_stop_at_commit(Oid subid, Oid relid);
 extern void logicalrep_worker_wakeup(Oid subid, Oid relid);
@@ -142,6 +172,9 @@ extern void logicalrep_worker_wakeup_ptr(LogicalRepWorker *worker);
 extern int    logicalrep_sync_worker_count(Oid subid);
 
 extern char *LogicalRepSyncTableStart(XLogRecPtr *origin_startpos);
+#ifdef __SUBSCRIPTION__
+extern void LogicalRepSyncStreamMain(void);
+#endif
 void        process_syncing_tables(XLogRecPtr current_lsn);
 void invalidate_syncing_table_states(Datum arg, int cacheid,
                                 uint32 hashvalue);
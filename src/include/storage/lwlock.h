@@ -176,6 +176,11 @@ extern PGDLLIMPORT int NamedLWLockTrancheRequests;
 /* Number of partitions of the 2pc info cache hashtable */
 #define NUM_CACHE_2PC_PARTITIONS  128
 
+#ifdef __TBASE__
+/* Number of partitions of the page compression address map locks */
+#define NUM_PAGE_COMPRESS_PARTITIONS  64
+#endif
+
 /* Number of partitions the shared lock tables are divided into */
 #define LOG2_NUM_LOCK_PARTITIONS  8
 #define NUM_LOCK_PARTITIONS  (1 << LOG2_NUM_LOCK_PARTITIONS)
@@ -192,8 +197,15 @@ extern PGDLLIMPORT int NamedLWLockTrancheRequests;
     (LOCK_MANAGER_LWLOCK_OFFSET + NUM_LOCK_PARTITIONS)
 #define CACHE_2PC_LWLOCK_OFFSET \
     (PREDICATELOCK_MANAGER_LWLOCK_OFFSET + NUM_PREDICATELOCK_PARTITIONS)
+#ifdef __TBASE__
+#define PAGE_COMPRESS_LWLOCK_OFFSET \
+	(CACHE_2PC_LWLOCK_OFFSET + NUM_CACHE_2PC_PARTITIONS)
+#define NUM_FIXED_LWLOCKS \
+	(PAGE_COMPRESS_LWLOCK_OFFSET + NUM_PAGE_COMPRESS_PARTITIONS)
+#else
 #define NUM_FIXED_LWLOCKS \
 	(CACHE_2PC_LWLOCK_OFFSET + NUM_CACHE_2PC_PARTITIONS)
+#endif
 typedef enum LWLockMode
 {
     LW_EXCLUSIVE,
@@ -293,6 +305,9 @@ typedef enum BuiltinTrancheIds
 #endif
     LWTRANCHE_TBM,
 	LWTRANCHE_2PC_INFO_CACHE,
+#ifdef __TBASE__
+    LWTRANCHE_PAGE_COMPRESS,
+#endif
     LWTRANCHE_FIRST_USER_DEFINED
 }            BuiltinTrancheIds;
 
@@ -0,0 +1,160 @@
+/*
+ * Tencent is pleased to support the open source community by making TBase available.  
+ * 
+ * Copyright (C) 2019 THL A29 Limited, a Tencent company.  All rights reserved.
+ * 
+ * TBase is licensed under the BSD 3-Clause License, except for the third-party component listed below. 
+ * 
+ * A copy of the BSD 3-Clause License is included in this file.
+ * 
+ * Other dependencies and licenses:
+ * 
+ * Open Source Software Licensed Under the PostgreSQL License: 
+ * --------------------------------------------------------------------
+ * 1. Postgres-XL XL9_5_STABLE
+ * Portions Copyright (c) 2015-2016, 2ndQuadrant Ltd
+ * Portions Copyright (c) 2012-2015, TransLattice, Inc.
+ * Portions Copyright (c) 2010-2017, Postgres-XC Development Group
+ * Portions Copyright (c) 1996-2015, The PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, The Regents of the University of California
+ * 
+ * Terms of the PostgreSQL License: 
+ * --------------------------------------------------------------------
+ * Permission to use, copy, modify, and distribute this software and its
+ * documentation for any purpose, without fee, and without a written agreement
+ * is hereby granted, provided that the above copyright notice and this
+ * paragraph and the following two paragraphs appear in all copies.
+ * 
+ * IN NO EVENT SHALL THE UNIVERSITY OF CALIFORNIA BE LIABLE TO ANY PARTY FOR
+ * DIRECT, INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+ * LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+ * DOCUMENTATION, EVEN IF THE UNIVERSITY OF CALIFORNIA HAS BEEN ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ * 
+ * THE UNIVERSITY OF CALIFORNIA SPECIFICALLY DISCLAIMS ANY WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS FOR A PARTICULAR PURPOSE.  THE SOFTWARE PROVIDED HEREUNDER IS
+ * ON AN "AS IS" BASIS, AND THE UNIVERSITY OF CALIFORNIA HAS NO OBLIGATIONS TO
+ * PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+ * 
+ * 
+ * Terms of the BSD 3-Clause License:
+ * --------------------------------------------------------------------
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation 
+ * and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of THL A29 Limited nor the names of its contributors may be used to endorse or promote products derived from this software without 
+ * specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, 
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS 
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+ * DAMAGE.
+ * 
+ */
+/*-------------------------------------------------------------------------
+ *
+ * pagecompress.h
+ *      compressed page storage for heap relations.
+ *
+ * A compressed relation keeps its main fork as a sequence of fixed-size
+ * chunks.  Each 8KB page is compressed (and then encrypted, if the relation
+ * is under transparent encryption) into as few chunks as possible, and the
+ * address fork (PAGE_COMPRESS_FORKNUM) maps every block number to its run
+ * of chunks.  Layers above smgr always see uncompressed pages, so buffer
+ * manager, checksums and WAL full-page images work unchanged.
+ *
+ * src/include/storage/pagecompress.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PAGECOMPRESS_H
+#define PAGECOMPRESS_H
+
+#include "storage/smgr.h"
+
+#define PC_MAGIC                0x50434D31    /* "PCM1" */
+#define PC_VERSION              1
+
+/* chunk size of the main fork, pages take 1..PC_MAX_CHUNKS chunks */
+#define PC_CHUNK_SIZE           (BLCKSZ / 8)
+#define PC_CHUNKS_PER_PAGE      (BLCKSZ / PC_CHUNK_SIZE)
+/* encrypted images of incompressible pages may be a little over BLCKSZ */
+#define PC_MAX_CHUNKS           (PC_CHUNKS_PER_PAGE * 2)
+
+/*
+ * Block 0 of the address fork.  It is followed by an array of
+ * PageCompressAddr entries indexed by heap block number.
+ */
+typedef struct PageCompressHeader
+{
+    uint32        pch_magic;
+    uint16        pch_version;
+    uint16        pch_chunk_size;
+    BlockNumber pch_nblocks;            /* logical size of the main fork */
+    uint32        pch_allocated_chunks;    /* high water mark of chunks in use */
+} PageCompressHeader;
+
+/*
+ * Address of one page.  pca_nchunks is the capacity of the run of chunks
+ * starting at pca_chunkno; the page is rewritten in place while its image
+ * fits, otherwise a new run is allocated at the end of the fork.  A zero
+ * capacity means the page is all zeroes.
+ */
+typedef struct PageCompressAddr
+{
+    uint32        pca_chunkno;
+    uint16        pca_nchunks;
+    uint16        pca_reserved;
+} PageCompressAddr;
+
+/* byte offset of the address of blkno in the address fork */
+#define PC_ADDR_OFFSET(blkno) \
+    ((uint64) BLCKSZ + (uint64) (blkno) * sizeof(PageCompressAddr))
+
+/* how the image stored in a run of chunks was produced */
+#define PC_METHOD_NONE          0    /* raw page */
+#define PC_METHOD_PGLZ          1    /* pglz compressed */
+
+/* header in front of every page image in the main fork */
+typedef struct PageCompressChunkHeader
+{
+    uint16        pcc_rawlen;        /* length of the image before encryption */
+    uint16        pcc_storedlen;    /* length of the image as stored */
+    uint8        pcc_method;        /* PC_METHOD_xxx */
+    uint8        pcc_reserved;
+    int16        pcc_algo_id;    /* relcrypt algorithm, or invalid */
+} PageCompressChunkHeader;
+
+#define SizeOfPageCompressChunkHeader    sizeof(PageCompressChunkHeader)
+
+extern Size PageCompressShmemSize(void);
+extern void PageCompressShmemInit(void);
+
+/* storage manager callbacks, see smgrsw[] */
+extern void pccreate(SMgrRelation reln, ForkNumber forknum, bool isRedo);
+extern void pcextend(SMgrRelation reln, ForkNumber forknum,
+         BlockNumber blocknum, char *buffer, bool skipFsync);
+extern void pcprefetch(SMgrRelation reln, ForkNumber forknum,
+           BlockNumber blocknum);
+extern void pcread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+       char *buffer);
+extern void pcwrite(SMgrRelation reln, ForkNumber forknum,
+        BlockNumber blocknum, char *buffer, bool skipFsync);
+extern void pcwriteback(SMgrRelation reln, ForkNumber forknum,
+            BlockNumber blocknum, BlockNumber nblocks);
+extern BlockNumber pcnblocks(SMgrRelation reln, ForkNumber forknum);
+extern void pctruncate(SMgrRelation reln, ForkNumber forknum,
+           BlockNumber nblocks);
+extern void pcimmedsync(SMgrRelation reln, ForkNumber forknum);
+#ifdef _SHARDING_
+extern void pcdealloc(SMgrRelation reln, ForkNumber forknum, BlockNumber from_blk);
+#endif
+
+#endif                            /* PAGECOMPRESS_H */
@@ -179,6 +179,8 @@ struct PGPROC
     LWLock         globalxidLock;                /* Protect the following globalXid field */
     char        globalXid[NAMEDATALEN];  /* Global Xid passed from Coordinator */
     bool        hasGlobalXid;      /* Indicate whether it has global xid passed from Coordinator */
+    bool        globalDeadlockVictim;    /* lock wait canceled by the global
+                                         * deadlock detector */
 #endif
 
     int            pgprocno;
@@ -127,6 +127,7 @@ extern TransactionId GetLocalTransactionId(const char *globalXid,
 					TransactionId *subxids, int *nsub, bool *overflowed);
 #endif
 extern char *GetGlobalTransactionId(const TransactionId pid);
+extern bool CancelGlobalTransactionLockWaiter(const char *globalXid, int pid);
 extern bool TransactionIdIsActive(TransactionId xid);
 extern TransactionId GetOldestXmin(Relation rel, int flags);
 extern TransactionId GetOldestXminInternal(Relation rel, int flags,
@@ -172,5 +173,8 @@ extern void ProcArrayGetReplicationSlotXmin(TransactionId *xmin,
 #ifdef __TBASE__
 extern RunningTransactions GetCurrentRunningTransaction(void);
 extern GlobalTimestamp GetLatestCommitTS(void);
+extern bool CommitTsReachedGTS(GlobalTimestamp gts);
+extern bool WaitForCommitsBelowGTS(GlobalTimestamp gts, int timeout_ms,
+                        bool include_prepared);
 #endif
 #endif							/* PROCARRAY_H */
@@ -76,5 +76,9 @@ extern void rel_crypt_struct_init(RelCrypt relcrypt);
 extern void rel_crypt_page_decrypt(RelCrypt relcrypt, Page page);
 extern Page rel_crypt_page_encrypt(RelCrypt relcrypt, Page page);
 extern bool rel_crypt_hash_lookup(RelFileNode * rnode, RelCrypt relcrypt_ret);
+#ifdef __TBASE__
+extern int  rel_crypt_buffer_encrypt(RelCrypt relcrypt, char *src, int srclen, char *dst, int dstlen);
+extern void rel_crypt_buffer_decrypt(int16 algo_id, char *buf, int buflen, char *dst, int rawlen);
+#endif
 
 #endif                            /* RELCRYPT_STORAGE_H */
@@ -94,6 +94,21 @@ typedef struct SMgrRelationData
     int            md_num_open_segs[MAX_FORKNUM + 1];
     struct _MdfdVec *md_seg_fds[MAX_FORKNUM + 1];
 
+#ifdef __TBASE__
+    /* smgr_which checked against the address fork, see smgrprobe() */
+    bool        pc_probed;
+
+    /*
+     * for pagecompress.c; address map already checked during recovery, and
+     * the last header read or written, valid while pc_header_version matches
+     * the version of its lock partition.
+     */
+    bool        pc_map_checked;
+    uint64        pc_header_version;
+    BlockNumber pc_nblocks;
+    uint32        pc_allocated_chunks;
+#endif
+
 #ifdef _MLS_
     RelCryptEntry smgr_relcrypt;
 #endif
@@ -107,9 +122,25 @@ typedef SMgrRelationData *SMgrRelation;
 #define SmgrIsTemp(smgr) \
     RelFileNodeBackendIsTemp((smgr)->smgr_rnode)
 
+#ifdef __TBASE__
+/* values of smgr_which */
+#define SMGR_MD                0    /* magnetic disk */
+#define SMGR_PAGE_COMPRESS    1    /* compressed pages on magnetic disk */
+
+/* storage manager of the relation, probing for the address fork once */
+#define SmgrWhich(smgr) \
+    ((smgr)->pc_probed ? (smgr)->smgr_which : smgrprobe(smgr))
+
+#define SmgrIsPageCompressed(smgr) \
+    (SmgrWhich(smgr) == SMGR_PAGE_COMPRESS)
+#endif
+
 extern void smgrinit(void);
 extern SMgrRelation smgropen(RelFileNode rnode, BackendId backend);
 extern bool smgrexists(SMgrRelation reln, ForkNumber forknum);
+#ifdef __TBASE__
+extern int    smgrprobe(SMgrRelation reln);
+#endif
 extern void smgrsetowner(SMgrRelation *owner, SMgrRelation reln);
 extern void smgrclearowner(SMgrRelation *owner, SMgrRelation reln);
 extern void smgrclose(SMgrRelation reln);
@@ -166,6 +197,13 @@ extern BlockNumber mdnblocks(SMgrRelation reln, ForkNumber forknum);
 extern void mdtruncate(SMgrRelation reln, ForkNumber forknum,
            BlockNumber nblocks);
 extern void mdimmedsync(SMgrRelation reln, ForkNumber forknum);
+extern void mdreadbytes(SMgrRelation reln, ForkNumber forknum, uint64 offset,
+            char *buffer, int nbytes);
+extern void mdwritebytes(SMgrRelation reln, ForkNumber forknum, uint64 offset,
+             char *buffer, int nbytes, bool skipFsync);
+extern void mdtruncatebytes(SMgrRelation reln, ForkNumber forknum,
+                uint64 nbytes);
+extern void mdimmedsyncbytes(SMgrRelation reln, ForkNumber forknum);
 extern void mdpreckpt(void);
 extern void mdsync(void);
 extern void mdpostckpt(void);
@@ -86,7 +86,8 @@ extern List * datamask_get_user_in_white_list(void);
 extern bool dmask_chk_usr_and_col_in_whit_list(Oid relid, Oid userid, int16 attnum);
 extern void datamask_exchange_all_cols_value(Node *node, TupleTableSlot *slot);
 extern bool datamask_scan_key_contain_mask(ScanState *state);
-extern DataMaskState *init_datamask_desc(Oid relid, Form_pg_attribute *attrs, Datamask *datamask);
+extern DataMaskState *init_datamask_desc(Oid relid, Form_pg_attribute *attrs, Datamask *datamask,
+                                         ScanState *scan);
 
 
 #endif /*DATAMASK_H*/
@@ -305,6 +305,9 @@ typedef struct StdRdOptions
 	AutoVacOpts autovacuum;		/* autovacuum-related options */
 	bool		user_catalog_table; /* use as an additional catalog relation */
 	int			parallel_workers;	/* max number of parallel workers */
+#ifdef __TBASE__
+	bool		page_compress;	/* store pages compressed, see pagecompress.c */
+#endif
 } StdRdOptions;
 
 #define HEAP_MIN_FILLFACTOR			10
@@ -343,6 +346,19 @@ typedef struct StdRdOptions
 	  (relation)->rd_rel->relkind == RELKIND_MATVIEW) ? \
 	 ((StdRdOptions *) (relation)->rd_options)->user_catalog_table : false)
 
+#ifdef __TBASE__
+/*
+ * RelationIsPageCompressed
+ *		Returns whether new storage of the relation should be page compressed.
+ *		Only permanent storage is really compressed, see
+ *		RelationCreatePageCompressFork().  Note multiple eval of argument!
+ */
+#define RelationIsPageCompressed(relation) \
+	((relation)->rd_options && \
+	 (relation)->rd_rel->relkind == RELKIND_RELATION ? \
+	 ((StdRdOptions *) (relation)->rd_options)->page_compress : false)
+#endif
+
 /*
  * RelationGetParallelWorkers
  *		Returns the relation's parallel_workers reloption setting.
@@ -72,8 +72,17 @@ extern TransactionId RecentGlobalDataXmin;
 
 extern GlobalTimestamp RecentCommitTs;
 extern GlobalTimestamp RecentDataTs;
+extern GlobalTimestamp RecentDbDataTs;
 extern int	vacuum_delta;
 extern bool vacuum_debug_print;
+extern bool vacuum_database_horizon;
+
+/*
+ * RecentDataTs is held back by the snapshots of every database, which shared
+ * relations need; the others only by their own database, see RecentDbDataTs.
+ */
+#define DataHorizonForRelation(relisshared) \
+	((relisshared) ? RecentDataTs : RecentDbDataTs)
 
 
 #ifdef _SHARDING_
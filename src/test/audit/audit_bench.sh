@@ -0,0 +1,60 @@
+#! /bin/sh
+# src/test/audit/audit_bench.sh
+#
+# Measure pgbench TPS with auditing off, with every statement audited and
+# written as text by backends, and with the same audit written as binary
+# records formatted by audit logger (alog_binary_records).
+#
+# Usage: audit_bench.sh [dbname [clients [seconds [scale]]]]
+#
+# Connection settings come from the usual PGHOST, PGPORT and PGUSER.  The
+# audit_admin user must be able to connect to the database, and PGUSER must
+# be allowed to run ALTER SYSTEM.  alog_binary_records only changes at server
+# start, so PGDATA must name the data directory of the node to restart.
+#
+# alog_binary_records is off by default; no measurement backs turning it on
+# yet, so compare the last two runs before doing so.
+
+DBNAME=${1:-audit_bench}
+CLIENTS=${2:-32}
+SECONDS_PER_RUN=${3:-60}
+SCALE=${4:-10}
+
+PSQL="psql -X -q -v ON_ERROR_STOP=1"
+
+set_audit()
+{
+	$PSQL -d "$DBNAME" -c "ALTER SYSTEM SET enable_audit = $1" || exit 1
+	$PSQL -d "$DBNAME" -c "ALTER SYSTEM SET alog_binary_records = $2" || exit 1
+	pg_ctl restart -D "$PGDATA" -w -m fast > /dev/null || exit 1
+}
+
+run_bench()
+{
+	pgbench -n -c "$CLIENTS" -j "$CLIENTS" -T "$SECONDS_PER_RUN" -M prepared "$DBNAME" 2>/dev/null |
+		sed -n 's/^tps = \([0-9.]*\) (excluding.*/\1/p'
+}
+
+createdb "$DBNAME" 2>/dev/null
+pgbench -i -q -s "$SCALE" "$DBNAME" || exit 1
+
+$PSQL -d "$DBNAME" -U audit_admin -c "audit all" || exit 1
+
+set_audit off off
+TPS_OFF=`run_bench`
+
+set_audit on off
+TPS_TEXT=`run_bench`
+
+set_audit on on
+TPS_BINARY=`run_bench`
+
+$PSQL -d "$DBNAME" -U audit_admin -c "noaudit all" > /dev/null
+$PSQL -d "$DBNAME" -c "ALTER SYSTEM RESET enable_audit" > /dev/null
+$PSQL -d "$DBNAME" -c "ALTER SYSTEM RESET alog_binary_records" > /dev/null
+pg_ctl restart -D "$PGDATA" -w -m fast > /dev/null
+
+echo "clients: $CLIENTS, seconds: $SECONDS_PER_RUN, scale: $SCALE"
+echo "audit off:                 $TPS_OFF tps"
+echo "audit on, text records:    $TPS_TEXT tps"
+echo "audit on, binary records:  $TPS_BINARY tps"
@@ -0,0 +1,29 @@
+# Masking decisions are cached for the statement that made them.  A read
+# only transaction under READ COMMITTED keeps its command id, yet each of
+# its statements must see the masking rules committed before it started.
+
+setup
+{
+  CREATE EXTENSION IF NOT EXISTS tbase_mls;
+  CREATE TABLE dm_rc (id int, secret int);
+  INSERT INTO dm_rc VALUES (1, 100), (2, 200);
+}
+
+teardown
+{
+  SET SESSION AUTHORIZATION mls_admin;
+  SELECT MLS_DATAMASK_DROP_TABLE_POLICY('public', 'dm_rc');
+  RESET SESSION AUTHORIZATION;
+  DROP TABLE dm_rc;
+}
+
+session "reader"
+setup		{ BEGIN ISOLATION LEVEL READ COMMITTED READ ONLY; }
+step "r_sel"	{ SELECT id, secret FROM dm_rc ORDER BY id; }
+step "r_commit"	{ COMMIT; }
+
+session "admin"
+setup		{ SET SESSION AUTHORIZATION mls_admin; }
+step "a_mask"	{ SELECT MLS_DATAMASK_CREATE('public', 'dm_rc', 'secret', 1, 7777); }
+
+permutation "r_sel" "a_mask" "r_sel" "r_commit"
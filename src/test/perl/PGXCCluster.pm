@@ -0,0 +1,425 @@
+=pod
+
+=head1 NAME
+
+PGXCCluster - a GTM, coordinators and datanodes for TAP tests
+
+=head1 SYNOPSIS
+
+  use PGXCCluster;
+
+  # One GTM, two coordinators and two datanodes, registered with each
+  # other and started
+  my $cluster = PGXCCluster->new('main', coordinators => 2, datanodes => 2);
+
+  my $cn1 = $cluster->coordinator(0);
+  $cn1->safe_psql('postgres', 'create table t (a int) distribute by shard (a)');
+
+  # Nodes are PostgresNode objects; restarts keep their node type
+  $cluster->datanode(1)->restart;
+
+  # A hot standby of a datanode, in another plane
+  my $standby = $cluster->add_datanode_standby(0, 'standby_plane');
+
+=head1 DESCRIPTION
+
+PGXCCluster sets up the nodes the same way pg_regress does for a temporary
+installation, but with the node handling of PostgresNode, so tests can
+stop, crash, back up and restart single nodes of a cluster.
+
+=cut
+
+package PGXCNode;
+
+use strict;
+use warnings;
+
+use PostgresNode;
+use TestLib ();
+
+our @ISA = ('PostgresNode');
+
+=pod
+
+=head1 PGXCNode METHODS
+
+PGXCNode is a PostgresNode that knows its node type: 'gtm', 'coordinator'
+or 'datanode'.
+
+=over
+
+=item PGXCNode->get_new_pgxc_node(name, type)
+
+Like PostgresNode::get_new_node, for a node of the given type.
+
+=cut
+
+sub get_new_pgxc_node
+{
+	my ($class, $name, $type) = @_;
+	my $node = PostgresNode::get_new_node($class, $name);
+
+	$node->{_pgxc_type} = $type;
+	return $node;
+}
+
+sub pgxc_type
+{
+	my ($self) = @_;
+	return $self->{_pgxc_type};
+}
+
+=pod
+
+=item $node->init(gtm => gtm node, ...)
+
+Runs initgtm for a GTM, otherwise initdb with the node name and type and
+the GTM to use.  Other parameters are those of PostgresNode::init.
+
+=cut
+
+sub init
+{
+	my ($self, %params) = @_;
+	my $name   = $self->name;
+	my $pgdata = $self->data_dir;
+
+	if ($self->pgxc_type eq 'gtm')
+	{
+		TestLib::system_or_bail('initgtm', '-Z', 'gtm', '-D', $pgdata);
+		$self->append_conf('gtm.conf', qq(
+nodename = '$name'
+port = ${\ $self->port }
+));
+		return;
+	}
+
+	my $gtm = $params{gtm};
+	die "node \"$name\" needs a GTM" unless defined $gtm;
+
+	$params{extra} = [
+		'--nodename',            $name,
+		'--nodetype',            $self->pgxc_type,
+		'--master_gtm_nodename', $gtm->name,
+		'--master_gtm_ip',       'localhost',
+		'--master_gtm_port',     $gtm->port,
+		@{ $params{extra} || [] } ];
+	$self->SUPER::init(%params);
+
+	# Internode connections go through the socket directory of the nodes.
+	# The pooler socket is named after its port, which must be unique.
+	$self->append_conf('postgresql.conf', qq(
+pooler_port = ${\ ($self->port + 1000) }
+max_connections = 100
+max_prepared_transactions = 100
+max_pool_size = 100
+sequence_range = 1
+));
+	return;
+}
+
+=pod
+
+=item $node->start() / stop() / restart() / teardown_node()
+
+Like their PostgresNode counterparts, with gtm_ctl for a GTM and the node
+type passed to the postmaster otherwise.  restart is a stop and a start, as
+pg_ctl restart would not pass the node type on.
+
+=cut
+
+sub start
+{
+	my ($self) = @_;
+	my $name = $self->name;
+
+	Test::More::BAIL_OUT("node \"$name\" is already running") if defined $self->{_pid};
+
+	if ($self->pgxc_type ne 'gtm')
+	{
+		print("### Starting node \"$name\"\n");
+		my $ret = TestLib::system_log('pg_ctl', '-Z', $self->pgxc_type,
+			'-D', $self->data_dir, '-l', $self->logfile, 'start');
+
+		if ($ret != 0)
+		{
+			print "# pg_ctl start failed; logfile:\n";
+			print TestLib::slurp_file($self->logfile);
+			Test::More::BAIL_OUT("pg_ctl start failed");
+		}
+
+		$self->_update_pid(1);
+		return;
+	}
+
+	print("### Starting GTM \"$name\"\n");
+	TestLib::system_or_bail('gtm_ctl', 'start', '-Z', 'gtm', '-D',
+		$self->data_dir, '-l', $self->logfile, '-o',
+		'-p ' . $self->port);
+
+	# gtm_ctl does not wait for the GTM to accept connections
+	sleep 1;
+	$self->{_pid} = 1;
+	return;
+}
+
+sub stop
+{
+	my ($self, $mode) = @_;
+
+	return $self->SUPER::stop($mode)
+	  unless $self->pgxc_type eq 'gtm';
+
+	$mode = 'fast' unless defined $mode;
+	return unless defined $self->{_pid};
+	print "### Stopping GTM \"${\ $self->name }\" using mode $mode\n";
+	TestLib::system_or_bail('gtm_ctl', 'stop', '-Z', 'gtm', '-D',
+		$self->data_dir, '-m', $mode);
+	delete $self->{_pid};
+	return;
+}
+
+sub restart
+{
+	my ($self) = @_;
+
+	$self->stop;
+	$self->start;
+	return;
+}
+
+sub teardown_node
+{
+	my ($self) = @_;
+
+	return $self->SUPER::teardown_node
+	  unless $self->pgxc_type eq 'gtm';
+
+	$self->stop('immediate');
+	return;
+}
+
+=pod
+
+=item $node->wait_for_subscription_sync()
+
+Waits until every table of the subscriptions on the node has finished its
+initial synchronization.
+
+=cut
+
+sub wait_for_subscription_sync
+{
+	my ($self) = @_;
+	my $query = "SELECT count(1) = 0 FROM pg_subscription_rel "
+	  . "WHERE srsubstate NOT IN ('r', 's')";
+
+	$self->poll_query_until('postgres', $query)
+	  or die "timed out waiting for \"${\ $self->name }\" to synchronize tables";
+	return;
+}
+
+=pod
+
+=back
+
+=cut
+
+package PGXCCluster;
+
+use strict;
+use warnings;
+
+use PostgresNode;
+use TestLib;
+use Test::More;
+
+=pod
+
+=head1 PGXCCluster METHODS
+
+=over
+
+=item PGXCCluster->new(name, coordinators => n, datanodes => m, conf => str)
+
+Creates, registers and starts a GTM, n coordinators (default 1) and m
+datanodes (default 2), named "<name>_cn1", "<name>_dn1" and so on.  conf is
+appended to postgresql.conf of every coordinator and datanode before they
+start.  The datanodes form the default node group.
+
+=cut
+
+sub new
+{
+	my ($class, $name, %params) = @_;
+	my $ncoords = defined $params{coordinators} ? $params{coordinators} : 1;
+	my $ndns    = defined $params{datanodes}    ? $params{datanodes}    : 2;
+	my $self    = bless {
+		name         => $name,
+		gtm          => undef,
+		coordinators => [],
+		datanodes    => [],
+		standbys     => [],
+	}, $class;
+
+	$self->{gtm} = PGXCNode->get_new_pgxc_node("${name}_gtm", 'gtm');
+	$self->{gtm}->init;
+	$self->{gtm}->start;
+
+	for my $i (1 .. $ncoords)
+	{
+		push @{ $self->{coordinators} },
+		  $self->_new_node("${name}_cn$i", 'coordinator', %params);
+	}
+	for my $i (1 .. $ndns)
+	{
+		push @{ $self->{datanodes} },
+		  $self->_new_node("${name}_dn$i", 'datanode', %params);
+	}
+
+	$self->_register_nodes;
+	return $self;
+}
+
+sub _new_node
+{
+	my ($self, $name, $type, %params) = @_;
+	my $node = PGXCNode->get_new_pgxc_node($name, $type);
+
+	$node->init(
+		gtm              => $self->{gtm},
+		allows_streaming => $params{allows_streaming} || 0);
+	$node->append_conf('postgresql.conf', $params{conf})
+	  if defined $params{conf};
+	$node->start;
+	return $node;
+}
+
+sub _node_options
+{
+	my ($node, $extra) = @_;
+	my $type = $node->pgxc_type;
+	my $host = $node->host;
+	my $port = $node->port;
+
+	return "type = '$type', host = '$host', port = $port" . ($extra || '');
+}
+
+# CREATE NODE for every node on every coordinator and datanode, like
+# setup_connection_information() of pg_regress
+sub _register_nodes
+{
+	my ($self) = @_;
+	my @nodes = ($self->all_nodes);
+	my $first_dn = $self->{datanodes}[0];
+
+	foreach my $target (@nodes)
+	{
+		my $sql = '';
+
+		foreach my $node (@nodes)
+		{
+			my $verb = $node == $target ? 'ALTER' : 'CREATE';
+			my $extra = (defined $first_dn && $node == $first_dn)
+			  ? ', primary, preferred' : '';
+
+			$sql .= "$verb NODE ${\ $node->name } WITH ("
+			  . _node_options($node, $extra) . ");\n";
+		}
+		$sql .= "SELECT pgxc_pool_reload();\n";
+		$target->safe_psql('postgres', $sql);
+	}
+
+	return unless @{ $self->{datanodes} } && @{ $self->{coordinators} };
+
+	my $dns = join(', ', map { $_->name } @{ $self->{datanodes} });
+	$self->coordinator(0)->safe_psql('postgres', qq(
+create default node group default_group with ($dns);
+create sharding group to group default_group;
+clean sharding;
+));
+	return;
+}
+
+=pod
+
+=item $cluster->add_datanode_standby(index, plane, conf => str)
+
+Makes a streaming hot standby of datanode index, registers it on the
+coordinators as that datanode in the given plane (pgxc_cluster_name) and
+returns it.  The datanode must have been created with allows_streaming.
+
+=cut
+
+sub add_datanode_standby
+{
+	my ($self, $index, $plane, %params) = @_;
+	my $primary = $self->datanode($index);
+	my $backup  = "${\ $primary->name }_standby_backup";
+	my $standby =
+	  PGXCNode->get_new_pgxc_node("${\ $primary->name }_$plane", 'datanode');
+
+	$primary->backup($backup);
+	$standby->init_from_backup($primary, $backup, has_streaming => 1);
+	$standby->append_conf('postgresql.conf', qq(
+pooler_port = ${\ ($standby->port + 1000) }
+pgxc_cluster_name = '$plane'
+));
+	$standby->append_conf('postgresql.conf', $params{conf})
+	  if defined $params{conf};
+	$standby->start;
+
+	# a standby has the name of its datanode
+	my $name = $primary->name;
+	foreach my $cn (@{ $self->{coordinators} })
+	{
+		$cn->safe_psql('postgres',
+			"CREATE NODE $name WITH ("
+			  . _node_options($standby, ", cluster = '$plane'")
+			  . ");\nSELECT pgxc_pool_reload();");
+	}
+
+	push @{ $self->{standbys} }, $standby;
+	return $standby;
+}
+
+=pod
+
+=item $cluster->gtm() / coordinator(i) / datanode(i) / all_nodes()
+
+Accessors, indexes start at 0.  all_nodes returns the coordinators and
+datanodes, without the GTM and standbys.
+
+=cut
+
+sub gtm
+{
+	my ($self) = @_;
+	return $self->{gtm};
+}
+
+sub coordinator
+{
+	my ($self, $i) = @_;
+	return $self->{coordinators}[$i];
+}
+
+sub datanode
+{
+	my ($self, $i) = @_;
+	return $self->{datanodes}[$i];
+}
+
+sub all_nodes
+{
+	my ($self) = @_;
+	return (@{ $self->{coordinators} }, @{ $self->{datanodes} });
+}
+
+=pod
+
+=back
+
+=cut
+
+1;
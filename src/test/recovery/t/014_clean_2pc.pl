@@ -0,0 +1,63 @@
+# Test that clean 2pc leaves transactions prepared by users alone.
+#
+# After a coordinator restarts, the 2pc it started in its earlier life are
+# resolved from its local 2pc records.  An explicit PREPARE TRANSACTION has
+# such a record too, but it is up to the user to finish it.
+use strict;
+use warnings;
+
+use PGXCCluster;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 5;
+
+my $cluster = PGXCCluster->new(
+	'clean2pc',
+	coordinators => 1,
+	datanodes    => 2,
+	conf         => qq(
+auto_clean_2pc_interval = 10s
+auto_clean_2pc_delay = 3s
+));
+my $cn = $cluster->coordinator(0);
+
+$cn->safe_psql(
+	'postgres', qq(
+create table c2pc_tbl (id int, val int) distribute by shard (id);
+insert into c2pc_tbl select i, i from generate_series(1, 100) i;
+));
+
+# The writes span both datanodes
+$cn->safe_psql(
+	'postgres', qq(
+begin;
+update c2pc_tbl set val = val + 1;
+insert into c2pc_tbl select i, i from generate_series(101, 110) i;
+prepare transaction 'c2pc_explicit';
+));
+
+# Crash the coordinator, its start node records survive
+$cn->stop('immediate');
+$cn->start;
+
+is($cn->safe_psql('postgres', 'select count(*) from tbase_clean_2pc_in_doubt()'),
+	'0', 'explicit prepared transaction is not in doubt');
+
+# Give the clean 2pc launcher a few rounds
+sleep 25;
+
+foreach my $dn ($cluster->datanode(0), $cluster->datanode(1))
+{
+	is( $dn->safe_psql(
+			'postgres',
+			"select count(*) from pg_prepared_xacts where gid = 'c2pc_explicit'"),
+		'1',
+		'explicit prepared transaction is still prepared on ' . $dn->name);
+}
+
+is($cn->safe_psql('postgres', 'select count(*), sum(val) from c2pc_tbl'),
+	'100|5050', 'prepared changes are not visible yet');
+
+$cn->safe_psql('postgres', "commit prepared 'c2pc_explicit'");
+is($cn->safe_psql('postgres', 'select count(*), sum(val) from c2pc_tbl'),
+	'110|6205', 'user commits the prepared transaction after the restart');
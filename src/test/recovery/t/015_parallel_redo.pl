@@ -0,0 +1,114 @@
+# Test parallel replay of WAL on a datanode standby
+#
+# A hot standby of a datanode replays with parallel_redo_workers while the
+# cluster runs a mixed workload.  Its contents must match the primary's,
+# before and after it is promoted, through both heap and index scans.
+use strict;
+use warnings;
+use PGXCCluster;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 8;
+
+my $cluster = PGXCCluster->new(
+	'redo',
+	coordinators     => 1,
+	datanodes        => 2,
+	allows_streaming => 1);
+my $cn      = $cluster->coordinator(0);
+my $primary = $cluster->datanode(0);
+
+$cn->safe_psql(
+	'postgres', qq(
+create table pr_heap (id int primary key, v int, t text) distribute by shard (id);
+create index pr_heap_v on pr_heap (v);
+insert into pr_heap select i, i % 100, md5(i::text) from generate_series(1, 1000) i;
+));
+
+my $standby = $cluster->add_datanode_standby(0, 'redo_plane',
+	conf => "parallel_redo_workers = 4\n");
+
+# The workers start once the standby is consistent
+$cn->safe_psql('postgres', 'checkpoint');
+ok( poll_log($standby, qr/started 4 parallel redo workers/),
+	'parallel redo workers started');
+
+# Mixed workload: inserts, HOT and non-HOT updates, deletes, vacuum, TOAST,
+# index builds, truncation, dropped tables and two-phase commits
+$cn->safe_psql(
+	'postgres', qq(
+insert into pr_heap select i, i % 100, md5(i::text) from generate_series(1001, 30000) i;
+update pr_heap set t = t || 'x' where id % 3 = 0;
+update pr_heap set v = v + 1000 where id % 7 = 0;
+delete from pr_heap where id % 11 = 0;
+vacuum pr_heap;
+insert into pr_heap select i, i, repeat(md5(i::text), 300) from generate_series(30001, 30100) i;
+create table pr_trunc (a int, b int) distribute by shard (a);
+insert into pr_trunc select i, i from generate_series(1, 5000) i;
+truncate pr_trunc;
+insert into pr_trunc select i, -i from generate_series(1, 2000) i;
+create index pr_trunc_b on pr_trunc (b);
+create table pr_drop (a int) distribute by shard (a);
+insert into pr_drop select generate_series(1, 5000);
+drop table pr_drop;
+begin;
+update pr_heap set t = 'in 2pc' where id between 100 and 200;
+insert into pr_trunc select i, i from generate_series(5001, 6000) i;
+prepare transaction 'pr_2pc';
+commit prepared 'pr_2pc';
+delete from pr_trunc where a % 2 = 0;
+vacuum pr_trunc;
+));
+
+$primary->wait_for_catchup($standby->name, 'replay', $primary->lsn('insert'));
+
+my @checks = (
+	"select count(*), sum(v), md5(string_agg(t, ',' order by id)) from pr_heap",
+	"select count(*), sum(b) from pr_trunc",
+	"set enable_seqscan = off; set enable_bitmapscan = off; "
+	  . "select count(*), sum(v) from pr_heap where v >= 0",
+	"set enable_seqscan = off; set enable_bitmapscan = off; "
+	  . "select count(*), sum(b) from pr_trunc where b > -1000000");
+
+is($standby->safe_psql('postgres', $checks[0]),
+	$primary->safe_psql('postgres', $checks[0]),
+	'heap matches on the hot standby');
+is($standby->safe_psql('postgres', $checks[2]),
+	$primary->safe_psql('postgres', $checks[2]),
+	'index scan matches on the hot standby');
+
+# Replay is complete at promotion, and the promoted node is consistent
+$standby->promote;
+$standby->poll_query_until('postgres', 'select not pg_is_in_recovery()')
+  or die "timed out waiting for promotion";
+
+my $i = 0;
+foreach my $check (@checks)
+{
+	$i++;
+	is($standby->safe_psql('postgres', $check),
+		$primary->safe_psql('postgres', $check),
+		"check $i matches after promotion");
+}
+
+# The promoted node takes writes, and its indexes are usable
+$standby->safe_psql('postgres',
+	'insert into pr_heap select i, i, null from generate_series(40001, 41000) i');
+is( $standby->safe_psql(
+		'postgres',
+		'set enable_seqscan = off; set enable_bitmapscan = off; '
+		  . 'select count(*) from pr_heap where v between 40001 and 41000'),
+	'1000',
+	'promoted node inserts through its indexes');
+
+sub poll_log
+{
+	my ($node, $re) = @_;
+
+	foreach my $n (1 .. 180)
+	{
+		return 1 if slurp_file($node->logfile) =~ $re;
+		sleep 1;
+	}
+	return 0;
+}
@@ -0,0 +1,104 @@
+# Test reads routed to a hot standby of a datanode
+#
+# With enable_standby_read_routing, a read-only transaction may read from a
+# standby that has replayed up to its snapshot, taken
+# standby_plane_query_delay seconds in the past.  A standby that lags behind
+# must not serve it: the read goes to the datanode and never returns rows
+# older than its snapshot.
+use strict;
+use warnings;
+use PGXCCluster;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 6;
+use Time::HiRes qw(usleep);
+
+my $cluster = PGXCCluster->new(
+	'sread',
+	coordinators     => 1,
+	datanodes        => 1,
+	allows_streaming => 1,
+	conf             => qq(
+enable_standby_read_routing = on
+standby_read_refresh_interval = 100
+standby_plane_query_delay = 1
+));
+my $cn      = $cluster->coordinator(0);
+my $primary = $cluster->datanode(0);
+
+$cn->safe_psql(
+	'postgres', qq(
+create table sr_tab (id int primary key, v int) distribute by shard (id);
+insert into sr_tab select i, 1 from generate_series(1, 1000) i;
+));
+
+my $standby = $cluster->add_datanode_standby(0, 'read_plane');
+$primary->wait_for_catchup($standby->name, 'replay', $primary->lsn('insert'));
+
+# Each read carries its own marker, to find in the log of the standby
+# whether the standby served it
+my $nread = 0;
+
+sub read_tab
+{
+	my ($tag) = @_;
+
+	$nread++;
+	my $marker = "${tag}_$nread";
+	my $result = $cn->safe_psql('postgres',
+		"select count(*), sum(v), '$marker' from sr_tab");
+	$result =~ s/\|\Q$marker\E$//;
+	return ($result, $marker);
+}
+
+sub served_by_standby
+{
+	my ($marker) = @_;
+
+	return slurp_file($standby->logfile) =~ /\Q$marker\E/;
+}
+
+# read until the standby serves one
+sub read_from_standby
+{
+	my ($tag) = @_;
+
+	foreach my $i (1 .. 300)
+	{
+		my ($result, $marker) = read_tab($tag);
+		return $result if served_by_standby($marker);
+		usleep(100_000);
+	}
+	return undef;
+}
+
+my $result = read_from_standby('caught_up');
+ok(defined $result, 'read routed to the standby once it has caught up');
+is($result, '1000|1000', 'standby read returns the data');
+
+# Stop replay and change every row
+$standby->safe_psql('postgres', 'select pg_wal_replay_pause()');
+$cn->safe_psql('postgres', 'update sr_tab set v = 2');
+
+# past the delay, the snapshot of any read is newer than the update, and the
+# pooler has polled the standby several times
+sleep 3;
+
+my $stale  = 0;
+my $routed = 0;
+foreach my $i (1 .. 20)
+{
+	my ($res, $marker) = read_tab('lagging');
+	$stale++ if $res ne '1000|2000';
+	$routed++ if served_by_standby($marker);
+}
+is($stale, 0, 'no read returns rows older than its snapshot');
+is($routed, 0, 'reads fall back to the datanode while the standby lags');
+
+# Once replay resumes and catches up, the standby serves reads again
+$standby->safe_psql('postgres', 'select pg_wal_replay_resume()');
+$primary->wait_for_catchup($standby->name, 'replay', $primary->lsn('insert'));
+
+$result = read_from_standby('resumed');
+ok(defined $result, 'read routed to the standby after it caught up again');
+is($result, '1000|2000', 'standby read returns the updated rows');
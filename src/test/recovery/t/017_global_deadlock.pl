@@ -0,0 +1,131 @@
+# Test the global deadlock detector on a cycle spanning two datanodes
+#
+# Two transactions each lock a row on a different datanode, then wait for
+# the row of the other one.  Neither datanode sees a cycle on its own; the
+# detector on the coordinator must cancel the wait of one of them, and let
+# the other one go on.
+use strict;
+use warnings;
+
+use PGXCCluster;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 5;
+use Time::HiRes qw(usleep);
+
+my $cluster = PGXCCluster->new(
+	'gdd',
+	coordinators => 1,
+	datanodes    => 2,
+	conf         => qq(
+enable_global_deadlock_detector = on
+global_deadlock_detector_interval = 200
+lock_timeout = 0
+));
+my $cn = $cluster->coordinator(0);
+
+$cn->safe_psql(
+	'postgres', qq(
+create table gd_tab (id int primary key, v int) distribute by shard (id);
+insert into gd_tab select i, 0 from generate_series(1, 100) i;
+));
+
+# a row on each datanode
+my $id_a = $cn->safe_psql('postgres',
+	'select min(id) from gd_tab where xc_node_id = (select min(xc_node_id) from gd_tab)');
+my $id_b = $cn->safe_psql('postgres',
+	'select min(id) from gd_tab where xc_node_id = (select max(xc_node_id) from gd_tab)');
+
+# Sessions that stay around, with statements that may wait
+sub start_session
+{
+	my $s = { stdin => '', stdout => '', stderr => '' };
+
+	$s->{handle} = IPC::Run::start(
+		[   'psql', '-X', '-qAt', '-f', '-', '-d',
+			$cn->connstr('postgres') ],
+		'<',
+		\$s->{stdin},
+		'>',
+		\$s->{stdout},
+		'2>',
+		\$s->{stderr});
+	return $s;
+}
+
+sub send_sql
+{
+	my ($s, $sql) = @_;
+
+	$s->{stdin} .= "$sql\n";
+	$s->{handle}->pump_nb;
+	return;
+}
+
+# pump both sessions until $cond returns true
+sub wait_until
+{
+	my ($cond, @sessions) = @_;
+
+	foreach my $i (1 .. 1800)
+	{
+		$_->{handle}->pump_nb foreach @sessions;
+		return 1 if $cond->();
+		usleep(100_000);
+	}
+	return 0;
+}
+
+my $s1 = start_session();
+my $s2 = start_session();
+
+send_sql($s1, "begin; update gd_tab set v = v + 1 where id = $id_a; select 's1_locked';");
+send_sql($s2, "begin; update gd_tab set v = v + 10 where id = $id_b; select 's2_locked';");
+wait_until(sub { $s1->{stdout} =~ /s1_locked/ && $s2->{stdout} =~ /s2_locked/ },
+	$s1, $s2)
+  or die "timed out waiting for the first locks";
+
+# close the cycle
+send_sql($s1, "update gd_tab set v = v + 1 where id = $id_b; select 's1_done';");
+send_sql($s2, "update gd_tab set v = v + 10 where id = $id_a; select 's2_done';");
+
+my $deadlock = qr/global deadlock detected/;
+ok( wait_until(
+		sub {
+			($s1->{stderr} =~ $deadlock && $s2->{stdout} =~ /s2_done/)
+			  || ($s2->{stderr} =~ $deadlock && $s1->{stdout} =~ /s1_done/);
+		},
+		$s1,
+		$s2),
+	'one wait of the cycle is canceled and the other transaction goes on');
+isnt($s1->{stderr} =~ $deadlock, $s2->{stderr} =~ $deadlock,
+	'only one transaction is the victim');
+
+my ($victim, $survivor, $expected) =
+  $s1->{stderr} =~ $deadlock ? ($s1, $s2, 20) : ($s2, $s1, 2);
+
+send_sql($victim,
+	"rollback; select count(*) from gd_tab; select 'victim_done';");
+send_sql($survivor, "commit; select 'survivor_done';");
+wait_until(
+	sub {
+		$victim->{stdout} =~ /victim_done/
+		  && $survivor->{stdout} =~ /survivor_done/;
+	},
+	$s1,
+	$s2) or die "timed out waiting for the transactions to end";
+$s1->{handle}->finish;
+$s2->{handle}->finish;
+
+is($cn->safe_psql('postgres', "select sum(v) from gd_tab where id in ($id_a, $id_b)"),
+	$expected, 'both updates of the surviving transaction are committed');
+like(slurp_file($cn->logfile),
+	qr/global deadlock detected, canceling global transaction/,
+	'detector logged the cycle');
+
+# the cancel only hit the wait, not a later statement of the victim's session;
+# the marker after the canceled update fails as the transaction is aborted
+my @errors = grep { !/current transaction is aborted/ }
+  $victim->{stderr} =~ /^.*ERROR:.*$/mg;
+ok($victim->{stdout} =~ /^100$/m && @errors == 1,
+	'session of the victim is usable after the rollback');
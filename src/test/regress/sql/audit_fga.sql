@@ -70,5 +70,21 @@ select * from pg_audit_fga_conf;
 select * from pg_audit_fga_conf_detail ;
 select *from pg_audit_fga_policy_columns_detail;
 
+-- policies of a dropped table can still be changed and dropped
+\c audit_fga_database audit_fga_user
+create table baz(idx bigint, str text);
+
+\c audit_fga_database audit_admin
+select add_policy(object_schema:='public', object_name:='baz', audit_columns:='idx',policy_name:='poli5', audit_condition:='idx > 1');
+
+\c audit_fga_database audit_fga_user
+drop table baz;
+
+\c audit_fga_database audit_admin
+select disable_policy(object_schema:='public', object_name:='baz', policy_name:='poli5');
+select enable_policy(object_schema:='public', object_name:='baz', policy_name:='poli5');
+select drop_policy(object_schema:='public', object_name:='baz', policy_name:='poli5');
+select count(*) from pg_audit_fga_conf where policy_name = 'poli5';
+
 
 
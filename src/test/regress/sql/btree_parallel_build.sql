@@ -0,0 +1,55 @@
+--
+-- Parallel btree builds must give the same index as a serial build, and
+-- find duplicates that end up in the shares of different participants
+--
+CREATE TABLE pbt_tbl (id int, val int, note text) DISTRIBUTE BY SHARD (id);
+INSERT INTO pbt_tbl SELECT i, i % 1000, md5(i::text) FROM generate_series(1, 50000) i;
+-- dead and updated tuples, which go to the dead spool or are left out
+DELETE FROM pbt_tbl WHERE id % 17 = 0;
+UPDATE pbt_tbl SET note = 'upd' WHERE id % 13 = 0;
+
+-- read back through the index only, in index order
+SET enable_seqscan = off;
+SET enable_bitmapscan = off;
+SET min_parallel_table_scan_size = 0;
+
+SET max_parallel_maintenance_workers = 0;
+CREATE INDEX pbt_idx ON pbt_tbl (val, note);
+SELECT count(*) AS serial_count,
+       md5(string_agg(val || ':' || note, ',')) AS serial_md5
+  FROM (SELECT val, note FROM pbt_tbl WHERE val >= 0 ORDER BY val, note) s \gset
+SELECT count(*) AS serial_eq_count FROM pbt_tbl WHERE val = 500 \gset
+DROP INDEX pbt_idx;
+
+SET max_parallel_maintenance_workers = 4;
+ALTER TABLE pbt_tbl SET (parallel_workers = 4);
+CREATE INDEX pbt_idx ON pbt_tbl (val, note);
+SELECT count(*) = :serial_count AS same_count,
+       md5(string_agg(val || ':' || note, ',')) = :'serial_md5' AS same_entries
+  FROM (SELECT val, note FROM pbt_tbl WHERE val >= 0 ORDER BY val, note) s;
+SELECT count(*) = :serial_eq_count AS same_lookup FROM pbt_tbl WHERE val = 500;
+
+-- the parallel index is maintained like any other
+INSERT INTO pbt_tbl VALUES (50001, 500, 'new');
+SELECT count(*) = :serial_eq_count + 1 AS lookup_after_insert FROM pbt_tbl WHERE val = 500;
+
+-- unique builds: the duplicate is in the last blocks, far from the first
+-- copy, so most likely in the share of another participant
+CREATE TABLE pbt_uniq (id int, pad text) DISTRIBUTE BY SHARD (id);
+ALTER TABLE pbt_uniq SET (parallel_workers = 4);
+INSERT INTO pbt_uniq SELECT i, repeat('x', 100) FROM generate_series(1, 20000) i;
+INSERT INTO pbt_uniq VALUES (42, 'dup');
+CREATE UNIQUE INDEX pbt_uniq_id ON pbt_uniq (id);
+
+-- a dead duplicate is not a violation, and the index enforces uniqueness
+DELETE FROM pbt_uniq WHERE pad = 'dup';
+CREATE UNIQUE INDEX pbt_uniq_id ON pbt_uniq (id);
+INSERT INTO pbt_uniq VALUES (42, 'again');
+SELECT count(*) FROM pbt_uniq WHERE id = 42;
+
+RESET enable_seqscan;
+RESET enable_bitmapscan;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_maintenance_workers;
+DROP TABLE pbt_tbl;
+DROP TABLE pbt_uniq;
@@ -0,0 +1,25 @@
+--
+-- 2pc left in doubt by an earlier life of the coordinator
+--
+CREATE TABLE clean_2pc_tbl (id int, val int) DISTRIBUTE BY SHARD (id);
+
+-- implicit 2pc, the writes span datanodes
+INSERT INTO clean_2pc_tbl SELECT i, i FROM generate_series(1, 100) i;
+BEGIN;
+UPDATE clean_2pc_tbl SET val = val + 1;
+INSERT INTO clean_2pc_tbl VALUES (101, 101);
+COMMIT;
+
+-- started by this life of the node, none of them is in doubt
+SELECT count(*) FROM tbase_clean_2pc_in_doubt();
+
+-- nor is a transaction prepared by a live session
+BEGIN;
+DELETE FROM clean_2pc_tbl WHERE id > 50;
+PREPARE TRANSACTION 'clean_2pc_live';
+SELECT count(*) FROM tbase_clean_2pc_in_doubt();
+COMMIT PREPARED 'clean_2pc_live';
+
+SELECT count(*), sum(val) FROM clean_2pc_tbl;
+
+DROP TABLE clean_2pc_tbl;
@@ -0,0 +1,21 @@
+--
+-- Vacuum data horizon of each database
+--
+SHOW vacuum_database_horizon;
+
+BEGIN ISOLATION LEVEL REPEATABLE READ;
+SELECT count(*) FROM pg_class WHERE relname = 'pg_class';
+
+-- our snapshot is kept, so this database has a holder
+SELECT count(*) FROM pg_stat_data_horizon WHERE datname = current_database();
+
+-- one holder per database
+SELECT count(*) = count(DISTINCT datid) AS one_per_database
+  FROM pg_stat_data_horizon WHERE datid IS NOT NULL;
+
+-- the horizon is behind the oldest snapshot, one of them holds back shared
+-- catalogs
+SELECT bool_and(horizon_ts IS NULL OR horizon_ts < snapshot_ts) AS behind,
+       bool_or(holds_shared) AS shared_holder
+  FROM pg_stat_data_horizon;
+COMMIT;
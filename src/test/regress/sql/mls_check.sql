@@ -226,6 +226,18 @@ select MLS_DATAMASK_DROP_USER_POLICY('public', 'tbl_datamask_xx', 'x_m', 'godlik
 select * from tbl_datamask_xx order by i;
 
 
+--case10:column pruning, a masked column read alone or next to others is still masked
+\c regression godlike
+select i, x_m from tbl_datamask_xx order by i;
+select i, j, y from tbl_datamask_xx order by i;
+select x_m from tbl_datamask_xx where i = 1024;
+select count(*) from tbl_datamask_xx;
+
+--case11:column pruning, without white list
+\c regression rubberneck
+select y, y_m from tbl_datamask_xx order by i;
+select ii_m, i_m from tbl_datamask_xx where i = 1026;
+
 --case12:
 \c regression godlike
 create table tbl_xx(id int, tt timestamp, ff4 float4, ff8 float8, nn numeric, cc char, cc_2 char(1), cc_3 char(6), cc_4 char(10), varch2 varchar2);
@@ -0,0 +1,30 @@
+--
+-- Page compressed tables
+--
+CREATE TABLE pc_tbl (id int, val text) WITH (page_compress = true);
+SELECT reloptions FROM pg_class WHERE relname = 'pc_tbl';
+
+-- extend
+INSERT INTO pc_tbl SELECT i, repeat('x', 100) || i FROM generate_series(1, 5000) i;
+SELECT count(*), sum(id), sum(length(val)) FROM pc_tbl;
+
+-- pages that outgrow their chunks are moved
+UPDATE pc_tbl SET val = repeat('y', 200) WHERE id % 10 = 0;
+SELECT count(*), sum(length(val)) FROM pc_tbl;
+
+-- vacuum truncates the empty tail, then the table grows again
+DELETE FROM pc_tbl WHERE id > 1000;
+VACUUM pc_tbl;
+SELECT count(*), sum(id) FROM pc_tbl;
+INSERT INTO pc_tbl SELECT i, 'z' FROM generate_series(1001, 2000) i;
+SELECT count(*), sum(id) FROM pc_tbl;
+
+-- rewrite and truncate keep the storage compressed
+VACUUM FULL pc_tbl;
+SELECT count(*), sum(id) FROM pc_tbl;
+TRUNCATE pc_tbl;
+SELECT count(*) FROM pc_tbl;
+INSERT INTO pc_tbl VALUES (1, 'a');
+SELECT * FROM pc_tbl;
+
+DROP TABLE pc_tbl;
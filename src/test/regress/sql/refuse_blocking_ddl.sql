@@ -0,0 +1,52 @@
+--
+-- refuse_blocking_ddl refuses DDL that blocks a distributed table while the
+-- datanodes rewrite, scan or index it
+--
+CREATE TABLE rbd_tbl (id int, val int, note text) DISTRIBUTE BY SHARD (id);
+INSERT INTO rbd_tbl SELECT i, i, 'n' || i FROM generate_series(1, 100) i;
+
+SET refuse_blocking_ddl = on;
+
+-- rewrites
+ALTER TABLE rbd_tbl ALTER COLUMN val TYPE bigint;
+ALTER TABLE rbd_tbl ADD COLUMN ts timestamptz DEFAULT clock_timestamp();
+
+-- validation scans
+ALTER TABLE rbd_tbl ADD CONSTRAINT rbd_val_pos CHECK (val > 0);
+ALTER TABLE rbd_tbl ALTER COLUMN note SET NOT NULL;
+
+-- index builds
+CREATE INDEX rbd_val_idx ON rbd_tbl (val);
+ALTER TABLE rbd_tbl ADD CONSTRAINT rbd_id_key UNIQUE (id);
+
+-- the non-blocking forms go through
+ALTER TABLE rbd_tbl ADD COLUMN flag int DEFAULT 0;
+ALTER TABLE rbd_tbl ADD CONSTRAINT rbd_val_pos CHECK (val > 0) NOT VALID;
+ALTER TABLE rbd_tbl VALIDATE CONSTRAINT rbd_val_pos;
+ALTER TABLE rbd_tbl ALTER COLUMN note DROP DEFAULT;
+
+-- nothing has been done on the datanodes by the refused statements
+SELECT count(*), sum(val), sum(flag) FROM rbd_tbl;
+SELECT attname, format_type(atttypid, atttypmod), attnotnull
+  FROM pg_attribute
+ WHERE attrelid = 'rbd_tbl'::regclass AND attnum > 0 AND NOT attisdropped
+ ORDER BY attnum;
+SELECT count(*) FROM pg_index WHERE indrelid = 'rbd_tbl'::regclass;
+
+-- a table created in the same transaction is not visible to anybody else
+BEGIN;
+CREATE TABLE rbd_new (id int, val int) DISTRIBUTE BY SHARD (id);
+INSERT INTO rbd_new SELECT i, i FROM generate_series(1, 10) i;
+ALTER TABLE rbd_new ALTER COLUMN val TYPE bigint;
+CREATE INDEX rbd_new_val_idx ON rbd_new (val);
+COMMIT;
+SELECT count(*), sum(val) FROM rbd_new;
+
+-- off again, the blocking forms run
+RESET refuse_blocking_ddl;
+ALTER TABLE rbd_tbl ALTER COLUMN val TYPE bigint;
+CREATE INDEX rbd_val_idx ON rbd_tbl (val);
+SELECT count(*), sum(val) FROM rbd_tbl;
+
+DROP TABLE rbd_tbl;
+DROP TABLE rbd_new;
@@ -0,0 +1,104 @@
+# Test pipelined apply of a TBase subscription on a coordinator
+#
+# Changes of sharded tables are queued to their datanodes without waiting
+# for each result; changes of replicated tables go through the executor on
+# the same connections, which must first collect the queued results.
+use strict;
+use warnings;
+use PGXCCluster;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 4;
+
+my $publisher = PGXCCluster->new(
+	'pub',
+	coordinators     => 1,
+	datanodes        => 1,
+	allows_streaming => 'logical');
+my $subscriber = PGXCCluster->new(
+	'sub',
+	coordinators => 1,
+	datanodes    => 2,
+	conf         => "logical_apply_pipeline_depth = 16\n");
+
+my $pub_cn = $publisher->coordinator(0);
+my $pub_dn = $publisher->datanode(0);
+my $sub_cn = $subscriber->coordinator(0);
+
+my $ddl = qq(
+create table tab_shard (a int primary key, b text) distribute by shard (a);
+create table tab_repl (a int primary key, b text) distribute by replication;
+);
+$pub_cn->safe_psql('postgres', $ddl);
+$sub_cn->safe_psql('postgres', $ddl);
+
+$pub_cn->safe_psql('postgres',
+	"insert into tab_shard select i, 'init' || i from generate_series(1, 100) i");
+
+$pub_dn->safe_psql('postgres',
+	'create publication tap_pub for table tab_shard, tab_repl');
+$sub_cn->safe_psql('postgres', 'create extension tbase_subscription');
+$sub_cn->safe_psql('postgres',
+	"create tbase subscription tap_sub connection '${\ $pub_dn->connstr('postgres') }' publication tap_pub"
+);
+my $appname = 'tap_sub_1_0';
+
+$sub_cn->wait_for_subscription_sync;
+
+my $check = qq(
+select count(*), sum(a), md5(string_agg(b, ',' order by a)) from tab_shard;
+select count(*), sum(a), md5(string_agg(b, ',' order by a)) from tab_repl;
+);
+
+sub check_same
+{
+	my ($msg) = @_;
+
+	$pub_dn->wait_for_catchup($appname, 'replay', $pub_dn->lsn('insert'));
+	is($sub_cn->safe_psql('postgres', $check),
+		$pub_cn->safe_psql('postgres', $check), $msg);
+	return;
+}
+
+check_same('initial data synchronized');
+
+# Many changes of one transaction on the sharded table, with changes of the
+# replicated table in between that have to wait for the queued ones
+$pub_cn->safe_psql(
+	'postgres', qq(
+begin;
+insert into tab_shard select i, 'ins' || i from generate_series(101, 3000) i;
+insert into tab_repl values (1, 'repl1');
+update tab_shard set b = b || '_upd' where a % 7 = 0;
+insert into tab_repl values (2, 'repl2');
+delete from tab_shard where a % 11 = 0;
+update tab_repl set b = b || '_upd';
+commit;
+));
+check_same('mixed transaction applied with pipelining');
+
+# The depth going to 0 is picked up between changes, here most likely while
+# a large transaction is applied; changes still in flight are collected
+# before the next change is applied synchronously
+$pub_cn->safe_psql(
+	'postgres', qq(
+begin;
+insert into tab_shard select i, 'big' || i from generate_series(10001, 200000) i;
+update tab_shard set b = b || '_nopipe' where a % 3 = 0;
+insert into tab_repl values (3, 'repl3');
+delete from tab_shard where a % 5 = 0;
+commit;
+));
+$sub_cn->append_conf('postgresql.conf', "logical_apply_pipeline_depth = 0\n");
+$sub_cn->reload;
+check_same('pipeline turned off while a transaction is applied');
+
+$sub_cn->append_conf('postgresql.conf', "logical_apply_pipeline_depth = 16\n");
+$sub_cn->reload;
+$pub_cn->safe_psql('postgres', qq(
+insert into tab_shard select i, 'last' || i from generate_series(6000, 6500) i;
+insert into tab_repl values (4, 'repl4');
+));
+check_same('changes applied after the pipeline was turned on again');
+
+$sub_cn->safe_psql('postgres', 'drop tbase subscription tap_sub');
@@ -0,0 +1,163 @@
+# Test streaming of large in-progress transactions to a TBase subscription
+#
+# The changes of a transaction too large for the reorder buffer are sent
+# before it ends, and spooled by the apply worker to a temporary file until
+# STREAM COMMIT or STREAM ABORT.
+use strict;
+use warnings;
+use PGXCCluster;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 12;
+use Time::HiRes qw(usleep);
+
+my $publisher = PGXCCluster->new(
+	'pub',
+	coordinators     => 1,
+	datanodes        => 1,
+	allows_streaming => 'logical');
+my $subscriber = PGXCCluster->new(
+	'sub',
+	coordinators => 1,
+	datanodes    => 2,
+	conf         => "logical_apply_streaming = on\n");
+
+my $pub_cn = $publisher->coordinator(0);
+my $pub_dn = $publisher->datanode(0);
+my $sub_cn = $subscriber->coordinator(0);
+
+my $ddl = 'create table test_tab (a int primary key, b text) distribute by shard (a)';
+$pub_cn->safe_psql('postgres', $ddl);
+$sub_cn->safe_psql('postgres', $ddl);
+$pub_cn->safe_psql('postgres', "insert into test_tab values (1, 'foo'), (2, 'bar')");
+
+$pub_dn->safe_psql('postgres', 'create publication tap_pub for table test_tab');
+$sub_cn->safe_psql('postgres', 'create extension tbase_subscription');
+$sub_cn->safe_psql('postgres',
+	"create tbase subscription tap_sub connection '${\ $pub_dn->connstr('postgres') }' publication tap_pub"
+);
+my $appname = 'tap_sub_1_0';
+
+$sub_cn->wait_for_subscription_sync;
+
+my $check = "select count(*), sum(a), md5(string_agg(b, ',' order by a)) from test_tab";
+
+# number of files the apply worker spooled streamed changes to
+sub spool_files
+{
+	my $dir = $sub_cn->data_dir . '/base/pgsql_tmp';
+
+	return 0 unless -d $dir;
+	opendir(my $dh, $dir) or die "could not open $dir: $!";
+	my @files = grep { !/^\.\.?$/ } readdir($dh);
+	closedir($dh);
+	return scalar @files;
+}
+
+sub wait_for_spool_files
+{
+	my ($present) = @_;
+
+	foreach my $i (1 .. 1800)
+	{
+		return 1 if (spool_files() > 0) == $present;
+		usleep(100_000);
+	}
+	return 0;
+}
+
+sub check_same
+{
+	my ($msg) = @_;
+
+	$pub_dn->wait_for_catchup($appname, 'replay', $pub_dn->lsn('insert'));
+	is($sub_cn->safe_psql('postgres', $check),
+		$pub_cn->safe_psql('postgres', $check), $msg);
+	return;
+}
+
+# Run the statements in an open transaction of a session that stays around
+my ($stdin, $stdout, $stderr) = ('', '', '');
+my $session = IPC::Run::start(
+	[   'psql', '-X', '-qAt', '-v', 'ON_ERROR_STOP=1', '-f', '-', '-d',
+		$pub_cn->connstr('postgres') ],
+	'<',
+	\$stdin,
+	'>',
+	\$stdout,
+	'2>',
+	\$stderr);
+
+sub session_run
+{
+	my ($sql, $marker) = @_;
+
+	$stdout = '';
+	$stdin .= "$sql\nselect '$marker';\n";
+	$session->pump until $stdout =~ /$marker[\r\n]$/;
+	return;
+}
+
+# Streamed commit
+session_run(qq(
+begin;
+insert into test_tab select i, md5(i::text) from generate_series(3, 5000) i;
+update test_tab set b = md5(b) where a > 0;
+delete from test_tab where a % 3 = 0;
+), 'commit_sent');
+
+ok(wait_for_spool_files(1), 'changes of the open transaction are spooled');
+is($sub_cn->safe_psql('postgres', 'select count(*) from test_tab'),
+	'2', 'spooled changes are not applied before the commit');
+
+session_run('commit;', 'commit_done');
+check_same('streamed transaction applied at commit');
+ok(wait_for_spool_files(0), 'spool file removed after STREAM COMMIT');
+
+# Streamed abort
+session_run(qq(
+begin;
+insert into test_tab select i, md5(i::text) from generate_series(5001, 10000) i;
+delete from test_tab where a % 2 = 0;
+), 'abort_sent');
+
+ok(wait_for_spool_files(1), 'changes of the transaction to abort are spooled');
+
+session_run('rollback;', 'abort_done');
+$pub_cn->safe_psql('postgres', "insert into test_tab values (20001, 'after abort')");
+check_same('streamed transaction not applied after abort');
+ok(wait_for_spool_files(0), 'spool file removed after STREAM ABORT');
+
+# Abort of a subtransaction of a streamed transaction
+session_run(qq(
+begin;
+insert into test_tab select i, md5(i::text) from generate_series(10001, 15000) i;
+savepoint s1;
+insert into test_tab select i, md5(i::text) from generate_series(15001, 20000) i;
+update test_tab set b = 'in s1' where a <= 10000;
+), 'subxact_sent');
+
+ok(wait_for_spool_files(1), 'changes of the subtransaction are spooled');
+
+session_run(qq(
+rollback to s1;
+insert into test_tab values (20002, 'after rollback to s1');
+savepoint s2;
+delete from test_tab where a % 5 = 0;
+release s2;
+commit;
+), 'subxact_done');
+
+check_same('aborted subtransaction skipped, the rest applied');
+is($sub_cn->safe_psql('postgres',
+		"select count(*) from test_tab where a between 15001 and 20000 or b = 'in s1'"),
+	'0', 'no change of the aborted subtransaction was applied');
+ok(wait_for_spool_files(0), 'spool file removed after the commit');
+
+$session->finish;
+
+# A small transaction is still sent at commit and spools nothing
+$pub_cn->safe_psql('postgres', "update test_tab set b = 'small' where a = 1");
+check_same('small transaction applied');
+
+$sub_cn->safe_psql('postgres', 'drop tbase subscription tap_sub');
@@ -0,0 +1,109 @@
+# Test binary transfer of column values to a TBase subscription
+#
+# With logical_apply_binary on, the initial copy and the changes carry the
+# values of built-in types in their binary format.  They must read back the
+# same as on the publisher.
+use strict;
+use warnings;
+use PGXCCluster;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 4;
+
+my $publisher = PGXCCluster->new(
+	'pub',
+	coordinators     => 1,
+	datanodes        => 1,
+	allows_streaming => 'logical');
+my $subscriber = PGXCCluster->new(
+	'sub',
+	coordinators => 1,
+	datanodes    => 2,
+	conf         => "logical_apply_binary = on\n");
+
+my $pub_cn = $publisher->coordinator(0);
+my $pub_dn = $publisher->datanode(0);
+my $sub_cn = $subscriber->coordinator(0);
+
+my $ddl = qq(
+create table tab_types (
+	id int primary key,
+	n numeric,
+	f8 float8,
+	f4 float4,
+	ts timestamptz,
+	iv interval,
+	d date,
+	bt bytea,
+	js jsonb,
+	ia int[],
+	ta text[],
+	u uuid,
+	addr inet,
+	bl bool,
+	t text,
+	vc varchar(20),
+	c char(5)
+) distribute by shard (id);
+);
+$pub_cn->safe_psql('postgres', $ddl);
+$sub_cn->safe_psql('postgres', $ddl);
+
+my $rows = qq(
+(1, 12345678901234567890.123456789, 'NaN', '-Infinity',
+ '2019-11-09 01:02:03.456789+08', '1 year 2 mons 3 days 04:05:06.789', '4713-01-01 BC',
+ '\\x00ff10', '{"a": [1, 2.5, null], "b": {"c": "d"}}', '{1,NULL,3}', '{"x y",NULL,"\\"q\\""}',
+ 'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11', '192.168.1.0/24', true, E'tab\\there', 'abc', 'ab'),
+(2, -0.000001, 'Infinity', 1.5e-30,
+ 'infinity', '-1 days -00:00:01', '2000-02-29',
+ '', '[]', '{}', '{}',
+ '00000000-0000-0000-0000-000000000000', '::1', false, '', '', ''),
+(3, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL)
+);
+
+# the first rows come with the initial copy
+$pub_cn->safe_psql('postgres', "insert into tab_types values $rows");
+
+$pub_dn->safe_psql('postgres', 'create publication tap_pub for table tab_types');
+$sub_cn->safe_psql('postgres', 'create extension tbase_subscription');
+$sub_cn->safe_psql('postgres',
+	"create tbase subscription tap_sub connection '${\ $pub_dn->connstr('postgres') }' publication tap_pub"
+);
+my $appname = 'tap_sub_1_0';
+
+$sub_cn->wait_for_subscription_sync;
+
+# compare the text form of every value, which differs if any was misread
+my $check = 'select * from tab_types order by id';
+
+sub check_same
+{
+	my ($msg) = @_;
+
+	$pub_dn->wait_for_catchup($appname, 'replay', $pub_dn->lsn('insert'));
+	is($sub_cn->safe_psql('postgres', $check),
+		$pub_cn->safe_psql('postgres', $check), $msg);
+	return;
+}
+
+check_same('initial copy in binary');
+
+# the same values again as changes
+$pub_cn->safe_psql('postgres',
+	"insert into tab_types select id + 10, n, f8, f4, ts, iv, d, bt, js, ia, ta, u, addr, bl, t, vc, c from tab_types where id <= 3"
+);
+check_same('inserted values in binary');
+
+$pub_cn->safe_psql(
+	'postgres', qq(
+update tab_types set n = n * 2, ts = ts + iv, js = js || '{"e": 1}',
+	ia = ia || 4, ta = array_append(ta, NULL), bt = bt || '\\x01'::bytea
+	where id > 10;
+update tab_types set t = NULL, f8 = 0 where id = 1;
+));
+check_same('updated values in binary');
+
+$pub_cn->safe_psql('postgres', 'delete from tab_types where id in (2, 12)');
+check_same('deleted rows');
+
+$sub_cn->safe_psql('postgres', 'drop tbase subscription tap_sub');
@@ -0,0 +1,92 @@
+# Test initial synchronization of several tables split into parallel streams
+#
+# With logical_sync_streams_per_table above 1, the copy of a sharded table
+# is split into ranges of shards copied by helper workers, and merged by the
+# table synchronization worker.  Every table must end up the same as on the
+# publisher, including the changes made while the copies run.
+use strict;
+use warnings;
+use PGXCCluster;
+use PostgresNode;
+use TestLib;
+use Test::More tests => 6;
+
+my $publisher = PGXCCluster->new(
+	'pub',
+	coordinators     => 1,
+	datanodes        => 1,
+	allows_streaming => 'logical');
+my $subscriber = PGXCCluster->new(
+	'sub',
+	coordinators => 1,
+	datanodes    => 2,
+	conf         => qq(
+logical_sync_streams_per_table = 4
+max_sync_workers_per_subscription = 6
+max_logical_replication_workers = 12
+max_worker_processes = 24
+));
+
+my $pub_cn = $publisher->coordinator(0);
+my $pub_dn = $publisher->datanode(0);
+my $sub_cn = $subscriber->coordinator(0);
+
+my @tables = ('tab1', 'tab2', 'tab3', 'tab_repl');
+my $ddl = qq(
+create table tab1 (a int primary key, b text) distribute by shard (a);
+create table tab2 (a int primary key, b text, c timestamptz) distribute by shard (a);
+create table tab3 (a bigint, b int, primary key (b, a)) distribute by shard (b);
+create table tab_repl (a int primary key, b text) distribute by replication;
+);
+$pub_cn->safe_psql('postgres', $ddl);
+$sub_cn->safe_psql('postgres', $ddl);
+
+$pub_cn->safe_psql(
+	'postgres', qq(
+insert into tab1 select i, md5(i::text) from generate_series(1, 100000) i;
+insert into tab2 select i, repeat('x', i % 100), '2019-01-01'::timestamptz + i * interval '1 min'
+	from generate_series(1, 50000) i;
+insert into tab3 select i, i % 1000 from generate_series(1, 80000) i;
+insert into tab_repl select i, i::text from generate_series(1, 1000) i;
+));
+
+$pub_dn->safe_psql('postgres',
+	'create publication tap_pub for table tab1, tab2, tab3, tab_repl');
+$sub_cn->safe_psql('postgres', 'create extension tbase_subscription');
+$sub_cn->safe_psql('postgres',
+	"create tbase subscription tap_sub connection '${\ $pub_dn->connstr('postgres') }' publication tap_pub"
+);
+my $appname = 'tap_sub_1_0';
+
+# changes while the tables are being copied
+$pub_cn->safe_psql(
+	'postgres', qq(
+insert into tab1 select i, 'late' || i from generate_series(100001, 101000) i;
+update tab2 set b = 'upd' where a % 10 = 0;
+delete from tab3 where b = 7;
+update tab_repl set b = 'upd' where a <= 10;
+));
+
+$sub_cn->wait_for_subscription_sync;
+$pub_dn->wait_for_catchup($appname, 'replay', $pub_dn->lsn('insert'));
+
+foreach my $tab (@tables)
+{
+	my $check = "select count(*), md5(string_agg(t::text, ',' order by t::text)) from $tab t";
+
+	is($sub_cn->safe_psql('postgres', $check),
+		$pub_cn->safe_psql('postgres', $check), "$tab synchronized");
+}
+
+# no helper is left behind once every table is ready
+is($sub_cn->safe_psql('postgres', 'select count(*) from tbase_get_sync_stream_stat()'),
+	'0', 'no copy stream left');
+
+# and the apply worker goes on
+$pub_cn->safe_psql('postgres', 'delete from tab1 where a % 2 = 0');
+$pub_dn->wait_for_catchup($appname, 'replay', $pub_dn->lsn('insert'));
+is($sub_cn->safe_psql('postgres', 'select count(*) from tab1'),
+	$pub_cn->safe_psql('postgres', 'select count(*) from tab1'),
+	'changes applied after the synchronization');
+
+$sub_cn->safe_psql('postgres', 'drop tbase subscription tap_sub');